@@ -42,6 +42,8 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include <limits.h>
 #include <ctype.h>
 #include "OVR_JSON.h"
+#include "OVR_JSONStream.h"
+#include "OVR_Array.h"
 #include "OVR_SysFile.h"
 #include "OVR_Log.h"
 #include "OVR_Math.h"
@@ -50,152 +52,199 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 namespace OVR {
 
 
-//-----------------------------------------------------------------------------
-// Create a new copy of a string
-static char* JSON_strdup(const char* str)
+// Parse the input text into an un-escaped cstring, and populate item.
+static const unsigned char firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
+
+// Helper to assign error sting and return 0.
+const char* AssignError(const char** perror, const char *errorMessage)
 {
-    size_t len  = OVR_strlen(str) + 1;
-    char* copy = (char*)OVR_ALLOC(len);
-    if (!copy)
-        return 0;
-    memcpy(copy, str, len);
-    return copy;
+    if (perror)
+        *perror = errorMessage;
+    return 0;
 }
 
-
 //-----------------------------------------------------------------------------
-// Render the number from the given item into a string.
-static char* PrintNumber(double d)
+// ***** JsonArena
+
+// Allocates the nodes of a tree parsed with JSON::ParseArena in blocks that are
+// all freed together, and interns the object names so that repeated names share
+// a single string buffer.
+class JsonArena
 {
-    char *str;
-    int valueint = (int)d;
+public:
+                    JsonArena() {}
+                    ~JsonArena();
 
-    if (fabs(((double)valueint)-d) <= DBL_EPSILON && d <= INT_MAX && d >= INT_MIN)
+    JSON*           AllocNode();
+    const String&   Intern(const char* str, int len);
+    char*           GetScratch(int size) { Scratch.Resize(size); return Scratch.GetDataPtr(); }
+
+private:
+    static const int MIN_BLOCK_NODES = 32;
+    static const int MAX_BLOCK_NODES = 4096;
+
+    struct NodeBlock
     {
-        str=(char*)OVR_ALLOC(21);   // 2^64+1 can be represented in 21 chars.
-        if (str)
-            OVR_sprintf(str, 21, "%d", valueint);
+        JSON*   Nodes;
+        int     Count;
+        int     Capacity;
+    };
+
+    ArrayPOD<NodeBlock> Blocks;
+    Array<String>       Strings;
+    ArrayPOD<int>       Table;      // Index + 1 into Strings, 0 for an empty slot.
+    ArrayPOD<char>      Scratch;    // Reused to decode strings.
+
+    static UInt32   Hash(const char* str, int len);
+    void            Rehash(int tableSize);
+};
+
+JsonArena::~JsonArena()
+{
+    // Detach all nodes from each other first, because nodes may have been moved
+    // between parents, and heap nodes added to the tree are released here.
+    for (UPInt i = 0; i < Blocks.GetSize(); i++)
+    {
+        for (int j = 0; j < Blocks[i].Count; j++)
+        {
+            Blocks[i].Nodes[j].releaseChildren();
+        }
     }
-    else
+    for (UPInt i = 0; i < Blocks.GetSize(); i++)
     {
-        str=(char*)OVR_ALLOC(64);    // This is a nice tradeoff.
-        if (str)
+        for (int j = 0; j < Blocks[i].Count; j++)
         {
-            // The JSON Standard, section 7.8.3, specifies that decimals are always expressed with '.' and 
-            // not some locale-specific decimal such as ',' or ' '. However, since we are using the C standard
-            // library below to write a floating point number, we need to make sure that it's writing a '.' 
-            // and not something else. We can't change the locale (even temporarily) here, as it will affect 
-            // the whole process by default. That are compiler-specific ways to change this per-thread, but 
-            // below we implement the simple solution of simply fixing the decimal after the string was written.
-
-            if (fabs(floor(d)-d) <= DBL_EPSILON && fabs(d) < 1.0e60)
-                OVR_sprintf(str, 64, "%.0f", d);
-            else if (fabs(d) < 1.0e-6 || fabs(d) > 1.0e9)
-                OVR_sprintf(str, 64, "%e", d);
-            else
-                OVR_sprintf(str, 64, "%f", d);
+            JSON* node = &Blocks[i].Nodes[j];
+            node->RefCount = 1;
+            node->~JSON();
         }
+        OVR_FREE(Blocks[i].Nodes);
     }
-    return str;
 }
 
+JSON* JsonArena::AllocNode()
+{
+    if (Blocks.GetSize() == 0 || Blocks.Back().Count == Blocks.Back().Capacity)
+    {
+        NodeBlock block;
+        block.Capacity = (Blocks.GetSize() == 0) ? MIN_BLOCK_NODES : Alg::Min(Blocks.Back().Capacity * 2, (int)MAX_BLOCK_NODES);
+        block.Count = 0;
+        block.Nodes = (JSON*)OVR_ALLOC(block.Capacity * sizeof(JSON));
+        if (!block.Nodes)
+            return 0;
+        Blocks.PushBack(block);
+    }
 
-// Parse the input text into an un-escaped cstring, and populate item.
-static const unsigned char firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
+    NodeBlock& block = Blocks.Back();
+    JSON* node = ::new (&block.Nodes[block.Count++]) JSON();
+    node->Arena = this;
+    // The arena holds a reference, so a Release() from user code never deletes the node.
+    node->AddRef();
+    return node;
+}
 
-// Helper to assign error sting and return 0.
-const char* AssignError(const char** perror, const char *errorMessage)
+UInt32 JsonArena::Hash(const char* str, int len)
 {
-    if (perror)
-        *perror = errorMessage;
-    return 0;
+    UInt32 hash = 2166136261u;
+    for (int i = 0; i < len; i++)
+    {
+        hash = (hash ^ (UByte)str[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void JsonArena::Rehash(int tableSize)
+{
+    Table.Resize(tableSize);
+    memset(Table.GetDataPtr(), 0, tableSize * sizeof(int));
+    for (int i = 0; i < (int)Strings.GetSize(); i++)
+    {
+        UInt32 slot = Hash(Strings[i].ToCStr(), (int)Strings[i].GetSize()) & (tableSize - 1);
+        while (Table[slot] != 0)
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        Table[slot] = i + 1;
+    }
+}
+
+const String& JsonArena::Intern(const char* str, int len)
+{
+    if ((int)Strings.GetSize() * 2 >= (int)Table.GetSize())
+    {
+        Rehash(Table.GetSize() == 0 ? 64 : (int)Table.GetSize() * 2);
+    }
+
+    const UInt32 mask = (UInt32)Table.GetSize() - 1;
+    UInt32 slot = Hash(str, len) & mask;
+    while (Table[slot] != 0)
+    {
+        const String& s = Strings[Table[slot] - 1];
+        if ((int)s.GetSize() == len && memcmp(s.ToCStr(), str, len) == 0)
+            return s;
+        slot = (slot + 1) & mask;
+    }
+
+    Strings.PushBack(String(str, len));
+    Table[slot] = (int)Strings.GetSize();
+    return Strings.Back();
 }
 
 //-----------------------------------------------------------------------------
 // ***** JSON Node class
 
 JSON::JSON(JSONItemType itemType) :
-    Type(itemType), dValue(0.0)
+    Arena(0), OwnedArena(0), Type(itemType), dValue(0.0)
 {
 }
 
 JSON::~JSON()
+{
+    releaseChildren();
+    delete OwnedArena;
+}
+
+// Detaches all children and releases the ones that are not allocated from an arena.
+void JSON::releaseChildren()
 {
     JSON* child = Children.GetFirst();
     while (!Children.IsNull(child))
     {
         child->RemoveNode();
-        child->Release();
+        if (!child->Arena)
+            child->Release();
         child = Children.GetFirst();
     }
 }
 
+// Allocates a node for parsing, from the arena if there is one.
+JSON* JSON::createChild(JsonArena* arena)
+{
+    return arena ? arena->AllocNode() : new JSON();
+}
+
 //-----------------------------------------------------------------------------
 // Parse the input text to generate a number, and populate the result into item
 // Returns the text position after the parsed number
-const char* JSON::parseNumber(const char *num)
+const char* JSON::parseNumber(const char *num, JsonArena* arena)
 {
     const char* num_start = num;
-    double      n=0, sign=1, scale=0;
-    int         subscale     = 0,
-                signsubscale = 1;
-
-    // Could use sscanf for this?
-    if (*num == '-')
-    {
-        sign=-1,num++;    // Has sign?
-    }
-    if (*num == '0')
-    {
-        num++;            // is zero
-    }
+    double      n = 0.0;
+    bool        isInteger;
+    int64_t     intValue;
 
-    if (*num>='1' && *num<='9') 
+    // Converts without pow() and without depending on the C locale.
+    num = JsonStreamReader::ParseNumber(num, n, isInteger, intValue);
+    if (num == num_start && *num == '-')
     {
-        do
-        {
-            n = (n*10.0) + (*num++ - '0');
-        }
-        while (*num>='0' && *num<='9');    // Number?
+        num++;    // A lone sign parses as zero.
     }
 
-    if (*num=='.' && num[1]>='0' && num[1]<='9')
-    {
-        num++;
-        do
-        {
-            n=(n*10.0)+(*num++ -'0');
-            scale--;
-        }
-        while (*num>='0' && *num<='9');  // Fractional part?
-    }
-
-    if (*num=='e' || *num=='E')        // Exponent?
-    {
-        num++;
-        if (*num == '+')
-        {
-            num++;
-        }
-        else if (*num=='-')
-        {
-            signsubscale=-1;
-            num++;        // With sign?
-        }
-
-        while (*num >= '0' && *num <= '9')
-        {
-            subscale = (subscale * 10) + (*num++ - '0');    // Number?
-        }
-    }
-
-    // Number = +/- number.fraction * 10^+/- exponent
-    n = sign*n*pow(10.0, (scale + subscale*signsubscale));
-
     // Assign parsed value.
     Type = JSON_Number;
     dValue = n;
-    Value.AssignString(num_start, num - num_start);
+    if (!arena)
+        Value.AssignString(num_start, num - num_start);
 
     return num;
 }
@@ -226,9 +275,9 @@ const char* ParseHex(unsigned* val, unsigned digits, const char* str)
 }
 
 //-----------------------------------------------------------------------------
-// Parses the input text into a string item and returns the text position after
-// the parsed string
-const char* JSON::parseString(const char* str, const char** perror)
+// Parses the input text into a string item, or into the item name if isName is set,
+// and returns the text position after the parsed string
+const char* JSON::parseString(const char* str, const char** perror, JsonArena* arena, bool isName)
 {
     const char* ptr = str+1;
     const char* p;
@@ -248,7 +297,7 @@ const char* JSON::parseString(const char* str, const char** perror)
     }
     
     // This is how long we need for the string, roughly.
-    out=(char*)OVR_ALLOC(len+1);
+    out=arena ? arena->GetScratch(len+1) : (char*)OVR_ALLOC(len+1);
     if (!out)
         return 0;
     
@@ -336,73 +385,25 @@ const char* JSON::parseString(const char* str, const char** perror)
     if (*ptr=='\"')
         ptr++;
     
-    // Make a copy of the string 
-    Value=out;
-    OVR_FREE(out);
-    Type=JSON_String;
-
-    return ptr;
-}
-
-//-----------------------------------------------------------------------------
-// Render the string provided to an escaped version that can be printed.
-char* PrintString(const char* str)
-{
-    const char *ptr;
-    char *ptr2,*out;
-    int len=0;
-    unsigned char token;
-    
-    if (!str)
-        return JSON_strdup("");
-    ptr=str;
-    
-    token=*ptr;
-    while (token && ++len)\
+    // Make a copy of the string, names in an arena are interned.
+    if (arena)
     {
-        if (strchr("\"\\\b\f\n\r\t",token))
-            len++;
-        else if (token<32) 
-            len+=5;
-        ptr++;
-        token=*ptr;
+        if (isName)
+            Name=arena->Intern(out, (int)(ptr2 - out));
+        else
+            Value.AssignString(out, ptr2 - out);
     }
-    
-    int buff_size = len+3;
-    out=(char*)OVR_ALLOC(buff_size);
-    if (!out)
-        return 0;
-
-    ptr2 = out;
-    ptr  = str;
-    *ptr2++ = '\"';
-
-    while (*ptr)
+    else
     {
-        if ((unsigned char)*ptr>31 && *ptr!='\"' && *ptr!='\\') 
-            *ptr2++=*ptr++;
+        if (isName)
+            Name=out;
         else
-        {
-            *ptr2++='\\';
-            switch (token=*ptr++)
-            {
-                case '\\':    *ptr2++='\\';    break;
-                case '\"':    *ptr2++='\"';    break;
-                case '\b':    *ptr2++='b';    break;
-                case '\f':    *ptr2++='f';    break;
-                case '\n':    *ptr2++='n';    break;
-                case '\r':    *ptr2++='r';    break;
-                case '\t':    *ptr2++='t';    break;
-                default: 
-                    OVR_sprintf(ptr2, buff_size - (ptr2-out), "u%04x",token);
-                    ptr2+=5;
-                    break;    // Escape and print.
-            }
-        }
+            Value=out;
+        OVR_FREE(out);
     }
-    *ptr2++='\"';
-    *ptr2++='\0';
-    return out;
+    Type=JSON_String;
+
+    return ptr;
 }
 
 //-----------------------------------------------------------------------------
@@ -418,6 +419,16 @@ static const char* skip(const char* in)
 // Parses the supplied buffer of JSON text and returns a JSON object tree
 // The returned object must be Released after use
 JSON* JSON::Parse(const char* buff, const char** perror)
+{
+    return parseRoot(buff, perror, false);
+}
+
+JSON* JSON::ParseArena(const char* buff, const char** perror)
+{
+    return parseRoot(buff, perror, true);
+}
+
+JSON* JSON::parseRoot(const char* buff, const char** perror, bool useArena)
 {
     const char* end = 0;
     JSON*       json = new JSON();
@@ -427,8 +438,11 @@ JSON* JSON::Parse(const char* buff, const char** perror)
         AssignError(perror, "Error: Failed to allocate memory");
         return 0;
     }
+
+    if (useArena)
+        json->OwnedArena = new JsonArena();
  
-    end = json->parseValue(skip(buff), perror);
+    end = json->parseValue(skip(buff), perror, json->OwnedArena);
     if (!end)
     {
         json->Release();
@@ -440,7 +454,7 @@ JSON* JSON::Parse(const char* buff, const char** perror)
 
 //-----------------------------------------------------------------------------
 // Parser core - when encountering text, process appropriately.
-const char* JSON::parseValue(const char* buff, const char** perror)
+const char* JSON::parseValue(const char* buff, const char** perror, JsonArena* arena)
 {
     if (perror)
         *perror = 0;
@@ -456,65 +470,52 @@ const char* JSON::parseValue(const char* buff, const char** perror)
     if (!strncmp(buff, "false", 5))
     { 
         Type   = JSON_Bool;
-        Value  = "false";
+        Value  = arena ? arena->Intern("false", 5) : String("false");
         dValue = 0.0;
         return buff + 5;
     }
     if (!strncmp(buff, "true", 4))
     {
         Type   = JSON_Bool;
-        Value  = "true";
+        Value  = arena ? arena->Intern("true", 4) : String("true");
         dValue = 1.0;
         return buff + 4;
     }
     if (*buff=='\"')
     {
-        return parseString(buff, perror);
+        return parseString(buff, perror, arena, false);
     }
     if (*buff=='-' || (*buff>='0' && *buff<='9'))
     { 
-        return parseNumber(buff);
+        return parseNumber(buff, arena);
     }
     if (*buff=='[')
     { 
-        return parseArray(buff, perror);
+        return parseArray(buff, perror, arena);
     }
     if (*buff=='{')
     {
-        return parseObject(buff, perror);
+        return parseObject(buff, perror, arena);
     }
 
     return AssignError(perror, StringUtils::Va( "Syntax Error: Invalid syntax: '%s'", buff) );
 }
 
 //-----------------------------------------------------------------------------
-// Render a value to text. 
+// Render a value to text in a single pass. The returned text must be freed
 char* JSON::PrintValue(int depth, bool fmt)
 {
-    char *out=0;
-
-    switch (Type)
-    {
-        case JSON_Null:        out = JSON_strdup("null");    break;
-        case JSON_Bool:
-            if (dValue == 0)
-                out = JSON_strdup("false");
-            else
-                out = JSON_strdup("true");
-            break;
-        case JSON_Number:    out = PrintNumber(dValue); break;
-        case JSON_String:    out = PrintString(Value.ToCStr()); break;
-        case JSON_Array:    out = PrintArray(depth, fmt); break;
-        case JSON_Object:    out = PrintObject(depth, fmt); break;
-        case JSON_None: OVR_ASSERT_LOG(false, ("Bad JSON type.")); break;
-    }
-    return out;
+    JsonWriter writer(fmt, depth);
+    writer.WriteValue(this);
+    if (writer.HasFailed())
+        return 0;
+    return writer.DetachText();
 }
 
 //-----------------------------------------------------------------------------
 // Build an array object from input text and returns the text position after
 // the parsed array
-const char* JSON::parseArray(const char* buff, const char** perror)
+const char* JSON::parseArray(const char* buff, const char** perror, JsonArena* arena)
 {
     JSON *child;
     if (*buff!='[')
@@ -528,24 +529,24 @@ const char* JSON::parseArray(const char* buff, const char** perror)
     if (*buff==']')
         return buff+1;    // empty array.
 
-    child = new JSON();
+    child = createChild(arena);
     if (!child)
         return 0;         // memory fail
     Children.PushBack(child);
     
-    buff=skip(child->parseValue(skip(buff), perror));    // skip any spacing, get the buff. 
+    buff=skip(child->parseValue(skip(buff), perror, arena));    // skip any spacing, get the buff. 
     if (!buff)
         return 0;
 
     while (*buff==',')
     {
-        JSON *new_item = new JSON();
+        JSON *new_item = createChild(arena);
         if (!new_item)
             return AssignError(perror, "Error: Failed to allocate memory");
         
         Children.PushBack(new_item);
 
-        buff=skip(new_item->parseValue(skip(buff+1), perror));
+        buff=skip(new_item->parseValue(skip(buff+1), perror, arena));
         if (!buff)
             return AssignError(perror, "Error: Failed to allocate memory");
     }
@@ -556,94 +557,10 @@ const char* JSON::parseArray(const char* buff, const char** perror)
     return AssignError(perror, "Syntax Error: Missing ending bracket");
 }
 
-//-----------------------------------------------------------------------------
-// Render an array to text.  The returned text must be freed
-char* JSON::PrintArray(int depth, bool fmt)
-{
-    char **  entries;
-    char *   out = 0, *ptr,*ret;
-    intptr_t len = 5;
-    
-    bool fail = false;
-    
-    // How many entries in the array? 
-    int numentries = GetItemCount();
-    if (!numentries)
-    {
-        out=(char*)OVR_ALLOC(3);
-        if (out)
-            OVR_strcpy(out, 3, "[]");
-        return out;
-    }
-    // Allocate an array to hold the values for each
-    entries=(char**)OVR_ALLOC(numentries*sizeof(char*));
-    if (!entries)
-        return 0;
-    memset(entries,0,numentries*sizeof(char*));
-
-    //// Retrieve all the results:
-    JSON* child = Children.GetFirst();
-    for (int i=0; i<numentries; i++)
-    {
-        //JSON* child = Children[i];
-        ret=child->PrintValue(depth+1, fmt);
-        entries[i]=ret;
-        if (ret)
-            len+=OVR_strlen(ret)+2+(fmt?1:0);
-        else
-        {
-            fail = true;
-            break;
-        }
-        child = Children.GetNext(child);
-    }
-    
-    // If we didn't fail, try to malloc the output string 
-    if (!fail)
-        out=(char*)OVR_ALLOC(len);
-    // If that fails, we fail. 
-    if (!out)
-        fail = true;
-
-    // Handle failure.
-    if (fail)
-    {
-        for (int i=0; i<numentries; i++) 
-        {
-            if (entries[i])
-                OVR_FREE(entries[i]);
-        }
-        OVR_FREE(entries);
-        return 0;
-    }
-    
-    // Compose the output array.
-    *out='[';
-    ptr=out+1;
-    *ptr='\0';
-    for (int i=0; i<numentries; i++)
-    {
-        OVR_strcpy(ptr, len - (ptr-out), entries[i]);
-        ptr+=OVR_strlen(entries[i]);
-        if (i!=numentries-1)
-        {
-            *ptr++=',';
-            if (fmt)
-                *ptr++=' ';
-            *ptr='\0';
-        }
-        OVR_FREE(entries[i]);
-    }
-    OVR_FREE(entries);
-    *ptr++=']';
-    *ptr++='\0';
-    return out;
-}
-
 //-----------------------------------------------------------------------------
 // Build an object from the supplied text and returns the text position after
 // the parsed object
-const char* JSON::parseObject(const char* buff, const char** perror)
+const char* JSON::parseObject(const char* buff, const char** perror, JsonArena* arena)
 {
     if (*buff!='{')
     {
@@ -655,46 +572,43 @@ const char* JSON::parseObject(const char* buff, const char** perror)
     if (*buff=='}')
         return buff+1;    // empty array.
     
-    JSON* child = new JSON();
+    JSON* child = createChild(arena);
+    if (!child)
+        return 0; // memory fail
     Children.PushBack(child);
 
-    buff=skip(child->parseString(skip(buff), perror));
+    buff=skip(child->parseString(skip(buff), perror, arena, true));
     if (!buff) 
         return 0;
-    child->Name = child->Value;
-    child->Value.Clear();
     
     if (*buff!=':')
     {
         return AssignError(perror, "Syntax Error: Missing colon");
     }
 
-    buff=skip(child->parseValue(skip(buff+1), perror));    // skip any spacing, get the value.
+    buff=skip(child->parseValue(skip(buff+1), perror, arena));    // skip any spacing, get the value.
     if (!buff)
         return 0;
     
     while (*buff==',')
     {
-        child = new JSON();
+        child = createChild(arena);
         if (!child)
             return 0; // memory fail
         
         Children.PushBack(child);
 
-        buff=skip(child->parseString(skip(buff+1), perror));
+        buff=skip(child->parseString(skip(buff+1), perror, arena, true));
         if (!buff)
             return 0;
         
-        child->Name=child->Value;
-        child->Value.Clear();
-        
         if (*buff!=':')
         {
             return AssignError(perror, "Syntax Error: Missing colon");
         }    // fail!
         
         // Skip any spacing, get the value.
-        buff=skip(child->parseValue(skip(buff+1), perror));
+        buff=skip(child->parseValue(skip(buff+1), perror, arena));
         if (!buff)
             return 0;
     }
@@ -705,158 +619,6 @@ const char* JSON::parseObject(const char* buff, const char** perror)
     return AssignError(perror, "Syntax Error: Missing closing brace");
 }
 
-//-----------------------------------------------------------------------------
-// Render an object to text.  The returned string must be freed
-char* JSON::PrintObject(int depth, bool fmt)
-{
-    char**   entries = 0, **names = 0;
-    char*    out = 0;
-    char*    ptr, *ret, *str;
-    intptr_t len = 7, i = 0, j;
-    bool     fail = false;
-    
-    // Count the number of entries.
-    int numentries = GetItemCount();
-    
-    // Explicitly handle empty object case
-    if (numentries == 0)
-    {
-        out=(char*)OVR_ALLOC(fmt?depth+4:4);
-        if (!out)
-            return 0;
-        ptr=out;
-        *ptr++='{';
-        
-        if (fmt)
-        {
-            *ptr++='\n';
-            for (i=0;i<depth-1;i++)
-                *ptr++='\t';
-        }
-        *ptr++='}';
-        *ptr++='\0';
-        return out;
-    }
-    // Allocate space for the names and the objects
-    entries=(char**)OVR_ALLOC(numentries*sizeof(char*));
-    if (!entries)
-        return 0;
-    names=(char**)OVR_ALLOC(numentries*sizeof(char*));
-    
-    if (!names)
-    {
-        OVR_FREE(entries);
-        return 0;
-    }
-    memset(entries,0,sizeof(char*)*numentries);
-    memset(names,0,sizeof(char*)*numentries);
-
-    // Collect all the results into our arrays:
-    depth++;
-    if (fmt)
-        len+=depth;
-
-    JSON* child = Children.GetFirst();
-    while (!Children.IsNull(child))
-    {
-        names[i]     = str = PrintString(child->Name.ToCStr());
-        entries[i++] = ret = child->PrintValue(depth, fmt);
-
-        if (str && ret)
-        {
-            len += OVR_strlen(ret)+OVR_strlen(str)+2+(fmt?2+depth:0);
-        }
-        else
-        {
-            fail = true;
-            break;
-        }
-        
-        child = Children.GetNext(child);
-    }
-    
-    // Try to allocate the output string
-    if (!fail)
-        out=(char*)OVR_ALLOC(len);
-    if (!out)
-        fail=true;
-
-    // Handle failure
-    if (fail)
-    {
-        for (i=0;i<numentries;i++)
-        {
-            if (names[i])
-                OVR_FREE(names[i]);
-            
-            if (entries[i])
-                OVR_FREE(entries[i]);}
-        
-        OVR_FREE(names);
-        OVR_FREE(entries);
-        return 0;
-    }
-    
-    // Compose the output:
-    *out = '{';
-    ptr  = out+1;
-    if (fmt)
-    {
-        *ptr++ = '\n';
-    }
-    *ptr = 0;
-    
-    for (i=0; i<numentries; i++)
-    {
-        if (fmt)
-        {
-            for (j = 0; j < depth; j++)
-            {
-                *ptr++ = '\t';
-            }
-        }
-        OVR_strcpy(ptr, len - (ptr-out), names[i]);
-        ptr   += OVR_strlen(names[i]);
-        *ptr++ =':';
-        
-        if (fmt)
-        {
-            *ptr++ = '\t';
-        }
-        
-        OVR_strcpy(ptr, len - (ptr-out), entries[i]);
-        ptr+=OVR_strlen(entries[i]);
-        
-        if (i != numentries - 1)
-        {
-            *ptr++ = ',';
-        }
-        
-        if (fmt)
-        {
-            *ptr++ = '\n';
-        }
-        *ptr = 0;
-        
-        OVR_FREE(names[i]);
-        OVR_FREE(entries[i]);
-    }
-    
-    OVR_FREE(names);
-    OVR_FREE(entries);
-    
-    if (fmt)
-    {
-        for (i = 0; i < depth - 1; i++)
-        {
-            *ptr++ = '\t';
-        }
-    }
-    *ptr++='}';
-    *ptr++='\0';
-    
-    return out; 
-}
 
 
 
@@ -1045,6 +807,16 @@ const char* JSON::GetArrayString(int index)
 // Loads and parses the given JSON file pathname and returns a JSON object tree.
 // The returned object must be Released after use.
 JSON* JSON::Load(const char* path, const char** perror)
+{
+    return loadRoot(path, perror, false);
+}
+
+JSON* JSON::LoadArena(const char* path, const char** perror)
+{
+    return loadRoot(path, perror, true);
+}
+
+JSON* JSON::loadRoot(const char* path, const char** perror, bool useArena)
 {
     SysFile f;
     if (!f.Open(path, File::Open_Read, File::Mode_Read))
@@ -1067,7 +839,7 @@ JSON* JSON::Load(const char* path, const char** perror)
     // Ensure the result is null-terminated since Parse() expects null-terminated input.
     buff[len] = '\0';
 
-    JSON* json = JSON::Parse((char*)buff, perror);
+    JSON* json = parseRoot((char*)buff, perror, useArena);
     OVR_FREE(buff);
     return json;
 }
@@ -1080,21 +852,12 @@ bool JSON::Save(const char* path)
     if (!f.Open(path, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_Write))
         return false;
 
-    char* text = PrintValue(0, true);
-    if (text)
-    {
-        intptr_t len   = OVR_strlen(text);
-        OVR_ASSERT(len <= (intptr_t)(int)len);
-
-        int   bytes = f.Write((uint8_t*)text, (int)len);
-        f.Close();
-        OVR_FREE(text);
-        return (bytes == len);
-    }
-    else
-    {
-        return false;
-    }
+    // Written straight to the file in chunks instead of printing the whole text first.
+    JsonWriter writer(&f, true);
+    writer.WriteValue(this);
+    const bool written = writer.Flush();
+    f.Close();
+    return written;
 }
 
 //-----------------------------------------------------------------------------
@@ -20,6 +20,8 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 
 namespace OVR {  
 
+class JsonArena;
+
 // JSONItemType describes the type of JSON item, specifying the type of
 // data that can be obtained from it.
 enum JSONItemType
@@ -44,6 +46,8 @@ class JSON : public RefCountBase<JSON>, public ListNode<JSON>
 {
 protected:
     List<JSON>      Children;
+    JsonArena*      Arena;      // Arena the node is allocated from, NULL for nodes on the heap.
+    JsonArena*      OwnedArena; // Arena with all the nodes of the tree, only set on the root.
 
 public:
     JSONItemType    Type;       // Type of this JSON node.
@@ -71,6 +75,13 @@ public:
     // Returns a null pointer and fills in *perror in case of parse error.
     static JSON*    Load(const char* path, const char** perror = 0);
 
+    // Same as Parse and Load, but all nodes are allocated from a single arena owned by
+    // the returned root, object names are interned and numbers do not keep their source
+    // text in Value. Nodes can still be detached, replaced and released, but they must
+    // not be used after the root is released.
+    static JSON*    ParseArena(const char* buff, const char** perror = 0);
+    static JSON*    LoadArena(const char* path, const char** perror = 0);
+
     // Saves a JSON object to a file.
     bool            Save(const char* path);
 
@@ -133,17 +144,21 @@ protected:
 
     static JSON*    createHelper(JSONItemType itemType, double dval, const char* strVal = 0);
 
-    // JSON Parsing helper functions.
-    const char*     parseValue(const char *buff, const char** perror);
-    const char*     parseNumber(const char *num);
-    const char*     parseArray(const char* value, const char** perror);
-    const char*     parseObject(const char* value, const char** perror);
-    const char*     parseString(const char* str, const char** perror);
+    static JSON*    parseRoot(const char* buff, const char** perror, bool useArena);
+    static JSON*    loadRoot(const char* path, const char** perror, bool useArena);
+    static JSON*    createChild(JsonArena* arena);
+    void            releaseChildren();
 
-    char*           PrintObject(int depth, bool fmt);
-    char*           PrintArray(int depth, bool fmt);
+    // JSON Parsing helper functions. Nodes are allocated from the arena if it is not NULL.
+    const char*     parseValue(const char *buff, const char** perror, JsonArena* arena);
+    const char*     parseNumber(const char *num, JsonArena* arena);
+    const char*     parseArray(const char* value, const char** perror, JsonArena* arena);
+    const char*     parseObject(const char* value, const char** perror, JsonArena* arena);
+    const char*     parseString(const char* str, const char** perror, JsonArena* arena, bool isName);
 
 	friend class JsonReader;
+	friend class JsonArena;
+	friend class JsonWriter;
 };
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,1176 @@
+/************************************************************************************
+
+Filename    :   OVR_JSONStream.cpp
+Content     :   Streaming reader and writer for JSON text
+Created     :   October 16, 2026
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+************************************************************************************/
+
+#include "OVR_JSONStream.h"
+
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <float.h>
+
+#include "OVR_File.h"
+#include "OVR_JSON.h"
+#include "OVR_Log.h"
+#include "OVR_String.h"
+#include "OVR_Std.h"
+
+namespace OVR {
+
+// Powers of ten that are exactly representable as a double.
+static const double ExactPowersOfTen[] =
+{
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int MAX_EXACT_POWER_OF_TEN = 22;
+
+static const int MAX_NUMBER_LENGTH = 64;
+
+//==============================
+// JsonFileSource::Read
+int JsonFileSource::Read( uint8_t * buffer, int numBytes )
+{
+	return pFile->Read( buffer, numBytes );
+}
+
+//==============================
+// JsonStreamReader::JsonStreamReader
+JsonStreamReader::JsonStreamReader( const void * text, const size_t length ) :
+	Source( NULL ),
+	Buffer( NULL ),
+	BufferSize( 0 ),
+	Cur( static_cast< const uint8_t * >( text ) ),
+	End( static_cast< const uint8_t * >( text ) + length ),
+	AtEnd( true ),
+	State( STATE_VALUE ),
+	Token( JSON_TOKEN_NONE ),
+	Depth( 0 ),
+	Number( 0.0 ),
+	Integer( 0 ),
+	IsInteger( false ),
+	Error( NULL ),
+	Line( 1 )
+{
+	Text.PushBack( '\0' );
+}
+
+//==============================
+// JsonStreamReader::JsonStreamReader
+JsonStreamReader::JsonStreamReader( JsonStreamSource * source, const int chunkSize ) :
+	Source( source ),
+	Buffer( NULL ),
+	BufferSize( chunkSize ),
+	Cur( NULL ),
+	End( NULL ),
+	AtEnd( false ),
+	State( STATE_VALUE ),
+	Token( JSON_TOKEN_NONE ),
+	Depth( 0 ),
+	Number( 0.0 ),
+	Integer( 0 ),
+	IsInteger( false ),
+	Error( NULL ),
+	Line( 1 )
+{
+	OVR_ASSERT( source != NULL && chunkSize > 0 );
+	Buffer = (uint8_t *)OVR_ALLOC( BufferSize );
+	Text.PushBack( '\0' );
+}
+
+//==============================
+// JsonStreamReader::~JsonStreamReader
+JsonStreamReader::~JsonStreamReader()
+{
+	OVR_FREE( Buffer );
+}
+
+//==============================
+// JsonStreamReader::Fill
+bool JsonStreamReader::Fill()
+{
+	if ( AtEnd || Buffer == NULL )
+	{
+		return false;
+	}
+	const int bytesRead = Source->Read( Buffer, BufferSize );
+	if ( bytesRead <= 0 )
+	{
+		if ( bytesRead < 0 )
+		{
+			Error = "Error: Failed to read the stream";
+		}
+		AtEnd = true;
+		return false;
+	}
+	Cur = Buffer;
+	End = Buffer + bytesRead;
+	return true;
+}
+
+//==============================
+// JsonStreamReader::Peek
+int JsonStreamReader::Peek()
+{
+	if ( Cur == End && !Fill() )
+	{
+		return -1;
+	}
+	return *Cur;
+}
+
+//==============================
+// JsonStreamReader::Get
+int JsonStreamReader::Get()
+{
+	if ( Cur == End && !Fill() )
+	{
+		return -1;
+	}
+	return *Cur++;
+}
+
+//==============================
+// JsonStreamReader::SkipWhitespace
+int JsonStreamReader::SkipWhitespace()
+{
+	for ( ; ; )
+	{
+		const int c = Peek();
+		if ( c == '\n' )
+		{
+			Line++;
+		}
+		else if ( c != ' ' && c != '\t' && c != '\r' )
+		{
+			return c;
+		}
+		Cur++;
+	}
+}
+
+//==============================
+// JsonStreamReader::Fail
+JsonStreamToken JsonStreamReader::Fail( const char * error )
+{
+	// A read error is the cause of whatever syntax error follows.
+	if ( Error == NULL )
+	{
+		Error = error;
+	}
+	Token = JSON_TOKEN_ERROR;
+	return Token;
+}
+
+//==============================
+// JsonStreamReader::EndValue
+JsonStreamToken JsonStreamReader::EndValue( const JsonStreamToken token )
+{
+	State = ( Depth == 0 ) ? STATE_DONE : STATE_COMMA_OR_END;
+	Token = token;
+	return Token;
+}
+
+//==============================
+// JsonStreamReader::Next
+JsonStreamToken JsonStreamReader::Next()
+{
+	if ( Token == JSON_TOKEN_END || Token == JSON_TOKEN_ERROR )
+	{
+		return Token;
+	}
+
+	const int c = SkipWhitespace();
+	switch ( State )
+	{
+		case STATE_VALUE:
+			return ReadValueToken( c );
+
+		case STATE_FIRST_VALUE_OR_END:
+			if ( c == ']' )
+			{
+				Cur++;
+				Depth--;
+				return EndValue( JSON_TOKEN_END_ARRAY );
+			}
+			return ReadValueToken( c );
+
+		case STATE_FIRST_NAME_OR_END:
+			if ( c == '}' )
+			{
+				Cur++;
+				Depth--;
+				return EndValue( JSON_TOKEN_END_OBJECT );
+			}
+			return ReadName( c );
+
+		case STATE_NAME:
+			return ReadName( c );
+
+		case STATE_COMMA_OR_END:
+		{
+			const bool inObject = ( Containers[Depth - 1] == '{' );
+			if ( c == ',' )
+			{
+				Cur++;
+				const int next = SkipWhitespace();
+				return inObject ? ReadName( next ) : ReadValueToken( next );
+			}
+			if ( c == ( inObject ? '}' : ']' ) )
+			{
+				Cur++;
+				Depth--;
+				return EndValue( inObject ? JSON_TOKEN_END_OBJECT : JSON_TOKEN_END_ARRAY );
+			}
+			if ( c == -1 )
+			{
+				return Fail( "Syntax Error: Unexpected end of text" );
+			}
+			return Fail( inObject ? "Syntax Error: Missing closing brace" : "Syntax Error: Missing ending bracket" );
+		}
+
+		case STATE_DONE:
+			if ( c != -1 )
+			{
+				return Fail( "Syntax Error: Text after the end of the value" );
+			}
+			if ( Error != NULL )
+			{
+				return Fail( Error );
+			}
+			Token = JSON_TOKEN_END;
+			return Token;
+	}
+	return Fail( "Error: Bad parse state" );
+}
+
+//==============================
+// JsonStreamReader::ReadValueToken
+JsonStreamToken JsonStreamReader::ReadValueToken( const int c )
+{
+	switch ( c )
+	{
+		case '{':
+		case '[':
+			if ( Depth >= JSON_STREAM_MAX_DEPTH )
+			{
+				return Fail( "Syntax Error: Nested too deep" );
+			}
+			Cur++;
+			Containers[Depth++] = (char)c;
+			State = ( c == '{' ) ? STATE_FIRST_NAME_OR_END : STATE_FIRST_VALUE_OR_END;
+			Token = ( c == '{' ) ? JSON_TOKEN_BEGIN_OBJECT : JSON_TOKEN_BEGIN_ARRAY;
+			return Token;
+		case '\"':
+			Cur++;
+			if ( !ReadStringText() )
+			{
+				return Token;
+			}
+			return EndValue( JSON_TOKEN_STRING );
+		case 't':
+			return ReadLiteral( "true", JSON_TOKEN_BOOL, 1.0 );
+		case 'f':
+			return ReadLiteral( "false", JSON_TOKEN_BOOL, 0.0 );
+		case 'n':
+			return ReadLiteral( "null", JSON_TOKEN_NULL, 0.0 );
+		case -1:
+			return Fail( "Syntax Error: Unexpected end of text" );
+		default:
+			if ( c == '-' || ( c >= '0' && c <= '9' ) )
+			{
+				return ReadNumber();
+			}
+			return Fail( "Syntax Error: Invalid syntax" );
+	}
+}
+
+//==============================
+// JsonStreamReader::ReadName
+JsonStreamToken JsonStreamReader::ReadName( const int c )
+{
+	if ( c != '\"' )
+	{
+		return Fail( "Syntax Error: Missing quote" );
+	}
+	Cur++;
+	if ( !ReadStringText() )
+	{
+		return Token;
+	}
+	if ( SkipWhitespace() != ':' )
+	{
+		return Fail( "Syntax Error: Missing colon" );
+	}
+	Cur++;
+	State = STATE_VALUE;
+	Token = JSON_TOKEN_NAME;
+	return Token;
+}
+
+//==============================
+// JsonStreamReader::ReadLiteral
+JsonStreamToken JsonStreamReader::ReadLiteral( const char * literal, const JsonStreamToken token, const double value )
+{
+	for ( const char * p = literal; *p != '\0'; p++ )
+	{
+		if ( Get() != *p )
+		{
+			return Fail( "Syntax Error: Invalid syntax" );
+		}
+	}
+	Number = value;
+	Integer = (int64_t)value;
+	IsInteger = false;
+	return EndValue( token );
+}
+
+//==============================
+// JsonStreamReader::ReadNumber
+JsonStreamToken JsonStreamReader::ReadNumber()
+{
+	// Numbers are short, so they are copied out to parse them across chunk boundaries.
+	char text[MAX_NUMBER_LENGTH];
+	int length = 0;
+	for ( ; ; )
+	{
+		const int c = Peek();
+		if ( !( ( c >= '0' && c <= '9' ) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' ) )
+		{
+			break;
+		}
+		if ( length >= MAX_NUMBER_LENGTH - 1 )
+		{
+			return Fail( "Syntax Error: Number too long" );
+		}
+		text[length++] = (char)c;
+		Cur++;
+	}
+	text[length] = '\0';
+
+	const char * end = ParseNumber( text, Number, IsInteger, Integer );
+	if ( end != text + length )
+	{
+		return Fail( "Syntax Error: Invalid number" );
+	}
+	return EndValue( JSON_TOKEN_NUMBER );
+}
+
+//==============================
+// JsonStreamReader::ReadHex4
+bool JsonStreamReader::ReadHex4( uint32_t & value )
+{
+	value = 0;
+	for ( int i = 0; i < 4; i++ )
+	{
+		const int c = Get();
+		if ( c >= '0' && c <= '9' )
+		{
+			value = value * 16 + ( c - '0' );
+		}
+		else if ( c >= 'a' && c <= 'f' )
+		{
+			value = value * 16 + ( c - 'a' + 10 );
+		}
+		else if ( c >= 'A' && c <= 'F' )
+		{
+			value = value * 16 + ( c - 'A' + 10 );
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//==============================
+// JsonStreamReader::AppendCodePoint
+void JsonStreamReader::AppendCodePoint( const uint32_t c )
+{
+	if ( c < 0x80 )
+	{
+		Text.PushBack( (char)c );
+	}
+	else if ( c < 0x800 )
+	{
+		Text.PushBack( (char)( 0xC0 | ( c >> 6 ) ) );
+		Text.PushBack( (char)( 0x80 | ( c & 0x3F ) ) );
+	}
+	else if ( c < 0x10000 )
+	{
+		Text.PushBack( (char)( 0xE0 | ( c >> 12 ) ) );
+		Text.PushBack( (char)( 0x80 | ( ( c >> 6 ) & 0x3F ) ) );
+		Text.PushBack( (char)( 0x80 | ( c & 0x3F ) ) );
+	}
+	else
+	{
+		Text.PushBack( (char)( 0xF0 | ( c >> 18 ) ) );
+		Text.PushBack( (char)( 0x80 | ( ( c >> 12 ) & 0x3F ) ) );
+		Text.PushBack( (char)( 0x80 | ( ( c >> 6 ) & 0x3F ) ) );
+		Text.PushBack( (char)( 0x80 | ( c & 0x3F ) ) );
+	}
+}
+
+//==============================
+// JsonStreamReader::ReadStringText
+// Decodes the string after the opening quote into Text.
+bool JsonStreamReader::ReadStringText()
+{
+	Text.Clear();
+	for ( ; ; )
+	{
+		if ( Cur == End && !Fill() )
+		{
+			Fail( "Syntax Error: Missing closing quote" );
+			return false;
+		}
+
+		// Copy the characters up to the next quote or escape in one go.
+		const uint8_t * start = Cur;
+		while ( Cur < End && *Cur != '\"' && *Cur != '\\' )
+		{
+			Cur++;
+		}
+		Text.Append( (const char *)start, Cur - start );
+		if ( Cur == End )
+		{
+			continue;
+		}
+
+		if ( *Cur++ == '\"' )
+		{
+			break;
+		}
+
+		const int escape = Get();
+		switch ( escape )
+		{
+			case 'b': Text.PushBack( '\b' ); break;
+			case 'f': Text.PushBack( '\f' ); break;
+			case 'n': Text.PushBack( '\n' ); break;
+			case 'r': Text.PushBack( '\r' ); break;
+			case 't': Text.PushBack( '\t' ); break;
+			case 'u':
+			{
+				uint32_t c;
+				if ( !ReadHex4( c ) )
+				{
+					Fail( "Syntax Error: Invalid unicode escape" );
+					return false;
+				}
+				// UTF16 surrogate pairs.
+				if ( c >= 0xD800 && c <= 0xDBFF )
+				{
+					uint32_t c2;
+					if ( Get() != '\\' || Get() != 'u' || !ReadHex4( c2 ) || c2 < 0xDC00 || c2 > 0xDFFF )
+					{
+						Fail( "Syntax Error: Invalid surrogate pair" );
+						return false;
+					}
+					c = 0x10000 + ( ( ( c & 0x3FF ) << 10 ) | ( c2 & 0x3FF ) );
+				}
+				else if ( c >= 0xDC00 && c <= 0xDFFF )
+				{
+					Fail( "Syntax Error: Invalid surrogate pair" );
+					return false;
+				}
+				// Null characters are dropped, like JSON::Parse does.
+				if ( c != 0 )
+				{
+					AppendCodePoint( c );
+				}
+				break;
+			}
+			case -1:
+				Fail( "Syntax Error: Missing closing quote" );
+				return false;
+			default:
+				Text.PushBack( (char)escape );
+				break;
+		}
+	}
+	Text.PushBack( '\0' );
+	return true;
+}
+
+//==============================
+// JsonStreamReader::SkipValue
+bool JsonStreamReader::SkipValue()
+{
+	Next();
+	return SkipRestOfValue();
+}
+
+//==============================
+// JsonStreamReader::SkipRestOfValue
+bool JsonStreamReader::SkipRestOfValue()
+{
+	if ( Token == JSON_TOKEN_BEGIN_OBJECT || Token == JSON_TOKEN_BEGIN_ARRAY )
+	{
+		const int depth = Depth - 1;
+		while ( Depth > depth )
+		{
+			const JsonStreamToken t = Next();
+			if ( t == JSON_TOKEN_ERROR || t == JSON_TOKEN_END )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	return ( Token >= JSON_TOKEN_STRING && Token <= JSON_TOKEN_NULL );
+}
+
+//==============================
+// JsonStreamReader::ReadDouble
+double JsonStreamReader::ReadDouble( const double defaultValue )
+{
+	if ( Next() == JSON_TOKEN_NUMBER || Token == JSON_TOKEN_BOOL )
+	{
+		return Number;
+	}
+	SkipRestOfValue();
+	return defaultValue;
+}
+
+//==============================
+// JsonStreamReader::ReadFloat
+float JsonStreamReader::ReadFloat( const float defaultValue )
+{
+	if ( Next() == JSON_TOKEN_NUMBER || Token == JSON_TOKEN_BOOL )
+	{
+		return (float)Number;
+	}
+	SkipRestOfValue();
+	return defaultValue;
+}
+
+//==============================
+// JsonStreamReader::ReadInt32
+int32_t JsonStreamReader::ReadInt32( const int32_t defaultValue )
+{
+	if ( Next() == JSON_TOKEN_NUMBER || Token == JSON_TOKEN_BOOL )
+	{
+		return GetInt32();
+	}
+	SkipRestOfValue();
+	return defaultValue;
+}
+
+//==============================
+// JsonStreamReader::ReadInt64
+int64_t JsonStreamReader::ReadInt64( const int64_t defaultValue )
+{
+	if ( Next() == JSON_TOKEN_NUMBER || Token == JSON_TOKEN_BOOL )
+	{
+		return GetInt64();
+	}
+	SkipRestOfValue();
+	return defaultValue;
+}
+
+//==============================
+// JsonStreamReader::ReadString
+const String JsonStreamReader::ReadString( const String & defaultValue )
+{
+	if ( Next() == JSON_TOKEN_STRING )
+	{
+		return String( Text.GetDataPtr(), Text.GetSize() - 1 );
+	}
+	SkipRestOfValue();
+	return defaultValue;
+}
+
+//==============================
+// JsonStreamReader::ReadValue
+JSON * JsonStreamReader::ReadValue()
+{
+	return ReadValue( Next() );
+}
+
+//==============================
+// JsonStreamReader::ReadValue
+JSON * JsonStreamReader::ReadValue( const JsonStreamToken token )
+{
+	switch ( token )
+	{
+		case JSON_TOKEN_BEGIN_OBJECT:
+		{
+			JSON * object = JSON::CreateObject();
+			while ( Next() == JSON_TOKEN_NAME )
+			{
+				const String name( Text.GetDataPtr(), Text.GetSize() - 1 );
+				JSON * item = ReadValue( Next() );
+				if ( item == NULL )
+				{
+					object->Release();
+					return NULL;
+				}
+				object->AddItem( name.ToCStr(), item );
+			}
+			if ( Token != JSON_TOKEN_END_OBJECT )
+			{
+				object->Release();
+				return NULL;
+			}
+			return object;
+		}
+		case JSON_TOKEN_BEGIN_ARRAY:
+		{
+			JSON * array = JSON::CreateArray();
+			for ( JsonStreamToken t = Next(); t != JSON_TOKEN_END_ARRAY; t = Next() )
+			{
+				JSON * item = ReadValue( t );
+				if ( item == NULL )
+				{
+					array->Release();
+					return NULL;
+				}
+				array->AddArrayElement( item );
+			}
+			return array;
+		}
+		case JSON_TOKEN_STRING:		return JSON::CreateString( Text.GetDataPtr() );
+		case JSON_TOKEN_NUMBER:		return JSON::CreateNumber( Number );
+		case JSON_TOKEN_BOOL:		return JSON::CreateBool( Number != 0.0 );
+		case JSON_TOKEN_NULL:		return JSON::CreateNull();
+		default:					return NULL;
+	}
+}
+
+//==============================
+// JsonStreamReader::ParseNumber
+// Accumulates up to 19 significant digits in an integer, then scales by an exact
+// power of ten. With at most 2^53 in the mantissa and a power of ten up to 10^22,
+// both operands are exact and the result is rounded only once.
+const char * JsonStreamReader::ParseNumber( const char * str, double & value, bool & isInteger, int64_t & intValue )
+{
+	const char * p = str;
+	const bool negative = ( *p == '-' );
+	if ( negative )
+	{
+		p++;
+	}
+	if ( *p < '0' || *p > '9' )
+	{
+		value = 0.0;
+		isInteger = false;
+		intValue = 0;
+		return str;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool isFraction = false;
+
+	for ( ; *p >= '0' && *p <= '9'; p++ )
+	{
+		if ( digits < 19 )
+		{
+			mantissa = mantissa * 10 + ( *p - '0' );
+			digits += ( mantissa != 0 );
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+	if ( *p == '.' && p[1] >= '0' && p[1] <= '9' )
+	{
+		isFraction = true;
+		for ( p++; *p >= '0' && *p <= '9'; p++ )
+		{
+			if ( digits < 19 )
+			{
+				mantissa = mantissa * 10 + ( *p - '0' );
+				digits += ( mantissa != 0 );
+				exponent--;
+			}
+		}
+	}
+	if ( *p == 'e' || *p == 'E' )
+	{
+		const char * e = p + 1;
+		const bool negativeExponent = ( *e == '-' );
+		if ( *e == '-' || *e == '+' )
+		{
+			e++;
+		}
+		if ( *e >= '0' && *e <= '9' )
+		{
+			isFraction = true;
+			int exp = 0;
+			for ( ; *e >= '0' && *e <= '9'; e++ )
+			{
+				if ( exp < 100000 )
+				{
+					exp = exp * 10 + ( *e - '0' );
+				}
+			}
+			exponent += negativeExponent ? -exp : exp;
+			p = e;
+		}
+	}
+
+	double d = (double)mantissa;
+	if ( mantissa != 0 && exponent != 0 )
+	{
+		if ( exponent > 400 )
+		{
+			exponent = 400;
+		}
+		else if ( exponent < -400 )
+		{
+			exponent = -400;
+		}
+		while ( exponent > MAX_EXACT_POWER_OF_TEN )
+		{
+			d *= ExactPowersOfTen[MAX_EXACT_POWER_OF_TEN];
+			exponent -= MAX_EXACT_POWER_OF_TEN;
+		}
+		while ( exponent < -MAX_EXACT_POWER_OF_TEN )
+		{
+			d /= ExactPowersOfTen[MAX_EXACT_POWER_OF_TEN];
+			exponent += MAX_EXACT_POWER_OF_TEN;
+		}
+		d = ( exponent < 0 ) ? d / ExactPowersOfTen[-exponent] : d * ExactPowersOfTen[exponent];
+	}
+	value = negative ? -d : d;
+
+	isInteger = !isFraction && exponent == 0 && mantissa <= (uint64_t)LLONG_MAX;
+	intValue = isInteger ? ( negative ? -(int64_t)mantissa : (int64_t)mantissa ) : 0;
+	return p;
+}
+
+//==============================
+// JsonWriter::JsonWriter
+JsonWriter::JsonWriter( const bool pretty, const int depth ) :
+	pFile( NULL ),
+	ChunkSize( 0 ),
+	Pretty( pretty ),
+	BaseDepth( depth ),
+	Failed( false ),
+	Data( NULL ),
+	Length( 0 ),
+	Capacity( 0 )
+{
+}
+
+//==============================
+// JsonWriter::JsonWriter
+JsonWriter::JsonWriter( File * file, const bool pretty, const int chunkSize ) :
+	pFile( file ),
+	ChunkSize( chunkSize ),
+	Pretty( pretty ),
+	BaseDepth( 0 ),
+	Failed( false ),
+	Data( NULL ),
+	Length( 0 ),
+	Capacity( 0 )
+{
+	OVR_ASSERT( file != NULL && chunkSize > 0 );
+}
+
+//==============================
+// JsonWriter::~JsonWriter
+JsonWriter::~JsonWriter()
+{
+	OVR_ASSERT( pFile == NULL || Length == 0 );	// Flush() was not called
+	OVR_FREE( Data );
+}
+
+//==============================
+// JsonWriter::Reserve
+// Makes room for size more characters plus a terminating null.
+char * JsonWriter::Reserve( const int size )
+{
+	if ( Failed )
+	{
+		return NULL;
+	}
+	if ( Length + size + 1 > Capacity )
+	{
+		int newCapacity = ( Capacity > 0 ) ? Capacity * 2 : 256;
+		while ( newCapacity < Length + size + 1 )
+		{
+			newCapacity *= 2;
+		}
+		char * data = (char *)OVR_REALLOC( Data, newCapacity );
+		if ( data == NULL )
+		{
+			// Keep the old buffer, which is freed as usual, and drop all further text.
+			Failed = true;
+			return NULL;
+		}
+		Data = data;
+		Capacity = newCapacity;
+	}
+	return Data + Length;
+}
+
+//==============================
+// JsonWriter::Flush
+bool JsonWriter::Flush()
+{
+	if ( pFile != NULL && Length > 0 )
+	{
+		if ( pFile->Write( (const uint8_t *)Data, Length ) != Length )
+		{
+			Failed = true;
+		}
+		Length = 0;
+	}
+	return !Failed;
+}
+
+//==============================
+// JsonWriter::DetachText
+char * JsonWriter::DetachText()
+{
+	char * end = Reserve( 0 );
+	if ( end == NULL )
+	{
+		OVR_FREE( Data );
+		Data = NULL;
+		Length = 0;
+		Capacity = 0;
+		return NULL;
+	}
+	end[0] = '\0';
+	char * text = Data;
+	Data = NULL;
+	Length = 0;
+	Capacity = 0;
+	return text;
+}
+
+//==============================
+// JsonWriter::Indent
+void JsonWriter::Indent( const int depth )
+{
+	if ( depth > 0 )
+	{
+		char * p = Reserve( depth );
+		if ( p != NULL )
+		{
+			memset( p, '\t', depth );
+			p[depth] = '\0';
+			Length += depth;
+		}
+	}
+}
+
+//==============================
+// JsonWriter::BeforeValue
+// Writes the separator before an array element. Object members are separated
+// when the name is written.
+void JsonWriter::BeforeValue()
+{
+	if ( Levels.GetSize() > 0 && !Levels.Back().IsObject )
+	{
+		if ( Levels.Back().Count++ > 0 )
+		{
+			if ( Pretty )
+			{
+				Put( ", ", 2 );
+			}
+			else
+			{
+				Put( ',' );
+			}
+		}
+	}
+}
+
+//==============================
+// JsonWriter::EndValue
+void JsonWriter::EndValue()
+{
+	if ( pFile != NULL && Length >= ChunkSize )
+	{
+		Flush();
+	}
+}
+
+//==============================
+// JsonWriter::BeginObject
+void JsonWriter::BeginObject()
+{
+	BeforeValue();
+	if ( Pretty )
+	{
+		Put( "{\n", 2 );
+	}
+	else
+	{
+		Put( '{' );
+	}
+	const Level level = { true, 0 };
+	Levels.PushBack( level );
+}
+
+//==============================
+// JsonWriter::EndObject
+void JsonWriter::EndObject()
+{
+	OVR_ASSERT( Levels.GetSize() > 0 && Levels.Back().IsObject );
+	const int count = Levels.Back().Count;
+	Levels.PopBack();
+	if ( Pretty )
+	{
+		// An empty object is indented one level less, as JSON::PrintValue always did.
+		const int depth = BaseDepth + Levels.GetSizeI();
+		if ( count > 0 )
+		{
+			Put( '\n' );
+			Indent( depth );
+		}
+		else
+		{
+			Indent( depth - 1 );
+		}
+	}
+	Put( '}' );
+	EndValue();
+}
+
+//==============================
+// JsonWriter::BeginArray
+void JsonWriter::BeginArray()
+{
+	BeforeValue();
+	Put( '[' );
+	const Level level = { false, 0 };
+	Levels.PushBack( level );
+}
+
+//==============================
+// JsonWriter::EndArray
+void JsonWriter::EndArray()
+{
+	OVR_ASSERT( Levels.GetSize() > 0 && !Levels.Back().IsObject );
+	Levels.PopBack();
+	Put( ']' );
+	EndValue();
+}
+
+//==============================
+// JsonWriter::WriteName
+void JsonWriter::WriteName( const char * name )
+{
+	OVR_ASSERT( Levels.GetSize() > 0 && Levels.Back().IsObject );
+	if ( Levels.Back().Count++ > 0 )
+	{
+		if ( Pretty )
+		{
+			Put( ",\n", 2 );
+		}
+		else
+		{
+			Put( ',' );
+		}
+	}
+	if ( Pretty )
+	{
+		Indent( BaseDepth + Levels.GetSizeI() );
+	}
+	PutString( name );
+	if ( Pretty )
+	{
+		Put( ":\t", 2 );
+	}
+	else
+	{
+		Put( ':' );
+	}
+}
+
+//==============================
+// JsonWriter::PutString
+void JsonWriter::PutString( const char * str )
+{
+	if ( str == NULL )
+	{
+		return;
+	}
+	Put( '\"' );
+	for ( ; ; )
+	{
+		// Copy the characters that need no escape in one go.
+		const char * start = str;
+		while ( (unsigned char)*str > 31 && *str != '\"' && *str != '\\' )
+		{
+			str++;
+		}
+		if ( str > start )
+		{
+			Put( start, (int)( str - start ) );
+		}
+		if ( *str == '\0' )
+		{
+			break;
+		}
+		const unsigned char c = (unsigned char)*str++;
+		switch ( c )
+		{
+			case '\\':	Put( "\\\\", 2 ); break;
+			case '\"':	Put( "\\\"", 2 ); break;
+			case '\b':	Put( "\\b", 2 ); break;
+			case '\f':	Put( "\\f", 2 ); break;
+			case '\n':	Put( "\\n", 2 ); break;
+			case '\r':	Put( "\\r", 2 ); break;
+			case '\t':	Put( "\\t", 2 ); break;
+			default:
+			{
+				static const char hex[] = "0123456789abcdef";
+				char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+				Put( escape, 6 );
+				break;
+			}
+		}
+	}
+	Put( '\"' );
+}
+
+//==============================
+// JsonWriter::WriteString
+void JsonWriter::WriteString( const char * value )
+{
+	BeforeValue();
+	PutString( value );
+	EndValue();
+}
+
+//==============================
+// JsonWriter::WriteNumber
+// Uses the same formats as the JSON writer always did, but integers are formatted
+// without printf, and a decimal comma from the C locale is replaced.
+void JsonWriter::WriteNumber( const double value )
+{
+	BeforeValue();
+
+	char buffer[64];
+	int length = 0;
+	const int valueInt = (int)value;
+	if ( fabs( (double)valueInt - value ) <= DBL_EPSILON && value <= INT_MAX && value >= INT_MIN )
+	{
+		char digits[16];
+		int numDigits = 0;
+		unsigned int u = ( valueInt < 0 ) ? 0u - (unsigned int)valueInt : (unsigned int)valueInt;
+		do
+		{
+			digits[numDigits++] = (char)( '0' + u % 10 );
+			u /= 10;
+		} while ( u != 0 );
+		if ( valueInt < 0 )
+		{
+			buffer[length++] = '-';
+		}
+		while ( numDigits > 0 )
+		{
+			buffer[length++] = digits[--numDigits];
+		}
+	}
+	else
+	{
+		if ( fabs( floor( value ) - value ) <= DBL_EPSILON && fabs( value ) < 1.0e60 )
+		{
+			length = OVR_sprintf( buffer, sizeof( buffer ), "%.0f", value );
+		}
+		else if ( fabs( value ) < 1.0e-6 || fabs( value ) > 1.0e9 )
+		{
+			length = OVR_sprintf( buffer, sizeof( buffer ), "%e", value );
+		}
+		else
+		{
+			length = OVR_sprintf( buffer, sizeof( buffer ), "%f", value );
+		}
+		if ( length < 0 || length >= (int)sizeof( buffer ) )
+		{
+			length = OVR_strlen( buffer );
+		}
+		for ( int i = 0; i < length; i++ )
+		{
+			if ( buffer[i] == ',' )
+			{
+				buffer[i] = '.';
+			}
+		}
+	}
+	Put( buffer, length );
+	EndValue();
+}
+
+//==============================
+// JsonWriter::WriteBool
+void JsonWriter::WriteBool( const bool value )
+{
+	BeforeValue();
+	if ( value )
+	{
+		Put( "true", 4 );
+	}
+	else
+	{
+		Put( "false", 5 );
+	}
+	EndValue();
+}
+
+//==============================
+// JsonWriter::WriteNull
+void JsonWriter::WriteNull()
+{
+	BeforeValue();
+	Put( "null", 4 );
+	EndValue();
+}
+
+//==============================
+// JsonWriter::WriteValue
+void JsonWriter::WriteValue( const JSON * value )
+{
+	switch ( value->Type )
+	{
+		case JSON_Null:		WriteNull(); break;
+		case JSON_Bool:		WriteBool( value->dValue != 0.0 ); break;
+		case JSON_Number:	WriteNumber( value->dValue ); break;
+		case JSON_String:	WriteString( value->Value.ToCStr() ); break;
+		case JSON_Array:
+		{
+			BeginArray();
+			for ( const JSON * child = value->Children.GetFirst(); !value->Children.IsNull( child ); child = value->Children.GetNext( child ) )
+			{
+				WriteValue( child );
+			}
+			EndArray();
+			break;
+		}
+		case JSON_Object:
+		{
+			BeginObject();
+			for ( const JSON * child = value->Children.GetFirst(); !value->Children.IsNull( child ); child = value->Children.GetNext( child ) )
+			{
+				WriteName( child->Name.ToCStr() );
+				WriteValue( child );
+			}
+			EndObject();
+			break;
+		}
+		case JSON_None:
+			OVR_ASSERT_LOG( false, ( "Bad JSON type." ) );
+			Failed = true;
+			break;
+	}
+}
+
+} // namespace OVR
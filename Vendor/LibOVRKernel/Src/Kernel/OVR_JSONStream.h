@@ -0,0 +1,322 @@
+/************************************************************************************
+
+PublicHeader:   None
+Filename    :   OVR_JSONStream.h
+Content     :   Streaming reader and writer for JSON text
+Created     :   October 16, 2026
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+************************************************************************************/
+
+#ifndef OVR_JSONStream_h
+#define OVR_JSONStream_h
+
+#include <string.h>
+
+#include "OVR_Types.h"
+#include "OVR_Array.h"
+#include "OVR_String.h"
+
+namespace OVR {
+
+class File;
+class JSON;
+
+//-----------------------------------------------------------------------------------
+// ***** JsonStreamSource
+
+// Supplies the JSON text to a JsonStreamReader in chunks.
+class JsonStreamSource
+{
+public:
+	virtual			~JsonStreamSource() {}
+
+	// Reads up to numBytes into the buffer. Returns the number of bytes read,
+	// 0 at the end of the stream, or -1 on error.
+	virtual int		Read( uint8_t * buffer, int numBytes ) = 0;
+};
+
+// Reads the JSON text from a kernel file, for instance a SysFile.
+class JsonFileSource : public JsonStreamSource
+{
+public:
+	explicit		JsonFileSource( File * file ) : pFile( file ) {}
+
+	virtual int		Read( uint8_t * buffer, int numBytes );
+
+private:
+	File *			pFile;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** JsonStreamReader
+
+// Pull reader that returns one token at a time without building a JSON tree.
+//
+// Text from a JsonStreamSource is read in chunks of a fixed size, and text in memory,
+// like a MappedView of a file, is read in place, so the memory used only depends on
+// the nesting depth and on the longest string in the text. Numbers are converted
+// without pow() and independent of the C locale.
+//
+// Reading the members of an object:
+//
+//	if ( reader.Next() == JSON_TOKEN_BEGIN_OBJECT )
+//	{
+//		while ( reader.Next() == JSON_TOKEN_NAME )
+//		{
+//			if ( OVR_strcmp( reader.GetString(), "width" ) == 0 && reader.Next() == JSON_TOKEN_NUMBER )
+//			{
+//				width = reader.GetInt32();
+//			}
+//			else
+//			{
+//				reader.SkipValue();
+//			}
+//		}
+//	}
+
+enum JsonStreamToken
+{
+	JSON_TOKEN_NONE,			// Next() has not been called yet
+	JSON_TOKEN_BEGIN_OBJECT,
+	JSON_TOKEN_END_OBJECT,
+	JSON_TOKEN_BEGIN_ARRAY,
+	JSON_TOKEN_END_ARRAY,
+	JSON_TOKEN_NAME,			// name of an object member, the value is the next token
+	JSON_TOKEN_STRING,
+	JSON_TOKEN_NUMBER,
+	JSON_TOKEN_BOOL,
+	JSON_TOKEN_NULL,
+	JSON_TOKEN_END,				// end of the text after the top level value
+	JSON_TOKEN_ERROR			// syntax or read error, see GetError()
+};
+
+static const int JSON_STREAM_CHUNK_SIZE	= 64 * 1024;
+static const int JSON_STREAM_MAX_DEPTH	= 256;
+
+class JsonStreamReader
+{
+public:
+	// Reads the text in place. The text does not need to be null-terminated.
+					JsonStreamReader( const void * text, const size_t length );
+	// Reads the text from the source in chunks of chunkSize bytes.
+					JsonStreamReader( JsonStreamSource * source, const int chunkSize = JSON_STREAM_CHUNK_SIZE );
+					~JsonStreamReader();
+
+	// Reads the next token. Once JSON_TOKEN_END or JSON_TOKEN_ERROR is returned,
+	// all further calls return the same token.
+	JsonStreamToken	Next();
+	JsonStreamToken	GetToken() const { return Token; }
+
+	// Skips the next value, including all nested values of an object or array.
+	// Call after JSON_TOKEN_NAME to skip a member, or inside an array to skip an
+	// element. Returns false on error.
+	bool			SkipValue();
+	// Skips the rest of the object or array that the last token began, for instance
+	// after Next() returned a value of an unexpected type. Does nothing for other
+	// values. Returns false on error, or if the last token was not a value.
+	bool			SkipRestOfValue();
+
+	// Read the next value, for instance the value of a member after JSON_TOKEN_NAME.
+	// A value of another type is skipped, and the default value is returned instead.
+	double			ReadDouble( const double defaultValue = 0.0 );
+	float			ReadFloat( const float defaultValue = 0.0f );
+	int32_t			ReadInt32( const int32_t defaultValue = 0 );
+	int64_t			ReadInt64( const int64_t defaultValue = 0 );
+	const String	ReadString( const String & defaultValue = String( "" ) );
+
+	// Reads the next value into a JSON tree. Returns NULL on error, or when the next
+	// token ends an object or array. This allows processing large arrays one element
+	// at a time with the JSON interface.
+	JSON *			ReadValue();
+
+	// Value of a JSON_TOKEN_NAME or JSON_TOKEN_STRING token. The string is always
+	// null-terminated, and only valid until the next call to Next().
+	const char *	GetString() const { return Text.GetDataPtr(); }
+	int				GetStringLength() const { return Text.GetSizeI() - 1; }
+
+	// Value of a JSON_TOKEN_NUMBER or JSON_TOKEN_BOOL token.
+	double			GetDouble() const { return Number; }
+	float			GetFloat() const { return (float)Number; }
+	int32_t			GetInt32() const { return IsInteger ? (int32_t)Integer : (int32_t)Number; }
+	int64_t			GetInt64() const { return IsInteger ? Integer : (int64_t)Number; }
+	bool			GetBool() const { return Number != 0.0; }
+	// True if the number has no fraction or exponent and fits in 64 bits.
+	bool			IsIntegerNumber() const { return IsInteger; }
+
+	// Number of objects and arrays that enclose the next token.
+	int				GetDepth() const { return Depth; }
+
+	const char *	GetError() const { return Error; }
+	int				GetErrorLine() const { return Line; }
+
+	// Parses a JSON number at str and returns the first character after it. The
+	// value is exact if it has at most 15 significant digits and a decimal exponent
+	// within +/-22, which covers all numbers written by JSON::PrintValue. If the number
+	// is an integer that fits in 64 bits, isInteger is set and intValue holds it.
+	static const char *	ParseNumber( const char * str, double & value, bool & isInteger, int64_t & intValue );
+
+private:
+	enum ParseState
+	{
+		STATE_VALUE,				// a value, at the top level or after a name or a comma in an array
+		STATE_FIRST_VALUE_OR_END,	// after '['
+		STATE_FIRST_NAME_OR_END,	// after '{'
+		STATE_NAME,					// after a comma in an object
+		STATE_COMMA_OR_END,			// after a value in an object or array
+		STATE_DONE					// after the top level value
+	};
+
+	JsonStreamSource *	Source;
+	uint8_t *		Buffer;
+	int				BufferSize;
+	const uint8_t *	Cur;
+	const uint8_t *	End;
+	bool			AtEnd;
+
+	ParseState		State;
+	JsonStreamToken	Token;
+	int				Depth;
+	char			Containers[JSON_STREAM_MAX_DEPTH];	// '{' or '[' for each enclosing value
+
+	ArrayPOD< char, ArrayConstPolicy< 0, 64, true > >	Text;	// never shrinks while reading
+	double			Number;
+	int64_t			Integer;
+	bool			IsInteger;
+
+	const char *	Error;
+	int				Line;
+
+	int				Peek();
+	int				Get();
+	bool			Fill();
+	int				SkipWhitespace();
+
+	JsonStreamToken	Fail( const char * error );
+	JsonStreamToken	EndValue( const JsonStreamToken token );
+	JsonStreamToken	ReadValueToken( const int c );
+	JsonStreamToken	ReadName( const int c );
+	JsonStreamToken	ReadNumber();
+	JsonStreamToken	ReadLiteral( const char * literal, const JsonStreamToken token, const double value );
+	bool			ReadStringText();
+	bool			ReadHex4( uint32_t & value );
+	void			AppendCodePoint( const uint32_t c );
+	JSON *			ReadValue( const JsonStreamToken token );
+
+	// Not copyable.
+					JsonStreamReader( const JsonStreamReader & );
+	JsonStreamReader &	operator = ( const JsonStreamReader & );
+};
+
+//-----------------------------------------------------------------------------------
+// ***** JsonWriter
+
+// Writes JSON text in a single pass, either into a buffer that grows as needed, or to
+// a file through a buffer that is written out whenever it holds chunkSize bytes.
+//
+// The output is the same as JSON::PrintValue, both compact and pretty printed, with
+// numbers formatted independent of the C locale.
+//
+//	JsonWriter writer;
+//	writer.BeginObject();
+//	writer.WriteName( "width" );
+//	writer.WriteNumber( width );
+//	writer.EndObject();
+
+class JsonWriter
+{
+public:
+	// Writes into a buffer. The depth is the initial indentation when pretty printing.
+	explicit		JsonWriter( const bool pretty = false, const int depth = 0 );
+	// Writes to the file, which must stay open until Flush() is called.
+					JsonWriter( File * file, const bool pretty = false, const int chunkSize = JSON_STREAM_CHUNK_SIZE );
+					~JsonWriter();
+
+	void			BeginObject();
+	void			EndObject();
+	void			BeginArray();
+	void			EndArray();
+
+	// Writes the name of the next object member, the value is written next.
+	void			WriteName( const char * name );
+
+	void			WriteString( const char * value );
+	void			WriteNumber( const double value );
+	void			WriteBool( const bool value );
+	void			WriteNull();
+	// Writes a whole JSON tree.
+	void			WriteValue( const JSON * value );
+
+	// Writes the buffered text to the file. Returns false if any write failed, or if
+	// the buffer could not grow, in which case the text after that point is dropped.
+	bool			Flush();
+	bool			HasFailed() const { return Failed; }
+
+	// The text in the buffer, null-terminated.
+	const char *	GetText() const { return ( Data != NULL ) ? Data : ""; }
+	int				GetLength() const { return Length; }
+	// Returns the text in the buffer and leaves the buffer empty. The text is
+	// allocated with OVR_ALLOC and must be freed with OVR_FREE. Returns NULL if
+	// the writer has failed.
+	char *			DetachText();
+
+private:
+	struct Level
+	{
+		bool		IsObject;
+		int			Count;
+	};
+
+	File *			pFile;
+	int				ChunkSize;
+	bool			Pretty;
+	int				BaseDepth;
+	bool			Failed;
+
+	char *			Data;
+	int				Length;
+	int				Capacity;
+
+	ArrayPOD< Level >	Levels;
+
+	// Returns NULL once the buffer failed to grow.
+	char *			Reserve( const int size );
+	void			Put( const char c );
+	void			Put( const char * str, const int length );
+	void			Indent( const int depth );
+	void			BeforeValue();
+	void			EndValue();
+	void			PutString( const char * str );
+
+	// Not copyable.
+					JsonWriter( const JsonWriter & );
+	JsonWriter &	operator = ( const JsonWriter & );
+};
+
+inline void JsonWriter::Put( const char c )
+{
+	char * p = Reserve( 1 );
+	if ( p != NULL )
+	{
+		p[0] = c;
+		p[1] = '\0';
+		Length++;
+	}
+}
+
+inline void JsonWriter::Put( const char * str, const int length )
+{
+	char * p = Reserve( length );
+	if ( p != NULL )
+	{
+		memcpy( p, str, length );
+		p[length] = '\0';
+		Length += length;
+	}
+}
+
+} // namespace OVR
+
+#endif // OVR_JSONStream_h
@@ -0,0 +1,564 @@
+/************************************************************************************
+
+Filename    :   OVR_JobSystem.cpp
+Content     :   Work-stealing job system
+Created     :   October 16, 2026
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+************************************************************************************/
+
+#include "OVR_JobSystem.h"
+
+#include <stdio.h>
+
+#if defined( OVR_OS_ANDROID )
+#include <unistd.h>			// for gettid()
+#endif
+
+#include "OVR_Alg.h"
+#include "OVR_Std.h"
+#include "OVR_LogUtils.h"
+
+namespace OVR {
+
+static const int JOB_QUEUE_SIZE		= 1024;		// must be a power of two
+static const int JOB_WORKER_SPINS	= 64;		// attempts to find a job before a worker sleeps
+static const int JOB_MAX_CORES		= 32;
+
+//-----------------------------------------------------------------------------------
+// ***** Worker
+
+// Each worker owns a Chase-Lev deque. The owner pushes and pops at the bottom, and
+// other threads steal from the top. The indices only ever increase, and are compared
+// through their difference so they can wrap around. The jobs sit between the two
+// indices so they are not on the same cache line.
+struct JobSystem::Worker
+{
+	Worker() :
+		WorkerThread( NULL ),
+		Id( NULL ),
+		System( NULL ),
+		Index( 0 ),
+		AffinityMask( 0 ),
+		Top( 0 ),
+		Bottom( 0 ) {}
+
+	bool Push( const JobDecl & job )
+	{
+		const uint32_t b = Bottom;
+		const uint32_t t = Top.Load_Acquire();
+		if ( (int32_t)( b - t ) >= JOB_QUEUE_SIZE )
+		{
+			return false;
+		}
+		Jobs[b & ( JOB_QUEUE_SIZE - 1 )] = job;
+		Bottom.Store_Release( b + 1 );
+		return true;
+	}
+
+	bool Pop( JobDecl & job )
+	{
+		const uint32_t b = Bottom - 1;
+		// The exchange is a full barrier, so thieves see the reservation before Top is read.
+		Bottom.Exchange_Sync( b );
+		const uint32_t t = Top.Load_Acquire();
+		if ( (int32_t)( b - t ) < 0 )
+		{
+			// empty
+			Bottom.Store_Release( b + 1 );
+			return false;
+		}
+		job = Jobs[b & ( JOB_QUEUE_SIZE - 1 )];
+		if ( b != t )
+		{
+			return true;
+		}
+		// The last job may also be taken by a thief.
+		const bool taken = Top.CompareAndSet_Sync( t, t + 1 );
+		Bottom.Store_Release( b + 1 );
+		return taken;
+	}
+
+	bool Steal( JobDecl & job )
+	{
+		const uint32_t t = Top.Load_Acquire();
+		const uint32_t b = Bottom.Load_Acquire();
+		if ( (int32_t)( b - t ) <= 0 )
+		{
+			return false;
+		}
+		job = Jobs[t & ( JOB_QUEUE_SIZE - 1 )];
+		return Top.CompareAndSet_Sync( t, t + 1 );
+	}
+
+	Thread *				WorkerThread;
+	volatile ThreadId		Id;
+	JobSystem *				System;
+	int						Index;
+	uint32_t				AffinityMask;
+
+	AtomicInt< uint32_t >	Top;
+	JobDecl					Jobs[JOB_QUEUE_SIZE];
+	AtomicInt< uint32_t >	Bottom;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** Core affinity
+
+static int GetCoreMaxFrequency( const int core )
+{
+	char path[128];
+	OVR_sprintf( path, sizeof( path ), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", core );
+	FILE * f = fopen( path, "r" );
+	if ( f == NULL )
+	{
+		return 0;
+	}
+	int frequency = 0;
+	if ( fscanf( f, "%d", &frequency ) != 1 )
+	{
+		frequency = 0;
+	}
+	fclose( f );
+	return frequency;
+}
+
+// Returns a bit mask with the cores in the affinity set, or 0 for any core.
+static uint32_t GetCoreAffinityMask( const JobCoreAffinity affinity )
+{
+	if ( affinity == JOB_CORES_ANY )
+	{
+		return 0;
+	}
+
+	const int numCores = Alg::Min( Thread::GetCPUCount(), JOB_MAX_CORES );
+	int frequencies[JOB_MAX_CORES];
+	int maxFrequency = 0;
+	for ( int i = 0; i < numCores; i++ )
+	{
+		frequencies[i] = GetCoreMaxFrequency( i );
+		maxFrequency = Alg::Max( maxFrequency, frequencies[i] );
+	}
+
+	uint32_t big = 0;
+	uint32_t little = 0;
+	for ( int i = 0; i < numCores; i++ )
+	{
+		if ( frequencies[i] == maxFrequency )
+		{
+			big |= 1u << i;
+		}
+		else
+		{
+			little |= 1u << i;
+		}
+	}
+
+	// Without frequencies, or if all cores are the same, all cores are used.
+	if ( maxFrequency == 0 || little == 0 )
+	{
+		return 0;
+	}
+	return ( affinity == JOB_CORES_BIG ) ? big : little;
+}
+
+static int CountBits( uint32_t mask )
+{
+	int count = 0;
+	for ( ; mask != 0; mask &= mask - 1 )
+	{
+		count++;
+	}
+	return count;
+}
+
+//-----------------------------------------------------------------------------------
+// ***** JobSystem
+
+JobSystem::JobSystem( const int numWorkers, const JobCoreAffinity affinity ) :
+	Workers( NULL ),
+	NumWorkers( 0 ),
+	Affinity( affinity ),
+	SharedFirst( 0 ),
+	NumSharedJobs( 0 ),
+	NumDependents( 0 ),
+	WorkEpoch( 0 ),
+	NumSleeping( 0 ),
+	NumWaiting( 0 ),
+	Exit( false )
+{
+	const uint32_t affinityMask = GetCoreAffinityMask( affinity );
+	const int numCores = ( affinityMask != 0 ) ? CountBits( affinityMask ) : Thread::GetCPUCount();
+
+	NumWorkers = ( numWorkers > 0 ) ? numWorkers : numCores - 1;
+	NumWorkers = Alg::Clamp( NumWorkers, 1, JOB_SYSTEM_MAX_WORKERS );
+
+	Workers = new Worker[NumWorkers];
+	for ( int i = 0; i < NumWorkers; i++ )
+	{
+		Workers[i].System = this;
+		Workers[i].Index = i;
+		Workers[i].AffinityMask = affinityMask;
+	}
+	// A worker that fails to start never gets jobs of its own, and the threads that
+	// wait for jobs run them inline, so the system still works without any workers.
+	int numStarted = 0;
+	for ( int i = 0; i < NumWorkers; i++ )
+	{
+		Workers[i].WorkerThread = new Thread( Thread::CreateParams( WorkerThreadFunction, &Workers[i], 128 * 1024 ) );
+		if ( !Workers[i].WorkerThread->Start() )
+		{
+			WARN( "JobSystem: failed to start worker %d", i );
+			delete Workers[i].WorkerThread;
+			Workers[i].WorkerThread = NULL;
+			continue;
+		}
+		numStarted++;
+	}
+
+	LOG( "JobSystem: %d of %d workers, affinity mask 0x%x", numStarted, NumWorkers, affinityMask );
+}
+
+JobSystem::~JobSystem()
+{
+	Exit = true;
+	WakeWorkers();
+
+	for ( int i = 0; i < NumWorkers; i++ )
+	{
+		if ( Workers[i].WorkerThread != NULL )
+		{
+			Workers[i].WorkerThread->Join();
+			delete Workers[i].WorkerThread;
+		}
+	}
+	delete [] Workers;
+}
+
+threadReturn_t JobSystem::WorkerThreadFunction( Thread * thread, void * v )
+{
+	Worker * worker = (Worker *)v;
+	JobSystem * system = worker->System;
+
+	thread->SetThreadName( "OVR::Job" );
+	worker->Id = GetCurrentThreadId();
+
+#if defined( OVR_OS_ANDROID )
+	if ( worker->AffinityMask != 0 )
+	{
+		SetThreadAffinityMask( gettid(), worker->AffinityMask );
+	}
+#endif
+
+	for ( ; ; )
+	{
+		const int epoch = system->WorkEpoch;
+
+		JobDecl job;
+		bool found = false;
+		for ( int i = 0; i < JOB_WORKER_SPINS && !found; i++ )
+		{
+			found = system->FindJob( worker->Index, job );
+		}
+		if ( found )
+		{
+			system->Execute( job );
+			continue;
+		}
+		if ( system->Exit )
+		{
+			break;
+		}
+
+		// Sleep unless jobs were added since the search started. A thread that adds jobs
+		// increments the epoch before checking for sleeping workers, and the worker is
+		// counted as sleeping before the epoch is checked, so a wake up cannot be lost.
+		system->WakeMutex.DoLock();
+		system->NumSleeping.ExchangeAdd_Sync( 1 );
+		if ( system->WorkEpoch.ExchangeAdd_Sync( 0 ) == epoch && !system->Exit )
+		{
+			system->WakeCondition.Wait( &system->WakeMutex );
+		}
+		system->NumSleeping.ExchangeAdd_Sync( -1 );
+		system->WakeMutex.Unlock();
+	}
+
+	return NULL;
+}
+
+int JobSystem::FindWorker() const
+{
+	const ThreadId id = GetCurrentThreadId();
+	for ( int i = 0; i < NumWorkers; i++ )
+	{
+		if ( Workers[i].Id == id )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool JobSystem::FindJob( const int workerIndex, JobDecl & job )
+{
+	// Newest local jobs first, because they are the most likely to be in the cache.
+	if ( workerIndex >= 0 && Workers[workerIndex].Pop( job ) )
+	{
+		return true;
+	}
+
+	if ( NumSharedJobs > 0 )
+	{
+		Lock::Locker locker( &SharedLock );
+		if ( SharedFirst < SharedJobs.GetSizeI() )
+		{
+			job = SharedJobs[SharedFirst++];
+			if ( SharedFirst == SharedJobs.GetSizeI() )
+			{
+				SharedJobs.Clear();
+				SharedFirst = 0;
+			}
+			NumSharedJobs.ExchangeAdd_Sync( -1 );
+			return true;
+		}
+	}
+
+	// Oldest jobs of the other workers, which are usually the largest.
+	const int first = ( workerIndex >= 0 ) ? workerIndex + 1 : 0;
+	for ( int i = 0; i < NumWorkers; i++ )
+	{
+		const int victim = ( first + i ) % NumWorkers;
+		if ( victim != workerIndex && Workers[victim].Steal( job ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Execute( const JobDecl & job )
+{
+	job.Function( job.Data );
+
+	// The counter may be released by a waiting thread as soon as it reaches zero.
+	if ( job.Counter != NULL && job.Counter->Count.ExchangeAdd_Sync( -1 ) == 1 )
+	{
+		if ( NumDependents.ExchangeAdd_Sync( 0 ) > 0 )
+		{
+			ReleaseDependents();
+		}
+		WakeWaiters();
+	}
+}
+
+void JobSystem::Push( const int workerIndex, const JobDecl & job )
+{
+	if ( workerIndex >= 0 && Workers[workerIndex].Push( job ) )
+	{
+		return;
+	}
+
+	Lock::Locker locker( &SharedLock );
+	SharedJobs.PushBack( job );
+	NumSharedJobs.ExchangeAdd_Sync( 1 );
+}
+
+void JobSystem::WakeWorkers()
+{
+	WorkEpoch.ExchangeAdd_Sync( 1 );
+	if ( NumSleeping.ExchangeAdd_Sync( 0 ) > 0 )
+	{
+		Mutex::Locker locker( &WakeMutex );
+		WakeCondition.NotifyAll();
+	}
+	// Waiting threads help with the new jobs.
+	WakeWaiters();
+}
+
+void JobSystem::WakeWaiters()
+{
+	if ( NumWaiting.ExchangeAdd_Sync( 0 ) > 0 )
+	{
+		Mutex::Locker locker( &WakeMutex );
+		DoneCondition.NotifyAll();
+	}
+}
+
+void JobSystem::ReleaseDependents()
+{
+	ArrayPOD< JobDecl > ready;
+	{
+		Lock::Locker locker( &DependentLock );
+		for ( int i = 0; i < Dependents.GetSizeI(); )
+		{
+			if ( Dependents[i].Dependency->IsDone() )
+			{
+				ready.PushBack( Dependents[i].Job );
+				Dependents.RemoveAtUnordered( i );
+				NumDependents.ExchangeAdd_Sync( -1 );
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	if ( ready.GetSizeI() > 0 )
+	{
+		const int workerIndex = FindWorker();
+		for ( int i = 0; i < ready.GetSizeI(); i++ )
+		{
+			Push( workerIndex, ready[i] );
+		}
+		WakeWorkers();
+	}
+}
+
+void JobSystem::Run( const JobDecl * jobs, const int numJobs, JobCounter * counter )
+{
+	if ( numJobs <= 0 )
+	{
+		return;
+	}
+	if ( counter != NULL )
+	{
+		counter->Count.ExchangeAdd_Sync( numJobs );
+	}
+
+	const int workerIndex = FindWorker();
+	for ( int i = 0; i < numJobs; i++ )
+	{
+		JobDecl job = jobs[i];
+		job.Counter = counter;
+		Push( workerIndex, job );
+	}
+	WakeWorkers();
+}
+
+void JobSystem::Run( const JobFunction function, void * data, JobCounter * counter )
+{
+	const JobDecl job( function, data );
+	Run( &job, 1, counter );
+}
+
+void JobSystem::RunAfter( const JobCounter & dependency, const JobDecl * jobs, const int numJobs, JobCounter * counter )
+{
+	if ( numJobs <= 0 )
+	{
+		return;
+	}
+	{
+		Lock::Locker locker( &DependentLock );
+
+		// The dependents are counted before the dependency is checked, and the job that
+		// completes the dependency checks the count after the counter reaches zero. Both
+		// are full barriers, so either that job sees the count and releases these jobs
+		// once it gets the lock, or the dependency is seen as done here.
+		NumDependents.ExchangeAdd_Sync( numJobs );
+		if ( !dependency.IsDone() )
+		{
+			if ( counter != NULL )
+			{
+				counter->Count.ExchangeAdd_Sync( numJobs );
+			}
+			for ( int i = 0; i < numJobs; i++ )
+			{
+				Dependent & dependent = Dependents[Dependents.AllocBack()];
+				dependent.Dependency = &dependency;
+				dependent.Job = jobs[i];
+				dependent.Job.Counter = counter;
+			}
+			return;
+		}
+		NumDependents.ExchangeAdd_Sync( -numJobs );
+	}
+	Run( jobs, numJobs, counter );
+}
+
+void JobSystem::Wait( const JobCounter & counter )
+{
+	const int workerIndex = FindWorker();
+	int spins = 0;
+	while ( !counter.IsDone() )
+	{
+		const int epoch = WorkEpoch;
+
+		JobDecl job;
+		if ( FindJob( workerIndex, job ) )
+		{
+			Execute( job );
+			spins = 0;
+			continue;
+		}
+		if ( ++spins < JOB_WORKER_SPINS )
+		{
+			continue;
+		}
+
+		// Sleep while the remaining jobs run elsewhere, like the workers do. The thread
+		// is counted as waiting before the counter and the epoch are checked, and a job
+		// that completes a counter, or a thread that adds jobs, checks for waiting
+		// threads afterwards, so a wake up cannot be lost.
+		WakeMutex.DoLock();
+		NumWaiting.ExchangeAdd_Sync( 1 );
+		if ( WorkEpoch.ExchangeAdd_Sync( 0 ) == epoch && !counter.IsDone() )
+		{
+			DoneCondition.Wait( &WakeMutex );
+		}
+		NumWaiting.ExchangeAdd_Sync( -1 );
+		WakeMutex.Unlock();
+		spins = 0;
+	}
+}
+
+struct jobRange_t
+{
+	JobSystem::RangeFunction	function;
+	void *						data;
+	int							begin;
+	int							end;
+};
+
+static void RunJobRange( void * data )
+{
+	const jobRange_t * range = (const jobRange_t *)data;
+	range->function( range->data, range->begin, range->end );
+}
+
+void JobSystem::ParallelFor( const int count, const int grainSize, const RangeFunction function, void * data )
+{
+	if ( count <= 0 )
+	{
+		return;
+	}
+
+	const int grain = Alg::Max( grainSize, 1 );
+	const int numRanges = ( count + grain - 1 ) / grain;
+	if ( numRanges == 1 )
+	{
+		function( data, 0, count );
+		return;
+	}
+
+	ArrayPOD< jobRange_t > ranges;
+	ArrayPOD< JobDecl > jobs;
+	ranges.Resize( numRanges );
+	jobs.Resize( numRanges );
+	for ( int i = 0; i < numRanges; i++ )
+	{
+		ranges[i].function = function;
+		ranges[i].data = data;
+		ranges[i].begin = i * grain;
+		ranges[i].end = Alg::Min( ( i + 1 ) * grain, count );
+		jobs[i] = JobDecl( RunJobRange, &ranges[i] );
+	}
+
+	JobCounter counter;
+	Run( jobs.GetDataPtr(), numRanges, &counter );
+	Wait( counter );
+}
+
+} // namespace OVR
@@ -0,0 +1,186 @@
+/************************************************************************************
+
+PublicHeader:   None
+Filename    :   OVR_JobSystem.h
+Content     :   Work-stealing job system
+Created     :   October 16, 2026
+Notes       :
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+************************************************************************************/
+
+#ifndef OVR_JobSystem_h
+#define OVR_JobSystem_h
+
+#include "OVR_Types.h"
+#include "OVR_Atomic.h"
+#include "OVR_Threads.h"
+#include "OVR_Array.h"
+
+namespace OVR {
+
+class JobSystem;
+class JobCounter;
+
+typedef void (*JobFunction)( void * data );
+
+struct JobDecl
+{
+	JobDecl() : Function( NULL ), Data( NULL ), Counter( NULL ) {}
+	JobDecl( JobFunction function, void * data ) : Function( function ), Data( data ), Counter( NULL ) {}
+
+	JobFunction		Function;
+	void *			Data;
+	JobCounter *	Counter;	// set by JobSystem::Run()
+};
+
+//-----------------------------------------------------------------------------------
+// ***** JobCounter
+
+// Counts the jobs that have been added with the counter and did not complete yet.
+// A counter can be reused once it is done.
+class JobCounter
+{
+public:
+					JobCounter() : Count( 0 ) {}
+
+	bool			IsDone() const { return Count.Load_Acquire() == 0; }
+	int				GetCount() const { return Count.Load_Acquire(); }
+
+private:
+	friend class JobSystem;
+
+	mutable AtomicInt< int >	Count;
+
+	// Protected copy constructor
+					JobCounter( const JobCounter & ) {}
+	JobCounter &	operator = ( const JobCounter & ) { return *this; }
+};
+
+//-----------------------------------------------------------------------------------
+// ***** JobSystem
+
+// Runs jobs on a set of worker threads. Each worker has a lock-less Chase-Lev deque
+// that only the worker itself pushes to and pops from, in LIFO order, and that the
+// other workers steal from, in FIFO order. Jobs that are added from threads that are
+// not workers go to a shared queue.
+//
+// Threads that wait for a counter execute jobs themselves until the counter is done,
+// so jobs can wait for other jobs without tying up a worker.
+//
+//	"Dynamic Circular Work-Stealing Deque"
+//	David Chase, Yossi Lev
+//	SPAA 2005
+
+enum JobCoreAffinity
+{
+	JOB_CORES_ANY,			// no affinity
+	JOB_CORES_BIG,			// the cores with the highest maximum frequency
+	JOB_CORES_LITTLE		// all other cores, or all cores if they are the same
+};
+
+static const int JOB_SYSTEM_MAX_WORKERS	= 16;
+
+class JobSystem
+{
+public:
+	// With numWorkers <= 0, a worker is started for each core in the affinity set,
+	// except one for the thread that adds and waits for the jobs.
+					JobSystem( const int numWorkers = 0, const JobCoreAffinity affinity = JOB_CORES_ANY );
+					~JobSystem();
+
+	int				GetNumWorkers() const { return NumWorkers; }
+
+	// Adds jobs that may run immediately. The counter, which can be NULL, is incremented
+	// by the number of jobs and decremented when each job completes.
+	void			Run( const JobDecl * jobs, const int numJobs, JobCounter * counter );
+	void			Run( const JobFunction function, void * data, JobCounter * counter );
+
+	// Adds jobs that are only run once the dependency is done. The dependency must stay
+	// alive, and must not be reused, until these jobs have been started.
+	void			RunAfter( const JobCounter & dependency, const JobDecl * jobs, const int numJobs, JobCounter * counter );
+
+	// Executes jobs on the calling thread until the counter is done. Once there are no
+	// jobs left to take, the thread sleeps until jobs are added or a counter is done.
+	void			Wait( const JobCounter & counter );
+
+	// Calls function( data, begin, end ) for ranges of at most grainSize indices that
+	// cover [0, count) in parallel, and waits for all of them to complete.
+	typedef void (*RangeFunction)( void * data, const int begin, const int end );
+	void			ParallelFor( const int count, const int grainSize, const RangeFunction function, void * data );
+
+private:
+	struct Worker;
+
+	struct Dependent
+	{
+		const JobCounter *	Dependency;
+		JobDecl				Job;
+	};
+
+	int				FindWorker() const;
+	bool			FindJob( const int workerIndex, JobDecl & job );
+	void			Execute( const JobDecl & job );
+	void			Push( const int workerIndex, const JobDecl & job );
+	void			ReleaseDependents();
+	void			WakeWorkers();
+	void			WakeWaiters();
+
+	static threadReturn_t	WorkerThreadFunction( Thread * thread, void * v );
+
+	Worker *					Workers;
+	int							NumWorkers;
+	JobCoreAffinity				Affinity;
+
+	// jobs added by other threads than the workers
+	Lock						SharedLock;
+	ArrayPOD< JobDecl >			SharedJobs;
+	int							SharedFirst;
+	AtomicInt< int >			NumSharedJobs;
+
+	// jobs waiting for a dependency
+	Lock						DependentLock;
+	Array< Dependent >			Dependents;
+	AtomicInt< int >			NumDependents;
+
+	// idle workers sleep until jobs are added
+	Mutex						WakeMutex;
+	WaitCondition				WakeCondition;
+	AtomicInt< int >			WorkEpoch;
+	AtomicInt< int >			NumSleeping;
+
+	// threads in Wait() sleep until jobs are added or a counter is done
+	WaitCondition				DoneCondition;
+	AtomicInt< int >			NumWaiting;
+	volatile bool				Exit;
+};
+
+// Calls functor( array[i], i ) for all elements of the array in parallel.
+template< typename _type_, typename _functor_ >
+void ParallelForArray( JobSystem & jobSystem, Array< _type_ > & array, const int grainSize, _functor_ & functor )
+{
+	struct Range
+	{
+		Array< _type_ > *	array;
+		_functor_ *			functor;
+
+		static void Function( void * data, const int begin, const int end )
+		{
+			Range * range = (Range *)data;
+			for ( int i = begin; i < end; i++ )
+			{
+				(*range->functor)( (*range->array)[i], i );
+			}
+		}
+	};
+
+	Range range;
+	range.array = &array;
+	range.functor = &functor;
+	jobSystem.ParallelFor( array.GetSizeI(), grainSize, Range::Function, &range );
+}
+
+} // namespace OVR
+
+#endif // OVR_JobSystem_h
@@ -85,6 +85,14 @@ void LogWithFileTag( const int prio, const char * fileTag, const char * fmt, ...
 #define ASSERT_WITH_TAG( __expr__, __tag__ ) { if ( !( __expr__ ) ) { WARN_WITH_TAG( __tag__, "ASSERTION FAILED: %s", #__expr__ ); OVR_DEBUG_BREAK; } }
 #endif
 
+#elif defined( OVR_OS_LINUX )	// allow this file to be included in host tools and tests
+
+#define LOG( ... ) ( (void)printf( __VA_ARGS__ ), (void)printf( "\n" ) )
+#define WARN( ... ) ( (void)fprintf( stderr, __VA_ARGS__ ), (void)fprintf( stderr, "\n" ) )
+#define FAIL( ... ) { fprintf( stderr, __VA_ARGS__ ); fprintf( stderr, "\n" ); abort(); }
+#define LOG_WITH_TAG( __tag__, ... ) LOG( __VA_ARGS__ )
+#define ASSERT_WITH_TAG( __expr__, __tag__ )
+
 #else
 #error "unknown platform"
 #endif	
@@ -121,7 +129,7 @@ private:
 
 	static double GetNanoSeconds()
 	{
-#if defined( OVR_OS_ANDROID )
+#if defined( OVR_OS_ANDROID ) || defined( OVR_OS_LINUX )
 		struct timespec now;
 		clock_gettime( CLOCK_MONOTONIC, &now );
 		return (double)now.tv_sec * 1e9 + now.tv_nsec;
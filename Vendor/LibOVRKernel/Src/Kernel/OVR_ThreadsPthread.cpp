@@ -657,7 +657,8 @@ ThreadId GetCurrentThreadId()
 /* static */
 int Thread::GetCPUCount()
 {
-    return 1;
+    const long count = sysconf( _SC_NPROCESSORS_ONLN );
+    return ( count > 0 ) ? (int)count : 1;
 }
 
 // *** Sleep functions
@@ -89,12 +89,13 @@ VrAppInterface life cycle
                                     <--+   |
     5.  while(keyEvent) OnKeyEvent()   |   |
     6.  Frame()                        |   |
-    7.  DrawEyeView(left)              |   |
-    8.  DrawEyeView(right)             |   |
+    7.  StartEyeViews(fov)             |   |
+    8.  DrawEyeView(left)              |   |
+    9.  DrawEyeView(right)             |   |
                                     ---+   |
-    9.  LeavingVrMode()                    |
+    10. LeavingVrMode()                    |
                                   ---------+
-    10. OneTimeShutdown()
+    11. OneTimeShutdown()
 
 */
 class VrAppInterface
@@ -153,6 +154,14 @@ public:
 	// new pop up dialogs.
 	virtual Matrix4f Frame( const VrFrame & vrFrame );
 
+	// This will be called right after Frame(), with the fov that will be passed
+	// to DrawEyeView(), before the framework sets up the eye buffers.
+	//
+	// Work for both eye views that does not need the GL context, like
+	// OvrSceneView::StartSurfaceCull(), can be started on another thread here,
+	// so it overlaps with the framework's own work for the frame.
+	virtual void StartEyeViews( const float fovDegreesX, const float fovDegreesY );
+
 	// The color buffer will have already been cleared or discarded, as
 	// appropriate for the GPU. The viewport and scissor will already be set.
 	//
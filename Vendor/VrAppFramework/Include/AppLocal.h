@@ -16,9 +16,29 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "PointTracker.h"
 #include "VrFrameBuilder.h"
 #include "Kernel/OVR_Threads.h"
+#include "MessageQueue.h"
 
 namespace OVR {
 
+// Messages sent to the VrThread through the AppLocal message queue.
+enum ovrAppMessage
+{
+	APP_MESSAGE_SYNC = MESSAGE_FIRST_USER,
+	APP_MESSAGE_SURFACE_CREATED,
+	APP_MESSAGE_SURFACE_DESTROYED,
+	APP_MESSAGE_RESUME,
+	APP_MESSAGE_PAUSE,
+	APP_MESSAGE_JOY,				// Float[0..3] = left x, left y, right x, right y
+	APP_MESSAGE_TOUCH,				// Int[0] = action, Float[0..1] = x, y
+	APP_MESSAGE_KEY,				// Int[0] = key code, Int[1] = down, Int[2] = repeat count
+	APP_MESSAGE_INTENT,				// Blob = package name, URI and JSON text as zero terminated strings
+	APP_MESSAGE_POPUP,				// Int[0..1] = width, height, Float[0] = seconds
+	APP_MESSAGE_QUIT
+};
+
+// Posts an intent message with the package name, URI and JSON text.
+void PostIntentMessage( ovrMessageQueue & queue, const char * packageName, const char * uri, const char * jsonText );
+
 //==============================================================
 // AppLocal
 //
@@ -284,6 +304,7 @@ private:
 	void				InitGlObjects();
 	void				ShutdownGlObjects();
 
+	void				GetEyeFovDegrees( float & fovDegreesX, float & fovDegreesY ) const;
 	void 				DrawEyeViews( Matrix4f const & viewMatrix );
 
 	void				DrawDialog( const Matrix4f & mvp );
@@ -298,9 +319,8 @@ private:
 	// Commands can be processed even when the window surfaces
 	// are not setup.
 	//
-	// The msg string will be freed by the framework after
-	// command processing.
-	void    			Command( const char * msg );
+	// The msg blob is only valid during command processing.
+	void    			Command( const ovrMessage & msg );
 
 	// Android Activity/Surface life cycle handling.
 	void				CreateWindowSurface();
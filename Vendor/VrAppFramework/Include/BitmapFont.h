@@ -67,6 +67,11 @@ public:
     static BitmapFont *     Create();
     static void             Free( BitmapFont * & font );
 
+	// Converts a JSON font info file to the binary font info format, which loads without
+	// any parsing. Load() accepts either format, so the converted file can replace the
+	// .fnt file in a package.
+	static bool				ConvertFontInfo( ovrFileSys & fileSys, const char * jsonUri, const char * binaryFileName );
+
 	virtual bool   			Load( ovrFileSys & fileSys, const char * uri ) = 0;
     virtual bool   	        Load( const char * languagePackageFileName, char const * fontInfoFileName ) = 0;
     // Calculates the native (unscaled) width of the text string. Line endings are ignored.
@@ -137,6 +142,10 @@ public:
 
 	virtual bool		IsInitialized() const = 0;
 
+	// Returns how many times a text layout was found in the layout cache and how many times
+	// one had to be built, since the surface was created.
+	virtual void		GetLayoutCacheCounts( int & hits, int & misses ) const = 0;
+
 protected:
     virtual     ~BitmapFontSurface() { }
 };
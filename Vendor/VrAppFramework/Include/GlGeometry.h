@@ -30,6 +30,30 @@ struct VertexAttribs
 	Array< Vector4f > jointWeights;
 };
 
+// Flags for the attributes present in a packed vertex buffer.  The attributes
+// are packed one after the other in the order of the VertexAttribs members.
+enum VertexAttribFlags
+{
+	VERTEX_ATTRIB_FLAG_POSITION			= 1 << 0,
+	VERTEX_ATTRIB_FLAG_NORMAL			= 1 << 1,
+	VERTEX_ATTRIB_FLAG_TANGENT			= 1 << 2,
+	VERTEX_ATTRIB_FLAG_BINORMAL			= 1 << 3,
+	VERTEX_ATTRIB_FLAG_COLOR			= 1 << 4,
+	VERTEX_ATTRIB_FLAG_UV0				= 1 << 5,
+	VERTEX_ATTRIB_FLAG_UV1				= 1 << 6,
+	VERTEX_ATTRIB_FLAG_JOINT_INDICES	= 1 << 7,
+	VERTEX_ATTRIB_FLAG_JOINT_WEIGHTS	= 1 << 8
+};
+
+// Returns the flags for the attributes present in the given VertexAttribs.
+int		GetVertexAttribFlags( const VertexAttribs & attribs );
+
+// Returns the size in bytes of a single packed vertex with the given attributes.
+size_t	GetPackedVertexSize( const int attribFlags );
+
+// Packs the attributes one after the other the same way GlGeometry::Create does.
+void	PackVertexAttribs( Array< uint8_t > & packed, const VertexAttribs & attribs );
+
 typedef unsigned short TriangleIndex;
 //typedef unsigned int TriangleIndex;
 
@@ -59,6 +83,12 @@ public:
 	void	Create( const VertexAttribs & attribs, const Array< TriangleIndex > & indices );
 	void	Update( const VertexAttribs & attribs );
 
+	// Create the VAO and vertex and index buffers from vertex data that is already
+	// packed as done by PackVertexAttribs. This allows uploading the vertex data
+	// straight from a memory mapped file without building a VertexAttribs.
+	void	Create( const int attribFlags, const int numVertices, const void * packedVertices,
+					const int numIndices, const TriangleIndex * indices );
+
 	// Assumes the correct program, uniforms, textures, etc, are all bound.
 	// Leaves the VAO bound for efficiency, be careful not to inadvertently
 	// modify any of the state.
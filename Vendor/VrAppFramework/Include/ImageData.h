@@ -19,6 +19,13 @@ namespace OVR {
 // Use stb_image_write.h for conventional files.
 void		Write32BitPvrTexture( const char * fileName, const unsigned char * texture, int width, int height );
 
+// Builds an uncompressed .pvr file in memory with a full mip chain down to 1x1,
+// so it can be uploaded with LoadTextureFromBuffer() without building mipmaps.
+// The returned buffer should be freed with free().
+// If srgb is true, the mip levels are resampled gamma correct.
+unsigned char * Create32BitPvrTextureWithMipmaps( const unsigned char * texture, const int width, const int height,
+					const bool srgb, int & bufferSize );
+
 // The returned buffer should be freed with free()
 // If srgb is true, the resampling will be gamma correct, otherwise it is just sumOf4 >> 2
 unsigned char * QuarterImageSize( const unsigned char * src, const int width, const int height, const bool srgb );
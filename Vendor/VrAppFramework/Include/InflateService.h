@@ -0,0 +1,123 @@
+/************************************************************************************
+
+Filename    :   InflateService.h
+Content     :   Parallel decompression of zip entries
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+#ifndef OVR_InflateService_h
+#define OVR_InflateService_h
+
+#include "Kernel/OVR_Types.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_JobSystem.h"
+#include "Kernel/OVR_Threads.h"
+
+namespace OVR
+{
+
+// Decompression buffers that are kept when freed and handed out again, so loading
+// the same kind of files over and over does not fault in fresh pages every time.
+// Sizes are rounded up to a power of two. At most maxBytes of free buffers are kept,
+// the rest go back to the system. Thread safe.
+class ovrInflateBufferPool
+{
+public:
+	explicit		ovrInflateBufferPool( const size_t maxBytes = 64 * 1024 * 1024 );
+					~ovrInflateBufferPool();
+
+	// Returns NULL if the buffer cannot be allocated.
+	void *			Alloc( const int size );
+	// Takes back a buffer from Alloc(), NULL is ignored.
+	void			Free( void * buffer );
+
+private:
+	static const int	NUM_SIZE_CLASSES = 32;
+
+	Mutex				Lock;
+	ArrayPOD< void * >	FreeBuffers[NUM_SIZE_CLASSES];
+	size_t				MaxBytes;
+	size_t				FreeBytes;
+
+	// Not copyable.
+					ovrInflateBufferPool( const ovrInflateBufferPool & );
+	ovrInflateBufferPool &	operator = ( const ovrInflateBufferPool & );
+};
+
+// A zip entry to decompress. Stored entries are copied, so both kinds of entries
+// can be handed to the service together.
+struct ovrInflateJob
+{
+					ovrInflateJob() :
+						Compressed( NULL ),
+						CompressedSize( 0 ),
+						Method( 0 ),
+						Crc( 0 ),
+						VerifyCrc( false ),
+						Buffer( NULL ),
+						Pool( NULL ),
+						Size( 0 ),
+						Valid( false )
+					{
+					}
+
+	const void *	Compressed;		// raw deflate stream, without a zlib header
+	int				CompressedSize;
+	int				Method;			// 0 for stored, Z_DEFLATED for deflated
+	uint32_t		Crc;			// checked against the decompressed data if VerifyCrc is set
+	bool			VerifyCrc;
+
+	void *			Buffer;			// the caller's buffer, or NULL to have one allocated
+	ovrInflateBufferPool *	Pool;	// allocates the buffer if set, otherwise it is allocated with malloc()
+	int				Size;			// decompressed size, the buffer must hold at least this many bytes
+	bool			Valid;			// set once the entry is decompressed and its CRC matches
+};
+
+// Decompresses independent zip entries at the same time on a pool of worker threads.
+//
+// Each entry is inflated by a single worker, since a deflate stream can only be
+// decoded front to back, and the CRC of a large entry is then computed in chunks
+// that are spread across the workers and combined. The calling thread takes jobs
+// as well while it waits, so the calls are synchronous like unzReadCurrentFile().
+
+class ovrInflateService
+{
+public:
+	// With numWorkers <= 0, a worker is started for each core except one.
+					ovrInflateService( const int numWorkers = 0 );
+
+	// Decompresses all jobs and returns once they are done. Returns true if every
+	// job is valid. Jobs fail if their buffer cannot be allocated. Buffers that were
+	// allocated for jobs that failed are freed and set back to NULL. Thread safe,
+	// callable by any thread.
+	bool			Inflate( ovrInflateJob * jobs, const int numJobs );
+	bool			Inflate( ovrInflateJob & job ) { return Inflate( &job, 1 ); }
+
+	int				GetNumWorkers() const { return Jobs.GetNumWorkers(); }
+
+private:
+	JobSystem		Jobs;
+
+	static void		InflateRange( void * data, const int begin, const int end );
+	static void		CrcRange( void * data, const int begin, const int end );
+
+	bool			InflateJob( ovrInflateJob & job );
+	uint32_t		ComputeCrc( const void * data, const int size );
+};
+
+// The service shared by package and model file loading, started on first use.
+ovrInflateService &	ovr_GetInflateService();
+
+// Sets the number of workers of the shared service, which only has an effect before
+// its first use. With numWorkers <= 0, which is the default, a worker is started for
+// each core except one.
+void				ovr_SetInflateServiceWorkers( const int numWorkers );
+
+// The buffer pool shared by model file loading.
+ovrInflateBufferPool &	ovr_GetInflateBufferPool();
+
+}	// namespace OVR
+
+#endif	// OVR_InflateService_h
@@ -385,6 +385,49 @@ struct VrDeviceStatus
 	bool				PowerLevelStateMinimum;						// true if not able to continue, must undock / shut off
 };
 
+// The System Activities app events are JSON strings. The framework classifies each
+// event once when it is added to the list, so the events can be handled by switching
+// on their type without parsing any JSON on the VR thread.
+enum ovrAppEventType
+{
+	APP_EVENT_OTHER,				// any other command, only available as JSON
+	APP_EVENT_REORIENT,				// SYSTEM_ACTIVITY_EVENT_REORIENT
+	APP_EVENT_RETURN_TO_LAUNCHER,	// SYSTEM_ACTIVITY_EVENT_RETURN_TO_LAUNCHER
+	APP_EVENT_EXIT_TO_HOME			// SYSTEM_ACTIVITY_EVENT_EXIT_TO_HOME
+};
+
+struct ovrAppEvent
+{
+	ovrAppEventType		Type;
+	char const *		Json;		// the same event in the SystemActivitiesAppEventList_t
+};
+
+// The typed events of a SystemActivitiesAppEventList_t, in the same order.
+class ovrAppEventList
+{
+public:
+						ovrAppEventList() : NumEvents( 0 ), JsonEvents( NULL ) {}
+
+	// Classifies all events that are currently in the JSON list.
+	void				Init( SystemActivitiesAppEventList_t * jsonEvents );
+	// Appends an event of a known type to both lists without parsing it.
+	bool				Append( ovrAppEventType const type, char const * json );
+	// Removes an event from both lists so the framework does not handle it again.
+	void				Remove( int const index );
+	// Drops the events that were removed from the JSON list with SystemActivities_RemoveAppEvent().
+	void				Sync();
+
+	int					GetNumEvents() const { return NumEvents; }
+	ovrAppEvent const &	GetEvent( int const index ) const { return Events[index]; }
+
+private:
+	ovrAppEvent			Events[SYSTEM_ACTIVITIES_MAX_APP_EVENTS];
+	int					NumEvents;
+	SystemActivitiesAppEventList_t *	JsonEvents;
+
+	int					FindJsonEvent( char const * json ) const;
+};
+
 // Passed to an application each frame.
 class VrFrame
 {
@@ -392,7 +435,9 @@ public:
 		VrFrame() :
 			PredictedDisplayTimeInSeconds( 0.0 ),
 			DeltaSeconds( 0.0f ),
-			FrameNumber( 0 ) {}
+			FrameNumber( 0 ),
+			AppEvents( NULL ),
+			AppEventList( NULL ) {}
 
 	// Predicted absolute time in seconds this frame will be displayed.
 	// To make accurate journal playback possible, applications should
@@ -424,6 +469,10 @@ public:
 	// from this queue as they handle them if they do not want the default event
 	// behavior to happen in the framework.
 	mutable SystemActivitiesAppEventList_t	* AppEvents;
+
+	// The same events as AppEvents, with their types. Removing an event from this list
+	// also removes it from AppEvents.
+	mutable ovrAppEventList	* AppEventList;
 };
 
 extern void InitInput();
@@ -1,7 +1,7 @@
 /************************************************************************************
 
 Filename    :   MessageQueue.h
-Content     :   Thread communication by string commands
+Content     :   Thread communication by typed messages and string commands
 Created     :   October 15, 2013
 Authors     :   John Carmack
 
@@ -11,16 +11,71 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #ifndef OVR_MessageQueue_h
 #define OVR_MessageQueue_h
 
+#include <Kernel/OVR_Types.h>
+#include <Kernel/OVR_Atomic.h>
 #include <Kernel/OVR_Threads.h>
 
 namespace OVR
 {
 
+// Opcodes below MESSAGE_FIRST_USER are reserved by the message queue.
+enum ovrMessageOpcode
+{
+	MESSAGE_NONE,
+	MESSAGE_STRING,			// Blob is a zero terminated string
+	MESSAGE_FIRST_USER
+};
+
+// A message is a fixed size record with an opcode, a small POD payload and
+// an optional blob that is copied into the queue when the message is posted.
+struct ovrMessage
+{
+					ovrMessage() :
+						Opcode( MESSAGE_NONE ),
+						Blob( NULL ),
+						BlobSize( 0 )
+					{
+						for ( int i = 0; i < 4; i++ )
+						{
+							Int[i] = 0;
+							Float[i] = 0.0f;
+						}
+					}
+
+	explicit		ovrMessage( const int opcode ) :
+						Opcode( opcode ),
+						Blob( NULL ),
+						BlobSize( 0 )
+					{
+						for ( int i = 0; i < 4; i++ )
+						{
+							Int[i] = 0;
+							Float[i] = 0.0f;
+						}
+					}
+
+	int				Opcode;
+	int				Int[4];
+	float			Float[4];
+	const void *	Blob;
+	int				BlobSize;
+};
+
 // This is a multiple-producer, single-consumer message queue.
+//
+// The messages are stored in a bounded ring of slots with a sequence number
+// per slot, so posting a message only claims a slot with a compare-and-swap
+// and never takes a lock. Blobs of up to MESSAGE_BLOB_SIZE bytes are copied
+// into a fixed pool, larger blobs, or blobs posted while the pool is empty,
+// are copied to the heap. The consumer only blocks when the queue is empty.
+
+static const int MESSAGE_BLOB_SIZE	= 256;
+static const int MESSAGE_NUM_BLOBS	= 32;
 
 class ovrMessageQueue
 {
 public:
+					// The number of messages is rounded up to a power of two.
 					ovrMessageQueue( int maxMessages );
 					~ovrMessageQueue();
 
@@ -29,10 +84,21 @@ public:
 	void			Shutdown();
 
 	// Thread safe, callable by any thread.
-	// The msg text is copied off before return, the caller can free
+	// The message blob is copied off before return, the caller can free
 	// the buffer.
 	// The app will abort() with a dump of all messages if the message
 	// buffer overflows.
+	void			Post( const ovrMessage & msg );
+	// If there are at least requiredSpace slots available in the queue, posts the message.
+	bool			PostIfSpaceAvailable( int requiredSpace, const ovrMessage & msg );
+	// Same as above but returns false if the queue is full instead of an abort.
+	bool			TryPost( const ovrMessage & msg );
+	// Same as above but waits until the message has been processed.
+	void			Send( const ovrMessage & msg );
+	// Same as above but returns false if the queue is full instead of an abort.
+	bool			TrySend( const ovrMessage & msg );
+
+	// String messages are posted as MESSAGE_STRING messages.
 	void			PostString( const char * msg );
 	// Builds a printf string and sends it as a message.
 	void			PostPrintf( const char * fmt, ... );
@@ -45,18 +111,22 @@ public:
 	bool			TryPostPrintf( const char * fmt, ... );
 
 	// Same as above but these wait until the message has been processed.
-	// NOTE: these cannot be used by multiple producers simultaneously.
 	void			SendString( const char * msg );
 	void			SendPrintf( const char * fmt, ... );
 
 	// Returns the number slots available for new messages.
-	int				SpaceAvailable() const { return maxMessages - ( tail - head ); }
+	int				SpaceAvailable() const { return maxMessages - (int)( tail.Load_Acquire() - head ); }
 
 	// The other methods are NOT thread safe, and should only be
 	// called by the thread that owns the ovrMessageQueue.
 
+	// Returns false if there are no more messages. The message blob stays valid
+	// until the next call to GetNextMessage() or ClearMessages().
+	bool			GetNextMessage( ovrMessage & msg );
+
 	// Returns NULL if there are no more messages, otherwise returns
 	// a string that the caller is now responsible for freeing.
+	// Messages that are not strings are discarded.
 	const char * 	GetNextMessage();
 
 	// Returns immediately if there is already a message in the queue.
@@ -72,30 +142,50 @@ private:
 	// If set true, print all message sends and gets to the log
 	static bool		debug;
 
-	bool			shutdown;
-	int 			maxMessages;
-
 	struct message_t
 	{
-		const char *	string;
-		bool			synced;
+		AtomicInt< UInt32 >	sequence;	// position + 1 once posted, position + maxMessages once free
+		ovrMessage			msg;
+		int					blob;		// index in the blob pool, or -1 if allocated on the heap
+		bool				synced;
 	};
 
-	// All messages will be allocated with strdup, and returned to
-	// the caller on GetNextMessage().
+	volatile bool	shutdown;
+	int 			maxMessages;
+
 	message_t * 	messages;
 
-	// PostMessage() fills in messages[tail%maxMessages], then increments tail
-	// If tail > head, GetNextMessage() will fetch messages[head%maxMessages],
-	// then increment head.
-	volatile int	head;
-	volatile int	tail;
+	// Post() claims messages[tail%maxMessages] by incrementing tail, fills it in,
+	// and then sets its sequence to tail + 1.  Once the sequence is set,
+	// GetNextMessage() will fetch messages[head%maxMessages], then increment head.
+	AtomicInt< UInt32 >	tail;
+	volatile UInt32	head;
+
+	// A bit is set for each blob that is free.
+	UByte *			blobs;
+	AtomicInt< UInt32 >	freeBlobs;
+
+	// The blob of the last message returned by GetNextMessage().
+	const void *	currentBlob;
+	int				currentBlobIndex;
+
+	// The consumer only takes the mutex to sleep or to notify that a synced message
+	// was processed, and producers only take it when the consumer is sleeping or
+	// when they wait for a synced message.
+	AtomicInt< int >	sleeping;
 	bool			synced;
+	UInt32			syncedPosition;
+	UInt32			processedPosition;
 	Mutex			mutex;
 	WaitCondition	posted;
 	WaitCondition	processed;
 
-	bool PostMessage( const char * msg, bool sync, bool abortIfFull );
+	bool			PostMessage( const ovrMessage & msg, bool sync, bool abortIfFull );
+	bool			PostMessageString( const char * msg, bool sync, bool abortIfFull );
+	int				AllocBlob();
+	void			FreeBlob( const int index );
+	void			FreeCurrentBlob();
+	bool			HasMessage() const;
 };
 
 }	// namespace OVR
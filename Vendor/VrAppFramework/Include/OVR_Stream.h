@@ -14,6 +14,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 
 #include "Kernel/OVR_String.h"
 #include "Kernel/OVR_MemBuffer.h"
+#include "Kernel/OVR_JSONStream.h"
 
 namespace OVR {
 
@@ -94,6 +95,28 @@ private:
 	ovrStream &				operator = ( ovrStream & rhs );
 };
 
+//==============================================================
+// ovrJsonStreamSource
+// Feeds an open stream to a JsonStreamReader in chunks, so a JSON file can be read
+// from a file or an apk without loading all of it.
+//
+//	ovrJsonStreamSource source( *stream );
+//	JsonStreamReader reader( &source );
+class ovrJsonStreamSource : public JsonStreamSource
+{
+public:
+	explicit				ovrJsonStreamSource( ovrStream & stream, size_t const chunkSize = JSON_STREAM_CHUNK_SIZE );
+
+	virtual int				Read( uint8_t * buffer, int numBytes ) OVR_OVERRIDE;
+
+private:
+	ovrStream &				Stream;
+	MemBufferT< uint8_t >	Chunk;
+
+	// Private assignment operator to prevent copying.
+	ovrJsonStreamSource &	operator = ( ovrJsonStreamSource & rhs );
+};
+
 } // namespace OVR
 
 #endif // OVR_FILE_H
\ No newline at end of file
@@ -13,6 +13,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #define OVRPACKAGEFILES_H
 
 #include "Kernel/OVR_MemBuffer.h"
+#include "Kernel/OVR_JSONStream.h"
 
 // The application package is the moral equivalent of the filesystem, so
 // I don't feel too bad about making it globally accessible, versus requiring
@@ -44,18 +45,59 @@ private:
 
 // Call this to open a specific package and use the returned handle in calls to functions for
 // loading from other application packages.
+// The package is mapped and its directory is indexed once when it is opened, so the functions
+// below are thread safe, and any number of threads can read from the same package at once.
 void *			ovr_OpenOtherApplicationPackage( const char * packageName );
 
 // Call this to close another application package after loading resources from it.
 void			ovr_CloseOtherApplicationPackage( void * & zipFile );
 
-// These are probably NOT thread safe!
 bool			ovr_OtherPackageFileExists( void * zipFile, const char * nameInZip );
 
+// Returns a pointer to the file in the mapped package without copying it. This only works for
+// files stored without compression, the pointer stays valid until the package is closed.
+// Returns false for compressed files, which have to be read instead.
+bool			ovr_MapFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, int & length, const void * & data );
+
+// Returns the CRC of the uncompressed file from the package directory, without reading the file.
+// This can be used to name files that are derived from a packaged file.
+bool			ovr_GetFileCrcFromOtherApplicationPackage( void * zipFile, const char * nameInZip, uint32_t & crc );
+
 // Returns NULL buffer if the file is not found.
 bool			ovr_ReadFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, int & length, void * & buffer );
 bool			ovr_ReadFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, MemBufferT< uint8_t > & buffer );
 
+// Reads several files at once, the compressed ones are decompressed in parallel by the
+// ovrInflateService. The buffers of files that are not found or fail to read are NULL.
+// Returns true if all files were read.
+bool			ovr_ReadFilesFromOtherApplicationPackage( void * zipFile, const int numFiles, const char * const * namesInZip,
+						int * lengths, void ** buffers );
+
+// Opens a file for reading in chunks with ovr_ReadFromPackageFile(). Compressed files are
+// inflated as they are read, so the whole file is never held in memory. The length is
+// the uncompressed size. Returns NULL if the file is not found.
+void *			ovr_OpenFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, int & length );
+
+// Reads up to numBytes into the buffer. Returns the number of bytes read, 0 at the end of
+// the file, or -1 if the data is corrupt, which is also returned by all further calls.
+// The CRC of the file is checked when the last byte is read.
+int				ovr_ReadFromPackageFile( void * packageFile, void * buffer, const int numBytes );
+
+// Must be called before the package is closed.
+void			ovr_ClosePackageFile( void * & packageFile );
+
+// Feeds a file opened with ovr_OpenFileFromOtherApplicationPackage() to a JsonStreamReader.
+class ovrPackageJsonSource : public JsonStreamSource
+{
+public:
+	explicit		ovrPackageJsonSource( void * packageFile ) : PackageFile( packageFile ) {}
+
+	virtual int		Read( uint8_t * buffer, int numBytes ) { return ovr_ReadFromPackageFile( PackageFile, buffer, numBytes ); }
+
+private:
+	void *			PackageFile;
+};
+
 
 //--------------------------------------------------------------
 // Functions for reading assets from this process's application package
@@ -76,15 +118,20 @@ const char *	ovr_GetApplicationPackageCachePath();
 // back in much faster.
 void			ovr_OpenApplicationPackage( const char * packageName, const char * cachePath );
 
-// These are probably NOT thread safe!
 bool			ovr_PackageFileExists( const char * nameInZip );
 
+// Returns false for compressed files, see ovr_MapFileFromOtherApplicationPackage().
+bool			ovr_MapFileFromApplicationPackage( const char * nameInZip, int & length, const void * & data );
+
 // Returns NULL buffer if the file is not found.
 bool			ovr_ReadFileFromApplicationPackage( const char * nameInZip, int & length, void * & buffer );
 
 // Returns an empty MemBufferFile if the file is not found.
 bool			ovr_ReadFileFromApplicationPackage( const char * nameInZip, MemBufferFile & memBufferFile );
 
+// See ovr_OpenFileFromOtherApplicationPackage().
+void *			ovr_OpenFileFromApplicationPackage( const char * nameInZip, int & length );
+
 
 }	// namespace OVR
 
@@ -59,7 +59,8 @@ public:
 	void				AdvanceVrFrame( const ovrInputEvents & inputEvents, ovrMobile * ovr,
 										const ovrFrameParms & frameParms,
 										const ovrHeadModelParms & headModelParms,
-										SystemActivitiesAppEventList_t * appEvents );
+										SystemActivitiesAppEventList_t * appEvents,
+										ovrAppEventList * appEventList );
 	const VrFrame &		Get() const { return vrFrame; }
 
 private:
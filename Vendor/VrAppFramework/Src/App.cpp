@@ -55,22 +55,6 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "embedded/dependency_error_ja.h"
 #include "embedded/dependency_error_ko.h"
 
-// some parameters from the intent can be empty strings, which cannot be represented as empty strings for sscanf
-// so we encode them as EMPTY_INTENT_STR.
-// Because the message queue handling uses sscanf() to parse the message, the JSON text is 
-// always placed at the end of the message because it can contain spaces while the package
-// name and URI cannot. The handler will use sscanf() to parse the first two strings, then
-// assume the JSON text is everything immediately following the space after the URI string.
-static const char * EMPTY_INTENT_STR = "<EMPTY>";
-void ComposeIntentMessage( char const * packageName, char const * uri, char const * jsonText, 
-		char * out, size_t outSize )
-{
-	OVR::OVR_sprintf( out, outSize, "intent %s %s %s",
-			packageName == NULL || packageName[0] == '\0' ? EMPTY_INTENT_STR : packageName,
-			uri == NULL || uri[0] == '\0' ? EMPTY_INTENT_STR : uri,
-			jsonText == NULL || jsonText[0] == '\0' ? "" : jsonText );
-}
-
 // Initialize and shutdown the app framework version of LibOVR.
 static struct InitShutdown
 {
@@ -159,6 +143,12 @@ Matrix4f VrAppInterface::Frame( const VrFrame & vrFrame )
 	return Matrix4f();
 }
 
+void VrAppInterface::StartEyeViews( const float fovDegreesX, const float fovDegreesY )
+{
+	OVR_UNUSED( fovDegreesX );
+	OVR_UNUSED( fovDegreesY );
+}
+
 Matrix4f VrAppInterface::DrawEyeView( const int eye, const float fovDegreesX, const float fovDegreesY, ovrFrameParms & frameParms ) 
 { 
 	LOG( "VrAppInterface::DrawEyeView - default handler called" );
@@ -363,14 +353,14 @@ void AppLocal::StartVrThread()
 	}
 
 	// Wait for the thread to be up and running.
-	MessageQueue.SendPrintf( "sync " );
+	MessageQueue.Send( ovrMessage( APP_MESSAGE_SYNC ) );
 }
 
 void AppLocal::StopVrThread()
 {
 	LOG( "StopVrThread" );
 
-	MessageQueue.PostPrintf( "quit " );
+	MessageQueue.Post( ovrMessage( APP_MESSAGE_QUIT ) );
 
 	if ( VrThread.Join() == false )
 	{
@@ -963,163 +953,150 @@ Matrix4f PanelMatrix( const Matrix4f & lastViewMatrix, const float popupDistance
 	return panelMatrix;
 }
 
+// The package name, URI and JSON text are placed in the message blob as consecutive
+// zero terminated strings, so none of them have to be parsed out of the message text.
+void PostIntentMessage( ovrMessageQueue & queue, const char * packageName, const char * uri, const char * jsonText )
+{
+	char blob[4096];
+	int length = 0;
+	const char * strings[3] = { packageName, uri, jsonText };
+	for ( int i = 0; i < 3; i++ )
+	{
+		const char * string = ( strings[i] != NULL ) ? strings[i] : "";
+		const int stringLength = Alg::Min( (int)OVR_strlen( string ), (int)sizeof( blob ) - length - ( 3 - i ) );
+		memcpy( blob + length, string, stringLength );
+		length += stringLength;
+		blob[length++] = '\0';
+	}
+
+	ovrMessage msg( APP_MESSAGE_INTENT );
+	msg.Blob = blob;
+	msg.BlobSize = length;
+	queue.Post( msg );
+}
+
 /*
  * Command
  *
  * Process commands sent over the message queue for the VR thread.
  *
  */
-void AppLocal::Command( const char *msg )
+void AppLocal::Command( const ovrMessage & msg )
 {
-	// Always include the space in MatchesHead to prevent problems
-	// with commands that have matching prefixes.
-
-	if ( MatchesHead( "sync ", msg ) )
-	{
-		LOG( "%p msg: VrThreadSynced", this );
-		VrThreadSynced = true;
-		return;
-	}
-
-	if ( MatchesHead( "surfaceCreated ", msg ) )
+	switch ( msg.Opcode )
 	{
-		LOG( "%p msg: surfaceCreated", this );
-		nativeWindow = pendingNativeWindow;
-		HandleVrModeChanges();
-		return;
-	}
-
-	if ( MatchesHead( "surfaceDestroyed ", msg ) )
-	{
-		LOG( "%p msg: surfaceDestroyed", this );
-		nativeWindow = NULL;
-		HandleVrModeChanges();
-		return;
-	}
-
-	if ( MatchesHead( "resume ", msg ) )
-	{
-		LOG( "%p msg: resume", this );
-		Resumed = true;
-		HandleVrModeChanges();
-		return;
-	}
-
-	if ( MatchesHead( "pause ", msg ) )
-	{
-		LOG( "%p msg: pause", this );
-		Resumed = false;
-		HandleVrModeChanges();
-		return;
-	}
-
-	if ( MatchesHead( "joy ", msg ) )
-	{
-		sscanf( msg, "joy %f %f %f %f",
-				&InputEvents.JoySticks[0][0],
-				&InputEvents.JoySticks[0][1],
-				&InputEvents.JoySticks[1][0],
-				&InputEvents.JoySticks[1][1] );
-		return;
-	}
-
-	if ( MatchesHead( "touch ", msg ) )
-	{
-		sscanf( msg, "touch %i %f %f",
-				&InputEvents.TouchAction,
-				&InputEvents.TouchPosition[0],
-				&InputEvents.TouchPosition[1] );
-		return;
-	}
-
-	if ( MatchesHead( "key ", msg ) )
-	{
-		int keyCode, down, repeatCount;
-		sscanf( msg, "key %i %i %i", &keyCode, &down, &repeatCount );
-		if ( InputEvents.NumKeyEvents < MAX_INPUT_KEY_EVENTS )
+		case APP_MESSAGE_SYNC:
 		{
-			InputEvents.KeyEvents[InputEvents.NumKeyEvents].KeyCode = static_cast< ovrKeyCode >( keyCode & ~BUTTON_JOYPAD_FLAG );
-			InputEvents.KeyEvents[InputEvents.NumKeyEvents].RepeatCount = repeatCount;
-			InputEvents.KeyEvents[InputEvents.NumKeyEvents].Down = ( down != 0 );
-			InputEvents.KeyEvents[InputEvents.NumKeyEvents].IsJoypadButton = ( keyCode & BUTTON_JOYPAD_FLAG ) != 0;
-			InputEvents.NumKeyEvents++;
+			LOG( "%p msg: VrThreadSynced", this );
+			VrThreadSynced = true;
+			return;
 		}
-		return;	
-	}
-
-	if ( MatchesHead( "intent ", msg ) )
-	{
-		LOG( "%p msg: intent", this );
-
-		// define the buffer sizes with macros so we can ensure that the sscanf sizes are also updated
-		// if the actual buffer sizes are changed.
-#define FROM_SIZE 511
-#define URI_SIZE 1023
-
-		char fromPackageName[FROM_SIZE + 1];
-		char uri[URI_SIZE + 1];
-		// since the package name and URI cannot contain spaces, but JSON can,
-		// the JSON string is at the end and will come after the third space.
-		sscanf( msg, "intent %" STRINGIZE_VALUE( FROM_SIZE ) "s %" STRINGIZE_VALUE( URI_SIZE ) "s", fromPackageName, uri );
-		char const * jsonStart = NULL;
-		size_t msgLen = OVR_strlen( msg );
-		int spaceCount = 0;
-		for ( size_t i = 0; i < msgLen; ++i ) {
-			if ( msg[i] == ' ' ) {
-				spaceCount++;
-				if ( spaceCount == 3 ) {
-					jsonStart = &msg[i+1];
-					break;
-				}
-			}
+		case APP_MESSAGE_SURFACE_CREATED:
+		{
+			LOG( "%p msg: surfaceCreated", this );
+			nativeWindow = pendingNativeWindow;
+			HandleVrModeChanges();
+			return;
 		}
-
-		if ( OVR_strcmp( fromPackageName, EMPTY_INTENT_STR ) == 0 )
+		case APP_MESSAGE_SURFACE_DESTROYED:
 		{
-			fromPackageName[0] = '\0';
+			LOG( "%p msg: surfaceDestroyed", this );
+			nativeWindow = NULL;
+			HandleVrModeChanges();
+			return;
 		}
-		if ( OVR_strcmp( uri, EMPTY_INTENT_STR ) == 0 )
+		case APP_MESSAGE_RESUME:
 		{
-			uri[0] = '\0';
+			LOG( "%p msg: resume", this );
+			Resumed = true;
+			HandleVrModeChanges();
+			return;
 		}
-
-		// assign launchIntent to the intent command
-		IntentFromPackage = fromPackageName;
-		IntentJSON = jsonStart;
-		IntentURI = uri;
-		IntentIsNew = true;
-
-		return;
-	}
-
-	if ( MatchesHead( "popup ", msg ) )
-	{
+		case APP_MESSAGE_PAUSE:
+		{
+			LOG( "%p msg: pause", this );
+			Resumed = false;
+			HandleVrModeChanges();
+			return;
+		}
+		case APP_MESSAGE_JOY:
+		{
+			InputEvents.JoySticks[0][0] = msg.Float[0];
+			InputEvents.JoySticks[0][1] = msg.Float[1];
+			InputEvents.JoySticks[1][0] = msg.Float[2];
+			InputEvents.JoySticks[1][1] = msg.Float[3];
+			return;
+		}
+		case APP_MESSAGE_TOUCH:
+		{
+			InputEvents.TouchAction = msg.Int[0];
+			InputEvents.TouchPosition[0] = msg.Float[0];
+			InputEvents.TouchPosition[1] = msg.Float[1];
+			return;
+		}
+		case APP_MESSAGE_KEY:
+		{
+			const int keyCode = msg.Int[0];
+			const int down = msg.Int[1];
+			const int repeatCount = msg.Int[2];
+			if ( InputEvents.NumKeyEvents < MAX_INPUT_KEY_EVENTS )
+			{
+				InputEvents.KeyEvents[InputEvents.NumKeyEvents].KeyCode = static_cast< ovrKeyCode >( keyCode & ~BUTTON_JOYPAD_FLAG );
+				InputEvents.KeyEvents[InputEvents.NumKeyEvents].RepeatCount = repeatCount;
+				InputEvents.KeyEvents[InputEvents.NumKeyEvents].Down = ( down != 0 );
+				InputEvents.KeyEvents[InputEvents.NumKeyEvents].IsJoypadButton = ( keyCode & BUTTON_JOYPAD_FLAG ) != 0;
+				InputEvents.NumKeyEvents++;
+			}
+			return;
+		}
+		case APP_MESSAGE_INTENT:
+		{
+			LOG( "%p msg: intent", this );
+
+			const char * fromPackageName = (const char *)msg.Blob;
+			const char * uri = fromPackageName + OVR_strlen( fromPackageName ) + 1;
+			const char * jsonText = uri + OVR_strlen( uri ) + 1;
+
+			// assign launchIntent to the intent command
+			IntentFromPackage = fromPackageName;
+			IntentJSON = jsonText;
+			IntentURI = uri;
+			IntentIsNew = true;
+			return;
+		}
+		case APP_MESSAGE_POPUP:
+		{
 #if defined( OVR_OS_ANDROID )
-		int width, height;
-		float seconds;
-		sscanf( msg, "popup %i %i %f", &width, &height, &seconds );
+			const int width = msg.Int[0];
+			const int height = msg.Int[1];
+			const float seconds = msg.Float[0];
 
-		dialogWidth = width;
-		dialogHeight = height;
-		dialogStopSeconds = vrapi_GetTimeInSeconds() + seconds;
+			dialogWidth = width;
+			dialogHeight = height;
+			dialogStopSeconds = vrapi_GetTimeInSeconds() + seconds;
 
-		dialogMatrix = PanelMatrix( lastViewMatrix, popupDistance, popupScale, width, height );
+			dialogMatrix = PanelMatrix( lastViewMatrix, popupDistance, popupScale, width, height );
 
-		glActiveTexture( GL_TEXTURE0 );
-		LOG( "RC_UPDATE_POPUP dialogTexture %i", dialogTexture->GetTextureId() );
-		dialogTexture->Update();
-		glBindTexture( GL_TEXTURE_EXTERNAL_OES, 0 );
+			glActiveTexture( GL_TEXTURE0 );
+			LOG( "RC_UPDATE_POPUP dialogTexture %i", dialogTexture->GetTextureId() );
+			dialogTexture->Update();
+			glBindTexture( GL_TEXTURE_EXTERNAL_OES, 0 );
 #endif
-		return;
-	}
-
-	if ( MatchesHead( "quit ", msg ) )
-	{
-		// "quit" is called fron onDestroy and onPause should have been called already
-		OVR_ASSERT( OvrMobile == NULL );
-		ReadyToExit = true;
-		LOG( "VrThreadSynced=%d CreatedSurface=%d ReadyToExit=%d", VrThreadSynced, CreatedSurface, ReadyToExit );
-		return;
+			return;
+		}
+		case APP_MESSAGE_QUIT:
+		{
+			// "quit" is called fron onDestroy and onPause should have been called already
+			OVR_ASSERT( OvrMobile == NULL );
+			ReadyToExit = true;
+			LOG( "VrThreadSynced=%d CreatedSurface=%d ReadyToExit=%d", VrThreadSynced, CreatedSurface, ReadyToExit );
+			return;
+		}
+		default:
+		{
+			WARN( "%p msg: unknown opcode %i", this, msg.Opcode );
+			return;
+		}
 	}
 }
 
@@ -1372,21 +1349,17 @@ void AppLocal::VrThreadFunction()
 		//SPAM( "FRAME START" );
 
 		// Process incoming messages until the queue is empty.
-		for ( ; ; )
+		for ( ovrMessage msg; MessageQueue.GetNextMessage( msg ); )
 		{
-			const char * msg = MessageQueue.GetNextMessage();
-			if ( msg == NULL )
-			{
-				break;
-			}
 			Command( msg );
-			free( (void *)msg );
 		}
 
 		// process any SA events - events that aren't always handled internally ( returnToLauncher )
 		// will be added to the event list
 		SystemActivitiesAppEventList_t appEvents;
 		SystemActivities_Update( OvrMobile, &Java, &appEvents );
+		ovrAppEventList appEventList;
+		appEventList.Init( &appEvents );
 
 		// Wait for messages until we are in VR mode.
 		if ( OvrMobile == NULL )
@@ -1434,11 +1407,11 @@ void AppLocal::VrThreadFunction()
 			// add a reorient message so we pass it down as an event that VrGUI (or the app) can get it and call ResetMenuOrientations()
 			char reorientMessage[1024];
 			SystemActivities_CreateSystemActivitiesCommand( "", SYSTEM_ACTIVITY_EVENT_REORIENT, "", "", reorientMessage, sizeof( reorientMessage ) );
-			SystemActivities_AppendAppEvent( &appEvents, reorientMessage );
+			appEventList.Append( APP_EVENT_REORIENT, reorientMessage );
 		}
 
 		// Update VrFrame.
-		TheVrFrame.AdvanceVrFrame( InputEvents, OvrMobile, FrameParms, VrSettings.HeadModelParms, &appEvents );
+		TheVrFrame.AdvanceVrFrame( InputEvents, OvrMobile, FrameParms, VrSettings.HeadModelParms, &appEvents, &appEventList );
 		InputEvents.NumKeyEvents = 0;
 
 		// Resend any debug lines that have expired.
@@ -1510,6 +1483,12 @@ void AppLocal::VrThreadFunction()
 		// Main loop logic and draw/update code common to both eyes.
 		this->lastViewMatrix = appInterface->Frame( TheVrFrame.Get() );
 
+		// Let the app start work for the eye views that overlaps with the rest of the frame.
+		float fovDegreesX;
+		float fovDegreesY;
+		GetEyeFovDegrees( fovDegreesX, fovDegreesY );
+		appInterface->StartEyeViews( fovDegreesX, fovDegreesY );
+
 		// Handle any events that weren't eaten by the app
 		SystemActivities_PostUpdate( OvrMobile, &Java, &appEvents );
 
@@ -76,18 +76,25 @@ void AppLocal::DrawPanel( const GLuint externalTextureId, const Matrix4f & dialo
 #endif
 }
 
-void AppLocal::DrawEyeViews( Matrix4f const & centerViewMatrix )
+void AppLocal::GetEyeFovDegrees( float & fovDegreesX, float & fovDegreesY ) const
 {
-	GetDebugFontSurface().Finish( centerViewMatrix );
-
 	// Increase the fov by about 10 degrees if we are not holding 60 fps so
 	// there is less black pull-in at the edges.
 	//
 	// Doing this dynamically based just on time causes visible flickering at the
 	// periphery when the fov is increased, so only do it if minimumVsyncs is set.
 	const float fovIncrease = ( ( FrameParms.MinimumVsyncs > 1 ) || TheVrFrame.Get().DeviceStatus.PowerLevelStateThrottled ) ? 10.0f : 0.0f;
-	const float fovDegreesX = SuggestedEyeFovDegreesX + fovIncrease;
-	const float fovDegreesY = SuggestedEyeFovDegreesY + fovIncrease;
+	fovDegreesX = SuggestedEyeFovDegreesX + fovIncrease;
+	fovDegreesY = SuggestedEyeFovDegreesY + fovIncrease;
+}
+
+void AppLocal::DrawEyeViews( Matrix4f const & centerViewMatrix )
+{
+	GetDebugFontSurface().Finish( centerViewMatrix );
+
+	float fovDegreesX;
+	float fovDegreesY;
+	GetEyeFovDegrees( fovDegreesX, fovDegreesY );
 
 	// DisplayMonoMode uses a single eye rendering for speed improvement
 	// and / or high refresh rate double-scan hardware modes.
@@ -29,9 +29,6 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 // queue is not be serviced by VrThreadFunction.
 static const int	MIN_SLOTS_AVAILABLE_FOR_INPUT = 12;
 
-void ComposeIntentMessage( char const * packageName, char const * uri, char const * jsonText, 
-		char * out, size_t outSize );
-
 extern "C"
 {
 
@@ -60,7 +57,7 @@ void Java_com_oculus_vrappframework_VrApp_nativeOnPause( JNIEnv *jni, jclass cla
 {
 	LOG( "%p nativePause", (void *)appPtr );
 	OVR::AppLocal * appLocal = (OVR::AppLocal *)appPtr;
-	appLocal->GetMessageQueue().SendPrintf( "pause " );
+	appLocal->GetMessageQueue().Send( OVR::ovrMessage( OVR::APP_MESSAGE_PAUSE ) );
 }
 
 void Java_com_oculus_vrappframework_VrApp_nativeOnResume( JNIEnv *jni, jclass clazz,
@@ -68,7 +65,7 @@ void Java_com_oculus_vrappframework_VrApp_nativeOnResume( JNIEnv *jni, jclass cl
 {
 	LOG( "%p nativeResume", (void *)appPtr );
 	OVR::AppLocal * appLocal = (OVR::AppLocal *)appPtr;
-	appLocal->GetMessageQueue().SendPrintf( "resume " );
+	appLocal->GetMessageQueue().Send( OVR::ovrMessage( OVR::APP_MESSAGE_RESUME ) );
 }
 
 void Java_com_oculus_vrappframework_VrApp_nativeOnDestroy( JNIEnv *jni, jclass clazz,
@@ -115,7 +112,7 @@ void Java_com_oculus_vrappframework_VrApp_nativeSurfaceCreated( JNIEnv *jni, jcl
 
 	LOG( "    pendingNativeWindow = ANativeWindow_fromSurface( jni, surface )" );
 	appLocal->pendingNativeWindow = newNativeWindow;
-	appLocal->GetMessageQueue().SendPrintf( "surfaceCreated " );
+	appLocal->GetMessageQueue().Send( OVR::ovrMessage( OVR::APP_MESSAGE_SURFACE_CREATED ) );
 }
 
 void Java_com_oculus_vrappframework_VrApp_nativeSurfaceChanged( JNIEnv *jni, jclass clazz,
@@ -139,7 +136,7 @@ void Java_com_oculus_vrappframework_VrApp_nativeSurfaceChanged( JNIEnv *jni, jcl
 	{
 		if ( appLocal->pendingNativeWindow != NULL )
 		{
-			appLocal->GetMessageQueue().SendPrintf( "surfaceDestroyed " );
+			appLocal->GetMessageQueue().Send( OVR::ovrMessage( OVR::APP_MESSAGE_SURFACE_DESTROYED ) );
 			LOG( "    ANativeWindow_release( pendingNativeWindow )" );
 			ANativeWindow_release( appLocal->pendingNativeWindow );
 			appLocal->pendingNativeWindow = NULL;
@@ -148,7 +145,7 @@ void Java_com_oculus_vrappframework_VrApp_nativeSurfaceChanged( JNIEnv *jni, jcl
 		{
 			LOG( "    pendingNativeWindow = ANativeWindow_fromSurface( jni, surface )" );
 			appLocal->pendingNativeWindow = newNativeWindow;
-			appLocal->GetMessageQueue().SendPrintf( "surfaceCreated " );
+			appLocal->GetMessageQueue().Send( OVR::ovrMessage( OVR::APP_MESSAGE_SURFACE_CREATED ) );
 		}
 	}
 	else if ( newNativeWindow != NULL )
@@ -164,7 +161,7 @@ void Java_com_oculus_vrappframework_VrApp_nativeSurfaceDestroyed( JNIEnv *jni, j
 
 	OVR::AppLocal * appLocal = (OVR::AppLocal *)appPtr;
 
-	appLocal->GetMessageQueue().SendPrintf( "surfaceDestroyed " );
+	appLocal->GetMessageQueue().Send( OVR::ovrMessage( OVR::APP_MESSAGE_SURFACE_DESTROYED ) );
 	LOG( "    ANativeWindow_release( pendingNativeWindow )" );
 	ANativeWindow_release( appLocal->pendingNativeWindow );
 	appLocal->pendingNativeWindow = NULL;
@@ -175,7 +172,11 @@ void Java_com_oculus_vrappframework_VrActivity_nativePopup( JNIEnv *jni, jclass
 {
 	LOG( "%p nativePopup", (void *)appPtr );
 	OVR::AppLocal * appLocal = (OVR::AppLocal *)appPtr;
-	appLocal->GetMessageQueue().PostPrintf( "popup %i %i %f", width, height, seconds );
+	OVR::ovrMessage msg( OVR::APP_MESSAGE_POPUP );
+	msg.Int[0] = width;
+	msg.Int[1] = height;
+	msg.Float[0] = seconds;
+	appLocal->GetMessageQueue().Post( msg );
 }
 
 jobject Java_com_oculus_vrappframework_VrActivity_nativeGetPopupSurfaceTexture( JNIEnv *jni, jclass clazz,
@@ -193,7 +194,12 @@ void Java_com_oculus_vrappframework_VrActivity_nativeJoypadAxis( JNIEnv *jni, jc
 	// Suspend input until OneTimeInit() has finished to avoid overflowing the message queue on long loads.
 	if ( appLocal->OneTimeInitCalled )
 	{
-		appLocal->GetMessageQueue().PostPrintfIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, "joy %f %f %f %f", lx, ly, rx, ry );
+		OVR::ovrMessage msg( OVR::APP_MESSAGE_JOY );
+		msg.Float[0] = lx;
+		msg.Float[1] = ly;
+		msg.Float[2] = rx;
+		msg.Float[3] = ry;
+		appLocal->GetMessageQueue().PostIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, msg );
 	}
 }
 
@@ -204,7 +210,11 @@ void Java_com_oculus_vrappframework_VrActivity_nativeTouch( JNIEnv *jni, jclass
 	// Suspend input until OneTimeInit() has finished to avoid overflowing the message queue on long loads.
 	if ( appLocal->OneTimeInitCalled )
 	{
-		appLocal->GetMessageQueue().PostPrintfIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, "touch %i %f %f", action, x, y );
+		OVR::ovrMessage msg( OVR::APP_MESSAGE_TOUCH );
+		msg.Int[0] = action;
+		msg.Float[0] = x;
+		msg.Float[1] = y;
+		appLocal->GetMessageQueue().PostIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, msg );
 	}
 }
 
@@ -216,7 +226,11 @@ void Java_com_oculus_vrappframework_VrActivity_nativeKeyEvent( JNIEnv *jni, jcla
 	if ( appLocal->OneTimeInitCalled )
 	{
 		OVR::ovrKeyCode keyCode = OVR::OSKeyToKeyCode( key );
-		appLocal->GetMessageQueue().PostPrintfIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, "key %i %i %i", keyCode, down, repeatCount );
+		OVR::ovrMessage msg( OVR::APP_MESSAGE_KEY );
+		msg.Int[0] = keyCode;
+		msg.Int[1] = down;
+		msg.Int[2] = repeatCount;
+		appLocal->GetMessageQueue().PostIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, msg );
 	}
 }
 
@@ -228,12 +242,9 @@ void Java_com_oculus_vrappframework_VrActivity_nativeNewIntent( JNIEnv *jni, jcl
 	JavaUTFChars utfUri( jni, uriString );
 	JavaUTFChars utfJson( jni, command );
 
-	char intentMessage[4096];
-	ComposeIntentMessage( utfPackageName.ToStr(), utfUri.ToStr(), utfJson.ToStr(), 
-			intentMessage, sizeof( intentMessage ) );
-	LOG( "nativeNewIntent: %s", intentMessage );
+	LOG( "nativeNewIntent: %s %s %s", utfPackageName.ToStr(), utfUri.ToStr(), utfJson.ToStr() );
 	OVR::AppLocal * appLocal = (OVR::AppLocal *)appPtr;
-	appLocal->GetMessageQueue().PostString( intentMessage );
+	OVR::PostIntentMessage( appLocal->GetMessageQueue(), utfPackageName.ToStr(), utfUri.ToStr(), utfJson.ToStr() );
 }
 
 }	// extern "C"
@@ -279,9 +290,7 @@ jlong VrAppInterface::SetActivity( JNIEnv * jni, jclass clazz, jobject activity,
 	}
 
 	// Send the launch intent.
-	char intentMessage[4096];
-	ComposeIntentMessage( utfFromPackageString.ToStr(), utfUriString.ToStr(), utfJsonString.ToStr(), intentMessage, sizeof( intentMessage ) );
-	appLocal->GetMessageQueue().PostString( intentMessage );
+	PostIntentMessage( appLocal->GetMessageQueue(), utfFromPackageString.ToStr(), utfUriString.ToStr(), utfJsonString.ToStr() );
 
 	return (jlong)app;
 }
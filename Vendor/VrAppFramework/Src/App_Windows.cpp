@@ -57,8 +57,8 @@ long long VrAppInterface::SetActivity( JNIEnv * jni, jclass clazz, jobject activ
 		appLocal->StartVrThread();
 
 		// TODO: Better way to map lifecycle
-		appLocal->GetMessageQueue().SendPrintf( "resume " );
-		appLocal->GetMessageQueue().SendPrintf( "surfaceCreated " );
+		appLocal->GetMessageQueue().Send( ovrMessage( APP_MESSAGE_RESUME ) );
+		appLocal->GetMessageQueue().Send( ovrMessage( APP_MESSAGE_SURFACE_CREATED ) );
 
 		appLocal->JoinVrThread();
 
@@ -15,18 +15,23 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 //
 
 #include "BitmapFont.h"
+#include "BitmapFontVertices.h"
 
 #if defined( OVR_OS_WIN32 )
 #include <intrin.h>
 #endif
 
+#if defined( OVR_CPU_SSE )
+#include <xmmintrin.h>
+#endif
+
 #include <errno.h>
 #include <math.h>
 #include <sys/stat.h>
 
 #include "Kernel/OVR_UTF8Util.h"
 #include "Kernel/OVR_String.h"
-#include "Kernel/OVR_JSON.h"
+#include "Kernel/OVR_JSONStream.h"
 #include "Kernel/OVR_GlUtils.h"
 #include "Kernel/OVR_LogUtils.h"
 
@@ -107,11 +112,113 @@ public:
 	float		BearingY;
 };
 
+//==============================================================
+// CharCodePageTable
+// Maps character codes to glyph indices with a two-level table. The directory has an entry
+// for each page of 256 character codes in the Unicode range, and only the pages that have
+// glyphs are allocated, so a sparse CJK font doesn't need a table sized to its largest code.
+class CharCodePageTable
+{
+public:
+	static const int		PAGE_BITS = 8;
+	static const int		PAGE_SIZE = 1 << PAGE_BITS;
+	static const uint32_t	MAX_CHAR_CODE = 0x10ffff;
+	static const int		NUM_DIRECTORY_ENTRIES = ( MAX_CHAR_CODE + 1 ) >> PAGE_BITS;
+	static const UInt16		INVALID_INDEX = 0xffff;
+
+							CharCodePageTable() { Clear(); }
+
+	void					Clear();
+
+	// Returns false if the character code or glyph index can't be stored in the table.
+	bool					Set( uint32_t const charCode, int const glyphIndex );
+
+	// Returns -1 if there is no glyph for the character code.
+	int						Get( uint32_t const charCode ) const
+							{
+								if ( charCode > MAX_CHAR_CODE )
+								{
+									return -1;
+								}
+								UInt16 const page = Directory[charCode >> PAGE_BITS];
+								if ( page == INVALID_INDEX )
+								{
+									return -1;
+								}
+								UInt16 const glyphIndex = Pages[( page << PAGE_BITS ) | ( charCode & ( PAGE_SIZE - 1 ) )];
+								return ( glyphIndex == INVALID_INDEX ) ? -1 : glyphIndex;
+							}
+
+	int						GetNumPages() const { return Pages.GetSizeI() >> PAGE_BITS; }
+
+	ArrayPOD< UInt16 >		Directory;	// page index for each range of PAGE_SIZE character codes
+	ArrayPOD< UInt16 >		Pages;		// glyph index for each character code in each page
+};
+
+//==============================
+// CharCodePageTable::Clear
+void CharCodePageTable::Clear()
+{
+	Directory.Resize( NUM_DIRECTORY_ENTRIES );
+	memset( Directory.GetDataPtr(), 0xff, Directory.GetSize() * sizeof( UInt16 ) );
+	Pages.Clear();
+}
+
+//==============================
+// CharCodePageTable::Set
+bool CharCodePageTable::Set( uint32_t const charCode, int const glyphIndex )
+{
+	if ( charCode > MAX_CHAR_CODE || glyphIndex < 0 || glyphIndex >= INVALID_INDEX )
+	{
+		return false;
+	}
+	UInt16 & page = Directory[charCode >> PAGE_BITS];
+	if ( page == INVALID_INDEX )
+	{
+		page = (UInt16)GetNumPages();
+		Pages.Resize( Pages.GetSize() + PAGE_SIZE );
+		memset( &Pages[page << PAGE_BITS], 0xff, PAGE_SIZE * sizeof( UInt16 ) );
+	}
+	Pages[( page << PAGE_BITS ) | ( charCode & ( PAGE_SIZE - 1 ) )] = (UInt16)glyphIndex;
+	return true;
+}
+
+//==============================================================
+// fontInfoBinaryHeader_t
+// The binary font info file starts with this header, followed by the font name, command line
+// and image file name as zero terminated strings, the glyphs, and the character code page table.
+// The glyph metrics are stored already scaled, so loading is just a copy of each table.
+struct fontInfoBinaryHeader_t
+{
+	UInt32		Magic;
+	UInt32		Version;
+	UInt32		HeaderSize;
+	UInt32		GlyphSize;
+	UInt32		NumGlyphs;
+	UInt32		NumPages;
+	UInt32		StringsOffset;
+	UInt32		GlyphsOffset;
+	UInt32		DirectoryOffset;
+	UInt32		PagesOffset;
+	float		NaturalWidth;
+	float		NaturalHeight;
+	float		HorizontalPad;
+	float		VerticalPad;
+	float		FontHeight;
+	float		ScaleFactorX;
+	float		ScaleFactorY;
+	float		TweakScale;
+	float		CenterOffset;
+	float		MaxAscent;
+	float		MaxDescent;
+};
 
 class FontInfoType
 {
 public:
 	static const int FNT_FILE_VERSION;
+	static const UInt32 FNT_BINARY_MAGIC;
+	static const UInt32 FNT_BINARY_VERSION;
 
 	// This is used to scale the UVs to world units that work with the current scale values used throughout
 	// the native code. Unfortunately the original code didn't account for the image size before factoring
@@ -136,6 +243,7 @@ public:
 	bool						Load( ovrFileSys & fileSys, char const * uri );
 	bool						Load( OvrApkFile const & languagePackageFile, char const * fileName );
 	FontGlyphType const &		GlyphForCharCode( uint32_t const charCode ) const;
+	bool						SaveBinary( char const * fileName ) const;
 
 	String						FontName;		// name of the font (not necessarily the file name)
 	String						CommandLine;	// command line used to generate this font
@@ -152,17 +260,21 @@ public:
 	float						MaxAscent;		// maximum ascent of any character
 	float						MaxDescent;		// maximum descent of any character
 	OVR::Array< FontGlyphType >	Glyphs;			// info about each glyph in the font
-	OVR::Array< int32_t >		CharCodeMap;	// index by character code to get the index of a glyph for the character
+	CharCodePageTable			CharCodeMap;	// index by character code to get the index of a glyph for the character
 
 private:
 	bool						LoadFromPackage( void* packageFile, char const * fileName );
-	bool						LoadFromBuffer( void const * buffer, size_t const bufferSize );
+	bool						LoadFromStream( JsonStreamReader & reader );
+	bool						LoadFromBinaryBuffer( void const * buffer, size_t const bufferSize );
+	static bool					IsBinary( void const * buffer, size_t const bufferSize );
 };
 
 const int FontInfoType::FNT_FILE_VERSION = 1;	// initial version storing pixel locations and scaling post/load to fix some precision loss
 // for now, we're not going to increment this so that we're less likely to have dependency issues with loading the font from Home
 // const int FontInfoType::FNT_FILE_VERSION = 2;		// added TweakScale for manual adjustment of other-language fonts
 const float FontInfoType::DEFAULT_SCALE_FACTOR = 512.0f;
+const UInt32 FontInfoType::FNT_BINARY_MAGIC = 0x42544e46;	// 'FNTB'
+const UInt32 FontInfoType::FNT_BINARY_VERSION = 1;
 
 class BitmapFontLocal : public BitmapFont
 {
@@ -243,22 +355,6 @@ private:
 // than BitmapFontLocal.
 static BitmapFontLocal const &  AsLocal( BitmapFont const & font ) { return *static_cast< BitmapFontLocal const* >( &font ); }
 
-struct fontVertex_t {
-	fontVertex_t() :
-		xyz( 0.0f ),
-		s( 0.0f ),
-		t( 0.0f ),
-		rgba(),
-		fontParms() {
-	}
-
-	Vector3f	xyz;
-	float		s;
-	float		t;
-	UByte		rgba[4];
-	UByte		fontParms[4];
-};
-
 typedef unsigned short fontIndex_t;
 
 //==============================
@@ -299,94 +395,58 @@ int32_t ColorToABGR( Vector4f const & color )
 
 
 
-// The vertices in a vertex block are in local space and pre-scaled.  They are transformed into
-// world space and stuffed into the VBO before rendering (once the current MVP is known).
-// The vertices can be pivoted around the Pivot point to face the camera, then an additional
-// rotation applied.
-class VertexBlockType
+// A text layout holds the glyph quads of a string in the plane of the text, pre-scaled and
+// justified around the origin, with x along the baseline and y up.  Layouts only depend on
+// the font, the text, the scale and the justification and SDF parms, so the same layout is
+// reused by every draw of the same string, regardless of its position, orientation or color.
+class TextLayoutType
 {
 public:
-	VertexBlockType() :
+	TextLayoutType() :
 		Font( NULL ),
-		Verts( NULL ),
-		NumVerts( 0 ),
-		Pivot( 0.0f ),
-		Rotation(),
-		Billboard( true ),
-		TrackRoll( false )
-	{
-	}
+		Scale( 0.0f ),
+		Hash( 0 ),
+		LastFrame( 0 ),
+		Next( -1 )
+	{
+		FontParms[0] = FontParms[1] = FontParms[2] = FontParms[3] = 0;
+	}
+
+	BitmapFont const *				Font;			// the font used to lay out the text
+	fontParms_t						Parms;			// only the justification and SDF centers are used
+	float							Scale;
+	String							Text;
+	UInt32							Hash;
+	ArrayPOD< textLayoutVertex_t >	Verts;			// 4 vertices per character
+	UByte							FontParms[4];	// SDF parms for all vertices
+	int								LastFrame;		// last frame the layout was drawn
+	int								Next;			// index of the next layout in the same hash bucket
+};
 
-	VertexBlockType( VertexBlockType const & other ) :
-		Font( NULL ),
-		Verts( NULL ),
-		NumVerts( 0 ),
+// A vertex block references the layout of a string that is drawn this frame. The layout is
+// transformed into world space and stuffed into the VBO before rendering (once the current
+// MVP is known). The layout can be pivoted around the Pivot point to face the camera.
+class VertexBlockType
+{
+public:
+	VertexBlockType() :
+		Layout( NULL ),
 		Pivot( 0.0f ),
-		Rotation(),
+		Right( 1.0f, 0.0f, 0.0f ),
+		Up( 0.0f, 1.0f, 0.0f ),
+		Color( 0 ),
 		Billboard( true ),
 		TrackRoll( false )
 	{
-		Copy( other );
 	}
 
-	VertexBlockType & operator=( VertexBlockType const & other )
-	{
-		Copy( other );
-		return *this;
-	}
-
-	void Copy( VertexBlockType const & other )
-	{
-		if ( &other == this )
-		{
-			return;
-		}
-		delete [] Verts;
-		Font		= other.Font;
-		Verts		= other.Verts;
-		NumVerts	= other.NumVerts;
-		Pivot		= other.Pivot;
-		Rotation	= other.Rotation;
-		Billboard	= other.Billboard;
-		TrackRoll	= other.TrackRoll;
-
-		other.Font = NULL;
-		other.Verts = NULL;
-		other.NumVerts = 0;
-	}
-
-	VertexBlockType( BitmapFont const & font, int const numVerts, Vector3f const & pivot,
-			Quatf const & rot, bool const billboard, bool const trackRoll ) :
-		Font( &font ),
-		NumVerts( numVerts ),
-		Pivot( pivot ),
-		Rotation( rot ),
-		Billboard( billboard ),
-		TrackRoll( trackRoll )
-	{
-		Verts = new fontVertex_t[numVerts];
-	}
-
-	~VertexBlockType()
-	{
-		Free();
-	}
-
-	void Free()
-	{
-		Font = NULL;
-		delete [] Verts;
-		Verts = NULL;
-		NumVerts = 0;
-	}
-
-	mutable BitmapFont const *	Font;		// the font used to render text into this vertex block
-	mutable fontVertex_t *		Verts;		// the vertices
-	mutable int					NumVerts;	// the number of vertices in the block
-	Vector3f					Pivot;		// postion this vertex block can be rotated around
-	Quatf						Rotation;	// additional rotation to apply
-	bool						Billboard;	// true to always face the camera
-	bool						TrackRoll;	// if true, when billboarded, roll with the camera
+	TextLayoutType const *	Layout;		// the layout of the text, owned by the layout cache
+	Vector3f				Pivot;		// postion this vertex block can be rotated around
+	Vector3f				Right;		// world direction of the layout x axis if not billboarded
+	Vector3f				Up;			// world direction of the layout y axis if not billboarded
+	UInt32					Color;		// ABGR color of all vertices
+	bool					Billboard;	// true to always face the camera
+	bool					TrackRoll;	// if true, when billboarded, roll with the camera
 };
 
 // Sets up VB and VAO for font drawing
@@ -449,14 +509,15 @@ GlGeometry	FontGeometry( int maxQuads )
 }
 
 //==============================
-// DrawText3D
-VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t const & parms,
-		Vector3f const & pos, Vector3f const & normal, Vector3f const & up,
-		float scale, Vector4f const & color, char const * text )
+// BuildTextLayout
+static void BuildTextLayout( BitmapFont const & font, fontParms_t const & parms,
+		float const scale, char const * text, TextLayoutType & layout )
 {
+	layout.Verts.Clear();
+
 	if ( text == NULL || text[0] == '\0' )
 	{
-		return VertexBlockType();	// nothing to do here, move along
+		return;	// nothing to do here, move along
 	}
 
 	// TODO: multiple line support -- we would need to calculate the horizontal width
@@ -471,24 +532,9 @@ VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t cons
 	float lineWidths[MAX_LINES];
 	int numLines;
 	AsLocal( font ).CalcTextMetrics( text, len, width, height, ascent, descent, fontHeight, lineWidths, MAX_LINES, numLines );
-//	LOG( "BitmapFontSurfaceLocal::DrawText3D( \"%s\" %s %s ) : width = %.2f, height = %.2f, numLines = %i, fh = %.2f",
-//			text, ( parms.AlignVert == VERTICAL_CENTER ) ? "cv" : ( ( parms.AlignVert == VERTICAL_BOTTOM ) ? "bv" : "tv" ),
-// 			( parms.AlignHoriz == HORIZONTAL_CENTER ) ? "ch" : ( ( parms.AlignVert == HORIZONTAL_LEFT ) ? "lh" : "rh" ),
-//			width, height, numLines, AsLocal( font ).GetFontInfo().FontHeight );
 	if ( len == 0 )
 	{
-		return VertexBlockType();
-	}
-
-	if ( !normal.IsNormalized() )
-	{
-		LOG( "DrawTextToVertexBlock: normal = ( %g, %g, %g ), text = '%s'", normal.x, normal.y, normal.z, text );
-		ASSERT_WITH_TAG( normal.IsNormalized(), "BitmapFont" );
-	}
-	if ( !up.IsNormalized() )
-	{
-		LOG( "DrawTextToVertexBlock: up = ( %g, %g, %g ), text = '%s'", up.x, up.y, up.z, text );
-		ASSERT_WITH_TAG( up.IsNormalized(), "BitmapFont" );
+		return;
 	}
 
 	const FontInfoType & fontInfo = AsLocal( font ).GetFontInfo();
@@ -497,15 +543,10 @@ VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t cons
 	float const xScale = AsLocal( font ).GetFontInfo().ScaleFactorX * scale;
 	float const yScale = AsLocal( font ).GetFontInfo().ScaleFactorY * scale;
 
-	// allocate a vertex block
-	size_t numVerts = 4 * len;
-	VertexBlockType vb( font, numVerts, pos, Quatf(), parms.Billboard, parms.TrackRoll );
+	layout.Verts.Resize( 4 * len );
 
-	Vector3f const right = up.Cross( normal );
-	Vector3f const r = ( parms.Billboard ) ? Vector3f( 1.0f, 0.0f, 0.0f ) : right;
-	Vector3f const u = ( parms.Billboard ) ? Vector3f( 0.0f, 1.0f, 0.0f ) : up;
-
-	Vector3f curPos( 0.0f );
+	float curX = 0.0f;
+	float curY = 0.0f;
 	switch( parms.AlignVert )
 	{
 		case VERTICAL_BASELINE :
@@ -514,7 +555,7 @@ VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t cons
 		case VERTICAL_CENTER :
 		{
 			float const vofs = ( height * 0.5f ) - ascent;
-			curPos += u * ( vofs * scale );
+			curY += vofs * scale;
 			break;
 		}
 		case VERTICAL_CENTER_FIXEDHEIGHT :
@@ -527,18 +568,18 @@ VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t cons
 			float const fh = AsLocal( font ).GetFontInfo().FontHeight;
 			float const adjust = ( ma - md ) * 0.5f;
 			float const vofs = ( fh * ( numLines - 1 ) * 0.5f ) - adjust;
-			curPos += u * ( vofs * yScale );
+			curY += vofs * yScale;
 			break;
 		}
 		case VERTICAL_TOP :
 		{
 			float const vofs = height - ascent;
-			curPos += u * ( vofs * scale );
+			curY += vofs * scale;
 			break;
 		}
 	}
 
-	Vector3f basePos = curPos;
+	float baseY = curY;
 	switch( parms.AlignHoriz )
 	{
 		case HORIZONTAL_LEFT :
@@ -546,30 +587,25 @@ VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t cons
 
 		case HORIZONTAL_CENTER :
 		{
-			curPos -= r * ( lineWidths[0] * 0.5f * scale );
+			curX -= lineWidths[0] * 0.5f * scale;
 			break;
 		}
 		case HORIZONTAL_RIGHT :
 		{
-			curPos -= r * ( lineWidths[0] * scale );
+			curX -= lineWidths[0] * scale;
 			break;
 		}
 	}
 
-	Vector3f lineInc = u * ( fontInfo.FontHeight * yScale );
+	float const lineInc = fontInfo.FontHeight * yScale;
 	float const distanceScale = imageWidth / FontInfoType::DEFAULT_SCALE_FACTOR;
-	const uint8_t fontParms[4] =
-	{
-			(uint8_t)( OVR::Alg::Clamp( parms.AlphaCenter + fontInfo.CenterOffset, 0.0f, 1.0f ) * 255 ),
-			(uint8_t)( OVR::Alg::Clamp( parms.ColorCenter + fontInfo.CenterOffset, 0.0f, 1.0f ) * 255 ),
-			(uint8_t)( OVR::Alg::Clamp( distanceScale, 1.0f, 255.0f ) ),
-			0
-	};
-
-    int iColor = ColorToABGR( color );
+	layout.FontParms[0] = (uint8_t)( OVR::Alg::Clamp( parms.AlphaCenter + fontInfo.CenterOffset, 0.0f, 1.0f ) * 255 );
+	layout.FontParms[1] = (uint8_t)( OVR::Alg::Clamp( parms.ColorCenter + fontInfo.CenterOffset, 0.0f, 1.0f ) * 255 );
+	layout.FontParms[2] = (uint8_t)( OVR::Alg::Clamp( distanceScale, 1.0f, 255.0f ) );
+	layout.FontParms[3] = 0;
 
 	int curLine = 0;
-	fontVertex_t * v = vb.Verts;
+	textLayoutVertex_t * v = layout.Verts.GetDataPtr();
 	char const * p = text;
 	size_t i = 0;
 	uint32_t charCode = UTF8Util::DecodeNextChar( &p );
@@ -580,8 +616,9 @@ VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t cons
 		{
 			// move to next line
 			curLine++;
-			basePos -= lineInc;
-			curPos = basePos;
+			baseY -= lineInc;
+			curX = 0.0f;
+			curY = baseY;
 			switch( parms.AlignHoriz )
 			{
 				case HORIZONTAL_LEFT :
@@ -589,12 +626,12 @@ VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t cons
 
 				case HORIZONTAL_CENTER :
 				{
-					curPos -= r * ( lineWidths[curLine] * 0.5f * scale );
+					curX -= lineWidths[curLine] * 0.5f * scale;
 					break;
 				}
 				case HORIZONTAL_RIGHT :
 				{
-					curPos -= r * ( lineWidths[curLine] * scale );
+					curX -= lineWidths[curLine] * scale;
 					break;
 				}
 			}
@@ -613,37 +650,211 @@ VertexBlockType DrawTextToVertexBlock( BitmapFont const & font, fontParms_t cons
 		float rw = ( g.Width + g.BearingX ) * xScale;
 		float rh = ( g.Height - g.BearingY ) * yScale;
 
-        // lower left
-        v[i * 4 + 0].xyz = curPos + ( r * bearingX ) - ( u * rh );
-        v[i * 4 + 0].s = s0;
-        v[i * 4 + 0].t = t1;
-        *(UInt32*)(&v[i * 4 + 0].rgba[0]) = iColor;
-		*(UInt32*)(&v[i * 4 + 0].fontParms[0]) = *(UInt32*)(&fontParms[0]);
-	    // upper left
-        v[i * 4 + 1].xyz = curPos + ( r * bearingX ) + ( u * bearingY );
-        v[i * 4 + 1].s = s0;
-        v[i * 4 + 1].t = t0;
-        *(UInt32*)(&v[i * 4 + 1].rgba[0]) = iColor;
-		*(UInt32*)(&v[i * 4 + 1].fontParms[0]) = *(UInt32*)(&fontParms[0]);
-        // upper right
-        v[i * 4 + 2].xyz = curPos + ( r * rw ) + ( u * bearingY );
-        v[i * 4 + 2].s = s1;
-        v[i * 4 + 2].t = t0;
-        *(UInt32*)(&v[i * 4 + 2].rgba[0]) = iColor;
-		*(UInt32*)(&v[i * 4 + 2].fontParms[0]) = *(UInt32*)(&fontParms[0]);
-        // lower right
-        v[i * 4 + 3].xyz = curPos + ( r * rw ) - ( u * rh );
-        v[i * 4 + 3].s = s1;
-        v[i * 4 + 3].t = t1;
-        *(UInt32*)(&v[i * 4 + 3].rgba[0]) = iColor;
-		*(UInt32*)(&v[i * 4 + 3].fontParms[0]) = *(UInt32*)(&fontParms[0]);
+		// lower left
+		v[i * 4 + 0].x = curX + bearingX;
+		v[i * 4 + 0].y = curY - rh;
+		v[i * 4 + 0].s = s0;
+		v[i * 4 + 0].t = t1;
+		// upper left
+		v[i * 4 + 1].x = curX + bearingX;
+		v[i * 4 + 1].y = curY + bearingY;
+		v[i * 4 + 1].s = s0;
+		v[i * 4 + 1].t = t0;
+		// upper right
+		v[i * 4 + 2].x = curX + rw;
+		v[i * 4 + 2].y = curY + bearingY;
+		v[i * 4 + 2].s = s1;
+		v[i * 4 + 2].t = t0;
+		// lower right
+		v[i * 4 + 3].x = curX + rw;
+		v[i * 4 + 3].y = curY - rh;
+		v[i * 4 + 3].s = s1;
+		v[i * 4 + 3].t = t1;
 		// advance to start of next char
-		curPos += r * ( g.AdvanceX * xScale );
+		curX += g.AdvanceX * xScale;
+	}
+}
+
+//==============================
+// TransformTextLayout
+// Places the layout in world space with its x and y axes along axisX and axisY.
+static void TransformTextLayout( TextLayoutType const & layout, Vector3f const & origin,
+		Vector3f const & axisX, Vector3f const & axisY, UInt32 const color, fontVertex_t * verts )
+{
+	TransformTextVertices( layout.Verts.GetDataPtr(), layout.Verts.GetSizeI(), origin, axisX, axisY,
+			color, *(UInt32 const *)( &layout.FontParms[0] ), verts );
+}
+
+//==============================================================
+// TextLayoutCache
+// Caches the layouts of the text drawn on a surface. Layouts that are not drawn for a number
+// of frames are evicted, so text that changes every frame only stays around briefly.
+class TextLayoutCache
+{
+public:
+							TextLayoutCache();
+							~TextLayoutCache();
+
+	// Returns the layout for the text, building it if it is not in the cache yet. The layout
+	// stays valid at least until the next call to EndFrame().
+	TextLayoutType const *	GetLayout( BitmapFont const & font, fontParms_t const & parms,
+									float const scale, char const * text );
+
+	// Evicts layouts that were not drawn recently.
+	void					EndFrame();
+
+	void					Clear();
+
+	int						GetHits() const { return Hits; }
+	int						GetMisses() const { return Misses; }
+
+private:
+	static const int		NUM_BUCKETS = 1024;		// must be a power of two
+	static const int		MAX_LAYOUTS = 1024;		// evict anything that was not drawn this frame beyond this
+	static const int		EVICT_FRAMES = 64;		// evict layouts that were not drawn in this many frames
+
+	Array< TextLayoutType * >	Layouts;
+	int						Buckets[NUM_BUCKETS];
+	int						FrameNumber;
+	int						Hits;
+	int						Misses;
+
+	void					Evict( int const minFrame );
+};
+
+static UInt32 TextLayoutHash( BitmapFont const & font, fontParms_t const & parms,
+		float const scale, char const * text )
+{
+	union
+	{
+		float	f;
+		UInt32	u;
+	} const bits[3] = { { scale }, { parms.AlphaCenter }, { parms.ColorCenter } };
+
+	// FNV-1a
+	UInt32 hash = 2166136261u;
+	for ( char const * p = text; *p != '\0'; p++ )
+	{
+		hash = ( hash ^ (UByte)*p ) * 16777619u;
+	}
+	UInt32 const values[6] = { (UInt32)(UPInt)&font, (UInt32)parms.AlignHoriz, (UInt32)parms.AlignVert, bits[0].u, bits[1].u, bits[2].u };
+	for ( int i = 0; i < 6; i++ )
+	{
+		hash = ( hash ^ values[i] ) * 16777619u;
+	}
+	return hash;
+}
+
+TextLayoutCache::TextLayoutCache() :
+	FrameNumber( 0 ),
+	Hits( 0 ),
+	Misses( 0 )
+{
+	for ( int i = 0; i < NUM_BUCKETS; i++ )
+	{
+		Buckets[i] = -1;
 	}
+}
+
+TextLayoutCache::~TextLayoutCache()
+{
+	Clear();
+}
 
-	return vb;
+void TextLayoutCache::Clear()
+{
+	for ( int i = 0; i < Layouts.GetSizeI(); i++ )
+	{
+		delete Layouts[i];
+	}
+	Layouts.Clear();
+	for ( int i = 0; i < NUM_BUCKETS; i++ )
+	{
+		Buckets[i] = -1;
+	}
 }
 
+TextLayoutType const * TextLayoutCache::GetLayout( BitmapFont const & font, fontParms_t const & parms,
+		float const scale, char const * text )
+{
+	UInt32 const hash = TextLayoutHash( font, parms, scale, text );
+	int & bucket = Buckets[hash & ( NUM_BUCKETS - 1 )];
+	for ( int i = bucket; i >= 0; i = Layouts[i]->Next )
+	{
+		TextLayoutType & layout = *Layouts[i];
+		if ( layout.Hash == hash &&
+				layout.Font == &font &&
+				layout.Scale == scale &&
+				layout.Parms.AlignHoriz == parms.AlignHoriz &&
+				layout.Parms.AlignVert == parms.AlignVert &&
+				layout.Parms.AlphaCenter == parms.AlphaCenter &&
+				layout.Parms.ColorCenter == parms.ColorCenter &&
+				OVR_strcmp( layout.Text.ToCStr(), text ) == 0 )
+		{
+			layout.LastFrame = FrameNumber;
+			Hits++;
+			return &layout;
+		}
+	}
+
+	Misses++;
+
+	TextLayoutType * layout = new TextLayoutType;
+	layout->Font = &font;
+	layout->Parms = parms;
+	layout->Scale = scale;
+	layout->Text = text;
+	layout->Hash = hash;
+	layout->LastFrame = FrameNumber;
+	BuildTextLayout( font, parms, scale, text, *layout );
+
+	layout->Next = bucket;
+	bucket = Layouts.GetSizeI();
+	Layouts.PushBack( layout );
+	return layout;
+}
+
+void TextLayoutCache::EndFrame()
+{
+	if ( Layouts.GetSizeI() > MAX_LAYOUTS )
+	{
+		Evict( FrameNumber );
+	}
+	else if ( ( FrameNumber % EVICT_FRAMES ) == EVICT_FRAMES - 1 )
+	{
+		Evict( FrameNumber - EVICT_FRAMES + 1 );
+	}
+	FrameNumber++;
+}
+
+// Removes all layouts last drawn before minFrame and rebuilds the hash chains.
+void TextLayoutCache::Evict( int const minFrame )
+{
+	int numKept = 0;
+	for ( int i = 0; i < Layouts.GetSizeI(); i++ )
+	{
+		if ( Layouts[i]->LastFrame < minFrame )
+		{
+			delete Layouts[i];
+		}
+		else
+		{
+			Layouts[numKept++] = Layouts[i];
+		}
+	}
+	Layouts.Resize( numKept );
+
+	for ( int i = 0; i < NUM_BUCKETS; i++ )
+	{
+		Buckets[i] = -1;
+	}
+	for ( int i = 0; i < numKept; i++ )
+	{
+		int & bucket = Buckets[Layouts[i]->Hash & ( NUM_BUCKETS - 1 )];
+		Layouts[i]->Next = bucket;
+		bucket = i;
+	}
+}
 
 ovrSurfaceDef BitmapFontLocal::TextSurface( const char * text,
 		float scale, const Vector4f & color, HorizontalJustification hjust,
@@ -652,30 +863,30 @@ ovrSurfaceDef BitmapFontLocal::TextSurface( const char * text,
 	fontParms_t	fp;
 	fp.AlignHoriz = hjust;
 	fp.AlignVert = vjust;
-	VertexBlockType	vb = DrawTextToVertexBlock( *this,
-			fp,
-			Vector3f( 0.0f ),				// origin
-			Vector3f( 0.0f, 0.0f, 1.0f ),	// normal
-			Vector3f( 0.0f, 1.0f, 0.0f ),	// up
-			scale,
-			color,
-			text );
+	TextLayoutType layout;
+	BuildTextLayout( *this, fp, scale, text, layout );
+
+	// the text is laid out on the Z = 0 plane, facing +Z
+	int const numVerts = layout.Verts.GetSizeI();
+	fontVertex_t * verts = new fontVertex_t[numVerts];
+	TransformTextLayout( layout, Vector3f( 0.0f ), Vector3f( 1.0f, 0.0f, 0.0f ), Vector3f( 0.0f, 1.0f, 0.0f ),
+			ColorToABGR( color ), verts );
 
 	ovrSurfaceDef s;
 
 	s.cullingBounds.Clear();
-	for ( int i = 0 ; i < vb.NumVerts ; i++ )
+	for ( int i = 0 ; i < numVerts ; i++ )
 	{
-		s.cullingBounds.AddPoint( vb.Verts[i].xyz );
+		s.cullingBounds.AddPoint( verts[i].xyz );
 	}
-	s.geo = FontGeometry( vb.NumVerts / 4 );
+	s.geo = FontGeometry( numVerts / 4 );
 
 	glBindVertexArray( s.geo.vertexArrayObject );
 	glBindBuffer( GL_ARRAY_BUFFER, s.geo.vertexBuffer );
-	glBufferSubData( GL_ARRAY_BUFFER, 0, vb.NumVerts * sizeof( fontVertex_t ), (void *)vb.Verts );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, numVerts * sizeof( fontVertex_t ), (void *)verts );
 	glBindVertexArray( 0 );
 
-	vb.Free();
+	delete [] verts;
 
 	// Special blend mode to also work over underlay layers
 	s.materialDef.gpuState.blendEnable = ovrGpuState::BLEND_ENABLE_SEPARATE;
@@ -737,16 +948,23 @@ public:
 
 	virtual bool		IsInitialized() const { return Initialized; }
 
+	virtual void		GetLayoutCacheCounts( int & hits, int & misses ) const;
+
 private:
+	// the arrays keep their memory from frame to frame
+	typedef ArrayConstPolicy< 0, 16, true > NeverShrinkPolicy;
+
 	GlGeometry      Geo;		// font glyphs
-	fontVertex_t *  Vertices;	// vertices that are written to the VBO
 	int             MaxVertices;
 	int             MaxIndices;
 	int             CurVertex;  // reset every Render()
 	int             CurIndex;   // reset every Render()
 	bool			Initialized;
 
-	Array< VertexBlockType >	    VertexBlocks;	// each pointer in the array points to an allocated block ov
+	ArrayPOD< VertexBlockType, NeverShrinkPolicy >	VertexBlocks;	// the text drawn this frame
+	ArrayPOD< vbSort_t, NeverShrinkPolicy >			SortBlocks;		// vertex blocks sorted nearest first
+	ArrayPOD< vbSort_t, NeverShrinkPolicy >			SortScratch;
+	TextLayoutCache					LayoutCache;	// layouts of the text drawn in recent frames
 };
 
 //==============================
@@ -780,41 +998,82 @@ static size_t FileSize( FILE * f )
 bool FontInfoType::LoadFromPackage( void* packageFile, char const * fileName )
 {
 	int length = 0;
-	void * packageBuffer = NULL;
-
-	ovr_ReadFileFromOtherApplicationPackage( packageFile, fileName, length, packageBuffer );
-	if ( packageBuffer == NULL ) 
+	void * file = ovr_OpenFileFromOtherApplicationPackage( packageFile, fileName, length );
+	if ( file == NULL ) 
 	{
 		return false;
 	}
 
-	size_t fsize;
+	// binary files are loaded into memory, JSON files are parsed while they are read
+	UInt32 magic = 0;
+	bool const isBinary = ovr_ReadFromPackageFile( file, &magic, sizeof( magic ) ) == sizeof( magic ) &&
+			IsBinary( &magic, sizeof( magic ) );
+	ovr_ClosePackageFile( file );
 
-	unsigned char * buffer = NULL;
-	// copy to a zero-terminated buffer for JSON parser
-	fsize = length + 1;
-	buffer = new unsigned char[fsize];
-	memcpy( buffer, packageBuffer, length );
-	buffer[length] = '\0';
-	free( packageBuffer );
+	if ( isBinary )
+	{
+		void * packageBuffer = NULL;
+		ovr_ReadFileFromOtherApplicationPackage( packageFile, fileName, length, packageBuffer );
+		if ( packageBuffer == NULL )
+		{
+			return false;
+		}
+		bool const r = LoadFromBinaryBuffer( packageBuffer, length );
+		free( packageBuffer );
+		return r;
+	}
 
-	// try to load from the buffer -- this may fail due to an invalid version
-	bool r = LoadFromBuffer( buffer, fsize );
-	delete [] buffer;
+	// reopen the file to parse it from the start
+	file = ovr_OpenFileFromOtherApplicationPackage( packageFile, fileName, length );
+	if ( file == NULL )
+	{
+		return false;
+	}
+	ovrPackageJsonSource source( file );
+	JsonStreamReader reader( &source );
+
+	// this may fail due to an invalid version
+	bool const r = LoadFromStream( reader );
+	ovr_ClosePackageFile( file );
 	return r;
 }
 
-
 //==============================
 // FontInfoType::Load
 bool FontInfoType::Load( ovrFileSys & fileSys, char const * uri )
 {
-	MemBufferT< uint8_t > buffer;	
-	if ( !fileSys.ReadFile( uri, buffer ) )
+	ovrStream * stream = fileSys.OpenStream( uri, OVR_STREAM_MODE_READ );
+	if ( stream == NULL )
+	{
+		return false;
+	}
+
+	MemBufferT< uint8_t > magic( sizeof( UInt32 ) );
+	size_t bytesRead = 0;
+	bool const isBinary = stream->Read( magic, sizeof( UInt32 ), bytesRead ) && IsBinary( magic, bytesRead );
+	fileSys.CloseStream( stream );
+
+	if ( isBinary )
+	{
+		MemBufferT< uint8_t > buffer;
+		if ( !fileSys.ReadFile( uri, buffer ) )
+		{
+			return false;
+		}
+		return LoadFromBinaryBuffer( buffer, buffer.GetSize() );
+	}
+
+	// reopen the stream to parse it from the start
+	stream = fileSys.OpenStream( uri, OVR_STREAM_MODE_READ );
+	if ( stream == NULL )
 	{
 		return false;
 	}
-	return LoadFromBuffer( buffer, buffer.GetSize() );
+	ovrJsonStreamSource source( *stream );
+	JsonStreamReader reader( &source );
+	bool const r = LoadFromStream( reader );
+	fileSys.CloseStream( stream );
+	return r;
 }
 
 //==============================
@@ -831,62 +1090,194 @@ bool FontInfoType::Load( OvrApkFile const & languagePackageFile, char const * fi
 }
 
 //==============================
-// FontInfoType::LoadFromBuffer
-bool FontInfoType::LoadFromBuffer( void const * buffer, size_t const bufferSize ) 
+// ReadGlyph
+// Reads the members of a glyph object after JSON_TOKEN_BEGIN_OBJECT.
+static void ReadGlyph( JsonStreamReader & reader, FontGlyphType & g )
 {
-	char const * errorMsg = NULL;
-	OVR::JSON * jsonRoot = OVR::JSON::Parse( reinterpret_cast< char const * >( buffer ), &errorMsg );
-	if ( jsonRoot == NULL )
+	while ( reader.Next() == JSON_TOKEN_NAME )
 	{
-		WARN( "JSON Error: %s", ( errorMsg != NULL ) ? errorMsg : "<NULL>" );
-		return false;
+		char const * name = reader.GetString();
+		if ( OVR_strcmp( name, "CharCode" ) == 0 )
+		{
+			g.CharCode = reader.ReadInt32();
+		}
+		else if ( OVR_strcmp( name, "X" ) == 0 )
+		{
+			g.X = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "Y" ) == 0 )
+		{
+			g.Y = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "Width" ) == 0 )
+		{
+			g.Width = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "Height" ) == 0 )
+		{
+			g.Height = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "AdvanceX" ) == 0 )
+		{
+			g.AdvanceX = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "AdvanceY" ) == 0 )
+		{
+			g.AdvanceY = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "BearingX" ) == 0 )
+		{
+			g.BearingX = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "BearingY" ) == 0 )
+		{
+			g.BearingY = reader.ReadFloat();
+		}
+		else
+		{
+			reader.SkipValue();
+		}
 	}
+}
 
-	int32_t maxCharCode = -1;
-	// currently we're only supporting the first unicode plane up to 65k. If we were to support other planes
-	// we could conceivably end up with a very sparse 1,114,111 byte type for mapping character codes to
-	// glyphs and if that's the case we may just want to use a hash, or use a combination of tables for
-	// the first 65K and hashes for the other, less-frequently-used characters.
-	static const int MAX_GLYPHS = 0xffff;	
+//==============================
+// FontInfoType::LoadFromStream
+bool FontInfoType::LoadFromStream( JsonStreamReader & reader ) 
+{
+	// glyph indices are stored as 16 bits in the character code map
+	static const int MAX_GLYPHS = CharCodePageTable::INVALID_INDEX;
 
-	// load the glyphs
-	const JsonReader jsonGlyphs( jsonRoot );
-	if ( !jsonGlyphs.IsObject() )
+	if ( reader.Next() != JSON_TOKEN_BEGIN_OBJECT )
 	{
-		jsonRoot->Release();
+		WARN( "JSON Error: %s", ( reader.GetError() != NULL ) ? reader.GetError() : "not an object" );
 		return false;
 	}
 
-	int Version = jsonGlyphs.GetChildFloatByName( "Version" );
-	if ( Version != FNT_FILE_VERSION )
+	int version = 0;
+	int numGlyphs = 0;
+	float horizontalPad = 0.0f;
+	float verticalPad = 0.0f;
+	float fontHeight = 0.0f;
+	NaturalWidth = 0.0f;
+	NaturalHeight = 0.0f;
+	CenterOffset = 0.0f;
+	TweakScale = 1.0f;
+	Glyphs.Clear();
+
+	// the members can be in any order, so the glyphs are scaled after the whole object is read
+	while ( reader.Next() == JSON_TOKEN_NAME )
 	{
-		jsonRoot->Release();
-		return false;
+		char const * name = reader.GetString();
+		if ( OVR_strcmp( name, "Version" ) == 0 )
+		{
+			version = static_cast< int >( reader.ReadFloat() );
+			if ( version != FNT_FILE_VERSION )
+			{
+				return false;
+			}
+		}
+		else if ( OVR_strcmp( name, "FontName" ) == 0 )
+		{
+			FontName = reader.ReadString();
+		}
+		else if ( OVR_strcmp( name, "CommandLine" ) == 0 )
+		{
+			CommandLine = reader.ReadString();
+		}
+		else if ( OVR_strcmp( name, "ImageFileName" ) == 0 )
+		{
+			ImageFileName = reader.ReadString();
+		}
+		else if ( OVR_strcmp( name, "NumGlyphs" ) == 0 )
+		{
+			numGlyphs = reader.ReadInt32();
+			if ( numGlyphs < 0 || numGlyphs > MAX_GLYPHS )
+			{
+				OVR_ASSERT( numGlyphs > 0 && numGlyphs <= MAX_GLYPHS );
+				return false;
+			}
+		}
+		else if ( OVR_strcmp( name, "NaturalWidth" ) == 0 )
+		{
+			NaturalWidth = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "NaturalHeight" ) == 0 )
+		{
+			NaturalHeight = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "HorizontalPad" ) == 0 )
+		{
+			horizontalPad = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "VerticalPad" ) == 0 )
+		{
+			verticalPad = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "FontHeight" ) == 0 )
+		{
+			fontHeight = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "CenterOffset" ) == 0 )
+		{
+			CenterOffset = reader.ReadFloat();
+		}
+		else if ( OVR_strcmp( name, "TweakScale" ) == 0 )
+		{
+			TweakScale = reader.ReadFloat( 1.0f );
+		}
+		else if ( OVR_strcmp( name, "Glyphs" ) == 0 )
+		{
+			if ( reader.Next() != JSON_TOKEN_BEGIN_ARRAY )
+			{
+				reader.SkipRestOfValue();
+				continue;
+			}
+			for ( ; ; )
+			{
+				JsonStreamToken const token = reader.Next();
+				if ( token == JSON_TOKEN_END_ARRAY || token == JSON_TOKEN_ERROR )
+				{
+					break;
+				}
+				// elements that are not objects keep a default glyph, as before
+				FontGlyphType g;
+				if ( token == JSON_TOKEN_BEGIN_OBJECT )
+				{
+					ReadGlyph( reader, g );
+				}
+				else
+				{
+					reader.SkipRestOfValue();
+				}
+				if ( Glyphs.GetSizeI() < MAX_GLYPHS )
+				{
+					Glyphs.PushBack( g );
+				}
+			}
+		}
+		else
+		{
+			reader.SkipValue();
+		}
 	}
 
-	FontName = jsonGlyphs.GetChildStringByName( "FontName" );
-	CommandLine = jsonGlyphs.GetChildStringByName( "CommandLine" );
-	ImageFileName = jsonGlyphs.GetChildStringByName( "ImageFileName" );
-	const int numGlyphs = jsonGlyphs.GetChildInt32ByName( "NumGlyphs" );
-	if ( numGlyphs < 0 || numGlyphs > MAX_GLYPHS )
+	if ( reader.GetToken() != JSON_TOKEN_END_OBJECT || reader.GetDepth() != 0 )
+	{
+		WARN( "JSON Error: %s at line %i", ( reader.GetError() != NULL ) ? reader.GetError() : "unexpected token", reader.GetErrorLine() );
+		return false;
+	}
+	if ( version != FNT_FILE_VERSION )
 	{
-		OVR_ASSERT( numGlyphs > 0 && numGlyphs <= MAX_GLYPHS );
-		jsonRoot->Release();
 		return false;
 	}
-
-	NaturalWidth = jsonGlyphs.GetChildFloatByName( "NaturalWidth" );
-	NaturalHeight = jsonGlyphs.GetChildFloatByName( "NaturalHeight" );
 
 	// we scale everything after loading integer values from the JSON file because the OVR JSON writer loses precision on floats
 	float nwScale = 1.0f / NaturalWidth;
 	float nhScale = 1.0f / NaturalHeight;
 
-	HorizontalPad = jsonGlyphs.GetChildFloatByName( "HorizontalPad" ) * nwScale;
-	VerticalPad = jsonGlyphs.GetChildFloatByName( "VerticalPad" ) * nhScale;
-	FontHeight = jsonGlyphs.GetChildFloatByName( "FontHeight" ) * nhScale;
-	CenterOffset = jsonGlyphs.GetChildFloatByName( "CenterOffset" );
-	TweakScale = jsonGlyphs.GetChildFloatByName( "TweakScale", 1.0f );
+	HorizontalPad = horizontalPad * nwScale;
+	VerticalPad = verticalPad * nhScale;
+	FontHeight = fontHeight * nhScale;
 
 	LOG( "FontName = %s", FontName.ToCStr() );
 	LOG( "CommandLine = %s", CommandLine.ToCStr() );
@@ -906,59 +1297,39 @@ bool FontInfoType::LoadFromBuffer( void const * buffer, size_t const bufferSize
 	}
 /// HACK: end hack
 
+	// only the first NumGlyphs glyphs are used, missing ones keep their defaults
 	Glyphs.Resize( numGlyphs );
 
-	const JsonReader jsonGlyphArray( jsonGlyphs.GetChildByName( "Glyphs" ) );
-
 	double oWidth = 0.0;
 	double oHeight = 0.0;
 
-	if ( jsonGlyphArray.IsArray() )
+	for ( int i = 0; i < Glyphs.GetSizeI(); i++ )
 	{
-		for ( int i = 0; i < Glyphs.GetSizeI() && !jsonGlyphArray.IsEndOfArray(); i++ )
+		FontGlyphType & g = Glyphs[i];
+		if ( g.CharCode == 'O' )
 		{
-			const JsonReader jsonGlyph( jsonGlyphArray.GetNextArrayElement() );
-			if ( jsonGlyph.IsObject() )
-			{
-				FontGlyphType & g = Glyphs[i];
-				g.CharCode	= jsonGlyph.GetChildInt32ByName( "CharCode" );
-				g.X			= jsonGlyph.GetChildFloatByName( "X" );
-				g.Y			= jsonGlyph.GetChildFloatByName( "Y" );
-				g.Width		= jsonGlyph.GetChildFloatByName( "Width" );
-				g.Height	= jsonGlyph.GetChildFloatByName( "Height" );
-				g.AdvanceX	= jsonGlyph.GetChildFloatByName( "AdvanceX" );
-				g.AdvanceY	= jsonGlyph.GetChildFloatByName( "AdvanceY" );
-				g.BearingX	= jsonGlyph.GetChildFloatByName( "BearingX" );
-				g.BearingY	= jsonGlyph.GetChildFloatByName( "BearingY" );
-
-				if ( g.CharCode == 'O' )
-				{
-					oWidth = g.Width;
-					oHeight = g.Height;
-				}
-
-				g.X *= nwScale;
-				g.Y *= nhScale;
-				g.Width *= nwScale;
-				g.Height *= nhScale;
-				g.AdvanceX *= nwScale;
-				g.AdvanceY *= nhScale;
-				g.BearingX *= nwScale;
-				g.BearingY *= nhScale;
-
-				float const ascent = g.BearingY;
-				float const descent = g.Height - g.BearingY;
-				if ( ascent > MaxAscent )
-				{
-					MaxAscent = ascent;
-				}
-				if ( descent > MaxDescent )
-				{
-					MaxDescent = descent;
-				}
+			oWidth = g.Width;
+			oHeight = g.Height;
+		}
 
-				maxCharCode = Alg::Max( maxCharCode, g.CharCode );
-			}
+		g.X *= nwScale;
+		g.Y *= nhScale;
+		g.Width *= nwScale;
+		g.Height *= nhScale;
+		g.AdvanceX *= nwScale;
+		g.AdvanceY *= nhScale;
+		g.BearingX *= nwScale;
+		g.BearingY *= nhScale;
+
+		float const ascent = g.BearingY;
+		float const descent = g.Height - g.BearingY;
+		if ( ascent > MaxAscent )
+		{
+			MaxAscent = ascent;
+		}
+		if ( descent > MaxDescent )
+		{
+			MaxDescent = descent;
 		}
 	}
 
@@ -975,45 +1346,204 @@ bool FontInfoType::LoadFromBuffer( void const * buffer, size_t const bufferSize
 	ScaleFactorX = DEFAULT_SCALE_FACTOR * DEFAULT_TEXT_SCALE * widthScaleFactor * TweakScale;
 	ScaleFactorY = DEFAULT_SCALE_FACTOR * DEFAULT_TEXT_SCALE * heightScaleFactor * TweakScale;
 
-	// This is not intended for wide or ucf character sets -- depending on the size range of
-	// character codes lookups may need to be changed to use a hash.
-	if ( maxCharCode >= MAX_GLYPHS )
+	// only the pages of character codes that have glyphs are allocated
+	CharCodeMap.Clear();
+	for ( int i = 0; i < Glyphs.GetSizeI(); ++i )
 	{
-		OVR_ASSERT( maxCharCode <= MAX_GLYPHS );
-		maxCharCode = MAX_GLYPHS;
+		FontGlyphType const & g = Glyphs[i];
+		if ( !CharCodeMap.Set( g.CharCode, i ) )
+		{
+			WARN( "FontInfoType::LoadFromStream: glyph %i has invalid CharCode %i", i, g.CharCode );
+		}
 	}
-	
-	// resize the array to the maximum glyph value
-	CharCodeMap.Resize( maxCharCode + 1 );
+	LOG( "CharCodeMap has %i pages.", CharCodeMap.GetNumPages() );
 
-	// init to empty value
-	for ( int i = 0; i < CharCodeMap.GetSizeI(); ++i )
+	return true;
+}
+
+//==============================
+// FontInfoType::IsBinary
+bool FontInfoType::IsBinary( void const * buffer, size_t const bufferSize )
+{
+	return buffer != NULL && bufferSize >= sizeof( UInt32 ) && *(UInt32 const *)buffer == FNT_BINARY_MAGIC;
+}
+
+//==============================
+// FontInfoType::LoadFromBinaryBuffer
+bool FontInfoType::LoadFromBinaryBuffer( void const * buffer, size_t const bufferSize )
+{
+	UByte const * data = static_cast< UByte const * >( buffer );
+	if ( bufferSize < sizeof( fontInfoBinaryHeader_t ) )
 	{
-		CharCodeMap[ i ] = -1;
+		WARN( "FontInfoType::LoadFromBinaryBuffer: file too small" );
+		return false;
+	}
+	fontInfoBinaryHeader_t header;
+	memcpy( &header, data, sizeof( header ) );
+	if ( header.Magic != FNT_BINARY_MAGIC || header.Version != FNT_BINARY_VERSION ||
+			header.HeaderSize != sizeof( fontInfoBinaryHeader_t ) || header.GlyphSize != sizeof( FontGlyphType ) )
+	{
+		WARN( "FontInfoType::LoadFromBinaryBuffer: version %u is not supported", header.Version );
+		return false;
 	}
 
-	for ( int i = 0; i < Glyphs.GetSizeI(); ++i )
+	size_t const glyphsSize = (size_t)header.NumGlyphs * sizeof( FontGlyphType );
+	size_t const directorySize = CharCodePageTable::NUM_DIRECTORY_ENTRIES * sizeof( UInt16 );
+	size_t const pagesSize = (size_t)header.NumPages * CharCodePageTable::PAGE_SIZE * sizeof( UInt16 );
+	if ( header.NumGlyphs > CharCodePageTable::INVALID_INDEX || header.NumPages > CharCodePageTable::INVALID_INDEX ||
+			header.StringsOffset >= bufferSize ||
+			header.GlyphsOffset > bufferSize || glyphsSize > bufferSize - header.GlyphsOffset ||
+			header.DirectoryOffset > bufferSize || directorySize > bufferSize - header.DirectoryOffset ||
+			header.PagesOffset > bufferSize || pagesSize > bufferSize - header.PagesOffset )
 	{
-		FontGlyphType const & g = Glyphs[i];
-		CharCodeMap[g.CharCode] = i;
+		WARN( "FontInfoType::LoadFromBinaryBuffer: file is truncated" );
+		return false;
 	}
 
-	jsonRoot->Release();
+	// the strings are stored back to back
+	char const * strings[3];
+	size_t offset = header.StringsOffset;
+	for ( int i = 0; i < 3; i++ )
+	{
+		strings[i] = reinterpret_cast< char const * >( data + offset );
+		while ( offset < bufferSize && data[offset] != '\0' )
+		{
+			offset++;
+		}
+		if ( offset >= bufferSize )
+		{
+			WARN( "FontInfoType::LoadFromBinaryBuffer: file is truncated" );
+			return false;
+		}
+		offset++;
+	}
+
+	FontName = strings[0];
+	CommandLine = strings[1];
+	ImageFileName = strings[2];
+	NaturalWidth = header.NaturalWidth;
+	NaturalHeight = header.NaturalHeight;
+	HorizontalPad = header.HorizontalPad;
+	VerticalPad = header.VerticalPad;
+	FontHeight = header.FontHeight;
+	ScaleFactorX = header.ScaleFactorX;
+	ScaleFactorY = header.ScaleFactorY;
+	TweakScale = header.TweakScale;
+	CenterOffset = header.CenterOffset;
+	MaxAscent = header.MaxAscent;
+	MaxDescent = header.MaxDescent;
+
+	Glyphs.Resize( header.NumGlyphs );
+	memcpy( Glyphs.GetDataPtr(), data + header.GlyphsOffset, glyphsSize );
+
+	CharCodeMap.Directory.Resize( CharCodePageTable::NUM_DIRECTORY_ENTRIES );
+	memcpy( CharCodeMap.Directory.GetDataPtr(), data + header.DirectoryOffset, directorySize );
+	CharCodeMap.Pages.Resize( header.NumPages * CharCodePageTable::PAGE_SIZE );
+	memcpy( CharCodeMap.Pages.GetDataPtr(), data + header.PagesOffset, pagesSize );
+
+	// make sure a corrupt file can't index outside the tables
+	for ( int i = 0; i < CharCodePageTable::NUM_DIRECTORY_ENTRIES; i++ )
+	{
+		UInt16 const page = CharCodeMap.Directory[i];
+		if ( page != CharCodePageTable::INVALID_INDEX && page >= header.NumPages )
+		{
+			WARN( "FontInfoType::LoadFromBinaryBuffer: invalid page %i", page );
+			CharCodeMap.Clear();
+			return false;
+		}
+	}
+	for ( int i = 0; i < CharCodeMap.Pages.GetSizeI(); i++ )
+	{
+		UInt16 const glyphIndex = CharCodeMap.Pages[i];
+		if ( glyphIndex != CharCodePageTable::INVALID_INDEX && glyphIndex >= header.NumGlyphs )
+		{
+			WARN( "FontInfoType::LoadFromBinaryBuffer: invalid glyph index %i", glyphIndex );
+			CharCodeMap.Clear();
+			return false;
+		}
+	}
+
+	LOG( "FontName = %s", FontName.ToCStr() );
+	LOG( "ImageFileName = %s", ImageFileName.ToCStr() );
+	LOG( "Loaded %i glyphs in %i pages.", Glyphs.GetSizeI(), CharCodeMap.GetNumPages() );
 
 	return true;
 }
 
+//==============================
+// FontInfoType::SaveBinary
+bool FontInfoType::SaveBinary( char const * fileName ) const
+{
+	char const * strings[3] = { FontName.ToCStr(), CommandLine.ToCStr(), ImageFileName.ToCStr() };
+	size_t stringsSize = 0;
+	for ( int i = 0; i < 3; i++ )
+	{
+		stringsSize += OVR_strlen( strings[i] ) + 1;
+	}
+	// keep the tables aligned
+	size_t const stringsPadding = ( 4 - ( stringsSize & 3 ) ) & 3;
+
+	fontInfoBinaryHeader_t header;
+	memset( &header, 0, sizeof( header ) );
+	header.Magic = FNT_BINARY_MAGIC;
+	header.Version = FNT_BINARY_VERSION;
+	header.HeaderSize = sizeof( fontInfoBinaryHeader_t );
+	header.GlyphSize = sizeof( FontGlyphType );
+	header.NumGlyphs = Glyphs.GetSizeI();
+	header.NumPages = CharCodeMap.GetNumPages();
+	header.StringsOffset = sizeof( fontInfoBinaryHeader_t );
+	header.GlyphsOffset = (UInt32)( header.StringsOffset + stringsSize + stringsPadding );
+	header.DirectoryOffset = (UInt32)( header.GlyphsOffset + header.NumGlyphs * sizeof( FontGlyphType ) );
+	header.PagesOffset = (UInt32)( header.DirectoryOffset + CharCodeMap.Directory.GetSize() * sizeof( UInt16 ) );
+	header.NaturalWidth = NaturalWidth;
+	header.NaturalHeight = NaturalHeight;
+	header.HorizontalPad = HorizontalPad;
+	header.VerticalPad = VerticalPad;
+	header.FontHeight = FontHeight;
+	header.ScaleFactorX = ScaleFactorX;
+	header.ScaleFactorY = ScaleFactorY;
+	header.TweakScale = TweakScale;
+	header.CenterOffset = CenterOffset;
+	header.MaxAscent = MaxAscent;
+	header.MaxDescent = MaxDescent;
+
+	FILE * f = fopen( fileName, "wb" );
+	if ( f == NULL )
+	{
+		WARN( "FontInfoType::SaveBinary: failed to open '%s': %s", fileName, strerror( errno ) );
+		return false;
+	}
+
+	bool ok = fwrite( &header, sizeof( header ), 1, f ) == 1;
+	for ( int i = 0; i < 3; i++ )
+	{
+		ok = ok && fwrite( strings[i], OVR_strlen( strings[i] ) + 1, 1, f ) == 1;
+	}
+	UByte const padding[4] = { 0, 0, 0, 0 };
+	ok = ok && fwrite( padding, 1, stringsPadding, f ) == stringsPadding;
+	ok = ok && fwrite( Glyphs.GetDataPtr(), sizeof( FontGlyphType ), Glyphs.GetSize(), f ) == Glyphs.GetSize();
+	ok = ok && fwrite( CharCodeMap.Directory.GetDataPtr(), sizeof( UInt16 ), CharCodeMap.Directory.GetSize(), f ) == CharCodeMap.Directory.GetSize();
+	ok = ok && fwrite( CharCodeMap.Pages.GetDataPtr(), sizeof( UInt16 ), CharCodeMap.Pages.GetSize(), f ) == CharCodeMap.Pages.GetSize();
+	ok = ( fclose( f ) == 0 ) && ok;
+
+	if ( !ok )
+	{
+		WARN( "FontInfoType::SaveBinary: failed to write '%s'", fileName );
+	}
+	return ok;
+}
+
 //==============================
 // FontInfoType::GlyphForCharCode
 FontGlyphType const & FontInfoType::GlyphForCharCode( uint32_t const charCode ) const
 {
-	const int glyphIndex = charCode >= CharCodeMap.GetSize() ? -1 : CharCodeMap[charCode];
+	const int glyphIndex = CharCodeMap.Get( charCode );
 
 	if ( glyphIndex < 0 || glyphIndex >= Glyphs.GetSizeI() )
 	{
 		WARN( "FontInfoType::GlyphForCharCode FAILED TO FIND GLYPH FOR CHARACTER!" );
 		WARN( "FontInfoType::GlyphForCharCode: charCode %u yielding %i", charCode, glyphIndex );
-		WARN( "FontInfoType::GlyphForCharCode: CharCodeMap size %i Glyphs size %i", CharCodeMap.GetSize(), Glyphs.GetSizeI() );
+		WARN( "FontInfoType::GlyphForCharCode: CharCodeMap pages %i Glyphs size %i", CharCodeMap.GetNumPages(), Glyphs.GetSizeI() );
 
 		if ( charCode == '*' )
 		{
@@ -1540,7 +2070,6 @@ void BitmapFontLocal::CalcTextMetrics( char const * text, size_t & len, float &
 //==============================
 // BitmapFontSurfaceLocal::BitmapFontSurface
 BitmapFontSurfaceLocal::BitmapFontSurfaceLocal() :
-	Vertices( NULL ),
 	MaxVertices( 0 ),
 	MaxIndices( 0 ),
 	CurVertex( 0 ),
@@ -1554,8 +2083,6 @@ BitmapFontSurfaceLocal::BitmapFontSurfaceLocal() :
 BitmapFontSurfaceLocal::~BitmapFontSurfaceLocal()
 {
 	Geo.Free();
-	delete [] Vertices;
-	Vertices = NULL;
 }
 
 //==============================
@@ -1564,19 +2091,11 @@ BitmapFontSurfaceLocal::~BitmapFontSurfaceLocal()
 void BitmapFontSurfaceLocal::Init( const int maxVertices ) 
 {
 	assert( Geo.vertexBuffer == 0 && Geo.indexBuffer == 0 && Geo.vertexArrayObject == 0 );
-	assert( Vertices == NULL );
-	if ( Vertices != NULL ) 
-	{
-		delete [] Vertices;
-		Vertices = NULL;
-	}
 	assert( maxVertices % 4 == 0 );
 
 	MaxVertices = maxVertices;
 	MaxIndices = ( maxVertices / 4 ) * 6;
 
-	Vertices = new fontVertex_t[ maxVertices ];
-
 	Geo = FontGeometry( MaxVertices / 4 );
 	Geo.indexCount = 0; // if there's anything to render this will be modified
     
@@ -1598,10 +2117,33 @@ void BitmapFontSurfaceLocal::DrawText3D( BitmapFont const & font, fontParms_t co
 	{
 		return;	// nothing to do here, move along
 	}
-	VertexBlockType vb = DrawTextToVertexBlock( font, parms, pos, normal, up, scale, color, text );
 
-	// add the new vertex block to the array of vertex blocks
-	VertexBlocks.PushBack( vb );
+	TextLayoutType const * layout = LayoutCache.GetLayout( font, parms, scale, text );
+	if ( layout->Verts.GetSizeI() == 0 )
+	{
+		return;
+	}
+
+	if ( !normal.IsNormalized() )
+	{
+		LOG( "DrawText3D: normal = ( %g, %g, %g ), text = '%s'", normal.x, normal.y, normal.z, text );
+		ASSERT_WITH_TAG( normal.IsNormalized(), "BitmapFont" );
+	}
+	if ( !up.IsNormalized() )
+	{
+		LOG( "DrawText3D: up = ( %g, %g, %g ), text = '%s'", up.x, up.y, up.z, text );
+		ASSERT_WITH_TAG( up.IsNormalized(), "BitmapFont" );
+	}
+
+	// add a new vertex block to the array of vertex blocks
+	VertexBlockType & vb = VertexBlocks[VertexBlocks.AllocBack()];
+	vb.Layout = layout;
+	vb.Pivot = pos;
+	vb.Right = up.Cross( normal );
+	vb.Up = up;
+	vb.Color = ColorToABGR( color );
+	vb.Billboard = parms.Billboard;
+	vb.TrackRoll = parms.TrackRoll;
 }
 
 //==============================
@@ -1643,27 +2185,9 @@ void BitmapFontSurfaceLocal::DrawTextBillboarded3Df( BitmapFont const & font, fo
 }
 
 
-//==============================================================
-// vbSort_t
-// small structure that is used to sort vertex blocks by their distance to the camera
-//==============================================================
-struct vbSort_t 
-{
-	int		VertexBlockIndex;
-	float	DistanceSquared;
-};
-
-//==============================
-// VertexBlockSortFn
-// sort function for vertex blocks
-int VertexBlockSortFn( void const * a, void const * b )
-{
-	return ftoi( ((vbSort_t const*)a)->DistanceSquared - ((vbSort_t const*)b)->DistanceSquared );
-}
-
 //==============================
 // BitmapFontSurfaceLocal::Finish
-// transform all vertex blocks into the vertices array so they're ready to be uploaded to the VBO
+// transform all vertex blocks straight into the VBO
 // We don't have to do this for each eye because the billboarded surfaces are sorted / aligned
 // based on their distance from / direction to the camera view position and not the camera direction.
 void BitmapFontSurfaceLocal::Finish( Matrix4f const & viewMatrix )
@@ -1676,32 +2200,73 @@ void BitmapFontSurfaceLocal::Finish( Matrix4f const & viewMatrix )
 	Vector3f viewPos = invViewMatrix.GetTranslation();
 
 	// sort vertex blocks indices based on distance to pivot
-	int const MAX_VERTEX_BLOCKS = 256;
-	vbSort_t vbSort[MAX_VERTEX_BLOCKS];
 	int const n = VertexBlocks.GetSizeI();
+	SortBlocks.Resize( n );
+	SortScratch.Resize( n );
+	int numVertices = 0;
 	for ( int i = 0; i < n; ++i )
 	{
-		vbSort[i].VertexBlockIndex = i;
-		VertexBlockType & vb = VertexBlocks[i];
-		vbSort[i].DistanceSquared = ( vb.Pivot - viewPos ).LengthSq();
+		VertexBlockType const & vb = VertexBlocks[i];
+		// squared distances are never negative, so the float bits sort as unsigned integers
+		union { float f; UInt32 u; } distance;
+		distance.f = ( vb.Pivot - viewPos ).LengthSq();
+		SortBlocks[i].DistanceKey = distance.u;
+		SortBlocks[i].VertexBlockIndex = i;
+		numVertices += vb.Layout->Verts.GetSizeI();
 	}
 
-	qsort( vbSort, n, sizeof( vbSort[0] ), VertexBlockSortFn );
+	vbSort_t const * vbSort = RadixSortVertexBlocks( SortBlocks.GetDataPtr(), SortScratch.GetDataPtr(), n );
+
+	// grow the VBO if the text drawn this frame doesn't fit, up to what 16 bit indices can address
+	int const MAX_SURFACE_VERTICES = 65536;
+	if ( numVertices > MaxVertices && MaxVertices < MAX_SURFACE_VERTICES )
+	{
+		int newMaxVertices = MaxVertices;
+		while ( newMaxVertices < numVertices && newMaxVertices < MAX_SURFACE_VERTICES )
+		{
+			newMaxVertices = Alg::Max( newMaxVertices * 2, 1024 );
+		}
+		MaxVertices = Alg::Min( newMaxVertices, MAX_SURFACE_VERTICES );
+		MaxIndices = ( MaxVertices / 4 ) * 6;
+		LOG( "BitmapFontSurfaceLocal::Finish: growing to %i vertices", MaxVertices );
+
+		Geo.Free();
+		Geo = FontGeometry( MaxVertices / 4 );
+	}
 
 	// transform the vertex blocks into the vertices array
 	CurIndex = 0;
 	CurVertex = 0;
 
+	fontVertex_t * vertices = NULL;
+	if ( n > 0 )
+	{
+		glBindBuffer( GL_ARRAY_BUFFER, Geo.vertexBuffer );
+		vertices = (fontVertex_t *)glMapBufferRange( GL_ARRAY_BUFFER, 0, MaxVertices * sizeof( fontVertex_t ),
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+		// this can happen after GPU resets
+		OVR_ASSERT( vertices != NULL );
+	}
+
 	// TODO:
 	// To add multiple-font-per-surface support, we need to add a 3rd component to s and t, 
 	// then get the font for each vertex block, and set the texture index on each vertex in 
 	// the third texture coordinate.
-	for ( int i = 0; i < VertexBlocks.GetSizeI(); ++i )
+	for ( int i = 0; i < n && vertices != NULL; ++i )
 	{		
-		VertexBlockType & vb = VertexBlocks[vbSort[i].VertexBlockIndex];
-		Matrix4f transform;
+		VertexBlockType const & vb = VertexBlocks[vbSort[i].VertexBlockIndex];
+		int const numVerts = vb.Layout->Verts.GetSizeI();
+		if ( CurVertex + numVerts > MaxVertices )
+		{
+			WARN( "BitmapFontSurfaceLocal::Finish: dropped %i vertex blocks that don't fit in %i vertices", n - i, MaxVertices );
+			break;
+		}
+
+		Vector3f axisX;
+		Vector3f axisY;
 		if ( vb.Billboard )
 		{
+			Matrix4f transform;
 			if ( vb.TrackRoll )
 			{
 				transform = invViewMatrix;
@@ -1712,45 +2277,49 @@ void BitmapFontSurfaceLocal::Finish( Matrix4f const & viewMatrix )
 				float const len = textNormal.Length();
 				if ( len < Mathf::SmallestNonDenormal )
 				{
-					vb.Free();
 					continue;
 				}
                 textNormal *= 1.0f / len;
                 transform = Matrix4f::CreateFromBasisVectors( textNormal, Vector3f( 0.0f, 1.0f, 0.0f ) );
 			}
-			transform.SetTranslation( vb.Pivot );
+			axisX = Vector3f( transform.M[0][0], transform.M[1][0], transform.M[2][0] );
+			axisY = Vector3f( transform.M[0][1], transform.M[1][1], transform.M[2][1] );
 		}
 		else
 		{
-			transform.SetIdentity();
-			transform.SetTranslation( vb.Pivot );
+			axisX = vb.Right;
+			axisY = vb.Up;
 		}
 
-		for ( int j = 0; j < vb.NumVerts; j++ )
-		{
-			fontVertex_t const & v = vb.Verts[j];
-			Vertices[CurVertex].xyz = transform.Transform( v.xyz );
-			Vertices[CurVertex].s = v.s;
-			Vertices[CurVertex].t = v.t;			
-			*(UInt32*)(&Vertices[CurVertex].rgba[0]) = *(UInt32*)(&v.rgba[0]);
-			*(UInt32*)(&Vertices[CurVertex].fontParms[0]) = *(UInt32*)(&v.fontParms[0]);
-			CurVertex++;
-		}
-		CurIndex += ( vb.NumVerts / 2 ) * 3;
-		// free this vertex block
-		vb.Free();
+		TransformTextLayout( *vb.Layout, vb.Pivot, axisX, axisY, vb.Color, &vertices[CurVertex] );
+		CurVertex += numVerts;
+		CurIndex += ( numVerts / 2 ) * 3;
+	}
+
+	if ( vertices != NULL )
+	{
+		glUnmapBuffer( GL_ARRAY_BUFFER );
 	}
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
 	// remove all elements from the vertex block (but don't free the memory since it's likely to be 
 	// needed on the next frame.
 	VertexBlocks.Clear();
 
-	glBindVertexArray( Geo.vertexArrayObject );
-	glBindBuffer( GL_ARRAY_BUFFER, Geo.vertexBuffer );
-	glBufferSubData( GL_ARRAY_BUFFER, 0, CurVertex * sizeof( fontVertex_t ), (void *)Vertices );
-	glBindVertexArray( 0 );	
+	// the layouts are no longer referenced
+	LayoutCache.EndFrame();
+
 	Geo.indexCount = CurIndex;
 }
 
+//==============================
+// BitmapFontSurfaceLocal::GetLayoutCacheCounts
+void BitmapFontSurfaceLocal::GetLayoutCacheCounts( int & hits, int & misses ) const
+{
+	hits = LayoutCache.GetHits();
+	misses = LayoutCache.GetMisses();
+}
+
 //==============================
 // BitmapFontSurfaceLocal::Render3D
 // render the font surface by transforming each vertex block and copying it into the VBO
@@ -1812,6 +2381,19 @@ void BitmapFont::Free( BitmapFont * & font )
 	}
 }
 
+//==============================
+// BitmapFont::ConvertFontInfo
+bool BitmapFont::ConvertFontInfo( ovrFileSys & fileSys, char const * jsonUri, char const * binaryFileName )
+{
+	FontInfoType fontInfo;
+	if ( !fontInfo.Load( fileSys, jsonUri ) )
+	{
+		WARN( "BitmapFont::ConvertFontInfo: failed to load '%s'", jsonUri );
+		return false;
+	}
+	return fontInfo.SaveBinary( binaryFileName );
+}
+
 //==============================
 // BitmapFontSurface::Create
 BitmapFontSurface * BitmapFontSurface::Create()
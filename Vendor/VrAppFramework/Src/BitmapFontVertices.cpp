@@ -0,0 +1,134 @@
+/************************************************************************************
+
+Filename    :   BitmapFontVertices.cpp
+Content     :   Vertex transform and sorting for bitmap font surfaces.
+Created     :   March 11, 2014
+Authors     :   Jonathan E. Wright
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "BitmapFontVertices.h"
+
+#if defined( OVR_CPU_SSE )
+#include <xmmintrin.h>
+#elif defined( OVR_CPU_ARM_NEON )
+#include <arm_neon.h>
+#endif
+
+#include <stddef.h>
+#include <string.h>
+
+#include "Kernel/OVR_Alg.h"
+
+namespace OVR {
+
+//==============================
+// TransformTextVertices
+// Separate multiplies and adds, rather than fused ones, so the SIMD paths
+// produce exactly the same positions as the scalar path.
+void TransformTextVertices( textLayoutVertex_t const * v, int const numVerts, Vector3f const & origin,
+		Vector3f const & axisX, Vector3f const & axisY, UInt32 const color, UInt32 const fontParms,
+		fontVertex_t * verts )
+{
+	OVR_COMPILER_ASSERT( sizeof( textLayoutVertex_t ) == 4 * sizeof( float ) );
+	OVR_COMPILER_ASSERT( offsetof( fontVertex_t, s ) == 3 * sizeof( float ) );
+
+#if defined( OVR_CPU_SSE )
+	__m128 const o = _mm_setr_ps( origin.x, origin.y, origin.z, 0.0f );
+	__m128 const ax = _mm_setr_ps( axisX.x, axisX.y, axisX.z, 0.0f );
+	__m128 const ay = _mm_setr_ps( axisY.x, axisY.y, axisY.z, 0.0f );
+	for ( int i = 0; i < numVerts; i++ )
+	{
+		__m128 const xyst = _mm_loadu_ps( &v[i].x );
+		__m128 const x = _mm_shuffle_ps( xyst, xyst, _MM_SHUFFLE( 0, 0, 0, 0 ) );
+		__m128 const y = _mm_shuffle_ps( xyst, xyst, _MM_SHUFFLE( 1, 1, 1, 1 ) );
+		__m128 const p = _mm_add_ps( _mm_add_ps( o, _mm_mul_ps( ax, x ) ), _mm_mul_ps( ay, y ) );
+		// p.x, p.y, p.z, s
+		__m128 const zs = _mm_shuffle_ps( p, xyst, _MM_SHUFFLE( 2, 2, 2, 2 ) );
+		_mm_storeu_ps( &verts[i].xyz.x, _mm_shuffle_ps( p, zs, _MM_SHUFFLE( 2, 0, 1, 0 ) ) );
+		verts[i].t = v[i].t;
+		*(UInt32*)(&verts[i].rgba[0]) = color;
+		*(UInt32*)(&verts[i].fontParms[0]) = fontParms;
+	}
+#elif defined( OVR_CPU_ARM_NEON )
+	float32x4_t const o = { origin.x, origin.y, origin.z, 0.0f };
+	float32x4_t const ax = { axisX.x, axisX.y, axisX.z, 0.0f };
+	float32x4_t const ay = { axisY.x, axisY.y, axisY.z, 0.0f };
+	for ( int i = 0; i < numVerts; i++ )
+	{
+		float32x4_t const xyst = vld1q_f32( &v[i].x );
+		float32x2_t const xy = vget_low_f32( xyst );
+		float32x4_t p = vaddq_f32( vaddq_f32( o, vmulq_lane_f32( ax, xy, 0 ) ), vmulq_lane_f32( ay, xy, 1 ) );
+		// p.x, p.y, p.z, s
+		p = vsetq_lane_f32( vgetq_lane_f32( xyst, 2 ), p, 3 );
+		vst1q_f32( &verts[i].xyz.x, p );
+		verts[i].t = v[i].t;
+		*(UInt32*)(&verts[i].rgba[0]) = color;
+		*(UInt32*)(&verts[i].fontParms[0]) = fontParms;
+	}
+#else
+	for ( int i = 0; i < numVerts; i++ )
+	{
+		verts[i].xyz = origin + axisX * v[i].x + axisY * v[i].y;
+		verts[i].s = v[i].s;
+		verts[i].t = v[i].t;
+		*(UInt32*)(&verts[i].rgba[0]) = color;
+		*(UInt32*)(&verts[i].fontParms[0]) = fontParms;
+	}
+#endif
+}
+
+//==============================
+// RadixSortVertexBlocks
+// Least significant byte first radix sort on the distance key. Passes where every
+// key has the same byte are skipped, which is common for the high byte.
+vbSort_t * RadixSortVertexBlocks( vbSort_t * blocks, vbSort_t * scratch, int const count )
+{
+	if ( count <= 1 )
+	{
+		return blocks;
+	}
+
+	int histograms[4][256];
+	memset( histograms, 0, sizeof( histograms ) );
+	for ( int i = 0; i < count; i++ )
+	{
+		UInt32 const key = blocks[i].DistanceKey;
+		for ( int pass = 0; pass < 4; pass++ )
+		{
+			histograms[pass][( key >> ( pass * 8 ) ) & 255]++;
+		}
+	}
+
+	vbSort_t * src = blocks;
+	vbSort_t * dst = scratch;
+	for ( int pass = 0; pass < 4; pass++ )
+	{
+		int const shift = pass * 8;
+		int * histogram = histograms[pass];
+		if ( histogram[( src[0].DistanceKey >> shift ) & 255] == count )
+		{
+			continue;
+		}
+
+		int offset = 0;
+		for ( int i = 0; i < 256; i++ )
+		{
+			int const n = histogram[i];
+			histogram[i] = offset;
+			offset += n;
+		}
+
+		for ( int i = 0; i < count; i++ )
+		{
+			dst[histogram[( src[i].DistanceKey >> shift ) & 255]++] = src[i];
+		}
+
+		Alg::Swap( src, dst );
+	}
+	return src;
+}
+
+} // namespace OVR
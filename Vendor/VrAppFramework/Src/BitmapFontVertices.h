@@ -0,0 +1,67 @@
+/************************************************************************************
+
+Filename    :   BitmapFontVertices.h
+Content     :   Vertex transform and sorting for bitmap font surfaces.
+Created     :   March 11, 2014
+Authors     :   Jonathan E. Wright
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#if !defined( OVR_BitmapFontVertices_h )
+#define OVR_BitmapFontVertices_h
+
+#include "Kernel/OVR_Math.h"
+
+namespace OVR {
+
+// These do not touch GL, so they can be measured on their own.
+
+struct fontVertex_t {
+	fontVertex_t() :
+		xyz( 0.0f ),
+		s( 0.0f ),
+		t( 0.0f ),
+		rgba(),
+		fontParms() {
+	}
+
+	Vector3f	xyz;
+	float		s;
+	float		t;
+	UByte		rgba[4];
+	UByte		fontParms[4];
+};
+
+
+// A vertex of a text layout in the plane of the text.
+struct textLayoutVertex_t
+{
+	float	x;
+	float	y;
+	float	s;
+	float	t;
+};
+
+
+// small structure that is used to sort vertex blocks by their distance to the camera
+struct vbSort_t 
+{
+	UInt32	DistanceKey;	// bits of the squared distance, which sort like the float itself
+	int		VertexBlockIndex;
+};
+
+// Places the layout vertices in world space with their x and y axes along axisX and axisY.
+// The vertices are written in order, so verts can point to a mapped buffer.
+void		TransformTextVertices( textLayoutVertex_t const * v, int const numVerts, Vector3f const & origin,
+				Vector3f const & axisX, Vector3f const & axisY, UInt32 const color, UInt32 const fontParms,
+				fontVertex_t * verts );
+
+// Sorts the vertex blocks by increasing distance key, keeping the order of equal keys.
+// Returns either blocks or scratch, whichever holds the sorted result.
+vbSort_t *	RadixSortVertexBlocks( vbSort_t * blocks, vbSort_t * scratch, int const count );
+
+} // namespace OVR
+
+#endif // OVR_BitmapFontVertices_h
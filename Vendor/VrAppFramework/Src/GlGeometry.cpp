@@ -114,6 +114,143 @@ void GlGeometry::Update( const VertexAttribs & attribs )
 	glBufferData( GL_ARRAY_BUFFER, packed.GetSize() * sizeof( packed[0] ), packed.GetDataPtr(), GL_STATIC_DRAW );
 }
 
+struct vertexAttribPacking_t
+{
+	int		flag;
+	int		location;
+	int		glType;
+	int		glComponents;
+	size_t	size;
+};
+
+// Same order as the VertexAttribs members and the packing in GlGeometry::Create().
+static const vertexAttribPacking_t VertexAttribPacking[] =
+{
+	{ VERTEX_ATTRIB_FLAG_POSITION,		VERTEX_ATTRIBUTE_LOCATION_POSITION,			GL_FLOAT,	3,	sizeof( Vector3f ) },
+	{ VERTEX_ATTRIB_FLAG_NORMAL,		VERTEX_ATTRIBUTE_LOCATION_NORMAL,			GL_FLOAT,	3,	sizeof( Vector3f ) },
+	{ VERTEX_ATTRIB_FLAG_TANGENT,		VERTEX_ATTRIBUTE_LOCATION_TANGENT,			GL_FLOAT,	3,	sizeof( Vector3f ) },
+	{ VERTEX_ATTRIB_FLAG_BINORMAL,		VERTEX_ATTRIBUTE_LOCATION_BINORMAL,			GL_FLOAT,	3,	sizeof( Vector3f ) },
+	{ VERTEX_ATTRIB_FLAG_COLOR,			VERTEX_ATTRIBUTE_LOCATION_COLOR,			GL_FLOAT,	4,	sizeof( Vector4f ) },
+	{ VERTEX_ATTRIB_FLAG_UV0,			VERTEX_ATTRIBUTE_LOCATION_UV0,				GL_FLOAT,	2,	sizeof( Vector2f ) },
+	{ VERTEX_ATTRIB_FLAG_UV1,			VERTEX_ATTRIBUTE_LOCATION_UV1,				GL_FLOAT,	2,	sizeof( Vector2f ) },
+	{ VERTEX_ATTRIB_FLAG_JOINT_INDICES,	VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES,	GL_INT,		4,	sizeof( Vector4i ) },
+	{ VERTEX_ATTRIB_FLAG_JOINT_WEIGHTS,	VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS,	GL_FLOAT,	4,	sizeof( Vector4f ) }
+};
+
+static const int NUM_VERTEX_ATTRIBS = sizeof( VertexAttribPacking ) / sizeof( VertexAttribPacking[0] );
+
+// Same test as PackVertexAttribute above, so both paths enable the same attributes.
+template< typename _attrib_type_ >
+static int GetVertexAttribFlag( const Array< _attrib_type_ > & attrib, const int flag )
+{
+	return ( attrib.GetSize() > 0 ) ? flag : 0;
+}
+
+int GetVertexAttribFlags( const VertexAttribs & attribs )
+{
+	int flags = 0;
+	flags |= GetVertexAttribFlag( attribs.position,		VERTEX_ATTRIB_FLAG_POSITION );
+	flags |= GetVertexAttribFlag( attribs.normal,		VERTEX_ATTRIB_FLAG_NORMAL );
+	flags |= GetVertexAttribFlag( attribs.tangent,		VERTEX_ATTRIB_FLAG_TANGENT );
+	flags |= GetVertexAttribFlag( attribs.binormal,		VERTEX_ATTRIB_FLAG_BINORMAL );
+	flags |= GetVertexAttribFlag( attribs.color,		VERTEX_ATTRIB_FLAG_COLOR );
+	flags |= GetVertexAttribFlag( attribs.uv0,			VERTEX_ATTRIB_FLAG_UV0 );
+	flags |= GetVertexAttribFlag( attribs.uv1,			VERTEX_ATTRIB_FLAG_UV1 );
+	flags |= GetVertexAttribFlag( attribs.jointIndices,	VERTEX_ATTRIB_FLAG_JOINT_INDICES );
+	flags |= GetVertexAttribFlag( attribs.jointWeights,	VERTEX_ATTRIB_FLAG_JOINT_WEIGHTS );
+	return flags;
+}
+
+size_t GetPackedVertexSize( const int attribFlags )
+{
+	size_t size = 0;
+	for ( int i = 0; i < NUM_VERTEX_ATTRIBS; i++ )
+	{
+		if ( ( attribFlags & VertexAttribPacking[i].flag ) != 0 )
+		{
+			size += VertexAttribPacking[i].size;
+		}
+	}
+	return size;
+}
+
+// Every attribute is packed with one element per vertex, because GlGeometry::Create
+// with packed vertices finds the attributes from the vertex count.  An attribute
+// with the wrong number of elements is cut off or padded with zeros.
+template< typename _attrib_type_ >
+static void PackVertexAttribute( Array< uint8_t > & packed, const Array< _attrib_type_ > & attrib, const int numVertices )
+{
+	if ( attrib.GetSize() > 0 )
+	{
+		const size_t offset = packed.GetSize();
+		const size_t size = numVertices * sizeof( attrib[0] );
+		const size_t copy = Alg::Min( attrib.GetSize(), (UPInt)numVertices ) * sizeof( attrib[0] );
+
+		packed.Resize( offset + size );
+		uint8_t * dest = packed.GetDataPtr() + offset;
+		memcpy( dest, attrib.GetDataPtr(), copy );
+		memset( dest + copy, 0, size - copy );
+	}
+}
+
+void PackVertexAttribs( Array< uint8_t > & packed, const VertexAttribs & attribs )
+{
+	const int numVertices = attribs.position.GetSizeI();
+
+	packed.Clear();
+	packed.Reserve( numVertices * GetPackedVertexSize( GetVertexAttribFlags( attribs ) ) );
+	PackVertexAttribute( packed, attribs.position,		numVertices );
+	PackVertexAttribute( packed, attribs.normal,		numVertices );
+	PackVertexAttribute( packed, attribs.tangent,		numVertices );
+	PackVertexAttribute( packed, attribs.binormal,		numVertices );
+	PackVertexAttribute( packed, attribs.color,			numVertices );
+	PackVertexAttribute( packed, attribs.uv0,			numVertices );
+	PackVertexAttribute( packed, attribs.uv1,			numVertices );
+	PackVertexAttribute( packed, attribs.jointIndices,	numVertices );
+	PackVertexAttribute( packed, attribs.jointWeights,	numVertices );
+}
+
+void GlGeometry::Create( const int attribFlags, const int numVertices, const void * packedVertices,
+						const int numIndices, const TriangleIndex * indices )
+{
+	vertexCount = numVertices;
+	indexCount = numIndices;
+
+	glGenBuffers( 1, &vertexBuffer );
+	glGenBuffers( 1, &indexBuffer );
+	glGenVertexArrays( 1, &vertexArrayObject );
+	glBindVertexArray( vertexArrayObject );
+	glBindBuffer( GL_ARRAY_BUFFER, vertexBuffer );
+
+	size_t offset = 0;
+	for ( int i = 0; i < NUM_VERTEX_ATTRIBS; i++ )
+	{
+		const vertexAttribPacking_t & attrib = VertexAttribPacking[i];
+		if ( ( attribFlags & attrib.flag ) != 0 )
+		{
+			glEnableVertexAttribArray( attrib.location );
+			glVertexAttribPointer( attrib.location, attrib.glComponents, attrib.glType, false, attrib.size, (void *)( offset ) );
+			offset += numVertices * attrib.size;
+		}
+		else
+		{
+			glDisableVertexAttribArray( attrib.location );
+		}
+	}
+
+	glBufferData( GL_ARRAY_BUFFER, offset, packedVertices, GL_STATIC_DRAW );
+
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, indexBuffer );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof( indices[0] ), indices, GL_STATIC_DRAW );
+
+	glBindVertexArray( 0 );
+
+	for ( int i = 0; i < NUM_VERTEX_ATTRIBS; i++ )
+	{
+		glDisableVertexAttribArray( VertexAttribPacking[i].location );
+	}
+}
+
 void GlGeometry::Draw() const
 {
 	glBindVertexArray( vertexArrayObject );
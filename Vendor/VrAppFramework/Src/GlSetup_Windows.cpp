@@ -86,6 +86,15 @@ GlWindow_t glWindow;
 static const int	MIN_SLOTS_AVAILABLE_FOR_INPUT = 12;
 AppLocal * app;
 
+static void PostKeyMessage( ovrMessageQueue & queue, const ovrKeyCode key, const int down )
+{
+	ovrMessage msg( APP_MESSAGE_KEY );
+	msg.Int[0] = key;
+	msg.Int[1] = down;
+	msg.Int[2] = 0;
+	queue.PostIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, msg );
+}
+
 LRESULT APIENTRY WndProc( HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam )
 {
 	GlWindow_t * window = (GlWindow_t *) GetWindowLongPtr( hWnd, GWLP_USERDATA );
@@ -129,7 +138,7 @@ LRESULT APIENTRY WndProc( HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam
 				const ovrKeyCode key = OSKeyToKeyCode( (int)wParam );
 				if ( app && !window->keyInput[key] )
 				{
-					app->GetMessageQueue().PostPrintfIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, "key %i %i %i", key, 1, 0 );
+					PostKeyMessage( app->GetMessageQueue(), key, 1 );
 				}
 				window->keyInput[key] = true;
 				LOG( "%s down\n", GetNameForKeyCode( key ) );
@@ -145,7 +154,7 @@ LRESULT APIENTRY WndProc( HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam
 				LOG( "%s up\n", GetNameForKeyCode( key ) );
 				if ( app )
 				{
-					app->GetMessageQueue().PostPrintfIfSpaceAvailable( MIN_SLOTS_AVAILABLE_FOR_INPUT, "key %i %i %i", key, 0, 0 );
+					PostKeyMessage( app->GetMessageQueue(), key, 0 );
 				}
 			}
 			break;
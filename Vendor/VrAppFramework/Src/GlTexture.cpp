@@ -835,6 +835,14 @@ GlTexture LoadTextureFromOtherApplicationPackage( void * zipFile, const char * n
 		return GlTexture( 0 );
 	}
 
+	// Textures stored without compression are loaded straight from the mapped package.
+	const void *	mapped;
+	int				mappedLength;
+	if ( ovr_MapFileFromOtherApplicationPackage( zipFile, nameInZip, mappedLength, mapped ) )
+	{
+		return LoadTextureFromBuffer( nameInZip, MemBuffer( mapped, mappedLength ), flags, width, height );
+	}
+
 	void * 	buffer;
 	int		bufferLength;
 
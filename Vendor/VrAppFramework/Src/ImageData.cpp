@@ -15,6 +15,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "Kernel/OVR_Types.h"
 #include "Kernel/OVR_Alg.h"
@@ -66,6 +67,71 @@ void Write32BitPvrTexture( const char * fileName, const unsigned char * texture,
 	fclose( f );
 }
 
+unsigned char * Create32BitPvrTextureWithMipmaps( const unsigned char * texture, const int width, const int height,
+					const bool srgb, int & bufferSize )
+{
+	bufferSize = 0;
+
+	int mipCount = 1;
+	int dataSize = width * height * 4;
+	for ( int w = width, h = height; w > 1 || h > 1; mipCount++ )
+	{
+		w = OVR::Alg::Max( 1, w >> 1 );
+		h = OVR::Alg::Max( 1, h >> 1 );
+		dataSize += w * h * 4;
+	}
+
+	unsigned char * buffer = (unsigned char *)malloc( sizeof( OVR_PVR_HEADER ) + dataSize );
+	if ( buffer == NULL )
+	{
+		WARN( "Failed to allocate %i bytes for %ix%i pvr texture", (int)sizeof( OVR_PVR_HEADER ) + dataSize, width, height );
+		return NULL;
+	}
+
+	OVR_PVR_HEADER header = {};
+	header.Version = 0x03525650;				// 'PVR' + 0x3
+	header.PixelFormat = 578721384203708274llu;	// 8888 RGBA
+	header.Width = width;
+	header.Height = height;
+	header.Depth = 1;
+	header.NumSurfaces = 1;
+	header.NumFaces = 1;
+	header.MipMapCount = mipCount;
+	memcpy( buffer, &header, sizeof( header ) );
+
+	unsigned char * level = buffer + sizeof( OVR_PVR_HEADER );
+	memcpy( level, texture, width * height * 4 );
+
+	int w = width;
+	int h = height;
+	for ( int i = 1; i < mipCount; i++ )
+	{
+		const int newWidth = OVR::Alg::Max( 1, w >> 1 );
+		const int newHeight = OVR::Alg::Max( 1, h >> 1 );
+
+		// QuarterImageSize() reads 2x2 blocks, so the last levels of a
+		// non-square image, which are a single texel wide or high, are scaled.
+		unsigned char * mip = ( w > 1 && h > 1 ) ?
+				QuarterImageSize( level, w, h, srgb ) :
+				ScaleImageRGBA( level, w, h, newWidth, newHeight, IMAGE_FILTER_LINEAR, srgb );
+		if ( mip == NULL )
+		{
+			free( buffer );
+			return NULL;
+		}
+
+		level += w * h * 4;
+		memcpy( level, mip, newWidth * newHeight * 4 );
+		free( mip );
+
+		w = newWidth;
+		h = newHeight;
+	}
+
+	bufferSize = sizeof( OVR_PVR_HEADER ) + dataSize;
+	return buffer;
+}
+
 inline int AbsInt( const int x )
 {
 	const int mask = x >> ( sizeof( int )* 8 - 1 );
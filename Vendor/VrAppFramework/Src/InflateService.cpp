@@ -0,0 +1,287 @@
+/************************************************************************************
+
+Filename    :   InflateService.cpp
+Content     :   Parallel decompression of zip entries
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "InflateService.h"
+
+#include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_LogUtils.h"
+
+#include <zlib.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace OVR
+{
+
+// Entries up to this size are checked by the worker that inflated them.
+static const int INFLATE_CRC_CHUNK_SIZE		= 1024 * 1024;
+
+struct inflateBatch_t
+{
+	ovrInflateService *	service;
+	ovrInflateJob *		jobs;
+};
+
+struct crcChunks_t
+{
+	const uint8_t *		data;
+	int					size;
+	uLong *				crcs;
+};
+
+// Each pooled buffer starts with a header that holds its size class, which keeps the
+// data 16 byte aligned.
+static const int INFLATE_BUFFER_HEADER_SIZE	= 16;
+
+// Buffers smaller than this are not worth keeping apart.
+static const int INFLATE_MIN_SIZE_CLASS		= 12;
+
+ovrInflateBufferPool::ovrInflateBufferPool( const size_t maxBytes ) :
+	MaxBytes( maxBytes ),
+	FreeBytes( 0 )
+{
+}
+
+ovrInflateBufferPool::~ovrInflateBufferPool()
+{
+	for ( int i = 0; i < NUM_SIZE_CLASSES; i++ )
+	{
+		for ( int j = 0; j < FreeBuffers[i].GetSizeI(); j++ )
+		{
+			free( FreeBuffers[i][j] );
+		}
+	}
+}
+
+void * ovrInflateBufferPool::Alloc( const int size )
+{
+	const size_t totalSize = (size_t)Alg::Max( size, 0 ) + INFLATE_BUFFER_HEADER_SIZE;
+	int sizeClass = INFLATE_MIN_SIZE_CLASS;
+	while ( ( (size_t)1 << sizeClass ) < totalSize )
+	{
+		sizeClass++;
+	}
+	if ( sizeClass >= NUM_SIZE_CLASSES )
+	{
+		return NULL;
+	}
+
+	UByte * header = NULL;
+	{
+		Mutex::Locker locker( &Lock );
+		if ( FreeBuffers[sizeClass].GetSizeI() > 0 )
+		{
+			header = (UByte *)FreeBuffers[sizeClass].Back();
+			FreeBuffers[sizeClass].PopBack();
+			FreeBytes -= (size_t)1 << sizeClass;
+		}
+	}
+	if ( header == NULL )
+	{
+		header = (UByte *)malloc( (size_t)1 << sizeClass );
+		if ( header == NULL )
+		{
+			return NULL;
+		}
+	}
+	*(int *)header = sizeClass;
+	return header + INFLATE_BUFFER_HEADER_SIZE;
+}
+
+void ovrInflateBufferPool::Free( void * buffer )
+{
+	if ( buffer == NULL )
+	{
+		return;
+	}
+	UByte * header = (UByte *)buffer - INFLATE_BUFFER_HEADER_SIZE;
+	const int sizeClass = *(int *)header;
+	const size_t bytes = (size_t)1 << sizeClass;
+	{
+		Mutex::Locker locker( &Lock );
+		if ( FreeBytes + bytes <= MaxBytes )
+		{
+			FreeBuffers[sizeClass].PushBack( header );
+			FreeBytes += bytes;
+			return;
+		}
+	}
+	free( header );
+}
+
+ovrInflateService::ovrInflateService( const int numWorkers ) :
+	Jobs( numWorkers, JOB_CORES_ANY )
+{
+}
+
+bool ovrInflateService::Inflate( ovrInflateJob * jobs, const int numJobs )
+{
+	inflateBatch_t batch;
+	batch.service = this;
+	batch.jobs = jobs;
+
+	// One entry per job, the entries are usually few and of very different sizes.
+	Jobs.ParallelFor( numJobs, 1, InflateRange, &batch );
+
+	bool allValid = true;
+	for ( int i = 0; i < numJobs; i++ )
+	{
+		allValid &= jobs[i].Valid;
+	}
+	return allValid;
+}
+
+void ovrInflateService::InflateRange( void * data, const int begin, const int end )
+{
+	inflateBatch_t * batch = (inflateBatch_t *)data;
+	for ( int i = begin; i < end; i++ )
+	{
+		ovrInflateJob & job = batch->jobs[i];
+		const bool allocated = ( job.Buffer == NULL );
+		if ( allocated )
+		{
+			job.Buffer = ( job.Pool != NULL ) ? job.Pool->Alloc( job.Size ) : malloc( Alg::Max( job.Size, 1 ) );
+			if ( job.Buffer == NULL )
+			{
+				WARN( "ovrInflateService: failed to allocate %d bytes", job.Size );
+				job.Valid = false;
+				continue;
+			}
+		}
+
+		job.Valid = batch->service->InflateJob( job );
+
+		if ( !job.Valid && allocated )
+		{
+			if ( job.Pool != NULL )
+			{
+				job.Pool->Free( job.Buffer );
+			}
+			else
+			{
+				free( job.Buffer );
+			}
+			job.Buffer = NULL;
+		}
+	}
+}
+
+bool ovrInflateService::InflateJob( ovrInflateJob & job )
+{
+	if ( job.Method == 0 )
+	{
+		if ( job.CompressedSize != job.Size )
+		{
+			return false;
+		}
+		memcpy( job.Buffer, job.Compressed, job.Size );
+	}
+	else if ( job.Method == Z_DEFLATED )
+	{
+		z_stream stream;
+		memset( &stream, 0, sizeof( stream ) );
+
+		// zip entries are raw deflate streams without a zlib header
+		if ( inflateInit2( &stream, -MAX_WBITS ) != Z_OK )
+		{
+			return false;
+		}
+
+		stream.next_in = (Bytef *)job.Compressed;
+		stream.avail_in = job.CompressedSize;
+		stream.next_out = (Bytef *)job.Buffer;
+		stream.avail_out = job.Size;
+
+		const int result = inflate( &stream, Z_FINISH );
+		inflateEnd( &stream );
+
+		if ( result != Z_STREAM_END || (int)stream.total_out != job.Size )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		WARN( "ovrInflateService: unsupported compression method %d", job.Method );
+		return false;
+	}
+
+	if ( job.VerifyCrc )
+	{
+		const uint32_t crc = ComputeCrc( job.Buffer, job.Size );
+		if ( crc != job.Crc )
+		{
+			WARN( "ovrInflateService: CRC %08x != %08x", crc, job.Crc );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ovrInflateService::CrcRange( void * data, const int begin, const int end )
+{
+	crcChunks_t * chunks = (crcChunks_t *)data;
+	for ( int i = begin; i < end; i++ )
+	{
+		const int offset = i * INFLATE_CRC_CHUNK_SIZE;
+		const int size = Alg::Min( chunks->size - offset, INFLATE_CRC_CHUNK_SIZE );
+		chunks->crcs[i] = crc32( 0, chunks->data + offset, size );
+	}
+}
+
+uint32_t ovrInflateService::ComputeCrc( const void * data, const int size )
+{
+	const int numChunks = ( size + INFLATE_CRC_CHUNK_SIZE - 1 ) / INFLATE_CRC_CHUNK_SIZE;
+	if ( numChunks <= 1 )
+	{
+		return (uint32_t)crc32( 0, (const Bytef *)data, size );
+	}
+
+	ArrayPOD< uLong > crcs;
+	crcs.Resize( numChunks );
+
+	crcChunks_t chunks;
+	chunks.data = (const uint8_t *)data;
+	chunks.size = size;
+	chunks.crcs = crcs.GetDataPtr();
+
+	Jobs.ParallelFor( numChunks, 1, CrcRange, &chunks );
+
+	uLong crc = crcs[0];
+	for ( int i = 1; i < numChunks; i++ )
+	{
+		const int chunkSize = Alg::Min( size - i * INFLATE_CRC_CHUNK_SIZE, INFLATE_CRC_CHUNK_SIZE );
+		crc = crc32_combine( crc, crcs[i], chunkSize );
+	}
+	return (uint32_t)crc;
+}
+
+static int InflateServiceWorkers = 0;
+
+void ovr_SetInflateServiceWorkers( const int numWorkers )
+{
+	InflateServiceWorkers = numWorkers;
+}
+
+ovrInflateService & ovr_GetInflateService()
+{
+	static ovrInflateService service( InflateServiceWorkers );
+	return service;
+}
+
+ovrInflateBufferPool & ovr_GetInflateBufferPool()
+{
+	static ovrInflateBufferPool pool;
+	return pool;
+}
+
+}	// namespace OVR
@@ -12,6 +12,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "Input.h"
 
 #include "Kernel/OVR_LogUtils.h"
+#include "Kernel/OVR_JSON.h"
 #if defined( OVR_OS_ANDROID )
 #include <android/keycodes.h>
 #else
@@ -707,4 +708,112 @@ ovrKeyCode OSKeyToKeyCode( int const osKey )
 	return keyCode;
 }
 
+//==============================
+// ClassifyAppEvent
+static ovrAppEventType ClassifyAppEvent( char const * json )
+{
+	ovrAppEventType type = APP_EVENT_OTHER;
+	JSON * jsonObj = JSON::Parse( json );
+	if ( jsonObj == NULL )
+	{
+		WARN( "ClassifyAppEvent: failed to parse '%s'", json );
+		return type;
+	}
+	const JSON * command = jsonObj->GetItemByName( "Command" );
+	if ( command != NULL )
+	{
+		char const * commandStr = command->GetStringValue().ToCStr();
+		if ( OVR_stricmp( commandStr, SYSTEM_ACTIVITY_EVENT_REORIENT ) == 0 )
+		{
+			type = APP_EVENT_REORIENT;
+		}
+		else if ( OVR_stricmp( commandStr, SYSTEM_ACTIVITY_EVENT_RETURN_TO_LAUNCHER ) == 0 )
+		{
+			type = APP_EVENT_RETURN_TO_LAUNCHER;
+		}
+		else if ( OVR_stricmp( commandStr, SYSTEM_ACTIVITY_EVENT_EXIT_TO_HOME ) == 0 )
+		{
+			type = APP_EVENT_EXIT_TO_HOME;
+		}
+	}
+	jsonObj->Release();
+	return type;
+}
+
+//==============================
+// ovrAppEventList::Init
+void ovrAppEventList::Init( SystemActivitiesAppEventList_t * jsonEvents )
+{
+	JsonEvents = jsonEvents;
+	NumEvents = 0;
+	for ( int i = 0; i < jsonEvents->NumEvents; ++i )
+	{
+		Events[NumEvents].Type = ClassifyAppEvent( jsonEvents->Events[i] );
+		Events[NumEvents].Json = jsonEvents->Events[i];
+		NumEvents++;
+	}
+}
+
+//==============================
+// ovrAppEventList::Append
+bool ovrAppEventList::Append( ovrAppEventType const type, char const * json )
+{
+	OVR_ASSERT( JsonEvents != NULL );
+	if ( !SystemActivities_AppendAppEvent( JsonEvents, json ) )
+	{
+		return false;
+	}
+	// the JSON list keeps its own copy of the event
+	Events[NumEvents].Type = type;
+	Events[NumEvents].Json = JsonEvents->Events[JsonEvents->NumEvents - 1];
+	NumEvents++;
+	return true;
+}
+
+//==============================
+// ovrAppEventList::FindJsonEvent
+int ovrAppEventList::FindJsonEvent( char const * json ) const
+{
+	for ( int i = 0; i < JsonEvents->NumEvents; ++i )
+	{
+		if ( JsonEvents->Events[i] == json )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+//==============================
+// ovrAppEventList::Remove
+void ovrAppEventList::Remove( int const index )
+{
+	OVR_ASSERT( index >= 0 && index < NumEvents );
+	int const jsonIndex = FindJsonEvent( Events[index].Json );
+	if ( jsonIndex >= 0 )
+	{
+		SystemActivities_RemoveAppEvent( JsonEvents, jsonIndex );
+	}
+	for ( int i = index + 1; i < NumEvents; ++i )
+	{
+		Events[i - 1] = Events[i];
+	}
+	NumEvents--;
+}
+
+//==============================
+// ovrAppEventList::Sync
+void ovrAppEventList::Sync()
+{
+	int numEvents = 0;
+	for ( int i = 0; i < NumEvents; ++i )
+	{
+		if ( FindJsonEvent( Events[i].Json ) >= 0 )
+		{
+			Events[numEvents++] = Events[i];
+		}
+	}
+	NumEvents = numEvents;
+}
+
 } // namespace OVR
\ No newline at end of file
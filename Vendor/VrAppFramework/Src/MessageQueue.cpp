@@ -1,7 +1,7 @@
 /************************************************************************************
 
 Filename    :   MessageQueue.cpp
-Content     :   Thread communication by string commands
+Content     :   Thread communication by typed messages and string commands
 Created     :   October 15, 2013
 Authors     :   John Carmack
 
@@ -14,6 +14,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "Kernel/OVR_LogUtils.h"
 
@@ -22,38 +23,64 @@ namespace OVR
 
 bool ovrMessageQueue::debug = false;
 
+static int RoundUpToPowerOfTwo( const int value )
+{
+	int rounded = 2;
+	while ( rounded < value )
+	{
+		rounded <<= 1;
+	}
+	return rounded;
+}
+
 ovrMessageQueue::ovrMessageQueue( int maxMessages_ ) :
 	shutdown( false ),
-	maxMessages( maxMessages_ ),
-	messages( new message_t[ maxMessages_ ] ),
+	maxMessages( RoundUpToPowerOfTwo( maxMessages_ ) ),
+	messages( NULL ),
 	head( 0 ),
-	tail( 0 ),
-	synced( false )
+	blobs( new UByte[MESSAGE_NUM_BLOBS * MESSAGE_BLOB_SIZE] ),
+	currentBlob( NULL ),
+	currentBlobIndex( -1 ),
+	synced( false ),
+	syncedPosition( 0 ),
+	processedPosition( 0 )
 {
-	assert( maxMessages > 0 );
+	assert( maxMessages_ > 0 );
+	OVR_COMPILER_ASSERT( MESSAGE_NUM_BLOBS <= 32 );
 
+	messages = new message_t[maxMessages];
 	for ( int i = 0; i < maxMessages; i++ )
 	{
-		messages[i].string = NULL;
+		messages[i].sequence.Store_Release( i );
+		messages[i].blob = -1;
 		messages[i].synced = false;
 	}
+
+	tail.Store_Release( 0 );
+	freeBlobs.Store_Release( ( MESSAGE_NUM_BLOBS < 32 ) ? ( ( 1u << MESSAGE_NUM_BLOBS ) - 1 ) : 0xFFFFFFFF );
+	sleeping.Store_Release( 0 );
 }
 
 ovrMessageQueue::~ovrMessageQueue()
 {
 	// Free any messages remaining on the queue.
-	for ( ; ; )
+	ovrMessage msg;
+	while ( GetNextMessage( msg ) )
 	{
-		const char * msg = GetNextMessage();
-		if ( !msg ) {
-			break;
+		if ( msg.Opcode == MESSAGE_STRING )
+		{
+			LOG( "%p:~ovrMessageQueue: still on queue: %s", this, (const char *)msg.Blob );
+		}
+		else
+		{
+			LOG( "%p:~ovrMessageQueue: still on queue: opcode %i", this, msg.Opcode );
 		}
-		LOG( "%p:~ovrMessageQueue: still on queue: %s", this, msg );
-		free( (void *)msg );
 	}
+	FreeCurrentBlob();
 
 	// Free the queue itself.
 	delete[] messages;
+	delete[] blobs;
 }
 
 void ovrMessageQueue::Shutdown()
@@ -62,55 +89,198 @@ void ovrMessageQueue::Shutdown()
 	shutdown = true;
 }
 
+// Claims a free blob from the pool, or returns -1 if the pool is empty.
+int ovrMessageQueue::AllocBlob()
+{
+	for ( ; ; )
+	{
+		const UInt32 free = freeBlobs.Load_Acquire();
+		if ( free == 0 )
+		{
+			return -1;
+		}
+		int index = 0;
+		while ( ( free & ( 1u << index ) ) == 0 )
+		{
+			index++;
+		}
+		if ( freeBlobs.CompareAndSet_Sync( free, free & ~( 1u << index ) ) )
+		{
+			return index;
+		}
+	}
+}
+
+void ovrMessageQueue::FreeBlob( const int index )
+{
+	// The bit is known to be clear so adding it cannot carry.
+	freeBlobs.ExchangeAdd_Sync( 1u << index );
+}
+
+void ovrMessageQueue::FreeCurrentBlob()
+{
+	if ( currentBlobIndex >= 0 )
+	{
+		FreeBlob( currentBlobIndex );
+	}
+	else if ( currentBlob != NULL )
+	{
+		free( (void *)currentBlob );
+	}
+	currentBlob = NULL;
+	currentBlobIndex = -1;
+}
+
+bool ovrMessageQueue::HasMessage() const
+{
+	const message_t & m = messages[head & ( maxMessages - 1 )];
+	return ( m.sequence.Load_Acquire() == head + 1 );
+}
+
 // Thread safe, callable by any thread.
-// The msg text is copied off before return, the caller can free
+// The msg blob is copied off before return, the caller can free
 // the buffer.
 // The app will abort() with a dump of all messages if the message
 // buffer overflows.
-bool ovrMessageQueue::PostMessage( const char * msg, bool sync, bool abortIfFull )
+bool ovrMessageQueue::PostMessage( const ovrMessage & msg, bool sync, bool abortIfFull )
 {
 	if ( shutdown )
 	{
-		LOG( "%p:PostMessage( %s ) to shutdown queue", this, msg );
+		LOG( "%p:PostMessage( %i ) to shutdown queue", this, msg.Opcode );
 		return false;
 	}
 	if ( debug )
 	{
-		LOG( "%p:PostMessage( %s )", this, msg );
+		LOG( "%p:PostMessage( %i )", this, msg.Opcode );
 	}
 
-	mutex.DoLock();
-	if ( tail - head >= maxMessages )
+	// Claim a slot.
+	UInt32 position = tail.Load_Acquire();
+	message_t * m = NULL;
+	for ( ; ; )
 	{
-		mutex.Unlock();
-		if ( abortIfFull )
+		m = &messages[position & ( maxMessages - 1 )];
+		const int diff = (int)( m->sequence.Load_Acquire() - position );
+		if ( diff == 0 )
 		{
-			LOG( "ovrMessageQueue overflow" );
-			for ( int i = head; i < tail; i++ )
+			if ( tail.CompareAndSet_Sync( position, position + 1 ) )
 			{
-				LOG( "%s", messages[i % maxMessages].string );
+				break;
 			}
-			FAIL( "Message buffer overflowed" );
 		}
-		return false;
+		else if ( diff < 0 )
+		{
+			if ( abortIfFull )
+			{
+				LOG( "ovrMessageQueue overflow" );
+				for ( UInt32 i = head; i != position; i++ )
+				{
+					const message_t & pending = messages[i & ( maxMessages - 1 )];
+					if ( pending.sequence.Load_Acquire() == i + 1 )
+					{
+						LOG( "%i %s", pending.msg.Opcode, ( pending.msg.Opcode == MESSAGE_STRING ) ? (const char *)pending.msg.Blob : "" );
+					}
+				}
+				FAIL( "Message buffer overflowed" );
+			}
+			return false;
+		}
+		position = tail.Load_Acquire();
 	}
-	const int index = tail % maxMessages;
-	messages[index].string = strdup( msg );
-	messages[index].synced = sync;
-	tail++;
-	posted.NotifyAll();
+
+	// Fill in the slot.
+	m->msg = msg;
+	m->blob = -1;
+	m->synced = sync;
+	if ( msg.Blob != NULL && msg.BlobSize > 0 )
+	{
+		void * blob = NULL;
+		if ( msg.BlobSize <= MESSAGE_BLOB_SIZE )
+		{
+			m->blob = AllocBlob();
+		}
+		if ( m->blob >= 0 )
+		{
+			blob = blobs + m->blob * MESSAGE_BLOB_SIZE;
+		}
+		else
+		{
+			blob = malloc( msg.BlobSize );
+		}
+		memcpy( blob, msg.Blob, msg.BlobSize );
+		m->msg.Blob = blob;
+	}
+	else
+	{
+		m->msg.Blob = NULL;
+		m->msg.BlobSize = 0;
+	}
+
+	// Publish the slot.
+	m->sequence.Store_Release( position + 1 );
+
+	// The read-modify-write orders the publish before the check for a sleeping consumer.
+	if ( sleeping.ExchangeAdd_Sync( 0 ) != 0 )
+	{
+		mutex.DoLock();
+		posted.NotifyAll();
+		mutex.Unlock();
+	}
+
 	if ( sync )
 	{
-		processed.Wait( &mutex );
+		mutex.DoLock();
+		while ( (int)( processedPosition - ( position + 1 ) ) < 0 )
+		{
+			processed.Wait( &mutex );
+		}
+		mutex.Unlock();
 	}
-	mutex.Unlock();
 
 	return true;
 }
 
-void ovrMessageQueue::PostString( const char * msg )
+bool ovrMessageQueue::PostMessageString( const char * msg, bool sync, bool abortIfFull )
+{
+	ovrMessage message( MESSAGE_STRING );
+	message.Blob = msg;
+	message.BlobSize = (int)strlen( msg ) + 1;
+	return PostMessage( message, sync, abortIfFull );
+}
+
+void ovrMessageQueue::Post( const ovrMessage & msg )
+{
+	PostMessage( msg, false, true );
+}
+
+bool ovrMessageQueue::PostIfSpaceAvailable( const int requiredSpace, const ovrMessage & msg )
 {
+	if ( SpaceAvailable() < requiredSpace )
+	{
+		return false;
+	}
 	PostMessage( msg, false, true );
+	return true;
+}
+
+bool ovrMessageQueue::TryPost( const ovrMessage & msg )
+{
+	return PostMessage( msg, false, false );
+}
+
+void ovrMessageQueue::Send( const ovrMessage & msg )
+{
+	PostMessage( msg, true, true );
+}
+
+bool ovrMessageQueue::TrySend( const ovrMessage & msg )
+{
+	return PostMessage( msg, true, false );
+}
+
+void ovrMessageQueue::PostString( const char * msg )
+{
+	PostMessageString( msg, false, true );
 }
 
 void ovrMessageQueue::PostPrintf( const char * fmt, ... )
@@ -120,7 +290,7 @@ void ovrMessageQueue::PostPrintf( const char * fmt, ... )
 	va_start( args, fmt );
 	vsnprintf( bigBuffer, sizeof( bigBuffer ), fmt, args );
 	va_end( args );
-	PostMessage( bigBuffer, false, true );
+	PostMessageString( bigBuffer, false, true );
 }
 
 bool ovrMessageQueue::PostPrintfIfSpaceAvailable( const int requiredSpace, const char * fmt, ... )
@@ -134,13 +304,13 @@ bool ovrMessageQueue::PostPrintfIfSpaceAvailable( const int requiredSpace, const
 	va_start( args, fmt );
 	vsnprintf( bigBuffer, sizeof( bigBuffer ), fmt, args );
 	va_end( args );
-	PostMessage( bigBuffer, false, true );
+	PostMessageString( bigBuffer, false, true );
 	return true;
 }
 
 bool ovrMessageQueue::TryPostString( const char * msg )
 {
-	return PostMessage( msg, false, false );
+	return PostMessageString( msg, false, false );
 }
 
 bool ovrMessageQueue::TryPostPrintf( const char * fmt, ... )
@@ -150,12 +320,12 @@ bool ovrMessageQueue::TryPostPrintf( const char * fmt, ... )
 	va_start( args, fmt );
 	vsnprintf( bigBuffer, sizeof( bigBuffer ), fmt, args );
 	va_end( args );
-	return PostMessage( bigBuffer, false, false );
+	return PostMessageString( bigBuffer, false, false );
 }
 
 void ovrMessageQueue::SendString( const char * msg )
 {
-	PostMessage( msg, true, true );
+	PostMessageString( msg, true, true );
 }
 
 void ovrMessageQueue::SendPrintf( const char * fmt, ... )
@@ -165,36 +335,69 @@ void ovrMessageQueue::SendPrintf( const char * fmt, ... )
 	va_start( args, fmt );
 	vsnprintf( bigBuffer, sizeof( bigBuffer ), fmt, args );
 	va_end( args );
-	PostMessage( bigBuffer, true, true );
+	PostMessageString( bigBuffer, true, true );
 }
 
-// Returns false if there are no more messages, otherwise returns
-// a string that the caller must free.
-const char * ovrMessageQueue::GetNextMessage()
+// Returns false if there are no more messages.
+bool ovrMessageQueue::GetNextMessage( ovrMessage & msg )
 {
 	NotifyMessageProcessed();
+	FreeCurrentBlob();
 
-	mutex.DoLock();
-	if ( tail <= head )
+	if ( !HasMessage() )
 	{
-		mutex.Unlock();
-		return NULL;
+		return false;
 	}
 
-	const int index = head % maxMessages;
-	const char * msg = messages[index].string;
-	synced = messages[index].synced;
-	messages[index].string = NULL;
-	messages[index].synced = false;
-	head++;
-	mutex.Unlock();
+	message_t & m = messages[head & ( maxMessages - 1 )];
+	msg = m.msg;
+	currentBlob = m.msg.Blob;
+	currentBlobIndex = m.blob;
+	if ( m.synced )
+	{
+		synced = true;
+		syncedPosition = head + 1;
+	}
+
+	// Release the slot to the producers.
+	m.sequence.Store_Release( head + maxMessages );
+	head = head + 1;
 
 	if ( debug )
 	{
-		LOG( "%p:GetNextMessage() : %s", this, msg );
+		LOG( "%p:GetNextMessage() : %i", this, msg.Opcode );
 	}
 
-	return msg;
+	return true;
+}
+
+// Returns NULL if there are no more messages, otherwise returns
+// a string that the caller must free.
+const char * ovrMessageQueue::GetNextMessage()
+{
+	ovrMessage msg;
+	while ( GetNextMessage( msg ) )
+	{
+		if ( msg.Opcode != MESSAGE_STRING )
+		{
+			WARN( "%p:GetNextMessage() : discarding opcode %i", this, msg.Opcode );
+			continue;
+		}
+
+		if ( debug )
+		{
+			LOG( "%p:GetNextMessage() : %s", this, (const char *)msg.Blob );
+		}
+
+		// Hand heap blobs over to the caller.
+		if ( currentBlobIndex < 0 )
+		{
+			currentBlob = NULL;
+			return (const char *)msg.Blob;
+		}
+		return strdup( (const char *)msg.Blob );
+	}
+	return NULL;
 }
 
 // Returns immediately if there is already a message in the queue.
@@ -203,8 +406,11 @@ void ovrMessageQueue::SleepUntilMessage()
 	NotifyMessageProcessed();
 
 	mutex.DoLock();
-	if ( tail > head )
+	// The read-modify-write orders the flag before the check for a message.
+	sleeping.Exchange_Sync( 1 );
+	if ( HasMessage() )
 	{
+		sleeping.Store_Release( 0 );
 		mutex.Unlock();
 		return;
 	}
@@ -215,6 +421,7 @@ void ovrMessageQueue::SleepUntilMessage()
 	}
 
 	posted.Wait( & mutex );
+	sleeping.Store_Release( 0 );
 	mutex.Unlock();
 
 	if ( debug )
@@ -227,7 +434,10 @@ void ovrMessageQueue::NotifyMessageProcessed()
 {
 	if ( synced )
 	{
+		mutex.DoLock();
+		processedPosition = syncedPosition;
 		processed.NotifyAll();
+		mutex.Unlock();
 		synced = false;
 	}
 }
@@ -238,11 +448,19 @@ void ovrMessageQueue::ClearMessages()
 	{
 		LOG( "%p:ClearMessages()", this );
 	}
-	for ( const char * msg = GetNextMessage(); msg != NULL; msg = GetNextMessage() )
+	ovrMessage msg;
+	while ( GetNextMessage( msg ) )
 	{
-		LOG( "%p:ClearMessages: discarding %s", this, msg );
-		free( (void *)msg );
+		if ( msg.Opcode == MESSAGE_STRING )
+		{
+			LOG( "%p:ClearMessages: discarding %s", this, (const char *)msg.Blob );
+		}
+		else
+		{
+			LOG( "%p:ClearMessages: discarding opcode %i", this, msg.Opcode );
+		}
 	}
+	FreeCurrentBlob();
 }
 
 }	// namespace OVR
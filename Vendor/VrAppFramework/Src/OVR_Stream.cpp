@@ -220,6 +220,13 @@ size_t ovrStream::Length() const
 	return Length_Internal();
 }
 
+//==============================
+// ovrStream::AtEnd
+bool ovrStream::AtEnd() const
+{
+	return AtEnd_Internal();
+}
+
 //==============================
 // ovrStream::GetUri
 char const * ovrStream::GetUri() const 
@@ -234,6 +241,48 @@ bool ovrStream::IsOpen() const
 	return Mode != OVR_STREAM_MODE_MAX;
 }
 
+//==============================================================================================
+// ovrJsonStreamSource
+//==============================================================================================
+
+//==============================
+// ovrJsonStreamSource::ovrJsonStreamSource
+ovrJsonStreamSource::ovrJsonStreamSource( ovrStream & stream, size_t const chunkSize )
+	: Stream( stream )
+	, Chunk( chunkSize )
+{
+}
+
+//==============================
+// ovrJsonStreamSource::Read
+int ovrJsonStreamSource::Read( uint8_t * buffer, int numBytes )
+{
+	if ( !Stream.IsOpen() )
+	{
+		return -1;
+	}
+
+	// only ask for what is left, so the stream does not report a short read at the end
+	const size_t remaining = Stream.Length() - Stream.Tell();
+	size_t count = ( (size_t)numBytes < Chunk.GetSize() ) ? (size_t)numBytes : Chunk.GetSize();
+	if ( count > remaining )
+	{
+		count = remaining;
+	}
+	if ( count == 0 )
+	{
+		return 0;
+	}
+
+	size_t bytesRead = 0;
+	if ( !Stream.Read( Chunk, count, bytesRead ) && bytesRead == 0 )
+	{
+		return -1;
+	}
+	memcpy( buffer, Chunk, bytesRead );
+	return (int)bytesRead;
+}
+
 //==============================================================================================
 // ovrUriScheme_File
 //==============================================================================================
@@ -501,14 +550,15 @@ void	ovrStream_File::Close_Internal()
 // ovrStream_File::Read_Internal
 bool ovrStream_File::Read_Internal( MemBufferT< uint8_t > & outBuffer, size_t const bytesToRead, size_t & outBytesRead )
 {
+	// Read single bytes so a short read at the end of the file still returns its count.
 	size_t numRead;
 #if defined( OVR_OS_ANDROID )
-	numRead = fread( outBuffer, bytesToRead, 1, F );
+	numRead = fread( outBuffer, 1, bytesToRead, F );
 #else
-	numRead = fread_s( outBuffer, outBuffer.GetSize(), bytesToRead, 1, F );
+	numRead = fread_s( outBuffer, outBuffer.GetSize(), 1, bytesToRead, F );
 #endif
-	outBytesRead = numRead * bytesToRead;
-	if ( numRead != 1 )
+	outBytesRead = numRead;
+	if ( numRead != bytesToRead )
 	{
 		LOG( "Tried to read %i bytes from file '%s', but only read %i bytes.", bytesToRead, Uri.ToCStr(), outBytesRead );
 		return false;
@@ -749,6 +799,9 @@ void ovrUriScheme_Apk::Shutdown_Internal()
 ovrStream_Apk::ovrStream_Apk( ovrUriScheme const & scheme )
 	: ovrStream( scheme )
 	, IsOpen( false )
+	, PackageFile( NULL )
+	, FileLength( 0 )
+	, FileOffset( 0 )
 {
 }
 
@@ -796,7 +849,11 @@ bool ovrStream_Apk::Open_Internal( char const * uri, ovrStreamMode const mode )
 
 	// inside of zip files, the leading slash will cause the file to not be found, so skip it
 	char const * pathStart = ( path[0] == '/' ) ? path + 1 : path;
-	IsOpen = ovr_OtherPackageFileExists( zipFile, pathStart );
+	int length = 0;
+	PackageFile = ovr_OpenFileFromOtherApplicationPackage( zipFile, pathStart, length );
+	FileLength = length;
+	FileOffset = 0;
+	IsOpen = ( PackageFile != NULL );
 	return IsOpen;
 }
 
@@ -804,6 +861,7 @@ bool ovrStream_Apk::Open_Internal( char const * uri, ovrStreamMode const mode )
 // ovrStream_Apk::Close_Internal
 void ovrStream_Apk::Close_Internal()
 {
+	ovr_ClosePackageFile( PackageFile );
 	IsOpen = false;
 }
 
@@ -811,8 +869,24 @@ void ovrStream_Apk::Close_Internal()
 // ovrStream_Apk::Read_Internal
 bool ovrStream_Apk::Read_Internal( MemBufferT< uint8_t > & outBuffer, size_t const bytesToRead, size_t & outBytesRead )
 {
-	OVR_ASSERT( false );	// TODO: cannot read partial files from an apk yet
-	return false;
+	outBytesRead = 0;
+	const size_t count = ( bytesToRead < outBuffer.GetSize() ) ? bytesToRead : outBuffer.GetSize();
+	while ( outBytesRead < count )
+	{
+		const int numRead = ovr_ReadFromPackageFile( PackageFile, (uint8_t *)outBuffer + outBytesRead, (int)( count - outBytesRead ) );
+		if ( numRead <= 0 )
+		{
+			break;
+		}
+		outBytesRead += numRead;
+	}
+	FileOffset += outBytesRead;
+	if ( outBytesRead != bytesToRead )
+	{
+		LOG( "Tried to read %i bytes from file '%s', but only read %i bytes.", (int)bytesToRead, GetUri(), (int)outBytesRead );
+		return false;
+	}
+	return true;
 }
 
 //==============================
@@ -862,24 +936,21 @@ bool ovrStream_Apk::Write_Internal( void const * inBuffer, size_t const bytesToW
 // ovrStream_Apk::Tell_Internal
 size_t ovrStream_Apk::Tell_Internal() const
 {
-	OVR_ASSERT( false );	// TODO: cannot read partial files from an apk yet
-	return 0;
+	return FileOffset;
 }
 
 //==============================
 // ovrStream_Apk::Length_Internal
 size_t ovrStream_Apk::Length_Internal() const
 {
-	OVR_ASSERT( false );	// TODO: cannot read partial files from an apk yet
-	return 0;
+	return FileLength;
 }
 
 //==============================
 // ovrStream_Apk::AtEnd_Internal
 bool ovrStream_Apk::AtEnd_Internal() const
 {
-	OVR_ASSERT( false );	// TODO: cannot read partial files from an apk yet
-	return true;
+	return FileOffset >= FileLength;
 }
 
 } // namespace OVR
\ No newline at end of file
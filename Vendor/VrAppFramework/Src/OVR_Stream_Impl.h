@@ -252,6 +252,9 @@ public:
 private:
 	String				HostName;
 	bool				IsOpen;
+	void *				PackageFile;	// the file is inflated as it is read
+	size_t				FileLength;
+	size_t				FileOffset;
 
 private:
 	virtual bool		Open_Internal( char const * uri, ovrStreamMode const mode ) OVR_OVERRIDE;
@@ -14,12 +14,17 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 
 #include "Kernel/OVR_LogUtils.h"
 #include "Kernel/OVR_String.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_MappedFile.h"
 
-#include "unzip.h"
+#include "InflateService.h"
+
+#include <zlib.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 namespace OVR
 {
@@ -32,6 +37,307 @@ const char *	ovr_GetApplicationPackageCachePath()
 	return CachePath;
 }
 
+//==============================================================
+// ovrPackage
+//
+// The package is mapped once and its central directory is parsed into a
+// hash table of entries when it is opened. After that the package is never
+// modified, so any number of threads can look up and read files at the same
+// time, each with its own inflate stream over the shared mapping.
+//==============================================================
+
+static const uint32_t ZIP_LOCAL_HEADER_SIGNATURE		= 0x04034b50;
+static const uint32_t ZIP_CENTRAL_HEADER_SIGNATURE		= 0x02014b50;
+static const uint32_t ZIP_END_SIGNATURE					= 0x06054b50;
+static const uint32_t ZIP64_END_LOCATOR_SIGNATURE		= 0x07064b50;
+static const uint32_t ZIP64_END_SIGNATURE				= 0x06064b50;
+static const int ZIP_LOCAL_HEADER_SIZE					= 30;
+static const int ZIP_CENTRAL_HEADER_SIZE				= 46;
+static const int ZIP_END_SIZE							= 22;
+static const int ZIP64_END_LOCATOR_SIZE					= 20;
+static const int ZIP64_END_SIZE							= 56;
+
+static inline uint32_t ReadU16( const uint8_t * p )
+{
+	return (uint32_t)p[0] | ( (uint32_t)p[1] << 8 );
+}
+
+static inline uint32_t ReadU32( const uint8_t * p )
+{
+	return (uint32_t)p[0] | ( (uint32_t)p[1] << 8 ) | ( (uint32_t)p[2] << 16 ) | ( (uint32_t)p[3] << 24 );
+}
+
+static inline uint64_t ReadU64( const uint8_t * p )
+{
+	return (uint64_t)ReadU32( p ) | ( (uint64_t)ReadU32( p + 4 ) << 32 );
+}
+
+// Names are looked up case insensitive, like unzLocateFile( zipFile, name, 2 ).
+static uint32_t HashEntryName( const char * name, const int length )
+{
+	uint32_t hash = 2166136261u;
+	for ( int i = 0; i < length; i++ )
+	{
+		hash = ( hash ^ (uint32_t)OVR_tolower( (unsigned char)name[i] ) ) * 16777619u;
+	}
+	return hash;
+}
+
+static bool EntryNamesEqual( const char * a, const char * b, const int length )
+{
+	for ( int i = 0; i < length; i++ )
+	{
+		if ( OVR_tolower( (unsigned char)a[i] ) != OVR_tolower( (unsigned char)b[i] ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+struct ovrPackageEntry
+{
+	uint32_t		Hash;
+	uint32_t		NameOffset;			// the name is not null-terminated in the central directory
+	int				NameLength;
+	int				Method;				// 0 = stored, Z_DEFLATED = deflated
+	uint32_t		Crc;
+	uint32_t		CompressedSize;
+	uint32_t		UncompressedSize;
+	uint32_t		LocalHeaderOffset;
+};
+
+class ovrPackage
+{
+public:
+							ovrPackage() : Data( NULL ), Length( 0 ) {}
+
+	bool					Open( const char * packageCodePath );
+
+	const ovrPackageEntry *	FindEntry( const char * nameInZip ) const;
+
+	// Returns the compressed data of the entry in the mapping, or NULL if the entry
+	// is not inside the package.
+	const uint8_t *			GetEntryData( const ovrPackageEntry & entry ) const;
+
+	const char *			GetEntryName( const ovrPackageEntry & entry ) const { return (const char *)Data + entry.NameOffset; }
+	int						GetNumEntries() const { return Entries.GetSizeI(); }
+	const ovrPackageEntry &	GetEntry( const int index ) const { return Entries[index]; }
+
+private:
+	MappedFile				File;
+	MappedView				View;
+	const uint8_t *			Data;
+	uint32_t				Length;
+
+	Array< ovrPackageEntry >	Entries;
+	Array< int >			Table;				// index + 1 in Entries, 0 for an empty slot
+
+	bool					ReadCentralDirectory( const char * packageCodePath );
+	void					AddEntry( const ovrPackageEntry & entry );
+};
+
+bool ovrPackage::Open( const char * packageCodePath )
+{
+	// The directory and the files are accessed in random order.
+	if ( !File.OpenRead( packageCodePath, false, false ) )
+	{
+		LOG( "Failed to open package '%s'", packageCodePath );
+		return false;
+	}
+	if ( File.GetLength() < (size_t)ZIP_END_SIZE || File.GetLength() > 0xFFFFFFFFu )
+	{
+		WARN( "Package '%s' has an invalid length", packageCodePath );
+		return false;
+	}
+	if ( !View.Open( &File ) || View.MapView( 0, (uint32_t)File.GetLength() ) == NULL )
+	{
+		WARN( "Failed to map package '%s'", packageCodePath );
+		return false;
+	}
+	Data = View.GetFront();
+	Length = (uint32_t)File.GetLength();
+
+	return ReadCentralDirectory( packageCodePath );
+}
+
+bool ovrPackage::ReadCentralDirectory( const char * packageCodePath )
+{
+	// The end of central directory record is followed by a comment of up to 64k.
+	const uint8_t * end = NULL;
+	const uint32_t minEnd = ( Length > ZIP_END_SIZE + 0xFFFF ) ? Length - ZIP_END_SIZE - 0xFFFF : 0;
+	for ( uint32_t offset = Length - ZIP_END_SIZE + 1; offset-- > minEnd; )
+	{
+		if ( ReadU32( Data + offset ) == ZIP_END_SIGNATURE )
+		{
+			end = Data + offset;
+			break;
+		}
+	}
+	if ( end == NULL )
+	{
+		WARN( "Package '%s' has no zip directory", packageCodePath );
+		return false;
+	}
+
+	uint64_t numEntries = ReadU16( end + 10 );
+	uint64_t directoryOffset = ReadU32( end + 16 );
+
+	// Use the zip64 record if the counts did not fit.
+	if ( ( numEntries == 0xFFFF || directoryOffset == 0xFFFFFFFF ) && end - Data >= ZIP64_END_LOCATOR_SIZE )
+	{
+		const uint8_t * locator = end - ZIP64_END_LOCATOR_SIZE;
+		if ( ReadU32( locator ) == ZIP64_END_LOCATOR_SIGNATURE )
+		{
+			const uint64_t end64Offset = ReadU64( locator + 8 );
+			if ( end64Offset + ZIP64_END_SIZE <= Length && ReadU32( Data + end64Offset ) == ZIP64_END_SIGNATURE )
+			{
+				numEntries = ReadU64( Data + end64Offset + 32 );
+				directoryOffset = ReadU64( Data + end64Offset + 48 );
+			}
+		}
+	}
+
+	if ( directoryOffset >= Length || numEntries > ( Length - directoryOffset ) / ZIP_CENTRAL_HEADER_SIZE )
+	{
+		WARN( "Package '%s' has an invalid zip directory", packageCodePath );
+		return false;
+	}
+
+	Entries.Reserve( (int)numEntries );
+	int tableSize = 64;
+	while ( tableSize < (int)numEntries * 2 )
+	{
+		tableSize *= 2;
+	}
+	Table.Resize( tableSize );
+	memset( Table.GetDataPtr(), 0, tableSize * sizeof( int ) );
+
+	uint32_t offset = (uint32_t)directoryOffset;
+	for ( uint64_t i = 0; i < numEntries; i++ )
+	{
+		const uint8_t * header = Data + offset;
+		if ( offset + ZIP_CENTRAL_HEADER_SIZE > Length || ReadU32( header ) != ZIP_CENTRAL_HEADER_SIGNATURE )
+		{
+			WARN( "Package '%s' has an invalid zip directory entry", packageCodePath );
+			return false;
+		}
+
+		const uint32_t nameLength = ReadU16( header + 28 );
+		const uint32_t extraLength = ReadU16( header + 30 );
+		const uint32_t commentLength = ReadU16( header + 32 );
+		const uint32_t headerLength = ZIP_CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+		if ( headerLength > Length - offset )
+		{
+			WARN( "Package '%s' has an invalid zip directory entry", packageCodePath );
+			return false;
+		}
+
+		uint64_t compressedSize = ReadU32( header + 20 );
+		uint64_t uncompressedSize = ReadU32( header + 24 );
+		uint64_t localHeaderOffset = ReadU32( header + 42 );
+
+		// The zip64 extra field only holds the values that did not fit, in this order.
+		if ( compressedSize == 0xFFFFFFFF || uncompressedSize == 0xFFFFFFFF || localHeaderOffset == 0xFFFFFFFF )
+		{
+			const uint8_t * extra = header + ZIP_CENTRAL_HEADER_SIZE + nameLength;
+			const uint8_t * extraEnd = extra + extraLength;
+			while ( extra + 4 <= extraEnd )
+			{
+				const uint32_t id = ReadU16( extra );
+				const uint32_t size = ReadU16( extra + 2 );
+				const uint8_t * field = extra + 4;
+				const uint8_t * fieldEnd = ( field + size <= extraEnd ) ? field + size : extraEnd;
+				if ( id == 0x0001 )
+				{
+					uint64_t * values[3] = { &uncompressedSize, &compressedSize, &localHeaderOffset };
+					for ( int j = 0; j < 3; j++ )
+					{
+						if ( *values[j] == 0xFFFFFFFF && field + 8 <= fieldEnd )
+						{
+							*values[j] = ReadU64( field );
+							field += 8;
+						}
+					}
+					break;
+				}
+				extra = field + size;
+			}
+		}
+
+		// Files that are not addressable with the 32 bit mapping are left out.
+		if ( compressedSize < 0xFFFFFFFF && uncompressedSize < 0x7FFFFFFF && localHeaderOffset < Length )
+		{
+			ovrPackageEntry entry;
+			entry.NameOffset = offset + ZIP_CENTRAL_HEADER_SIZE;
+			entry.NameLength = (int)nameLength;
+			entry.Hash = HashEntryName( (const char *)Data + entry.NameOffset, entry.NameLength );
+			entry.Method = (int)ReadU16( header + 10 );
+			entry.Crc = ReadU32( header + 16 );
+			entry.CompressedSize = (uint32_t)compressedSize;
+			entry.UncompressedSize = (uint32_t)uncompressedSize;
+			entry.LocalHeaderOffset = (uint32_t)localHeaderOffset;
+			AddEntry( entry );
+		}
+
+		offset += headerLength;
+	}
+
+	return true;
+}
+
+void ovrPackage::AddEntry( const ovrPackageEntry & entry )
+{
+	// Like unzLocateFile, the first entry with a name wins.
+	const uint32_t mask = (uint32_t)Table.GetSize() - 1;
+	uint32_t slot = entry.Hash & mask;
+	while ( Table[slot] != 0 )
+	{
+		const ovrPackageEntry & other = Entries[Table[slot] - 1];
+		if ( other.Hash == entry.Hash && other.NameLength == entry.NameLength &&
+				EntryNamesEqual( GetEntryName( other ), GetEntryName( entry ), entry.NameLength ) )
+		{
+			return;
+		}
+		slot = ( slot + 1 ) & mask;
+	}
+	Entries.PushBack( entry );
+	Table[slot] = Entries.GetSizeI();
+}
+
+const ovrPackageEntry * ovrPackage::FindEntry( const char * nameInZip ) const
+{
+	const int nameLength = (int)strlen( nameInZip );
+	const uint32_t hash = HashEntryName( nameInZip, nameLength );
+	const uint32_t mask = (uint32_t)Table.GetSize() - 1;
+	for ( uint32_t slot = hash & mask; Table[slot] != 0; slot = ( slot + 1 ) & mask )
+	{
+		const ovrPackageEntry & entry = Entries[Table[slot] - 1];
+		if ( entry.Hash == hash && entry.NameLength == nameLength &&
+				EntryNamesEqual( GetEntryName( entry ), nameInZip, nameLength ) )
+		{
+			return &entry;
+		}
+	}
+	return NULL;
+}
+
+const uint8_t * ovrPackage::GetEntryData( const ovrPackageEntry & entry ) const
+{
+	// The local header has its own name and extra field lengths.
+	const uint32_t offset = entry.LocalHeaderOffset;
+	if ( offset + ZIP_LOCAL_HEADER_SIZE > Length || ReadU32( Data + offset ) != ZIP_LOCAL_HEADER_SIGNATURE )
+	{
+		return NULL;
+	}
+	const uint64_t dataOffset = (uint64_t)offset + ZIP_LOCAL_HEADER_SIZE + ReadU16( Data + offset + 26 ) + ReadU16( Data + offset + 28 );
+	if ( dataOffset + entry.CompressedSize > Length )
+	{
+		return NULL;
+	}
+	return Data + dataOffset;
+}
+
 OvrApkFile::OvrApkFile( void * zipFile ) : 
 	ZipFile( zipFile ) 
 { 
@@ -48,28 +354,26 @@ OvrApkFile::~OvrApkFile()
 
 void * ovr_OpenOtherApplicationPackage( const char * packageCodePath )
 {
-	void * zipFile = unzOpen( packageCodePath );
+	ovrPackage * package = new ovrPackage();
+	if ( !package->Open( packageCodePath ) )
+	{
+		delete package;
+		return NULL;
+	}
 
 // enable the following block if you need to see the list of files in the application package
 // This is useful for finding a file added in one of the res/ sub-folders (necesary if you want
 // to include a resource file in every project that links VRLib).
 #if 0
 	// enumerate the files in the package for us so we can see if the VRLib res/raw files are in there
-	if ( unzGoToFirstFile( zipFile ) == UNZ_OK )
+	LOG( "FilesInPackage", "Files in package:" );
+	for ( int i = 0; i < package->GetNumEntries(); i++ )
 	{
-		LOG( "FilesInPackage", "Files in package:" );
-		do
-		{
-			unz_file_info fileInfo;
-			char fileName[512];
-			if ( unzGetCurrentFileInfo( zipFile, &fileInfo, fileName, sizeof( fileName ), NULL, 0, NULL, 0 ) == UNZ_OK )
-			{
-				LOG( "FilesInPackage", "%s", fileName );
-			}
-		} while ( unzGoToNextFile( zipFile ) == UNZ_OK );
+		const ovrPackageEntry & entry = package->GetEntry( i );
+		LOG( "FilesInPackage", "%.*s", entry.NameLength, package->GetEntryName( entry ) );
 	}
 #endif
-	return zipFile;
+	return package;
 }
 
 void ovr_CloseOtherApplicationPackage( void * & zipFile )
@@ -78,32 +382,72 @@ void ovr_CloseOtherApplicationPackage( void * & zipFile )
 	{
 		return;
 	}
-	unzClose( zipFile );
+	delete (ovrPackage *)zipFile;
 	zipFile = 0;
 }
 
 bool ovr_OtherPackageFileExists( void* zipFile, const char * nameInZip )
 {
-	const int locateRet = unzLocateFile( zipFile, nameInZip, 2 /* case insensitive */ );
-	if ( locateRet != UNZ_OK )
+	if ( zipFile == 0 )
+	{
+		return false;
+	}
+
+	if ( ( (const ovrPackage *)zipFile )->FindEntry( nameInZip ) == NULL )
 	{
 		LOG( "File '%s' not found in apk!", nameInZip );
 		return false;
 	}
 
-	const int openRet = unzOpenCurrentFile( zipFile );
-	if ( openRet != UNZ_OK )
+	return true;
+}
+
+bool ovr_MapFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, int & length, const void * & data )
+{
+	length = 0;
+	data = NULL;
+	if ( zipFile == 0 )
 	{
-		WARN( "Error opening file '%s' from apk!", nameInZip );
 		return false;
 	}
 
-	unzCloseCurrentFile( zipFile );
+	const ovrPackage * package = (const ovrPackage *)zipFile;
+	const ovrPackageEntry * entry = package->FindEntry( nameInZip );
+	if ( entry == NULL || entry->Method != 0 )
+	{
+		return false;
+	}
+
+	const uint8_t * entryData = package->GetEntryData( *entry );
+	if ( entryData == NULL || entry->CompressedSize != entry->UncompressedSize )
+	{
+		WARN( "Error mapping file '%s' from apk!", nameInZip );
+		return false;
+	}
 
+	length = (int)entry->UncompressedSize;
+	data = entryData;
+	return true;
+}
+
+bool ovr_GetFileCrcFromOtherApplicationPackage( void * zipFile, const char * nameInZip, uint32_t & crc )
+{
+	crc = 0;
+	if ( zipFile == 0 )
+	{
+		return false;
+	}
+
+	const ovrPackageEntry * entry = ( (const ovrPackage *)zipFile )->FindEntry( nameInZip );
+	if ( entry == NULL )
+	{
+		return false;
+	}
+
+	crc = entry->Crc;
 	return true;
 }
 
-// This is DEFINITELY NOT thread safe! 
 bool ovr_ReadFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, MemBufferT< uint8_t > & outBuffer )
 {
 	int length = 0;
@@ -114,147 +458,320 @@ bool ovr_ReadFileFromOtherApplicationPackage( void * zipFile, const char * nameI
 	return success;
 }
 
-// This is DEFINITELY NOT thread safe! 
-bool ovr_ReadFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, int & length, void * & buffer )
+// Reads the file that was decompressed by an earlier launch, if there is one.
+static bool ReadCachedPackageFile( const ovrPackageEntry & info, const char * nameInZip, int & length, void * & buffer )
 {
 	length = 0;
 	buffer = NULL;
-	if ( zipFile == 0 )
+
+	char	cacheName[1024];
+	sprintf( cacheName, "%s/%08x.bin", CachePath, (unsigned)info.Crc );
+#if defined( OVR_OS_ANDROID )
+	const int fd = open( cacheName, O_RDONLY );
+	if ( fd > 0 )
 	{
-		return false;
+		struct stat	s = {};
+
+		if ( fstat( fd, &s ) != -1 )
+		{
+//			LOG( "Loading cached file for: %s", nameInZip );
+			const int cachedLength = s.st_size;
+			if ( cachedLength != (int)info.UncompressedSize )
+			{
+				LOG( "Cached file for %s has length %i != %i", nameInZip,
+						cachedLength, (int)info.UncompressedSize );
+				// Fall through to normal load.
+			}
+			else
+			{
+				void * cachedBuffer = malloc( cachedLength );
+				const int r = read( fd, cachedBuffer, cachedLength );
+				close( fd );
+				if ( r != cachedLength )
+				{
+					LOG( "Cached file for %s only read %i != %i", nameInZip,
+							r, cachedLength );
+					free( cachedBuffer );
+					// Fall back to normal load.
+					return false;
+				}
+				// Got the cached file.
+				length = cachedLength;
+				buffer = cachedBuffer;
+				return true;
+			}
+		}
+		close( fd );
 	}
+#endif
+	return false;
+}
 
-	const int locateRet = unzLocateFile( zipFile, nameInZip, 2 /* case insensitive */ );
-	if ( locateRet != UNZ_OK )
+// Writes a decompressed file to the cache directory.
+static void WriteCachedPackageFile( const ovrPackageEntry & info, const char * nameInZip, const void * buffer, const int length )
+{
+#if defined( OVR_OS_ANDROID )
+	// Threads may write the same file at the same time, so each uses its own temp file.
+	char	tempName[1024];
+	sprintf( tempName, "%s/%08x.%i.tmp", CachePath, (unsigned)info.Crc, (int)gettid() );
+
+	char	cacheName[1024];
+	sprintf( cacheName, "%s/%08x.bin", CachePath, (unsigned)info.Crc );
+	const int fd = open( tempName, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR );
+	if ( fd > 0 )
 	{
-		LOG( "File '%s' not found in apk!", nameInZip );
-		return false;
+		const int r = write( fd, buffer, length );
+		close( fd );
+		if ( r == length )
+		{
+			if ( rename( tempName, cacheName ) == -1 )
+			{
+				LOG( "Failed to rename cache file for %s", nameInZip );
+			}
+			else
+			{
+				LOG( "Cache file generated for %s", nameInZip );
+			}
+		}
+		else
+		{
+			LOG( "Only wrote %i of %i for cached %s", r, length, nameInZip );
+		}
+	}
+	else
+	{
+		LOG( "Failed to open new cache file for %s: %s", nameInZip, tempName );
 	}
+#endif
+}
 
-	unz_file_info	info;
-	const int getRet = unzGetCurrentFileInfo( zipFile, &info, NULL,0, NULL,0, NULL,0);
-	if ( getRet != UNZ_OK )
+bool ovr_ReadFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, int & length, void * & buffer )
+{
+	return ovr_ReadFilesFromOtherApplicationPackage( zipFile, 1, &nameInZip, &length, &buffer );
+}
+
+bool ovr_ReadFilesFromOtherApplicationPackage( void * zipFile, const int numFiles, const char * const * namesInZip,
+		int * lengths, void ** buffers )
+{
+	for ( int i = 0; i < numFiles; i++ )
+	{
+		lengths[i] = 0;
+		buffers[i] = NULL;
+	}
+	if ( zipFile == 0 )
 	{
-		WARN( "File info error reading '%s' from apk!", nameInZip );
 		return false;
 	}
 
-	// Check for an already extracted cache file based on the CRC if
-	// the file is compressed.
-	if ( info.compression_method != 0 && CachePath[0] )
+	const ovrPackage * package = (const ovrPackage *)zipFile;
+	bool allRead = true;
+
+	// Look up all files first, and then decompress the ones that are not cached together.
+	Array< ovrInflateJob > jobs;
+	ArrayPOD< const ovrPackageEntry * > jobEntries;
+	ArrayPOD< int > jobFiles;
+
+	for ( int i = 0; i < numFiles; i++ )
 	{
-		char	cacheName[1024];
-		sprintf( cacheName, "%s/%08x.bin", CachePath, (unsigned)info.crc );
-#if defined( OVR_OS_ANDROID )
-		const int fd = open( cacheName, O_RDONLY );
-		if ( fd > 0 )
+		const char * nameInZip = namesInZip[i];
+		const ovrPackageEntry * entry = package->FindEntry( nameInZip );
+		if ( entry == NULL )
 		{
-			struct stat	s = {};
+			LOG( "File '%s' not found in apk!", nameInZip );
+			allRead = false;
+			continue;
+		}
 
-			if ( fstat( fd, &s ) != -1 )
+		// Check for an already extracted cache file based on the CRC if
+		// the file is compressed.
+		if ( entry->Method != 0 && CachePath[0] )
+		{
+			if ( ReadCachedPackageFile( *entry, nameInZip, lengths[i], buffers[i] ) )
 			{
-//				LOG( "Loading cached file for: %s", nameInZip );
-				length = s.st_size;
-				if ( length != (int)info.uncompressed_size )
-				{
-					LOG( "Cached file for %s has length %i != %i", nameInZip,
-							length, info.uncompressed_size );
-					// Fall through to normal load.
-				}
-				else
-				{
-					buffer = malloc( length );
-					const int r = read( fd, buffer, length );
-					close( fd );
-					if ( r != length )
-					{
-						LOG( "Cached file for %s only read %i != %i", nameInZip,
-								r, length );
-						free( buffer );
-						// Fall through to normal load.
-					}
-					else
-					{	// Got the cached file.
-						return true;
-					}
-				}
+				continue;
 			}
-			close( fd );
 		}
-#endif
+
+		const uint8_t * data = package->GetEntryData( *entry );
+		if ( data == NULL || ( entry->Method != 0 && entry->Method != Z_DEFLATED ) )
+		{
+			WARN( "Error opening file '%s' from apk!", nameInZip );
+			allRead = false;
+			continue;
+		}
+
+		ovrInflateJob & job = jobs[jobs.AllocBack()];
+		job.Compressed = data;
+		job.CompressedSize = (int)entry->CompressedSize;
+		job.Method = entry->Method;
+		job.Crc = entry->Crc;
+		job.VerifyCrc = true;
+		job.Size = (int)entry->UncompressedSize;
+		jobEntries.PushBack( entry );
+		jobFiles.PushBack( i );
 	}
-	else
+
+	if ( jobs.GetSizeI() == 0 )
 	{
-//		LOG( "Not compressed: %s", nameInZip );
+		return allRead;
 	}
 
-	const int openRet = unzOpenCurrentFile( zipFile );
-	if ( openRet != UNZ_OK )
+	ovr_GetInflateService().Inflate( jobs.GetDataPtr(), jobs.GetSizeI() );
+
+	for ( int j = 0; j < jobs.GetSizeI(); j++ )
 	{
-		WARN( "Error opening file '%s' from apk!", nameInZip );
-		return false;
+		const ovrInflateJob & job = jobs[j];
+		const int i = jobFiles[j];
+		if ( !job.Valid )
+		{
+			WARN( "Error reading file '%s' from apk!", namesInZip[i] );
+			allRead = false;
+			continue;
+		}
+
+		lengths[i] = job.Size;
+		buffers[i] = job.Buffer;
+
+		// Optionally write out to the cache directory
+		if ( job.Method != 0 && CachePath[0] )
+		{
+			WriteCachedPackageFile( *jobEntries[j], namesInZip[i], job.Buffer, job.Size );
+		}
 	}
 
-	length = info.uncompressed_size;
-	buffer = malloc( length );
+	return allRead;
+}
 
-	const int readRet = unzReadCurrentFile( zipFile, buffer, length );
-	if ( readRet != length )
+// A file that is read from the package in chunks. The compressed data is inflated
+// straight from the mapping into the caller's buffer.
+struct ovrPackageFile
+{
+	const uint8_t *	Data;
+	int				Method;
+	uint32_t		Crc;
+	uint32_t		CompressedSize;
+	uint32_t		UncompressedSize;
+	uint32_t		Offset;				// uncompressed bytes returned so far
+	uint32_t		RunningCrc;
+	bool			Failed;
+	z_stream		Stream;
+};
+
+void * ovr_OpenFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip, int & length )
+{
+	length = 0;
+	if ( zipFile == 0 )
 	{
-		WARN( "Error reading file '%s' from apk!", nameInZip );
-		free( buffer );
-		length = 0;
-		buffer = NULL;
-		return false;
+		return NULL;
 	}
 
-	unzCloseCurrentFile( zipFile );
+	const ovrPackage * package = (const ovrPackage *)zipFile;
+	const ovrPackageEntry * entry = package->FindEntry( nameInZip );
+	if ( entry == NULL )
+	{
+		LOG( "File '%s' not found in apk!", nameInZip );
+		return NULL;
+	}
 
-	// Optionally write out to the cache directory
-	if ( info.compression_method != 0 && CachePath[0] )
+	const uint8_t * data = package->GetEntryData( *entry );
+	if ( data == NULL || ( entry->Method != 0 && entry->Method != Z_DEFLATED ) ||
+			( entry->Method == 0 && entry->CompressedSize != entry->UncompressedSize ) )
 	{
-		char	tempName[1024];
-		sprintf( tempName, "%s/%08x.tmp", CachePath, (unsigned)info.crc );
+		WARN( "Error opening file '%s' from apk!", nameInZip );
+		return NULL;
+	}
 
-		char	cacheName[1024];
-		sprintf( cacheName, "%s/%08x.bin", CachePath, (unsigned)info.crc );
-#if defined( OVR_OS_ANDROID )
-		const int fd = open( tempName, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR );
-		if ( fd > 0 )
+	ovrPackageFile * file = new ovrPackageFile();
+	file->Data = data;
+	file->Method = entry->Method;
+	file->Crc = entry->Crc;
+	file->CompressedSize = entry->CompressedSize;
+	file->UncompressedSize = entry->UncompressedSize;
+	file->Offset = 0;
+	file->RunningCrc = 0;
+	file->Failed = false;
+	memset( &file->Stream, 0, sizeof( file->Stream ) );
+
+	if ( entry->Method == Z_DEFLATED )
+	{
+		// zip entries are raw deflate streams without a zlib header
+		if ( inflateInit2( &file->Stream, -MAX_WBITS ) != Z_OK )
 		{
-			const int r = write( fd, buffer, length );
-			close( fd );
-			if ( r == length )
-			{
-				if ( rename( tempName, cacheName ) == -1 )
-				{
-					LOG( "Failed to rename cache file for %s", nameInZip );
-				}
-				else
-				{
-					LOG( "Cache file generated for %s", nameInZip );
-				}
-			}
-			else
-			{
-				LOG( "Only wrote %i of %i for cached %s", r, length, nameInZip );
-			}
+			WARN( "Error opening file '%s' from apk!", nameInZip );
+			delete file;
+			return NULL;
 		}
-		else
+		file->Stream.next_in = (Bytef *)data;
+		file->Stream.avail_in = entry->CompressedSize;
+	}
+
+	length = (int)entry->UncompressedSize;
+	return file;
+}
+
+int ovr_ReadFromPackageFile( void * packageFile, void * buffer, const int numBytes )
+{
+	ovrPackageFile * file = (ovrPackageFile *)packageFile;
+	if ( file == NULL || file->Failed )
+	{
+		return -1;
+	}
+
+	const uint32_t remaining = file->UncompressedSize - file->Offset;
+	const uint32_t count = ( (uint32_t)numBytes < remaining ) ? (uint32_t)numBytes : remaining;
+	if ( count == 0 )
+	{
+		return 0;
+	}
+
+	if ( file->Method == 0 )
+	{
+		memcpy( buffer, file->Data + file->Offset, count );
+	}
+	else
+	{
+		file->Stream.next_out = (Bytef *)buffer;
+		file->Stream.avail_out = count;
+		const int result = inflate( &file->Stream, Z_SYNC_FLUSH );
+		if ( ( result != Z_OK && result != Z_STREAM_END ) || file->Stream.avail_out != 0 )
 		{
-			LOG( "Failed to open new cache file for %s: %s", nameInZip, tempName );
+			WARN( "ovr_ReadFromPackageFile: inflate failed" );
+			file->Failed = true;
+			return -1;
 		}
-#endif
 	}
 
-	return true;
+	file->RunningCrc = (uint32_t)crc32( file->RunningCrc, (const Bytef *)buffer, count );
+	file->Offset += count;
+	if ( file->Offset == file->UncompressedSize && file->RunningCrc != file->Crc )
+	{
+		WARN( "ovr_ReadFromPackageFile: CRC mismatch" );
+		file->Failed = true;
+		return -1;
+	}
+	return (int)count;
+}
+
+void ovr_ClosePackageFile( void * & packageFile )
+{
+	ovrPackageFile * file = (ovrPackageFile *)packageFile;
+	if ( file == NULL )
+	{
+		return;
+	}
+	if ( file->Method == Z_DEFLATED )
+	{
+		inflateEnd( &file->Stream );
+	}
+	delete file;
+	packageFile = NULL;
 }
 
 //--------------------------------------------------------------
 // Functions for reading assets from this process's application package
 //--------------------------------------------------------------
 
-static unzFile packageZipFile = 0;
+static void * packageZipFile = 0;
 
 void * ovr_GetApplicationPackageFile()
 {
@@ -279,11 +796,21 @@ bool ovr_PackageFileExists( const char * nameInZip )
 	return ovr_OtherPackageFileExists( packageZipFile, nameInZip );
 }
 
+bool ovr_MapFileFromApplicationPackage( const char * nameInZip, int & length, const void * & data )
+{
+	return ovr_MapFileFromOtherApplicationPackage( packageZipFile, nameInZip, length, data );
+}
+
 bool ovr_ReadFileFromApplicationPackage( const char * nameInZip, int & length, void * & buffer )
 {
 	return ovr_ReadFileFromOtherApplicationPackage( packageZipFile, nameInZip, length, buffer );
 }
 
+void * ovr_OpenFileFromApplicationPackage( const char * nameInZip, int & length )
+{
+	return ovr_OpenFileFromOtherApplicationPackage( packageZipFile, nameInZip, length );
+}
+
 bool ovr_ReadFileFromApplicationPackage( const char * nameInZip, MemBufferFile & memBufferFile )
 {
 	memBufferFile.FreeData();
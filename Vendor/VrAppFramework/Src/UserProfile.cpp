@@ -55,7 +55,7 @@ void SaveProfile(const UserProfile& profile)
 	root->AddNumberItem( "headModelHeight", profile.HeadModelParms.HeadModelHeight );
 	root->AddNumberItem( "headModelDepth", profile.HeadModelParms.HeadModelDepth );
 
-	if ( root->Save( PROFILE_PATH ) )
+	if ( !root->Save( PROFILE_PATH ) )
 	{
 		WARN( "Failed to save user profile %s", PROFILE_PATH );
 	}
@@ -254,7 +254,8 @@ void VrFrameBuilder::InterpretTouchpad( VrInput & input, const double currentTim
 void VrFrameBuilder::AdvanceVrFrame( const ovrInputEvents & inputEvents, ovrMobile * ovr,
 									const ovrFrameParms & frameParms,
 									const ovrHeadModelParms & headModelParms,
-									SystemActivitiesAppEventList_t * appEvents )
+									SystemActivitiesAppEventList_t * appEvents,
+									ovrAppEventList * appEventList )
 {
 	const VrInput lastVrInput = vrFrame.Input;
 
@@ -410,6 +411,7 @@ void VrFrameBuilder::AdvanceVrFrame( const ovrInputEvents & inputEvents, ovrMobi
 	vrFrame.DeviceStatus.PowerLevelStateMinimum		= ( vrapi_GetSystemStatusInt( &frameParms.Java, VRAPI_SYS_STATUS_THROTTLED2 ) != VRAPI_FALSE );
 
 	vrFrame.AppEvents = appEvents;
+	vrFrame.AppEventList = appEventList;
 }
 
 }	// namespace OVR
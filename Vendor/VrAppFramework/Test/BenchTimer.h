@@ -0,0 +1,28 @@
+/************************************************************************************
+
+Filename    :   BenchTimer.h
+Content     :   Wall clock timing for the host benchmarks
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#ifndef OVR_BenchTimer_h
+#define OVR_BenchTimer_h
+
+#include <time.h>
+
+namespace OVR
+{
+
+inline double BenchSeconds()
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+} // namespace OVR
+
+#endif	// OVR_BenchTimer_h
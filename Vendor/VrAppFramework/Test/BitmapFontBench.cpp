@@ -0,0 +1,295 @@
+/************************************************************************************
+
+Filename    :   BitmapFontBench.cpp
+Content     :   Host benchmark for sorting and transforming bitmap font vertex blocks
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Finishes a font surface of 1k, 5k and 20k billboarded text blocks of 16
+// characters each, the way BitmapFontSurfaceLocal::Finish did before and does
+// now, without the GL calls:
+//
+//	- before: qsort on the float distance with the ftoi comparator, then a
+//	  Matrix4f per block and a matrix transform per vertex,
+//	- now: RadixSortVertexBlocks on the distance bits, then TransformTextVertices
+//	  with the two axes of the block.
+//
+// The radix sort has to produce the order of a stable sort on the distance, the
+// transform has to produce exactly the positions of the scalar path, and the
+// positions have to be within 1e-4 of the matrix transform, or the benchmark
+// fails.  The Makefile builds this benchmark with -ffp-contract=off, like the
+// Android build, so the scalar reference is not contracted into fused multiply-adds.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test bench
+
+#include "BitmapFontVertices.h"
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int BLOCK_COUNTS[]		= { 1000, 5000, 20000 };
+static const int CHARS_PER_BLOCK	= 16;
+static const int VERTS_PER_BLOCK	= CHARS_PER_BLOCK * 4;
+static const int NUM_FRAMES			= 20;
+
+static float RandomFloat( const float min, const float max )
+{
+	return min + ( max - min ) * ( rand() / (float)RAND_MAX );
+}
+
+struct textBlock_t
+{
+	Vector3f	Pivot;
+	UInt32		Color;
+};
+
+struct oldSort_t
+{
+	float	DistanceSquared;
+	int		VertexBlockIndex;
+};
+
+static int ftoi( float const f )
+{
+	return (int)f;
+}
+
+static int OldVertexBlockSortFn( void const * a, void const * b )
+{
+	return ftoi( ((oldSort_t const*)a)->DistanceSquared - ((oldSort_t const*)b)->DistanceSquared );
+}
+
+static int StableSortFn( void const * a, void const * b )
+{
+	vbSort_t const * sa = (vbSort_t const *)a;
+	vbSort_t const * sb = (vbSort_t const *)b;
+	if ( sa->DistanceKey != sb->DistanceKey )
+	{
+		return sa->DistanceKey < sb->DistanceKey ? -1 : 1;
+	}
+	return sa->VertexBlockIndex - sb->VertexBlockIndex;
+}
+
+static UInt32 DistanceKey( float const distanceSquared )
+{
+	union { float f; UInt32 u; } distance;
+	distance.f = distanceSquared;
+	return distance.u;
+}
+
+static void BillboardAxes( Vector3f const & viewPos, Vector3f const & pivot, Vector3f & axisX, Vector3f & axisY )
+{
+	Vector3f const textNormal = ( viewPos - pivot ).Normalized();
+	Matrix4f const transform = Matrix4f::CreateFromBasisVectors( textNormal, Vector3f( 0.0f, 1.0f, 0.0f ) );
+	axisX = Vector3f( transform.M[0][0], transform.M[1][0], transform.M[2][0] );
+	axisY = Vector3f( transform.M[0][1], transform.M[1][1], transform.M[2][1] );
+}
+
+// The layout vertices of a line of characters, as the old vertex blocks stored them.
+static void MakeLayout( ArrayPOD< textLayoutVertex_t > & layout, ArrayPOD< fontVertex_t > & oldLayout )
+{
+	layout.Resize( VERTS_PER_BLOCK );
+	oldLayout.Resize( VERTS_PER_BLOCK );
+	for ( int c = 0; c < CHARS_PER_BLOCK; c++ )
+	{
+		float const x = ( c - CHARS_PER_BLOCK * 0.5f ) * 0.031f;
+		for ( int i = 0; i < 4; i++ )
+		{
+			textLayoutVertex_t & v = layout[c * 4 + i];
+			v.x = x + ( ( i & 1 ) ? 0.027f : 0.0f );
+			v.y = ( i & 2 ) ? 0.042f : -0.008f;
+			v.s = c / (float)CHARS_PER_BLOCK + ( ( i & 1 ) ? 0.05f : 0.0f );
+			v.t = ( i & 2 ) ? 0.0f : 0.1f;
+
+			fontVertex_t & o = oldLayout[c * 4 + i];
+			o.xyz = Vector3f( v.x, v.y, 0.0f );
+			o.s = v.s;
+			o.t = v.t;
+		}
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	srand( 1 );
+
+	ArrayPOD< textLayoutVertex_t > layout;
+	ArrayPOD< fontVertex_t > oldLayout;
+	MakeLayout( layout, oldLayout );
+
+	UInt32 const fontParms = 0x00ff80c0;
+
+	bool failed = false;
+	for ( int c = 0; c < (int)( sizeof( BLOCK_COUNTS ) / sizeof( BLOCK_COUNTS[0] ) ); c++ )
+	{
+		int const n = BLOCK_COUNTS[c];
+
+		ArrayPOD< textBlock_t > blocks;
+		blocks.Resize( n );
+		for ( int i = 0; i < n; i++ )
+		{
+			blocks[i].Pivot = Vector3f( RandomFloat( -20.0f, 20.0f ), RandomFloat( 0.0f, 4.0f ), RandomFloat( -20.0f, 20.0f ) );
+			blocks[i].Color = (UInt32)rand();
+		}
+
+		ArrayPOD< oldSort_t > oldSort;
+		ArrayPOD< vbSort_t > sortBlocks;
+		ArrayPOD< vbSort_t > sortScratch;
+		ArrayPOD< vbSort_t > stableSort;
+		ArrayPOD< fontVertex_t > oldVertices;
+		ArrayPOD< fontVertex_t > vertices;
+		oldSort.Resize( n );
+		sortBlocks.Resize( n );
+		sortScratch.Resize( n );
+		stableSort.Resize( n );
+		oldVertices.Resize( n * VERTS_PER_BLOCK );
+		vertices.Resize( n * VERTS_PER_BLOCK );
+
+		double oldSortTime = 0.0;
+		double oldTransformTime = 0.0;
+		double sortTime = 0.0;
+		double transformTime = 0.0;
+		int orderErrors = 0;
+		int transformErrors = 0;
+		int oldTransformErrors = 0;
+
+		for ( int frame = 0; frame < NUM_FRAMES; frame++ )
+		{
+			Vector3f const viewPos( RandomFloat( -2.0f, 2.0f ), 1.6f, RandomFloat( -2.0f, 2.0f ) );
+
+			// before
+			double start = BenchSeconds();
+			for ( int i = 0; i < n; i++ )
+			{
+				oldSort[i].DistanceSquared = ( blocks[i].Pivot - viewPos ).LengthSq();
+				oldSort[i].VertexBlockIndex = i;
+			}
+			qsort( oldSort.GetDataPtr(), n, sizeof( oldSort[0] ), OldVertexBlockSortFn );
+			oldSortTime += BenchSeconds() - start;
+
+			start = BenchSeconds();
+			for ( int i = 0; i < n; i++ )
+			{
+				textBlock_t const & block = blocks[oldSort[i].VertexBlockIndex];
+				Vector3f const textNormal = ( viewPos - block.Pivot ).Normalized();
+				Matrix4f transform = Matrix4f::CreateFromBasisVectors( textNormal, Vector3f( 0.0f, 1.0f, 0.0f ) );
+				transform.SetTranslation( block.Pivot );
+				fontVertex_t * out = &oldVertices[i * VERTS_PER_BLOCK];
+				for ( int j = 0; j < VERTS_PER_BLOCK; j++ )
+				{
+					fontVertex_t const & v = oldLayout[j];
+					out[j].xyz = transform.Transform( v.xyz );
+					out[j].s = v.s;
+					out[j].t = v.t;
+					*(UInt32*)(&out[j].rgba[0]) = block.Color;
+					*(UInt32*)(&out[j].fontParms[0]) = fontParms;
+				}
+			}
+			oldTransformTime += BenchSeconds() - start;
+
+			// now
+			start = BenchSeconds();
+			for ( int i = 0; i < n; i++ )
+			{
+				sortBlocks[i].DistanceKey = DistanceKey( ( blocks[i].Pivot - viewPos ).LengthSq() );
+				sortBlocks[i].VertexBlockIndex = i;
+			}
+			memcpy( stableSort.GetDataPtr(), sortBlocks.GetDataPtr(), n * sizeof( vbSort_t ) );
+			vbSort_t const * sorted = RadixSortVertexBlocks( sortBlocks.GetDataPtr(), sortScratch.GetDataPtr(), n );
+			sortTime += BenchSeconds() - start;
+
+			start = BenchSeconds();
+			for ( int i = 0; i < n; i++ )
+			{
+				textBlock_t const & block = blocks[sorted[i].VertexBlockIndex];
+				Vector3f axisX;
+				Vector3f axisY;
+				BillboardAxes( viewPos, block.Pivot, axisX, axisY );
+				TransformTextVertices( layout.GetDataPtr(), VERTS_PER_BLOCK, block.Pivot, axisX, axisY,
+						block.Color, fontParms, &vertices[i * VERTS_PER_BLOCK] );
+			}
+			transformTime += BenchSeconds() - start;
+
+			// check the order against a stable sort
+			qsort( stableSort.GetDataPtr(), n, sizeof( stableSort[0] ), StableSortFn );
+			for ( int i = 0; i < n; i++ )
+			{
+				orderErrors += ( sorted[i].VertexBlockIndex != stableSort[i].VertexBlockIndex );
+			}
+
+			// check the positions against the scalar path and the matrix transform of the same block
+			ArrayPOD< int > oldIndex;
+			oldIndex.Resize( n );
+			for ( int i = 0; i < n; i++ )
+			{
+				oldIndex[oldSort[i].VertexBlockIndex] = i;
+			}
+			for ( int i = 0; i < n; i++ )
+			{
+				int const b = sorted[i].VertexBlockIndex;
+				textBlock_t const & block = blocks[b];
+				Vector3f axisX;
+				Vector3f axisY;
+				BillboardAxes( viewPos, block.Pivot, axisX, axisY );
+				fontVertex_t const * out = &vertices[i * VERTS_PER_BLOCK];
+				fontVertex_t const * oldOut = &oldVertices[oldIndex[b] * VERTS_PER_BLOCK];
+				for ( int j = 0; j < VERTS_PER_BLOCK; j++ )
+				{
+					Vector3f const xyz = block.Pivot + axisX * layout[j].x + axisY * layout[j].y;
+					if ( memcmp( &out[j].xyz, &xyz, sizeof( xyz ) ) != 0 || out[j].s != layout[j].s || out[j].t != layout[j].t ||
+							*(UInt32 const *)( &out[j].rgba[0] ) != block.Color ||
+							*(UInt32 const *)( &out[j].fontParms[0] ) != fontParms )
+					{
+						transformErrors++;
+					}
+					if ( ( out[j].xyz - oldOut[j].xyz ).Length() > 1e-4f )
+					{
+						oldTransformErrors++;
+					}
+				}
+			}
+		}
+
+		if ( orderErrors != 0 )
+		{
+			printf( "%5d blocks: %d blocks are not in the order of a stable sort\n", n, orderErrors );
+		}
+		if ( transformErrors != 0 )
+		{
+			printf( "%5d blocks: %d vertices differ from the scalar transform\n", n, transformErrors );
+		}
+		if ( oldTransformErrors != 0 )
+		{
+			printf( "%5d blocks: %d vertices differ from the matrix transform\n", n, oldTransformErrors );
+		}
+		failed |= ( orderErrors != 0 || transformErrors != 0 || oldTransformErrors != 0 );
+
+		oldSortTime /= NUM_FRAMES;
+		oldTransformTime /= NUM_FRAMES;
+		sortTime /= NUM_FRAMES;
+		transformTime /= NUM_FRAMES;
+		printf( "%5d blocks: sort qsort %6.3f ms, radix %6.3f ms, %5.2fx; transform matrix %6.3f ms, axes %6.3f ms, %5.2fx; total %5.2fx\n",
+				n, oldSortTime * 1e3, sortTime * 1e3, oldSortTime / sortTime,
+				oldTransformTime * 1e3, transformTime * 1e3, oldTransformTime / transformTime,
+				( oldSortTime + oldTransformTime ) / ( sortTime + transformTime ) );
+	}
+
+	printf( failed ? "FAILED: font vertices are wrong\n" : "PASSED: font vertices match\n" );
+	return failed ? 1 : 0;
+}
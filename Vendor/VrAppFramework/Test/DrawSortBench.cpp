@@ -0,0 +1,190 @@
+/************************************************************************************
+
+Filename    :   DrawSortBench.cpp
+Content     :   Host benchmark for the radix sort of packed draw keys
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Sorts 1k, 10k and 50k visible surfaces, a quarter of them transparent, once
+// with std::stable_sort over the bsort_t records the model renderer used before,
+// and once with RadixSortDrawKeys over packed keys with the same layout as
+// DrawSortKey() in MODEL_SURFACE_SORT_DEPTH mode.  With the program and texture
+// bits cleared, both sorts have to produce exactly the same surface order, or
+// the test fails.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test bench
+
+#include "ModelCull.h"
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int SURFACE_COUNTS[]	= { 1000, 10000, 50000 };
+static const int NUM_FRAMES			= 20;
+
+// The sort record as it was before the keys were packed.  The pointers
+// are only there to keep the record the same size.
+struct bsort_t
+{
+	float						key;
+	const Matrix4f * 			modelMatrix;
+	const Array< Matrix4f > *	joints;
+	const void *				surface;
+	bool						transparent;
+
+	bool operator< (const bsort_t& b2) const
+	{
+		const bsort_t& b1 = *this;
+		bool trans1 = b1.transparent;
+		bool trans2 = b2.transparent;
+		if ( trans1 == trans2 )
+		{
+			float f1 = b1.key;
+			float f2 = b2.key;
+			if ( !trans1 )
+			{
+				// both are solid, sort front-to-back
+				return ( f1 < f2 );
+			}
+			else
+			{
+				// both are transparent, sort back-to-front
+				return ( f2 < f1 );
+			}
+		}
+		// otherwise, one is solid and one is translucent... the solid is always rendered first
+		return !trans1;
+	};
+};
+
+struct Surface
+{
+	float	farW;
+	bool	transparent;
+	int		program;
+	int		texture;
+};
+
+// Same layout as DrawSortKey() with MODEL_SURFACE_SORT_DEPTH.
+static UInt64 MakeDrawKey( const Surface & surface, const bool withState )
+{
+	UInt32 depth;
+	memcpy( &depth, &surface.farW, sizeof( depth ) );
+	depth &= 0x7FFFFFFF;
+	if ( surface.transparent )
+	{
+		depth = 0x7FFFFFFF - depth;
+	}
+	const UInt64 program = withState ? ( surface.program & 0xFFFF ) : 0;
+	const UInt64 texture = withState ? ( surface.texture & 0xFFFF ) : 0;
+	return ( (UInt64)surface.transparent << 63 ) | ( (UInt64)depth << 32 ) | ( program << 16 ) | texture;
+}
+
+// Depths are quantized so there are plenty of ties for the stable ordering to matter.
+static void MakeSurfaces( Array< Surface > & surfaces, const int count )
+{
+	surfaces.Resize( count );
+	for ( int i = 0; i < count; i++ )
+	{
+		surfaces[i].farW = 0.1f + ( rand() % 20000 ) * 0.05f;
+		surfaces[i].transparent = ( rand() % 4 ) == 0;
+		surfaces[i].program = 1 + rand() % 16;
+		surfaces[i].texture = 1 + rand() % 64;
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	srand( 1 );
+
+	bool failed = false;
+	for ( int c = 0; c < (int)( sizeof( SURFACE_COUNTS ) / sizeof( SURFACE_COUNTS[0] ) ); c++ )
+	{
+		const int count = SURFACE_COUNTS[c];
+		Array< Surface > surfaces;
+		MakeSurfaces( surfaces, count );
+
+		ArrayPOD< bsort_t > source;
+		ArrayPOD< bsort_t > bsort;
+		source.Resize( count );
+		bsort.Resize( count );
+		for ( int i = 0; i < count; i++ )
+		{
+			source[i].key = surfaces[i].farW;
+			source[i].modelMatrix = NULL;
+			source[i].joints = NULL;
+			source[i].surface = &surfaces[i];
+			source[i].transparent = surfaces[i].transparent;
+		}
+
+		ArrayPOD< ModelDrawKey > keys;
+		ArrayPOD< ModelDrawKey > scratch;
+		keys.Resize( count );
+		scratch.Resize( count );
+
+		// Building the records or keys is part of both timings.
+		const double oldStart = BenchSeconds();
+		for ( int frame = 0; frame < NUM_FRAMES; frame++ )
+		{
+			memcpy( bsort.GetDataPtr(), source.GetDataPtr(), count * sizeof( bsort_t ) );
+			std::stable_sort( bsort.GetDataPtr(), bsort.GetDataPtr() + count );
+		}
+		const double oldTime = ( BenchSeconds() - oldStart ) / NUM_FRAMES;
+
+		const double newStart = BenchSeconds();
+		for ( int frame = 0; frame < NUM_FRAMES; frame++ )
+		{
+			for ( int i = 0; i < count; i++ )
+			{
+				keys[i].key = MakeDrawKey( surfaces[i], true );
+				keys[i].index = i;
+			}
+			RadixSortDrawKeys( keys.GetDataPtr(), scratch.GetDataPtr(), count );
+		}
+		const double newTime = ( BenchSeconds() - newStart ) / NUM_FRAMES;
+
+		// Without the state bits the radix sort has to match the old order exactly.
+		for ( int i = 0; i < count; i++ )
+		{
+			keys[i].key = MakeDrawKey( surfaces[i], false );
+			keys[i].index = i;
+		}
+		RadixSortDrawKeys( keys.GetDataPtr(), scratch.GetDataPtr(), count );
+
+		int mismatches = 0;
+		for ( int i = 0; i < count; i++ )
+		{
+			if ( bsort[i].surface != &surfaces[keys[i].index] )
+			{
+				if ( mismatches++ < 10 )
+				{
+					printf( "position %d: old surface %d, new surface %d\n", i,
+							(int)( (const Surface *)bsort[i].surface - &surfaces[0] ), keys[i].index );
+				}
+			}
+		}
+		failed |= ( mismatches != 0 );
+
+		printf( "%6d surfaces: std::stable_sort %7.3f ms, radix %7.3f ms, %.2fx\n",
+				count, oldTime * 1e3, newTime * 1e3, oldTime / newTime );
+	}
+
+	printf( failed ? "FAILED: draw order differs from the old sort\n" : "PASSED: draw order matches the old sort\n" );
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+/************************************************************************************
+
+Filename    :   InflateBench.cpp
+Content     :   Host benchmark for inflating an asset pack with the inflate service
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Deflates an asset pack of entries from 64 KB to 16 MB, 500 MB in total unless
+// another size in MB is given on the command line, and inflates all entries:
+//
+//	- one at a time on the calling thread, into buffers from malloc(), the way
+//	  unzReadCurrentFile() was used before the inflate service, keeping all
+//	  buffers until the pack is done like the loaders do,
+//	- with inflate services of 1, 2, 4 and 8 workers, into buffers from malloc(),
+//	- with the same services into buffers from an ovrInflateBufferPool, which
+//	  gets the buffers of the previous run back.
+//
+// The CRC of every entry is verified by the service, and the first run of every
+// service is compared with the original data, or the benchmark fails.  The
+// scaling numbers only mean something on a host with at least as many cores as
+// workers.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test bench
+
+#include "InflateService.h"
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
+
+#include <zlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int WORKER_COUNTS[]	= { 1, 2, 4, 8 };
+static const int DEFAULT_MEGABYTES	= 500;
+static const int NUM_RUNS			= 3;
+
+struct packEntry_t
+{
+	ArrayPOD< UByte >	Contents;
+	ArrayPOD< UByte >	Compressed;
+	uint32_t			Crc;
+};
+
+// Compressible contents, like texture data and vertex arrays.
+static void MakeContents( ArrayPOD< UByte > & contents, const int size, const int seed )
+{
+	contents.Resize( size );
+	UInt32 value = seed * 2654435761u;
+	for ( int i = 0; i < size; i++ )
+	{
+		if ( ( i & 63 ) == 0 )
+		{
+			value = value * 1664525u + 1013904223u;
+		}
+		contents[i] = (UByte)( ( value >> ( ( i & 3 ) * 8 ) ) & 0x3F );
+	}
+}
+
+// Raw deflate, the way zip entries are stored.
+static bool Deflate( const ArrayPOD< UByte > & contents, ArrayPOD< UByte > & compressed )
+{
+	z_stream stream;
+	memset( &stream, 0, sizeof( stream ) );
+	if ( deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+	{
+		return false;
+	}
+	compressed.Resize( deflateBound( &stream, contents.GetSizeI() ) );
+	stream.next_in = (Bytef *)contents.GetDataPtr();
+	stream.avail_in = contents.GetSizeI();
+	stream.next_out = compressed.GetDataPtr();
+	stream.avail_out = compressed.GetSizeI();
+	const int result = deflate( &stream, Z_FINISH );
+	compressed.Resize( stream.total_out );
+	deflateEnd( &stream );
+	return result == Z_STREAM_END;
+}
+
+static void MakeJobs( const Array< packEntry_t > & pack, ovrInflateBufferPool * pool, Array< ovrInflateJob > & jobs )
+{
+	jobs.Resize( pack.GetSizeI() );
+	for ( int i = 0; i < pack.GetSizeI(); i++ )
+	{
+		jobs[i] = ovrInflateJob();
+		jobs[i].Compressed = pack[i].Compressed.GetDataPtr();
+		jobs[i].CompressedSize = pack[i].Compressed.GetSizeI();
+		jobs[i].Method = Z_DEFLATED;
+		jobs[i].Crc = pack[i].Crc;
+		jobs[i].VerifyCrc = true;
+		jobs[i].Pool = pool;
+		jobs[i].Size = pack[i].Contents.GetSizeI();
+	}
+}
+
+// Returns the number of entries that are not valid or differ from the pack.
+static int CheckJobs( const Array< packEntry_t > & pack, const Array< ovrInflateJob > & jobs )
+{
+	int errors = 0;
+	for ( int i = 0; i < jobs.GetSizeI(); i++ )
+	{
+		errors += ( !jobs[i].Valid || jobs[i].Buffer == NULL ||
+					memcmp( jobs[i].Buffer, pack[i].Contents.GetDataPtr(), jobs[i].Size ) != 0 );
+	}
+	return errors;
+}
+
+static void FreeJobs( Array< ovrInflateJob > & jobs )
+{
+	for ( int i = 0; i < jobs.GetSizeI(); i++ )
+	{
+		if ( jobs[i].Pool != NULL )
+		{
+			jobs[i].Pool->Free( jobs[i].Buffer );
+		}
+		else
+		{
+			free( jobs[i].Buffer );
+		}
+		jobs[i].Buffer = NULL;
+	}
+}
+
+// Inflates the pack NUM_RUNS times and returns the average time of a run.
+static double InflateRuns( ovrInflateService & service, ovrInflateBufferPool * pool,
+						const Array< packEntry_t > & pack, int & errors )
+{
+	double time = 0.0;
+	for ( int run = 0; run < NUM_RUNS; run++ )
+	{
+		Array< ovrInflateJob > jobs;
+		MakeJobs( pack, pool, jobs );
+		const double start = BenchSeconds();
+		errors += !service.Inflate( jobs.GetDataPtr(), jobs.GetSizeI() );
+		time += BenchSeconds() - start;
+		if ( run == 0 )
+		{
+			errors += CheckJobs( pack, jobs );
+		}
+		FreeJobs( jobs );
+	}
+	return time / NUM_RUNS;
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	const int megabytes = ( argc > 1 ) ? atoi( argv[1] ) : DEFAULT_MEGABYTES;
+
+	// Entries from 64 KB to 16 MB, about as many bytes in each size.
+	Array< packEntry_t > pack;
+	size_t totalSize = 0;
+	size_t compressedSize = 0;
+	for ( int i = 0; totalSize < (size_t)megabytes * 1024 * 1024; i++ )
+	{
+		const int size = ( 64 * 1024 ) << ( i % 9 );
+		packEntry_t & entry = pack[pack.AllocBack()];
+		MakeContents( entry.Contents, size, i );
+		if ( !Deflate( entry.Contents, entry.Compressed ) )
+		{
+			printf( "FAILED: could not deflate entry %d\n", i );
+			return 1;
+		}
+		entry.Crc = (uint32_t)crc32( 0, entry.Contents.GetDataPtr(), size );
+		totalSize += size;
+		compressedSize += entry.Compressed.GetSizeI();
+	}
+	const double totalMegabytes = totalSize / ( 1024.0 * 1024.0 );
+
+	// One entry at a time on this thread, like unzReadCurrentFile().
+	int errors = 0;
+	double sequentialTime = 0.0;
+	for ( int run = 0; run < NUM_RUNS; run++ )
+	{
+		ArrayPOD< UByte * > buffers;
+		buffers.Resize( pack.GetSizeI() );
+		const double start = BenchSeconds();
+		for ( int i = 0; i < pack.GetSizeI(); i++ )
+		{
+			const int size = pack[i].Contents.GetSizeI();
+			UByte * buffer = (UByte *)malloc( size );
+			buffers[i] = buffer;
+			z_stream stream;
+			memset( &stream, 0, sizeof( stream ) );
+			inflateInit2( &stream, -MAX_WBITS );
+			stream.next_in = (Bytef *)pack[i].Compressed.GetDataPtr();
+			stream.avail_in = pack[i].Compressed.GetSizeI();
+			stream.next_out = buffer;
+			stream.avail_out = size;
+			const bool inflated = ( inflate( &stream, Z_FINISH ) == Z_STREAM_END );
+			inflateEnd( &stream );
+			errors += ( !inflated || (uint32_t)crc32( 0, buffer, size ) != pack[i].Crc );
+		}
+		sequentialTime += BenchSeconds() - start;
+		for ( int i = 0; i < buffers.GetSizeI(); i++ )
+		{
+			free( buffers[i] );
+		}
+	}
+	sequentialTime /= NUM_RUNS;
+
+	printf( "%d cores, %d entries, %.0f MB, %.0f MB deflated: sequential %7.1f ms, %6.1f MB/s\n",
+			Thread::GetCPUCount(), pack.GetSizeI(), totalMegabytes, compressedSize / ( 1024.0 * 1024.0 ),
+			sequentialTime * 1e3, totalMegabytes / sequentialTime );
+
+	for ( int w = 0; w < (int)( sizeof( WORKER_COUNTS ) / sizeof( WORKER_COUNTS[0] ) ); w++ )
+	{
+		ovrInflateService service( WORKER_COUNTS[w] );
+		ovrInflateBufferPool pool( totalSize * 2 );
+
+		const double mallocTime = InflateRuns( service, NULL, pack, errors );
+		const double poolTime = InflateRuns( service, &pool, pack, errors );
+
+		printf( "%d workers: malloc %7.1f ms, %6.1f MB/s, %.2fx; pooled %7.1f ms, %6.1f MB/s, %.2fx\n",
+				service.GetNumWorkers(),
+				mallocTime * 1e3, totalMegabytes / mallocTime, sequentialTime / mallocTime,
+				poolTime * 1e3, totalMegabytes / poolTime, sequentialTime / poolTime );
+	}
+
+	if ( errors != 0 )
+	{
+		printf( "FAILED: %d entries were not inflated correctly\n", errors );
+		return 1;
+	}
+	printf( "PASSED: all entries inflated correctly with every worker count\n" );
+	return 0;
+}
@@ -0,0 +1,260 @@
+/************************************************************************************
+
+Filename    :   JobSystemBench.cpp
+Content     :   Host benchmark for the work-stealing job system
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Measures the job system with 1, 2, 4 and 8 workers:
+//
+//	- the round trip of a single empty job added from outside the workers,
+//	- the cost per job of adding and completing many empty jobs, from outside
+//	  the workers and from a job on a worker, which pushes to its own deque,
+//	- how many of the jobs added by one job are taken by other threads, which
+//	  includes the thread that waits for the jobs,
+//	- the speed up of ParallelFor over a serial loop on compute bound work.
+//
+// Every job has to run exactly once and ParallelFor has to produce the same
+// result as the serial loop, or the benchmark fails.  The scaling numbers only
+// mean something on a host with at least as many cores as workers.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test bench
+
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_JobSystem.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int WORKER_COUNTS[]	= { 1, 2, 4, 8 };
+static const int NUM_ROUND_TRIPS	= 2000;
+static const int NUM_SPAWN_JOBS		= 100000;
+static const int NUM_STEAL_JOBS		= 1000;		// fits in a worker deque
+static const int NUM_STEAL_RUNS		= 50;
+static const int PARALLEL_COUNT		= 1 << 20;
+static const int PARALLEL_GRAIN		= 4096;
+
+static void EmptyJob( void * data )
+{
+	OVR_UNUSED( data );
+}
+
+static void CountJob( void * data )
+{
+	AtomicInt< int > * count = (AtomicInt< int > *)data;
+	count->ExchangeAdd_Sync( 1 );
+}
+
+//-----------------------------------------------------------------------------------
+// Jobs spawned from a worker
+
+struct SpawnFromWorker
+{
+	JobSystem *			System;
+	int					NumJobs;
+	AtomicInt< int >	Count;
+	double				Seconds;
+};
+
+static void SpawnFromWorkerJob( void * data )
+{
+	SpawnFromWorker * spawn = (SpawnFromWorker *)data;
+
+	ArrayPOD< JobDecl > jobs;
+	jobs.Resize( 256 );
+	for ( int i = 0; i < jobs.GetSizeI(); i++ )
+	{
+		jobs[i] = JobDecl( CountJob, &spawn->Count );
+	}
+
+	const double start = BenchSeconds();
+	JobCounter counter;
+	for ( int added = 0; added < spawn->NumJobs; added += jobs.GetSizeI() )
+	{
+		spawn->System->Run( jobs.GetDataPtr(), Alg::Min( jobs.GetSizeI(), spawn->NumJobs - added ), &counter );
+		spawn->System->Wait( counter );
+	}
+	spawn->Seconds = BenchSeconds() - start;
+}
+
+//-----------------------------------------------------------------------------------
+// Jobs taken from the thread that added them
+
+struct StealFromWorker
+{
+	JobSystem *			System;
+	ThreadId			Owner;
+	AtomicInt< int >	Stolen;
+	AtomicInt< int >	Count;
+};
+
+static void StealJob( void * data )
+{
+	StealFromWorker * steal = (StealFromWorker *)data;
+	// Long enough that the other workers can wake up and steal.
+	volatile float x = 1.0f;
+	for ( int i = 0; i < 2000; i++ )
+	{
+		x = sqrtf( x + 1.0f );
+	}
+	steal->Count.ExchangeAdd_Sync( 1 );
+	if ( GetCurrentThreadId() != steal->Owner )
+	{
+		steal->Stolen.ExchangeAdd_Sync( 1 );
+	}
+}
+
+static void StealFromWorkerJob( void * data )
+{
+	StealFromWorker * steal = (StealFromWorker *)data;
+	steal->Owner = GetCurrentThreadId();
+
+	ArrayPOD< JobDecl > jobs;
+	jobs.Resize( NUM_STEAL_JOBS );
+	for ( int i = 0; i < jobs.GetSizeI(); i++ )
+	{
+		jobs[i] = JobDecl( StealJob, steal );
+	}
+
+	JobCounter counter;
+	steal->System->Run( jobs.GetDataPtr(), jobs.GetSizeI(), &counter );
+	steal->System->Wait( counter );
+}
+
+//-----------------------------------------------------------------------------------
+// ParallelFor
+
+static float WorkItem( const int i )
+{
+	float x = (float)i;
+	for ( int j = 0; j < 16; j++ )
+	{
+		x = sqrtf( x * 1.5f + 1.0f );
+	}
+	return x;
+}
+
+static void WorkRange( void * data, const int begin, const int end )
+{
+	float * results = (float *)data;
+	for ( int i = begin; i < end; i++ )
+	{
+		results[i] = WorkItem( i );
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	bool failed = false;
+
+	ArrayPOD< float > serialResults;
+	ArrayPOD< float > parallelResults;
+	serialResults.Resize( PARALLEL_COUNT );
+	parallelResults.Resize( PARALLEL_COUNT );
+
+	const double serialStart = BenchSeconds();
+	WorkRange( serialResults.GetDataPtr(), 0, PARALLEL_COUNT );
+	const double serialTime = BenchSeconds() - serialStart;
+
+	printf( "%d cores, serial loop %.2f ms\n", Thread::GetCPUCount(), serialTime * 1e3 );
+
+	for ( int w = 0; w < (int)( sizeof( WORKER_COUNTS ) / sizeof( WORKER_COUNTS[0] ) ); w++ )
+	{
+		JobSystem jobSystem( WORKER_COUNTS[w] );
+
+		// Round trip of a single job.
+		const double roundTripStart = BenchSeconds();
+		for ( int i = 0; i < NUM_ROUND_TRIPS; i++ )
+		{
+			JobCounter counter;
+			jobSystem.Run( EmptyJob, NULL, &counter );
+			jobSystem.Wait( counter );
+		}
+		const double roundTripTime = ( BenchSeconds() - roundTripStart ) / NUM_ROUND_TRIPS;
+
+		// Many jobs added from outside the workers.
+		AtomicInt< int > outsideCount( 0 );
+		ArrayPOD< JobDecl > jobs;
+		jobs.Resize( NUM_SPAWN_JOBS );
+		for ( int i = 0; i < NUM_SPAWN_JOBS; i++ )
+		{
+			jobs[i] = JobDecl( CountJob, &outsideCount );
+		}
+		const double outsideStart = BenchSeconds();
+		JobCounter outsideCounter;
+		jobSystem.Run( jobs.GetDataPtr(), NUM_SPAWN_JOBS, &outsideCounter );
+		jobSystem.Wait( outsideCounter );
+		const double outsideTime = ( BenchSeconds() - outsideStart ) / NUM_SPAWN_JOBS;
+
+		// Many jobs added from a worker.
+		SpawnFromWorker spawn;
+		spawn.System = &jobSystem;
+		spawn.NumJobs = NUM_SPAWN_JOBS;
+		spawn.Count.Store_Release( 0 );
+		spawn.Seconds = 0.0;
+		JobCounter spawnCounter;
+		jobSystem.Run( SpawnFromWorkerJob, &spawn, &spawnCounter );
+		jobSystem.Wait( spawnCounter );
+		const double workerTime = spawn.Seconds / NUM_SPAWN_JOBS;
+
+		// Jobs taken from the thread that added them.
+		int stolen = 0;
+		int stealCount = 0;
+		for ( int run = 0; run < NUM_STEAL_RUNS; run++ )
+		{
+			StealFromWorker steal;
+			steal.System = &jobSystem;
+			steal.Owner = NULL;
+			steal.Stolen.Store_Release( 0 );
+			steal.Count.Store_Release( 0 );
+			JobCounter stealCounter;
+			jobSystem.Run( StealFromWorkerJob, &steal, &stealCounter );
+			jobSystem.Wait( stealCounter );
+			stolen += steal.Stolen.Load_Acquire();
+			stealCount += steal.Count.Load_Acquire();
+		}
+
+		// Scaling of ParallelFor.
+		memset( parallelResults.GetDataPtr(), 0, PARALLEL_COUNT * sizeof( float ) );
+		const double parallelStart = BenchSeconds();
+		jobSystem.ParallelFor( PARALLEL_COUNT, PARALLEL_GRAIN, WorkRange, parallelResults.GetDataPtr() );
+		const double parallelTime = BenchSeconds() - parallelStart;
+
+		const bool counted = outsideCount.Load_Acquire() == NUM_SPAWN_JOBS &&
+								spawn.Count.Load_Acquire() == NUM_SPAWN_JOBS &&
+								stealCount == NUM_STEAL_JOBS * NUM_STEAL_RUNS;
+		const bool same = memcmp( serialResults.GetDataPtr(), parallelResults.GetDataPtr(), PARALLEL_COUNT * sizeof( float ) ) == 0;
+		if ( !counted )
+		{
+			printf( "%d workers: jobs did not all run exactly once\n", WORKER_COUNTS[w] );
+		}
+		if ( !same )
+		{
+			printf( "%d workers: ParallelFor results differ from the serial loop\n", WORKER_COUNTS[w] );
+		}
+		failed |= !counted || !same;
+
+		printf( "%d workers: round trip %6.2f us; per job from outside %5.3f us, from a worker %5.3f us; "
+				"%5.1f%% taken by other threads; ParallelFor %7.2f ms, %.2fx\n",
+				jobSystem.GetNumWorkers(), roundTripTime * 1e6, outsideTime * 1e6, workerTime * 1e6,
+				100.0 * stolen / ( NUM_STEAL_JOBS * NUM_STEAL_RUNS ), parallelTime * 1e3, serialTime / parallelTime );
+	}
+
+	printf( failed ? "FAILED: job system results are wrong\n" : "PASSED: all jobs ran exactly once\n" );
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,354 @@
+/************************************************************************************
+
+Filename    :   JsonParseBench.cpp
+Content     :   Host benchmark for parsing large JSON documents
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Parses generated JSON documents of 1, 4 and 16 MB with JSON::Parse, which
+// allocates every node on the heap, and with JSON::ParseArena, which allocates
+// the nodes from an arena owned by the root.  The documents look like the meta
+// data of a large media folder: an array of objects with the same keys, with
+// strings, numbers, booleans and small arrays.
+//
+// The allocator of the kernel is replaced by one that counts allocations, so
+// the benchmark reports the parse and release times and the number of
+// allocations and bytes of each mode.  Both trees have to be identical, or
+// the benchmark fails.
+//
+// The document is also written to a file and read back in chunks with a
+// JsonStreamReader, one element of the Data array at a time, the way the meta
+// data manager reads its stored meta file.  For every mode the peak memory in
+// use while parsing is reported; the streamed elements have to match the tree.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test bench
+
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_JSON.h"
+#include "Kernel/OVR_JSONStream.h"
+#include "Kernel/OVR_String.h"
+#include "Kernel/OVR_SysFile.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int DOCUMENT_MEGABYTES[]	= { 1, 4, 16 };
+static const int NUM_RUNS				= 5;
+static const char * DOCUMENT_PATH		= "JsonParseBench.json";
+
+//-----------------------------------------------------------------------------------
+// Allocation counting
+
+class CountingAllocator : public DefaultAllocator
+{
+public:
+	CountingAllocator() :
+		Allocations( 0 ),
+		Bytes( 0 ),
+		Live( 0 ),
+		Base( 0 ),
+		Peak( 0 )
+	{
+	}
+
+	virtual void * Alloc( size_t size )
+	{
+		Allocations++;
+		Bytes += size;
+		return Track( DefaultAllocator::Alloc( size ) );
+	}
+	virtual void * AllocDebug( size_t size, const char * file, unsigned line )
+	{
+		Allocations++;
+		Bytes += size;
+		return Track( DefaultAllocator::AllocDebug( size, file, line ) );
+	}
+	virtual void * Realloc( void * p, size_t newSize )
+	{
+		Allocations++;
+		Bytes += newSize;
+		Live -= ( p != NULL ) ? malloc_usable_size( p ) : 0;
+		return Track( DefaultAllocator::Realloc( p, newSize ) );
+	}
+	virtual void Free( void * p )
+	{
+		Live -= ( p != NULL ) ? malloc_usable_size( p ) : 0;
+		DefaultAllocator::Free( p );
+	}
+
+	void Reset()
+	{
+		Allocations = 0;
+		Bytes = 0;
+		Base = Live;
+		Peak = Live;
+	}
+
+	// Most memory in use since the last Reset(), on top of what was in use before.
+	size_t PeakBytes() const { return Peak - Base; }
+
+	size_t	Allocations;
+	size_t	Bytes;
+
+private:
+	size_t	Live;
+	size_t	Base;
+	size_t	Peak;
+
+	void * Track( void * p )
+	{
+		Live += ( p != NULL ) ? malloc_usable_size( p ) : 0;
+		Peak = ( Live > Peak ) ? Live : Peak;
+		return p;
+	}
+};
+
+//-----------------------------------------------------------------------------------
+// Documents
+
+static void MakeDocument( String & text, const int megabytes )
+{
+	static const char * const categories[] = { "Favorites", "Oculus 360 Photos", "Camera", "Downloads", "Screenshots" };
+
+	StringBuffer buffer;
+	buffer.AppendString( "{\n\t\"Categories\": [" );
+	for ( int i = 0; i < 5; i++ )
+	{
+		buffer.AppendFormat( "%s\n\t\t{ \"name\": \"%s\", \"tags\": [ \"%s\" ] }", i > 0 ? "," : "", categories[i], categories[i] );
+	}
+	buffer.AppendString( "\n\t],\n\t\"Data\": [" );
+	for ( int i = 0; buffer.GetSize() < (UPInt)megabytes * 1024 * 1024; i++ )
+	{
+		buffer.AppendFormat( "%s\n\t\t{\n\t\t\t\"url\": \"/storage/emulated/0/Oculus/360Photos/photo_%06d.jpg\",\n"
+				"\t\t\t\"title\": \"Photo %d \\\"%s\\\"\",\n"
+				"\t\t\t\"author\": \"Author %d\",\n"
+				"\t\t\t\"tags\": [ \"%s\", \"%s\" ],\n"
+				"\t\t\t\"width\": %d,\n"
+				"\t\t\t\"height\": %d,\n"
+				"\t\t\t\"heading\": %.6f,\n"
+				"\t\t\t\"pos\": [ %.4f, %.4f, %.4f ],\n"
+				"\t\t\t\"isStereo\": %s,\n"
+				"\t\t\t\"thumb\": null\n\t\t}",
+				i > 0 ? "," : "", i, i, categories[i % 5], i % 97, categories[i % 5], categories[( i / 5 ) % 5],
+				4096 + ( i % 3 ) * 1024, 2048 + ( i % 2 ) * 2048, ( i % 360 ) * 0.0174533,
+				( i % 17 ) * 0.25f - 2.0f, 1.6f, ( i % 13 ) * -0.5f, ( i % 4 ) == 0 ? "true" : "false" );
+	}
+	buffer.AppendString( "\n\t]\n}\n" );
+	text = buffer;
+}
+
+// Returns true if both trees have the same structure, names and values.
+static bool SameTree( const JSON * a, const JSON * b )
+{
+	if ( a->Type != b->Type || a->Name != b->Name )
+	{
+		return false;
+	}
+	if ( a->Type == JSON_String && a->Value != b->Value )
+	{
+		return false;
+	}
+	if ( ( a->Type == JSON_Number || a->Type == JSON_Bool ) && a->dValue != b->dValue )
+	{
+		return false;
+	}
+	const JSON * ca = a->GetFirstItem();
+	const JSON * cb = b->GetFirstItem();
+	while ( ca != NULL && cb != NULL )
+	{
+		if ( !SameTree( ca, cb ) )
+		{
+			return false;
+		}
+		ca = a->GetNextItem( const_cast< JSON * >( ca ) );
+		cb = b->GetNextItem( const_cast< JSON * >( cb ) );
+	}
+	return ca == NULL && cb == NULL;
+}
+
+struct parseResult_t
+{
+	double	ParseTime;
+	double	ReleaseTime;
+	size_t	Allocations;
+	size_t	Bytes;
+	size_t	PeakBytes;
+};
+
+// Parses the text NUM_RUNS times and returns the tree of the last run.
+static JSON * ParseRuns( CountingAllocator & allocator, const String & text, const bool arena, parseResult_t & result )
+{
+	result.ParseTime = 0.0;
+	result.ReleaseTime = 0.0;
+	JSON * json = NULL;
+	for ( int run = 0; run < NUM_RUNS; run++ )
+	{
+		allocator.Reset();
+		const double parseStart = BenchSeconds();
+		json = arena ? JSON::ParseArena( text.ToCStr() ) : JSON::Parse( text.ToCStr() );
+		result.ParseTime += BenchSeconds() - parseStart;
+		result.Allocations = allocator.Allocations;
+		result.Bytes = allocator.Bytes;
+		result.PeakBytes = allocator.PeakBytes();
+		if ( json == NULL )
+		{
+			return NULL;
+		}
+		if ( run < NUM_RUNS - 1 )
+		{
+			const double releaseStart = BenchSeconds();
+			json->Release();
+			result.ReleaseTime += BenchSeconds() - releaseStart;
+		}
+	}
+	result.ParseTime /= NUM_RUNS;
+	result.ReleaseTime /= NUM_RUNS - 1;
+	return json;
+}
+
+// Reads the Data array of the document file one element at a time NUM_RUNS times, and
+// checks every element of the last run against the tree. Returns the number of elements
+// read, or -1 if the file does not parse or an element differs.
+static int StreamRuns( CountingAllocator & allocator, const JSON * tree, parseResult_t & result )
+{
+	const JSON * data = tree->GetItemByName( "Data" );
+	result.ParseTime = 0.0;
+	result.ReleaseTime = 0.0;
+	int numElements = 0;
+	for ( int run = 0; run < NUM_RUNS; run++ )
+	{
+		SysFile file;
+		if ( !file.Open( DOCUMENT_PATH, File::Open_Read, File::Mode_Read ) )
+		{
+			return -1;
+		}
+		allocator.Reset();
+		const double parseStart = BenchSeconds();
+		JsonFileSource source( &file );
+		JsonStreamReader reader( &source );
+		const JSON * expected = ( data != NULL ) ? data->GetFirstItem() : NULL;
+		numElements = 0;
+		if ( reader.Next() == JSON_TOKEN_BEGIN_OBJECT )
+		{
+			while ( reader.Next() == JSON_TOKEN_NAME )
+			{
+				if ( OVR_strcmp( reader.GetString(), "Data" ) != 0 )
+				{
+					reader.SkipValue();
+					continue;
+				}
+				if ( reader.Next() != JSON_TOKEN_BEGIN_ARRAY )
+				{
+					reader.SkipRestOfValue();
+					continue;
+				}
+				for ( JSON * element = reader.ReadValue(); element != NULL; element = reader.ReadValue() )
+				{
+					// the name of an array element is empty in both trees
+					if ( run == NUM_RUNS - 1 && ( expected == NULL || !SameTree( element, expected ) ) )
+					{
+						element->Release();
+						return -1;
+					}
+					element->Release();
+					expected = ( expected != NULL ) ? data->GetNextItem( const_cast< JSON * >( expected ) ) : NULL;
+					numElements++;
+				}
+			}
+		}
+		result.ParseTime += BenchSeconds() - parseStart;
+		result.Allocations = allocator.Allocations;
+		result.Bytes = allocator.Bytes;
+		result.PeakBytes = allocator.PeakBytes();
+		if ( reader.GetToken() != JSON_TOKEN_END_OBJECT || reader.GetDepth() != 0 || expected != NULL )
+		{
+			return -1;
+		}
+	}
+	result.ParseTime /= NUM_RUNS;
+	return numElements;
+}
+
+int main( int argc, char * argv[] )
+{
+	static CountingAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	bool failed = false;
+	for ( int d = 0; d < (int)( sizeof( DOCUMENT_MEGABYTES ) / sizeof( DOCUMENT_MEGABYTES[0] ) ); d++ )
+	{
+		String text;
+		MakeDocument( text, DOCUMENT_MEGABYTES[d] );
+		const double megabytes = text.GetSize() / ( 1024.0 * 1024.0 );
+
+		parseResult_t heap;
+		parseResult_t arena;
+		parseResult_t stream;
+		JSON * heapJson = ParseRuns( allocator, text, false, heap );
+		JSON * arenaJson = ParseRuns( allocator, text, true, arena );
+
+		if ( heapJson == NULL || arenaJson == NULL )
+		{
+			printf( "%5.1f MB: the document does not parse\n", megabytes );
+			failed = true;
+		}
+		else if ( !SameTree( heapJson, arenaJson ) )
+		{
+			printf( "%5.1f MB: the arena tree differs from the heap tree\n", megabytes );
+			failed = true;
+		}
+		else
+		{
+			FILE * f = fopen( DOCUMENT_PATH, "wb" );
+			const bool written = f != NULL && fwrite( text.ToCStr(), 1, text.GetSize(), f ) == text.GetSize();
+			if ( f != NULL )
+			{
+				fclose( f );
+			}
+			if ( !written || StreamRuns( allocator, heapJson, stream ) < 0 )
+			{
+				printf( "%5.1f MB: the streamed elements differ from the tree\n", megabytes );
+				failed = true;
+			}
+			remove( DOCUMENT_PATH );
+		}
+		if ( heapJson != NULL )
+		{
+			heapJson->Release();
+		}
+		if ( arenaJson != NULL )
+		{
+			arenaJson->Release();
+		}
+
+		if ( failed )
+		{
+			break;
+		}
+
+		printf( "%5.1f MB: heap parse %7.2f ms (%5.1f MB/s), release %6.2f ms, %8u allocations, %6.1f MB, peak %6.1f MB; "
+				"arena parse %7.2f ms (%5.1f MB/s), release %6.2f ms, %8u allocations, %6.1f MB, peak %6.1f MB; parse %.2fx; "
+				"stream %7.2f ms (%5.1f MB/s), peak %6.3f MB\n",
+				megabytes,
+				heap.ParseTime * 1e3, megabytes / heap.ParseTime, heap.ReleaseTime * 1e3,
+				(unsigned)heap.Allocations, heap.Bytes / ( 1024.0 * 1024.0 ), heap.PeakBytes / ( 1024.0 * 1024.0 ),
+				arena.ParseTime * 1e3, megabytes / arena.ParseTime, arena.ReleaseTime * 1e3,
+				(unsigned)arena.Allocations, arena.Bytes / ( 1024.0 * 1024.0 ), arena.PeakBytes / ( 1024.0 * 1024.0 ),
+				heap.ParseTime / arena.ParseTime,
+				stream.ParseTime * 1e3, megabytes / stream.ParseTime, stream.PeakBytes / ( 1024.0 * 1024.0 ) );
+	}
+
+	printf( failed ? "FAILED: arena parse or stream differs from heap parse\n" : "PASSED: arena parse and stream match heap parse\n" );
+	return failed ? 1 : 0;
+}
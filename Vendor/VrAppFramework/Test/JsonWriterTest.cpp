@@ -0,0 +1,667 @@
+/************************************************************************************
+
+Filename    :   JsonWriterTest.cpp
+Content     :   Host test and benchmark for writing JSON text with JsonWriter
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Prints JSON trees with JSON::PrintValue, which uses JsonWriter, and with the
+// recursive printer it replaced, which is copied below.  The trees are a set
+// of documents with the edge cases of the old printer, a tree of random
+// numbers and strings, and a generated 8 MB meta data file.  Both printers
+// have to produce byte identical text, compact and pretty printed at depth 0
+// and 1, and JSON::Save has to write the same text as the old printer, or the
+// test fails.
+//
+// The times of both printers and of saving with both are reported for the
+// meta data file.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test test
+
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_JSON.h"
+#include "Kernel/OVR_String.h"
+#include "Kernel/OVR_Std.h"
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const char * const SAVE_FILE_NAME	= "JsonWriterTest.json";
+static const int META_DATA_MEGABYTES		= 8;
+
+//-----------------------------------------------------------------------------------
+// The recursive printer as it was before JsonWriter, with the JSON members
+// turned into functions that take the node.
+
+//-----------------------------------------------------------------------------
+// Create a new copy of a string
+static char* OldStrdup(const char* str)
+{
+    size_t len  = OVR_strlen(str) + 1;
+    char* copy = (char*)OVR_ALLOC(len);
+    if (!copy)
+        return 0;
+    memcpy(copy, str, len);
+    return copy;
+}
+
+
+//-----------------------------------------------------------------------------
+// Render the number from the given item into a string.
+static char* OldPrintNumber(double d)
+{
+    char *str;
+    int valueint = (int)d;
+
+    if (fabs(((double)valueint)-d) <= DBL_EPSILON && d <= INT_MAX && d >= INT_MIN)
+    {
+        str=(char*)OVR_ALLOC(21);   // 2^64+1 can be represented in 21 chars.
+        if (str)
+            OVR_sprintf(str, 21, "%d", valueint);
+    }
+    else
+    {
+        str=(char*)OVR_ALLOC(64);    // This is a nice tradeoff.
+        if (str)
+        {
+            // The JSON Standard, section 7.8.3, specifies that decimals are always expressed with '.' and 
+            // not some locale-specific decimal such as ',' or ' '. However, since we are using the C standard
+            // library below to write a floating point number, we need to make sure that it's writing a '.' 
+            // and not something else. We can't change the locale (even temporarily) here, as it will affect 
+            // the whole process by default. That are compiler-specific ways to change this per-thread, but 
+            // below we implement the simple solution of simply fixing the decimal after the string was written.
+
+            if (fabs(floor(d)-d) <= DBL_EPSILON && fabs(d) < 1.0e60)
+                OVR_sprintf(str, 64, "%.0f", d);
+            else if (fabs(d) < 1.0e-6 || fabs(d) > 1.0e9)
+                OVR_sprintf(str, 64, "%e", d);
+            else
+                OVR_sprintf(str, 64, "%f", d);
+        }
+    }
+    return str;
+}
+//-----------------------------------------------------------------------------
+// Render the string provided to an escaped version that can be printed.
+static char* OldPrintString(const char* str)
+{
+    const char *ptr;
+    char *ptr2,*out;
+    int len=0;
+    unsigned char token;
+    
+    if (!str)
+        return OldStrdup("");
+    ptr=str;
+    
+    token=*ptr;
+    while (token && ++len)\
+    {
+        if (strchr("\"\\\b\f\n\r\t",token))
+            len++;
+        else if (token<32) 
+            len+=5;
+        ptr++;
+        token=*ptr;
+    }
+    
+    int buff_size = len+3;
+    out=(char*)OVR_ALLOC(buff_size);
+    if (!out)
+        return 0;
+
+    ptr2 = out;
+    ptr  = str;
+    *ptr2++ = '\"';
+
+    while (*ptr)
+    {
+        if ((unsigned char)*ptr>31 && *ptr!='\"' && *ptr!='\\') 
+            *ptr2++=*ptr++;
+        else
+        {
+            *ptr2++='\\';
+            switch (token=*ptr++)
+            {
+                case '\\':    *ptr2++='\\';    break;
+                case '\"':    *ptr2++='\"';    break;
+                case '\b':    *ptr2++='b';    break;
+                case '\f':    *ptr2++='f';    break;
+                case '\n':    *ptr2++='n';    break;
+                case '\r':    *ptr2++='r';    break;
+                case '\t':    *ptr2++='t';    break;
+                default: 
+                    OVR_sprintf(ptr2, buff_size - (ptr2-out), "u%04x",token);
+                    ptr2+=5;
+                    break;    // Escape and print.
+            }
+        }
+    }
+    *ptr2++='\"';
+    *ptr2++='\0';
+    return out;
+}
+
+static char* OldPrintArray(const JSON* json, int depth, bool fmt);
+static char* OldPrintObject(const JSON* json, int depth, bool fmt);
+
+//-----------------------------------------------------------------------------
+// Render a value to text. 
+static char* OldPrintValue(const JSON* json, int depth, bool fmt)
+{
+    char *out=0;
+
+    switch (json->Type)
+    {
+        case JSON_Null:        out = OldStrdup("null");    break;
+        case JSON_Bool:
+            if (json->dValue == 0)
+                out = OldStrdup("false");
+            else
+                out = OldStrdup("true");
+            break;
+        case JSON_Number:    out = OldPrintNumber(json->dValue); break;
+        case JSON_String:    out = OldPrintString(json->Value.ToCStr()); break;
+        case JSON_Array:    out = OldPrintArray(json, depth, fmt); break;
+        case JSON_Object:    out = OldPrintObject(json, depth, fmt); break;
+        case JSON_None: OVR_ASSERT(false); break;
+    }
+    return out;
+}
+//-----------------------------------------------------------------------------
+// Render an array to text.  The returned text must be freed
+static char* OldPrintArray(const JSON* json, int depth, bool fmt)
+{
+    char **  entries;
+    char *   out = 0, *ptr,*ret;
+    intptr_t len = 5;
+    
+    bool fail = false;
+    
+    // How many entries in the array? 
+    int numentries = json->GetItemCount();
+    if (!numentries)
+    {
+        out=(char*)OVR_ALLOC(3);
+        if (out)
+            OVR_strcpy(out, 3, "[]");
+        return out;
+    }
+    // Allocate an array to hold the values for each
+    entries=(char**)OVR_ALLOC(numentries*sizeof(char*));
+    if (!entries)
+        return 0;
+    memset(entries,0,numentries*sizeof(char*));
+
+    //// Retrieve all the results:
+    const JSON* child = json->GetFirstItem();
+    for (int i=0; i<numentries; i++)
+    {
+        ret=OldPrintValue(child, depth+1, fmt);
+        entries[i]=ret;
+        if (ret)
+            len+=OVR_strlen(ret)+2+(fmt?1:0);
+        else
+        {
+            fail = true;
+            break;
+        }
+        child = json->GetNextItem(const_cast<JSON*>(child));
+    }
+    
+    // If we didn't fail, try to malloc the output string 
+    if (!fail)
+        out=(char*)OVR_ALLOC(len);
+    // If that fails, we fail. 
+    if (!out)
+        fail = true;
+
+    // Handle failure.
+    if (fail)
+    {
+        for (int i=0; i<numentries; i++) 
+        {
+            if (entries[i])
+                OVR_FREE(entries[i]);
+        }
+        OVR_FREE(entries);
+        return 0;
+    }
+    
+    // Compose the output array.
+    *out='[';
+    ptr=out+1;
+    *ptr='\0';
+    for (int i=0; i<numentries; i++)
+    {
+        OVR_strcpy(ptr, len - (ptr-out), entries[i]);
+        ptr+=OVR_strlen(entries[i]);
+        if (i!=numentries-1)
+        {
+            *ptr++=',';
+            if (fmt)
+                *ptr++=' ';
+            *ptr='\0';
+        }
+        OVR_FREE(entries[i]);
+    }
+    OVR_FREE(entries);
+    *ptr++=']';
+    *ptr++='\0';
+    return out;
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Render an object to text.  The returned string must be freed
+static char* OldPrintObject(const JSON* json, int depth, bool fmt)
+{
+    char**   entries = 0, **names = 0;
+    char*    out = 0;
+    char*    ptr, *ret, *str;
+    intptr_t len = 7, i = 0, j;
+    bool     fail = false;
+    
+    // Count the number of entries.
+    int numentries = json->GetItemCount();
+    
+    // Explicitly handle empty object case
+    if (numentries == 0)
+    {
+        out=(char*)OVR_ALLOC(fmt?depth+4:4);
+        if (!out)
+            return 0;
+        ptr=out;
+        *ptr++='{';
+        
+        if (fmt)
+        {
+            *ptr++='\n';
+            for (i=0;i<depth-1;i++)
+                *ptr++='\t';
+        }
+        *ptr++='}';
+        *ptr++='\0';
+        return out;
+    }
+    // Allocate space for the names and the objects
+    entries=(char**)OVR_ALLOC(numentries*sizeof(char*));
+    if (!entries)
+        return 0;
+    names=(char**)OVR_ALLOC(numentries*sizeof(char*));
+    
+    if (!names)
+    {
+        OVR_FREE(entries);
+        return 0;
+    }
+    memset(entries,0,sizeof(char*)*numentries);
+    memset(names,0,sizeof(char*)*numentries);
+
+    // Collect all the results into our arrays:
+    depth++;
+    if (fmt)
+        len+=depth;
+
+    const JSON* child = json->GetFirstItem();
+    while (child != NULL)
+    {
+        names[i]     = str = OldPrintString(child->Name.ToCStr());
+        entries[i++] = ret = OldPrintValue(child, depth, fmt);
+
+        if (str && ret)
+        {
+            len += OVR_strlen(ret)+OVR_strlen(str)+2+(fmt?2+depth:0);
+        }
+        else
+        {
+            fail = true;
+            break;
+        }
+        
+        child = json->GetNextItem(const_cast<JSON*>(child));
+    }
+    
+    // Try to allocate the output string
+    if (!fail)
+        out=(char*)OVR_ALLOC(len);
+    if (!out)
+        fail=true;
+
+    // Handle failure
+    if (fail)
+    {
+        for (i=0;i<numentries;i++)
+        {
+            if (names[i])
+                OVR_FREE(names[i]);
+            
+            if (entries[i])
+                OVR_FREE(entries[i]);}
+        
+        OVR_FREE(names);
+        OVR_FREE(entries);
+        return 0;
+    }
+    
+    // Compose the output:
+    *out = '{';
+    ptr  = out+1;
+    if (fmt)
+    {
+        *ptr++ = '\n';
+    }
+    *ptr = 0;
+    
+    for (i=0; i<numentries; i++)
+    {
+        if (fmt)
+        {
+            for (j = 0; j < depth; j++)
+            {
+                *ptr++ = '\t';
+            }
+        }
+        OVR_strcpy(ptr, len - (ptr-out), names[i]);
+        ptr   += OVR_strlen(names[i]);
+        *ptr++ =':';
+        
+        if (fmt)
+        {
+            *ptr++ = '\t';
+        }
+        
+        OVR_strcpy(ptr, len - (ptr-out), entries[i]);
+        ptr+=OVR_strlen(entries[i]);
+        
+        if (i != numentries - 1)
+        {
+            *ptr++ = ',';
+        }
+        
+        if (fmt)
+        {
+            *ptr++ = '\n';
+        }
+        *ptr = 0;
+        
+        OVR_FREE(names[i]);
+        OVR_FREE(entries[i]);
+    }
+    
+    OVR_FREE(names);
+    OVR_FREE(entries);
+    
+    if (fmt)
+    {
+        for (i = 0; i < depth - 1; i++)
+        {
+            *ptr++ = '\t';
+        }
+    }
+    *ptr++='}';
+    *ptr++='\0';
+    
+    return out; 
+}
+
+//-----------------------------------------------------------------------------------
+// Documents
+
+static const char * const DOCUMENTS[] =
+{
+	"{}",
+	"[]",
+	"{ \"a\": {}, \"b\": [], \"c\": [ {}, [], { \"d\": {} } ], \"e\": { \"f\": { \"g\": {} } } }",
+	"[ [ [ {} ] ], { \"x\": [ [], {} ] } ]",
+	"{ \"null\": null, \"true\": true, \"false\": false, \"empty\": \"\" }",
+	"{ \"escapes\": \"quote \\\" backslash \\\\ slash / \\b \\f \\n \\r \\t \\u0001 \\u001f end\", \"\\\"name\\\"\\t\": 1 }",
+	"{ \"utf8\": \"\\u00e9\\u4e2d\\u00fc\", \"raw\": \"caf\xc3\xa9\" }",
+	"[ 0, 1, -1, 7, 2147483647, -2147483648, 2147483648, -2147483649, 4294967296, 1e15, 1e20, 1e59, 1e60, 1e61, 1e200 ]",
+	"[ 0.5, -0.5, 0.1, 3.14159265358979, -2.718281828, 1e-6, 1.5e-6, 9.99e-7, 1e-7, -1e-7, 1e-300, 999999999.5, 1000000000.5, 1e9, 1.5e9, 12345.678901234 ]",
+	"{ \"Categories\": [ { \"name\": \"Favorites\", \"tags\": [ \"Favorites\" ] } ], \"Data\": [ { \"url\": \"a.jpg\", \"pos\": [ 0.25, 1.6, -3.5 ], \"thumb\": null } ] }",
+};
+
+// A tree of random numbers across all magnitudes the printer handles and strings
+// of random bytes, which include every control character.
+static JSON * MakeRandomTree( const int numItems )
+{
+	JSON * root = JSON::CreateObject();
+	JSON * numbers = JSON::CreateArray();
+	JSON * strings = JSON::CreateObject();
+	root->AddItem( "numbers", numbers );
+	root->AddItem( "strings", strings );
+	for ( int i = 0; i < numItems; i++ )
+	{
+		const double mantissa = ( rand() / (double)RAND_MAX - 0.5 ) * 20.0;
+		const int exponent = ( rand() % 90 ) - 20;
+		switch ( i % 4 )
+		{
+			case 0:	numbers->AddArrayNumber( mantissa * pow( 10.0, exponent ) ); break;
+			case 1:	numbers->AddArrayNumber( floor( mantissa * pow( 10.0, exponent ) ) ); break;
+			case 2:	numbers->AddArrayNumber( (double)( rand() - RAND_MAX / 2 ) ); break;
+			case 3:	numbers->AddArrayNumber( ( rand() % 100000 ) / 1000.0 ); break;
+		}
+
+		char name[16];
+		char value[32];
+		OVR_sprintf( name, sizeof( name ), "s%d", i );
+		const int length = rand() % ( sizeof( value ) - 1 );
+		for ( int j = 0; j < length; j++ )
+		{
+			value[j] = (char)( 1 + rand() % 255 );
+		}
+		value[length] = '\0';
+		strings->AddStringItem( name, value );
+	}
+	return root;
+}
+
+static JSON * MakeMetaData( const int megabytes )
+{
+	static const char * const categories[] = { "Favorites", "Oculus 360 Photos", "Camera", "Downloads", "Screenshots" };
+
+	JSON * root = JSON::CreateObject();
+	JSON * categoryArray = JSON::CreateArray();
+	root->AddItem( "Categories", categoryArray );
+	for ( int i = 0; i < 5; i++ )
+	{
+		JSON * category = JSON::CreateObject();
+		category->AddStringItem( "name", categories[i] );
+		JSON * tags = JSON::CreateArray();
+		tags->AddArrayString( categories[i] );
+		category->AddItem( "tags", tags );
+		categoryArray->AddArrayElement( category );
+	}
+
+	JSON * data = JSON::CreateArray();
+	root->AddItem( "Data", data );
+	// about 320 bytes pretty printed per entry
+	const int numEntries = megabytes * 1024 * 1024 / 320;
+	for ( int i = 0; i < numEntries; i++ )
+	{
+		char text[128];
+		JSON * entry = JSON::CreateObject();
+		OVR_sprintf( text, sizeof( text ), "/storage/emulated/0/Oculus/360Photos/photo_%06d.jpg", i );
+		entry->AddStringItem( "url", text );
+		OVR_sprintf( text, sizeof( text ), "Photo %d \"%s\"", i, categories[i % 5] );
+		entry->AddStringItem( "title", text );
+		OVR_sprintf( text, sizeof( text ), "Author %d", i % 97 );
+		entry->AddStringItem( "author", text );
+		JSON * tags = JSON::CreateArray();
+		tags->AddArrayString( categories[i % 5] );
+		tags->AddArrayString( categories[( i / 5 ) % 5] );
+		entry->AddItem( "tags", tags );
+		entry->AddNumberItem( "width", 4096 + ( i % 3 ) * 1024 );
+		entry->AddNumberItem( "height", 2048 + ( i % 2 ) * 2048 );
+		entry->AddNumberItem( "heading", ( i % 360 ) * 0.0174533 );
+		JSON * pos = JSON::CreateArray();
+		pos->AddArrayNumber( ( i % 17 ) * 0.25 - 2.0 );
+		pos->AddArrayNumber( 1.6 );
+		pos->AddArrayNumber( ( i % 13 ) * -0.5 );
+		entry->AddItem( "pos", pos );
+		entry->AddBoolItem( "isStereo", ( i % 4 ) == 0 );
+		entry->AddItem( "thumb", JSON::CreateNull() );
+		data->AddArrayElement( entry );
+	}
+	return root;
+}
+
+//-----------------------------------------------------------------------------------
+// Comparison
+
+// Returns true if both printers produce the same text.
+static bool SamePrint( JSON * json, const int depth, const bool fmt, const char * label )
+{
+	char * oldText = OldPrintValue( json, depth, fmt );
+	char * newText = json->PrintValue( depth, fmt );
+	const bool same = ( oldText != NULL && newText != NULL && strcmp( oldText, newText ) == 0 );
+	if ( !same )
+	{
+		int i = 0;
+		if ( oldText != NULL && newText != NULL )
+		{
+			while ( oldText[i] != '\0' && oldText[i] == newText[i] )
+			{
+				i++;
+			}
+		}
+		printf( "%s, depth %d, %s: the text differs at byte %d\n", label, depth, fmt ? "pretty" : "compact", i );
+		if ( oldText != NULL && newText != NULL )
+		{
+			printf( "  old: %.40s\n  new: %.40s\n", oldText + Alg::Max( i - 20, 0 ), newText + Alg::Max( i - 20, 0 ) );
+		}
+	}
+	OVR_FREE( oldText );
+	OVR_FREE( newText );
+	return same;
+}
+
+static bool SamePrints( JSON * json, const char * label )
+{
+	bool same = true;
+	for ( int depth = 0; depth < 2; depth++ )
+	{
+		same &= SamePrint( json, depth, false, label );
+		same &= SamePrint( json, depth, true, label );
+	}
+	return same;
+}
+
+// Saves the tree the old way, by printing the whole text and writing it in one go.
+static bool OldSave( JSON * json, const char * path )
+{
+	FILE * f = fopen( path, "wb" );
+	if ( f == NULL )
+	{
+		return false;
+	}
+	char * text = OldPrintValue( json, 0, true );
+	bool written = false;
+	if ( text != NULL )
+	{
+		const size_t length = strlen( text );
+		written = ( fwrite( text, 1, length, f ) == length );
+		OVR_FREE( text );
+	}
+	fclose( f );
+	return written;
+}
+
+// Returns true if the file holds exactly the text.
+static bool FileMatches( const char * path, const char * text )
+{
+	FILE * f = fopen( path, "rb" );
+	if ( f == NULL )
+	{
+		return false;
+	}
+	const size_t length = strlen( text );
+	char * data = (char *)malloc( length + 1 );
+	const size_t read = fread( data, 1, length + 1, f );
+	fclose( f );
+	const bool same = ( read == length && memcmp( data, text, length ) == 0 );
+	free( data );
+	return same;
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	srand( 1 );
+
+	bool failed = false;
+
+	for ( int i = 0; i < (int)( sizeof( DOCUMENTS ) / sizeof( DOCUMENTS[0] ) ); i++ )
+	{
+		char label[32];
+		OVR_sprintf( label, sizeof( label ), "document %d", i );
+		const char * error = NULL;
+		JSON * json = JSON::Parse( DOCUMENTS[i], &error );
+		if ( json == NULL )
+		{
+			printf( "%s does not parse: %s\n", label, error != NULL ? error : "" );
+			failed = true;
+			continue;
+		}
+		failed |= !SamePrints( json, label );
+		json->Release();
+	}
+
+	JSON * randomTree = MakeRandomTree( 20000 );
+	failed |= !SamePrints( randomTree, "random tree" );
+	randomTree->Release();
+
+	JSON * metaData = MakeMetaData( META_DATA_MEGABYTES );
+	failed |= !SamePrints( metaData, "meta data" );
+
+	const double oldPrintStart = BenchSeconds();
+	char * oldText = OldPrintValue( metaData, 0, true );
+	const double oldPrintTime = BenchSeconds() - oldPrintStart;
+
+	const double newPrintStart = BenchSeconds();
+	char * newText = metaData->PrintValue( 0, true );
+	const double newPrintTime = BenchSeconds() - newPrintStart;
+	OVR_FREE( newText );
+
+	const double oldSaveStart = BenchSeconds();
+	const bool oldSaved = OldSave( metaData, SAVE_FILE_NAME );
+	const double oldSaveTime = BenchSeconds() - oldSaveStart;
+
+	const double newSaveStart = BenchSeconds();
+	const bool newSaved = metaData->Save( SAVE_FILE_NAME );
+	const double newSaveTime = BenchSeconds() - newSaveStart;
+
+	if ( !oldSaved || !newSaved || oldText == NULL || !FileMatches( SAVE_FILE_NAME, oldText ) )
+	{
+		printf( "meta data: the saved file differs from the old printer\n" );
+		failed = true;
+	}
+
+	printf( "meta data, %.1f MB: print old %6.2f ms, new %6.2f ms, %.2fx; save old %6.2f ms, new %6.2f ms, %.2fx\n",
+			oldText != NULL ? strlen( oldText ) / ( 1024.0 * 1024.0 ) : 0.0,
+			oldPrintTime * 1e3, newPrintTime * 1e3, oldPrintTime / newPrintTime,
+			oldSaveTime * 1e3, newSaveTime * 1e3, oldSaveTime / newSaveTime );
+
+	OVR_FREE( oldText );
+	metaData->Release();
+	remove( SAVE_FILE_NAME );
+
+	printf( failed ? "FAILED: JsonWriter output differs from the old printer\n" : "PASSED: JsonWriter output is byte identical to the old printer\n" );
+	return failed ? 1 : 0;
+}
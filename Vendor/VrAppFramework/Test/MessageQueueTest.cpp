@@ -0,0 +1,353 @@
+/************************************************************************************
+
+Filename    :   MessageQueueTest.cpp
+Content     :   Host test and contention benchmark for the message queue
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Posts messages from 1, 2, 4 and 8 producer threads to one consumer thread,
+// once through ovrMessageQueue and once through the locked string queue that
+// it replaced, which strdup'ed every message and was parsed with sscanf.
+//
+// Every producer numbers its messages, every 8th message carries a blob, some
+// of them too large for the blob pool, and every 1000th message is sent synced.
+// The consumer checks that the messages of each producer arrive in order and
+// that every blob is intact, or the test fails.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test test
+
+#include "MessageQueue.h"
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Threads.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int PRODUCER_COUNTS[]	= { 1, 2, 4, 8 };
+static const int MAX_PRODUCERS		= 8;
+static const int NUM_MESSAGES		= 50000;	// per producer
+static const int QUEUE_SIZE			= 256;
+static const int MESSAGE_TEST		= MESSAGE_FIRST_USER;
+
+static int BlobSize( const int sequence )
+{
+	// Every 4th blob does not fit in the pool.
+	return ( ( sequence / 8 ) % 4 == 3 ) ? MESSAGE_BLOB_SIZE + 64 : 16 + ( sequence % MESSAGE_BLOB_SIZE ) / 2;
+}
+
+static UByte BlobByte( const int producer, const int sequence, const int i )
+{
+	return (UByte)( producer * 31 + sequence * 7 + i );
+}
+
+//-----------------------------------------------------------------------------------
+// The locked string queue as it was before typed messages
+
+class OldMessageQueue
+{
+public:
+	OldMessageQueue( int maxMessages_ ) :
+		maxMessages( maxMessages_ ),
+		messages( new message_t[maxMessages_] ),
+		head( 0 ),
+		tail( 0 ),
+		synced( false )
+	{
+		for ( int i = 0; i < maxMessages; i++ )
+		{
+			messages[i].string = NULL;
+			messages[i].synced = false;
+		}
+	}
+	~OldMessageQueue()
+	{
+		delete[] messages;
+	}
+
+	bool PostMessage( const char * msg, bool sync )
+	{
+		mutex.DoLock();
+		if ( tail - head >= maxMessages )
+		{
+			mutex.Unlock();
+			return false;
+		}
+		const int index = tail % maxMessages;
+		messages[index].string = strdup( msg );
+		messages[index].synced = sync;
+		tail++;
+		posted.NotifyAll();
+		if ( sync )
+		{
+			processed.Wait( &mutex );
+		}
+		mutex.Unlock();
+		return true;
+	}
+
+	const char * GetNextMessage()
+	{
+		NotifyMessageProcessed();
+
+		mutex.DoLock();
+		if ( tail <= head )
+		{
+			mutex.Unlock();
+			return NULL;
+		}
+		const int index = head % maxMessages;
+		const char * msg = messages[index].string;
+		synced = messages[index].synced;
+		messages[index].string = NULL;
+		messages[index].synced = false;
+		head++;
+		mutex.Unlock();
+		return msg;
+	}
+
+	void SleepUntilMessage()
+	{
+		NotifyMessageProcessed();
+
+		mutex.DoLock();
+		if ( tail > head )
+		{
+			mutex.Unlock();
+			return;
+		}
+		posted.Wait( &mutex );
+		mutex.Unlock();
+	}
+
+	void NotifyMessageProcessed()
+	{
+		if ( synced )
+		{
+			mutex.DoLock();
+			processed.NotifyAll();
+			mutex.Unlock();
+			synced = false;
+		}
+	}
+
+private:
+	struct message_t
+	{
+		const char *	string;
+		bool			synced;
+	};
+
+	int				maxMessages;
+	message_t *		messages;
+	int				head;
+	int				tail;
+	bool			synced;
+	Mutex			mutex;
+	WaitCondition	posted;
+	WaitCondition	processed;
+};
+
+//-----------------------------------------------------------------------------------
+// Producers
+
+struct Producer
+{
+	ovrMessageQueue *	Queue;
+	OldMessageQueue *	OldQueue;
+	int					Index;
+};
+
+static threadReturn_t ProducerThread( Thread * thread, void * v )
+{
+	const Producer * producer = (const Producer *)v;
+
+	UByte blob[MESSAGE_BLOB_SIZE + 64];
+	for ( int sequence = 0; sequence < NUM_MESSAGES; sequence++ )
+	{
+		ovrMessage msg( MESSAGE_TEST );
+		msg.Int[0] = producer->Index;
+		msg.Int[1] = sequence;
+		if ( ( sequence % 8 ) == 0 )
+		{
+			msg.BlobSize = BlobSize( sequence );
+			for ( int i = 0; i < msg.BlobSize; i++ )
+			{
+				blob[i] = BlobByte( producer->Index, sequence, i );
+			}
+			msg.Blob = blob;
+		}
+		const bool sync = ( sequence % 1000 ) == 999;
+		while ( !( sync ? producer->Queue->TrySend( msg ) : producer->Queue->TryPost( msg ) ) )
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static threadReturn_t OldProducerThread( Thread * thread, void * v )
+{
+	const Producer * producer = (const Producer *)v;
+
+	for ( int sequence = 0; sequence < NUM_MESSAGES; sequence++ )
+	{
+		char text[64];
+		snprintf( text, sizeof( text ), "test %i %i", producer->Index, sequence );
+		while ( !producer->OldQueue->PostMessage( text, ( sequence % 1000 ) == 999 ) )
+		{
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void StartProducers( Producer * producers, Thread ** threads, const int numProducers,
+							ovrMessageQueue * queue, OldMessageQueue * oldQueue )
+{
+	for ( int i = 0; i < numProducers; i++ )
+	{
+		producers[i].Queue = queue;
+		producers[i].OldQueue = oldQueue;
+		producers[i].Index = i;
+		threads[i] = new Thread( Thread::CreateParams( queue != NULL ? ProducerThread : OldProducerThread, &producers[i], 128 * 1024 ) );
+		threads[i]->Start();
+	}
+}
+
+static void JoinProducers( Thread ** threads, const int numProducers )
+{
+	for ( int i = 0; i < numProducers; i++ )
+	{
+		threads[i]->Join();
+		delete threads[i];
+	}
+}
+
+//-----------------------------------------------------------------------------------
+// Consumers
+
+// Returns the number of errors.
+static int ConsumeMessages( ovrMessageQueue & queue, const int numProducers )
+{
+	int expected[MAX_PRODUCERS] = { 0 };
+	int errors = 0;
+	for ( int received = 0; received < numProducers * NUM_MESSAGES; )
+	{
+		ovrMessage msg;
+		if ( !queue.GetNextMessage( msg ) )
+		{
+			queue.SleepUntilMessage();
+			continue;
+		}
+		received++;
+
+		const int producer = msg.Int[0];
+		const int sequence = msg.Int[1];
+		bool ok = ( msg.Opcode == MESSAGE_TEST && producer >= 0 && producer < numProducers && sequence == expected[producer] );
+		if ( ok && ( sequence % 8 ) == 0 )
+		{
+			ok = ( msg.BlobSize == BlobSize( sequence ) && msg.Blob != NULL );
+			for ( int i = 0; ok && i < msg.BlobSize; i++ )
+			{
+				ok = ( ((const UByte *)msg.Blob)[i] == BlobByte( producer, sequence, i ) );
+			}
+		}
+		else if ( ok )
+		{
+			ok = ( msg.Blob == NULL );
+		}
+		if ( !ok )
+		{
+			if ( errors++ < 10 )
+			{
+				printf( "message from producer %d with sequence %d is wrong\n", producer, sequence );
+			}
+			if ( producer < 0 || producer >= numProducers )
+			{
+				continue;
+			}
+		}
+		expected[producer] = sequence + 1;
+	}
+	queue.NotifyMessageProcessed();
+	return errors;
+}
+
+static int ConsumeOldMessages( OldMessageQueue & queue, const int numProducers )
+{
+	int expected[MAX_PRODUCERS] = { 0 };
+	int errors = 0;
+	for ( int received = 0; received < numProducers * NUM_MESSAGES; )
+	{
+		const char * text = queue.GetNextMessage();
+		if ( text == NULL )
+		{
+			queue.SleepUntilMessage();
+			continue;
+		}
+		received++;
+
+		int producer = -1;
+		int sequence = -1;
+		if ( sscanf( text, "test %i %i", &producer, &sequence ) != 2 || producer < 0 || producer >= numProducers ||
+				sequence != expected[producer] )
+		{
+			errors++;
+		}
+		else
+		{
+			expected[producer] = sequence + 1;
+		}
+		free( (void *)text );
+	}
+	queue.NotifyMessageProcessed();
+	return errors;
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	bool failed = false;
+	for ( int p = 0; p < (int)( sizeof( PRODUCER_COUNTS ) / sizeof( PRODUCER_COUNTS[0] ) ); p++ )
+	{
+		const int numProducers = PRODUCER_COUNTS[p];
+		Producer producers[MAX_PRODUCERS];
+		Thread * threads[MAX_PRODUCERS];
+
+		OldMessageQueue oldQueue( QUEUE_SIZE );
+		const double oldStart = BenchSeconds();
+		StartProducers( producers, threads, numProducers, NULL, &oldQueue );
+		const int oldErrors = ConsumeOldMessages( oldQueue, numProducers );
+		JoinProducers( threads, numProducers );
+		const double oldTime = BenchSeconds() - oldStart;
+
+		ovrMessageQueue queue( QUEUE_SIZE );
+		const double newStart = BenchSeconds();
+		StartProducers( producers, threads, numProducers, &queue, NULL );
+		const int errors = ConsumeMessages( queue, numProducers );
+		JoinProducers( threads, numProducers );
+		const double newTime = BenchSeconds() - newStart;
+
+		failed |= ( errors != 0 || oldErrors != 0 );
+
+		const double numMessages = (double)numProducers * NUM_MESSAGES;
+		printf( "%d producers: string queue %6.3f M msgs/s, typed queue %6.3f M msgs/s, %.2fx\n",
+				numProducers, numMessages / oldTime * 1e-6, numMessages / newTime * 1e-6, oldTime / newTime );
+	}
+
+	printf( failed ? "FAILED: messages were lost, reordered or corrupted\n" : "PASSED: all messages arrived in order and intact\n" );
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,270 @@
+/************************************************************************************
+
+Filename    :   ModelCullBench.cpp
+Content     :   Host benchmark for the batched model surface cull
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Culls 1k to 100k surfaces with random bounds and model matrices against a
+// perspective view, once with the one-surface-at-a-time cull the model renderer
+// used before, and once four at a time with BoundsSortCullKeys.  Every sort key
+// has to match the old cull bit for bit, or the test fails.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test bench
+
+#include "ModelCull.h"
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int SURFACE_COUNTS[]	= { 1000, 10000, 100000 };
+static const int NUM_FRAMES			= 20;
+
+// The cull as it was before surfaces were batched.
+static float OldBoundsSortCullKey( const Bounds3f & bounds, const Matrix4f & mvp )
+{
+	// Always cull empty bounds, which can be used to disable a surface.
+	// Don't just check a single axis, or billboards would be culled.
+	if ( bounds.b[1].x == bounds.b[0].x &&  bounds.b[1].y == bounds.b[0].y )
+	{
+		return 0;
+	}
+
+	// Not very efficient code...
+	Vector4f c[8];
+	for ( int i = 0; i < 8; i++ )
+	{
+		Vector4f world;
+		world.x = bounds.b[(i&1)].x;
+		world.y = bounds.b[(i&2)>>1].y;
+		world.z = bounds.b[(i&4)>>2].z;
+		world.w = 1.0f;
+
+		c[i] = mvp.Transform( world );
+	}
+
+	int i;
+	for ( i = 0; i < 8; i++ )
+	{
+		if ( c[i].x > -c[i].w )
+		{
+			break;
+		}
+	}
+	if ( i == 8 )
+	{
+		return 0;	// all off one side
+	}
+	for ( i = 0; i < 8; i++ )
+	{
+		if ( c[i].x < c[i].w )
+		{
+			break;
+		}
+	}
+	if ( i == 8 )
+	{
+		return 0;	// all off one side
+	}
+
+	for ( i = 0; i < 8; i++ )
+	{
+		if ( c[i].y > -c[i].w )
+		{
+			break;
+		}
+	}
+	if ( i == 8 )
+	{
+		return 0;	// all off one side
+	}
+	for ( i = 0; i < 8; i++ )
+	{
+		if ( c[i].y < c[i].w )
+		{
+			break;
+		}
+	}
+	if ( i == 8 )
+	{
+		return 0;	// all off one side
+	}
+
+	for ( i = 0; i < 8; i++ )
+	{
+		if ( c[i].z > -c[i].w )
+		{
+			break;
+		}
+	}
+	if ( i == 8 )
+	{
+		return 0;	// all off one side
+	}
+	for ( i = 0; i < 8; i++ )
+	{
+		if ( c[i].z < c[i].w )
+		{
+			break;
+		}
+	}
+	if ( i == 8 )
+	{
+		return 0;	// all off one side
+	}
+
+	// calculate the farthest W point for front to back sorting
+	float maxW = 0;
+	for ( i = 0; i < 8; i++ )
+	{
+		const float w = c[i].w;
+		if ( w > maxW )
+		{
+			maxW = w;
+		}
+	}
+
+	return maxW;		// couldn't cull
+}
+
+static float RandomFloat( const float min, const float max )
+{
+	return min + ( max - min ) * ( rand() / (float)RAND_MAX );
+}
+
+struct Surface
+{
+	Bounds3f	bounds;
+	Matrix4f	modelMatrix;
+};
+
+// Objects are scattered all around the viewer, so most of them are culled by
+// one plane or another, and every 16th bounds is empty.
+static void MakeSurfaces( Array< Surface > & surfaces, const int count )
+{
+	surfaces.Resize( count );
+	for ( int i = 0; i < count; i++ )
+	{
+		const Vector3f size( RandomFloat( 0.1f, 4.0f ), RandomFloat( 0.1f, 4.0f ), RandomFloat( 0.1f, 4.0f ) );
+		const Vector3f mins( RandomFloat( -2.0f, 0.0f ), RandomFloat( -2.0f, 0.0f ), RandomFloat( -2.0f, 0.0f ) );
+		surfaces[i].bounds = Bounds3f( mins, ( i % 16 ) == 0 ? Vector3f( mins.x, mins.y, mins.z + size.z ) : mins + size );
+		surfaces[i].modelMatrix = Matrix4f::Translation( RandomFloat( -50.0f, 50.0f ), RandomFloat( -10.0f, 10.0f ), RandomFloat( -50.0f, 50.0f ) ) *
+									Matrix4f::RotationY( RandomFloat( 0.0f, 6.28f ) );
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	srand( 1 );
+
+	const Matrix4f viewMatrix = Matrix4f::LookAtRH( Vector3f( 0.0f, 1.5f, 0.0f ), Vector3f( 0.3f, 1.5f, -1.0f ), Vector3f( 0.0f, 1.0f, 0.0f ) );
+	const Matrix4f projectionMatrix = Matrix4f::PerspectiveRH( DegreeToRad( 90.0f ), 1.0f, 0.1f, 1000.0f );
+	const Matrix4f vpMatrix = projectionMatrix * viewMatrix;
+
+	bool failed = false;
+	for ( int c = 0; c < (int)( sizeof( SURFACE_COUNTS ) / sizeof( SURFACE_COUNTS[0] ) ); c++ )
+	{
+		const int count = SURFACE_COUNTS[c];
+		Array< Surface > surfaces;
+		MakeSurfaces( surfaces, count );
+
+		ArrayPOD< float > oldKeys;
+		ArrayPOD< float > newKeys;
+		ArrayPOD< ModelCullBatch > batches;
+		batches.Resize( ( count + MODEL_CULL_BATCH_SIZE - 1 ) / MODEL_CULL_BATCH_SIZE );
+		memset( batches.GetDataPtr(), 0, batches.GetSize() * sizeof( ModelCullBatch ) );
+		oldKeys.Resize( count );
+		newKeys.Resize( batches.GetSize() * MODEL_CULL_BATCH_SIZE );
+
+		// The kernels alone, with the mvp matrices already computed.
+		Array< Matrix4f > mvps;
+		mvps.Resize( count );
+		for ( int i = 0; i < count; i++ )
+		{
+			mvps[i] = vpMatrix * surfaces[i].modelMatrix;
+			SetCullBatchSurface( batches[i / MODEL_CULL_BATCH_SIZE], i % MODEL_CULL_BATCH_SIZE, surfaces[i].bounds, mvps[i] );
+		}
+
+		const double oldCullStart = BenchSeconds();
+		for ( int frame = 0; frame < NUM_FRAMES; frame++ )
+		{
+			for ( int i = 0; i < count; i++ )
+			{
+				oldKeys[i] = OldBoundsSortCullKey( surfaces[i].bounds, mvps[i] );
+			}
+		}
+		const double oldCullTime = ( BenchSeconds() - oldCullStart ) / NUM_FRAMES;
+
+		const double newCullStart = BenchSeconds();
+		for ( int frame = 0; frame < NUM_FRAMES; frame++ )
+		{
+			for ( int i = 0; i < batches.GetSizeI(); i++ )
+			{
+				BoundsSortCullKeys( batches[i], &newKeys[i * MODEL_CULL_BATCH_SIZE] );
+			}
+		}
+		const double newCullTime = ( BenchSeconds() - newCullStart ) / NUM_FRAMES;
+
+		// Both paths including the mvp multiply, as BuildModelSurfaceList does.
+		const double oldStart = BenchSeconds();
+		for ( int frame = 0; frame < NUM_FRAMES; frame++ )
+		{
+			for ( int i = 0; i < count; i++ )
+			{
+				oldKeys[i] = OldBoundsSortCullKey( surfaces[i].bounds, vpMatrix * surfaces[i].modelMatrix );
+			}
+		}
+		const double oldTime = ( BenchSeconds() - oldStart ) / NUM_FRAMES;
+
+		const double newStart = BenchSeconds();
+		for ( int frame = 0; frame < NUM_FRAMES; frame++ )
+		{
+			for ( int i = 0; i < count; i++ )
+			{
+				SetCullBatchSurface( batches[i / MODEL_CULL_BATCH_SIZE], i % MODEL_CULL_BATCH_SIZE, surfaces[i].bounds, vpMatrix * surfaces[i].modelMatrix );
+			}
+			for ( int i = 0; i < batches.GetSizeI(); i++ )
+			{
+				BoundsSortCullKeys( batches[i], &newKeys[i * MODEL_CULL_BATCH_SIZE] );
+			}
+		}
+		const double newTime = ( BenchSeconds() - newStart ) / NUM_FRAMES;
+
+		int visible = 0;
+		int mismatches = 0;
+		for ( int i = 0; i < count; i++ )
+		{
+			visible += ( oldKeys[i] != 0.0f );
+			if ( memcmp( &oldKeys[i], &newKeys[i], sizeof( float ) ) != 0 )
+			{
+				if ( mismatches++ < 10 )
+				{
+					printf( "surface %d: old key %.9g, new key %.9g\n", i, oldKeys[i], newKeys[i] );
+				}
+			}
+		}
+		failed |= ( mismatches != 0 );
+
+		printf( "%6d surfaces, %6d visible: cull old %7.3f ms, batched %7.3f ms, %.2fx; with mvp old %7.3f ms, batched %7.3f ms, %.2fx\n",
+				count, visible, oldCullTime * 1e3, newCullTime * 1e3, oldCullTime / newCullTime,
+				oldTime * 1e3, newTime * 1e3, oldTime / newTime );
+	}
+
+	printf( failed ? "FAILED: cull keys differ from the old cull\n" : "PASSED: cull keys match the old cull\n" );
+	return failed ? 1 : 0;
+}
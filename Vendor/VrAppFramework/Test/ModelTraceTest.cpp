@@ -0,0 +1,271 @@
+/************************************************************************************
+
+Filename    :   ModelTraceTest.cpp
+Content     :   Host test for building and tracing the model KD-tree
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Builds the KD-tree of scenes of 1k to 100k triangles with ModelTrace::Build,
+// the way model files without a prebuilt tree are loaded, and traces rays from
+// a viewer in the middle of the scene with Trace and with Trace_Exhaustive.  The
+// tree has to validate, and every ray has to hit the same distance as the
+// exhaustive trace, or the test fails.
+//
+// The same rays are then traced with TraceBatch, once in random order and once
+// as a coherent view grid, and every result has to match Trace bit for bit.
+// The Makefile builds this test with -ffp-contract=off, like the Android build
+// of ModelTrace.cpp, because contracting the ray setup into fused multiply-adds
+// in one path and not the other changes the last bits of the results.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test test
+
+#include "ModelTrace.h"
+#include "BenchTimer.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int TRIANGLE_COUNTS[]	= { 1000, 10000, 100000 };
+static const int NUM_RAYS			= 20000;
+static const int NUM_EXHAUSTIVE		= 200;
+static const int VIEW_GRID_SIZE		= 128;
+
+static float RandomFloat( const float min, const float max )
+{
+	return min + ( max - min ) * ( rand() / (float)RAND_MAX );
+}
+
+static Vector3f RandomDirection()
+{
+	for ( ; ; )
+	{
+		const Vector3f dir( RandomFloat( -1.0f, 1.0f ), RandomFloat( -1.0f, 1.0f ), RandomFloat( -1.0f, 1.0f ) );
+		const float lengthSq = dir.LengthSq();
+		if ( lengthSq > 0.01f && lengthSq <= 1.0f )
+		{
+			return dir / sqrtf( lengthSq );
+		}
+	}
+}
+
+// An upward facing floor made of quads with small triangles scattered above
+// it, about as dense as the clutter in a room.
+static void MakeScene( ModelTrace & model, const int numTriangles )
+{
+	const int floorQuads = 16;
+	const float floorSize = 40.0f;
+
+	model.vertices.Clear();
+	model.uvs.Clear();
+	model.indices.Clear();
+
+	for ( int z = 0; z <= floorQuads; z++ )
+	{
+		for ( int x = 0; x <= floorQuads; x++ )
+		{
+			model.vertices.PushBack( Vector3f( ( x / (float)floorQuads - 0.5f ) * floorSize, 0.0f, ( z / (float)floorQuads - 0.5f ) * floorSize ) );
+			model.uvs.PushBack( Vector2f( x / (float)floorQuads, z / (float)floorQuads ) );
+		}
+	}
+	for ( int z = 0; z < floorQuads; z++ )
+	{
+		for ( int x = 0; x < floorQuads; x++ )
+		{
+			const int v = z * ( floorQuads + 1 ) + x;
+			model.indices.PushBack( v );
+			model.indices.PushBack( v + floorQuads + 1 );
+			model.indices.PushBack( v + 1 );
+			model.indices.PushBack( v + 1 );
+			model.indices.PushBack( v + floorQuads + 1 );
+			model.indices.PushBack( v + floorQuads + 2 );
+		}
+	}
+
+	while ( model.indices.GetSizeI() / 3 < numTriangles )
+	{
+		const Vector3f center( RandomFloat( -20.0f, 20.0f ), RandomFloat( 0.0f, 4.0f ), RandomFloat( -20.0f, 20.0f ) );
+		const float size = RandomFloat( 0.05f, 0.5f );
+		for ( int i = 0; i < 3; i++ )
+		{
+			model.indices.PushBack( model.vertices.GetSizeI() );
+			model.vertices.PushBack( center + RandomDirection() * size );
+			model.uvs.PushBack( Vector2f( RandomFloat( 0.0f, 1.0f ), RandomFloat( 0.0f, 1.0f ) ) );
+		}
+	}
+}
+
+static bool SameHit( const traceResult_t & a, const traceResult_t & b )
+{
+	if ( ( a.triangleIndex < 0 ) != ( b.triangleIndex < 0 ) )
+	{
+		return false;
+	}
+	return fabsf( a.fraction - b.fraction ) <= 1e-5f;
+}
+
+// Rays through a grid over a 90 degree view, in row order, so rays next to each
+// other in the batch go through the same leafs.
+static void MakeViewGrid( Array< Vector3f > & ends, const Vector3f & eye )
+{
+	const Matrix4f view = Matrix4f::RotationY( 0.5f ) * Matrix4f::RotationX( -0.3f );
+	ends.Resize( VIEW_GRID_SIZE * VIEW_GRID_SIZE );
+	for ( int y = 0; y < VIEW_GRID_SIZE; y++ )
+	{
+		for ( int x = 0; x < VIEW_GRID_SIZE; x++ )
+		{
+			const Vector3f dir( ( x + 0.5f ) / VIEW_GRID_SIZE * 2.0f - 1.0f, ( y + 0.5f ) / VIEW_GRID_SIZE * 2.0f - 1.0f, -1.0f );
+			ends[y * VIEW_GRID_SIZE + x] = eye + view.Transform( dir.Normalized() ) * 50.0f;
+		}
+	}
+}
+
+// Traces the rays with Trace and TraceBatch, and returns the number of results that
+// are not bit identical.
+static int CompareTraceBatch( const ModelTrace & model, const Vector3f & eye, const Array< Vector3f > & ends,
+								double & traceRate, double & batchRate )
+{
+	const int numRays = ends.GetSizeI();
+
+	Array< Vector3f > starts;
+	starts.Resize( numRays );
+	for ( int i = 0; i < numRays; i++ )
+	{
+		starts[i] = eye;
+	}
+
+	Array< traceResult_t > results;
+	Array< traceResult_t > batchResults;
+	results.Resize( numRays );
+	batchResults.Resize( numRays );
+
+	const double traceStart = BenchSeconds();
+	for ( int i = 0; i < numRays; i++ )
+	{
+		results[i] = model.Trace( starts[i], ends[i] );
+	}
+	traceRate = numRays / ( BenchSeconds() - traceStart );
+
+	const double batchStart = BenchSeconds();
+	model.TraceBatch( starts.GetDataPtr(), ends.GetDataPtr(), batchResults.GetDataPtr(), numRays );
+	batchRate = numRays / ( BenchSeconds() - batchStart );
+
+	int mismatches = 0;
+	for ( int i = 0; i < numRays; i++ )
+	{
+		const traceResult_t & a = results[i];
+		const traceResult_t & b = batchResults[i];
+		if ( a.triangleIndex != b.triangleIndex || memcmp( &a.fraction, &b.fraction, sizeof( a.fraction ) ) != 0 ||
+				memcmp( &a.uv, &b.uv, sizeof( a.uv ) ) != 0 || memcmp( &a.normal, &b.normal, sizeof( a.normal ) ) != 0 )
+		{
+			if ( mismatches++ < 10 )
+			{
+				printf( "ray %d: Trace hit %d at %.9g, TraceBatch hit %d at %.9g\n", i, a.triangleIndex, a.fraction, b.triangleIndex, b.fraction );
+			}
+		}
+	}
+	return mismatches;
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	srand( 1 );
+
+	const Vector3f eye( 0.0f, 1.6f, 0.0f );
+
+	bool failed = false;
+	bool batchFailed = false;
+	for ( int c = 0; c < (int)( sizeof( TRIANGLE_COUNTS ) / sizeof( TRIANGLE_COUNTS[0] ) ); c++ )
+	{
+		ModelTrace model;
+		MakeScene( model, TRIANGLE_COUNTS[c] );
+
+		const double buildStart = BenchSeconds();
+		const bool built = model.Build();
+		const double buildTime = BenchSeconds() - buildStart;
+		if ( !built )
+		{
+			printf( "%6d triangles: the built tree does not validate\n", TRIANGLE_COUNTS[c] );
+			failed = true;
+			continue;
+		}
+
+		Array< Vector3f > ends;
+		ends.Resize( NUM_RAYS );
+		for ( int i = 0; i < NUM_RAYS; i++ )
+		{
+			ends[i] = eye + RandomDirection() * 50.0f;
+		}
+
+		Array< traceResult_t > results;
+		results.Resize( NUM_RAYS );
+
+		const double traceStart = BenchSeconds();
+		for ( int i = 0; i < NUM_RAYS; i++ )
+		{
+			results[i] = model.Trace( eye, ends[i] );
+		}
+		const double traceTime = BenchSeconds() - traceStart;
+
+		const double exhaustiveStart = BenchSeconds();
+		int hits = 0;
+		int mismatches = 0;
+		for ( int i = 0; i < NUM_EXHAUSTIVE; i++ )
+		{
+			const traceResult_t exhaustive = model.Trace_Exhaustive( eye, ends[i] );
+			hits += ( exhaustive.triangleIndex >= 0 );
+			if ( !SameHit( results[i], exhaustive ) )
+			{
+				if ( mismatches++ < 10 )
+				{
+					printf( "ray %d: tree hit %d at %.7f, exhaustive hit %d at %.7f\n", i,
+							results[i].triangleIndex, results[i].fraction, exhaustive.triangleIndex, exhaustive.fraction );
+				}
+			}
+		}
+		const double exhaustiveTime = BenchSeconds() - exhaustiveStart;
+		failed |= ( mismatches != 0 );
+
+		const double treeRate = NUM_RAYS / traceTime;
+		const double exhaustiveRate = NUM_EXHAUSTIVE / exhaustiveTime;
+		printf( "%6d triangles: build %7.2f ms, %5d nodes, %5d leafs; %3d of %d rays hit; tree %9.0f rays/s, exhaustive %8.0f rays/s, %.0fx\n",
+				TRIANGLE_COUNTS[c], buildTime * 1e3, model.header.numNodes, model.header.numLeafs, hits, NUM_EXHAUSTIVE,
+				treeRate, exhaustiveRate, treeRate / exhaustiveRate );
+
+		double incoherentTraceRate;
+		double incoherentBatchRate;
+		const int incoherentMismatches = CompareTraceBatch( model, eye, ends, incoherentTraceRate, incoherentBatchRate );
+
+		Array< Vector3f > gridEnds;
+		MakeViewGrid( gridEnds, eye );
+		double coherentTraceRate;
+		double coherentBatchRate;
+		const int coherentMismatches = CompareTraceBatch( model, eye, gridEnds, coherentTraceRate, coherentBatchRate );
+
+		batchFailed |= ( incoherentMismatches != 0 || coherentMismatches != 0 );
+
+		printf( "%6d triangles: incoherent Trace %6.3f Mrays/s, TraceBatch %6.3f Mrays/s, %.2fx; coherent Trace %6.3f Mrays/s, TraceBatch %6.3f Mrays/s, %.2fx\n",
+				TRIANGLE_COUNTS[c],
+				incoherentTraceRate * 1e-6, incoherentBatchRate * 1e-6, incoherentBatchRate / incoherentTraceRate,
+				coherentTraceRate * 1e-6, coherentBatchRate * 1e-6, coherentBatchRate / coherentTraceRate );
+	}
+
+	printf( failed ? "FAILED: traces differ from the exhaustive trace\n" : "PASSED: traces match the exhaustive trace\n" );
+	printf( batchFailed ? "FAILED: batched traces differ from Trace\n" : "PASSED: batched traces match Trace bit for bit\n" );
+	failed |= batchFailed;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/************************************************************************************
+
+Filename    :   ModelZipTest.cpp
+Content     :   Host test for reading the entries of zipped model files
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Writes a model zip with a models.json, a models.bin and a set of textures of
+// different sizes, some of them stored, and reads all entries with
+// ReadModelZipEntries, once one at a time through the zip file like the model
+// loader did before, and once from memory with inflate services of 1, 2, 4 and 8
+// workers.  Every entry is checked against its contents.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test test
+
+#include "ModelZip.h"
+#include "BenchTimer.h"
+#include "zip.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_Std.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int NUM_TEXTURES		= 48;
+static const int WORKER_COUNTS[]	= { 1, 2, 4, 8 };
+static const int NUM_RUNS			= 5;
+static const char * ZIP_PATH		= "ModelZipTest.zip";
+
+struct TestEntry
+{
+	char				name[64];
+	ArrayPOD< char >	contents;
+	bool				stored;
+};
+
+// Compressible contents, like texture data and vertex arrays.
+static void MakeContents( TestEntry & entry, const int size, const int seed )
+{
+	entry.contents.Resize( size );
+	UInt32 value = seed * 2654435761u;
+	for ( int i = 0; i < size; i++ )
+	{
+		if ( ( i & 63 ) == 0 )
+		{
+			value = value * 1664525u + 1013904223u;
+		}
+		entry.contents[i] = (char)( ( value >> ( ( i & 3 ) * 8 ) ) & 0x3F );
+	}
+}
+
+static void MakeEntries( Array< TestEntry > & entries )
+{
+	entries.Resize( NUM_TEXTURES + 2 );
+
+	OVR_strcpy( entries[0].name, sizeof( entries[0].name ), "models.json" );
+	MakeContents( entries[0], 2 * 1024 * 1024, 1 );
+	entries[0].stored = false;
+
+	OVR_strcpy( entries[1].name, sizeof( entries[1].name ), "models.bin" );
+	MakeContents( entries[1], 8 * 1024 * 1024, 2 );
+	entries[1].stored = false;
+
+	for ( int i = 0; i < NUM_TEXTURES; i++ )
+	{
+		TestEntry & entry = entries[2 + i];
+		OVR_sprintf( entry.name, sizeof( entry.name ), ( i & 1 ) ? "texture%d.ktx" : "texture%d.pvr", i );
+		MakeContents( entry, ( 64 << ( i % 6 ) ) * 1024, 3 + i );
+		entry.stored = ( i % 5 ) == 0;
+	}
+}
+
+static bool WriteZip( const Array< TestEntry > & entries )
+{
+	zipFile zf = zipOpen( ZIP_PATH, 0 );
+	if ( zf == NULL )
+	{
+		return false;
+	}
+	for ( int i = 0; i < entries.GetSizeI(); i++ )
+	{
+		const TestEntry & entry = entries[i];
+		zip_fileinfo info;
+		memset( &info, 0, sizeof( info ) );
+		if ( zipOpenNewFileInZip( zf, entry.name, &info, NULL, 0, NULL, 0, NULL,
+								entry.stored ? 0 : Z_DEFLATED, entry.stored ? 0 : Z_DEFAULT_COMPRESSION ) != ZIP_OK ||
+			zipWriteInFileInZip( zf, entry.contents.GetDataPtr(), entry.contents.GetSize() ) != ZIP_OK ||
+			zipCloseFileInZip( zf ) != ZIP_OK )
+		{
+			zipClose( zf, NULL );
+			return false;
+		}
+	}
+	return zipClose( zf, NULL ) == ZIP_OK;
+}
+
+static bool ReadFile( ArrayPOD< char > & data )
+{
+	FILE * fp = fopen( ZIP_PATH, "rb" );
+	if ( fp == NULL )
+	{
+		return false;
+	}
+	fseek( fp, 0, SEEK_END );
+	data.Resize( ftell( fp ) );
+	fseek( fp, 0, SEEK_SET );
+	const bool read = fread( data.GetDataPtr(), 1, data.GetSize(), fp ) == data.GetSize();
+	fclose( fp );
+	return read;
+}
+
+static int CheckEntries( const Array< TestEntry > & expected, const Array< modelZipEntry_t > & entries )
+{
+	int errors = 0;
+	if ( entries.GetSizeI() != expected.GetSizeI() )
+	{
+		printf( "%d entries read, expected %d\n", entries.GetSizeI(), expected.GetSizeI() );
+		return 1;
+	}
+	for ( int i = 0; i < entries.GetSizeI(); i++ )
+	{
+		const modelZipEntry_t & entry = entries[i];
+		const TestEntry & test = expected[i];
+		if ( !entry.valid || OVR_strcmp( entry.name, test.name ) != 0 || entry.size != test.contents.GetSizeI() ||
+				memcmp( entry.buffer, test.contents.GetDataPtr(), entry.size ) != 0 )
+		{
+			printf( "entry %s does not match\n", test.name );
+			errors++;
+		}
+	}
+
+	const char * modelsJson = NULL;
+	int modelsJsonLength = 0;
+	const char * modelsBin = NULL;
+	int modelsBinLength = 0;
+	FindModelZipEntries( entries, ZIP_PATH, modelsJson, modelsJsonLength, modelsBin, modelsBinLength );
+	if ( modelsJson == NULL || modelsJsonLength != expected[0].contents.GetSizeI() ||
+			modelsBin == NULL || modelsBinLength != expected[1].contents.GetSizeI() )
+	{
+		printf( "models.json or models.bin not found\n" );
+		errors++;
+	}
+	return errors;
+}
+
+int main( int argc, char * argv[] )
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	Array< TestEntry > expected;
+	MakeEntries( expected );
+
+	ArrayPOD< char > fileData;
+	if ( !WriteZip( expected ) || !ReadFile( fileData ) )
+	{
+		printf( "FAILED: could not write %s\n", ZIP_PATH );
+		return 1;
+	}
+
+	int errors = 0;
+
+	// One entry at a time through the zip file, without the file data in memory.
+	double sequentialTime = 0.0;
+	for ( int run = 0; run < NUM_RUNS; run++ )
+	{
+		unzFile zfp = unzOpen( ZIP_PATH );
+		Array< modelZipEntry_t > entries;
+		const double start = BenchSeconds();
+		ReadModelZipEntries( zfp, ZIP_PATH, NULL, entries );
+		sequentialTime += BenchSeconds() - start;
+		errors += CheckEntries( expected, entries );
+		FreeModelZipEntries( entries );
+	}
+	sequentialTime /= NUM_RUNS;
+	printf( "%d entries, %d bytes zipped: sequential %7.2f ms\n", expected.GetSizeI(), fileData.GetSizeI(), sequentialTime * 1e3 );
+
+	// The directory is walked through the zip file, and the entries are found
+	// in the copy of the same file in memory.
+	for ( int w = 0; w < (int)( sizeof( WORKER_COUNTS ) / sizeof( WORKER_COUNTS[0] ) ); w++ )
+	{
+		ovrInflateService inflateService( WORKER_COUNTS[w] );
+		double time = 0.0;
+		for ( int run = 0; run < NUM_RUNS; run++ )
+		{
+			unzFile zfp = unzOpen( ZIP_PATH );
+			Array< modelZipEntry_t > entries;
+			const double start = BenchSeconds();
+			ReadModelZipEntries( zfp, ZIP_PATH, fileData.GetDataPtr(), entries, inflateService );
+			time += BenchSeconds() - start;
+			errors += CheckEntries( expected, entries );
+			FreeModelZipEntries( entries );
+		}
+		time /= NUM_RUNS;
+		printf( "%d workers: %7.2f ms, %.2fx\n", WORKER_COUNTS[w], time * 1e3, sequentialTime / time );
+	}
+
+	remove( ZIP_PATH );
+
+	if ( errors != 0 )
+	{
+		printf( "FAILED: %d entries did not match\n", errors );
+		return 1;
+	}
+	printf( "PASSED: all entries match with every worker count\n" );
+	return 0;
+}
@@ -0,0 +1,295 @@
+/************************************************************************************
+
+Filename    :   PackageFilesTest.cpp
+Content     :   Host test for reading application packages from many threads
+Created     :   October 16, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+// Writes a zip with 50k entries, a third of them stored and the rest deflated, and
+// then looks up, reads and maps all entries from many threads at once, with names
+// in a different case than in the zip. Every file is checked against its contents,
+// both when it is read at once and when it is read in small chunks.
+//
+// Build and run on a Linux host with the Makefile in this folder:
+//
+//	make -C Vendor/VrAppFramework/Test test
+
+#include "PackageFiles.h"
+
+#include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_Atomic.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Std.h"
+
+#include <zlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+static const int NUM_ENTRIES		= 50000;
+static const int NUM_THREADS		= 16;
+static const char * ZIP_PATH		= "PackageFilesTest.zip";
+static const int CHUNK_SIZE			= 7;	// smaller than any entry, and not a power of two
+
+// The contents repeat the index so the deflated entries differ in size.
+static int MakeContents( const int index, char * buffer, const int bufferSize )
+{
+	int length = 0;
+	for ( int i = 0; i <= index % 37; i++ )
+	{
+		length += OVR_sprintf( buffer + length, bufferSize - length, "file %d ", index );
+	}
+	return length;
+}
+
+static void MakeName( const int index, const bool upperCase, char * name, const int nameSize )
+{
+	OVR_sprintf( name, nameSize, upperCase ? "ASSETS/DIR%d/FILE_%d.TXT" : "assets/Dir%d/File_%d.txt", index % 100, index );
+}
+
+static bool IsStored( const int index )
+{
+	return ( index % 3 ) == 0;
+}
+
+static void PutU16( ArrayPOD< uint8_t > & out, const uint32_t value )
+{
+	out.PushBack( (uint8_t)( value ) );
+	out.PushBack( (uint8_t)( value >> 8 ) );
+}
+
+static void PutU32( ArrayPOD< uint8_t > & out, const uint32_t value )
+{
+	PutU16( out, value & 0xFFFF );
+	PutU16( out, value >> 16 );
+}
+
+static void PutBytes( ArrayPOD< uint8_t > & out, const void * data, const int size )
+{
+	const int offset = out.GetSizeI();
+	out.Resize( offset + size );
+	memcpy( out.GetDataPtr() + offset, data, size );
+}
+
+static bool WriteTestZip( const char * path )
+{
+	ArrayPOD< uint8_t > zip;
+	ArrayPOD< uint8_t > directory;
+	uint8_t compressed[2048];
+	char contents[1024];
+	char name[128];
+
+	for ( int i = 0; i < NUM_ENTRIES; i++ )
+	{
+		MakeName( i, false, name, sizeof( name ) );
+		const int nameLength = (int)strlen( name );
+		const int length = MakeContents( i, contents, sizeof( contents ) );
+		const uint32_t crc = (uint32_t)crc32( 0, (const Bytef *)contents, length );
+
+		const uint8_t * data = (const uint8_t *)contents;
+		int dataLength = length;
+		int method = 0;
+		if ( !IsStored( i ) )
+		{
+			z_stream stream;
+			memset( &stream, 0, sizeof( stream ) );
+			deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY );
+			stream.next_in = (Bytef *)contents;
+			stream.avail_in = length;
+			stream.next_out = compressed;
+			stream.avail_out = sizeof( compressed );
+			const int result = deflate( &stream, Z_FINISH );
+			deflateEnd( &stream );
+			if ( result != Z_STREAM_END )
+			{
+				return false;
+			}
+			data = compressed;
+			dataLength = (int)stream.total_out;
+			method = Z_DEFLATED;
+		}
+
+		const uint32_t localHeaderOffset = zip.GetSizeI();
+
+		PutU32( zip, 0x04034b50 );
+		PutU16( zip, 20 );				// version needed
+		PutU16( zip, 0 );				// flags
+		PutU16( zip, method );
+		PutU32( zip, 0 );				// time and date
+		PutU32( zip, crc );
+		PutU32( zip, dataLength );
+		PutU32( zip, length );
+		PutU16( zip, nameLength );
+		PutU16( zip, 0 );				// extra field length
+		PutBytes( zip, name, nameLength );
+		PutBytes( zip, data, dataLength );
+
+		PutU32( directory, 0x02014b50 );
+		PutU16( directory, 20 );		// version made by
+		PutU16( directory, 20 );		// version needed
+		PutU16( directory, 0 );			// flags
+		PutU16( directory, method );
+		PutU32( directory, 0 );			// time and date
+		PutU32( directory, crc );
+		PutU32( directory, dataLength );
+		PutU32( directory, length );
+		PutU16( directory, nameLength );
+		PutU16( directory, 0 );			// extra field length
+		PutU16( directory, 0 );			// comment length
+		PutU16( directory, 0 );			// disk number
+		PutU16( directory, 0 );			// internal attributes
+		PutU32( directory, 0 );			// external attributes
+		PutU32( directory, localHeaderOffset );
+		PutBytes( directory, name, nameLength );
+	}
+
+	const uint32_t directoryOffset = zip.GetSizeI();
+	PutBytes( zip, directory.GetDataPtr(), directory.GetSizeI() );
+
+	PutU32( zip, 0x06054b50 );
+	PutU16( zip, 0 );					// disk number
+	PutU16( zip, 0 );					// directory disk number
+	PutU16( zip, NUM_ENTRIES );
+	PutU16( zip, NUM_ENTRIES );
+	PutU32( zip, directory.GetSizeI() );
+	PutU32( zip, directoryOffset );
+	PutU16( zip, 0 );					// comment length
+
+	FILE * f = fopen( path, "wb" );
+	if ( f == NULL )
+	{
+		return false;
+	}
+	const bool written = ( fwrite( zip.GetDataPtr(), 1, zip.GetSizeI(), f ) == zip.GetSize() );
+	fclose( f );
+	return written;
+}
+
+struct testThread_t
+{
+	void *				package;
+	int					first;
+	AtomicInt< int > *	errors;
+};
+
+static threadReturn_t ReadEntriesThread( Thread * thread, void * v )
+{
+	testThread_t * test = (testThread_t *)v;
+	char contents[1024];
+	char name[128];
+	int errors = 0;
+
+	// Each thread starts at a different entry, so the threads touch different parts
+	// of the package at the same time.
+	for ( int n = 0; n < NUM_ENTRIES; n++ )
+	{
+		const int i = ( test->first + n * 7 ) % NUM_ENTRIES;
+		MakeName( i, ( n & 1 ) != 0, name, sizeof( name ) );
+		const int length = MakeContents( i, contents, sizeof( contents ) );
+
+		int readLength = 0;
+		void * buffer = NULL;
+		if ( !ovr_ReadFileFromOtherApplicationPackage( test->package, name, readLength, buffer ) ||
+				readLength != length || memcmp( buffer, contents, length ) != 0 )
+		{
+			errors++;
+		}
+		free( buffer );
+
+		int openLength = 0;
+		void * file = ovr_OpenFileFromOtherApplicationPackage( test->package, name, openLength );
+		if ( file == NULL || openLength != length )
+		{
+			errors++;
+		}
+		else
+		{
+			char chunked[1024];
+			int offset = 0;
+			for ( ; ; )
+			{
+				const int numRead = ovr_ReadFromPackageFile( file, chunked + offset, CHUNK_SIZE );
+				if ( numRead <= 0 || offset + numRead > (int)sizeof( chunked ) )
+				{
+					if ( numRead < 0 )
+					{
+						errors++;
+					}
+					break;
+				}
+				offset += numRead;
+			}
+			if ( offset != length || memcmp( chunked, contents, length ) != 0 )
+			{
+				errors++;
+			}
+		}
+		ovr_ClosePackageFile( file );
+
+		int mappedLength = 0;
+		const void * mapped = NULL;
+		const bool isMapped = ovr_MapFileFromOtherApplicationPackage( test->package, name, mappedLength, mapped );
+		if ( isMapped != IsStored( i ) || ( isMapped && ( mappedLength != length || memcmp( mapped, contents, length ) != 0 ) ) )
+		{
+			errors++;
+		}
+	}
+
+	test->errors->ExchangeAdd_Sync( errors );
+	return NULL;
+}
+
+int main()
+{
+	static DefaultAllocator allocator;
+	Allocator::setInstance( &allocator );
+
+	if ( !WriteTestZip( ZIP_PATH ) )
+	{
+		printf( "FAILED: could not write %s\n", ZIP_PATH );
+		return 1;
+	}
+
+	void * package = ovr_OpenOtherApplicationPackage( ZIP_PATH );
+	if ( package == NULL )
+	{
+		printf( "FAILED: could not open %s\n", ZIP_PATH );
+		return 1;
+	}
+
+	AtomicInt< int > errors( 0 );
+	if ( ovr_OtherPackageFileExists( package, "assets/missing.txt" ) )
+	{
+		errors.ExchangeAdd_Sync( 1 );
+	}
+
+	testThread_t tests[NUM_THREADS];
+	Thread * threads[NUM_THREADS];
+	for ( int i = 0; i < NUM_THREADS; i++ )
+	{
+		tests[i].package = package;
+		tests[i].first = i * ( NUM_ENTRIES / NUM_THREADS );
+		tests[i].errors = &errors;
+		threads[i] = new Thread( Thread::CreateParams( ReadEntriesThread, &tests[i], 128 * 1024 ) );
+		threads[i]->Start();
+	}
+	for ( int i = 0; i < NUM_THREADS; i++ )
+	{
+		threads[i]->Join();
+		delete threads[i];
+	}
+
+	ovr_CloseOtherApplicationPackage( package );
+	remove( ZIP_PATH );
+
+	const int numErrors = errors.Load_Acquire();
+	printf( "%s: %d entries read by %d threads, %d errors\n", ( numErrors == 0 ) ? "PASSED" : "FAILED",
+			NUM_ENTRIES, NUM_THREADS, numErrors );
+	return ( numErrors == 0 ) ? 0 : 1;
+}
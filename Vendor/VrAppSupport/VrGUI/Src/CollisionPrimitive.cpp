@@ -163,7 +163,7 @@ bool OvrTriCollisionPrimitive::IntersectRay( Vector3f const & localStart, Vector
 
 //==============================
 // OvrTriCollisionPrimitive::DebugRender
-void OvrTriCollisionPrimitive::DebugRender( OvrDebugLines & debugLines, Posef & pose ) const
+void OvrTriCollisionPrimitive::DebugRender( OvrDebugLines & debugLines, Posef const & pose ) const
 {
 	debugLines.AddBounds( pose, GetBounds(), Vector4f( 1.0f, 0.5f, 0.0f, 1.0f ) );
 
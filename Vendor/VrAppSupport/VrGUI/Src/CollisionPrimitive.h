@@ -70,7 +70,7 @@ public:
 								Vector3f const & scale, ContentFlags_t const testContents, 
 								float & t0, float & t1 ) const;
 
-	virtual void		DebugRender( OvrDebugLines & debugLines, Posef & pose ) const = 0;
+	virtual void		DebugRender( OvrDebugLines & debugLines, Posef const & pose ) const = 0;
 
 	ContentFlags_t		GetContents() const { return Contents; }
 	void				SetContents( ContentFlags_t const contents ) { Contents = contents; }
@@ -113,7 +113,7 @@ public:
 								Vector3f const & scale, ContentFlags_t const testContents,
 								OvrCollisionResult & result ) const;
 
-	virtual void		DebugRender( OvrDebugLines & debugLines, Posef & pose ) const;
+	virtual void		DebugRender( OvrDebugLines & debugLines, Posef const & pose ) const;
 
 private:
 	Array< Vector3f >		Vertices;	// vertices for all triangles
@@ -28,6 +28,8 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "VRMenuObject.h"
 #include "ScrollBarComponent.h"
 #include "SwipeHintComponent.h"
+#include "ImageData.h"
+#include <sys/stat.h>
 
 namespace OVR {
 
@@ -279,6 +281,7 @@ private:
 				{
 					LOG( "Hiding %s - unloading thumbs", folder->CategoryTag.ToCStr() );
 					folder->Visible = false;
+					FolderBrowser.CancelThumbnailLoads( folder->FolderIndex, -1 );
 					folder->UnloadThumbnails( guiSys, FolderBrowser.GetDefaultThumbnailTextureId(), FolderBrowser.GetThumbWidth(), FolderBrowser.GetThumbHeight() );
 				}
 
@@ -697,6 +700,7 @@ private:
 				if ( panel->Visible )
 				{
 					panel->Visible = false;
+					FolderBrowser.CancelThumbnailLoads( folder.FolderIndex, panel->Id );
 					panel->LoadDefaultThumbnail( guiSys, FolderBrowser.GetDefaultThumbnailTextureId(), FolderBrowser.GetThumbWidth(), FolderBrowser.GetThumbHeight() );
 				}
 			}
@@ -774,12 +778,14 @@ OvrFolderBrowser::OvrFolderBrowser(
 	, NoMedia( false )
 	, AllowPanelTouchUp( false )
 	, TextureCommands( 10000 )
-	, BackgroundCommands( 10000 )
+	, ThumbnailRequestSequence( 0 )
+	, ThumbnailPriorityFolder( -1 )
+	, ThumbnailCacheBytes( 0 )
+	, ThumbnailCacheClock( 0 )
 	, ControllerDirectionLock( NO_LOCK )
 	, LastControllerInputTimeStamp( 0.0f )
 	, IsTouchDownPosistionTracked( false )
 	, TouchDirectionLocked( NO_LOCK )
-	, ThumbnailLoadingThread( Thread::CreateParams( & ThumbnailThread, this, 128 * 1024, -1, Thread::NotRunning, Thread::BelowNormalPriority) )
 {
 	DefaultPanelTextureIds[ 0 ] = 0;
 	DefaultPanelTextureIds[ 1 ] = 0;
@@ -838,11 +844,15 @@ OvrFolderBrowser::OvrFolderBrowser(
 		}
 	}
 
-	if ( ! ThumbnailLoadingThread.Start() )
+	for ( int i = 0; i < NUM_THUMBNAIL_THREADS; ++i )
 	{
-		FAIL( "Thumbnail thread start failed." );
+		ThumbnailLoadingThreads[ i ] = new Thread( Thread::CreateParams( &ThumbnailThread, this, 128 * 1024, -1, Thread::NotRunning, Thread::BelowNormalPriority ) );
+		if ( !ThumbnailLoadingThreads[ i ]->Start() )
+		{
+			FAIL( "Thumbnail thread start failed." );
+		}
+		ThumbnailLoadingThreads[ i ]->SetThreadName( "FolderBrowser" );
 	}
-	ThumbnailLoadingThread.SetThreadName( "FolderBrowser" );
 
 	PanelWidth = panelWidth * VRMenuObject::DEFAULT_TEXEL_SCALE;
 	PanelHeight = panelHeight * VRMenuObject::DEFAULT_TEXEL_SCALE;
@@ -865,12 +875,36 @@ VRMenuComponent* OvrFolderBrowser::CreateFolderBrowserSwipeComponent( OvrFolderB
 OvrFolderBrowser::~OvrFolderBrowser()
 {
 	LOG( "OvrFolderBrowser::~OvrFolderBrowser" );
-	// Wake up thumbnail thread if needed and shut it down
+	// Wake up the thumbnail threads if needed and shut them down
 	ThumbnailThreadMutex.DoLock();
 	ThumbnailThreadState.SetState( THUMBNAIL_THREAD_SHUTDOWN );
+	ThumbnailRequests.Clear();
 	ThumbnailThreadCondition.NotifyAll();
 	ThumbnailThreadMutex.Unlock();
-	BackgroundCommands.ClearMessages();
+	for ( int i = 0; i < NUM_THUMBNAIL_THREADS; ++i )
+	{
+		ThumbnailLoadingThreads[ i ]->Join();
+		delete ThumbnailLoadingThreads[ i ];
+		ThumbnailLoadingThreads[ i ] = NULL;
+	}
+
+	// free the thumbnails that were loaded but not uploaded yet
+	for ( const char * cmd = TextureCommands.GetNextMessage(); cmd != NULL; cmd = TextureCommands.GetNextMessage() )
+	{
+		void * data = NULL;
+		if ( sscanf( cmd, "thumb %*i %*i %p", &data ) == 1 )
+		{
+			free( data );
+		}
+		free( ( void * )cmd );
+	}
+
+	for ( int i = 0; i < ThumbnailCache.GetSizeI(); ++i )
+	{
+		free( ThumbnailCache[ i ].Data );
+	}
+	ThumbnailCache.Clear();
+	ThumbnailCacheBytes = 0;
 	
 	int numFolders = Folders.GetSizeI();
 	for ( int i = 0; i < numFolders; ++i )
@@ -901,8 +935,14 @@ OvrFolderBrowser::~OvrFolderBrowser()
 
 void OvrFolderBrowser::Frame_Impl( OvrGuiSys & guiSys, VrFrame const & vrFrame )
 {
-	// Check for thumbnail loads
-	while ( 1 )
+	// Load the thumbnails of the folder in view first
+	if ( Folders.GetSizeI() > 0 )
+	{
+		ThumbnailPriorityFolder = GetActiveFolderIndex( guiSys );
+	}
+
+	// Check for thumbnail loads, a few per frame so a burst of decoded thumbnails does not hitch
+	for ( int numUploads = 0; numUploads < MAX_THUMBNAIL_UPLOADS_PER_FRAME; ++numUploads )
 	{
 		const char * cmd = TextureCommands.GetNextMessage();
 		if ( !cmd )
@@ -1005,6 +1045,12 @@ void OvrFolderBrowser::OneTimeInit( OvrGuiSys & guiSys )
 	storagePaths.GetPathIfValidPermission( EST_PRIMARY_EXTERNAL_STORAGE, EFT_CACHE, "", permissionFlags_t( PERMISSION_WRITE ), AppCachePath );
 	OVR_ASSERT( !AppCachePath.IsEmpty() );
 
+	if ( !AppCachePath.IsEmpty() )
+	{
+		ThumbnailCachePath = AppCachePath + "thumbcache/";
+		MakePath( ThumbnailCachePath.ToCStr(), permissionFlags_t( PERMISSION_READ ) | PERMISSION_WRITE );
+	}
+
 	storagePaths.PushBackSearchPathIfValid( EST_SECONDARY_EXTERNAL_STORAGE, EFT_ROOT, "RetailMedia/", ThumbSearchPaths );
 	storagePaths.PushBackSearchPathIfValid( EST_SECONDARY_EXTERNAL_STORAGE, EFT_ROOT, "", ThumbSearchPaths );
 	storagePaths.PushBackSearchPathIfValid( EST_PRIMARY_EXTERNAL_STORAGE, EFT_ROOT, "RetailMedia/", ThumbSearchPaths );
@@ -1528,171 +1574,413 @@ void OvrFolderBrowser::UpdateFolderTitle( OvrGuiSys & guiSys, const FolderView *
 	}
 }
 
-threadReturn_t OvrFolderBrowser::ThumbnailThread( Thread *thread, void * v )
+//==============================
+// OvrFolderBrowser::WaitForThumbnailRequest
+// Returns false when the thumbnail threads should shut down.
+bool OvrFolderBrowser::WaitForThumbnailRequest( ThumbnailRequest & request )
 {
-	thread->SetThreadName( "FolderBrowser" );
-
-	OvrFolderBrowser * folderBrowser = (OvrFolderBrowser *)v;
-
+	ThumbnailThreadMutex.DoLock();
 	for ( ;; )
 	{
-		folderBrowser->BackgroundCommands.SleepUntilMessage();
-
-		switch ( folderBrowser->ThumbnailThreadState.GetState() )
+		const eThumbnailThreadState state = ThumbnailThreadState.GetState();
+		if ( state == THUMBNAIL_THREAD_SHUTDOWN )
+		{
+			ThumbnailThreadMutex.Unlock();
+			return false;
+		}
+		if ( state == THUMBNAIL_THREAD_WORK && ThumbnailRequests.GetSizeI() > 0 )
 		{
-		case THUMBNAIL_THREAD_WORK:
 			break;
-		case THUMBNAIL_THREAD_PAUSE:
+		}
+		ThumbnailThreadCondition.Wait( &ThumbnailThreadMutex );
+	}
+
+	// The panels of the folder in view go first, then the most recently revealed panels,
+	// because those are the ones that are on screen.
+	const int priorityFolder = ThumbnailPriorityFolder;
+	int best = 0;
+	for ( int i = 1; i < ThumbnailRequests.GetSizeI(); ++i )
+	{
+		const ThumbnailRequest & cur = ThumbnailRequests[ i ];
+		const ThumbnailRequest & other = ThumbnailRequests[ best ];
+		const bool curInView = ( cur.FolderIndex == priorityFolder );
+		const bool otherInView = ( other.FolderIndex == priorityFolder );
+		if ( curInView != otherInView ? curInView : cur.Sequence > other.Sequence )
 		{
-			LOG( "OvrFolderBrowser::ThumbnailThread PAUSED" );
-			folderBrowser->ThumbnailThreadMutex.DoLock();
-			while ( folderBrowser->ThumbnailThreadState.GetState() == THUMBNAIL_THREAD_PAUSE )
-			{
-				folderBrowser->ThumbnailThreadCondition.Wait( &folderBrowser->ThumbnailThreadMutex );
-			}
-			folderBrowser->ThumbnailThreadMutex.Unlock();
-			continue;
+			best = i;
 		}
-		case THUMBNAIL_THREAD_SHUTDOWN:
-			LOG( "OvrFolderBrowser::ThumbnailThread shutting down" );
-			return NULL;
+	}
+	request = ThumbnailRequests[ best ];
+	ThumbnailRequests.RemoveAtUnordered( best );
+
+	ThumbnailThreadMutex.Unlock();
+	return true;
+}
+
+//==============================
+// OvrFolderBrowser::QueueThumbnailRequest
+void OvrFolderBrowser::QueueThumbnailRequest( const int folderIndex, const int panelId, const bool remote,
+		const char * path, const char * cacheDestination )
+{
+	ThumbnailThreadMutex.DoLock();
+
+	// a panel that is revealed again before its thumbnail was loaded only needs one load
+	int index = -1;
+	for ( int i = 0; i < ThumbnailRequests.GetSizeI(); ++i )
+	{
+		if ( ThumbnailRequests[ i ].FolderIndex == folderIndex && ThumbnailRequests[ i ].PanelId == panelId )
+		{
+			index = i;
+			break;
 		}
+	}
+	if ( index < 0 )
+	{
+		index = ThumbnailRequests.GetSizeI();
+		ThumbnailRequests.Resize( index + 1 );
+	}
+
+	ThumbnailRequest & request = ThumbnailRequests[ index ];
+	request.FolderIndex = folderIndex;
+	request.PanelId = panelId;
+	request.Remote = remote;
+	request.Path = path;
+	request.CacheDestination = cacheDestination;
+	request.Sequence = ThumbnailRequestSequence++;
 
-		const char * msg = folderBrowser->BackgroundCommands.GetNextMessage();
-		LOG( "BackgroundCommands: %s", msg );
+	ThumbnailThreadCondition.Notify();
+	ThumbnailThreadMutex.Unlock();
+}
 
-		if ( MatchesHead( "load ", msg ) )
+//==============================
+// OvrFolderBrowser::CancelThumbnailLoads
+void OvrFolderBrowser::CancelThumbnailLoads( const int folderIndex, const int panelId )
+{
+	ThumbnailThreadMutex.DoLock();
+	for ( int i = ThumbnailRequests.GetSizeI() - 1; i >= 0; --i )
+	{
+		if ( ThumbnailRequests[ i ].FolderIndex == folderIndex && ( panelId < 0 || ThumbnailRequests[ i ].PanelId == panelId ) )
 		{
-			int folderId = -1;
-			int panelId = -1;
+			ThumbnailRequests.RemoveAtUnordered( i );
+		}
+	}
+	ThumbnailThreadMutex.Unlock();
+}
 
-			sscanf( msg, "load %i %i", &folderId, &panelId );
-			OVR_ASSERT( folderId >= 0 && panelId >= 0 );
+// Scales a decoded thumbnail, which is freed, to the thumbnail size. The image is
+// halved first while it is at least twice as large, so the filtered resample only
+// covers the last step.
+static unsigned char * ScaleToThumbnailSize( unsigned char * data, const int width, const int height,
+		const int thumbWidth, const int thumbHeight )
+{
+	int w = width;
+	int h = height;
+	while ( w >= thumbWidth * 2 && h >= thumbHeight * 2 )
+	{
+		unsigned char * quarter = QuarterImageSize( data, w, h, true );
+		free( data );
+		data = quarter;
+		w >>= 1;
+		h >>= 1;
+	}
 
-			// Do we still need to load this?
-			const FolderView * folder = folderBrowser->GetFolderView( folderId );
-			// ThumbnailsLoaded is set to false when the category goes out of view - do not load the thumbnail
-			if ( folder && folder->Visible ) 
-			{
-				if ( panelId >= 0 && panelId < folder->Panels.GetSizeI() )
-				{
-					const PanelView * panel = folder->Panels.At( panelId );
-					if ( panel && panel->Visible )
-					{
-						const char * fileName = strstr( msg, ":" ) + 1;
+	if ( w != thumbWidth || h != thumbHeight )
+	{
+		unsigned char * scaled = ScaleImageRGBA( data, w, h, thumbWidth, thumbHeight, IMAGE_FILTER_CUBIC );
+		free( data );
+		data = scaled;
+	}
+	return data;
+}
 
-						const String fullPath( fileName );
+// The file is written under a temporary name and then renamed, so other threads,
+// or the next run after a crash, never read a partially written thumbnail.
+static void WriteThumbnailCacheFile( const char * fileName, const unsigned char * data, const int size )
+{
+	char tempFileName[ 1024 ];
+	OVR_sprintf( tempFileName, sizeof( tempFileName ), "%s.%p.tmp", fileName, GetCurrentThreadId() );
 
-						int		width;
-						int		height;
-						unsigned char * data = folderBrowser->LoadThumbnail( fileName, width, height );
-						if ( data != NULL )
-						{
-							folderBrowser->TextureCommands.PostPrintf( "thumb %i %i %p %i %i",
-								folderId, panelId, data, width, height );
-						}
-						else
-						{
-							WARN( "Thumbnail load fail for: %s", fileName );
-						}
-					}
-				}
-			}
+	FILE * f = fopen( tempFileName, "wb" );
+	if ( f == NULL )
+	{
+		WARN( "Failed to open %s for writing", tempFileName );
+		return;
+	}
+	const bool written = ( fwrite( data, size, 1, f ) == 1 );
+	if ( fclose( f ) != 0 || !written || rename( tempFileName, fileName ) != 0 )
+	{
+		WARN( "Failed to write %s", fileName );
+		remove( tempFileName );
+	}
+}
 
+//==============================
+// OvrFolderBrowser::GetThumbnailCacheKey
+// Thumbnails are content addressed, in memory and on disk: the key is a hash of the source
+// path, the modification time and size of the source, and the thumbnail size. Remote
+// thumbnails are only keyed on their URL. Returns false if the source cannot be found.
+bool OvrFolderBrowser::GetThumbnailCacheKey( const char * path, const bool remote, UInt64 & key ) const
+{
+	UInt64 values[5] = { (UInt64)THUMBNAIL_CACHE_VERSION, (UInt64)ThumbWidth, (UInt64)ThumbHeight, 0, 0 };
+	if ( !remote )
+	{
+		struct stat st;
+		if ( stat( path, &st ) != 0 )
+		{
+			return false;
 		}
-		else if ( MatchesHead( "httpThumb", msg ) )
+		values[3] = (UInt64)st.st_mtime;
+		values[4] = (UInt64)st.st_size;
+	}
+
+	// FNV-1a
+	UInt64 hash = 14695981039346656037ull;
+	for ( const char * p = path; *p != '\0'; p++ )
+	{
+		hash = ( hash ^ (UByte)*p ) * 1099511628211ull;
+	}
+	for ( int i = 0; i < 5; i++ )
+	{
+		hash = ( hash ^ values[i] ) * 1099511628211ull;
+	}
+
+	key = hash;
+	return true;
+}
+
+//==============================
+// OvrFolderBrowser::GetThumbnailCacheFileName
+// Returns false if there is no disk cache.
+bool OvrFolderBrowser::GetThumbnailCacheFileName( const UInt64 key, char * fileName, const int fileNameSize ) const
+{
+	if ( ThumbnailCachePath.IsEmpty() )
+	{
+		return false;
+	}
+	OVR_sprintf( fileName, fileNameSize, "%s%016llx.pvr", ThumbnailCachePath.ToCStr(), (unsigned long long)key );
+	return true;
+}
+
+threadReturn_t OvrFolderBrowser::ThumbnailThread( Thread *thread, void * v )
+{
+	thread->SetThreadName( "FolderBrowser" );
+
+	OvrFolderBrowser * folderBrowser = (OvrFolderBrowser *)v;
+
+	ThumbnailRequest request;
+	while ( folderBrowser->WaitForThumbnailRequest( request ) )
+	{
+		const int folderId = request.FolderIndex;
+		const int panelId = request.PanelId;
+		LOG( "ThumbnailThread: %s %d %d", request.Path.ToCStr(), folderId, panelId );
+
+		// Do we still need to load this?
+		const FolderView * folder = folderBrowser->GetFolderView( folderId );
+		// Visible is set to false when the category goes out of view - do not load the thumbnail
+		if ( folder == NULL || !folder->Visible || panelId < 0 || panelId >= folder->Panels.GetSizeI() )
+		{
+			continue;
+		}
+		const PanelView * panel = folder->Panels.At( panelId );
+		if ( panel == NULL || !panel->Visible )
 		{
-			int folderId = -1;
-			int panelId = -1;
-			char panoUrl[ 1024 ] = {};
-			char cacheDestination[ 1024 ] = {};
+			continue;
+		}
 
-			sscanf( msg, "httpThumb %s %s %d %d", panoUrl, cacheDestination, &folderId, &panelId );
+		const char * fileName = request.Remote ? request.CacheDestination.ToCStr() : request.Path.ToCStr();
 
-			// Do we still need to load this?
-			const FolderView * folder = folderBrowser->GetFolderView( folderId );
-			// ThumbnailsLoaded is set to false when the category goes out of view - do not load the thumbnail
-			if ( folder && folder->Visible )
+		UInt64 key = 0;
+		if ( !folderBrowser->GetThumbnailCacheKey( request.Path.ToCStr(), request.Remote, key ) )
+		{
+			WARN( "Thumbnail load fail for: %s", request.Path.ToCStr() );
+			continue;
+		}
+
+		// A thumbnail in the disk cache is ready for upload, it only takes a single read
+		char cacheFileName[ 1024 ];
+		const bool cacheable = folderBrowser->GetThumbnailCacheFileName( key, cacheFileName, sizeof( cacheFileName ) );
+		if ( cacheable && FileExists( cacheFileName ) )
+		{
+			MemBufferFile cacheFile( cacheFileName );
+			if ( cacheFile.Length > 0 )
 			{
-				if ( panelId >= 0 && panelId < folder->Panels.GetSizeI() )
-				{
-					const PanelView * panel = folder->Panels.At( panelId );
-					if ( panel && panel->Visible )
-					{
-						int		width;
-						int		height;
-						unsigned char * data = folderBrowser->RetrieveRemoteThumbnail(
-							panoUrl,
-							cacheDestination,
-							folderId,
-							panelId,
-							width,
-							height );
-
-						if ( data != NULL )
-						{
-							folderBrowser->TextureCommands.PostPrintf( "thumb %i %i %p %i %i",
-								folderId, panelId, data, width, height );
-						}
-						else
-						{
-							WARN( "Thumbnail download fail for: %s", panoUrl );
-						}
-					}
-				}
+				const MemBuffer buffer = cacheFile.ToMemBuffer();
+				folderBrowser->TextureCommands.PostPrintf( "thumb %i %i %p %i %llx:%s",
+					folderId, panelId, buffer.Buffer, buffer.Length, (unsigned long long)key, fileName );
+				continue;
 			}
 		}
+
+		int		width;
+		int		height;
+		unsigned char * data = NULL;
+		if ( request.Remote )
+		{
+			data = folderBrowser->RetrieveRemoteThumbnail(
+				request.Path.ToCStr(),
+				request.CacheDestination.ToCStr(),
+				folderId,
+				panelId,
+				width,
+				height );
+		}
 		else
 		{
-			LOG( "OvrFolderBrowser::ThumbnailThread received unhandled message: %s", msg );
-			OVR_ASSERT( false );
+			data = folderBrowser->LoadThumbnail( request.Path.ToCStr(), width, height );
+		}
+
+		if ( data == NULL )
+		{
+			WARN( "Thumbnail load fail for: %s", request.Path.ToCStr() );
+			continue;
+		}
+
+		const int thumbWidth = folderBrowser->GetThumbWidth();
+		const int thumbHeight = folderBrowser->GetThumbHeight();
+		data = ScaleToThumbnailSize( data, width, height, thumbWidth, thumbHeight );
+		if ( data == NULL )
+		{
+			WARN( "OvrFolderBrowser::ThumbnailThread Failed to scale %s", fileName );
+			continue;
+		}
+
+		if ( !folderBrowser->ApplyThumbAntialiasing( data, thumbWidth, thumbHeight ) )
+		{
+			WARN( "OvrFolderBrowser::ThumbnailThread Failed to apply AA to %s", fileName );
+		}
+
+		int size = 0;
+		unsigned char * texture = Create32BitPvrTextureWithMipmaps( data, thumbWidth, thumbHeight, true /* srgb */, size );
+		free( data );
+		if ( texture == NULL )
+		{
+			WARN( "OvrFolderBrowser::ThumbnailThread Failed to build mipmaps for %s", fileName );
+			continue;
 		}
 
-		free( ( void * )msg );
+		if ( cacheable )
+		{
+			WriteThumbnailCacheFile( cacheFileName, texture, size );
+		}
+
+		folderBrowser->TextureCommands.PostPrintf( "thumb %i %i %p %i %llx:%s",
+			folderId, panelId, texture, size, (unsigned long long)key, fileName );
 	}
+
 	LOG( "OvrFolderBrowser::ThumbnailThread returned" );
 	return NULL;
 }
 
+//==============================
+// OvrFolderBrowser::FindCachedThumbnail
+int OvrFolderBrowser::FindCachedThumbnail( const UInt64 key )
+{
+	for ( int i = 0; i < ThumbnailCache.GetSizeI(); ++i )
+	{
+		if ( ThumbnailCache[ i ].Key == key )
+		{
+			ThumbnailCache[ i ].LastUsed = ++ThumbnailCacheClock;
+			return i;
+		}
+	}
+	return -1;
+}
+
+//==============================
+// OvrFolderBrowser::AddCachedThumbnail
+// Takes ownership of the data and returns the index of the new entry.
+int OvrFolderBrowser::AddCachedThumbnail( const char * path, unsigned char * data, const int size )
+{
+	// free the least recently used thumbnails until the new one fits
+	for ( ;; )
+	{
+		int oldest = -1;
+		for ( int i = 0; i < ThumbnailCache.GetSizeI(); ++i )
+		{
+			if ( ThumbnailCache[ i ].Key == key )
+			{
+				oldest = i;		// replace a copy of the same thumbnail
+				break;
+			}
+			if ( oldest < 0 || ThumbnailCache[ i ].LastUsed < ThumbnailCache[ oldest ].LastUsed )
+			{
+				oldest = i;
+			}
+		}
+		if ( oldest < 0 || ( ThumbnailCacheBytes + size <= MAX_THUMBNAIL_CACHE_BYTES && ThumbnailCache[ oldest ].Key != key ) )
+		{
+			break;
+		}
+		CachedThumbnail & entry = ThumbnailCache[ oldest ];
+		ThumbnailCacheBytes -= entry.Size;
+		free( entry.Data );
+		ThumbnailCache.RemoveAtUnordered( oldest );
+	}
+
+	const int index = ThumbnailCache.GetSizeI();
+	ThumbnailCache.Resize( index + 1 );
+	CachedThumbnail & entry = ThumbnailCache[ index ];
+	entry.Key = key;
+	entry.Data = data;
+	entry.Size = size;
+	entry.LastUsed = ++ThumbnailCacheClock;
+	ThumbnailCacheBytes += size;
+	return index;
+}
+
 // THUMBFIX: call this to load final thumbnail onto the panel
 void OvrFolderBrowser::LoadThumbnailToTexture( OvrGuiSys & guiSys, const char * thumbnailCommand )
 {	
-	int folderId;
-	int panelId;
-	unsigned char * data;
-	int width;
-	int height;
+	int folderId = -1;
+	int panelId = -1;
 
-	sscanf( thumbnailCommand, "thumb %i %i %p %i %i", &folderId, &panelId, &data, &width, &height );
-	if ( folderId < 0 || panelId < 0 )
+	const char * path = strchr( thumbnailCommand, ':' );
+	if ( path == NULL )
 	{
-		delete data;
+		WARN( "OvrFolderBrowser::LoadThumbnailToTexture bad command: %s", thumbnailCommand );
 		return;
 	}
+	path++;
 
-	FolderView * folder = GetFolderView( folderId );
-	if ( folder == NULL )
+	int cacheIndex = -1;
+	unsigned long long key = 0;
+	if ( MatchesHead( "thumb ", thumbnailCommand ) )
+	{
+		void * data = NULL;
+		int size = 0;
+		sscanf( thumbnailCommand, "thumb %i %i %p %i %llx", &folderId, &panelId, &data, &size, &key );
+		cacheIndex = AddCachedThumbnail( key, ( unsigned char * )data, size );
+	}
+	else if ( MatchesHead( "cached ", thumbnailCommand ) )
+	{
+		sscanf( thumbnailCommand, "cached %i %i %llx", &folderId, &panelId, &key );
+		cacheIndex = FindCachedThumbnail( key );
+		if ( cacheIndex < 0 )
+		{
+			// freed before it could be uploaded, load it again
+			QueueThumbnailRequest( folderId, panelId, false, path, "" );
+			return;
+		}
+	}
+	if ( folderId < 0 || panelId < 0 || cacheIndex < 0 )
 	{
-		WARN( "OvrFolderBrowser::LoadThumbnailToTexture failed to find FolderView at %i", folderId );
-		free( data );
 		return;
 	}
 
-	Array<PanelView*> * panels = &folder->Panels;
-	if ( panels == NULL )
+	FolderView * folder = GetFolderView( folderId );
+	if ( folder == NULL )
 	{
-		WARN( "OvrFolderBrowser::LoadThumbnailToTexture failed to get panels array from folder" );
-		free( data );
+		WARN( "OvrFolderBrowser::LoadThumbnailToTexture failed to find FolderView at %i", folderId );
 		return;
 	}
 
 	PanelView * panel = NULL;
 
 	// find panel using panelId
-	const int numPanels = panels->GetSizeI();
+	const int numPanels = folder->Panels.GetSizeI();
 	for ( int index = 0; index < numPanels; ++index )
 	{
-		PanelView* currentPanel = panels->At( index );
+		PanelView* currentPanel = folder->Panels.At( index );
 		if ( currentPanel->Id == panelId )
 		{
 			panel = currentPanel;
@@ -1700,16 +1988,16 @@ void OvrFolderBrowser::LoadThumbnailToTexture( OvrGuiSys & guiSys, const char *
 		}
 	}
 
-	if ( panel == NULL ) // Panel not found as it was moved. Delete data and bail
+	if ( panel == NULL ) // Panel not found as it was moved. Bail, the thumbnail stays cached
 	{
 		WARN( "OvrFolderBrowser::LoadThumbnailToTexture failed to find panel id %d in folder %d", panelId, folderId );
-		free( data );
 		return;
 	}
 
-	if ( !ApplyThumbAntialiasing( data, width, height ) )
+	if ( !folder->Visible || !panel->Visible )
 	{
-		WARN( "OvrFolderBrowser::LoadThumbnailToTexture Failed to apply AA to %s", thumbnailCommand );
+		// scrolled away while loading, the thumbnail stays cached for when it comes back
+		return;
 	}
 
 	// Grab the Panel from VRMenu
@@ -1717,18 +2005,25 @@ void OvrFolderBrowser::LoadThumbnailToTexture( OvrGuiSys & guiSys, const char *
 	VRMenuObject * panelObject = guiSys.GetVRMenuMgr().ToObject( thumbHandle );
 	OVR_ASSERT( panelObject );
 
-	GLuint texId = LoadRGBATextureFromMemory(
-		data, width, height, true /* srgb */ ).texture;
-	free( data );
+	// The thumbnail already has its mip chain, so it is uploaded without building mipmaps
+	const CachedThumbnail & thumb = ThumbnailCache[ cacheIndex ];
+	int width = 0;
+	int height = 0;
+	GLuint texId = LoadTextureFromBuffer( "thumbnail.pvr", MemBuffer( thumb.Data, thumb.Size ),
+		TextureFlags_t( TEXTUREFLAG_USE_SRGB ) | TEXTUREFLAG_NO_DEFAULT, width, height ).texture;
 
 	if ( texId )
 	{
+		if ( panel->TextureId != 0 && panel->TextureId != DefaultPanelTextureIds[ 0 ] )
+		{
+			glDeleteTextures( 1, &panel->TextureId );
+		}
+
 		panelObject->SetSurfaceTexture( 0, 0, SURFACE_TEXTURE_DIFFUSE,
 			texId, ThumbWidth, ThumbHeight );
 
 		panel->TextureId = texId;
 
-		BuildTextureMipmaps( texId );
 		MakeTextureTrilinear( texId );
 		MakeTextureClamped( texId );
 	}
@@ -1826,7 +2121,7 @@ void OvrFolderBrowser::QueueAsyncThumbnailLoad( const OvrMetaDatum * panoData, c
 		}
 		else // download and cache it 
 		{
-			BackgroundCommands.PostPrintf( "httpThumb %s %s %d %d", panoUrl.ToCStr(), appCacheThumbPath, folderIndex, panelId );
+			QueueThumbnailRequest( folderIndex, panelId, true, panoUrl.ToCStr(), appCacheThumbPath );
 			return;
 		}
 	}
@@ -1859,10 +2154,15 @@ void OvrFolderBrowser::QueueAsyncThumbnailLoad( const OvrMetaDatum * panoData, c
 
 	if ( !finalThumb.IsEmpty() )
 	{
-		char cmd[ 1024 ];
-		OVR_sprintf( cmd, 1024, "load %i %i:%s", folderIndex, panelId, finalThumb.ToCStr() );
-		LOG( "Thumb cmd: %s", cmd );
-		BackgroundCommands.PostString( cmd );
+		UInt64 key = 0;
+		if ( GetThumbnailCacheKey( finalThumb.ToCStr(), false, key ) && FindCachedThumbnail( key ) >= 0 )
+		{
+			// upload it from the cache on the next frame
+			TextureCommands.PostPrintf( "cached %i %i %llx:%s", folderIndex, panelId, (unsigned long long)key, finalThumb.ToCStr() );
+			return;
+		}
+		LOG( "Thumb load: %i %i:%s", folderIndex, panelId, finalThumb.ToCStr() );
+		QueueThumbnailRequest( folderIndex, panelId, false, finalThumb.ToCStr(), "" );
 	}
 	else
 	{
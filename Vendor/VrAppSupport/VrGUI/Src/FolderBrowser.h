@@ -173,6 +173,8 @@ public:
 	bool						ApplyThumbAntialiasing( unsigned char * inOutBuffer, int width, int height ) const;
 	GLuint						GetDefaultThumbnailTextureId() const		{ return DefaultPanelTextureIds[ 0 ]; }
 	void						QueueAsyncThumbnailLoad( const OvrMetaDatum * panoData, const int folderIndex, const int panelId );
+	// Drops the queued thumbnail loads for a panel, or for all panels of the folder if panelId < 0.
+	void						CancelThumbnailLoads( const int folderIndex, const int panelId );
 
 protected:
 	OvrFolderBrowser( OvrGuiSys & guiSys,
@@ -198,7 +200,8 @@ protected:
 	// Called when a panel is activated
 	virtual void				OnPanelActivated( OvrGuiSys & guiSys, const OvrMetaDatum * panelData ) = 0;
 
-	// Called on a background thread to load thumbnail
+	// Called on one of the thumbnail threads to load a thumbnail. Calls for different
+	// thumbnails may run at the same time.
 	virtual	unsigned char *		LoadThumbnail( const char * filename, int & width, int & height ) = 0;
 
 	// Returns the proper thumbnail URL
@@ -212,7 +215,7 @@ protected:
 
 	// Optional interface
 	//
-	// Request external thumbnail - called on main thread
+	// Request external thumbnail - called on one of the thumbnail threads, like LoadThumbnail
 	virtual unsigned char *		RetrieveRemoteThumbnail(
 			const char * url,
 			const char * cacheDestinationFile,
@@ -271,8 +274,33 @@ protected:
 	int							MediaCount; // Used to determine if no media was loaded
 
 private:
+	struct ThumbnailRequest
+	{
+		int				FolderIndex;
+		int				PanelId;
+		bool			Remote;				// if true, Path is a URL that is downloaded to CacheDestination
+		String			Path;
+		String			CacheDestination;
+		UInt32			Sequence;			// the most recent requests are loaded first
+	};
+
+	struct CachedThumbnail
+	{
+		UInt64			Key;				// same key as the disk cache, see GetThumbnailCacheKey
+		unsigned char *	Data;				// uncompressed .pvr with the full mip chain
+		int				Size;
+		UInt32			LastUsed;
+	};
+
 	static threadReturn_t		ThumbnailThread( Thread * thread, void * v );
 	void				LoadThumbnailToTexture( OvrGuiSys & guiSys, const char * thumbnailCommand );
+	void				QueueThumbnailRequest( const int folderIndex, const int panelId, const bool remote,
+										const char * path, const char * cacheDestination );
+	bool				WaitForThumbnailRequest( ThumbnailRequest & request );
+	int					FindCachedThumbnail( const UInt64 key );
+	int					AddCachedThumbnail( const UInt64 key, unsigned char * data, const int size );
+	bool				GetThumbnailCacheKey( const char * path, const bool remote, UInt64 & key ) const;
+	bool				GetThumbnailCacheFileName( const UInt64 key, char * fileName, const int fileNameSize ) const;
 
 	friend class OvrPanel_OnUp;
 	void				OnPanelUp( OvrGuiSys & guiSys, const OvrMetaDatum * data );
@@ -330,9 +358,13 @@ private:
 
 	RootDirection		OnEnterMenuRootAdjust;
 	
-	// Checked at Frame() time for commands from the thumbnail/create thread
+	// Checked at Frame() time for commands from the thumbnail/create threads
 	ovrMessageQueue		TextureCommands;
-	ovrMessageQueue		BackgroundCommands;
+
+	static const int	NUM_THUMBNAIL_THREADS = 3;
+	static const int	MAX_THUMBNAIL_UPLOADS_PER_FRAME = 4;
+	static const int	MAX_THUMBNAIL_CACHE_BYTES = 16 * 1024 * 1024;
+	static const int	THUMBNAIL_CACHE_VERSION = 1;	// bump to invalidate the thumbnails cached on disk
 
 	enum eThumbnailThreadState
 	{
@@ -341,11 +373,20 @@ private:
 		THUMBNAIL_THREAD_SHUTDOWN
 	};
 	LocklessUpdater< eThumbnailThreadState > ThumbnailThreadState;
-	OVR::Mutex				ThumbnailThreadMutex;
+	OVR::Mutex				ThumbnailThreadMutex;		// protects ThumbnailRequests
 	OVR::WaitCondition		ThumbnailThreadCondition;
+	Array< ThumbnailRequest >	ThumbnailRequests;
+	UInt32					ThumbnailRequestSequence;
+	volatile int			ThumbnailPriorityFolder;	// the thumbnails of the folder in view are loaded first
+
+	// Decoded thumbnails, least recently used are freed first - only used on the main thread
+	Array< CachedThumbnail >	ThumbnailCache;
+	int						ThumbnailCacheBytes;
+	UInt32					ThumbnailCacheClock;
 
 	Array< String >		ThumbSearchPaths;
 	String				AppCachePath;
+	String				ThumbnailCachePath;		// empty if thumbnails are not cached on disk
 
 	// Keep a reference to Panel texture used for AA alpha when creating thumbnails
 	static unsigned char *		ThumbPanelBG;
@@ -363,7 +404,7 @@ private:
 	Vector3f 						TouchDownPosistion; // First event in touch relative is considered as touch down position
 	eScrollDirectionLockType		TouchDirectionLocked;
 
-	Thread									ThumbnailLoadingThread;
+	Thread *								ThumbnailLoadingThreads[ NUM_THUMBNAIL_THREADS ];
 };
 
 
@@ -29,7 +29,6 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "VrApi.h"
 #include "Android/JniUtils.h"
 #include "VolumePopup.h"
-#include "Kernel/OVR_JSON.h"
 #include "Kernel/OVR_Lexer.h"
 #include "SystemActivities.h"
 
@@ -591,23 +590,27 @@ void OvrGuiSysLocal::Frame( const VrFrame & vrFrame, Matrix4f const & centerView
 		return;
 	}
 
-	for ( int i = 0; i < vrFrame.AppEvents->NumEvents; ++i )
+	ovrAppEventList * appEvents = vrFrame.AppEventList;
+	if ( appEvents != NULL )
 	{
-		char const * jsonError;
-		JSON * jsonObj = JSON::Parse( vrFrame.AppEvents->Events[i], &jsonError );
-		JsonReader reader( jsonObj );
-		OVR_ASSERT( jsonObj != NULL && reader.IsObject() );
-		String command = reader.GetChildStringByName( "Command" );
-		if ( OVR_stricmp( command.ToCStr(), SYSTEM_ACTIVITY_EVENT_REORIENT ) == 0 )
+		// the app may have removed events from the JSON list
+		appEvents->Sync();
+		for ( int i = 0; i < appEvents->GetNumEvents(); ++i )
 		{
-			//LOG( "OvrGuiSysLocal::Frame - reorienting" );
-			app->RecenterYaw( false );
-			ResetMenuOrientations( app->GetLastViewMatrix() );
-			// remove this event so the app doesn't handle it again
-			SystemActivities_RemoveAppEvent( vrFrame.AppEvents, i );
-			--i;
+			switch ( appEvents->GetEvent( i ).Type )
+			{
+				case APP_EVENT_REORIENT:
+					//LOG( "OvrGuiSysLocal::Frame - reorienting" );
+					app->RecenterYaw( false );
+					ResetMenuOrientations( app->GetLastViewMatrix() );
+					// remove this event so the app doesn't handle it again
+					appEvents->Remove( i );
+					--i;
+					break;
+				default:
+					break;
+			}
 		}
-		jsonObj->Release();
 	}
 
 	// update volume popup
@@ -13,11 +13,15 @@ Copyright   :   Copyright 2015 Oculus VR, LLC. All Rights reserved.
 #include "MetaDataManager.h"
 
 #include "Kernel/OVR_JSON.h"
+#include "Kernel/OVR_JSONStream.h"
 #include "Kernel/OVR_LogUtils.h"
+#include "Kernel/OVR_SysFile.h"
 
 #include "VrCommon.h"
 #include "PackageFiles.h"
 
+#include <stdio.h>
+
 
 namespace OVR {
 
@@ -41,6 +45,25 @@ static bool OvrMetaDatumIdComparator( const OvrMetaDatum * a, const OvrMetaDatum
 	return a->Id < b->Id;
 }
 
+static JSON * TagsToJson( const Array< String > & tags )
+{
+	JSON * tagsObject = JSON::CreateArray();
+	for ( int t = 0; t < tags.GetSizeI(); ++t )
+	{
+		if ( JSON * tagObject = JSON::CreateObject() )
+		{
+			tagObject->AddStringItem( CATEGORY, tags.At( t ).ToCStr() );
+			tagsObject->AddArrayElement( tagObject );
+		}
+	}
+	return tagsObject;
+}
+
+OvrMetaData::~OvrMetaData()
+{
+	WaitForCompaction();
+}
+
 void OvrMetaData::InitFromDirectory( const char * relativePath, const Array< String > & searchPaths, const OvrMetaDataFileExtensions & fileExtensions )
 {
 	LOG( "OvrMetaData::InitFromDirectory( %s )", relativePath );
@@ -112,6 +135,7 @@ void OvrMetaData::InitFromDirectory( const char * relativePath, const Array< Str
 	if ( !currentCategory.DatumIndicies.IsEmpty() )
 	{
 		Categories.PushBack( currentCategory );
+		InvalidateCategoryIndex();
 	}
 
 	// Recurse into subdirs
@@ -142,6 +166,7 @@ void OvrMetaData::InitFromFileList( const Array< String > & fileList, const OvrM
 			cat.LocaleKey = cat.CategoryTag;
 			catIndex = Categories.GetSizeI();
 			Categories.PushBack( cat );
+			InvalidateCategoryIndex();
 			uniqueCategoryList.Add( categoryTag, catIndex );
 		}
 		else
@@ -187,14 +212,9 @@ void OvrMetaData::InitFromFileList( const Array< String > & fileList, const OvrM
 
 void OvrMetaData::RenameCategory( const char * currentTag, const char * newName )
 {
-	for ( int i = 0; i < Categories.GetSizeI(); ++i )
+	if ( Category * category = GetCategory( currentTag ) )
 	{
-		Category & cat = Categories.At( i );
-		if ( cat.CategoryTag == currentTag )
-		{
-			cat.LocaleKey = newName;
-			break;
-		}
+		category->LocaleKey = newName;
 	}
 }
 
@@ -220,21 +240,154 @@ bool OvrMetaData::RenameCategoryTag( const char * currentTag, const char * newNa
 		}
 	}
 	category->CategoryTag = newName;
+	InvalidateCategoryIndex();
 	return true;
 }
 
-JSON * LoadPackageMetaFile( const char * metaFile )
+// Replaces the tags of a datum read from the meta file with the tags in the journal, if
+// the journal has any for the datum.
+static void ApplyJournal( JSON * datum, const StringHash< Array< String > > & journal )
+{
+	const JsonReader datumReader( datum );
+	if ( !datumReader.IsObject() )
+	{
+		return;
+	}
+	const Array< String > * tags = journal.GetCaseInsensitive( datumReader.GetChildStringByName( URL_INNER ) );
+	if ( tags == NULL )
+	{
+		return;
+	}
+	JSON * newTags = TagsToJson( *tags );
+	if ( JSON * oldTags = datum->GetItemByName( TAGS ) )
+	{
+		oldTags->ReplaceNodeWith( newTags );
+		oldTags->Release();
+	}
+	else
+	{
+		datum->AddItem( TAGS, newTags );
+	}
+}
+
+bool OvrMetaData::ExtractMetaFile( JsonStreamReader & reader, const char * fileName, const Array< String > & searchPaths,
+	const StringHash< Array< String > > * journal, double & outVersion, Array< Category > & outCategories,
+	StringHash< OvrMetaDatum * > & outMetaData ) const
+{
+	if ( reader.Next() == JSON_TOKEN_BEGIN_OBJECT )
+	{
+		while ( reader.Next() == JSON_TOKEN_NAME )
+		{
+			if ( OVR_strcmp( reader.GetString(), VERSION ) == 0 )
+			{
+				outVersion = reader.ReadDouble( outVersion );
+			}
+			else if ( OVR_strcmp( reader.GetString(), CATEGORIES ) == 0 || OVR_strcmp( reader.GetString(), DATA ) == 0 )
+			{
+				const bool isData = ( OVR_strcmp( reader.GetString(), DATA ) == 0 );
+				if ( reader.Next() != JSON_TOKEN_BEGIN_ARRAY )
+				{
+					reader.SkipRestOfValue();
+					continue;
+				}
+				// Only one category or datum is held as a JSON tree at a time. ReadValue()
+				// returns NULL at the end of the array.
+				int jsonIndex = MetaData.GetSizeI();
+				while ( JSON * element = reader.ReadValue() )
+				{
+					if ( !isData )
+					{
+						ExtractCategory( JsonReader( element ), outCategories );
+					}
+					else
+					{
+						if ( journal != NULL )
+						{
+							ApplyJournal( element, *journal );
+						}
+						if ( ExtractDatum( JsonReader( element ), searchPaths, jsonIndex, outMetaData ) )
+						{
+							jsonIndex++;
+						}
+					}
+					element->Release();
+				}
+			}
+			else
+			{
+				reader.SkipValue();
+			}
+		}
+	}
+
+	if ( reader.GetToken() == JSON_TOKEN_ERROR || reader.GetDepth() != 0 )
+	{
+		WARN( "OvrMetaData failed to parse %s: %s (line %i)", fileName,
+				( reader.GetError() != NULL ) ? reader.GetError() : "unexpected value", reader.GetErrorLine() );
+		return false;
+	}
+	return true;
+}
+
+bool OvrMetaData::ExtractPackageMetaData( const char * metaFile, const Array< String > & searchPaths, double & outVersion,
+	Array< Category > & outCategories, StringHash< OvrMetaDatum * > & outMetaData ) const
 {
-	int bufferLength = 0;
-	void * 	buffer = NULL;
 	String assetsMetaFile = "assets/";
 	assetsMetaFile += metaFile;
-	ovr_ReadFileFromApplicationPackage( assetsMetaFile.ToCStr(), bufferLength, buffer );
-	if ( !buffer )
+
+	// The file is inflated in chunks while it is read.
+	int length = 0;
+	void * packageFile = ovr_OpenFileFromApplicationPackage( assetsMetaFile.ToCStr(), length );
+	if ( packageFile == NULL )
 	{
-		WARN( "LoadPackageMetaFile failed to read %s", assetsMetaFile.ToCStr() );
+		WARN( "ExtractPackageMetaData failed to read %s", assetsMetaFile.ToCStr() );
+		return false;
 	}
-	return JSON::Parse( static_cast< const char * >( buffer ) );
+
+	ovrPackageJsonSource source( packageFile );
+	JsonStreamReader reader( &source );
+	const bool extracted = ExtractMetaFile( reader, assetsMetaFile.ToCStr(), searchPaths, NULL, outVersion, outCategories, outMetaData );
+	ovr_ClosePackageFile( packageFile );
+	return extracted;
+}
+
+bool OvrMetaData::ExtractStoredMetaData( const Array< String > & searchPaths, double & outVersion,
+	Array< Category > & outCategories, StringHash< OvrMetaDatum * > & outMetaData ) const
+{
+	SysFile file;
+	if ( !file.Open( FilePath, File::Open_Read, File::Mode_Read ) )
+	{
+		return false;
+	}
+
+	// The old journal is left over from a compaction that did not complete
+	StringHash< Array< String > > journal;
+	ReadJournal( GetOldJournalPath().ToCStr(), journal );
+	ReadJournal( GetJournalPath().ToCStr(), journal );
+
+	// Nothing is returned from a file that is only partially valid.
+	double version = outVersion;
+	Array< Category > categories;
+	StringHash< OvrMetaDatum * > metaData;
+
+	JsonFileSource source( &file );
+	JsonStreamReader reader( &source );
+	const bool extracted = ExtractMetaFile( reader, FilePath.ToCStr(), searchPaths, &journal, version, categories, metaData );
+	file.Close();
+
+	if ( !extracted )
+	{
+		for ( StringHash< OvrMetaDatum * >::Iterator iter = metaData.Begin(); iter != metaData.End(); ++iter )
+		{
+			delete iter->Second;
+		}
+		return false;
+	}
+
+	outVersion = version;
+	Alg::Swap( outCategories, categories );
+	Alg::Swap( outMetaData, metaData );
+	return true;
 }
 
 JSON * OvrMetaData::CreateOrGetStoredMetaFile( const char * appFileStoragePath, const char * metaFile )
@@ -244,14 +397,14 @@ JSON * OvrMetaData::CreateOrGetStoredMetaFile( const char * appFileStoragePath,
 
 	LOG( "CreateOrGetStoredMetaFile FilePath: %s", FilePath.ToCStr() );
 
-	JSON * dataFile = JSON::Load( FilePath.ToCStr() );
+	JSON * dataFile = JSON::LoadArena( FilePath.ToCStr() );
 	if ( dataFile == NULL )
 	{
 		// If this is the first run, or we had an error loading the file, we copy the meta file from assets to app's cache
 		WriteMetaFile( metaFile );
 
 		// try loading it again
-		dataFile = JSON::Load( FilePath.ToCStr() );
+		dataFile = JSON::LoadArena( FilePath.ToCStr() );
 		if ( dataFile == NULL )
 		{
 			WARN( "OvrMetaData failed to load JSON meta file: %s", metaFile );
@@ -261,6 +414,19 @@ JSON * OvrMetaData::CreateOrGetStoredMetaFile( const char * appFileStoragePath,
 	{
 		LOG( "OvrMetaData::CreateOrGetStoredMetaFile found %s", FilePath.ToCStr() );
 	}
+
+	// The old journal is left over from a compaction that did not complete
+	StringHash< Array< String > > journal;
+	ReadJournal( GetOldJournalPath().ToCStr(), journal );
+	ReadJournal( GetJournalPath().ToCStr(), journal );
+	JSON * data = ( dataFile != NULL ) ? dataFile->GetItemByName( DATA ) : NULL;
+	if ( data != NULL && !journal.IsEmpty() )
+	{
+		for ( JSON * datum = data->GetFirstItem(); datum != NULL; datum = data->GetNextItem( datum ) )
+		{
+			ApplyJournal( datum, journal );
+		}
+	}
 	return dataFile;
 }
 
@@ -309,10 +475,30 @@ void OvrMetaData::InitFromDirectoryMergeMeta( const char * relativePath, const A
 
 	OVR_ASSERT( HasPermission( FilePath.ToCStr(), permissionFlags_t( PERMISSION_READ ) ) );
 
-	JSON * dataFile = CreateOrGetStoredMetaFile( appFileStoragePath.ToCStr(), metaFile );
-
 	InitFromDirectory( relativePath, searchPaths, fileExtensions );
-	ProcessMetaData( dataFile, searchPaths, metaFile );
+
+	// The stored meta file is streamed, one datum at a time, instead of being loaded
+	// with CreateOrGetStoredMetaFile().
+	double storedVersion = Version;
+	Array< Category > storedCategories;
+	StringHash< OvrMetaDatum * > storedMetaData;
+	bool stored = ExtractStoredMetaData( searchPaths, storedVersion, storedCategories, storedMetaData );
+	if ( !stored )
+	{
+		// If this is the first run, or we had an error loading the file, we copy the meta file from assets to app's cache
+		WriteMetaFile( metaFile );
+		stored = ExtractStoredMetaData( searchPaths, storedVersion, storedCategories, storedMetaData );
+		if ( !stored )
+		{
+			WARN( "OvrMetaData failed to load JSON meta file: %s", metaFile );
+		}
+	}
+	if ( stored )
+	{
+		Version = storedVersion;
+		MergeMetaData( searchPaths, metaFile, storedCategories, storedMetaData );
+	}
+	RewriteMetaFile();
 }
 
 void OvrMetaData::InitFromFileListMergeMeta( const Array< String > & fileList, const Array< String > & searchPaths,
@@ -366,12 +552,13 @@ void OvrMetaData::InsertCategoryList( const int startIndex, const Array< Categor
 	}
 
 	Alg::Swap( Categories, finalCategoryList );
+	InvalidateCategoryIndex();
 }
 
 void OvrMetaData::ProcessRemoteMetaFile( const char * metaFileString, const int startIndex )
 {
 	char const * errorMsg = NULL;
-	JSON * remoteMetaFile = JSON::Parse( metaFileString, &errorMsg );
+	JSON * remoteMetaFile = JSON::ParseArena( metaFileString, &errorMsg );
 	if ( remoteMetaFile != NULL )
 	{
 		// First grab the version
@@ -408,7 +595,7 @@ void OvrMetaData::ProcessRemoteMetaFile( const char * metaFileString, const int
 			FAIL( "OvrMetaData::ProcessMetaData failed to generate JSON meta file" );
 		}
 
-		dataFile->Save( FilePath.ToCStr() );
+		SaveMetaFile( dataFile );
 
 		LOG( "OvrMetaData::ProcessRemoteMetaFile updated %s", FilePath.ToCStr() );
 		dataFile->Release();
@@ -429,73 +616,95 @@ void OvrMetaData::ProcessMetaData( JSON * dataFile, const Array< String > & sear
 		Array< Category > storedCategories;
 		StringHash< OvrMetaDatum * > storedMetaData;
 		ExtractCategories( dataFile, storedCategories );
+		ExtractMetaData( dataFile, searchPaths, storedMetaData );
+		dataFile->Release();
+
+		MergeMetaData( searchPaths, metaFile, storedCategories, storedMetaData );
+	}
+	else
+	{
+		WARN( "OvrMetaData::ProcessMetaData NULL dataFile" );
+	}
+	RewriteMetaFile();
+}
 
-		// Read in package data first
-		JSON * packageMeta = LoadPackageMetaFile( metaFile );
-		if ( packageMeta )
+void OvrMetaData::MergeMetaData( const Array< String > & searchPaths, const char * metaFile,
+	Array< Category > & storedCategories, StringHash< OvrMetaDatum * > & storedMetaData )
+{
+	// Read in package data first, the package categories go after the stored ones
+	double packageVersion = 0.0;
+	StringHash< OvrMetaDatum * > mergedMetaData;
+	if ( ExtractPackageMetaData( metaFile, searchPaths, packageVersion, storedCategories, mergedMetaData ) )
+	{
+		// If we failed to find a version in the serialized data, need to set it from the assets version
+		if ( Version < 0.0 ) 
 		{
-			// If we failed to find a version in the serialized data, need to set it from the assets version
-			if ( Version < 0.0 ) 
+			Version = packageVersion;
+			if ( Version < 0.0 )
 			{
-				ExtractVersion( packageMeta, Version );
-				if ( Version < 0.0 )
-				{
-					Version = 0.0;
-				}
+				Version = 0.0;
 			}
-			ExtractCategories( packageMeta, storedCategories );
-			ExtractMetaData( packageMeta, searchPaths, storedMetaData );
-			packageMeta->Release();
+		}
+	}
+	else
+	{
+		WARN( "ProcessMetaData ExtractPackageMetaData failed for %s", metaFile );
+	}
+
+	// The stored data overrides any found in the package
+	for ( StringHash< OvrMetaDatum * >::Iterator storedIter = storedMetaData.Begin(); storedIter != storedMetaData.End(); ++storedIter )
+	{
+		StringHash< OvrMetaDatum * >::Iterator iter = mergedMetaData.FindCaseInsensitive( storedIter->First );
+		if ( iter == mergedMetaData.End() )
+		{
+			mergedMetaData.Add( storedIter->First, storedIter->Second );
 		}
 		else
 		{
-			WARN( "ProcessMetaData LoadPackageMetaFile failed for %s", metaFile );
+			delete iter->Second;
+			iter->Second = storedIter->Second;
 		}
+	}
+	storedMetaData.Clear();
 
-		// Read in the stored data - overriding any found in the package
-		ExtractMetaData( dataFile, searchPaths, storedMetaData );
+	// Reconcile the stored data vs the data read in
+	ReconcileCategories( storedCategories );
+	ReconcileMetaData( mergedMetaData );
 
-		// Reconcile the stored data vs the data read in
-		ReconcileCategories( storedCategories );
-		ReconcileMetaData( storedMetaData );
-	
-		// Recreate indices which may have changed after reconciliation
-		RegenerateCategoryIndices();
+	// Recreate indices which may have changed after reconciliation
+	RegenerateCategoryIndices();
 
-		// Delete any newly empty categories except Favorites 
-		if ( !Categories.IsEmpty() )
+	// Delete any newly empty categories except Favorites 
+	if ( !Categories.IsEmpty() )
+	{
+		Array< Category > finalCategories;
+		finalCategories.PushBack( Categories.At( 0 ) );
+		for ( int catIndex = 1; catIndex < Categories.GetSizeI(); ++catIndex )
 		{
-			Array< Category > finalCategories;
-			finalCategories.PushBack( Categories.At( 0 ) );
-			for ( int catIndex = 1; catIndex < Categories.GetSizeI(); ++catIndex )
+			Category & cat = Categories.At( catIndex );
+			if ( !cat.DatumIndicies.IsEmpty() )
 			{
-				Category & cat = Categories.At( catIndex );
-				if ( !cat.DatumIndicies.IsEmpty() )
-				{
-					finalCategories.PushBack( cat );
-				}
-				else
-				{
-					WARN( "OvrMetaData::ProcessMetaData discarding empty %s", cat.CategoryTag.ToCStr() );
-				}
+				finalCategories.PushBack( cat );
+			}
+			else
+			{
+				WARN( "OvrMetaData::ProcessMetaData discarding empty %s", cat.CategoryTag.ToCStr() );
 			}
-			Alg::Swap( finalCategories, Categories );
 		}
-		dataFile->Release();
-	}
-	else
-	{
-		WARN( "OvrMetaData::ProcessMetaData NULL dataFile" );
+		Alg::Swap( finalCategories, Categories );
+		InvalidateCategoryIndex();
 	}
+}
 
-	// Rewrite new data
-	dataFile = MetaDataToJson();
+void OvrMetaData::RewriteMetaFile()
+{
+	JSON * dataFile = MetaDataToJson();
 	if ( dataFile == NULL )
 	{
 		FAIL( "OvrMetaData::ProcessMetaData failed to generate JSON meta file" );
 	}
 
-	dataFile->Save( FilePath.ToCStr() );
+	SaveMetaFile( dataFile );
 
 	LOG( "OvrMetaData::ProcessMetaData created %s", FilePath.ToCStr() );
 	dataFile->Release();
@@ -528,11 +737,35 @@ void OvrMetaData::ReconcileMetaData( StringHash< OvrMetaDatum * > & storedMetaDa
 	{
 		MetaData.PushBack( *sortedIter );
 	}
+	UrlIndexDirty = true;
 	storedMetaData.Clear();
 }
 
 void OvrMetaData::DedupMetaData( Array< OvrMetaDatum * > & existingData, StringHash< OvrMetaDatum * > & newData )
 {
+	// With only a few new entries, look them up in the url index instead of walking all the existing data
+	if ( &existingData == &MetaData && (int)newData.GetSize() < existingData.GetSizeI() )
+	{
+		Array< String > dedupedUrls;
+		for ( StringHash< OvrMetaDatum * >::Iterator iter = newData.Begin(); iter != newData.End(); ++iter )
+		{
+			OvrMetaDatum * metaDatum = GetMetaDatumByUrl( iter->First );
+			if ( metaDatum != NULL )
+			{
+				OvrMetaDatum * storedDatum = iter->Second;
+				LOG( "DedupMetaData metadata for %s", storedDatum->Url.ToCStr() );
+				Alg::Swap( storedDatum->Tags, metaDatum->Tags );
+				SwapExtendedData( storedDatum, metaDatum );
+				dedupedUrls.PushBack( iter->First );
+			}
+		}
+		for ( int i = 0; i < dedupedUrls.GetSizeI(); ++i )
+		{
+			newData.Remove( dedupedUrls[ i ] );
+		}
+		return;
+	}
+
     // Fix the read in meta data using the stored
     for ( int i = 0; i < existingData.GetSizeI(); ++i )
     {
@@ -603,6 +836,7 @@ void OvrMetaData::ReconcileCategories( Array< Category > & storedCategories )
 
 	// Now replace Categories
 	Alg::Swap( Categories, finalCategories );
+	InvalidateCategoryIndex();
 }
 
 void OvrMetaData::ExtractVersion( JSON * dataFile, double & outVersion ) const
@@ -632,32 +866,36 @@ void OvrMetaData::ExtractCategories( JSON * dataFile, Array< Category > & outCat
 	{
 		while ( const JSON * nextElement = categories.GetNextArrayElement() )
 		{
-			const JsonReader category( nextElement );
-			if ( category.IsObject() )
-			{
-				Category extractedCategory;
-				extractedCategory.CategoryTag = category.GetChildStringByName( TAG );
-				extractedCategory.LocaleKey = category.GetChildStringByName( LABEL );
+			ExtractCategory( JsonReader( nextElement ), outCategories );
+		}
+	}
+}
 
-				// Check if we already have this category
-				bool exists = false;
-				for ( int i = 0; i < outCategories.GetSizeI(); ++i )
-				{
-					const Category & existingCat = outCategories.At( i );
-					if ( extractedCategory.CategoryTag == existingCat.CategoryTag )
-					{
-						exists = true;
-						break;
-					}
-				}
+void OvrMetaData::ExtractCategory( const JsonReader & category, Array< Category > & outCategories ) const
+{
+	if ( category.IsObject() )
+	{
+		Category extractedCategory;
+		extractedCategory.CategoryTag = category.GetChildStringByName( TAG );
+		extractedCategory.LocaleKey = category.GetChildStringByName( LABEL );
 
-				if ( !exists )
-				{
-					LOG( "Extracting category: %s", extractedCategory.CategoryTag.ToCStr() );
-					outCategories.PushBack( extractedCategory );
-				}
+		// Check if we already have this category
+		bool exists = false;
+		for ( int i = 0; i < outCategories.GetSizeI(); ++i )
+		{
+			const Category & existingCat = outCategories.At( i );
+			if ( extractedCategory.CategoryTag == existingCat.CategoryTag )
+			{
+				exists = true;
+				break;
 			}
 		}
+
+		if ( !exists )
+		{
+			LOG( "Extracting category: %s", extractedCategory.CategoryTag.ToCStr() );
+			outCategories.PushBack( extractedCategory );
+		}
 	}
 }
 
@@ -674,68 +912,78 @@ void OvrMetaData::ExtractMetaData( JSON * dataFile, const Array< String > & sear
 		int jsonIndex = MetaData.GetSizeI();
 		while ( const JSON * nextElement = data.GetNextArrayElement() )
 		{
-			const JsonReader datum( nextElement );
-			if ( datum.IsObject() )
+			if ( ExtractDatum( JsonReader( nextElement ), searchPaths, jsonIndex, outMetaData ) )
 			{
-				OvrMetaDatum * metaDatum = CreateMetaDatum( "" );
-				if ( !metaDatum )
-				{
-					continue;
-				}
+				jsonIndex++;
+			}
+		}
+	}
+}
 
-				metaDatum->Id = jsonIndex++;
-				const JsonReader tags( datum.GetChildByName( TAGS ) );
-				if ( tags.IsArray() )
-				{
-					while ( const JSON * tagElement = tags.GetNextArrayElement() )
-					{
-						const JsonReader tag( tagElement );
-						if ( tag.IsObject() )
-						{
-							metaDatum->Tags.PushBack( tag.GetChildStringByName( CATEGORY ) );
-						}
-					}
-				}
+bool OvrMetaData::ExtractDatum( const JsonReader & datum, const Array< String > & searchPaths, const int id, StringHash< OvrMetaDatum * > & outMetaData ) const
+{
+	if ( !datum.IsObject() )
+	{
+		return false;
+	}
 
-				OVR_ASSERT( !metaDatum->Tags.IsEmpty() );
+	OvrMetaDatum * metaDatum = CreateMetaDatum( "" );
+	if ( !metaDatum )
+	{
+		return false;
+	}
 
-				const String relativeUrl( datum.GetChildStringByName( URL_INNER ) );
-				metaDatum->Url = relativeUrl;
-				bool foundPath = false;
-				const bool isRemote = IsRemote( metaDatum );
-				
-				// Get the absolute path if this is a local file
-				if ( !isRemote )
-				{
-					foundPath = GetFullPath( searchPaths, relativeUrl.ToCStr(), metaDatum->Url );
-					if ( !foundPath )
-					{
-						// if we fail to find the file, check for encrypted extension (TODO: Might put this into a virtual function if necessary, benign for now)
-						foundPath = GetFullPath( searchPaths, String( relativeUrl + ".x" ).ToCStr(), metaDatum->Url );
-					}
-				}
-				
-				// if we fail to find the local file or it's a remote file, the Url is left as read in from the stored data
-				if ( isRemote || !foundPath )
-				{
-					metaDatum->Url = relativeUrl;
-				}
+	metaDatum->Id = id;
+	const JsonReader tags( datum.GetChildByName( TAGS ) );
+	if ( tags.IsArray() )
+	{
+		while ( const JSON * tagElement = tags.GetNextArrayElement() )
+		{
+			const JsonReader tag( tagElement );
+			if ( tag.IsObject() )
+			{
+				metaDatum->Tags.PushBack( tag.GetChildStringByName( CATEGORY ) );
+			}
+		}
+	}
 
-				ExtractExtendedData( datum, *metaDatum );
-				LOG( "OvrMetaData::ExtractMetaData adding datum %s", metaDatum->Url.ToCStr() );
+	OVR_ASSERT( !metaDatum->Tags.IsEmpty() );
 
-				StringHash< OvrMetaDatum * >::Iterator iter = outMetaData.FindCaseInsensitive( metaDatum->Url );
-				if ( iter == outMetaData.End() )
-				{
-					outMetaData.Add( metaDatum->Url, metaDatum );
-				}
-				else
-				{
-					iter->Second = metaDatum;
-				}
-			}
+	const String relativeUrl( datum.GetChildStringByName( URL_INNER ) );
+	metaDatum->Url = relativeUrl;
+	bool foundPath = false;
+	const bool isRemote = IsRemote( metaDatum );
+	
+	// Get the absolute path if this is a local file
+	if ( !isRemote )
+	{
+		foundPath = GetFullPath( searchPaths, relativeUrl.ToCStr(), metaDatum->Url );
+		if ( !foundPath )
+		{
+			// if we fail to find the file, check for encrypted extension (TODO: Might put this into a virtual function if necessary, benign for now)
+			foundPath = GetFullPath( searchPaths, String( relativeUrl + ".x" ).ToCStr(), metaDatum->Url );
 		}
 	}
+	
+	// if we fail to find the local file or it's a remote file, the Url is left as read in from the stored data
+	if ( isRemote || !foundPath )
+	{
+		metaDatum->Url = relativeUrl;
+	}
+
+	ExtractExtendedData( datum, *metaDatum );
+	LOG( "OvrMetaData::ExtractMetaData adding datum %s", metaDatum->Url.ToCStr() );
+
+	StringHash< OvrMetaDatum * >::Iterator iter = outMetaData.FindCaseInsensitive( metaDatum->Url );
+	if ( iter == outMetaData.End() )
+	{
+		outMetaData.Add( metaDatum->Url, metaDatum );
+	}
+	else
+	{
+		iter->Second = metaDatum;
+	}
+	return true;
 }
 
 void OvrMetaData::ExtractRemoteMetaData( JSON * dataFile, StringHash< OvrMetaDatum * > & outMetaData ) const
@@ -795,6 +1043,14 @@ void OvrMetaData::ExtractRemoteMetaData( JSON * dataFile, StringHash< OvrMetaDat
 
 void OvrMetaData::Serialize()
 {
+	if ( FilePath.IsEmpty() )
+	{
+		WARN( "OvrMetaData::Serialize no meta file" );
+		return;
+	}
+
+	WaitForCompaction();
+
 	// Serialize the new metadata
 	JSON * dataFile = MetaDataToJson();
 	if ( dataFile == NULL )
@@ -802,10 +1058,181 @@ void OvrMetaData::Serialize()
 		FAIL( "OvrMetaData::Serialize failed to generate JSON meta file" );
 	}
 
-	dataFile->Save( FilePath.ToCStr() );
+	// Changes from now on go to a new journal. If a previous compaction failed, the old
+	// journal is kept as is and both journals stay until the meta file is replaced.
+	const String journalPath = GetJournalPath();
+	const String oldJournalPath = GetOldJournalPath();
+	if ( !FileExists( oldJournalPath.ToCStr() ) && FileExists( journalPath.ToCStr() ) )
+	{
+		rename( journalPath.ToCStr(), oldJournalPath.ToCStr() );
+	}
+	JournalEntries = 0;
+
+	Compaction * compaction = new Compaction;
+	compaction->Snapshot = dataFile;
+	compaction->FilePath = FilePath;
+	compaction->OldJournalPath = oldJournalPath;
 
-	LOG( "OvrMetaData::Serialize updated %s", FilePath.ToCStr() );
-	dataFile->Release();
+	CompactionThread = new Thread( Thread::CreateParams( &CompactionThreadFunction, compaction, 128 * 1024, -1, Thread::NotRunning, Thread::BelowNormalPriority ) );
+	if ( !CompactionThread->Start() )
+	{
+		WARN( "OvrMetaData::Serialize failed to start the compaction thread" );
+		delete CompactionThread;
+		CompactionThread = NULL;
+		dataFile->Release();
+		delete compaction;
+	}
+}
+
+threadReturn_t OvrMetaData::CompactionThreadFunction( Thread * thread, void * v )
+{
+	thread->SetThreadName( "MetaCompaction" );
+
+	Compaction * compaction = (Compaction *)v;
+
+	// The meta file is replaced in one step, so it is never seen partially written
+	const String tempPath = compaction->FilePath + ".tmp";
+	if ( compaction->Snapshot->Save( tempPath.ToCStr() ) && rename( tempPath.ToCStr(), compaction->FilePath.ToCStr() ) == 0 )
+	{
+		remove( compaction->OldJournalPath.ToCStr() );
+		LOG( "OvrMetaData::Serialize updated %s", compaction->FilePath.ToCStr() );
+	}
+	else
+	{
+		WARN( "OvrMetaData::Serialize failed to write %s", compaction->FilePath.ToCStr() );
+	}
+
+	compaction->Snapshot->Release();
+	delete compaction;
+	return NULL;
+}
+
+bool OvrMetaData::IsCompacting() const
+{
+	return CompactionThread != NULL && !CompactionThread->IsFinished();
+}
+
+void OvrMetaData::WaitForCompaction()
+{
+	if ( CompactionThread != NULL )
+	{
+		CompactionThread->Join();
+		delete CompactionThread;
+		CompactionThread = NULL;
+	}
+}
+
+// Writes a complete meta file, which makes both journals redundant.
+void OvrMetaData::SaveMetaFile( JSON * dataFile )
+{
+	WaitForCompaction();
+
+	const String tempPath = FilePath + ".tmp";
+	if ( !dataFile->Save( tempPath.ToCStr() ) || rename( tempPath.ToCStr(), FilePath.ToCStr() ) != 0 )
+	{
+		WARN( "OvrMetaData::SaveMetaFile failed to write %s", FilePath.ToCStr() );
+		return;
+	}
+
+	remove( GetOldJournalPath().ToCStr() );
+	remove( GetJournalPath().ToCStr() );
+	JournalEntries = 0;
+}
+
+void OvrMetaData::AppendToJournal( const OvrMetaDatum & datum )
+{
+	if ( FilePath.IsEmpty() )
+	{
+		WARN( "OvrMetaData::AppendToJournal no meta file for %s", datum.Url.ToCStr() );
+		return;
+	}
+
+	JSON * entry = JSON::CreateObject();
+	entry->AddStringItem( URL_INNER, datum.Url.ToCStr() );
+	entry->AddItem( TAGS, TagsToJson( datum.Tags ) );
+	char * text = entry->PrintValue( 0, false );
+	entry->Release();
+
+	const String journalPath = GetJournalPath();
+	FILE * journal = fopen( journalPath.ToCStr(), "a" );
+	if ( journal == NULL )
+	{
+		WARN( "OvrMetaData::AppendToJournal failed to open %s", journalPath.ToCStr() );
+		OVR_FREE( text );
+		return;
+	}
+	fprintf( journal, "%s\n", text );
+	fclose( journal );
+	OVR_FREE( text );
+
+	// Never wait for a compaction here, the journal just grows until it is done
+	if ( ++JournalEntries >= MAX_JOURNAL_ENTRIES && !IsCompacting() )
+	{
+		Serialize();
+	}
+}
+
+// Each journal line replaces the tags of a datum, so reading a line more than once is harmless.
+void OvrMetaData::ReadJournal( const char * journalPath, StringHash< Array< String > > & outTags ) const
+{
+	FILE * journal = fopen( journalPath, "rb" );
+	if ( journal == NULL )
+	{
+		return;
+	}
+	fseek( journal, 0, SEEK_END );
+	const long length = ftell( journal );
+	fseek( journal, 0, SEEK_SET );
+	char * buffer = (char *)malloc( length + 1 );
+	const size_t readLength = fread( buffer, 1, length, journal );
+	buffer[ readLength ] = '\0';
+	fclose( journal );
+
+	int numRead = 0;
+	for ( char * line = buffer; *line != '\0'; )
+	{
+		char * end = strchr( line, '\n' );
+		if ( end != NULL )
+		{
+			*end = '\0';
+		}
+
+		// a crash while appending can leave a partial last line
+		JSON * entry = JSON::Parse( line );
+		if ( entry != NULL )
+		{
+			const JsonReader entryReader( entry );
+			const JsonReader tagsReader( entry->GetItemByName( TAGS ) );
+			if ( entryReader.IsObject() && tagsReader.IsArray() )
+			{
+				Array< String > tags;
+				while ( const JSON * tagElement = tagsReader.GetNextArrayElement() )
+				{
+					const JsonReader tag( tagElement );
+					if ( tag.IsObject() )
+					{
+						tags.PushBack( tag.GetChildStringByName( CATEGORY ) );
+					}
+				}
+				outTags.SetCaseInsensitive( entryReader.GetChildStringByName( URL_INNER ), tags );
+				numRead++;
+			}
+			entry->Release();
+		}
+		else if ( *line != '\0' )
+		{
+			WARN( "OvrMetaData::ReadJournal skipping invalid entry in %s", journalPath );
+		}
+
+		if ( end == NULL )
+		{
+			break;
+		}
+		line = end + 1;
+	}
+	free( buffer );
+
+	LOG( "OvrMetaData::ReadJournal read %d changes from %s", numRead, journalPath );
 }
 
 void OvrMetaData::RegenerateCategoryIndices()
@@ -830,6 +1257,7 @@ void OvrMetaData::RegenerateCategoryIndices()
 			{
 				LOG( "Removing broken metadatum %s", metaDatum.Url.ToCStr() );
 				MetaData.RemoveAtUnordered( metaDataIndex );
+				metaDataIndex--;	// the last datum was moved here
 			}
 		}
 	}
@@ -876,6 +1304,34 @@ void OvrMetaData::RegenerateCategoryIndices()
 			}
 		}
 	}
+
+	RebuildUrlIndex();
+}
+
+void OvrMetaData::RebuildCategoryIndex()
+{
+	TagToCategoryIndex.Clear();
+	for ( int i = 0; i < Categories.GetSizeI(); ++i )
+	{
+		if ( TagToCategoryIndex.Find( Categories[ i ].CategoryTag ) == TagToCategoryIndex.End() )
+		{
+			TagToCategoryIndex.Add( Categories[ i ].CategoryTag, i );
+		}
+	}
+	CategoryIndexDirty = false;
+}
+
+void OvrMetaData::RebuildUrlIndex()
+{
+	UrlToIndex.Clear();
+	for ( int i = 0; i < MetaData.GetSizeI(); ++i )
+	{
+		if ( UrlToIndex.FindCaseInsensitive( MetaData[ i ]->Url ) == UrlToIndex.End() )
+		{
+			UrlToIndex.Add( MetaData[ i ]->Url, i );
+		}
+	}
+	UrlIndexDirty = false;
 }
 
 JSON * OvrMetaData::MetaDataToJson() const
@@ -912,20 +1368,7 @@ JSON * OvrMetaData::MetaDataToJson() const
 		{
 			ExtendedDataToJson( metaDatum, datumObject );
 			datumObject->AddStringItem( URL_INNER, metaDatum.Url.ToCStr() );
-			LOG( "OvrMetaData::MetaDataToJson adding datum url %s", metaDatum.Url.ToCStr() );
-			if ( JSON * newTagsObject = JSON::CreateArray() )
-			{
-				for ( int t = 0; t < metaDatum.Tags.GetSizeI(); ++t )
-				{
-					if ( JSON * tagObject = JSON::CreateObject() )
-					{
-						tagObject->AddStringItem( CATEGORY, metaDatum.Tags.At( t ).ToCStr() );
-						newTagsObject->AddArrayElement( tagObject );
-					}
-				}
-
-				datumObject->AddItem( TAGS, newTagsObject );
-			}
+			datumObject->AddItem( TAGS, TagsToJson( metaDatum.Tags ) );
 			newDataObject->AddArrayElement( datumObject );
 		}
 	}
@@ -936,15 +1379,10 @@ JSON * OvrMetaData::MetaDataToJson() const
 
 TagAction OvrMetaData::ToggleTag( OvrMetaDatum * metaDatum, const String & newTag )
 {
-	JSON * DataFile = JSON::Load( FilePath.ToCStr() );
-	if ( DataFile == NULL )
-	{
-		FAIL( "OvrMetaData failed to load JSON meta file: %s", FilePath.ToCStr() );
-	}
-
-	OVR_ASSERT( DataFile );
 	OVR_ASSERT( metaDatum );
 
+	const int metaDataIndex = GetMetaDatumIndex( metaDatum );
+
 	// First update the local data
 	TagAction action = TAG_ERROR;
 	for ( int t = 0; t < metaDatum->Tags.GetSizeI(); ++t )
@@ -960,6 +1398,7 @@ TagAction OvrMetaData::ToggleTag( OvrMetaDatum * metaDatum, const String & newTa
 			LOG( "ToggleTag TAG_REMOVED tag: %s on %s", newTag.ToCStr(), metaDatum->Url.ToCStr() );
 			action = TAG_REMOVED;
 			metaDatum->Tags.RemoveAt( t );
+			RemoveFromCategory( newTag, metaDataIndex );
 			break;
 		}
 	}
@@ -968,38 +1407,49 @@ TagAction OvrMetaData::ToggleTag( OvrMetaDatum * metaDatum, const String & newTa
 	{
 		LOG( "ToggleTag TAG_ADDED tag: %s on %s", newTag.ToCStr(), metaDatum->Url.ToCStr() );
 		metaDatum->Tags.PushBack( newTag );
+		AddToCategory( newTag, metaDataIndex );
 		action = TAG_ADDED;
 	}
 
-	// Then serialize 
-	JSON * newTagsObject = JSON::CreateArray();
-	OVR_ASSERT( newTagsObject );
-
-	newTagsObject->Name = TAGS;
+	// Then serialize
+	AppendToJournal( *metaDatum );
+	return action;
+}
 
-	for ( int t = 0; t < metaDatum->Tags.GetSizeI(); ++t )
+void OvrMetaData::AddToCategory( const String & tag, const int metaDataIndex )
+{
+	Category * category = GetCategory( tag );
+	if ( category == NULL || metaDataIndex < 0 )
 	{
-		if ( JSON * tagObject = JSON::CreateObject() )
+		return;
+	}
+	for ( int i = 0; i < category->DatumIndicies.GetSizeI(); ++i )
+	{
+		if ( category->DatumIndicies[ i ] == metaDataIndex )
 		{
-			tagObject->AddStringItem( CATEGORY, metaDatum->Tags.At( t ).ToCStr() );
-			newTagsObject->AddArrayElement( tagObject );
+			return;
 		}
 	}
+	category->DatumIndicies.PushBack( metaDataIndex );
+	category->Dirty = true;
+}
 
-	if ( JSON * data = DataFile->GetItemByName( DATA ) )
+void OvrMetaData::RemoveFromCategory( const String & tag, const int metaDataIndex )
+{
+	Category * category = GetCategory( tag );
+	if ( category == NULL || metaDataIndex < 0 )
 	{
-		if ( JSON * datum = data->GetItemByIndex( metaDatum->Id ) )
+		return;
+	}
+	for ( int i = 0; i < category->DatumIndicies.GetSizeI(); ++i )
+	{
+		if ( category->DatumIndicies[ i ] == metaDataIndex )
 		{
-			if ( JSON * tags = datum->GetItemByName( TAGS ) )
-			{
-				tags->ReplaceNodeWith( newTagsObject );
-				tags->Release();
-				DataFile->Save( FilePath.ToCStr() );
-			}
+			category->DatumIndicies.RemoveAt( i );
+			category->Dirty = true;
+			return;
 		}
 	}
-	DataFile->Release();
-	return action;
 }
 
 void OvrMetaData::AddCategory( const String & name )
@@ -1008,6 +1458,7 @@ void OvrMetaData::AddCategory( const String & name )
 	cat.CategoryTag = name;
 	cat.LocaleKey = name;
 	Categories.PushBack( cat );
+	InvalidateCategoryIndex();
 }
 
 void OvrMetaData::InsertCategoryAt( const int index, const String & name )
@@ -1025,6 +1476,7 @@ void OvrMetaData::InsertCategoryAt( const int index, const String & name )
 			cat.CategoryTag = name;
 			cat.LocaleKey = name;
 			Categories.InsertAt( index, cat );
+			InvalidateCategoryIndex();
 		}
 		else
 		{
@@ -1036,16 +1488,14 @@ void OvrMetaData::InsertCategoryAt( const int index, const String & name )
 
 OvrMetaData::Category * OvrMetaData::GetCategory( const String & categoryName )
 {
-	const int numCategories = Categories.GetSizeI();
-	for ( int i = 0; i < numCategories; ++i )
+	// Every change to the categories, including through GetCategory( int ), invalidates the
+	// index, so a miss in an up to date index means there is no such category.
+	if ( CategoryIndexDirty )
 	{
-		Category & category = Categories.At( i );
-		if ( category.CategoryTag == categoryName )
-		{
-			return &category;
-		}
+		RebuildCategoryIndex();
 	}
-	return NULL;
+	const int * index = TagToCategoryIndex.Get( categoryName );
+	return ( index != NULL ) ? &Categories[ *index ] : NULL;
 }
 
 const OvrMetaDatum & OvrMetaData::GetMetaDatum( const int index ) const
@@ -1054,6 +1504,36 @@ const OvrMetaDatum & OvrMetaData::GetMetaDatum( const int index ) const
 	return *MetaData.At( index );
 }
 
+OvrMetaDatum * OvrMetaData::GetMetaDatumByUrl( const String & url )
+{
+	if ( UrlIndexDirty )
+	{
+		RebuildUrlIndex();
+	}
+	const int * index = UrlToIndex.GetCaseInsensitive( url );
+	if ( index != NULL && ( *index >= MetaData.GetSizeI() || MetaData[ *index ]->Url.CompareNoCase( url.ToCStr() ) != 0 ) )
+	{
+		// the meta data was changed through GetMetaData()
+		RebuildUrlIndex();
+		index = UrlToIndex.GetCaseInsensitive( url );
+	}
+	return ( index != NULL ) ? MetaData[ *index ] : NULL;
+}
+
+// Returns the index of the datum in the meta data, which is normally its Id.
+int OvrMetaData::GetMetaDatumIndex( const OvrMetaDatum * datum )
+{
+	if ( datum->Id >= 0 && datum->Id < MetaData.GetSizeI() && MetaData[ datum->Id ] == datum )
+	{
+		return datum->Id;
+	}
+	if ( GetMetaDatumByUrl( datum->Url ) == datum )
+	{
+		return *UrlToIndex.GetCaseInsensitive( datum->Url );
+	}
+	return -1;
+}
+
 
 bool OvrMetaData::GetMetaData( const Category & category, Array< const OvrMetaDatum * > & outMetaData ) const
 {
@@ -16,10 +16,12 @@ Copyright   :   Copyright 2015 Oculus VR, LLC. All Rights reserved.
 #include "Kernel/OVR_Array.h"
 #include "Kernel/OVR_String.h"
 #include "Kernel/OVR_StringHash.h"
+#include "Kernel/OVR_Threads.h"
 
 namespace OVR {
 class JSON;
 class JsonReader;
+class JsonStreamReader;
 //==============================================================
 // OvrMetaData
 struct OvrMetaDatum
@@ -62,8 +64,13 @@ public:
 	};
 
 	OvrMetaData()
-		: Version( -1.0 )
+		: CategoryIndexDirty( true )
+		, UrlIndexDirty( false )
+		, JournalEntries( 0 )
+		, CompactionThread( NULL )
+		, Version( -1.0 )
 	{}
+	virtual ~OvrMetaData();
 
 	// Init meta data from contents on disk
 	void					InitFromDirectory( const char * relativePath, const Array< String > & searchPaths, const OvrMetaDataFileExtensions & fileExtensions );
@@ -90,10 +97,13 @@ public:
 	// Rename a category tag after construction 
 	bool					RenameCategoryTag( const char * currentTag, const char * newName );
 
-	// Adds or removes tag and returns action taken
+	// Adds or removes tag and returns action taken.
+	// The category of the tag is updated in place, and the change is appended to the
+	// journal of the meta file instead of rewriting it.
 	TagAction				ToggleTag( OvrMetaDatum * data, const String & tag );
 
-	// Returns metaData file if one is found, otherwise creates one using the default meta.json in the assets folder
+	// Returns metaData file if one is found, otherwise creates one using the default meta.json in the assets folder.
+	// Changes in the journal of the meta file are applied to the returned data.
 	JSON *					CreateOrGetStoredMetaFile( const char * appFileStoragePath, const char * metaFile );
 	void					AddCategory( const String & name );
 	void					InsertCategoryAt( const int index, const String & name );
@@ -101,8 +111,9 @@ public:
 	const Array< Category > &			GetCategories() const 							{ return Categories; }
 	const Array< OvrMetaDatum * > &		GetMetaData() const 							{ return MetaData; }
 	const Category & 					GetCategory( const int index ) const 			{ return Categories.At( index ); }
-	Category & 							GetCategory( const int index )   				{ return Categories.At( index ); }
+	Category & 							GetCategory( const int index )   				{ InvalidateCategoryIndex(); return Categories.At( index ); }
 	const OvrMetaDatum &				GetMetaDatum( const int index ) const;
+	OvrMetaDatum *						GetMetaDatumByUrl( const String & url );
 	bool 								GetMetaData( const Category & category, Array< const OvrMetaDatum * > & outMetaData ) const;
 	void								SetCategoryDatumIndicies( const int index, const Array< int >& datumIndicies );
 	void								DumpToLog( bool const verbose ) const;
@@ -127,7 +138,7 @@ public:
 	double						GetVersion()												{ return Version; }
 	void						SetVersion( const double val )								{ Version = val; }
 	Array< OvrMetaDatum * > &	GetMetaData()												{ return MetaData; }
-	void						SetMetaData( const Array< OvrMetaDatum * > & newData )		{ MetaData = newData; }
+	void						SetMetaData( const Array< OvrMetaDatum * > & newData )		{ MetaData = newData; UrlIndexDirty = true; }
 
 	Category * 				GetCategory( const String & categoryName );
 
@@ -141,12 +152,70 @@ public:
 	void					ExtractCategories( JSON * dataFile, Array< Category > & outCategories ) const;
 	void					ExtractMetaData( JSON * dataFile, const Array< String > & searchPaths, StringHash< OvrMetaDatum * > & outMetaData ) const;
 	void					ExtractRemoteMetaData( JSON * dataFile, StringHash< OvrMetaDatum * > & outMetaData ) const;
+	void					ExtractCategory( const JsonReader & category, Array< Category > & outCategories ) const;
+	bool					ExtractDatum( const JsonReader & datum, const Array< String > & searchPaths, const int id, StringHash< OvrMetaDatum * > & outMetaData ) const;
+	// Extracts the version, categories and data from a meta file without building a JSON
+	// tree for the whole file, only for one category or datum at a time. The tags in the
+	// journal, if not NULL, replace the tags of the data read from the file.
+	bool					ExtractMetaFile( JsonStreamReader & reader, const char * fileName, const Array< String > & searchPaths,
+								const StringHash< Array< String > > * journal, double & outVersion,
+								Array< Category > & outCategories, StringHash< OvrMetaDatum * > & outMetaData ) const;
+	// Streams the meta file in the package, which is inflated in chunks while it is read.
+	bool					ExtractPackageMetaData( const char * metaFile, const Array< String > & searchPaths, double & outVersion,
+								Array< Category > & outCategories, StringHash< OvrMetaDatum * > & outMetaData ) const;
+	// Streams the stored meta file and applies its journal. Returns false, and nothing
+	// else, if the file is missing or invalid.
+	bool					ExtractStoredMetaData( const Array< String > & searchPaths, double & outVersion,
+								Array< Category > & outCategories, StringHash< OvrMetaDatum * > & outMetaData ) const;
+	// Merges the stored data with the data in the package and with the data found on disk.
+	void					MergeMetaData( const Array< String > & searchPaths, const char * metaFile,
+								Array< Category > & storedCategories, StringHash< OvrMetaDatum * > & storedMetaData );
+	void					RewriteMetaFile();
+	// Rewrites the meta file, including all journaled changes. Serialize is asynchronous:
+	// the meta data is copied into a JSON tree on the calling thread, and the tree is saved
+	// on a background thread, so the file may not be written yet when this returns. A
+	// call waits for the previous save to finish first.
 	void					Serialize();
 private:
+	// The journal holds one line of JSON with the url and tags of a datum per change.
+	// Once it has MAX_JOURNAL_ENTRIES lines, a snapshot of the meta data is written to
+	// the meta file in the background. The journal is first renamed to the old journal,
+	// which is only removed once the meta file was replaced, so the meta file plus the
+	// old journal plus the journal always hold the latest tags.
+	static const int		MAX_JOURNAL_ENTRIES = 128;
+
+	struct Compaction
+	{
+		JSON *				Snapshot;
+		String				FilePath;
+		String				OldJournalPath;
+	};
+
+	void					InvalidateCategoryIndex()									{ CategoryIndexDirty = true; }
+	void					RebuildCategoryIndex();
+	void					RebuildUrlIndex();
+	int						GetMetaDatumIndex( const OvrMetaDatum * datum );
+	void					AddToCategory( const String & tag, const int metaDataIndex );
+	void					RemoveFromCategory( const String & tag, const int metaDataIndex );
+
+	String					GetJournalPath() const										{ return FilePath + ".journal"; }
+	String					GetOldJournalPath() const									{ return FilePath + ".journal.old"; }
+	void					AppendToJournal( const OvrMetaDatum & datum );
+	void					ReadJournal( const char * journalPath, StringHash< Array< String > > & outTags ) const;
+	void					SaveMetaFile( JSON * dataFile );
+	bool					IsCompacting() const;
+	void					WaitForCompaction();
+	static threadReturn_t	CompactionThreadFunction( Thread * thread, void * v );
+
 	String 					FilePath;
 	Array< Category >		Categories;
 	Array< OvrMetaDatum * >	MetaData;
+	StringHash< int >		TagToCategoryIndex;
 	StringHash< int >		UrlToIndex;
+	bool					CategoryIndexDirty;
+	bool					UrlIndexDirty;
+	int						JournalEntries;
+	Thread *				CompactionThread;
 	double					Version;
 };
 
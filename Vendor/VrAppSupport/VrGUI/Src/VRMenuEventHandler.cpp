@@ -52,7 +52,7 @@ void VRMenuEventHandler::Frame( OvrGuiSys & guiSys, VrFrame const & vrFrame,
 	const Vector3f viewFwd( GetViewMatrixForward( viewMatrix ) );
 
 	HitTestResult result;
-	menuHandle_t hitHandle = root->HitTest( guiSys, menuPose, viewPos, viewFwd, ContentFlags_t( CONTENT_SOLID ), result );
+	menuHandle_t hitHandle = HitTestIndex.HitTest( guiSys, rootHandle, menuPose, viewPos, viewFwd, ContentFlags_t( CONTENT_SOLID ), result );
 	result.RayStart = viewPos;
 	result.RayDir = viewFwd;
 
@@ -48,6 +48,8 @@ public:
 private:
 	menuHandle_t	FocusedHandle;
 
+	VRMenuHitTestIndex	HitTestIndex;	// hit tests the gaze against the objects of the menu
+
 	ovrSoundLimiter	GazeOverSoundLimiter;
 	ovrSoundLimiter	DownSoundLimiter;
 	ovrSoundLimiter	UpSoundLimiter;
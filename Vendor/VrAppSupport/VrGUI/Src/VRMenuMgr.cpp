@@ -225,6 +225,163 @@ public:
 	}
 };
 
+//==============================
+// GetTextPosition
+static Vector3f GetTextPosition( Posef const & itemPose, Posef const & textLocalPose, Vector3f const & scale )
+{
+	Posef curTextPose;
+// FIXME: this doesn't mirror the scale / rotation order for the localPose above
+//	curTextPose.Position = itemPose.Position + ( itemPose.Orientation * scale.EntrywiseMultiply( textLocalPose.Position ) );
+	curTextPose.Position = itemPose.Position + ( itemPose.Orientation * textLocalPose.Position * scale );
+	curTextPose.Orientation = textLocalPose.Orientation * itemPose.Orientation;
+	Vector3f textNormal = curTextPose.Orientation * Vector3f( 0.0f, 0.0f, 1.0f );
+	return curTextPose.Position + textNormal * 0.001f; // this is simply to prevent z-fighting right now
+}
+
+//==============================================================
+// VRMenuTransformTree
+// The objects of a submitted menu tree, flattened in submission order so that parents
+// always come before their children, with the world transforms of each object cached
+// in parallel arrays. The transforms of an object are only recomputed when its revision
+// changes or when the transforms of its parent were recomputed.
+class VRMenuTransformTree
+{
+public:
+										VRMenuTransformTree( menuHandle_t const rootHandle );
+
+	// Flattens the tree again. All transforms are recomputed on the next submission.
+	void								Flatten( OvrVRMenuMgr const & menuMgr, VRMenuObject const * root );
+
+	// Recomputes the cached state of one object from the cached state of its parent.
+	void								UpdateTransforms( BitmapFont const & font, int const index,
+												Posef const & parentModelPose, Vector4f const & parentColor,
+												Vector3f const & parentScale );
+
+	menuHandle_t						RootHandle;
+	Posef								WorldPose;				// world pose the transforms were computed for
+	int									HierarchyChangeCount;	// VRMenuObject::GetHierarchyChangeCount() when flattened
+	int									LastFrame;				// frame the tree was last submitted on
+	bool								Valid;
+
+	// per object, in submission order
+	ArrayPOD< VRMenuObject const * >	Objects;
+	ArrayPOD< int >						Parents;		// index of the parent, or -1 for the root
+	ArrayPOD< int >						SubtreeEnds;	// one past the index of the last descendant
+	ArrayPOD< int >						Revisions;		// object revisions the cached state was computed for
+	Array< Posef >						ModelPoses;		// world pose, including the hilight pose for objects that render
+	Array< Vector4f >					Colors;			// color modulated by all parent colors
+	Array< Vector3f >					Scales;			// scale multiplied by all parent scales
+	Array< Vector3f >					ItemUps;
+	Array< Vector3f >					ItemNormals;
+	Array< Vector3f >					TextPositions;	// world position of the text, unless the object is billboarded
+	Array< Bounds3f >					LocalBounds;	// local bounds scaled by the parent scale
+	Array< Bounds3f >					CullBounds;
+
+	// per object, only valid for the current submission
+	ArrayPOD< UByte >					Visited;		// 1 if the object and all its parents are visible
+	ArrayPOD< UByte >					Updated;		// 1 if the transforms were recomputed
+	ArrayPOD< UByte >					BoundsDirty;	// 1 if the cull bounds need to be recomputed
+	ArrayPOD< int >						DistanceIndices;// distance index passed on to the children
+
+private:
+	void								Flatten_r( OvrVRMenuMgr const & menuMgr, VRMenuObject const * obj, int const parent );
+};
+
+//==============================
+// VRMenuTransformTree::VRMenuTransformTree
+VRMenuTransformTree::VRMenuTransformTree( menuHandle_t const rootHandle )
+	: RootHandle( rootHandle )
+	, HierarchyChangeCount( 0 )
+	, LastFrame( 0 )
+	, Valid( false )
+{
+}
+
+//==============================
+// VRMenuTransformTree::Flatten_r
+void VRMenuTransformTree::Flatten_r( OvrVRMenuMgr const & menuMgr, VRMenuObject const * obj, int const parent )
+{
+	int const index = Objects.GetSizeI();
+	Objects.PushBack( obj );
+	Parents.PushBack( parent );
+	SubtreeEnds.PushBack( index + 1 );
+	Revisions.PushBack( obj->GetRevision() - 1 );	// force an update
+
+	for ( int i = 0; i < obj->NumChildren(); ++i )
+	{
+		VRMenuObject const * child = menuMgr.ToObject( obj->GetChildHandleForIndex( i ) );
+		if ( child != NULL )
+		{
+			Flatten_r( menuMgr, child, index );
+		}
+	}
+
+	SubtreeEnds[index] = Objects.GetSizeI();
+}
+
+//==============================
+// VRMenuTransformTree::Flatten
+void VRMenuTransformTree::Flatten( OvrVRMenuMgr const & menuMgr, VRMenuObject const * root )
+{
+	Objects.Resize( 0 );
+	Parents.Resize( 0 );
+	SubtreeEnds.Resize( 0 );
+	Revisions.Resize( 0 );
+
+	Flatten_r( menuMgr, root, -1 );
+
+	int const numObjects = Objects.GetSizeI();
+	ModelPoses.Resize( numObjects );
+	Colors.Resize( numObjects );
+	Scales.Resize( numObjects );
+	ItemUps.Resize( numObjects );
+	ItemNormals.Resize( numObjects );
+	TextPositions.Resize( numObjects );
+	LocalBounds.Resize( numObjects );
+	CullBounds.Resize( numObjects );
+	Visited.Resize( numObjects );
+	Updated.Resize( numObjects );
+	BoundsDirty.Resize( numObjects );
+	DistanceIndices.Resize( numObjects );
+
+	HierarchyChangeCount = VRMenuObject::GetHierarchyChangeCount();
+	Valid = true;
+}
+
+//==============================
+// VRMenuTransformTree::UpdateTransforms
+void VRMenuTransformTree::UpdateTransforms( BitmapFont const & font, int const index,
+		Posef const & parentModelPose, Vector4f const & parentColor, Vector3f const & parentScale )
+{
+	VRMenuObject const * obj = Objects[index];
+	Posef const & localPose = obj->GetLocalPose();
+
+	Posef curModelPose;
+	curModelPose.Position = parentModelPose.Position + ( parentModelPose.Orientation * parentScale.EntrywiseMultiply( localPose.Position ) );
+	curModelPose.Orientation = parentModelPose.Orientation * localPose.Orientation;
+
+	Vector3f const scale = parentScale.EntrywiseMultiply( obj->GetLocalScale() );
+
+	if ( obj->GetType() != VRMENU_CONTAINER )
+	{
+		Posef const & hilightPose = obj->GetHilightPose();
+		Posef itemPose( curModelPose.Orientation * hilightPose.Orientation,
+						curModelPose.Position + ( curModelPose.Orientation * parentScale.EntrywiseMultiply( hilightPose.Position ) ) );
+		Matrix4f poseMat( itemPose.Orientation );
+		ItemUps[index] = poseMat.GetYBasis();
+		ItemNormals[index] = poseMat.GetZBasis();
+		curModelPose = itemPose;	// so children like the slider bar caret use our hilight offset and don't end up clipping behind us!
+
+		TextPositions[index] = GetTextPosition( itemPose, obj->GetTextLocalPose(), scale );
+	}
+
+	ModelPoses[index] = curModelPose;
+	Colors[index] = parentColor * obj->GetColor();
+	Scales[index] = scale;
+	LocalBounds[index] = obj->GetLocalBounds( font ) * parentScale;
+	Revisions[index] = obj->GetRevision();
+}
+
 //==============================================================
 // VRMenuMgrLocal
 class VRMenuMgrLocal : public OvrVRMenuMgr
@@ -259,6 +416,8 @@ public:
 	// Call once per frame before rendering to sort surfaces.
 	virtual void				Finish( Matrix4f const & viewMatrix );
 
+	virtual void				GetSubmitStats( int & numVisited, int & numRecomputed ) const;
+
 #if 1
 	virtual void 				RenderEyeView( Matrix4f const & centerViewMatrix, 
 										Matrix4f const & viewMatrix, 
@@ -279,12 +438,12 @@ private:
 	// private methods
 	//--------------------------------------------------------------
 	void						CondenseList();
-	void						SubmitForRenderingRecursive( OvrGuiSys & guiSys, Matrix4f const & centerViewMatrix,
-										VRMenuRenderFlags_t const & flags, VRMenuObject const * obj, 
-										Posef const & parentModelPose, Vector4f const & parentColor, 
-										Vector3f const & parentScale, Bounds3f & cullBounds,
-                                        SubmittedMenuObject * submitted, int const maxIndices, int & curIndex,
-										int const distanceIndex ) const;
+	VRMenuTransformTree &		GetTransformTree( menuHandle_t const rootHandle );
+	void						SubmitObject( OvrGuiSys & guiSys, Matrix4f const & centerViewMatrix,
+										VRMenuRenderFlags_t const & flags, VRMenuTransformTree const & tree,
+										int const index, int const distanceIndex, int & submissionIndex );
+	void						UpdateCullBounds( VRMenuTransformTree & tree ) const;
+	void						DrawDebug( OvrGuiSys & guiSys, VRMenuTransformTree const & tree, Posef const & worldPose ) const;
 
 	//--------------------------------------------------------------
 	// private members
@@ -300,6 +459,13 @@ private:
 	int						NumSubmitted;				// number of currently submitted menu objects
 	mutable int				NumToRender;				// number of submitted objects to render
 
+	Array< VRMenuTransformTree * >	TransformTrees;		// cached transforms of the menu trees submitted on the last frame
+	int						FrameNumber;				// incremented by Finish()
+	int						NumNodesVisited;			// number of objects submitted on the current frame
+	int						NumNodesRecomputed;			// number of objects whose transforms were recomputed on the current frame
+	int						LastNodesVisited;
+	int						LastNodesRecomputed;
+
 	GlProgram		        GUIProgramDiffuseOnly;					// has a diffuse only
 	GlProgram		        GUIProgramDiffusePlusAdditive;			// has a diffuse and an additive
 	GlProgram				GUIProgramDiffuseComposite;				// has a two diffuse maps
@@ -368,6 +534,11 @@ VRMenuMgrLocal::VRMenuMgrLocal( OvrGuiSys & guiSys )
 	, Initialized( false )
 	, NumSubmitted( 0 )
 	, NumToRender( 0 )
+	, FrameNumber( 0 )
+	, NumNodesVisited( 0 )
+	, NumNodesRecomputed( 0 )
+	, LastNodesVisited( 0 )
+	, LastNodesRecomputed( 0 )
 {
 }
 
@@ -375,6 +546,11 @@ VRMenuMgrLocal::VRMenuMgrLocal( OvrGuiSys & guiSys )
 // VRMenuMgrLocal::~VRMenuMgrLocal
 VRMenuMgrLocal::~VRMenuMgrLocal()
 {
+	for ( int i = 0; i < TransformTrees.GetSizeI(); ++i )
+	{
+		delete TransformTrees[i];
+	}
+	TransformTrees.Clear();
 }
 
 //==================================
@@ -634,234 +810,224 @@ static void LogBounds( const char * name, char const * prefix, Bounds3f const &
 */
 
 //==============================
-// VRMenuMgrLocal::SubmitForRenderingRecursive
-void VRMenuMgrLocal::SubmitForRenderingRecursive( OvrGuiSys & guiSys, Matrix4f const & centerViewMatrix, 
-		VRMenuRenderFlags_t const & flags, VRMenuObject const * obj, Posef const & parentModelPose, 
-		Vector4f const & parentColor, Vector3f const & parentScale, Bounds3f & cullBounds, 
-		SubmittedMenuObject * submitted, int const maxIndices, int & curIndex, int const distanceIndex ) const
+// VRMenuMgrLocal::GetTransformTree
+VRMenuTransformTree & VRMenuMgrLocal::GetTransformTree( menuHandle_t const rootHandle )
 {
-	if ( curIndex >= maxIndices )
+	for ( int i = 0; i < TransformTrees.GetSizeI(); ++i )
 	{
-		// If this happens we're probably not correctly clearing the submitted surfaces each frame
-		// OR we've got a LOT of surfaces.
-		LOG( "maxIndices = %i, curIndex = %i", maxIndices, curIndex );
-		ASSERT_WITH_TAG( curIndex < maxIndices, "VrMenu" );
-		return;
+		if ( TransformTrees[i]->RootHandle == rootHandle )
+		{
+			return *TransformTrees[i];
+		}
 	}
+	TransformTrees.PushBack( new VRMenuTransformTree( rootHandle ) );
+	return *TransformTrees.Back();
+}
 
-	// check if this object is hidden
-	if ( obj->GetFlags() & VRMENUOBJECT_DONT_RENDER )
+//==============================
+// VRMenuMgrLocal::SubmitObject
+// Submits the surfaces and text of one object using its cached transforms.
+void VRMenuMgrLocal::SubmitObject( OvrGuiSys & guiSys, Matrix4f const & centerViewMatrix, 
+		VRMenuRenderFlags_t const & flags, VRMenuTransformTree const & tree, int const index, 
+		int const distanceIndex, int & submissionIndex )
+{
+	submissionIndex = -1;
+
+	VRMenuObject const * obj = tree.Objects[index];
+	if ( obj->GetType() == VRMENU_CONTAINER )	// containers never render, but their children may
 	{
 		return;
 	}
 
-	Posef const & localPose = obj->GetLocalPose();
-
-	Posef curModelPose;
-	curModelPose.Position = parentModelPose.Position + ( parentModelPose.Orientation * parentScale.EntrywiseMultiply( localPose.Position ) );
-	curModelPose.Orientation = parentModelPose.Orientation * localPose.Orientation;
+	VRMenuObjectFlags_t const oFlags = obj->GetFlags();
+	VRMenuRenderFlags_t rFlags = flags;
+	if ( oFlags & VRMENUOBJECT_FLAG_POLYGON_OFFSET )
+	{
+		rFlags |= VRMENU_RENDER_POLYGON_OFFSET;
+	}
+	if ( oFlags & VRMENUOBJECT_FLAG_NO_DEPTH )
+	{
+		rFlags |= VRMENU_RENDER_NO_DEPTH;
+	}
 
-	Vector4f curColor = parentColor * obj->GetColor();
-	Vector3f const & localScale = obj->GetLocalScale();
-	Vector3f scale = parentScale.EntrywiseMultiply( localScale );
+	Posef itemPose = tree.ModelPoses[index];
+	Vector3f textPosition = tree.TextPositions[index];
+	Vector3f const & scale = tree.Scales[index];
+	if ( oFlags & VRMENUOBJECT_FLAG_BILLBOARD )
+	{
+		Matrix4f invViewMatrix = centerViewMatrix.Transposed();
+		itemPose.Orientation = Quatf( invViewMatrix );
+		textPosition = GetTextPosition( itemPose, obj->GetTextLocalPose(), scale );
+	}
 
-	OVR_ASSERT( obj != NULL );
+	if ( ShowPoses )
+	{
+		Matrix4f const poseMat( itemPose );
+		guiSys.GetDebugLines().AddLine( itemPose.Position, itemPose.Position + poseMat.GetXBasis() * 0.05f, 
+				Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), 0, false );	
+		guiSys.GetDebugLines().AddLine( itemPose.Position, itemPose.Position + poseMat.GetYBasis() * 0.05f, 
+				Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );	
+		guiSys.GetDebugLines().AddLine( itemPose.Position, itemPose.Position + poseMat.GetZBasis() * 0.05f, 
+				Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ), Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ), 0, false );	
+	}
 
-	int submissionIndex = -1;
-	VRMenuObjectFlags_t const oFlags = obj->GetFlags();
-	if ( obj->GetType() != VRMENU_CONTAINER )	// containers never render, but their children may
+	// the menu object may have zero or more renderable surfaces (if 0, it may draw only text)
+	submissionIndex = NumSubmitted;
+	Vector4f const & curColor = tree.Colors[index];
+	Array< VRMenuSurface > const & surfaces = obj->GetSurfaces();
+	for ( int i = 0; i < surfaces.GetSizeI(); ++i )
 	{
-        Posef const & hilightPose = obj->GetHilightPose();
-        Posef itemPose( curModelPose.Orientation * hilightPose.Orientation,
-                        curModelPose.Position + ( curModelPose.Orientation * parentScale.EntrywiseMultiply( hilightPose.Position ) ) );
-		Matrix4f poseMat( itemPose.Orientation );
-		Vector3f itemUp = poseMat.GetYBasis();
-		Vector3f itemNormal = poseMat.GetZBasis();
-		curModelPose = itemPose;	// so children like the slider bar caret use our hilight offset and don't end up clipping behind us!
-		VRMenuRenderFlags_t rFlags = flags;
-		if ( oFlags & VRMENUOBJECT_FLAG_POLYGON_OFFSET )
-		{
-			rFlags |= VRMENU_RENDER_POLYGON_OFFSET;
-		}
-		if ( oFlags & VRMENUOBJECT_FLAG_NO_DEPTH )
+		VRMenuSurface const & surf = surfaces[i];
+		if ( surf.IsRenderable() )
 		{
-			rFlags |= VRMENU_RENDER_NO_DEPTH;
+			SubmittedMenuObject & sub = Submitted[NumSubmitted];
+			sub.SurfaceIndex = i;
+			sub.DistanceIndex = distanceIndex >= 0 ? distanceIndex : NumSubmitted;
+			sub.Pose = itemPose;
+			sub.Scale = scale;
+			sub.Flags = rFlags;
+			sub.ColorTableOffset = obj->GetColorTableOffset();
+			sub.SkipAdditivePass = !obj->IsHilighted();
+			sub.Handle = obj->GetHandle();
+			// modulate surface color with parent's current color
+			sub.Color = surf.GetColor() * curColor;
+			sub.Offsets = surf.GetAnchorOffsets();
+			sub.FadeDirection = obj->GetFadeDirection();
+			sub.ClipUVs = surf.GetClipUVs();
+#if defined( OVR_BUILD_DEBUG )
+			sub.SurfaceName = surf.GetName();
+#endif
+			NumSubmitted++;
 		}
+	}
 
-		if ( oFlags & VRMENUOBJECT_FLAG_BILLBOARD )
+	OVR::String const & text = obj->GetText();
+	if ( ( oFlags & VRMENUOBJECT_DONT_RENDER_TEXT ) == 0 && text.GetLengthI() > 0 )
+	{
+		Vector3f textScale = scale * obj->GetTextLocalScale();
+
+		Vector4f textColor = obj->GetTextColor();
+		// Apply parent's alpha influence
+		int const parent = tree.Parents[index];
+		textColor.w *= parent >= 0 ? tree.Colors[parent].w : 1.0f;
+		VRMenuFontParms const & fp = obj->GetFontParms();
+		fontParms_t fontParms;
+		fontParms.AlignHoriz = fp.AlignHoriz;
+		fontParms.AlignVert = fp.AlignVert;
+		fontParms.Billboard = fp.Billboard;
+		fontParms.TrackRoll = fp.TrackRoll;
+		fontParms.ColorCenter = fp.ColorCenter;
+		fontParms.AlphaCenter = fp.AlphaCenter;
+
+		guiSys.GetDefaultFontSurface().DrawText3D( guiSys.GetDefaultFont(), fontParms, 
+				textPosition, tree.ItemNormals[index], tree.ItemUps[index], textScale.x * fp.Scale, textColor, text.ToCStr() );
+
+		if ( ShowDebugBounds )
 		{
-			Matrix4f invViewMatrix = centerViewMatrix.Transposed();
-			itemPose.Orientation = Quatf( invViewMatrix );
+			// this shows a ruler for the wrap width when rendering text
+			Vector3f xofs( 0.1f, 0.0f, 0.0f );
+			guiSys.GetDebugLines().AddLine( textPosition - xofs, textPosition + xofs,
+				Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );
+			Vector3f yofs( 0.0f, 0.1f, 0.0f );
+			guiSys.GetDebugLines().AddLine( textPosition - yofs, textPosition + yofs,
+				Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );
+			Vector3f zofs( 0.0f, 0.0f, 0.1f );
+			guiSys.GetDebugLines().AddLine( textPosition - zofs, textPosition + zofs,
+				Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );
 		}
+	}
+}
 
-		if ( ShowPoses )
+//==============================
+// VRMenuMgrLocal::UpdateCullBounds
+// Recomputes the cull bounds of the visited objects whose bounds, or the bounds of any of
+// whose children, changed. Children come after their parents, so walking the objects
+// backwards visits all children before their parent.
+void VRMenuMgrLocal::UpdateCullBounds( VRMenuTransformTree & tree ) const
+{
+	for ( int i = tree.Objects.GetSizeI() - 1; i >= 0; --i )
+	{
+		if ( !tree.Visited[i] || !tree.BoundsDirty[i] )
 		{
-			Matrix4f const poseMat( itemPose );
-			guiSys.GetDebugLines().AddLine( itemPose.Position, itemPose.Position + poseMat.GetXBasis() * 0.05f, 
-					Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), 0, false );	
-			guiSys.GetDebugLines().AddLine( itemPose.Position, itemPose.Position + poseMat.GetYBasis() * 0.05f, 
-					Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );	
-			guiSys.GetDebugLines().AddLine( itemPose.Position, itemPose.Position + poseMat.GetZBasis() * 0.05f, 
-					Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ), Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ), 0, false );	
+			continue;
 		}
 
-		// the menu object may have zero or more renderable surfaces (if 0, it may draw only text)
-		submissionIndex = curIndex;
-		Array< VRMenuSurface > const & surfaces = obj->GetSurfaces();
-		for ( int i = 0; i < surfaces.GetSizeI(); ++i )
+		Bounds3f cullBounds = tree.LocalBounds[i];
+		Vector3f const & scale = tree.Scales[i];
+		for ( int child = i + 1; child < tree.SubtreeEnds[i]; child = tree.SubtreeEnds[child] )
 		{
-			VRMenuSurface const & surf = surfaces[i];
-			if ( surf.IsRenderable() )
+			if ( !tree.Visited[child] )
 			{
-				SubmittedMenuObject & sub = submitted[curIndex];
-				sub.SurfaceIndex = i;
-				sub.DistanceIndex = distanceIndex >= 0 ? distanceIndex : curIndex;
-				sub.Pose = itemPose;
-				sub.Scale = scale;
-				sub.Flags = rFlags;
-				sub.ColorTableOffset = obj->GetColorTableOffset();
-				sub.SkipAdditivePass = !obj->IsHilighted();
-				sub.Handle = obj->GetHandle();
-				// modulate surface color with parent's current color
-				sub.Color = surf.GetColor() * curColor;
-				sub.Offsets = surf.GetAnchorOffsets();
-				sub.FadeDirection = obj->GetFadeDirection();
-				sub.ClipUVs = surf.GetClipUVs();
-#if defined( OVR_BUILD_DEBUG )
-				sub.SurfaceName = surf.GetName();
-#endif
-				curIndex++;
+				continue;
 			}
+			Posef pose = tree.Objects[child]->GetLocalPose();
+			pose.Position = pose.Position * scale;
+			cullBounds = Bounds3f::Union( cullBounds, Bounds3f::Transform( pose, tree.CullBounds[child] ) );
 		}
+		tree.CullBounds[i] = cullBounds;
+		tree.Objects[i]->SetCullBounds( cullBounds );
 
-		OVR::String const & text = obj->GetText();
-		if ( ( oFlags & VRMENUOBJECT_DONT_RENDER_TEXT ) == 0 && text.GetLengthI() > 0 )
+		if ( tree.Parents[i] >= 0 )
 		{
-            Posef const & textLocalPose = obj->GetTextLocalPose();
-            Posef curTextPose;
-// FIXME: this doesn't mirror the scale / rotation order for the localPose above
-//            curTextPose.Position = itemPose.Position + ( itemPose.Orientation * scale.EntrywiseMultiply( textLocalPose.Position ) );
-            curTextPose.Position = itemPose.Position + ( itemPose.Orientation * textLocalPose.Position * scale );
-            curTextPose.Orientation = textLocalPose.Orientation * itemPose.Orientation;
-            Vector3f textNormal = curTextPose.Orientation * Vector3f( 0.0f, 0.0f, 1.0f );
-			Vector3f position = curTextPose.Position + textNormal * 0.001f; // this is simply to prevent z-fighting right now
-            Vector3f textScale = scale * obj->GetTextLocalScale();
-
-            Vector4f textColor = obj->GetTextColor();
-            // Apply parent's alpha influence
-            textColor.w *= parentColor.w;
-			VRMenuFontParms const & fp = obj->GetFontParms();
-			fontParms_t fontParms;
-			fontParms.AlignHoriz = fp.AlignHoriz;
-			fontParms.AlignVert = fp.AlignVert;
-			fontParms.Billboard = fp.Billboard;
-			fontParms.TrackRoll = fp.TrackRoll;
-			fontParms.ColorCenter = fp.ColorCenter;
-			fontParms.AlphaCenter = fp.AlphaCenter;
-
-			guiSys.GetDefaultFontSurface().DrawText3D( guiSys.GetDefaultFont(), fontParms, 
-					position, itemNormal, itemUp, textScale.x * fp.Scale, textColor, text.ToCStr() );
-
-			if ( ShowDebugBounds )
-			{
-				// this shows a ruler for the wrap width when rendering text
-				Vector3f xofs( 0.1f, 0.0f, 0.0f );
-				guiSys.GetDebugLines().AddLine( position - xofs, position + xofs,
-					Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );
-				Vector3f yofs( 0.0f, 0.1f, 0.0f );
-				guiSys.GetDebugLines().AddLine( position - yofs, position + yofs,
-					Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );
-				Vector3f zofs( 0.0f, 0.0f, 0.1f );
-				guiSys.GetDebugLines().AddLine( position - zofs, position + zofs,
-					Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );
-			}
+			tree.BoundsDirty[tree.Parents[i]] = 1;
 		}
-        //LOG_WITH_TAG( "Spam", "AddPoint for '%s'", text.ToCStr() );
-		//GetDebugLines().AddPoint( curModelPose.Position, 0.05f, 1, true );
 	}
+}
 
-    cullBounds = obj->GetLocalBounds( guiSys.GetDefaultFont() ) * parentScale;
-
-	// submit all children
-    if ( obj->Children.GetSizeI() > 0 )
-    {
-		// If this object has the render hierarchy order flag, then it and all its children should
-		// be depth sorted based on this object's distance + the inverse of the submission index.
-		// (inverted because we want a higher submission index to render after a lower submission index)
-		int di = distanceIndex;
-		if ( di < 0 && ( oFlags & VRMenuObjectFlags_t( VRMENUOBJECT_RENDER_HIERARCHY_ORDER ) ) )
+//==============================
+// VRMenuMgrLocal::DrawDebug
+void VRMenuMgrLocal::DrawDebug( OvrGuiSys & guiSys, VRMenuTransformTree const & tree, Posef const & worldPose ) const
+{
+	for ( int i = 0; i < tree.Objects.GetSizeI(); ++i )
+	{
+		if ( !tree.Visited[i] )
 		{
-			di = submissionIndex;
+			continue;
 		}
-	    for ( int i = 0; i < obj->Children.GetSizeI(); ++i )
-	    {
-		    menuHandle_t childHandle = obj->Children[i];
-		    VRMenuObject const * child = static_cast< VRMenuObject const * >( ToObject( childHandle ) );
-		    if ( child == NULL )
-		    {
-			    continue;
-		    }
-
-            Bounds3f childCullBounds;
-		    SubmitForRenderingRecursive( guiSys, centerViewMatrix, flags, child, curModelPose, 
-                    curColor, scale, childCullBounds, submitted, maxIndices, curIndex, di );
-
-		    Posef pose = child->GetLocalPose();
-		    pose.Position = pose.Position * scale;
-            childCullBounds = Bounds3f::Transform( pose, childCullBounds );
-            cullBounds = Bounds3f::Union( cullBounds, childCullBounds );
-	    }
-    }
-
-    obj->SetCullBounds( cullBounds );
 
+		VRMenuObject const * obj = tree.Objects[i];
+		int const parent = tree.Parents[i];
+		Posef const & curModelPose = tree.ModelPoses[i];
+		Posef const & parentModelPose = parent >= 0 ? tree.ModelPoses[parent] : worldPose;
+		Vector3f const parentScale = parent >= 0 ? tree.Scales[parent] : Vector3f( 1.0f );
 
-	if ( ShowDebugBounds )
-	{
-		OvrCollisionPrimitive const * cp = obj->GetCollisionPrimitive();
-		if ( cp != NULL )
+		if ( ShowDebugBounds )
 		{
-			cp->DebugRender( guiSys.GetDebugLines(), curModelPose );
-		}
-		{
-			// for debug drawing, put the cull bounds in world space
-			//LogBounds( obj->GetText().ToCStr(), "Transformed CullBounds", myCullBounds );
-			guiSys.GetDebugLines().AddBounds( curModelPose, obj->GetCullBounds(), Vector4f( 0.0f, 1.0f, 1.0f, 1.0f ) );
-		}
-		{
-			Bounds3f localBounds = obj->GetLocalBounds( guiSys.GetDefaultFont() ) * parentScale;
-			//LogBounds( obj->GetText().ToCStr(), "localBounds", localBounds );
-    		guiSys.GetDebugLines().AddBounds( curModelPose, localBounds, Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ) );
-			Bounds3f textLocalBounds = obj->GetTextLocalBounds( guiSys.GetDefaultFont() );
-			Posef hilightPose = obj->GetHilightPose();
-			textLocalBounds = Bounds3f::Transform( Posef( hilightPose.Orientation, hilightPose.Position * scale ), textLocalBounds );
-    		guiSys.GetDebugLines().AddBounds( curModelPose, textLocalBounds * parentScale, Vector4f( 1.0f, 1.0f, 0.0f, 1.0f ) );
+			OvrCollisionPrimitive const * cp = obj->GetCollisionPrimitive();
+			if ( cp != NULL )
+			{
+				cp->DebugRender( guiSys.GetDebugLines(), curModelPose );
+			}
+			{
+				// for debug drawing, put the cull bounds in world space
+				//LogBounds( obj->GetText().ToCStr(), "Transformed CullBounds", myCullBounds );
+				guiSys.GetDebugLines().AddBounds( curModelPose, obj->GetCullBounds(), Vector4f( 0.0f, 1.0f, 1.0f, 1.0f ) );
+			}
+			{
+				Bounds3f const & localBounds = tree.LocalBounds[i];
+				//LogBounds( obj->GetText().ToCStr(), "localBounds", localBounds );
+				guiSys.GetDebugLines().AddBounds( curModelPose, localBounds, Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ) );
+				Bounds3f textLocalBounds = obj->GetTextLocalBounds( guiSys.GetDefaultFont() );
+				Posef hilightPose = obj->GetHilightPose();
+				textLocalBounds = Bounds3f::Transform( Posef( hilightPose.Orientation, hilightPose.Position * tree.Scales[i] ), textLocalBounds );
+				guiSys.GetDebugLines().AddBounds( curModelPose, textLocalBounds * parentScale, Vector4f( 1.0f, 1.0f, 0.0f, 1.0f ) );
+			}
 		}
-	}
 
-	// draw the hierarchy
-	if ( ShowDebugHierarchy )
-	{
-		fontParms_t fp;
-		fp.AlignHoriz = HORIZONTAL_CENTER;
-		fp.AlignVert = VERTICAL_CENTER;
-		fp.Billboard = true;
-#if 0
-		VRMenuObject const * parent = ToObject( obj->GetParentHandle() );
-		if ( parent != NULL )
-		{
-			Vector3f itemUp = curModelPose.Orientation * Vector3f( 0.0f, 1.0f, 0.0f );
-			Vector3f itemNormal = curModelPose.Orientation * Vector3f( 0.0f, 0.0f, 1.0f );
-			fontSurface.DrawTextBillboarded3D( font, fp, curModelPose.Position, itemNormal, itemUp,
-					0.5f, Vector4f( 1.0f, 0.0f, 1.0f, 1.0f ), obj->GetSurfaces()[0] ); //parent->GetText().ToCStr() );
-		}
-#endif
-		guiSys.GetDebugLines().AddLine( parentModelPose.Position, curModelPose.Position, Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ), 5, false );
-		if ( obj->GetSurfaces().GetSizeI() > 0 ) 
+		// draw the hierarchy
+		if ( ShowDebugHierarchy )
 		{
-			guiSys.GetDefaultFontSurface().DrawTextBillboarded3D( guiSys.GetDefaultFont(), fp, 
-					curModelPose.Position, 0.5f, Vector4f( 0.8f, 0.8f, 0.8f, 1.0f ), 
-					obj->GetSurfaces()[0].GetName().ToCStr() );
+			fontParms_t fp;
+			fp.AlignHoriz = HORIZONTAL_CENTER;
+			fp.AlignVert = VERTICAL_CENTER;
+			fp.Billboard = true;
+			guiSys.GetDebugLines().AddLine( parentModelPose.Position, curModelPose.Position, Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ), 5, false );
+			if ( obj->GetSurfaces().GetSizeI() > 0 ) 
+			{
+				guiSys.GetDefaultFontSurface().DrawTextBillboarded3D( guiSys.GetDefaultFont(), fp, 
+						curModelPose.Position, 0.5f, Vector4f( 0.8f, 0.8f, 0.8f, 1.0f ), 
+						obj->GetSurfaces()[0].GetName().ToCStr() );
+			}
 		}
 	}
 }
@@ -869,6 +1035,10 @@ void VRMenuMgrLocal::SubmitForRenderingRecursive( OvrGuiSys & guiSys, Matrix4f c
 //==============================
 // VRMenuMgrLocal::SubmitForRendering
 // Submits the specified menu object and it's children
+//
+// The objects are visited linearly in the flattened order of their tree. Transforms, colors
+// and bounds are only recomputed for the objects that changed and their descendants, so a
+// menu that does not change only pays for submitting its surfaces and text.
 void VRMenuMgrLocal::SubmitForRendering( OvrGuiSys & guiSys, Matrix4f const & centerViewMatrix, 
 		menuHandle_t const handle, Posef const & worldPose, VRMenuRenderFlags_t const & flags )
 {
@@ -884,15 +1054,119 @@ void VRMenuMgrLocal::SubmitForRendering( OvrGuiSys & guiSys, Matrix4f const & ce
 		return;
 	}
 
-    Bounds3f cullBounds;
-	SubmitForRenderingRecursive( guiSys, centerViewMatrix, flags, obj, worldPose, Vector4f( 1.0f ), 
-			Vector3f( 1.0f ), cullBounds, Submitted, MAX_SUBMITTED, NumSubmitted, -1 );
+	VRMenuTransformTree & tree = GetTransformTree( handle );
+	if ( !tree.Valid || tree.HierarchyChangeCount != VRMenuObject::GetHierarchyChangeCount() )
+	{
+		tree.Flatten( *this, obj );
+	}
+	bool const worldPoseChanged = !( tree.WorldPose.Orientation == worldPose.Orientation ) || 
+			!( tree.WorldPose.Position == worldPose.Position );
+	tree.WorldPose = worldPose;
+	tree.LastFrame = FrameNumber;
+
+	BitmapFont const & font = guiSys.GetDefaultFont();
+	int const numObjects = tree.Objects.GetSizeI();
+	memset( tree.Visited.GetDataPtr(), 0, numObjects * sizeof( UByte ) );
+
+	for ( int i = 0; i < numObjects; )
+	{
+		VRMenuObject const * cur = tree.Objects[i];
+		int const parent = tree.Parents[i];
+
+		// check if this object is hidden
+		if ( cur->GetFlags() & VRMENUOBJECT_DONT_RENDER )
+		{
+			if ( tree.Revisions[i] != cur->GetRevision() )
+			{
+				// the object was just hidden, so it no longer contributes to its parent's bounds
+				tree.Revisions[i] = cur->GetRevision();
+				if ( parent >= 0 )
+				{
+					tree.BoundsDirty[parent] = 1;
+				}
+			}
+			i = tree.SubtreeEnds[i];
+			continue;
+		}
+
+		if ( NumSubmitted >= MAX_SUBMITTED )
+		{
+			// If this happens we're probably not correctly clearing the submitted surfaces each frame
+			// OR we've got a LOT of surfaces.
+			LOG( "maxIndices = %i, curIndex = %i", MAX_SUBMITTED, NumSubmitted );
+			ASSERT_WITH_TAG( NumSubmitted < MAX_SUBMITTED, "VrMenu" );
+			break;
+		}
+
+		bool const update = ( parent >= 0 ? tree.Updated[parent] != 0 : worldPoseChanged ) || 
+				tree.Revisions[i] != cur->GetRevision();
+		if ( update )
+		{
+			if ( parent >= 0 )
+			{
+				tree.UpdateTransforms( font, i, tree.ModelPoses[parent], tree.Colors[parent], tree.Scales[parent] );
+			}
+			else
+			{
+				tree.UpdateTransforms( font, i, worldPose, Vector4f( 1.0f ), Vector3f( 1.0f ) );
+			}
+			NumNodesRecomputed++;
+		}
+		NumNodesVisited++;
+		tree.Visited[i] = 1;
+		tree.Updated[i] = update;
+		tree.BoundsDirty[i] = update;
+
+		int const distanceIndex = parent >= 0 ? tree.DistanceIndices[parent] : -1;
+		int submissionIndex;
+		SubmitObject( guiSys, centerViewMatrix, flags, tree, i, distanceIndex, submissionIndex );
+
+		// If this object has the render hierarchy order flag, then it and all its children should
+		// be depth sorted based on this object's distance + the inverse of the submission index.
+		// (inverted because we want a higher submission index to render after a lower submission index)
+		int di = distanceIndex;
+		if ( di < 0 && ( cur->GetFlags() & VRMenuObjectFlags_t( VRMENUOBJECT_RENDER_HIERARCHY_ORDER ) ) )
+		{
+			di = submissionIndex;
+		}
+		tree.DistanceIndices[i] = di;
+
+		i++;
+	}
+
+	UpdateCullBounds( tree );
+
+	if ( ShowDebugBounds || ShowDebugHierarchy )
+	{
+		DrawDebug( guiSys, tree, worldPose );
+	}
 }
 
 //==============================
 // VRMenuMgrLocal::Finish
 void VRMenuMgrLocal::Finish( Matrix4f const & viewMatrix )
 {
+	// free the cached transforms of menus that were not submitted on this frame
+	for ( int i = TransformTrees.GetSizeI() - 1; i >= 0; --i )
+	{
+		if ( TransformTrees[i]->LastFrame != FrameNumber )
+		{
+			delete TransformTrees[i];
+			TransformTrees.RemoveAtUnordered( i );
+		}
+	}
+	FrameNumber++;
+
+	if ( ShowStats )
+	{
+		LOG( "VRMenuMgr: %i objects visited, %i recomputed, %i surfaces submitted", 
+				NumNodesVisited, NumNodesRecomputed, NumSubmitted );
+	}
+	LastNodesVisited = NumNodesVisited;
+	LastNodesRecomputed = NumNodesRecomputed;
+	NumNodesVisited = 0;
+	NumNodesRecomputed = 0;
+
 	if ( NumSubmitted == 0 )
 	{
 		NumToRender = 0;
@@ -922,6 +1196,14 @@ void VRMenuMgrLocal::Finish( Matrix4f const & viewMatrix )
 	NumSubmitted = 0;
 }
 
+//==============================
+// VRMenuMgrLocal::GetSubmitStats
+void VRMenuMgrLocal::GetSubmitStats( int & numVisited, int & numRecomputed ) const
+{
+	numVisited = LastNodesVisited;
+	numRecomputed = LastNodesRecomputed;
+}
+
 #if 1
 //==============================
 // VRMenuMgrLocal::RenderEyeView
@@ -55,6 +55,10 @@ public:
 
 	// Call once per frame before rendering to sort surfaces.
 	virtual void				Finish( Matrix4f const & viewMatrix ) = 0;
+
+	// Returns the number of menu objects submitted on the last finished frame, and how many
+	// of them had their transforms recomputed because they or one of their parents changed.
+	virtual void				GetSubmitStats( int & numVisited, int & numRecomputed ) const = 0;
 #if 1
 	virtual void 				RenderEyeView( Matrix4f const & centerViewMatrix, 
 										Matrix4f const & viewMatrix, 
@@ -12,6 +12,8 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 
 #include "VRMenuObject.h"
 
+#include <algorithm>
+
 #include "Kernel/OVR_Geometry.h"
 #include "GlTexture.h"
 #include "App.h"			// for loading images from the assets folder
@@ -28,6 +30,8 @@ namespace OVR {
 float const	VRMenuObject::TEXELS_PER_METER		= 500.0f;
 float const	VRMenuObject::DEFAULT_TEXEL_SCALE	= 1.0f / TEXELS_PER_METER;
 
+int VRMenuObject::HierarchyChangeCount = 0;
+
 const float VRMenuSurface::Z_BOUNDS = 0.05f;
 
 // too bad this doesn't work
@@ -984,9 +988,14 @@ VRMenuObject::VRMenuObject( VRMenuObjectParms const & parms,
 	MinsBoundsExpand( 0.0f ),
 	MaxsBoundsExpand( 0.0f ),
 	TextMetrics(),
-	WrapWidth( 0.0f )
+	WrapWidth( 0.0f ),
+	Revision( 0 ),
+	HitTestIndex( NULL ),
+	HitTestEntry( -1 ),
+	HitTestDirty( false )
 {
 	CullBounds.Clear();
+	MarkChanged();
 }
 
 //==================================
@@ -1009,6 +1018,30 @@ VRMenuObject::~VRMenuObject()
 	Handle.Release();
 	ParentHandle.Release();
 	Type = VRMENU_MAX;
+	MarkHierarchyChanged();
+}
+
+//==================================
+// VRMenuObject::MarkHierarchyChanged
+void VRMenuObject::MarkHierarchyChanged()
+{
+	MarkChanged();
+	HierarchyChangeCount++;
+	if ( HitTestIndex != NULL )
+	{
+		HitTestIndex->Invalidate();
+	}
+}
+
+//==================================
+// VRMenuObject::MarkHitTestDirty
+void VRMenuObject::MarkHitTestDirty()
+{
+	if ( !HitTestDirty )
+	{
+		HitTestDirty = true;
+		HitTestIndex->Dirty.PushBack( HitTestEntry );
+	}
 }
 
 //==================================
@@ -1028,6 +1061,7 @@ void VRMenuObject::Init( OvrGuiSys & guiSys, VRMenuObjectParms const & parms )
 	{
 		AddComponent( parms.Components[i] );
 	}
+	MarkChanged();
 }
 
 //==================================
@@ -1039,6 +1073,7 @@ void VRMenuObject::FreeChildren( OvrVRMenuMgr & menuMgr )
 		menuMgr.FreeObject( Children[i] );
 	}
 	Children.Resize( 0 );
+	MarkHierarchyChanged();
 	// NOTE! bounds will be incorrect now until submitted for rendering
 }
 
@@ -1075,6 +1110,7 @@ bool VRMenuObject::IsDescendant( OvrVRMenuMgr & menuMgr, menuHandle_t const hand
 void VRMenuObject::AddChild( OvrVRMenuMgr & menuMgr, menuHandle_t const handle )
 {
 	Children.PushBack( handle );
+	MarkHierarchyChanged();
 
 	VRMenuObject * child = menuMgr.ToObject( handle );
 	if ( child != NULL )
@@ -1093,6 +1129,7 @@ void VRMenuObject::RemoveChild( OvrVRMenuMgr & menuMgr, menuHandle_t const handl
 		if ( Children[i] == handle )
 		{
 			Children.RemoveAtUnordered( i );
+			MarkHierarchyChanged();
 			return;
 		}
 	}
@@ -1108,6 +1145,7 @@ void VRMenuObject::FreeChild( OvrVRMenuMgr & menuMgr, menuHandle_t const handle
 		if ( childHandle == handle )
 		{
 			Children.RemoveAtUnordered( i );
+			MarkHierarchyChanged();
 			menuMgr.FreeObject( childHandle );
 			return;
 		}
@@ -1205,59 +1243,32 @@ bool VRMenuObject::IntersectRay( Vector3f const & localStart, Vector3f const & l
 }
 
 //==============================
-// VRMenuObject::HitTest_r
-bool VRMenuObject::HitTest_r( OvrGuiSys & guiSys, Posef const & parentPose, 
-		Vector3f const & parentScale, Vector3f const & rayStart, Vector3f const & rayDir,
-		ContentFlags_t const testContents, HitTestResult & result ) const
+// VRMenuObject::HitTestCullBounds
+bool VRMenuObject::HitTestCullBounds( Vector3f const & localStart, Vector3f const & localDir ) const
 {
-	if ( Flags & VRMENUOBJECT_DONT_RENDER )
+	if ( CullBounds.IsInverted() )
 	{
+		LOG_WITH_TAG( "Spam", "CullBounds are inverted!!" );
 		return false;
 	}
+	float cullT0;
+	float cullT1;
+	// any contents will hit cull bounds
+	ContentFlags_t allContents( ALL_BITS );
+	bool hitCullBounds = IntersectRayBounds( localStart, localDir, CullBounds.GetMins(), CullBounds.GetMaxs(), 
+								allContents, cullT0, cullT1 );
 
-	if ( Flags & VRMENUOBJECT_DONT_HIT_ALL )
-	{
-		return false;
-	}
+//    LOG_WITH_TAG( "Spam", "Cull hit = %s, t0 = %.2f t1 = %.2f", hitCullBounds ? "true" : "false", cullT0, cullT1 );
 
-	// transform ray into local space
-	Vector3f const & localScale = GetLocalScale();
-	Vector3f scale = parentScale.EntrywiseMultiply( localScale );
-	Posef modelPose;
-	modelPose.Position = parentPose.Position + ( parentPose.Orientation * parentScale.EntrywiseMultiply( LocalPose.Position ) );
-	modelPose.Orientation = LocalPose.Orientation * parentPose.Orientation;
-	Vector3f localStart = modelPose.Orientation.Inverted().Rotate( rayStart - modelPose.Position );
-	Vector3f localDir = modelPose.Orientation.Inverted().Rotate( rayDir );
-/*
-    LOG_WITH_TAG( "Spam", "Hit test vs '%s', start: (%.2f, %.2f, %.2f ) cull bounds( %.2f, %.2f, %.2f ) -> ( %.2f, %.2f, %.2f )", GetText().ToCStr(),
-            localStart.x, localStart.y, localStart.z,
-            CullBounds.b[0].x, CullBounds.b[0].y, CullBounds.b[0].z,
-            CullBounds.b[1].x, CullBounds.b[1].y, CullBounds.b[1].z );
-*/
-	// test against cull bounds if we have children  ... otherwise cullBounds == localBounds
-	if ( Children.GetSizeI() > 0 )  
-	{
-		if ( CullBounds.IsInverted() )
-		{
-			LOG_WITH_TAG( "Spam", "CullBounds are inverted!!" );
-			return false;
-		}
-		float cullT0;
-		float cullT1;
-		// any contents will hit cull bounds
-		ContentFlags_t allContents( ALL_BITS );
-		bool hitCullBounds = IntersectRayBounds( localStart, localDir, CullBounds.GetMins(), CullBounds.GetMaxs(), 
-									allContents, cullT0, cullT1 );
-
-//        LOG_WITH_TAG( "Spam", "Cull hit = %s, t0 = %.2f t1 = %.2f", hitCullBounds ? "true" : "false", cullT0, cullT1 );
-
-	    if ( !hitCullBounds )
-	    {
-		return false;
-		}
-	}
+	return hitCullBounds;
+}
 
-	// test against self first, if not a container
+//==============================
+// VRMenuObject::HitTestSelf
+bool VRMenuObject::HitTestSelf( OvrGuiSys & guiSys, Vector3f const & parentScale,
+		Vector3f const & localStart, Vector3f const & localDir,
+		ContentFlags_t const testContents, HitTestResult & result ) const
+{
 	if ( GetContents() & testContents )
 	{
 		if ( Flags & VRMENUOBJECT_BOUND_ALL )
@@ -1306,6 +1317,47 @@ bool VRMenuObject::HitTest_r( OvrGuiSys & guiSys, Posef const & parentPose,
 			}
 		}
 	}
+	return result.HitHandle.IsValid();
+}
+
+//==============================
+// VRMenuObject::HitTest_r
+bool VRMenuObject::HitTest_r( OvrGuiSys & guiSys, Posef const & parentPose, 
+		Vector3f const & parentScale, Vector3f const & rayStart, Vector3f const & rayDir,
+		ContentFlags_t const testContents, HitTestResult & result ) const
+{
+	if ( Flags & VRMENUOBJECT_DONT_RENDER )
+	{
+		return false;
+	}
+
+	if ( Flags & VRMENUOBJECT_DONT_HIT_ALL )
+	{
+		return false;
+	}
+
+	// transform ray into local space
+	Vector3f const & localScale = GetLocalScale();
+	Vector3f scale = parentScale.EntrywiseMultiply( localScale );
+	Posef modelPose;
+	modelPose.Position = parentPose.Position + ( parentPose.Orientation * parentScale.EntrywiseMultiply( LocalPose.Position ) );
+	modelPose.Orientation = LocalPose.Orientation * parentPose.Orientation;
+	Vector3f localStart = modelPose.Orientation.Inverted().Rotate( rayStart - modelPose.Position );
+	Vector3f localDir = modelPose.Orientation.Inverted().Rotate( rayDir );
+/*
+    LOG_WITH_TAG( "Spam", "Hit test vs '%s', start: (%.2f, %.2f, %.2f ) cull bounds( %.2f, %.2f, %.2f ) -> ( %.2f, %.2f, %.2f )", GetText().ToCStr(),
+            localStart.x, localStart.y, localStart.z,
+            CullBounds.b[0].x, CullBounds.b[0].y, CullBounds.b[0].z,
+            CullBounds.b[1].x, CullBounds.b[1].y, CullBounds.b[1].z );
+*/
+	// test against cull bounds if we have children  ... otherwise cullBounds == localBounds
+	if ( Children.GetSizeI() > 0 && !HitTestCullBounds( localStart, localDir ) )
+	{
+		return false;
+	}
+
+	// test against self first, if not a container
+	HitTestSelf( guiSys, parentScale, localStart, localDir, testContents, result );
 
 	// test against children
 	for ( int i = 0; i < Children.GetSizeI(); ++i )
@@ -1335,6 +1387,498 @@ menuHandle_t VRMenuObject::HitTest( OvrGuiSys & guiSys, Posef const & worldPose,
 	return result.HitHandle;
 }
 
+//======================================================================================
+// VRMenuHitTestIndex
+
+// The hit tests also hit when the ray starts within this distance of the bounds.
+static const float HIT_TEST_CONTAINS_EXPAND	= 0.1f;
+static const int MAX_HIT_TEST_STACK			= 64;
+
+//==============================
+// HitTestWorldBounds
+// Returns world space bounds that contain everything the hit tests of the entry can hit,
+// with a margin for the rounding differences of testing in world space.
+static Bounds3f HitTestWorldBounds( Bounds3f const & localBounds, Posef const & modelPose )
+{
+	Vector3f const expand( HIT_TEST_CONTAINS_EXPAND );
+	Bounds3f bounds = Bounds3f::Transform( modelPose, Bounds3f::Expand( localBounds, -expand, expand ) );
+	float maxCoord = 0.0f;
+	for ( int i = 0; i < 3; i++ )
+	{
+		maxCoord = Alg::Max( maxCoord, Alg::Max( fabsf( bounds.b[0][i] ), fabsf( bounds.b[1][i] ) ) );
+	}
+	float const margin = 0.001f + maxCoord * 0.0001f;
+	return Bounds3f::Expand( bounds, Vector3f( -margin ), Vector3f( margin ) );
+}
+
+//==============================
+// IsHitTestUnbounded
+// The ray tests against bounds with inverted axes are not well defined, so entries with such
+// bounds are kept out of the hierarchy and always tested.
+static bool IsHitTestUnbounded( Bounds3f const & localBounds )
+{
+	return localBounds.b[0].x > localBounds.b[1].x || localBounds.b[0].y > localBounds.b[1].y ||
+			localBounds.b[0].z > localBounds.b[1].z;
+}
+
+//==============================
+// SameBounds
+static bool SameBounds( Bounds3f const & a, Bounds3f const & b )
+{
+	return a.b[0] == b.b[0] && a.b[1] == b.b[1];
+}
+
+//==============================
+// RayMayHitBounds
+// Returns true if the ray, starting at rayStart, touches the bounds.
+static bool RayMayHitBounds( Vector3f const & rayStart, Vector3f const & rayDir, Bounds3f const & bounds )
+{
+	float tMin = 0.0f;
+	float tMax = FLT_MAX;
+	for ( int i = 0; i < 3; i++ )
+	{
+		if ( fabsf( rayDir[i] ) < 1e-30f )
+		{
+			if ( rayStart[i] < bounds.b[0][i] || rayStart[i] > bounds.b[1][i] )
+			{
+				return false;
+			}
+			continue;
+		}
+		float const invDir = 1.0f / rayDir[i];
+		float t0 = ( bounds.b[0][i] - rayStart[i] ) * invDir;
+		float t1 = ( bounds.b[1][i] - rayStart[i] ) * invDir;
+		if ( t0 > t1 )
+		{
+			Alg::Swap( t0, t1 );
+		}
+		tMin = Alg::Max( tMin, t0 );
+		tMax = Alg::Min( tMax, t1 );
+		if ( tMin > tMax )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//==============================
+// HitTestBoundsCompare
+struct HitTestBoundsCompare
+{
+	HitTestBoundsCompare( Array< VRMenuHitTestNode > const & leafs_, int const axis_ ) :
+		leafs( leafs_ ),
+		axis( axis_ ) {}
+
+	bool operator()( int const a, int const b ) const
+	{
+		return leafs[a].Bounds.b[0][axis] + leafs[a].Bounds.b[1][axis] < leafs[b].Bounds.b[0][axis] + leafs[b].Bounds.b[1][axis];
+	}
+
+	Array< VRMenuHitTestNode > const &	leafs;
+	int											axis;
+};
+
+//==============================
+// BuildHitTestNode
+// Builds the node at nodeIndex over a range of leafs, splitting at the median of the axis
+// with the largest spread of leaf centers.
+static void BuildHitTestNode( Array< VRMenuHitTestNode > & nodes, Array< VRMenuHitTestNode > const & leafs,
+		int * order, int const count, int const nodeIndex, int const parentIndex )
+{
+	if ( count == 1 )
+	{
+		nodes[nodeIndex] = leafs[order[0]];
+		nodes[nodeIndex].Parent = parentIndex;
+		return;
+	}
+
+	Bounds3f centers;
+	centers.Clear();
+	for ( int i = 0; i < count; i++ )
+	{
+		centers.AddPoint( leafs[order[i]].Bounds.GetCenter() );
+	}
+	Vector3f const spread = centers.GetSize();
+	int splitAxis = 0;
+	for ( int axis = 1; axis < 3; axis++ )
+	{
+		if ( spread[axis] > spread[splitAxis] )
+		{
+			splitAxis = axis;
+		}
+	}
+
+	int const half = count / 2;
+	std::nth_element( order, order + half, order + count, HitTestBoundsCompare( leafs, splitAxis ) );
+
+	int const child = nodes.GetSizeI();
+	nodes.Resize( child + 2 );
+	BuildHitTestNode( nodes, leafs, order, half, child + 0, nodeIndex );
+	BuildHitTestNode( nodes, leafs, order + half, count - half, child + 1, nodeIndex );
+
+	VRMenuHitTestNode & node = nodes[nodeIndex];
+	node.Bounds = Bounds3f::Union( nodes[child + 0].Bounds, nodes[child + 1].Bounds );
+	node.Parent = parentIndex;
+	node.Child = child;
+	node.Entry = -1;
+}
+
+//==============================
+// VRMenuHitTestIndex::VRMenuHitTestIndex
+VRMenuHitTestIndex::VRMenuHitTestIndex() :
+	Valid( false ),
+	Font( NULL )
+{
+}
+
+//==============================
+// VRMenuHitTestIndex::~VRMenuHitTestIndex
+VRMenuHitTestIndex::~VRMenuHitTestIndex()
+{
+	Invalidate();
+}
+
+//==============================
+// VRMenuHitTestIndex::Invalidate
+// An object that is freed invalidates the index first, so all entries still point at
+// live objects here.
+void VRMenuHitTestIndex::Invalidate()
+{
+	for ( int i = 0; i < Entries.GetSizeI(); i++ )
+	{
+		Entries[i].Object->HitTestIndex = NULL;
+		Entries[i].Object->HitTestEntry = -1;
+		Entries[i].Object->HitTestDirty = false;
+	}
+	Entries.Clear();
+	Nodes.Clear();
+	Unbounded.Clear();
+	Dirty.Clear();
+	Valid = false;
+}
+
+//==============================
+// VRMenuHitTestIndex::Collect
+// Adds the object and its children in the same order as HitTest_r(). Hidden objects are
+// added as well, so showing them again does not change the entries.
+void VRMenuHitTestIndex::Collect( OvrGuiSys & guiSys, VRMenuObject const * object, int const parent )
+{
+	// an object can only be in one index
+	if ( object->HitTestIndex != NULL && object->HitTestIndex != this )
+	{
+		object->HitTestIndex->Invalidate();
+	}
+
+	int const index = Entries.GetSizeI();
+	Entries.AllocBack();
+	Entries[index].Object = object;
+	Entries[index].Parent = parent;
+	Entries[index].Leaf = -1;
+	Entries[index].HasChildren = object->Children.GetSizeI() > 0;
+	object->HitTestIndex = this;
+	object->HitTestEntry = index;
+	object->HitTestDirty = false;
+
+	for ( int i = 0; i < object->Children.GetSizeI(); ++i )
+	{
+		VRMenuObject const * child = guiSys.GetVRMenuMgr().ToObject( object->Children[i] );
+		if ( child != NULL )
+		{
+			Collect( guiSys, child, index );
+		}
+	}
+	Entries[index].End = Entries.GetSizeI();
+}
+
+//==============================
+// VRMenuHitTestIndex::UpdateEntry
+// Recomputes the scale, bounds and the model pose HitTest_r() uses from the parent entry.
+void VRMenuHitTestIndex::UpdateEntry( BitmapFont const & font, int const index )
+{
+	Entry & entry = Entries[index];
+	VRMenuObject const * object = entry.Object;
+	Posef const & parentPose = ( entry.Parent >= 0 ) ? Entries[entry.Parent].ModelPose : WorldPose;
+	Posef const & localPose = object->LocalPose;
+
+	entry.ParentScale = ( entry.Parent >= 0 ) ? Entries[entry.Parent].Scale : Vector3f( 1.0f );
+	entry.Scale = entry.ParentScale.EntrywiseMultiply( object->GetLocalScale() );
+	entry.LocalBounds = object->GetLocalBounds( font ) * entry.ParentScale;
+	entry.ModelPose.Position = parentPose.Position + ( parentPose.Orientation * entry.ParentScale.EntrywiseMultiply( localPose.Position ) );
+	entry.ModelPose.Orientation = localPose.Orientation * parentPose.Orientation;
+}
+
+//==============================
+// VRMenuHitTestIndex::Update
+// Updates the dirty entries and all entries below them, or all entries if the world pose
+// changed. The entries below an entry directly follow it, so each dirty entry updates a
+// single range, and sorting the dirty entries updates parents before their children.
+// Returns false if the bounds of an entry became unbounded or bounded, which changes the
+// leafs of the hierarchy.
+bool VRMenuHitTestIndex::Update( BitmapFont const & font, bool const worldPoseChanged )
+{
+	Enabled.Resize( Entries.GetSizeI() );
+	Refits.Clear();
+
+	if ( worldPoseChanged && Entries.GetSizeI() > 0 )
+	{
+		Dirty.PushBack( 0 );
+	}
+	std::sort( Dirty.GetDataPtr(), Dirty.GetDataPtr() + Dirty.GetSizeI() );
+
+	bool leafsValid = true;
+	int updatedEnd = 0;	// one past the last entry updated so far
+	for ( int d = 0; d < Dirty.GetSizeI(); d++ )
+	{
+		int const first = Dirty[d];
+		Entries[first].Object->HitTestDirty = false;
+		if ( first < updatedEnd )
+		{
+			continue;	// already updated below a parent
+		}
+		updatedEnd = Entries[first].End;
+		for ( int i = first; i < updatedEnd; i++ )
+		{
+			Entry const & entry = Entries[i];
+			VRMenuObject const * object = entry.Object;
+			int const parent = entry.Parent;
+
+			// HitTest_r() skips hidden objects and everything below them
+			Enabled[i] = ( parent < 0 || Enabled[parent] != 0 ) &&
+					!( object->Flags & VRMENUOBJECT_DONT_RENDER ) && !( object->Flags & VRMENUOBJECT_DONT_HIT_ALL );
+
+			UpdateEntry( font, i );
+			if ( IsHitTestUnbounded( entry.LocalBounds ) != ( entry.Leaf < 0 ) )
+			{
+				leafsValid = false;
+			}
+			else if ( entry.Leaf >= 0 )
+			{
+				Refits.PushBack( i );
+			}
+		}
+	}
+	Dirty.Clear();
+	return leafsValid;
+}
+
+//==============================
+// VRMenuHitTestIndex::Build
+void VRMenuHitTestIndex::Build()
+{
+	Nodes.Clear();
+	Unbounded.Clear();
+
+	Array< VRMenuHitTestNode > leafs;
+	for ( int i = 0; i < Entries.GetSizeI(); i++ )
+	{
+		Entries[i].Leaf = -1;
+		if ( IsHitTestUnbounded( Entries[i].LocalBounds ) )
+		{
+			Unbounded.PushBack( i );
+			continue;
+		}
+		VRMenuHitTestNode & leaf = leafs[leafs.AllocBack()];
+		leaf.Bounds = HitTestWorldBounds( Entries[i].LocalBounds, Entries[i].ModelPose );
+		leaf.Parent = -1;
+		leaf.Child = -1;
+		leaf.Entry = i;
+	}
+
+	if ( leafs.GetSizeI() > 0 )
+	{
+		ArrayPOD< int > order;
+		order.Resize( leafs.GetSizeI() );
+		for ( int i = 0; i < order.GetSizeI(); i++ )
+		{
+			order[i] = i;
+		}
+		Nodes.Resize( 1 );
+		BuildHitTestNode( Nodes, leafs, order.GetDataPtr(), order.GetSizeI(), 0, -1 );
+	}
+
+	for ( int i = 0; i < Nodes.GetSizeI(); i++ )
+	{
+		if ( Nodes[i].Child == -1 )
+		{
+			Entries[Nodes[i].Entry].Leaf = i;
+		}
+	}
+}
+
+//==============================
+// VRMenuHitTestIndex::Refit
+// Refits the nodes above the leafs of the updated entries, up to the first node whose bounds
+// did not change. If most entries were updated, all nodes are refit in a single reverse pass
+// instead, since children are always after their parent node.
+void VRMenuHitTestIndex::Refit()
+{
+	if ( Refits.GetSizeI() * 4 > Entries.GetSizeI() )
+	{
+		for ( int i = Nodes.GetSizeI() - 1; i >= 0; i-- )
+		{
+			VRMenuHitTestNode & node = Nodes[i];
+			if ( node.Child == -1 )
+			{
+				node.Bounds = HitTestWorldBounds( Entries[node.Entry].LocalBounds, Entries[node.Entry].ModelPose );
+			}
+			else
+			{
+				node.Bounds = Bounds3f::Union( Nodes[node.Child + 0].Bounds, Nodes[node.Child + 1].Bounds );
+			}
+		}
+		return;
+	}
+
+	for ( int i = 0; i < Refits.GetSizeI(); i++ )
+	{
+		Entry const & entry = Entries[Refits[i]];
+		int nodeIndex = entry.Leaf;
+		Bounds3f bounds = HitTestWorldBounds( entry.LocalBounds, entry.ModelPose );
+		while ( nodeIndex >= 0 && !SameBounds( Nodes[nodeIndex].Bounds, bounds ) )
+		{
+			Nodes[nodeIndex].Bounds = bounds;
+			nodeIndex = Nodes[nodeIndex].Parent;
+			if ( nodeIndex >= 0 )
+			{
+				VRMenuHitTestNode const & node = Nodes[nodeIndex];
+				bounds = Bounds3f::Union( Nodes[node.Child + 0].Bounds, Nodes[node.Child + 1].Bounds );
+			}
+		}
+	}
+}
+
+//==============================
+// VRMenuHitTestIndex::HitsCullBounds
+// Returns true if the ray hits the cull bounds of the entry and all its ancestors, which is
+// what HitTest_r() requires before it tests an object.
+bool VRMenuHitTestIndex::HitsCullBounds( int const entryIndex, Vector3f const & rayStart, Vector3f const & rayDir )
+{
+	for ( int i = entryIndex; i >= 0; i = Entries[i].Parent )
+	{
+		Entry const & entry = Entries[i];
+		if ( !entry.HasChildren )
+		{
+			continue;
+		}
+		if ( CullResults[i] < 0 )
+		{
+			Posef const & modelPose = entry.ModelPose;
+			Vector3f localStart = modelPose.Orientation.Inverted().Rotate( rayStart - modelPose.Position );
+			Vector3f localDir = modelPose.Orientation.Inverted().Rotate( rayDir );
+			CullResults[i] = entry.Object->HitTestCullBounds( localStart, localDir ) ? 1 : 0;
+		}
+		if ( CullResults[i] == 0 )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//==============================
+// VRMenuHitTestIndex::HitTest
+menuHandle_t VRMenuHitTestIndex::HitTest( OvrGuiSys & guiSys, menuHandle_t const & rootHandle, Posef const & worldPose,
+		Vector3f const & rayStart, Vector3f const & rayDir,
+		ContentFlags_t const testContents, HitTestResult & result )
+{
+	VRMenuObject const * root = guiSys.GetVRMenuMgr().ToObject( rootHandle );
+	if ( root == NULL )
+	{
+		Invalidate();
+		return result.HitHandle;
+	}
+
+	BitmapFont const * font = &guiSys.GetDefaultFont();
+	bool const worldPoseChanged = !( WorldPose.Position == worldPose.Position ) || !( WorldPose.Orientation == worldPose.Orientation );
+	WorldPose = worldPose;
+	if ( !Valid || RootHandle != rootHandle || Font != font )
+	{
+		Invalidate();
+		Valid = true;
+		RootHandle = rootHandle;
+		Font = font;
+		Collect( guiSys, root, -1 );
+		Update( *font, true );
+		Build();
+	}
+	else if ( !Update( *font, worldPoseChanged ) )
+	{
+		Build();
+	}
+	else
+	{
+		Refit();
+	}
+
+	// find the entries the ray may hit
+	Candidates.Clear();
+	for ( int i = 0; i < Unbounded.GetSizeI(); i++ )
+	{
+		if ( Enabled[Unbounded[i]] )
+		{
+			Candidates.PushBack( Unbounded[i] );
+		}
+	}
+	int stack[MAX_HIT_TEST_STACK];
+	int stackSize = 0;
+	if ( Nodes.GetSizeI() > 0 )
+	{
+		stack[stackSize++] = 0;
+	}
+	while ( stackSize > 0 )
+	{
+		VRMenuHitTestNode const & node = Nodes[stack[--stackSize]];
+		if ( !RayMayHitBounds( rayStart, rayDir, node.Bounds ) )
+		{
+			continue;
+		}
+		if ( node.Child == -1 )
+		{
+			if ( Enabled[node.Entry] && ( Entries[node.Entry].Object->GetContents() & testContents ) )
+			{
+				Candidates.PushBack( node.Entry );
+			}
+			continue;
+		}
+		OVR_ASSERT( stackSize + 2 <= MAX_HIT_TEST_STACK );
+		stack[stackSize++] = node.Child + 1;
+		stack[stackSize++] = node.Child + 0;
+	}
+
+	// Test the candidates in the order HitTest_r() visits them. A later object only
+	// replaces the result if it is strictly closer, as in HitTest_r().
+	std::sort( Candidates.GetDataPtr(), Candidates.GetDataPtr() + Candidates.GetSizeI() );
+	CullResults.Resize( Entries.GetSizeI() );
+	memset( CullResults.GetDataPtr(), -1, CullResults.GetSize() * sizeof( SByte ) );
+	for ( int i = 0; i < Candidates.GetSizeI(); i++ )
+	{
+		int const entryIndex = Candidates[i];
+		if ( !HitsCullBounds( entryIndex, rayStart, rayDir ) )
+		{
+			continue;
+		}
+		Entry const & entry = Entries[entryIndex];
+		Posef const & modelPose = entry.ModelPose;
+		Vector3f localStart = modelPose.Orientation.Inverted().Rotate( rayStart - modelPose.Position );
+		Vector3f localDir = modelPose.Orientation.Inverted().Rotate( rayDir );
+		if ( entryIndex == 0 )
+		{
+			// the root tests against the caller's result, like HitTest_r()
+			entry.Object->HitTestSelf( guiSys, entry.ParentScale, localStart, localDir, testContents, result );
+			continue;
+		}
+		HitTestResult entryResult;
+		if ( entry.Object->HitTestSelf( guiSys, entry.ParentScale, localStart, localDir, testContents, entryResult ) &&
+				entryResult.t < result.t )
+		{
+			result = entryResult;
+		}
+	}
+
+	return result.HitHandle;
+}
+
 //==============================
 // VRMenuObject::RenderSurface
 void VRMenuObject::RenderSurface( OvrVRMenuMgr const & menuMgr, Matrix4f const & mvp, SubmittedMenuObject const & sub ) const
@@ -1594,6 +2138,7 @@ Vector4f const & VRMenuObject::GetColor() const
 void VRMenuObject::SetColor( Vector4f const & c )
 {
 	Color = c;
+	MarkChanged();
 }
 
 void VRMenuObject::SetVisible( bool visible )
@@ -1606,6 +2151,7 @@ void VRMenuObject::SetVisible( bool visible )
 	{
 		Flags |= VRMenuObjectFlags_t( VRMENUOBJECT_DONT_RENDER );
 	}
+	MarkChanged();
 }
 
 //==============================
@@ -1660,6 +2206,7 @@ void  VRMenuObject::SetSurfaceTexture( OvrGuiSys & guiSys, int const surfaceInde
 		return;
 	}
 	Surfaces[surfaceIndex].LoadTexture( guiSys, textureIndex, type, imageName );
+	MarkChanged();
 }
 
 //==============================
@@ -1673,6 +2220,7 @@ void  VRMenuObject::SetSurfaceTexture( int const surfaceIndex, int const texture
 		return;
 	}
 	Surfaces[surfaceIndex].LoadTexture( textureIndex, type, texId, width, height );
+	MarkChanged();
 }
 
 //==============================
@@ -1688,6 +2236,7 @@ void  VRMenuObject::SetSurfaceTextureTakeOwnership( int const surfaceIndex, int
 	}
 	Surfaces[ surfaceIndex ].LoadTexture( textureIndex, type, texId, width, height );
 	Surfaces[ surfaceIndex ].SetOwnership( textureIndex, true );
+	MarkChanged();
 }
 
 //==============================
@@ -1706,6 +2255,7 @@ void VRMenuObject::RegenerateSurfaceGeometry( int const surfaceIndex, const bool
 	}
 
 	Surfaces[ surfaceIndex ].RegenerateSurfaceGeometry();
+	MarkChanged();
 }
 
 //==============================
@@ -1732,6 +2282,7 @@ void VRMenuObject::SetSurfaceDims( int const surfaceIndex, Vector2f const &dims
 	}
 
 	Surfaces[ surfaceIndex ].SetDims( dims );
+	MarkChanged();
 }
 
 //==============================
@@ -1758,6 +2309,7 @@ void VRMenuObject::SetSurfaceBorder( int const surfaceIndex, Vector4f const & bo
 	}
 
 	Surfaces[ surfaceIndex ].SetBorder( border );
+	MarkChanged();
 }
 
 
@@ -1767,6 +2319,7 @@ void VRMenuObject::SetLocalBoundsExpand( Vector3f const mins, Vector3f const & m
 {
 	MinsBoundsExpand = mins;
 	MaxsBoundsExpand = maxs;
+	MarkChanged();
 }
 
 //==============================
@@ -1778,6 +2331,7 @@ void VRMenuObject::SetCollisionPrimitive( OvrCollisionPrimitive * c )
 		delete CollisionPrimitive;
 	}
 	CollisionPrimitive = c;
+	MarkChanged();
 }
 
 //==============================
@@ -1847,6 +2401,7 @@ void VRMenuObject::SetSurfaceVisible( int const surfaceIndex, bool const v )
 {
 	VRMenuSurface & surf = Surfaces[surfaceIndex];
 	surf.SetVisible( v );
+	MarkChanged();
 }
 
 //==============================
@@ -1868,6 +2423,7 @@ int VRMenuObject::NumSurfaces() const
 // VRMenuObject::AllocSurface
 int VRMenuObject::AllocSurface()
 {
+	MarkChanged();
 	return Surfaces.AllocBack();
 }
 
@@ -1878,6 +2434,7 @@ void VRMenuObject::CreateFromSurfaceParms( OvrGuiSys & guiSys, int const surface
 {
 	VRMenuSurface & surf = Surfaces[surfaceIndex];
 	surf.CreateFromSurfaceParms( guiSys, parms );
+	MarkChanged();
 }
 
 //==============================
@@ -1887,6 +2444,7 @@ void VRMenuObject::SetTextWordWrapped( char const * text, BitmapFont const & fon
 	SetText( text );
 	font.WordWrapText( Text, widthInMeters, FontParms.Scale );
 	WrapWidth = widthInMeters;
+	MarkChanged();
 }
 
 } // namespace OVR
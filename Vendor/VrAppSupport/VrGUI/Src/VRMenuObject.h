@@ -123,6 +123,7 @@ class VRMenuComponent_OnSubmitForRendering;
 class VRMenuComponent_OnRender;
 class VRMenuComponent_OnTouchRelative;
 class BitmapFont;
+class VRMenuHitTestIndex;
 struct fontParms_t;
 
 // border indices
@@ -722,6 +723,7 @@ class VRMenuObject
 public:
 	friend class VRMenuMgr;
 	friend class VRMenuMgrLocal;
+	friend class VRMenuHitTestIndex;
 
 	static float const	TEXELS_PER_METER;
 	static float const	DEFAULT_TEXEL_SCALE;
@@ -793,12 +795,12 @@ public:
 	void				SetParentHandle( menuHandle_t const h ) { ParentHandle = h; }
 
 	VRMenuObjectFlags_t const &	GetFlags() const { return Flags; }
-	void				SetFlags( VRMenuObjectFlags_t const & flags ) { Flags = flags; }
-	void				AddFlags( VRMenuObjectFlags_t const & flags ) { Flags |= flags; }
-	void				RemoveFlags( VRMenuObjectFlags_t const & flags ) { Flags &= ~flags; }
+	void				SetFlags( VRMenuObjectFlags_t const & flags ) { Flags = flags; MarkChanged(); }
+	void				AddFlags( VRMenuObjectFlags_t const & flags ) { Flags |= flags; MarkChanged(); }
+	void				RemoveFlags( VRMenuObjectFlags_t const & flags ) { Flags &= ~flags; MarkChanged(); }
 
 	OVR::String const &	GetText() const { return Text; }
-	void				SetText( char const * text ) { Text = text; TextDirty = true; }
+	void				SetText( char const * text ) { Text = text; TextDirty = true; MarkChanged(); }
 	void				SetTextWordWrapped( char const * text, class BitmapFont const & font, float const widthInMeters );
 
 	bool				IsHilighted() const { return Hilighted; }
@@ -809,27 +811,27 @@ public:
 	menuHandle_t		GetChildHandleForIndex( int const index ) const { return Children[index]; }
 
 	Posef const &		GetLocalPose() const { return LocalPose; }
-	void				SetLocalPose( Posef const & pose ) { LocalPose = pose; }
+	void				SetLocalPose( Posef const & pose ) { LocalPose = pose; MarkChanged(); }
 	Vector3f const &	GetLocalPosition() const { return LocalPose.Position; }
-	void				SetLocalPosition( Vector3f const & pos ) { LocalPose.Position = pos; }
+	void				SetLocalPosition( Vector3f const & pos ) { LocalPose.Position = pos; MarkChanged(); }
 	Quatf const &		GetLocalRotation() const { return LocalPose.Orientation; }
-	void				SetLocalRotation( Quatf const & rot ) { LocalPose.Orientation = rot; }
+	void				SetLocalRotation( Quatf const & rot ) { LocalPose.Orientation = rot; MarkChanged(); }
 	Vector3f            GetLocalScale() const;
-	void				SetLocalScale( Vector3f const & scale ) { LocalScale = scale; }
+	void				SetLocalScale( Vector3f const & scale ) { LocalScale = scale; MarkChanged(); }
 
     Posef const &       GetHilightPose() const { return HilightPose; }
-    void                SetHilightPose( Posef const & pose ) { HilightPose = pose; }
+    void                SetHilightPose( Posef const & pose ) { HilightPose = pose; MarkChanged(); }
     float               GetHilightScale() const { return HilightScale; }
-    void                SetHilightScale( float const s ) { HilightScale = s; }
+    void                SetHilightScale( float const s ) { HilightScale = s; MarkChanged(); }
 
-    void                SetTextLocalPose( Posef const & pose ) { TextLocalPose = pose; }
+    void                SetTextLocalPose( Posef const & pose ) { TextLocalPose = pose; MarkChanged(); }
     Posef const &       GetTextLocalPose() const { return TextLocalPose; }
-    void                SetTextLocalPosition( Vector3f const & pos ) { TextLocalPose.Position = pos; }
+    void                SetTextLocalPosition( Vector3f const & pos ) { TextLocalPose.Position = pos; MarkChanged(); }
     Vector3f const &    GetTextLocalPosition() const { return TextLocalPose.Position; }
-    void                SetTextLocalRotation( Quatf const & rot ) { TextLocalPose.Orientation = rot; }
+    void                SetTextLocalRotation( Quatf const & rot ) { TextLocalPose.Orientation = rot; MarkChanged(); }
     Quatf const &       GetTextLocalRotation() const { return TextLocalPose.Orientation; }
     Vector3f            GetTextLocalScale() const;
-    void                SetTextLocalScale( Vector3f const & scale ) { TextLocalScale = scale; }
+    void                SetTextLocalScale( Vector3f const & scale ) { TextLocalScale = scale; MarkChanged(); }
 
 	void				SetLocalBoundsExpand( Vector3f const mins, Vector3f const & maxs );
 
@@ -851,7 +853,7 @@ public:
 	VRMenuId_t			GetId() const { return Id; }
 	menuHandle_t		ChildHandleForId( OvrVRMenuMgr & menuMgr, VRMenuId_t const id ) const;
 
-	void				SetFontParms( VRMenuFontParms const & fontParms ) { FontParms = fontParms; }
+	void				SetFontParms( VRMenuFontParms const & fontParms ) { FontParms = fontParms; MarkChanged(); }
 	VRMenuFontParms const & GetFontParms() const { return FontParms; }
 
 	Vector3f const &	GetFadeDirection() const { return FadeDirection;  }
@@ -904,11 +906,17 @@ public:
 	// surfaces (non-virtual)
 	//--------------------------------------------------------------
 	VRMenuSurface const &			GetSurface( int const s ) const { return Surfaces[s]; }
-	VRMenuSurface &					GetSurface( int const s ) { return Surfaces[s]; }
+	VRMenuSurface &					GetSurface( int const s ) { MarkChanged(); return Surfaces[s]; }
 	Array< VRMenuSurface > const &	GetSurfaces() const { return Surfaces; }
 
 	float							GetWrapWidth() const { return WrapWidth; }
 
+	// Incremented whenever an object is freed or children are added or removed.
+	static int						GetHierarchyChangeCount() { return HierarchyChangeCount; }
+	// Incremented whenever this object is changed in a way that can change its submitted
+	// transforms, color or bounds, or whether it can be hit.
+	int								GetRevision() const { return Revision; }
+
 	void							BuildDrawSurface( OvrVRMenuMgr const & menuMgr,
 											Matrix4f const & modelMatrix, 
 											Matrix4f const & viewMatrix,
@@ -960,7 +968,20 @@ private:
 
 	float						WrapWidth;
 
+	int							Revision;
+
+	static int					HierarchyChangeCount;
+
+	// the hit test index that has an entry for this object, which is told about changes
+	mutable VRMenuHitTestIndex *	HitTestIndex;
+	mutable int						HitTestEntry;
+	mutable bool					HitTestDirty;	// true if the entry is in the index's dirty list
+
 private:
+	void						MarkChanged() { Revision++; if ( HitTestIndex != NULL ) { MarkHitTestDirty(); } }
+	void						MarkHierarchyChanged();
+	void						MarkHitTestDirty();
+
 	// only VRMenuMgrLocal static methods can construct and destruct a menu object.
 	VRMenuObject( VRMenuObjectParms const & parms, menuHandle_t const handle );
 	~VRMenuObject();
@@ -980,9 +1001,100 @@ private:
                                         Vector3f const & rayStart, Vector3f const & rayDir,  ContentFlags_t const testContents, 
                                         HitTestResult & result ) const;
 
+	// Returns false if the ray (in the object's local space) misses the cull bounds, in which case
+	// none of the children can be hit.
+	bool						HitTestCullBounds( Vector3f const & localStart, Vector3f const & localDir ) const;
+
+	// Tests the ray (in the object's local space) against this object only.
+	bool						HitTestSelf( OvrGuiSys & guiSys, Vector3f const & parentScale,
+										Vector3f const & localStart, Vector3f const & localDir,
+										ContentFlags_t const testContents, HitTestResult & result ) const;
+
 	int							GetComponentIndex( VRMenuComponent * component ) const;
 };
 
+//==============================================================
+// VRMenuHitTestNode
+// Node of the bounding volume hierarchy of a VRMenuHitTestIndex.
+struct VRMenuHitTestNode
+{
+	Bounds3f	Bounds;		// world space bounds
+	int			Parent;		// index of the parent node, or -1 for the root
+	int			Child;		// index of the first child (+1 = second child), or -1 for a leaf
+	int			Entry;		// index of the entry of a leaf
+};
+
+//==============================================================
+// VRMenuHitTestIndex
+// Bounding volume hierarchy over the world space bounds of the objects in a menu tree.
+// HitTest() returns exactly the same result as VRMenuObject::HitTest(), but only runs
+// the ray tests for the objects whose bounds the ray may touch.
+//
+// Each collected object points back at the index. The setters of an object add its entry
+// to the dirty list, so a hit test only updates the dirty entries and the entries below
+// them, and only refits the nodes above their leafs. Adding, removing or freeing an object
+// in the tree invalidates the index, and the objects are collected again on the next hit
+// test.
+class VRMenuHitTestIndex
+{
+public:
+	friend class VRMenuObject;
+
+						VRMenuHitTestIndex();
+						~VRMenuHitTestIndex();
+
+	menuHandle_t		HitTest( OvrGuiSys & guiSys, menuHandle_t const & rootHandle, Posef const & worldPose,
+								Vector3f const & rayStart, Vector3f const & rayDir,
+								ContentFlags_t const testContents, HitTestResult & result );
+
+	// Forces the objects to be collected again on the next hit test.
+	void				Invalidate();
+
+	int					GetNumObjects() const { return Entries.GetSizeI(); }
+
+private:
+	struct Entry
+	{
+		VRMenuObject const *	Object;
+		int						Parent;			// index of the parent entry, or -1 for the root
+		int						Leaf;			// index of the leaf node, or -1 if the entry is unbounded
+		int						End;			// one past the last entry below this one
+		bool					HasChildren;	// if true, the cull bounds must be hit to hit this object
+		Vector3f				ParentScale;
+		Vector3f				Scale;
+		Bounds3f				LocalBounds;	// bounds of the object's hit tests in its own space
+		Posef					ModelPose;		// the pose HitTest_r() uses for the object
+	};
+
+	// the per hit test arrays keep their memory
+	typedef ArrayConstPolicy< 0, 16, true > NeverShrinkPolicy;
+
+	Array< Entry >				Entries;		// objects in the order HitTest_r() visits them
+	Array< VRMenuHitTestNode >	Nodes;
+	ArrayPOD< int >				Unbounded;		// entries with inverted bounds, which are always tested
+	ArrayPOD< int, NeverShrinkPolicy >		Candidates;
+	ArrayPOD< SByte, NeverShrinkPolicy >	CullResults;	// per entry: -1 = not tested, 0 = missed, 1 = hit
+	ArrayPOD< UByte, NeverShrinkPolicy >	Enabled;		// per entry: 1 if neither it nor a parent is hidden or ignores hits
+	ArrayPOD< int, NeverShrinkPolicy >		Dirty;			// entries whose object changed since the last hit test
+	ArrayPOD< int, NeverShrinkPolicy >		Refits;			// bounded entries updated for the current hit test
+
+	bool						Valid;
+	menuHandle_t				RootHandle;
+	BitmapFont const *			Font;
+	Posef						WorldPose;
+
+	void				Collect( OvrGuiSys & guiSys, VRMenuObject const * object, int const parent );
+	void				UpdateEntry( BitmapFont const & font, int const index );
+	bool				Update( BitmapFont const & font, bool const worldPoseChanged );
+	void				Build();
+	void				Refit();
+	bool				HitsCullBounds( int const entryIndex, Vector3f const & rayStart, Vector3f const & rayDir );
+
+	// not copyable, the objects point back at the index
+						VRMenuHitTestIndex( VRMenuHitTestIndex const & );
+	VRMenuHitTestIndex &	operator = ( VRMenuHitTestIndex const & );
+};
+
 } // namespace OVR
 
 #endif // OVR_VRMenuObject_h
@@ -15,6 +15,7 @@ LOCAL_ARM_MODE  := arm				# full speed arm instead of thumb
 LOCAL_ARM_NEON  := true				# compile with neon support enabled
 
 include $(LOCAL_PATH)/../../../../../cflags.mk
+LOCAL_CFLAGS	+= -ffp-contract=off	# ModelTrace::TraceBatch has to match ModelTrace::Trace bit for bit
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../../Src
 
@@ -22,7 +23,9 @@ LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/../../../Src
 
 LOCAL_SRC_FILES := 	../../../Src/ModelFile.cpp \
 					../../../Src/ModelCollision.cpp \
+					../../../Src/ModelCull.cpp \
 					../../../Src/ModelTrace.cpp \
+					../../../Src/ModelZip.cpp \
 					../../../Src/ModelRender.cpp \
 					../../../Src/SceneView.cpp
 
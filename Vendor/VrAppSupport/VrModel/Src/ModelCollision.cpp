@@ -12,10 +12,13 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "ModelCollision.h"
 
 #include <math.h>
+#include <float.h>
+#include <algorithm>
 
 #include "Kernel/OVR_Alg.h"
 #include "Kernel/OVR_Array.h"
 #include "Kernel/OVR_String.h"
+#include "Kernel/OVR_LogUtils.h"
 
 namespace OVR {
 
@@ -120,11 +123,237 @@ bool CollisionPolytope::PopOut( Vector3f & p ) const
 //	ModelCollision
 //-----------------------------------------------------------------------------
 
-bool ModelCollision::TestPoint( const Vector3f & p ) const
+/*
+
+	The bounding volume hierarchy only uses the axial planes of the polytopes. A polytope
+	is not touched by a point or segment when the point or both end points of the segment
+	are outside any one of its planes, and the axial planes of a node are never tighter
+	than those of the polytopes below it. Bounds derived from the polytope vertices cannot
+	be used, because CollisionPolytope::TestRay() also reports segments that pass a polytope
+	without any of its planes separating the end points.
+
+	The clipped segments in TestRay() are always contained in the original segment, so the
+	polytopes found for the original segment are tested in the same order as before.
+
+*/
+
+static const int MAX_COLLISION_CANDIDATES	= 256;
+static const int MAX_COLLISION_STACK		= 64;
+
+// Returns true if both points are outside the same axial plane.
+static bool OutsideAxialPlanes( const float * sides, const Vector3f & a, const Vector3f & b )
+{
+	return	(  a.x + sides[0] > 0.0f &&  b.x + sides[0] > 0.0f ) ||
+			( -a.x + sides[1] > 0.0f && -b.x + sides[1] > 0.0f ) ||
+			(  a.y + sides[2] > 0.0f &&  b.y + sides[2] > 0.0f ) ||
+			( -a.y + sides[3] > 0.0f && -b.y + sides[3] > 0.0f ) ||
+			(  a.z + sides[4] > 0.0f &&  b.z + sides[4] > 0.0f ) ||
+			( -a.z + sides[5] > 0.0f && -b.z + sides[5] > 0.0f );
+}
+
+static bool IsFinite( const Vector3f & v )
+{
+	// infinity and NaN times zero are NaN
+	return ( v.x * 0.0f == 0.0f && v.y * 0.0f == 0.0f && v.z * 0.0f == 0.0f );
+}
+
+static float AxialCenter( const CollisionNode & node, const int axis )
+{
+	return ( node.Sides[axis * 2 + 1] - node.Sides[axis * 2 + 0] ) * 0.5f;
+}
+
+struct CollisionBoundsCompare
+{
+	CollisionBoundsCompare( const Array< CollisionNode > & leafs_, const int axis_ ) :
+		leafs( leafs_ ),
+		axis( axis_ ) {}
+
+	bool operator()( const int a, const int b ) const
+	{
+		return AxialCenter( leafs[a], axis ) < AxialCenter( leafs[b], axis );
+	}
+
+	const Array< CollisionNode > &	leafs;
+	int								axis;
+};
+
+// Builds the node at nodeIndex over a range of leafs, splitting at the median of the axis
+// with the largest spread of leaf centers.
+static void BuildCollisionNode( Array< CollisionNode > & nodes, const Array< CollisionNode > & leafs,
+								int * order, const int count, const int nodeIndex )
+{
+	if ( count == 1 )
+	{
+		nodes[nodeIndex] = leafs[order[0]];
+		return;
+	}
+
+	float mins[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxs[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for ( int i = 0; i < count; i++ )
+	{
+		for ( int axis = 0; axis < 3; axis++ )
+		{
+			const float center = AxialCenter( leafs[order[i]], axis );
+			mins[axis] = Alg::Min( mins[axis], center );
+			maxs[axis] = Alg::Max( maxs[axis], center );
+		}
+	}
+	int splitAxis = 0;
+	for ( int axis = 1; axis < 3; axis++ )
+	{
+		if ( maxs[axis] - mins[axis] > maxs[splitAxis] - mins[splitAxis] )
+		{
+			splitAxis = axis;
+		}
+	}
+
+	const int half = count / 2;
+	std::nth_element( order, order + half, order + count, CollisionBoundsCompare( leafs, splitAxis ) );
+
+	const int child = nodes.GetSizeI();
+	nodes.Resize( child + 2 );
+	BuildCollisionNode( nodes, leafs, order, half, child + 0 );
+	BuildCollisionNode( nodes, leafs, order + half, count - half, child + 1 );
+
+	// A smaller distance is a looser plane for both plane orientations.
+	CollisionNode & node = nodes[nodeIndex];
+	for ( int i = 0; i < 6; i++ )
+	{
+		node.Sides[i] = Alg::Min( nodes[child + 0].Sides[i], nodes[child + 1].Sides[i] );
+	}
+	node.Child = child;
+	node.Polytope = -1;
+}
+
+void ModelCollision::Build()
 {
+	Nodes.Clear();
+	Unbounded.Clear();
+	NumBuiltPolytopes = Polytopes.GetSizeI();
+
+	// Use the tightest axial planes of each polytope as its bounds.
+	Array< CollisionNode > leafs;
 	for ( int i = 0; i < Polytopes.GetSizeI(); i++ )
 	{
-		if ( Polytopes[i].TestPoint( p ) )
+		CollisionNode leaf;
+		for ( int j = 0; j < 6; j++ )
+		{
+			leaf.Sides[j] = -FLT_MAX;
+		}
+		leaf.Child = -1;
+		leaf.Polytope = i;
+
+		const Array< Planef > & planes = Polytopes[i].Planes;
+		for ( int j = 0; j < planes.GetSizeI(); j++ )
+		{
+			const Vector3f & n = planes[j].N;
+			const int axis = ( n.x != 0.0f ) + ( n.y != 0.0f ) * 2 + ( n.z != 0.0f ) * 4;
+			if ( axis != 1 && axis != 2 && axis != 4 )
+			{
+				continue;
+			}
+			const float component = n[axis >> 1];
+			if ( component != 1.0f && component != -1.0f )
+			{
+				continue;
+			}
+			const int side = ( axis >> 1 ) * 2 + ( component < 0.0f );
+			leaf.Sides[side] = Alg::Max( leaf.Sides[side], planes[j].D );
+		}
+
+		bool bounded = true;
+		for ( int j = 0; j < 6; j++ )
+		{
+			bounded &= ( leaf.Sides[j] != -FLT_MAX );
+		}
+		if ( bounded )
+		{
+			leafs.PushBack( leaf );
+		}
+		else
+		{
+			Unbounded.PushBack( i );
+		}
+	}
+
+	if ( leafs.GetSizeI() > 0 )
+	{
+		Array< int > order;
+		order.Resize( leafs.GetSizeI() );
+		for ( int i = 0; i < order.GetSizeI(); i++ )
+		{
+			order[i] = i;
+		}
+		Nodes.Resize( 1 );
+		BuildCollisionNode( Nodes, leafs, order.GetDataPtr(), order.GetSizeI(), 0 );
+	}
+
+	LOG( "ModelCollision::Build - %d polytopes, %d nodes, %d unbounded",
+			Polytopes.GetSizeI(), Nodes.GetSizeI(), Unbounded.GetSizeI() );
+}
+
+int ModelCollision::FindPolytopes( const Vector3f & start, const Vector3f & end, int * polytopes, const int maxPolytopes ) const
+{
+	if ( NumBuiltPolytopes != Polytopes.GetSizeI() || Polytopes.GetSizeI() == 0 )
+	{
+		return -1;
+	}
+	if ( !IsFinite( start ) || !IsFinite( end ) || Unbounded.GetSizeI() > maxPolytopes )
+	{
+		return -1;
+	}
+
+	int numPolytopes = 0;
+	for ( int i = 0; i < Unbounded.GetSizeI(); i++ )
+	{
+		polytopes[numPolytopes++] = Unbounded[i];
+	}
+
+	int stack[MAX_COLLISION_STACK];
+	int stackSize = 0;
+	if ( Nodes.GetSizeI() > 0 )
+	{
+		stack[stackSize++] = 0;
+	}
+	while ( stackSize > 0 )
+	{
+		const CollisionNode & node = Nodes[stack[--stackSize]];
+		if ( OutsideAxialPlanes( node.Sides, start, end ) )
+		{
+			continue;
+		}
+		if ( node.Child == -1 )
+		{
+			if ( numPolytopes >= maxPolytopes )
+			{
+				return -1;
+			}
+			polytopes[numPolytopes++] = node.Polytope;
+			continue;
+		}
+		if ( stackSize + 2 > MAX_COLLISION_STACK )
+		{
+			return -1;
+		}
+		stack[stackSize++] = node.Child + 1;
+		stack[stackSize++] = node.Child + 0;
+	}
+
+	std::sort( polytopes, polytopes + numPolytopes );
+	return numPolytopes;
+}
+
+bool ModelCollision::TestPoint( const Vector3f & p ) const
+{
+	int candidates[MAX_COLLISION_CANDIDATES];
+	const int numCandidates = FindPolytopes( p, p, candidates, MAX_COLLISION_CANDIDATES );
+	const int count = ( numCandidates >= 0 ) ? numCandidates : Polytopes.GetSizeI();
+
+	for ( int i = 0; i < count; i++ )
+	{
+		const int index = ( numCandidates >= 0 ) ? candidates[i] : i;
+		if ( Polytopes[index].TestPoint( p ) )
 		{
 			return true;
 		}
@@ -134,12 +363,18 @@ bool ModelCollision::TestPoint( const Vector3f & p ) const
 
 bool ModelCollision::TestRay( const Vector3f & start, const Vector3f & dir, float & length, Planef * plane ) const
 {
+	int candidates[MAX_COLLISION_CANDIDATES];
+	const int numCandidates = ( length >= 0.0f ) ?
+								FindPolytopes( start, start + dir * length, candidates, MAX_COLLISION_CANDIDATES ) : -1;
+	const int count = ( numCandidates >= 0 ) ? numCandidates : Polytopes.GetSizeI();
+
 	bool clipped = false;
-	for ( int i = 0; i < Polytopes.GetSizeI(); i++ )
+	for ( int i = 0; i < count; i++ )
 	{
+		const int index = ( numCandidates >= 0 ) ? candidates[i] : i;
 		Planef clipPlane;
 		float clipLength = length;
-		if ( Polytopes[i].TestRay( start, dir, clipLength, &clipPlane ) )
+		if ( Polytopes[index].TestRay( start, dir, clipLength, &clipPlane ) )
 		{
 			if ( clipLength < length )
 			{
@@ -157,9 +392,14 @@ bool ModelCollision::TestRay( const Vector3f & start, const Vector3f & dir, floa
 
 bool ModelCollision::PopOut( Vector3f & p ) const
 {
-	for ( int i = 0; i < Polytopes.GetSizeI(); i++ )
+	int candidates[MAX_COLLISION_CANDIDATES];
+	const int numCandidates = FindPolytopes( p, p, candidates, MAX_COLLISION_CANDIDATES );
+	const int count = ( numCandidates >= 0 ) ? numCandidates : Polytopes.GetSizeI();
+
+	for ( int i = 0; i < count; i++ )
 	{
-		if ( Polytopes[i].PopOut( p ) )
+		const int index = ( numCandidates >= 0 ) ? candidates[i] : i;
+		if ( Polytopes[index].PopOut( p ) )
 		{
 			return true;
 		}
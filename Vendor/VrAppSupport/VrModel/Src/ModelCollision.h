@@ -40,9 +40,26 @@ public:
 	Array< Planef > Planes;
 };
 
+// Node of the bounding volume hierarchy over the polytopes of a ModelCollision.
+// The bounds are stored as the distances of the six axial planes so they can be
+// tested in exactly the same way as the planes of the polytopes.
+struct CollisionNode
+{
+	float	Sides[6];	// D of the +X, -X, +Y, -Y, +Z and -Z axial planes
+	int		Child;		// index of the first child (+1 = second child), or -1 for a leaf
+	int		Polytope;	// index of the polytope of a leaf
+};
+
 class ModelCollision
 {
 public:
+			ModelCollision() : NumBuiltPolytopes( 0 ) {}
+
+	// Builds the bounding volume hierarchy over the polytopes. The hierarchy only
+	// prunes polytopes that would not be hit, so all tests return exactly the same
+	// results as without it. Must be called again after the polytopes are changed.
+	void	Build();
+
 	// Returns true if the given point is inside solid.
 	bool	TestPoint( const Vector3f & p ) const;
 
@@ -54,8 +71,18 @@ public:
 	// Pops the given point out of any collision geometry the point may be inside of.
 	bool	PopOut( Vector3f & p ) const;
 
+private:
+	// Finds the polytopes that may be touched by a segment, in increasing order.
+	// Returns -1 if all polytopes need to be tested.
+	int		FindPolytopes( const Vector3f & start, const Vector3f & end, int * polytopes, const int maxPolytopes ) const;
+
 public:
 	Array< CollisionPolytope > Polytopes;
+
+private:
+	Array< CollisionNode >	Nodes;
+	Array< int >			Unbounded;	// polytopes without six axial planes, which are always tested
+	int						NumBuiltPolytopes;
 };
 
 Vector3f SlideMove(
@@ -0,0 +1,274 @@
+/************************************************************************************
+
+Filename    :   ModelCull.cpp
+Content     :   Batched culling and sorting of model surfaces
+Created     :   August 9, 2013
+Authors     :   John Carmack
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+************************************************************************************/
+
+#include "ModelCull.h"
+
+#include <string.h>
+#include "Kernel/OVR_Alg.h"
+
+#if defined( OVR_CPU_SSE )
+#include <xmmintrin.h>
+#elif defined( OVR_CPU_ARM_NEON )
+#include <arm_neon.h>
+#endif
+
+namespace OVR
+{
+
+void SetCullBatchSurface( ModelCullBatch & batch, const int lane, const Bounds3f & bounds, const Matrix4f & mvp )
+{
+	for ( int i = 0; i < 4; i++ )
+	{
+		for ( int j = 0; j < 4; j++ )
+		{
+			batch.mvp[i][j][lane] = mvp.M[i][j];
+		}
+	}
+	batch.mins[0][lane] = bounds.b[0].x;
+	batch.mins[1][lane] = bounds.b[0].y;
+	batch.mins[2][lane] = bounds.b[0].z;
+	batch.maxs[0][lane] = bounds.b[1].x;
+	batch.maxs[1][lane] = bounds.b[1].y;
+	batch.maxs[2][lane] = bounds.b[1].z;
+}
+
+#if defined( OVR_CPU_SSE )
+
+void BoundsSortCullKeys( const ModelCullBatch & batch, float * keys )
+{
+	__m128 m[4][4];
+	for ( int i = 0; i < 4; i++ )
+	{
+		for ( int j = 0; j < 4; j++ )
+		{
+			m[i][j] = _mm_loadu_ps( batch.mvp[i][j] );
+		}
+	}
+	__m128 mins[3];
+	__m128 maxs[3];
+	for ( int i = 0; i < 3; i++ )
+	{
+		mins[i] = _mm_loadu_ps( batch.mins[i] );
+		maxs[i] = _mm_loadu_ps( batch.maxs[i] );
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	// A plane culls a bounds only if no corner is on the inside of it.
+	__m128 inside[6] = { zero, zero, zero, zero, zero, zero };
+	__m128 maxW = zero;
+
+	for ( int i = 0; i < 8; i++ )
+	{
+		const __m128 x = ( i & 1 ) ? maxs[0] : mins[0];
+		const __m128 y = ( i & 2 ) ? maxs[1] : mins[1];
+		const __m128 z = ( i & 4 ) ? maxs[2] : mins[2];
+
+		__m128 c[4];
+		for ( int r = 0; r < 4; r++ )
+		{
+			c[r] = _mm_add_ps( _mm_add_ps( _mm_add_ps(
+						_mm_mul_ps( m[r][0], x ),
+						_mm_mul_ps( m[r][1], y ) ),
+						_mm_mul_ps( m[r][2], z ) ),
+						m[r][3] );
+		}
+		const __m128 negW = _mm_sub_ps( zero, c[3] );
+
+		inside[0] = _mm_or_ps( inside[0], _mm_cmpgt_ps( c[0], negW ) );
+		inside[1] = _mm_or_ps( inside[1], _mm_cmplt_ps( c[0], c[3] ) );
+		inside[2] = _mm_or_ps( inside[2], _mm_cmpgt_ps( c[1], negW ) );
+		inside[3] = _mm_or_ps( inside[3], _mm_cmplt_ps( c[1], c[3] ) );
+		inside[4] = _mm_or_ps( inside[4], _mm_cmpgt_ps( c[2], negW ) );
+		inside[5] = _mm_or_ps( inside[5], _mm_cmplt_ps( c[2], c[3] ) );
+
+		// calculate the farthest W point for front to back sorting
+		maxW = _mm_max_ps( maxW, c[3] );
+	}
+
+	const __m128 empty = _mm_and_ps( _mm_cmpeq_ps( maxs[0], mins[0] ), _mm_cmpeq_ps( maxs[1], mins[1] ) );
+
+	__m128 visible = _mm_and_ps( _mm_and_ps( inside[0], inside[1] ), _mm_and_ps( inside[2], inside[3] ) );
+	visible = _mm_and_ps( visible, _mm_and_ps( inside[4], inside[5] ) );
+	visible = _mm_andnot_ps( empty, visible );
+
+	_mm_storeu_ps( keys, _mm_and_ps( visible, maxW ) );
+}
+
+#elif defined( OVR_CPU_ARM_NEON )
+
+void BoundsSortCullKeys( const ModelCullBatch & batch, float * keys )
+{
+	float32x4_t m[4][4];
+	for ( int i = 0; i < 4; i++ )
+	{
+		for ( int j = 0; j < 4; j++ )
+		{
+			m[i][j] = vld1q_f32( batch.mvp[i][j] );
+		}
+	}
+	float32x4_t mins[3];
+	float32x4_t maxs[3];
+	for ( int i = 0; i < 3; i++ )
+	{
+		mins[i] = vld1q_f32( batch.mins[i] );
+		maxs[i] = vld1q_f32( batch.maxs[i] );
+	}
+
+	const float32x4_t zero = vdupq_n_f32( 0.0f );
+	const uint32x4_t none = vdupq_n_u32( 0 );
+
+	// A plane culls a bounds only if no corner is on the inside of it.
+	uint32x4_t inside[6] = { none, none, none, none, none, none };
+	float32x4_t maxW = zero;
+
+	for ( int i = 0; i < 8; i++ )
+	{
+		const float32x4_t x = ( i & 1 ) ? maxs[0] : mins[0];
+		const float32x4_t y = ( i & 2 ) ? maxs[1] : mins[1];
+		const float32x4_t z = ( i & 4 ) ? maxs[2] : mins[2];
+
+		// Separate multiplies and adds, rather than vmla, so the results
+		// match the scalar path exactly.
+		float32x4_t c[4];
+		for ( int r = 0; r < 4; r++ )
+		{
+			c[r] = vaddq_f32( vaddq_f32( vaddq_f32(
+						vmulq_f32( m[r][0], x ),
+						vmulq_f32( m[r][1], y ) ),
+						vmulq_f32( m[r][2], z ) ),
+						m[r][3] );
+		}
+		const float32x4_t negW = vnegq_f32( c[3] );
+
+		inside[0] = vorrq_u32( inside[0], vcgtq_f32( c[0], negW ) );
+		inside[1] = vorrq_u32( inside[1], vcltq_f32( c[0], c[3] ) );
+		inside[2] = vorrq_u32( inside[2], vcgtq_f32( c[1], negW ) );
+		inside[3] = vorrq_u32( inside[3], vcltq_f32( c[1], c[3] ) );
+		inside[4] = vorrq_u32( inside[4], vcgtq_f32( c[2], negW ) );
+		inside[5] = vorrq_u32( inside[5], vcltq_f32( c[2], c[3] ) );
+
+		// calculate the farthest W point for front to back sorting
+		maxW = vmaxq_f32( maxW, c[3] );
+	}
+
+	const uint32x4_t empty = vandq_u32( vceqq_f32( maxs[0], mins[0] ), vceqq_f32( maxs[1], mins[1] ) );
+
+	uint32x4_t visible = vandq_u32( vandq_u32( inside[0], inside[1] ), vandq_u32( inside[2], inside[3] ) );
+	visible = vandq_u32( visible, vandq_u32( inside[4], inside[5] ) );
+	visible = vbicq_u32( visible, empty );
+
+	vst1q_f32( keys, vreinterpretq_f32_u32( vandq_u32( visible, vreinterpretq_u32_f32( maxW ) ) ) );
+}
+
+#else
+
+void BoundsSortCullKeys( const ModelCullBatch & batch, float * keys )
+{
+	for ( int lane = 0; lane < MODEL_CULL_BATCH_SIZE; lane++ )
+	{
+		keys[lane] = 0.0f;
+
+		if ( batch.maxs[0][lane] == batch.mins[0][lane] && batch.maxs[1][lane] == batch.mins[1][lane] )
+		{
+			continue;
+		}
+
+		bool inside[6] = { false, false, false, false, false, false };
+		float maxW = 0.0f;
+
+		for ( int i = 0; i < 8; i++ )
+		{
+			const float x = ( i & 1 ) ? batch.maxs[0][lane] : batch.mins[0][lane];
+			const float y = ( i & 2 ) ? batch.maxs[1][lane] : batch.mins[1][lane];
+			const float z = ( i & 4 ) ? batch.maxs[2][lane] : batch.mins[2][lane];
+
+			float c[4];
+			for ( int r = 0; r < 4; r++ )
+			{
+				c[r] = batch.mvp[r][0][lane] * x + batch.mvp[r][1][lane] * y + batch.mvp[r][2][lane] * z + batch.mvp[r][3][lane];
+			}
+
+			inside[0] |= ( c[0] > -c[3] );
+			inside[1] |= ( c[0] < c[3] );
+			inside[2] |= ( c[1] > -c[3] );
+			inside[3] |= ( c[1] < c[3] );
+			inside[4] |= ( c[2] > -c[3] );
+			inside[5] |= ( c[2] < c[3] );
+
+			// calculate the farthest W point for front to back sorting
+			if ( c[3] > maxW )
+			{
+				maxW = c[3];
+			}
+		}
+
+		if ( inside[0] && inside[1] && inside[2] && inside[3] && inside[4] && inside[5] )
+		{
+			keys[lane] = maxW;
+		}
+	}
+}
+
+#endif
+
+void RadixSortDrawKeys( ModelDrawKey * keys, ModelDrawKey * scratch, const int count )
+{
+	if ( count <= 1 )
+	{
+		return;
+	}
+
+	int histograms[8][256];
+	memset( histograms, 0, sizeof( histograms ) );
+	for ( int i = 0; i < count; i++ )
+	{
+		const UInt64 key = keys[i].key;
+		for ( int pass = 0; pass < 8; pass++ )
+		{
+			histograms[pass][( key >> ( pass * 8 ) ) & 255]++;
+		}
+	}
+
+	ModelDrawKey * src = keys;
+	ModelDrawKey * dst = scratch;
+	for ( int pass = 0; pass < 8; pass++ )
+	{
+		const int shift = pass * 8;
+		int * histogram = histograms[pass];
+		if ( histogram[( src[0].key >> shift ) & 255] == count )
+		{
+			continue;
+		}
+
+		int offset = 0;
+		for ( int i = 0; i < 256; i++ )
+		{
+			const int n = histogram[i];
+			histogram[i] = offset;
+			offset += n;
+		}
+
+		for ( int i = 0; i < count; i++ )
+		{
+			dst[histogram[( src[i].key >> shift ) & 255]++] = src[i];
+		}
+
+		Alg::Swap( src, dst );
+	}
+
+	if ( src != keys )
+	{
+		memcpy( keys, src, count * sizeof( ModelDrawKey ) );
+	}
+}
+
+} // namespace OVR
@@ -0,0 +1,63 @@
+/************************************************************************************
+
+Filename    :   ModelCull.h
+Content     :   Batched culling and sorting of model surfaces
+Created     :   August 9, 2013
+Authors     :   John Carmack
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+************************************************************************************/
+#ifndef OVR_ModelCull_h
+#define OVR_ModelCull_h
+
+#include "Kernel/OVR_Math.h"
+
+namespace OVR
+{
+
+// The surface bounds are culled four at a time.  The inputs for each group
+// of four surfaces are stored as a structure-of-arrays, with the surface
+// index in the innermost dimension, so every transformed corner and every
+// plane test is a single vector operation across all four surfaces.
+static const int MODEL_CULL_BATCH_SIZE = 4;
+
+struct ModelCullBatch
+{
+	float	mvp[4][4][MODEL_CULL_BATCH_SIZE];		// row, column, surface
+	float	mins[3][MODEL_CULL_BATCH_SIZE];
+	float	maxs[3][MODEL_CULL_BATCH_SIZE];
+};
+
+// Stores the bounds and mvp of a single surface in the given lane of the batch.
+void SetCullBatchSurface( ModelCullBatch & batch, const int lane, const Bounds3f & bounds, const Matrix4f & mvp );
+
+// Writes 0 for every bounds in the batch that is culled by its mvp, otherwise
+// writes the max W value of the bounds corners so it can be sorted into roughly
+// front to back order for more efficient Z cull.  Sorting bounds in increasing
+// order of their farthest W value usually makes characters and objects draw
+// before the environments they are in, and draws sky boxes last, which is what we want.
+//
+// Empty bounds are always culled, which can be used to disable a surface.
+// Don't just check a single axis, or billboards would be culled.
+void BoundsSortCullKeys( const ModelCullBatch & batch, float * keys );
+
+// Packed sort key for a visible surface, see DrawSortKey() in ModelRender.cpp
+// for the layout.
+// The index refers back into the candidate surface list.
+struct ModelDrawKey
+{
+	UInt64	key;
+	int		index;
+};
+
+// Least significant byte first radix sort on the full 64 bit key.
+// Passes where every key has the same byte are skipped, which is common
+// for the program and texture bytes and the high bytes of the depth.
+// IMPORTANT: the sort is stable, so surfaces with identical keys will
+// sort consistently from frame to frame.
+void RadixSortDrawKeys( ModelDrawKey * keys, ModelDrawKey * scratch, const int count );
+
+} // namespace OVR
+
+#endif	// OVR_ModelCull_h
@@ -12,6 +12,8 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "ModelFile.h"
 
 #include <math.h>
+#include <stdio.h>
+#include <unistd.h>
 
 #include "Kernel/OVR_Alg.h"
 #include "Kernel/OVR_Math.h"
@@ -19,13 +21,17 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "Kernel/OVR_String.h"
 #include "Kernel/OVR_String_Utils.h"
 #include "Kernel/OVR_JSON.h"
+#include "Kernel/OVR_JSONStream.h"
 #include "Kernel/OVR_BinaryFile.h"
 #include "Kernel/OVR_MappedFile.h"
 #include "Kernel/OVR_LogUtils.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Atomic.h"
 
 #include "unzip.h"
 #include "GlTexture.h"
 #include "PackageFiles.h"
+#include "ModelZip.h"
 #include "OVR_FileSys.h"
 
 // Verbose log, redefine this as LOG() to get lots more info dumped
@@ -172,740 +178,1679 @@ void ReadModelArray( Array< _type_ > & out, const char * string, const BinaryRea
 	}
 }
 
-void LoadModelFileJson( ModelFile & model,
-						const char * modelsJson, const int modelsJsonLength,
-						const char * modelsBin, const int modelsBinLength,
-						const ModelGlPrograms & programs, const MaterialParms & materialParms,
-						ModelGeo * outModelGeo )
+enum ModelMaterialType
 {
-	LOG( "parsing %s", model.FileName.ToCStr() );
-	OVR_UNUSED( modelsJsonLength );
+	MATERIAL_TYPE_OPAQUE,
+	MATERIAL_TYPE_PERFORATED,
+	MATERIAL_TYPE_TRANSPARENT,
+	MATERIAL_TYPE_ADDITIVE
+};
 
-	const BinaryReader bin( (const UByte *)modelsBin, modelsBinLength );
+enum ModelTextureUsage
+{
+	TEXTURE_USAGE_OTHER,
+	TEXTURE_USAGE_DIFFUSE,
+	TEXTURE_USAGE_EMISSIVE
+};
 
-	if ( modelsBin != NULL && bin.ReadUInt32() != 0x6272766F )
+enum ModelSurfaceTexture
+{
+	SURFACE_TEXTURE_DIFFUSE,
+	SURFACE_TEXTURE_EMISSIVE,
+	SURFACE_TEXTURE_NORMAL,
+	SURFACE_TEXTURE_SPECULAR,
+	SURFACE_TEXTURE_REFLECTION,
+	SURFACE_TEXTURE_MAX
+};
+
+struct modelTextureData_t
+{
+	String		name;
+	int			usage;
+};
+
+struct modelSurfaceData_t
+{
+	String					name;
+	int						materialType;
+	int						textures[SURFACE_TEXTURE_MAX];
+	Bounds3f				bounds;
+	VertexAttribs			attribs;
+	Array< TriangleIndex >	indices;
+};
+
+// The render model as read from models.json and models.bin, before any
+// textures or geometry are created.
+struct modelRenderData_t
+{
+	Array< modelTextureData_t >	textures;
+	Array< modelSurfaceData_t >	surfaces;
+};
+
+// Reads the first token of the next value. A value that does not begin with the
+// expected token is skipped.
+static bool BeginJsonValue( JsonStreamReader & reader, const JsonStreamToken beginToken )
+{
+	if ( reader.Next() == beginToken )
 	{
-		LOG( "LoadModelFileJson: bad binary file for %s", model.FileName.ToCStr() );
-		return;
+		return true;
 	}
+	reader.SkipRestOfValue();
+	return false;
+}
+
+static void ParseSurfaceJson( modelSurfaceData_t & surfaceData, const JsonReader & surface, const BinaryReader & bin )
+{
+	//
+	// Source Meshes
+	//
 
-	const char * error = NULL;
-	JSON * json = JSON::Parse( modelsJson, & error );
-	if ( json == NULL )
+	const JsonReader source( surface.GetChildByName( "source" ) );
+	if ( source.IsArray() )
+	{
+		while ( !source.IsEndOfArray() )
+		{
+			if ( surfaceData.name.GetLength() )
+			{
+				surfaceData.name += ";";
+			}
+			surfaceData.name += source.GetNextArrayString();
+		}
+	}
+
+	LOGV( "surface %s", surfaceData.name.ToCStr() );
+
+	//
+	// Surface Material
+	//
+
+	surfaceData.materialType = MATERIAL_TYPE_OPAQUE;
+	for ( int i = 0; i < SURFACE_TEXTURE_MAX; i++ )
+	{
+		surfaceData.textures[i] = -1;
+	}
+
+	const JsonReader material( surface.GetChildByName( "material" ) );
+	if ( material.IsObject() )
+	{
+		const String type = material.GetChildStringByName( "type" );
+
+		if ( type == "opaque" )				{ surfaceData.materialType = MATERIAL_TYPE_OPAQUE; }
+		else if ( type == "perforated" )	{ surfaceData.materialType = MATERIAL_TYPE_PERFORATED; }
+		else if ( type == "transparent" )	{ surfaceData.materialType = MATERIAL_TYPE_TRANSPARENT; }
+		else if ( type == "additive" )		{ surfaceData.materialType = MATERIAL_TYPE_ADDITIVE; }
+
+		surfaceData.textures[SURFACE_TEXTURE_DIFFUSE]		= material.GetChildInt32ByName( "diffuse", -1 );
+		surfaceData.textures[SURFACE_TEXTURE_NORMAL]		= material.GetChildInt32ByName( "normal", -1 );
+		surfaceData.textures[SURFACE_TEXTURE_SPECULAR]		= material.GetChildInt32ByName( "specular", -1 );
+		surfaceData.textures[SURFACE_TEXTURE_EMISSIVE]		= material.GetChildInt32ByName( "emissive", -1 );
+		surfaceData.textures[SURFACE_TEXTURE_REFLECTION]	= material.GetChildInt32ByName( "reflection", -1 );
+	}
+
+	//
+	// Surface Bounds
+	//
+
+	StringUtils::StringTo( surfaceData.bounds, surface.GetChildStringByName( "bounds" ).ToCStr() );
+
+	//
+	// Vertices
+	//
+
+	VertexAttribs & attribs = surfaceData.attribs;
+
+	const JsonReader vertices( surface.GetChildByName( "vertices" ) );
+	if ( vertices.IsObject() )
+	{
+		const int vertexCount = Alg::Min( vertices.GetChildInt32ByName( "vertexCount" ), MAX_GEOMETRY_VERTICES );
+		// LOG( "%5d vertices", vertexCount );
+
+		ReadModelArray( attribs.position,     vertices.GetChildStringByName( "position" ).ToCStr(),		bin, vertexCount );
+		ReadModelArray( attribs.normal,       vertices.GetChildStringByName( "normal" ).ToCStr(),		bin, vertexCount );
+		ReadModelArray( attribs.tangent,      vertices.GetChildStringByName( "tangent" ).ToCStr(),		bin, vertexCount );
+		ReadModelArray( attribs.binormal,     vertices.GetChildStringByName( "binormal" ).ToCStr(),		bin, vertexCount );
+		ReadModelArray( attribs.color,        vertices.GetChildStringByName( "color" ).ToCStr(),		bin, vertexCount );
+		ReadModelArray( attribs.uv0,          vertices.GetChildStringByName( "uv0" ).ToCStr(),			bin, vertexCount );
+		ReadModelArray( attribs.uv1,          vertices.GetChildStringByName( "uv1" ).ToCStr(),			bin, vertexCount );
+		ReadModelArray( attribs.jointIndices, vertices.GetChildStringByName( "jointIndices" ).ToCStr(),	bin, vertexCount );
+		ReadModelArray( attribs.jointWeights, vertices.GetChildStringByName( "jointWeights" ).ToCStr(),	bin, vertexCount );
+	}
+
+	//
+	// Triangles
+	//
+
+	const JsonReader triangles( surface.GetChildByName( "triangles" ) );
+	if ( triangles.IsObject() )
+	{
+		const int indexCount = Alg::Min( triangles.GetChildInt32ByName( "indexCount" ), MAX_GEOMETRY_INDICES );
+		// LOG( "%5d indices", indexCount );
+
+		ReadModelArray( surfaceData.indices, triangles.GetChildStringByName( "indices" ).ToCStr(), bin, indexCount );
+	}
+}
+
+// Reads the render model object that is the next value. The textures, joints, tags and
+// surfaces are read one array element at a time.
+static void ParseRenderModelJson( ModelFile & model, modelRenderData_t & renderData,
+						JsonStreamReader & reader, const BinaryReader & bin )
+{
+	if ( !BeginJsonValue( reader, JSON_TOKEN_BEGIN_OBJECT ) )
 	{
-		WARN( "LoadModelFileJson: Error loading %s : %s", model.FileName.ToCStr(), error );
 		return;
 	}
 
-	const JsonReader models( json );
-	if ( models.IsObject() )
+	LOG( "loading render model.." );
+
+	enum TextureOcclusion
 	{
-		//
-		// Render Model
-		//
+		TEXTURE_OCCLUSION_OPAQUE,
+		TEXTURE_OCCLUSION_PERFORATED,
+		TEXTURE_OCCLUSION_TRANSPARENT
+	};
 
-		const JsonReader render_model( models.GetChildByName( "render_model" ) );
-		if ( render_model.IsObject() )
+	while ( reader.Next() == JSON_TOKEN_NAME )
+	{
+		const char * name = reader.GetString();
+		if ( OVR_strcmp( name, "textures" ) == 0 )
 		{
-			LOG( "loading render model.." );
-
 			//
 			// Render Model Textures
 			//
 
-			enum TextureOcclusion
+			if ( !BeginJsonValue( reader, JSON_TOKEN_BEGIN_ARRAY ) )
+			{
+				continue;
+			}
+			for ( JSON * element = reader.ReadValue(); element != NULL; element = reader.ReadValue() )
+			{
+				const JsonReader texture( element );
+				if ( texture.IsObject() )
+				{
+					const UPInt index = renderData.textures.AllocBack();
+					renderData.textures[index].name = texture.GetChildStringByName( "name" );
+
+					const String usage = texture.GetChildStringByName( "usage" );
+					renderData.textures[index].usage = TEXTURE_USAGE_OTHER;
+					if ( usage == "diffuse" )			{ renderData.textures[index].usage = TEXTURE_USAGE_DIFFUSE; }
+					else if ( usage == "emissive" )		{ renderData.textures[index].usage = TEXTURE_USAGE_EMISSIVE; }
+					/*
+					const String occlusion = texture.GetChildStringByName( "occlusion" );
+
+					TextureOcclusion textureOcclusion = TEXTURE_OCCLUSION_OPAQUE;
+					if ( occlusion == "opaque" )			{ textureOcclusion = TEXTURE_OCCLUSION_OPAQUE; }
+					else if ( occlusion == "perforated" )	{ textureOcclusion = TEXTURE_OCCLUSION_PERFORATED; }
+					else if ( occlusion == "transparent" )	{ textureOcclusion = TEXTURE_OCCLUSION_TRANSPARENT; }
+					*/
+				}
+				element->Release();
+			}
+		}
+		else if ( OVR_strcmp( name, "joints" ) == 0 )
+		{
+			//
+			// Render Model Joints
+			//
+
+			if ( !BeginJsonValue( reader, JSON_TOKEN_BEGIN_ARRAY ) )
+			{
+				continue;
+			}
+			model.Joints.Clear();
+			for ( JSON * element = reader.ReadValue(); element != NULL; element = reader.ReadValue() )
+			{
+				const JsonReader joint( element );
+				if ( joint.IsObject() )
+				{
+					const UPInt index = model.Joints.AllocBack();
+					model.Joints[index].index = static_cast<int>( index );
+					model.Joints[index].name = joint.GetChildStringByName( "name" );
+					StringUtils::StringTo( model.Joints[index].transform, joint.GetChildStringByName( "transform" ).ToCStr() );
+					model.Joints[index].animation = MODEL_JOINT_ANIMATION_NONE;
+					const String animation = joint.GetChildStringByName( "animation" );
+					if ( animation == "none" )			{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_NONE; }
+					else if ( animation == "rotate" )	{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_ROTATE; }
+					else if ( animation == "sway" )		{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_SWAY; }
+					else if ( animation == "bob" )		{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_BOB; }
+					model.Joints[index].parameters.x = joint.GetChildFloatByName( "parmX" );
+					model.Joints[index].parameters.y = joint.GetChildFloatByName( "parmY" );
+					model.Joints[index].parameters.z = joint.GetChildFloatByName( "parmZ" );
+					model.Joints[index].timeOffset = joint.GetChildFloatByName( "timeOffset" );
+					model.Joints[index].timeScale = joint.GetChildFloatByName( "timeScale" );
+				}
+				element->Release();
+			}
+		}
+		else if ( OVR_strcmp( name, "tags" ) == 0 )
+		{
+			//
+			// Render Model Tags
+			//
+
+			if ( !BeginJsonValue( reader, JSON_TOKEN_BEGIN_ARRAY ) )
+			{
+				continue;
+			}
+			model.Tags.Clear();
+			for ( JSON * element = reader.ReadValue(); element != NULL; element = reader.ReadValue() )
+			{
+				const JsonReader tag( element );
+				if ( tag.IsObject() )
+				{
+					const UPInt index = model.Tags.AllocBack();
+					model.Tags[index].name = tag.GetChildStringByName( "name" );
+					StringUtils::StringTo( model.Tags[index].matrix, 		tag.GetChildStringByName( "matrix" ).ToCStr() );
+					StringUtils::StringTo( model.Tags[index].jointIndices, 	tag.GetChildStringByName( "jointIndices" ).ToCStr() );
+					StringUtils::StringTo( model.Tags[index].jointWeights, 	tag.GetChildStringByName( "jointWeights" ).ToCStr() );
+				}
+				element->Release();
+			}
+		}
+		else if ( OVR_strcmp( name, "surfaces" ) == 0 )
+		{
+			//
+			// Render Model Surfaces
+			//
+
+			if ( !BeginJsonValue( reader, JSON_TOKEN_BEGIN_ARRAY ) )
+			{
+				continue;
+			}
+			// The surfaces read their vertices and indices from models.bin in order.
+			for ( JSON * element = reader.ReadValue(); element != NULL; element = reader.ReadValue() )
+			{
+				const JsonReader surface( element );
+				if ( surface.IsObject() )
+				{
+					const UPInt index = renderData.surfaces.AllocBack();
+					ParseSurfaceJson( renderData.surfaces[index], surface, bin );
+				}
+				element->Release();
+			}
+		}
+		else
+		{
+			reader.SkipValue();
+		}
+	}
+}
+
+// Reads the collision model array that is the next value, one polytope at a time.
+static void ParseCollisionModelJson( ModelCollision & collision, JsonStreamReader & reader )
+{
+	if ( !BeginJsonValue( reader, JSON_TOKEN_BEGIN_ARRAY ) )
+	{
+		return;
+	}
+
+	for ( JSON * element = reader.ReadValue(); element != NULL; element = reader.ReadValue() )
+	{
+		const UPInt index = collision.Polytopes.AllocBack();
+
+		const JsonReader polytope( element );
+		if ( polytope.IsObject() )
+		{
+			collision.Polytopes[index].Name = polytope.GetChildStringByName( "name" );
+			StringUtils::StringTo( collision.Polytopes[index].Planes, polytope.GetChildStringByName( "planes" ).ToCStr() );
+		}
+		element->Release();
+	}
+
+	collision.Build();
+}
+
+static void ParseTraceModelJson( ModelTrace & traceModel, const JsonReader & raytrace_model, const BinaryReader & bin )
+{
+	traceModel.header.numVertices	= raytrace_model.GetChildInt32ByName( "numVertices" );
+	traceModel.header.numUvs		= raytrace_model.GetChildInt32ByName( "numUvs" );
+	traceModel.header.numIndices	= raytrace_model.GetChildInt32ByName( "numIndices" );
+	traceModel.header.numNodes		= raytrace_model.GetChildInt32ByName( "numNodes" );
+	traceModel.header.numLeafs		= raytrace_model.GetChildInt32ByName( "numLeafs" );
+	traceModel.header.numOverflow	= raytrace_model.GetChildInt32ByName( "numOverflow" );
+
+	StringUtils::StringTo( traceModel.header.bounds, raytrace_model.GetChildStringByName( "bounds" ).ToCStr() );
+
+	ReadModelArray( traceModel.vertices, raytrace_model.GetChildStringByName( "vertices" ).ToCStr(), bin, traceModel.header.numVertices );
+	ReadModelArray( traceModel.uvs, raytrace_model.GetChildStringByName( "uvs" ).ToCStr(), bin, traceModel.header.numUvs );
+	ReadModelArray( traceModel.indices, raytrace_model.GetChildStringByName( "indices" ).ToCStr(), bin, traceModel.header.numIndices );
+
+	if ( !bin.ReadArray( traceModel.nodes, traceModel.header.numNodes ) )
+	{
+		const JsonReader nodes_array( raytrace_model.GetChildByName( "nodes" ) );
+		if ( nodes_array.IsArray() )
+		{
+			while ( !nodes_array.IsEndOfArray() )
 			{
-				TEXTURE_OCCLUSION_OPAQUE,
-				TEXTURE_OCCLUSION_PERFORATED,
-				TEXTURE_OCCLUSION_TRANSPARENT
-			};
+				const UPInt index = traceModel.nodes.AllocBack();
 
-			Array< GlTexture > glTextures;
+				const JsonReader node( nodes_array.GetNextArrayElement() );
+				if ( node.IsObject() )
+				{
+					traceModel.nodes[index].data = (UInt32) node.GetChildInt64ByName( "data" );
+					traceModel.nodes[index].dist = node.GetChildFloatByName( "dist" );
+				}
+			}
+		}
+	}
 
-			const JsonReader texture_array( render_model.GetChildByName( "textures" ) );
-			if ( texture_array.IsArray() )
+	if ( !bin.ReadArray( traceModel.leafs, traceModel.header.numLeafs ) )
+	{
+		const JsonReader leafs_array( raytrace_model.GetChildByName( "leafs" ) );
+		if ( leafs_array.IsArray() )
+		{
+			while ( !leafs_array.IsEndOfArray() )
 			{
-				while ( !texture_array.IsEndOfArray() )
+				const UPInt index = traceModel.leafs.AllocBack();
+
+				const JsonReader leaf( leafs_array.GetNextArrayElement() );
+				if ( leaf.IsObject() )
 				{
-					const JsonReader texture( texture_array.GetNextArrayElement() );
-					if ( texture.IsObject() )
+					StringUtils::StringTo( traceModel.leafs[index].triangles, RT_KDTREE_MAX_LEAF_TRIANGLES, leaf.GetChildStringByName( "triangles" ).ToCStr() );
+					StringUtils::StringTo( traceModel.leafs[index].ropes, 6, leaf.GetChildStringByName( "ropes" ).ToCStr() );
+					StringUtils::StringTo( traceModel.leafs[index].bounds, leaf.GetChildStringByName( "bounds" ).ToCStr() );
+				}
+			}
+		}
+	}
+
+	ReadModelArray( traceModel.overflow, raytrace_model.GetChildStringByName( "overflow" ).ToCStr(), bin, traceModel.header.numOverflow );
+
+	// Model files may leave out the KD-tree and only store the triangles.
+	const bool buildTree = traceModel.header.numNodes == 0 && traceModel.header.numIndices > 0;
+	if ( buildTree ? !traceModel.Build() : !traceModel.Validate( true ) )
+	{
+		// this is a fatal error so that a model file from an untrusted source is never able to cause out-of-bounds reads.
+		FAIL( "Invalid model data" );
+	}
+}
+
+// Reads models.json while it is parsed, without building a JSON tree of the whole file.
+// Only one element of the large arrays is held as a JSON tree at a time.
+// The joints, tags, collision and ray-trace models are stored directly in the model,
+// and the render model is stored in renderData, without issuing any GL calls.
+// This does not touch the model textures so it can run on a different thread
+// while the textures are loaded.
+// Returns false if the text is not valid JSON.
+static bool ParseModelFileJson( ModelFile & model, modelRenderData_t & renderData,
+						JsonStreamReader & reader,
+						const char * modelsBin, const int modelsBinLength )
+{
+	const BinaryReader bin( (const UByte *)modelsBin, modelsBinLength );
+
+	if ( modelsBin != NULL && bin.ReadUInt32() != 0x6272766F )
+	{
+		LOG( "LoadModelFileJson: bad binary file for %s", model.FileName.ToCStr() );
+		return true;
+	}
+
+	// models.bin stores the ray-trace model after the render model, so the ray-trace
+	// model is kept until the end, wherever it is in models.json. With models.bin it
+	// only holds the counts.
+	JSON * raytraceModel = NULL;
+
+	if ( BeginJsonValue( reader, JSON_TOKEN_BEGIN_OBJECT ) )
+	{
+		while ( reader.Next() == JSON_TOKEN_NAME )
+		{
+			const char * name = reader.GetString();
+			if ( OVR_strcmp( name, "render_model" ) == 0 )
+			{
+				ParseRenderModelJson( model, renderData, reader, bin );
+			}
+			else if ( OVR_strcmp( name, "collision_model" ) == 0 )
+			{
+				LOGV( "loading collision model.." );
+				ParseCollisionModelJson( model.Collisions, reader );
+			}
+			else if ( OVR_strcmp( name, "ground_collision_model" ) == 0 )
+			{
+				LOGV( "loading ground collision model.." );
+				ParseCollisionModelJson( model.GroundCollisions, reader );
+			}
+			else if ( OVR_strcmp( name, "raytrace_model" ) == 0 )
+			{
+				if ( raytraceModel != NULL )
+				{
+					raytraceModel->Release();
+				}
+				raytraceModel = reader.ReadValue();
+			}
+			else
+			{
+				reader.SkipValue();
+			}
+		}
+	}
+
+	const bool parsed = reader.GetToken() != JSON_TOKEN_ERROR && reader.GetDepth() == 0;
+
+	//
+	// Ray-Trace Model
+	//
+
+	if ( parsed && raytraceModel != NULL )
+	{
+		const JsonReader raytrace_model( raytraceModel );
+		if ( raytrace_model.IsObject() )
+		{
+			LOGV( "loading ray-trace model.." );
+			ParseTraceModelJson( model.TraceModel, raytrace_model, bin );
+		}
+	}
+	if ( raytraceModel != NULL )
+	{
+		raytraceModel->Release();
+	}
+
+	if ( parsed && !bin.IsAtEnd() )
+	{
+		WARN( "failed to properly read binary file" );
+	}
+
+	return parsed;
+}
+
+// Matches the render model textures with the already loaded model textures,
+// creating a default texture if a texture file is missing.
+static void LoadModelTextures( ModelFile & model, const Array< modelTextureData_t > & textures,
+						const MaterialParms & materialParms, Array< GlTexture > & glTextures )
+{
+	for ( int t = 0; t < textures.GetSizeI(); t++ )
+	{
+		const String & name = textures[t].name;
+
+		// Try to match the texture names with the already loaded texture
+		// and create a default texture if the texture file is missing.
+		int i = 0;
+		for ( ; i < model.Textures.GetSizeI(); i++ )
+		{
+			if ( model.Textures[i].name.CompareNoCase( name ) == 0 )
+			{
+				break;
+			}
+		}
+		if ( i == model.Textures.GetSizeI() )
+		{
+			LOG( "texture %s defaulted", name.ToCStr() );
+			// Create a default texture.
+			LoadModelFileTexture( model, name.ToCStr(), NULL, 0, materialParms );
+		}
+		glTextures.PushBack( model.Textures[i].texid );
+
+		if ( textures[t].usage == TEXTURE_USAGE_DIFFUSE )
+		{
+			if ( materialParms.EnableDiffuseAniso == true )
+			{
+				MakeTextureAniso( model.Textures[i].texid, 2.0f );
+			}
+		}
+		else if ( textures[t].usage == TEXTURE_USAGE_EMISSIVE )
+		{
+			if ( materialParms.EnableEmissiveLodClamp == true )
+			{
+				// LOD clamp lightmap textures to avoid light bleeding
+				MakeTextureLodClamped( model.Textures[i].texid, 1 );
+			}
+		}
+	}
+}
+
+// Sets up the textures and render program for a surface now that the vertex attributes are known.
+static void SetupSurfaceMaterial( ovrSurfaceDef & surfaceDef, const int materialType, const int * textureIndices,
+						const Array< GlTexture > & glTextures, const bool skinned, const bool vertexColor,
+						const ModelGlPrograms & programs, const MaterialParms & materialParms )
+{
+	const int diffuseTextureIndex = textureIndices[SURFACE_TEXTURE_DIFFUSE];
+	const int emissiveTextureIndex = textureIndices[SURFACE_TEXTURE_EMISSIVE];
+	const int normalTextureIndex = textureIndices[SURFACE_TEXTURE_NORMAL];
+	const int specularTextureIndex = textureIndices[SURFACE_TEXTURE_SPECULAR];
+	const int reflectionTextureIndex = textureIndices[SURFACE_TEXTURE_REFLECTION];
+
+	const char * materialTypeString = "opaque";
+	OVR_UNUSED( materialTypeString );	// we'll get warnings if the LOGV's compile out
+
+	// set up additional material flags for the surface
+	if ( materialType == MATERIAL_TYPE_PERFORATED )
+	{
+		// Just blend because alpha testing is rather expensive.
+		surfaceDef.materialDef.gpuState.blendEnable = true;
+		surfaceDef.materialDef.gpuState.depthMaskEnable = false;
+		surfaceDef.materialDef.gpuState.blendSrc = GL_SRC_ALPHA;
+		surfaceDef.materialDef.gpuState.blendDst = GL_ONE_MINUS_SRC_ALPHA;
+		materialTypeString = "perforated";
+	}
+	else if ( materialType == MATERIAL_TYPE_TRANSPARENT || materialParms.Transparent )
+	{
+		surfaceDef.materialDef.gpuState.blendEnable = true;
+		surfaceDef.materialDef.gpuState.depthMaskEnable = false;
+		surfaceDef.materialDef.gpuState.blendSrc = GL_SRC_ALPHA;
+		surfaceDef.materialDef.gpuState.blendDst = GL_ONE_MINUS_SRC_ALPHA;
+		materialTypeString = "transparent";
+	}
+	else if ( materialType == MATERIAL_TYPE_ADDITIVE )
+	{
+		surfaceDef.materialDef.gpuState.blendEnable = true;
+		surfaceDef.materialDef.gpuState.depthMaskEnable = false;
+		surfaceDef.materialDef.gpuState.blendSrc = GL_ONE;
+		surfaceDef.materialDef.gpuState.blendDst = GL_ONE;
+		materialTypeString = "additive";
+	}
+
+	if ( diffuseTextureIndex >= 0 && diffuseTextureIndex < glTextures.GetSizeI() )
+	{
+		surfaceDef.materialDef.textures[0] = glTextures[diffuseTextureIndex];
+
+		if ( emissiveTextureIndex >= 0 && emissiveTextureIndex < glTextures.GetSizeI() )
+		{
+			surfaceDef.materialDef.textures[1] = glTextures[emissiveTextureIndex];
+
+			if (	normalTextureIndex >= 0 && normalTextureIndex < glTextures.GetSizeI() &&
+					specularTextureIndex >= 0 && specularTextureIndex < glTextures.GetSizeI() &&
+					reflectionTextureIndex >= 0 && reflectionTextureIndex < glTextures.GetSizeI() )
+			{
+				// reflection mapped material;
+				surfaceDef.materialDef.textures[2] = glTextures[normalTextureIndex];
+				surfaceDef.materialDef.textures[3] = glTextures[specularTextureIndex];
+				surfaceDef.materialDef.textures[4] = glTextures[reflectionTextureIndex];
+
+				surfaceDef.materialDef.numTextures = 5;
+				if ( skinned )
+				{
+					if ( programs.ProgSkinnedReflectionMapped == NULL )
 					{
-						const String name = texture.GetChildStringByName( "name" );
-
-						// Try to match the texture names with the already loaded texture
-						// and create a default texture if the texture file is missing.
-						int i = 0;
-						for ( ; i < model.Textures.GetSizeI(); i++ )
-						{
-							if ( model.Textures[i].name.CompareNoCase( name ) == 0 )
-							{
-								break;
-							}
-						}
-						if ( i == model.Textures.GetSizeI() )
-						{
-							LOG( "texture %s defaulted", name.ToCStr() );
-							// Create a default texture.
-							LoadModelFileTexture( model, name.ToCStr(), NULL, 0, materialParms );
-						}
-						glTextures.PushBack( model.Textures[i].texid );
-
-						const String usage = texture.GetChildStringByName( "usage" );
-						if ( usage == "diffuse" )
-						{
-							if ( materialParms.EnableDiffuseAniso == true )
-							{
-								MakeTextureAniso( model.Textures[i].texid, 2.0f );
-							}
-						}
-						else if ( usage == "emissive" )
-						{
-							if ( materialParms.EnableEmissiveLodClamp == true )
-							{
-								// LOD clamp lightmap textures to avoid light bleeding
-								MakeTextureLodClamped( model.Textures[i].texid, 1 );
-							}
-						}
-						/*
-						const String occlusion = texture.GetChildStringByName( "occlusion" );
-
-						TextureOcclusion textureOcclusion = TEXTURE_OCCLUSION_OPAQUE;
-						if ( occlusion == "opaque" )			{ textureOcclusion = TEXTURE_OCCLUSION_OPAQUE; }
-						else if ( occlusion == "perforated" )	{ textureOcclusion = TEXTURE_OCCLUSION_PERFORATED; }
-						else if ( occlusion == "transparent" )	{ textureOcclusion = TEXTURE_OCCLUSION_TRANSPARENT; }
-						*/
+						FAIL( "No ProgSkinnedReflectionMapped set");
 					}
+					surfaceDef.materialDef.programObject = programs.ProgSkinnedReflectionMapped->program;
+					surfaceDef.materialDef.uniformMvp = programs.ProgSkinnedReflectionMapped->uMvp;
+					surfaceDef.materialDef.uniformModel = programs.ProgSkinnedReflectionMapped->uModel;
+					surfaceDef.materialDef.uniformView = programs.ProgSkinnedReflectionMapped->uView;
+					surfaceDef.materialDef.uniformJoints = programs.ProgSkinnedReflectionMapped->uJoints;
+					LOGV( "%s skinned reflection mapped material", materialTypeString );
+				}
+				else
+				{
+					if ( programs.ProgReflectionMapped == NULL )
+					{
+						FAIL( "No ProgReflectionMapped set");
+					}
+					surfaceDef.materialDef.programObject = programs.ProgReflectionMapped->program;
+					surfaceDef.materialDef.uniformMvp = programs.ProgReflectionMapped->uMvp;
+					surfaceDef.materialDef.uniformModel = programs.ProgReflectionMapped->uModel;
+					surfaceDef.materialDef.uniformView = programs.ProgReflectionMapped->uView;
+					LOGV( "%s reflection mapped material", materialTypeString );
+				}
+			}
+			else
+			{
+				// light mapped material
+				surfaceDef.materialDef.numTextures = 2;
+				if ( skinned )
+				{
+					if ( programs.ProgSkinnedLightMapped == NULL )
+					{
+						FAIL( "No ProgSkinnedLightMapped set");
+					}
+					surfaceDef.materialDef.programObject = programs.ProgSkinnedLightMapped->program;
+					surfaceDef.materialDef.uniformMvp = programs.ProgSkinnedLightMapped->uMvp;
+					surfaceDef.materialDef.uniformJoints = programs.ProgSkinnedLightMapped->uJoints;
+					LOGV( "%s skinned light mapped material", materialTypeString );
+				}
+				else
+				{
+					if ( programs.ProgLightMapped == NULL )
+					{
+						FAIL( "No ProgLightMapped set");
+					}
+					surfaceDef.materialDef.programObject = programs.ProgLightMapped->program;
+					surfaceDef.materialDef.uniformMvp = programs.ProgLightMapped->uMvp;
+					LOGV( "%s light mapped material", materialTypeString );
+				}
+			}
+		}
+		else
+		{
+			// diffuse only material
+			surfaceDef.materialDef.numTextures = 1;
+			if ( skinned )
+			{
+				if ( programs.ProgSkinnedSingleTexture == NULL )
+				{
+					FAIL( "No ProgSkinnedSingleTexture set");
+				}
+				surfaceDef.materialDef.programObject = programs.ProgSkinnedSingleTexture->program;
+				surfaceDef.materialDef.uniformMvp = programs.ProgSkinnedSingleTexture->uMvp;
+				surfaceDef.materialDef.uniformJoints = programs.ProgSkinnedSingleTexture->uJoints;
+				LOGV( "%s skinned diffuse only material", materialTypeString );
+			}
+			else
+			{
+				if ( programs.ProgSingleTexture == NULL )
+				{
+					FAIL( "No ProgSingleTexture set");
 				}
+				surfaceDef.materialDef.programObject = programs.ProgSingleTexture->program;
+				surfaceDef.materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
+				LOGV( "%s diffuse only material", materialTypeString );
+			}
+		}
+	}
+	else if ( vertexColor )
+	{
+		// vertex color material
+		surfaceDef.materialDef.numTextures = 0;
+		if ( skinned )
+		{
+			if ( programs.ProgSkinnedVertexColor == NULL )
+			{
+				FAIL( "No ProgSkinnedVertexColor set");
+			}
+			surfaceDef.materialDef.programObject = programs.ProgSkinnedVertexColor->program;
+			surfaceDef.materialDef.uniformMvp = programs.ProgSkinnedVertexColor->uMvp;
+			LOGV( "%s skinned vertex color material", materialTypeString );
+		}
+		else
+		{
+			if ( programs.ProgVertexColor == NULL )
+			{
+				FAIL( "No ProgVertexColor set");
+			}
+			surfaceDef.materialDef.programObject = programs.ProgVertexColor->program;
+			surfaceDef.materialDef.uniformMvp = programs.ProgVertexColor->uMvp;
+			LOGV( "%s vertex color material", materialTypeString );
+		}
+	}
+	else
+	{
+		// surface without texture or vertex colors
+		surfaceDef.materialDef.textures[0] = 0;
+		surfaceDef.materialDef.numTextures = 1;
+		if ( skinned )
+		{
+			if ( programs.ProgSkinnedSingleTexture == NULL )
+			{
+				FAIL( "No ProgSkinnedSingleTexture set");
+			}
+			surfaceDef.materialDef.programObject = programs.ProgSkinnedSingleTexture->program;
+			surfaceDef.materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
+			LOGV( "%s skinned default texture material", materialTypeString );
+		}
+		else
+		{
+			if ( programs.ProgSingleTexture == NULL )
+			{
+				FAIL( "No ProgSingleTexture set");
 			}
+			surfaceDef.materialDef.programObject = programs.ProgSingleTexture->program;
+			surfaceDef.materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
+			LOGV( "%s default texture material", materialTypeString );
+		}
+	}
 
-			//
-			// Render Model Joints
-			//
+	if ( materialParms.PolygonOffset )
+	{
+		surfaceDef.materialDef.gpuState.polygonOffsetEnable = true;
+		LOGV( "polygon offset material" );
+	}
+}
+
+// Creates the render model from the parsed render data.
+// This issues GL calls and must be called on the GL thread.
+static void LoadModelRenderData( ModelFile & model, const modelRenderData_t & renderData,
+						const ModelGlPrograms & programs, const MaterialParms & materialParms,
+						ModelGeo * outModelGeo )
+{
+	Array< GlTexture > glTextures;
+	LoadModelTextures( model, renderData.textures, materialParms, glTextures );
+
+	for ( int s = 0; s < renderData.surfaces.GetSizeI(); s++ )
+	{
+		const modelSurfaceData_t & surfaceData = renderData.surfaces[s];
+		const VertexAttribs & attribs = surfaceData.attribs;
+
+		const UPInt index = model.Def.surfaces.AllocBack();
+		ovrSurfaceDef & surfaceDef = model.Def.surfaces[index];
+
+		surfaceDef.surfaceName = surfaceData.name;
+		surfaceDef.cullingBounds = surfaceData.bounds;
+
+		if ( outModelGeo != NULL )
+		{
+			const TriangleIndex indexOffset = static_cast<TriangleIndex>( (*outModelGeo).positions.GetSize() );
+			for ( int i = 0; i < attribs.position.GetSizeI(); ++i )
+			{
+				(*outModelGeo).positions.PushBack( attribs.position[i] );
+			}
+			for ( int i = 0; i < surfaceData.indices.GetSizeI(); ++i )
+			{
+				(*outModelGeo).indices.PushBack( surfaceData.indices[i] + indexOffset );
+			}
+		}
+
+		surfaceDef.geo.Create( attribs, surfaceData.indices );
+
+		const bool skinned = (	attribs.jointIndices.GetSize() == attribs.position.GetSize() &&
+								attribs.jointWeights.GetSize() == attribs.position.GetSize() );
+
+		SetupSurfaceMaterial( surfaceDef, surfaceData.materialType, surfaceData.textures, glTextures,
+								skinned, attribs.color.GetSizeI() > 0, programs, materialParms );
+	}
+}
+
+void LoadModelFileJson( ModelFile & model,
+						const char * modelsJson, const int modelsJsonLength,
+						const char * modelsBin, const int modelsBinLength,
+						const ModelGlPrograms & programs, const MaterialParms & materialParms,
+						ModelGeo * outModelGeo )
+{
+	LOG( "parsing %s", model.FileName.ToCStr() );
+
+	JsonStreamReader reader( modelsJson, modelsJsonLength );
+	modelRenderData_t renderData;
+	if ( !ParseModelFileJson( model, renderData, reader, modelsBin, modelsBinLength ) )
+	{
+		WARN( "LoadModelFileJson: Error loading %s : %s at line %i", model.FileName.ToCStr(),
+				( reader.GetError() != NULL ) ? reader.GetError() : "invalid models.json", reader.GetErrorLine() );
+		return;
+	}
+	LoadModelRenderData( model, renderData, programs, materialParms, outModelGeo );
+}
+
+
+//-----------------------------------------------------------------------------
+//	Threaded zip loading
+//-----------------------------------------------------------------------------
+
+// Model files are loaded in stages:
+//
+// 1. The zip directory is walked on the calling thread.  Stored entries in a
+//    memory resident zip are referenced in place, and deflated entries are only
+//    located, not read.
+// 2. The deflated entries are inflated and checked in parallel by the shared
+//    ovrInflateService, with the calling thread also taking entries.
+// 3. models.json is parsed and read into the model on a worker thread while the
+//    calling thread uploads the textures.
+// 4. The geometry is created from the parsed render model on the calling thread.
+//
+// Only stages 3 and 4 on the calling thread issue GL calls.  The inflated entries
+// are freed as soon as they are consumed, so the textures and the parsed model do
+// not all stay in memory together with their zip entries.
+//
+// The GL-free stages 1 and 2 are in ModelZip.cpp.
+
+struct modelParseJob_t
+{
+	modelParseJob_t() :
+		model( NULL ),
+		text( NULL ),
+		textLength( 0 ),
+		bin( NULL ),
+		binLength( 0 ),
+		parsed( false ),
+		error( NULL ) {}
+
+	ModelFile *			model;
+	modelRenderData_t	renderData;
+	const char *		text;
+	int					textLength;
+	const char *		bin;
+	int					binLength;
+	bool				parsed;
+	const char *		error;
+};
+
+// Only touches the model members that are not touched while loading the textures.
+static threadReturn_t ParseModelJsonThread( Thread * thread, void * v )
+{
+	modelParseJob_t * job = (modelParseJob_t *)v;
+	// the text is read in place, it is not zero terminated when the entry is stored
+	JsonStreamReader reader( job->text, job->textLength );
+	job->parsed = ParseModelFileJson( *job->model, job->renderData, reader, job->bin, job->binLength );
+	if ( !job->parsed )
+	{
+		job->error = ( reader.GetError() != NULL ) ? reader.GetError() : "invalid models.json";
+	}
+	return NULL;
+}
+
+static ModelFile * LoadModelFile( unzFile zfp, const char * fileName,
+								const char * fileData, const int fileDataLength,
+								const ModelGlPrograms & programs,
+								const MaterialParms & materialParms,
+								ModelGeo * outModelGeo = NULL )
+{
+	LOGCPUTIME( "LoadModelFile" );
+
+	ModelFile * modelPtr = new ModelFile;
+	ModelFile & model = *modelPtr;
+
+	model.FileName = fileName;
+	model.UsingSrgbTextures = materialParms.UseSrgbTextureFormats;
+
+	if ( !zfp )
+	{
+		WARN( "Error: can't load %s", fileName );
+		return modelPtr;
+	}
+
+	Array< modelZipEntry_t > entries;
+	ReadModelZipEntries( zfp, fileName, fileData, entries );
+
+	// locate the model files
+
+	const char * modelsJson = NULL;
+	int modelsJsonLength = 0;
+	const char * modelsBin = NULL;
+	int modelsBinLength = 0;
+	FindModelZipEntries( entries, fileName, modelsJson, modelsJsonLength, modelsBin, modelsBinLength );
+
+	// parse the json while the textures are loaded
+
+	modelParseJob_t parseJob;
+	Thread * parseThread = NULL;
+	if ( modelsJson != NULL )
+	{
+		LOG( "parsing %s", model.FileName.ToCStr() );
+		parseJob.model = &model;
+		parseJob.text = modelsJson;
+		parseJob.textLength = modelsJsonLength;
+		parseJob.bin = modelsBin;
+		parseJob.binLength = modelsBinLength;
+		parseThread = new Thread( Thread::CreateParams( ParseModelJsonThread, &parseJob, 128 * 1024 ) );
+		if ( !parseThread->Start() )
+		{
+			delete parseThread;
+			parseThread = NULL;
+			ParseModelJsonThread( NULL, &parseJob );
+		}
+	}
+
+	for ( int i = 0; i < entries.GetSizeI(); i++ )
+	{
+		modelZipEntry_t & entry = entries[i];
+		if ( !entry.valid || entry.buffer == modelsJson || entry.buffer == modelsBin )
+		{
+			continue;
+		}
+
+		if ( IsModelTextureFile( entry.name ) )
+		{
+			LoadModelFileTexture( model, entry.name, entry.buffer, entry.size, materialParms );
+		}
+		else
+		{
+			// ignore other files
+			LOG( "Ignoring %s", entry.name );
+		}
+		FreeModelZipEntry( entry );
+	}
+
+	if ( parseThread != NULL )
+	{
+		parseThread->Join();
+		delete parseThread;
+	}
+
+	// The render model holds copies of everything it needs from models.json and models.bin.
+	FreeModelZipEntries( entries );
+
+	if ( modelsJson != NULL )
+	{
+		if ( !parseJob.parsed )
+		{
+			WARN( "LoadModelFileJson: Error loading %s : %s", model.FileName.ToCStr(), parseJob.error );
+		}
+		else
+		{
+			LoadModelRenderData( model, parseJob.renderData, programs, materialParms, outModelGeo );
+		}
+	}
+
+	return modelPtr;
+}
+
+//-----------------------------------------------------------------------------
+//	Binary model files
+//-----------------------------------------------------------------------------
+
+// A binary model file holds the contents of a zipped model file in a form that
+// can be memory mapped and used directly, without inflating or parsing anything:
+//
+//	modelBinaryHeader_t
+//	modelBinarySection_t[MODEL_SECTION_MAX]
+//	section data, with each section starting at a 16-byte aligned offset
+//
+// Records reference strings by their offset in the strings section, and bulk data
+// by its offset in the blobs section, where every blob starts 16-byte aligned.
+// Texture images are stored as the original .pvr / .ktx files, and the vertices of
+// each surface are stored packed as done by GlGeometry, so both can be uploaded
+// straight from the mapped file. All data is stored in native byte order.
+
+static const UInt32 MODEL_BINARY_MAGIC		= 0x6D72766F;	// "ovrm"
+static const UInt32 MODEL_BINARY_VERSION	= 1;
+static const UInt32 MODEL_BINARY_ALIGNMENT	= 16;
+
+enum modelBinarySectionType_t
+{
+	MODEL_SECTION_STRINGS,
+	MODEL_SECTION_BLOBS,
+	MODEL_SECTION_IMAGES,
+	MODEL_SECTION_TEXTURES,
+	MODEL_SECTION_JOINTS,
+	MODEL_SECTION_TAGS,
+	MODEL_SECTION_SURFACES,
+	MODEL_SECTION_COLLISION,
+	MODEL_SECTION_GROUND_COLLISION,
+	MODEL_SECTION_PLANES,
+	MODEL_SECTION_TRACE,
+	MODEL_SECTION_MAX
+};
+
+struct modelBinaryHeader_t
+{
+	UInt32		magic;
+	UInt32		version;
+	UInt32		fileSize;
+	UInt32		numSections;
+};
+
+struct modelBinarySection_t
+{
+	UInt32		type;
+	UInt32		count;		// number of records
+	UInt32		offset;		// from the start of the file
+	UInt32		size;		// in bytes
+};
+
+struct modelBinaryImage_t
+{
+	UInt32		name;
+	UInt32		offset;
+	UInt32		size;
+};
+
+struct modelBinaryTexture_t
+{
+	UInt32		name;
+	UInt32		usage;
+};
+
+struct modelBinaryJoint_t
+{
+	UInt32		name;
+	UInt32		animation;
+	Matrix4f	transform;
+	Vector3f	parameters;
+	float		timeOffset;
+	float		timeScale;
+};
+
+struct modelBinaryTag_t
+{
+	UInt32		name;
+	Matrix4f	matrix;
+	Vector4i	jointIndices;
+	Vector4f	jointWeights;
+};
+
+struct modelBinarySurface_t
+{
+	UInt32		name;
+	UInt32		materialType;
+	SInt32		textures[SURFACE_TEXTURE_MAX];
+	Bounds3f	bounds;
+	UInt32		attribFlags;
+	UInt32		numVertices;
+	UInt32		vertexOffset;
+	UInt32		numIndices;
+	UInt32		indexOffset;
+};
+
+struct modelBinaryPolytope_t
+{
+	UInt32		name;
+	UInt32		firstPlane;
+	UInt32		numPlanes;
+};
+
+struct modelBinaryTrace_t
+{
+	kdtree_header_t	header;
+	UInt32			vertexOffset;
+	UInt32			uvOffset;
+	UInt32			indexOffset;
+	UInt32			nodeOffset;
+	UInt32			leafOffset;
+	UInt32			overflowOffset;
+};
+
+static const UInt32 ModelBinaryRecordSize[MODEL_SECTION_MAX] =
+{
+	1,								// MODEL_SECTION_STRINGS
+	1,								// MODEL_SECTION_BLOBS
+	sizeof( modelBinaryImage_t ),	// MODEL_SECTION_IMAGES
+	sizeof( modelBinaryTexture_t ),	// MODEL_SECTION_TEXTURES
+	sizeof( modelBinaryJoint_t ),	// MODEL_SECTION_JOINTS
+	sizeof( modelBinaryTag_t ),		// MODEL_SECTION_TAGS
+	sizeof( modelBinarySurface_t ),	// MODEL_SECTION_SURFACES
+	sizeof( modelBinaryPolytope_t ),// MODEL_SECTION_COLLISION
+	sizeof( modelBinaryPolytope_t ),// MODEL_SECTION_GROUND_COLLISION
+	sizeof( Planef ),				// MODEL_SECTION_PLANES
+	sizeof( modelBinaryTrace_t )	// MODEL_SECTION_TRACE
+};
+
+static const int VALID_VERTEX_ATTRIB_FLAGS = ( VERTEX_ATTRIB_FLAG_JOINT_WEIGHTS << 1 ) - 1;
+
+static bool IsModelFileBinary( const void * buffer, const int bufferLength )
+{
+	return ( buffer != NULL && bufferLength >= (int)sizeof( modelBinaryHeader_t ) &&
+				( (const modelBinaryHeader_t *)buffer )->magic == MODEL_BINARY_MAGIC );
+}
+
+// Validates the header and section table of a binary model file, and provides
+// range checked access to the sections.
+class ModelBinaryReader
+{
+public:
+	ModelBinaryReader() :
+		Data( NULL ),
+		Sections( NULL ) {}
+
+	bool Open( const char * fileName, const UByte * data, const int length )
+	{
+		if ( !IsModelFileBinary( data, length ) )
+		{
+			WARN( "%s is not a binary model file", fileName );
+			return false;
+		}
+		const modelBinaryHeader_t * header = (const modelBinaryHeader_t *)data;
+		if ( header->version != MODEL_BINARY_VERSION )
+		{
+			WARN( "%s has binary model version %u, expected %u", fileName, header->version, MODEL_BINARY_VERSION );
+			return false;
+		}
+		if ( header->fileSize > (UInt32)length || header->numSections != MODEL_SECTION_MAX ||
+				sizeof( modelBinaryHeader_t ) + MODEL_SECTION_MAX * sizeof( modelBinarySection_t ) > header->fileSize )
+		{
+			WARN( "%s has a bad binary model header", fileName );
+			return false;
+		}
+		const modelBinarySection_t * sections = (const modelBinarySection_t *)( data + sizeof( modelBinaryHeader_t ) );
+		for ( int i = 0; i < MODEL_SECTION_MAX; i++ )
+		{
+			const modelBinarySection_t & section = sections[i];
+			if (	section.type != (UInt32)i ||
+					( section.offset & ( MODEL_BINARY_ALIGNMENT - 1 ) ) != 0 ||
+					(UInt64)section.offset + section.size > header->fileSize ||
+					(UInt64)section.count * ModelBinaryRecordSize[i] != section.size )
+			{
+				WARN( "%s has a bad binary model section %d", fileName, i );
+				return false;
+			}
+		}
+		// all strings are referenced by offset, so make sure the last one is terminated
+		const modelBinarySection_t & strings = sections[MODEL_SECTION_STRINGS];
+		if ( strings.size == 0 || data[strings.offset + strings.size - 1] != '\0' )
+		{
+			WARN( "%s has bad binary model strings", fileName );
+			return false;
+		}
+		Data = data;
+		Sections = sections;
+		return true;
+	}
+
+	template< typename _type_ >
+	const _type_ * GetRecords( const int section, int & count ) const
+	{
+		OVR_ASSERT( ModelBinaryRecordSize[section] == sizeof( _type_ ) );
+		count = (int)Sections[section].count;
+		return (const _type_ *)( Data + Sections[section].offset );
+	}
+
+	const char * GetString( const UInt32 offset ) const
+	{
+		if ( offset >= Sections[MODEL_SECTION_STRINGS].size )
+		{
+			return "";
+		}
+		return (const char *)( Data + Sections[MODEL_SECTION_STRINGS].offset + offset );
+	}
+
+	// Returns NULL if the blob is not completely inside the blobs section.
+	const UByte * GetBlob( const UInt32 offset, const UInt64 size ) const
+	{
+		if ( ( offset & ( MODEL_BINARY_ALIGNMENT - 1 ) ) != 0 || (UInt64)offset + size > Sections[MODEL_SECTION_BLOBS].size )
+		{
+			return NULL;
+		}
+		return Data + Sections[MODEL_SECTION_BLOBS].offset + offset;
+	}
+
+	template< typename _type_ >
+	bool ReadBlobArray( Array< _type_ > & out, const UInt32 offset, const int numElements ) const
+	{
+		out.Resize( 0 );
+		if ( numElements <= 0 )
+		{
+			return ( numElements == 0 );
+		}
+		const UByte * blob = GetBlob( offset, (UInt64)numElements * sizeof( _type_ ) );
+		if ( blob == NULL )
+		{
+			return false;
+		}
+		out.Resize( numElements );
+		memcpy( &out[0], blob, numElements * sizeof( _type_ ) );
+		return true;
+	}
+
+private:
+	const UByte *					Data;
+	const modelBinarySection_t *	Sections;
+};
+
+static void LoadModelBinaryCollision( const ModelBinaryReader & reader, const int section, ModelCollision & collision )
+{
+	int numPolytopes = 0;
+	const modelBinaryPolytope_t * polytopes = reader.GetRecords< modelBinaryPolytope_t >( section, numPolytopes );
+	int numPlanes = 0;
+	const Planef * planes = reader.GetRecords< Planef >( MODEL_SECTION_PLANES, numPlanes );
+
+	collision.Polytopes.Resize( numPolytopes );
+	for ( int i = 0; i < numPolytopes; i++ )
+	{
+		CollisionPolytope & polytope = collision.Polytopes[i];
+		polytope.Name = reader.GetString( polytopes[i].name );
+		if ( (UInt64)polytopes[i].firstPlane + polytopes[i].numPlanes > (UInt64)numPlanes )
+		{
+			WARN( "polytope %s has out of range planes", polytope.Name.ToCStr() );
+			continue;
+		}
+		polytope.Planes.Resize( polytopes[i].numPlanes );
+		for ( UInt32 j = 0; j < polytopes[i].numPlanes; j++ )
+		{
+			polytope.Planes[j] = planes[polytopes[i].firstPlane + j];
+		}
+	}
+
+	collision.Build();
+}
+
+// Creates the model from a memory resident binary model file.
+// The texture images and geometry are uploaded straight from the file data.
+// This issues GL calls and must be called on the GL thread.
+static void LoadModelFileBinary( ModelFile & model, const UByte * data, const int length,
+						const ModelGlPrograms & programs, const MaterialParms & materialParms,
+						ModelGeo * outModelGeo )
+{
+	LOGCPUTIME( "LoadModelFileBinary" );
+
+	ModelBinaryReader reader;
+	if ( !reader.Open( model.FileName.ToCStr(), data, length ) )
+	{
+		return;
+	}
+
+	//
+	// Texture Images
+	//
+
+	int numImages = 0;
+	const modelBinaryImage_t * images = reader.GetRecords< modelBinaryImage_t >( MODEL_SECTION_IMAGES, numImages );
+	for ( int i = 0; i < numImages; i++ )
+	{
+		const char * name = reader.GetString( images[i].name );
+		const UByte * image = reader.GetBlob( images[i].offset, images[i].size );
+		if ( image == NULL )
+		{
+			WARN( "Failed to read %s from %s", name, model.FileName.ToCStr() );
+			continue;
+		}
+		LoadModelFileTexture( model, name, (const char *)image, images[i].size, materialParms );
+	}
 
-			const JsonReader joint_array( render_model.GetChildByName( "joints" ) );
-			if ( joint_array.IsArray() )
-			{
-				model.Joints.Clear();
+	//
+	// Render Model Textures
+	//
 
-				while ( !joint_array.IsEndOfArray() )
-				{
-					const JsonReader joint( joint_array.GetNextArrayElement() );
-					if ( joint.IsObject() )
-					{
-						const UPInt index = model.Joints.AllocBack();
-						model.Joints[index].index = static_cast<int>( index );
-						model.Joints[index].name = joint.GetChildStringByName( "name" );
-						StringUtils::StringTo( model.Joints[index].transform, joint.GetChildStringByName( "transform" ).ToCStr() );
-						model.Joints[index].animation = MODEL_JOINT_ANIMATION_NONE;
-						const String animation = joint.GetChildStringByName( "animation" );
-						if ( animation == "none" )			{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_NONE; }
-						else if ( animation == "rotate" )	{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_ROTATE; }
-						else if ( animation == "sway" )		{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_SWAY; }
-						else if ( animation == "bob" )		{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_BOB; }
-						model.Joints[index].parameters.x = joint.GetChildFloatByName( "parmX" );
-						model.Joints[index].parameters.y = joint.GetChildFloatByName( "parmY" );
-						model.Joints[index].parameters.z = joint.GetChildFloatByName( "parmZ" );
-						model.Joints[index].timeOffset = joint.GetChildFloatByName( "timeOffset" );
-						model.Joints[index].timeScale = joint.GetChildFloatByName( "timeScale" );
-					}
-				}
-			}
+	int numTextures = 0;
+	const modelBinaryTexture_t * textures = reader.GetRecords< modelBinaryTexture_t >( MODEL_SECTION_TEXTURES, numTextures );
+	Array< modelTextureData_t > textureData;
+	textureData.Resize( numTextures );
+	for ( int i = 0; i < numTextures; i++ )
+	{
+		textureData[i].name = reader.GetString( textures[i].name );
+		textureData[i].usage = textures[i].usage;
+	}
 
-			//
-			// Render Model Tags
-			//
+	Array< GlTexture > glTextures;
+	LoadModelTextures( model, textureData, materialParms, glTextures );
 
-			const JsonReader tag_array( render_model.GetChildByName( "tags" ) );
-			if ( tag_array.IsArray() )
-			{
-				model.Tags.Clear();
+	//
+	// Render Model Joints
+	//
 
-				while ( !tag_array.IsEndOfArray() )
-				{
-					const JsonReader tag( tag_array.GetNextArrayElement() );
-					if ( tag.IsObject() )
-					{
-						const UPInt index = model.Tags.AllocBack();
-						model.Tags[index].name = tag.GetChildStringByName( "name" );
-						StringUtils::StringTo( model.Tags[index].matrix, 		tag.GetChildStringByName( "matrix" ).ToCStr() );
-						StringUtils::StringTo( model.Tags[index].jointIndices, 	tag.GetChildStringByName( "jointIndices" ).ToCStr() );
-						StringUtils::StringTo( model.Tags[index].jointWeights, 	tag.GetChildStringByName( "jointWeights" ).ToCStr() );
-					}
-				}
-			}
+	int numJoints = 0;
+	const modelBinaryJoint_t * joints = reader.GetRecords< modelBinaryJoint_t >( MODEL_SECTION_JOINTS, numJoints );
+	model.Joints.Resize( numJoints );
+	for ( int i = 0; i < numJoints; i++ )
+	{
+		ModelJoint & joint = model.Joints[i];
+		joint.index = i;
+		joint.name = reader.GetString( joints[i].name );
+		joint.transform = joints[i].transform;
+		joint.animation = ( joints[i].animation <= MODEL_JOINT_ANIMATION_BOB ) ?
+							(ModelJointAnimation)joints[i].animation : MODEL_JOINT_ANIMATION_NONE;
+		joint.parameters = joints[i].parameters;
+		joint.timeOffset = joints[i].timeOffset;
+		joint.timeScale = joints[i].timeScale;
+	}
 
-			//
-			// Render Model Surfaces
-			//
+	//
+	// Render Model Tags
+	//
 
-			const JsonReader surface_array( render_model.GetChildByName( "surfaces" ) );
-			if ( surface_array.IsArray() )
-			{
-				while ( !surface_array.IsEndOfArray() )
-				{
-					const JsonReader surface( surface_array.GetNextArrayElement() );
-					if ( surface.IsObject() )
-					{
-						const UPInt index = model.Def.surfaces.AllocBack();
-
-						//
-						// Source Meshes
-						//
-
-						const JsonReader source( surface.GetChildByName( "source" ) );
-						if ( source.IsArray() )
-						{
-							while ( !source.IsEndOfArray() )
-							{
-								if ( model.Def.surfaces[index].surfaceName.GetLength() )
-								{
-									model.Def.surfaces[index].surfaceName += ";";
-								}
-								model.Def.surfaces[index].surfaceName += source.GetNextArrayString();
-							}
-						}
-
-						LOGV( "surface %s", model.Def.surfaces[index].surfaceName.ToCStr() );
-
-						//
-						// Surface Material
-						//
-
-						enum
-						{
-							MATERIAL_TYPE_OPAQUE,
-							MATERIAL_TYPE_PERFORATED,
-							MATERIAL_TYPE_TRANSPARENT,
-							MATERIAL_TYPE_ADDITIVE
-						} materialType = MATERIAL_TYPE_OPAQUE;
-
-						int diffuseTextureIndex = -1;
-						int normalTextureIndex = -1;
-						int specularTextureIndex = -1;
-						int emissiveTextureIndex = -1;
-						int reflectionTextureIndex = -1;
-
-						const JsonReader material( surface.GetChildByName( "material" ) );
-						if ( material.IsObject() )
-						{
-							const String type = material.GetChildStringByName( "type" );
-
-							if ( type == "opaque" )				{ materialType = MATERIAL_TYPE_OPAQUE; }
-							else if ( type == "perforated" )	{ materialType = MATERIAL_TYPE_PERFORATED; }
-							else if ( type == "transparent" )	{ materialType = MATERIAL_TYPE_TRANSPARENT; }
-							else if ( type == "additive" )		{ materialType = MATERIAL_TYPE_ADDITIVE; }
-
-							diffuseTextureIndex		= material.GetChildInt32ByName( "diffuse", -1 );
-							normalTextureIndex		= material.GetChildInt32ByName( "normal", -1 );
-							specularTextureIndex	= material.GetChildInt32ByName( "specular", -1 );
-							emissiveTextureIndex	= material.GetChildInt32ByName( "emissive", -1 );
-							reflectionTextureIndex	= material.GetChildInt32ByName( "reflection", -1 );
-						}
-
-						//
-						// Surface Bounds
-						//
-
-						StringUtils::StringTo( model.Def.surfaces[index].cullingBounds, surface.GetChildStringByName( "bounds" ).ToCStr() );
-
-						TriangleIndex indexOffset = 0;
-						if ( outModelGeo != NULL )
-						{
-							indexOffset = static_cast<TriangleIndex>( (*outModelGeo).positions.GetSize() );
-						}
-						//
-						// Vertices
-						//
-
-						VertexAttribs attribs;
-
-						const JsonReader vertices( surface.GetChildByName( "vertices" ) );
-						if ( vertices.IsObject() )
-						{
-							const int vertexCount = Alg::Min( vertices.GetChildInt32ByName( "vertexCount" ), MAX_GEOMETRY_VERTICES );
-							// LOG( "%5d vertices", vertexCount );
-
-							ReadModelArray( attribs.position,     vertices.GetChildStringByName( "position" ).ToCStr(),		bin, vertexCount );
-							ReadModelArray( attribs.normal,       vertices.GetChildStringByName( "normal" ).ToCStr(),		bin, vertexCount );
-							ReadModelArray( attribs.tangent,      vertices.GetChildStringByName( "tangent" ).ToCStr(),		bin, vertexCount );
-							ReadModelArray( attribs.binormal,     vertices.GetChildStringByName( "binormal" ).ToCStr(),		bin, vertexCount );
-							ReadModelArray( attribs.color,        vertices.GetChildStringByName( "color" ).ToCStr(),		bin, vertexCount );
-							ReadModelArray( attribs.uv0,          vertices.GetChildStringByName( "uv0" ).ToCStr(),			bin, vertexCount );
-							ReadModelArray( attribs.uv1,          vertices.GetChildStringByName( "uv1" ).ToCStr(),			bin, vertexCount );
-							ReadModelArray( attribs.jointIndices, vertices.GetChildStringByName( "jointIndices" ).ToCStr(),	bin, vertexCount );
-							ReadModelArray( attribs.jointWeights, vertices.GetChildStringByName( "jointWeights" ).ToCStr(),	bin, vertexCount );
-
-							if ( outModelGeo != NULL )
-							{
-								for ( int i = 0; i < attribs.position.GetSizeI(); ++i )
-								{
-									(*outModelGeo).positions.PushBack( attribs.position[i] );
-								}
-							}
-						}
-
-						//
-						// Triangles
-						//
-
-						Array< TriangleIndex > indices;
-
-						const JsonReader triangles( surface.GetChildByName( "triangles" ) );
-						if ( triangles.IsObject() )
-						{
-							const int indexCount = Alg::Min( triangles.GetChildInt32ByName( "indexCount" ), MAX_GEOMETRY_INDICES );
-							// LOG( "%5d indices", indexCount );
-
-							ReadModelArray( indices, triangles.GetChildStringByName( "indices" ).ToCStr(), bin, indexCount );
-						}
-
-						if ( outModelGeo != NULL )
-						{
-							for ( int i = 0; i < indices.GetSizeI(); ++i )
-							{
-								(*outModelGeo).indices.PushBack( indices[i] + indexOffset );
-							}
-						}
-
-						//
-						// Setup geometry, textures and render programs now that the vertex attributes are known.
-						//
-
-						model.Def.surfaces[index].geo.Create( attribs, indices );
-
-						const char * materialTypeString = "opaque";
-						OVR_UNUSED( materialTypeString );	// we'll get warnings if the LOGV's compile out
-
-						// set up additional material flags for the surface
-						if ( materialType == MATERIAL_TYPE_PERFORATED )
-						{
-							// Just blend because alpha testing is rather expensive.
-							model.Def.surfaces[index].materialDef.gpuState.blendEnable = true;
-							model.Def.surfaces[index].materialDef.gpuState.depthMaskEnable = false;
-							model.Def.surfaces[index].materialDef.gpuState.blendSrc = GL_SRC_ALPHA;
-							model.Def.surfaces[index].materialDef.gpuState.blendDst = GL_ONE_MINUS_SRC_ALPHA;
-							materialTypeString = "perforated";
-						}
-						else if ( materialType == MATERIAL_TYPE_TRANSPARENT || materialParms.Transparent )
-						{
-							model.Def.surfaces[index].materialDef.gpuState.blendEnable = true;
-							model.Def.surfaces[index].materialDef.gpuState.depthMaskEnable = false;
-							model.Def.surfaces[index].materialDef.gpuState.blendSrc = GL_SRC_ALPHA;
-							model.Def.surfaces[index].materialDef.gpuState.blendDst = GL_ONE_MINUS_SRC_ALPHA;
-							materialTypeString = "transparent";
-						}
-						else if ( materialType == MATERIAL_TYPE_ADDITIVE )
-						{
-							model.Def.surfaces[index].materialDef.gpuState.blendEnable = true;
-							model.Def.surfaces[index].materialDef.gpuState.depthMaskEnable = false;
-							model.Def.surfaces[index].materialDef.gpuState.blendSrc = GL_ONE;
-							model.Def.surfaces[index].materialDef.gpuState.blendDst = GL_ONE;
-							materialTypeString = "additive";
-						}
-
-						const bool skinned = (	attribs.jointIndices.GetSize() == attribs.position.GetSize() &&
-												attribs.jointWeights.GetSize() == attribs.position.GetSize() );
-
-						if ( diffuseTextureIndex >= 0 && diffuseTextureIndex < glTextures.GetSizeI() )
-						{
-							model.Def.surfaces[index].materialDef.textures[0] = glTextures[diffuseTextureIndex];
-
-							if ( emissiveTextureIndex >= 0 && emissiveTextureIndex < glTextures.GetSizeI() )
-							{
-								model.Def.surfaces[index].materialDef.textures[1] = glTextures[emissiveTextureIndex];
-
-								if (	normalTextureIndex >= 0 && normalTextureIndex < glTextures.GetSizeI() &&
-										specularTextureIndex >= 0 && specularTextureIndex < glTextures.GetSizeI() &&
-										reflectionTextureIndex >= 0 && reflectionTextureIndex < glTextures.GetSizeI() )
-								{
-									// reflection mapped material;
-									model.Def.surfaces[index].materialDef.textures[2] = glTextures[normalTextureIndex];
-									model.Def.surfaces[index].materialDef.textures[3] = glTextures[specularTextureIndex];
-									model.Def.surfaces[index].materialDef.textures[4] = glTextures[reflectionTextureIndex];
-
-									model.Def.surfaces[index].materialDef.numTextures = 5;
-									if ( skinned )
-									{
-										if ( programs.ProgSkinnedReflectionMapped == NULL )
-										{
-											FAIL( "No ProgSkinnedReflectionMapped set");
-										}
-										model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedReflectionMapped->program;
-										model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSkinnedReflectionMapped->uMvp;
-										model.Def.surfaces[index].materialDef.uniformModel = programs.ProgSkinnedReflectionMapped->uModel;
-										model.Def.surfaces[index].materialDef.uniformView = programs.ProgSkinnedReflectionMapped->uView;
-										model.Def.surfaces[index].materialDef.uniformJoints = programs.ProgSkinnedReflectionMapped->uJoints;
-										LOGV( "%s skinned reflection mapped material", materialTypeString );
-									}
-									else
-									{
-										if ( programs.ProgReflectionMapped == NULL )
-										{
-											FAIL( "No ProgReflectionMapped set");
-										}
-										model.Def.surfaces[index].materialDef.programObject = programs.ProgReflectionMapped->program;
-										model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgReflectionMapped->uMvp;
-										model.Def.surfaces[index].materialDef.uniformModel = programs.ProgReflectionMapped->uModel;
-										model.Def.surfaces[index].materialDef.uniformView = programs.ProgReflectionMapped->uView;
-										LOGV( "%s reflection mapped material", materialTypeString );
-									}
-								}
-								else
-								{
-									// light mapped material
-									model.Def.surfaces[index].materialDef.numTextures = 2;
-									if ( skinned )
-									{
-										if ( programs.ProgSkinnedLightMapped == NULL )
-										{
-											FAIL( "No ProgSkinnedLightMapped set");
-										}
-										model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedLightMapped->program;
-										model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSkinnedLightMapped->uMvp;
-										model.Def.surfaces[index].materialDef.uniformJoints = programs.ProgSkinnedLightMapped->uJoints;
-										LOGV( "%s skinned light mapped material", materialTypeString );
-									}
-									else
-									{
-										if ( programs.ProgLightMapped == NULL )
-										{
-											FAIL( "No ProgLightMapped set");
-										}
-										model.Def.surfaces[index].materialDef.programObject = programs.ProgLightMapped->program;
-										model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgLightMapped->uMvp;
-										LOGV( "%s light mapped material", materialTypeString );
-									}
-								}
-							}
-							else 
-							{
-								// diffuse only material
-								model.Def.surfaces[index].materialDef.numTextures = 1;
-								if ( skinned )
-								{
-									if ( programs.ProgSkinnedSingleTexture == NULL )
-									{
-										FAIL( "No ProgSkinnedSingleTexture set");
-									}
-									model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedSingleTexture->program;
-									model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSkinnedSingleTexture->uMvp;
-									model.Def.surfaces[index].materialDef.uniformJoints = programs.ProgSkinnedSingleTexture->uJoints;
-									LOGV( "%s skinned diffuse only material", materialTypeString );
-								}
-								else
-								{
-									if ( programs.ProgSingleTexture == NULL )
-									{
-										FAIL( "No ProgSingleTexture set");
-									}
-									model.Def.surfaces[index].materialDef.programObject = programs.ProgSingleTexture->program;
-									model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
-									LOGV( "%s diffuse only material", materialTypeString );
-								}
-							}
-						}
-						else if ( attribs.color.GetSizeI() > 0 )
-						{
-							// vertex color material
-							model.Def.surfaces[index].materialDef.numTextures = 0;
-							if ( skinned )
-							{
-								if ( programs.ProgSkinnedVertexColor == NULL )
-								{
-									FAIL( "No ProgSkinnedVertexColor set");
-								}
-								model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedVertexColor->program;
-								model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSkinnedVertexColor->uMvp;
-								LOGV( "%s skinned vertex color material", materialTypeString );
-							}
-							else
-							{
-								if ( programs.ProgVertexColor == NULL )
-								{
-									FAIL( "No ProgVertexColor set");
-								}
-								model.Def.surfaces[index].materialDef.programObject = programs.ProgVertexColor->program;
-								model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgVertexColor->uMvp;
-								LOGV( "%s vertex color material", materialTypeString );
-							}
-						}
-						else
-						{
-							// surface without texture or vertex colors
-							model.Def.surfaces[index].materialDef.textures[0] = 0;
-							model.Def.surfaces[index].materialDef.numTextures = 1;
-							if ( skinned )
-							{
-								if ( programs.ProgSkinnedSingleTexture == NULL )
-								{
-									FAIL( "No ProgSkinnedSingleTexture set");
-								}
-								model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedSingleTexture->program;
-								model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
-								LOGV( "%s skinned default texture material", materialTypeString );
-							}
-							else
-							{
-								if ( programs.ProgSingleTexture == NULL )
-								{
-									FAIL( "No ProgSingleTexture set");
-								}
-								model.Def.surfaces[index].materialDef.programObject = programs.ProgSingleTexture->program;
-								model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
-								LOGV( "%s default texture material", materialTypeString );
-							}
-						}
-
-						if ( materialParms.PolygonOffset )
-						{
-							model.Def.surfaces[index].materialDef.gpuState.polygonOffsetEnable = true;
-							LOGV( "polygon offset material" );
-						}
-					}
-				}
-			}
-		}
+	int numTags = 0;
+	const modelBinaryTag_t * tags = reader.GetRecords< modelBinaryTag_t >( MODEL_SECTION_TAGS, numTags );
+	model.Tags.Resize( numTags );
+	for ( int i = 0; i < numTags; i++ )
+	{
+		ModelTag & tag = model.Tags[i];
+		tag.name = reader.GetString( tags[i].name );
+		tag.matrix = tags[i].matrix;
+		tag.jointIndices = tags[i].jointIndices;
+		tag.jointWeights = tags[i].jointWeights;
+	}
 
-		//
-		// Collision Model
-		//
+	//
+	// Render Model Surfaces
+	//
 
-		const JsonReader collision_model( models.GetChildByName( "collision_model" ) );
-		if ( collision_model.IsArray() )
+	int numSurfaces = 0;
+	const modelBinarySurface_t * surfaces = reader.GetRecords< modelBinarySurface_t >( MODEL_SECTION_SURFACES, numSurfaces );
+	for ( int s = 0; s < numSurfaces; s++ )
+	{
+		const modelBinarySurface_t & surface = surfaces[s];
+		const char * name = reader.GetString( surface.name );
+
+		const int attribFlags = (int)surface.attribFlags;
+		const UByte * vertices = reader.GetBlob( surface.vertexOffset, (UInt64)surface.numVertices * GetPackedVertexSize( attribFlags ) );
+		const UByte * indices = reader.GetBlob( surface.indexOffset, (UInt64)surface.numIndices * sizeof( TriangleIndex ) );
+		if (	vertices == NULL || indices == NULL ||
+				( attribFlags & ~VALID_VERTEX_ATTRIB_FLAGS ) != 0 ||
+				( surface.numVertices > 0 && ( attribFlags & VERTEX_ATTRIB_FLAG_POSITION ) == 0 ) ||
+				surface.numVertices > (UInt32)MAX_GEOMETRY_VERTICES ||
+				surface.numIndices > (UInt32)MAX_GEOMETRY_INDICES )
 		{
-			LOGV( "loading collision model.." );
-
-			while ( !collision_model.IsEndOfArray() )
-			{
-				const UPInt index = model.Collisions.Polytopes.AllocBack();
-
-				const JsonReader polytope( collision_model.GetNextArrayElement() );
-				if ( polytope.IsObject() )
-				{
-					model.Collisions.Polytopes[index].Name = polytope.GetChildStringByName( "name" );
-					StringUtils::StringTo( model.Collisions.Polytopes[index].Planes, polytope.GetChildStringByName( "planes" ).ToCStr() );
-				}
-			}
+			WARN( "surface %s has bad geometry in %s", name, model.FileName.ToCStr() );
+			continue;
 		}
 
-		//
-		// Ground Collision Model
-		//
+		const UPInt index = model.Def.surfaces.AllocBack();
+		ovrSurfaceDef & surfaceDef = model.Def.surfaces[index];
 
-		const JsonReader ground_collision_model( models.GetChildByName( "ground_collision_model" ) );
-		if ( ground_collision_model.IsArray() )
-		{
-			LOGV( "loading ground collision model.." );
+		surfaceDef.surfaceName = name;
+		surfaceDef.cullingBounds = surface.bounds;
 
-			while ( !ground_collision_model.IsEndOfArray() )
+		if ( outModelGeo != NULL )
+		{
+			const TriangleIndex indexOffset = static_cast<TriangleIndex>( (*outModelGeo).positions.GetSize() );
+			const Vector3f * positions = (const Vector3f *)vertices;
+			for ( UInt32 i = 0; i < surface.numVertices; ++i )
 			{
-				const UPInt index = model.GroundCollisions.Polytopes.AllocBack();
-
-				const JsonReader polytope( ground_collision_model.GetNextArrayElement() );
-				if ( polytope.IsObject() )
-				{
-					model.GroundCollisions.Polytopes[index].Name = polytope.GetChildStringByName( "name" );
-					StringUtils::StringTo( model.GroundCollisions.Polytopes[index].Planes, polytope.GetChildStringByName( "planes" ).ToCStr() );
-				}
+				(*outModelGeo).positions.PushBack( positions[i] );
+			}
+			const TriangleIndex * triangles = (const TriangleIndex *)indices;
+			for ( UInt32 i = 0; i < surface.numIndices; ++i )
+			{
+				(*outModelGeo).indices.PushBack( triangles[i] + indexOffset );
 			}
 		}
 
-		//
-		// Ray-Trace Model
-		//
+		surfaceDef.geo.Create( attribFlags, surface.numVertices, vertices, surface.numIndices, (const TriangleIndex *)indices );
 
-		const JsonReader raytrace_model( models.GetChildByName( "raytrace_model" ) );
-		if ( raytrace_model.IsObject() )
+		// surfaces without vertices are treated as skinned, the same as from models.json
+		const int skinnedFlags = VERTEX_ATTRIB_FLAG_JOINT_INDICES | VERTEX_ATTRIB_FLAG_JOINT_WEIGHTS;
+		const bool skinned = ( surface.numVertices == 0 || ( attribFlags & skinnedFlags ) == skinnedFlags );
+		const int textureIndices[SURFACE_TEXTURE_MAX] =
 		{
-			LOGV( "loading ray-trace model.." );
+			surface.textures[SURFACE_TEXTURE_DIFFUSE],
+			surface.textures[SURFACE_TEXTURE_EMISSIVE],
+			surface.textures[SURFACE_TEXTURE_NORMAL],
+			surface.textures[SURFACE_TEXTURE_SPECULAR],
+			surface.textures[SURFACE_TEXTURE_REFLECTION]
+		};
+
+		SetupSurfaceMaterial( surfaceDef, surface.materialType, textureIndices, glTextures,
+								skinned, ( attribFlags & VERTEX_ATTRIB_FLAG_COLOR ) != 0, programs, materialParms );
+	}
 
-			ModelTrace &traceModel = model.TraceModel;
+	//
+	// Collision Models
+	//
 
-			traceModel.header.numVertices	= raytrace_model.GetChildInt32ByName( "numVertices" );
-			traceModel.header.numUvs		= raytrace_model.GetChildInt32ByName( "numUvs" );
-			traceModel.header.numIndices	= raytrace_model.GetChildInt32ByName( "numIndices" );
-			traceModel.header.numNodes		= raytrace_model.GetChildInt32ByName( "numNodes" );
-			traceModel.header.numLeafs		= raytrace_model.GetChildInt32ByName( "numLeafs" );
-			traceModel.header.numOverflow	= raytrace_model.GetChildInt32ByName( "numOverflow" );
-			if ( !traceModel.Validate( true ) )
-			{
-				// this is a fatal error so that a model file from an untrusted source is never able to cause out-of-bounds reads.
-				FAIL( "Invalid model data" );
-			}
+	LoadModelBinaryCollision( reader, MODEL_SECTION_COLLISION, model.Collisions );
+	LoadModelBinaryCollision( reader, MODEL_SECTION_GROUND_COLLISION, model.GroundCollisions );
 
-			StringUtils::StringTo( traceModel.header.bounds, raytrace_model.GetChildStringByName( "bounds" ).ToCStr() );
+	//
+	// Ray-Trace Model
+	//
 
-			ReadModelArray( traceModel.vertices, raytrace_model.GetChildStringByName( "vertices" ).ToCStr(), bin, traceModel.header.numVertices );
-			ReadModelArray( traceModel.uvs, raytrace_model.GetChildStringByName( "uvs" ).ToCStr(), bin, traceModel.header.numUvs );
-			ReadModelArray( traceModel.indices, raytrace_model.GetChildStringByName( "indices" ).ToCStr(), bin, traceModel.header.numIndices );
+	int numTraces = 0;
+	const modelBinaryTrace_t * trace = reader.GetRecords< modelBinaryTrace_t >( MODEL_SECTION_TRACE, numTraces );
+	if ( numTraces > 0 )
+	{
+		ModelTrace & traceModel = model.TraceModel;
 
-			if ( !bin.ReadArray( traceModel.nodes, traceModel.header.numNodes ) )
-			{
-				const JsonReader nodes_array( raytrace_model.GetChildByName( "nodes" ) );
-				if ( nodes_array.IsArray() )
-				{
-					while ( !nodes_array.IsEndOfArray() )
-					{
-						const UPInt index = traceModel.nodes.AllocBack();
-
-						const JsonReader node( nodes_array.GetNextArrayElement() );
-						if ( node.IsObject() )
-						{
-							traceModel.nodes[index].data = (UInt32) node.GetChildInt64ByName( "data" );
-							traceModel.nodes[index].dist = node.GetChildFloatByName( "dist" );
-						}
-					}
-				}
-			}
+		traceModel.header = trace->header;
 
-			if ( !bin.ReadArray( traceModel.leafs, traceModel.header.numLeafs ) )
-			{
-				const JsonReader leafs_array( raytrace_model.GetChildByName( "leafs" ) );
-				if ( leafs_array.IsArray() )
-				{
-					while ( !leafs_array.IsEndOfArray() )
-					{
-						const UPInt index = traceModel.leafs.AllocBack();
-
-						const JsonReader leaf( leafs_array.GetNextArrayElement() );
-						if ( leaf.IsObject() )
-						{
-							StringUtils::StringTo( traceModel.leafs[index].triangles, RT_KDTREE_MAX_LEAF_TRIANGLES, leaf.GetChildStringByName( "triangles" ).ToCStr() );
-							StringUtils::StringTo( traceModel.leafs[index].ropes, 6, leaf.GetChildStringByName( "ropes" ).ToCStr() );
-							StringUtils::StringTo( traceModel.leafs[index].bounds, leaf.GetChildStringByName( "bounds" ).ToCStr() );
-						}
-					}
-				}
-			}
+		bool valid = true;
+		valid &= reader.ReadBlobArray( traceModel.vertices, trace->vertexOffset, traceModel.header.numVertices );
+		valid &= reader.ReadBlobArray( traceModel.uvs, trace->uvOffset, traceModel.header.numUvs );
+		valid &= reader.ReadBlobArray( traceModel.indices, trace->indexOffset, traceModel.header.numIndices );
+		valid &= reader.ReadBlobArray( traceModel.nodes, trace->nodeOffset, traceModel.header.numNodes );
+		valid &= reader.ReadBlobArray( traceModel.leafs, trace->leafOffset, traceModel.header.numLeafs );
+		valid &= reader.ReadBlobArray( traceModel.overflow, trace->overflowOffset, traceModel.header.numOverflow );
 
-			ReadModelArray( traceModel.overflow, raytrace_model.GetChildStringByName( "overflow" ).ToCStr(), bin, traceModel.header.numOverflow );
+		if ( !valid || !traceModel.Validate( true ) )
+		{
+			// this is a fatal error so that a model file from an untrusted source is never able to cause out-of-bounds reads.
+			FAIL( "Invalid model data" );
 		}
 	}
-	json->Release();
-
-	if ( !bin.IsAtEnd() )
-	{
-		WARN( "failed to properly read binary file" );
-	}
 }
 
-static ModelFile * LoadModelFile( unzFile zfp, const char * fileName,
-								const char * fileData, const int fileDataLength,
-								const ModelGlPrograms & programs,
-								const MaterialParms & materialParms,
-								ModelGeo * outModelGeo = NULL )
+// Builds a binary model file in memory.
+class ModelBinaryWriter
 {
-	LOGCPUTIME( "LoadModelFile" );
-
-	ModelFile * modelPtr = new ModelFile;
-	ModelFile & model = *modelPtr;
+public:
+	ModelBinaryWriter()
+	{
+		for ( int i = 0; i < MODEL_SECTION_MAX; i++ )
+		{
+			Counts[i] = 0;
+		}
+		// offset 0 is the empty string
+		AddString( "" );
+	}
 
-	model.FileName = fileName;
-	model.UsingSrgbTextures = materialParms.UseSrgbTextureFormats;
+	UInt32 AddString( const char * string )
+	{
+		const UInt32 offset = (UInt32)Sections[MODEL_SECTION_STRINGS].GetSize();
+		Append( MODEL_SECTION_STRINGS, string, strlen( string ) + 1 );
+		Counts[MODEL_SECTION_STRINGS] = Sections[MODEL_SECTION_STRINGS].GetSize();
+		return offset;
+	}
 
-	if ( !zfp )
+	UInt32 AddBlob( const void * data, const size_t size )
 	{
-		WARN( "Error: can't load %s", fileName );
-		return modelPtr;
+		Align( MODEL_SECTION_BLOBS );
+		const UInt32 offset = (UInt32)Sections[MODEL_SECTION_BLOBS].GetSize();
+		Append( MODEL_SECTION_BLOBS, data, size );
+		Counts[MODEL_SECTION_BLOBS] = Sections[MODEL_SECTION_BLOBS].GetSize();
+		return offset;
 	}
 
-	// load all texture files and locate the model files
+	template< typename _type_ >
+	UInt32 AddBlobArray( const Array< _type_ > & array )
+	{
+		return AddBlob( array.GetDataPtr(), array.GetSize() * sizeof( _type_ ) );
+	}
 
-	const char * modelsJson = NULL;
-	int modelsJsonLength = 0;
+	template< typename _type_ >
+	void AddRecord( const int section, const _type_ & record )
+	{
+		OVR_ASSERT( ModelBinaryRecordSize[section] == sizeof( _type_ ) );
+		Append( section, &record, sizeof( record ) );
+		Counts[section]++;
+	}
 
-	const char * modelsBin = NULL;
-	int modelsBinLength = 0;
+	int GetCount( const int section ) const { return Counts[section]; }
 
-	for ( int ret = unzGoToFirstFile( zfp ); ret == UNZ_OK; ret = unzGoToNextFile( zfp ) )
+	bool Write( const char * fileName, int & fileSize ) const
 	{
-		unz_file_info finfo;
-		char entryName[256];
-		unzGetCurrentFileInfo( zfp, &finfo, entryName, sizeof( entryName ), NULL, 0, NULL, 0 );
-		LOGV( "zip level: %ld, file: %s", finfo.compression_method, entryName );
+		Array< UByte > file;
+		file.Resize( sizeof( modelBinaryHeader_t ) + MODEL_SECTION_MAX * sizeof( modelBinarySection_t ) );
 
-		if ( unzOpenCurrentFile( zfp ) != UNZ_OK )
+		modelBinarySection_t sections[MODEL_SECTION_MAX];
+		for ( int i = 0; i < MODEL_SECTION_MAX; i++ )
 		{
-			WARN( "Failed to open %s from %s", entryName, fileName );
-			continue;
-		}
-		
-		const int size = finfo.uncompressed_size;
-		char * buffer = NULL;
+			file.Resize( ( file.GetSize() + MODEL_BINARY_ALIGNMENT - 1 ) & ~( MODEL_BINARY_ALIGNMENT - 1 ) );
 
-		if ( finfo.compression_method == 0 && fileData != NULL )
-		{
-			buffer = (char *)fileData + unzGetCurrentFileZStreamPos64( zfp );
-		}
-		else
-		{
-			buffer = new char[size + 1];
-			buffer[size] = '\0';	// always zero terminate text files
+			sections[i].type = i;
+			sections[i].count = Counts[i];
+			sections[i].offset = (UInt32)file.GetSize();
+			sections[i].size = (UInt32)Sections[i].GetSize();
 
-			if ( unzReadCurrentFile( zfp, buffer, size ) != size )
+			file.Resize( file.GetSize() + Sections[i].GetSize() );
+			if ( Sections[i].GetSize() > 0 )
 			{
-				WARN( "Failed to read %s from %s", entryName, fileName );
-				delete [] buffer;
-				continue;
+				memcpy( &file[sections[i].offset], Sections[i].GetDataPtr(), Sections[i].GetSize() );
 			}
 		}
 
-		// assume a 3 character extension
-		const size_t entryLength = strlen( entryName );
-		const char * extension = ( entryLength >= 4 ) ? &entryName[entryLength - 4] : entryName;
+		modelBinaryHeader_t header;
+		header.magic = MODEL_BINARY_MAGIC;
+		header.version = MODEL_BINARY_VERSION;
+		header.fileSize = (UInt32)file.GetSize();
+		header.numSections = MODEL_SECTION_MAX;
+
+		memcpy( &file[0], &header, sizeof( header ) );
+		memcpy( &file[sizeof( header )], sections, sizeof( sections ) );
 
-		if ( OVR_stricmp( entryName, "models.json" ) == 0 )
+		FILE * f = fopen( fileName, "wb" );
+		if ( f == NULL )
 		{
-			// save this for parsing
-			modelsJson = (const char *)buffer;
-			modelsJsonLength = size;
-			buffer = NULL;	// don't free it now
+			WARN( "Failed to open %s for writing", fileName );
+			return false;
 		}
-		else if ( OVR_stricmp( entryName, "models.bin" ) == 0 )
+		const bool written = ( fwrite( file.GetDataPtr(), file.GetSize(), 1, f ) == 1 );
+		fclose( f );
+
+		fileSize = file.GetSizeI();
+		return written;
+	}
+
+private:
+	Array< UByte >	Sections[MODEL_SECTION_MAX];
+	UInt32			Counts[MODEL_SECTION_MAX];
+
+	void Append( const int section, const void * data, const size_t size )
+	{
+		const size_t offset = Sections[section].GetSize();
+		Sections[section].Resize( offset + size );
+		if ( size > 0 )
 		{
-			// save this for parsing
-			modelsBin = (const char *)buffer;
-			modelsBinLength = size;
-			buffer = NULL;	// don't free it now
+			memcpy( &Sections[section][offset], data, size );
 		}
-		else if (	OVR_stricmp( extension, ".pvr" ) == 0 ||
-					OVR_stricmp( extension, ".ktx" ) == 0 )
+	}
+
+	void Align( const int section )
+	{
+		const size_t size = Sections[section].GetSize();
+		const size_t aligned = ( size + MODEL_BINARY_ALIGNMENT - 1 ) & ~( MODEL_BINARY_ALIGNMENT - 1 );
+		const UByte zero[MODEL_BINARY_ALIGNMENT] = { 0 };
+		Append( section, zero, aligned - size );
+	}
+};
+
+static void AddModelBinaryCollision( ModelBinaryWriter & writer, const int section, const ModelCollision & collision )
+{
+	for ( int i = 0; i < collision.Polytopes.GetSizeI(); i++ )
+	{
+		const CollisionPolytope & polytope = collision.Polytopes[i];
+
+		modelBinaryPolytope_t record;
+		record.name = writer.AddString( polytope.Name.ToCStr() );
+		record.firstPlane = writer.GetCount( MODEL_SECTION_PLANES );
+		record.numPlanes = polytope.Planes.GetSizeI();
+		writer.AddRecord( section, record );
+
+		for ( int j = 0; j < polytope.Planes.GetSizeI(); j++ )
 		{
-			// only support .pvr and .ktx containers for now
-			LoadModelFileTexture( model, entryName, buffer, size, materialParms );
+			writer.AddRecord( MODEL_SECTION_PLANES, polytope.Planes[j] );
 		}
-		else
+	}
+}
+
+// Writes a binary model file from a model that was parsed from models.json and
+// the texture images from the same zip file.
+static bool WriteModelFileBinary( const char * fileName, const ModelFile & model, const modelRenderData_t & renderData,
+						const Array< modelZipEntry_t > & entries, int & fileSize )
+{
+	ModelBinaryWriter writer;
+
+	for ( int i = 0; i < entries.GetSizeI(); i++ )
+	{
+		const modelZipEntry_t & entry = entries[i];
+		if ( !entry.valid || !IsModelTextureFile( entry.name ) )
 		{
-			// ignore other files
-			LOG( "Ignoring %s", entryName );
+			continue;
 		}
 
-		if ( buffer < fileData || buffer > fileData + fileDataLength )
+		modelBinaryImage_t record;
+		record.name = writer.AddString( entry.name );
+		record.offset = writer.AddBlob( entry.buffer, entry.size );
+		record.size = entry.size;
+		writer.AddRecord( MODEL_SECTION_IMAGES, record );
+	}
+
+	for ( int i = 0; i < renderData.textures.GetSizeI(); i++ )
+	{
+		modelBinaryTexture_t record;
+		record.name = writer.AddString( renderData.textures[i].name.ToCStr() );
+		record.usage = renderData.textures[i].usage;
+		writer.AddRecord( MODEL_SECTION_TEXTURES, record );
+	}
+
+	for ( int i = 0; i < model.Joints.GetSizeI(); i++ )
+	{
+		const ModelJoint & joint = model.Joints[i];
+
+		modelBinaryJoint_t record;
+		record.name = writer.AddString( joint.name.ToCStr() );
+		record.animation = joint.animation;
+		record.transform = joint.transform;
+		record.parameters = joint.parameters;
+		record.timeOffset = joint.timeOffset;
+		record.timeScale = joint.timeScale;
+		writer.AddRecord( MODEL_SECTION_JOINTS, record );
+	}
+
+	for ( int i = 0; i < model.Tags.GetSizeI(); i++ )
+	{
+		const ModelTag & tag = model.Tags[i];
+
+		modelBinaryTag_t record;
+		record.name = writer.AddString( tag.name.ToCStr() );
+		record.matrix = tag.matrix;
+		record.jointIndices = tag.jointIndices;
+		record.jointWeights = tag.jointWeights;
+		writer.AddRecord( MODEL_SECTION_TAGS, record );
+	}
+
+	Array< uint8_t > packed;
+	for ( int i = 0; i < renderData.surfaces.GetSizeI(); i++ )
+	{
+		const modelSurfaceData_t & surface = renderData.surfaces[i];
+
+		PackVertexAttribs( packed, surface.attribs );
+
+		modelBinarySurface_t record;
+		record.name = writer.AddString( surface.name.ToCStr() );
+		record.materialType = surface.materialType;
+		for ( int j = 0; j < SURFACE_TEXTURE_MAX; j++ )
 		{
-			delete [] buffer;
+			record.textures[j] = surface.textures[j];
 		}
+		record.bounds = surface.bounds;
+		record.attribFlags = GetVertexAttribFlags( surface.attribs );
+		record.numVertices = surface.attribs.position.GetSizeI();
+		record.vertexOffset = writer.AddBlobArray( packed );
+		record.numIndices = surface.indices.GetSizeI();
+		record.indexOffset = writer.AddBlobArray( surface.indices );
+		writer.AddRecord( MODEL_SECTION_SURFACES, record );
+	}
+
+	AddModelBinaryCollision( writer, MODEL_SECTION_COLLISION, model.Collisions );
+	AddModelBinaryCollision( writer, MODEL_SECTION_GROUND_COLLISION, model.GroundCollisions );
 
-		unzCloseCurrentFile( zfp );
+	const ModelTrace & traceModel = model.TraceModel;
+	if ( traceModel.nodes.GetSizeI() > 0 )
+	{
+		modelBinaryTrace_t record;
+		record.header = traceModel.header;
+		record.vertexOffset = writer.AddBlobArray( traceModel.vertices );
+		record.uvOffset = writer.AddBlobArray( traceModel.uvs );
+		record.indexOffset = writer.AddBlobArray( traceModel.indices );
+		record.nodeOffset = writer.AddBlobArray( traceModel.nodes );
+		record.leafOffset = writer.AddBlobArray( traceModel.leafs );
+		record.overflowOffset = writer.AddBlobArray( traceModel.overflow );
+		writer.AddRecord( MODEL_SECTION_TRACE, record );
 	}
-	unzClose( zfp );
 
-	if ( modelsJson != NULL )
+	return writer.Write( fileName, fileSize );
+}
+
+static bool ConvertModelFileToBinary( unzFile zfp, const char * srcFileName,
+								const char * fileData, const int fileDataLength,
+								const char * dstFileName )
+{
+	LOGCPUTIME( "ConvertModelFileToBinary" );
+
+	if ( !zfp )
+	{
+		WARN( "Error: can't load %s", srcFileName );
+		return false;
+	}
+
+	Array< modelZipEntry_t > entries;
+	ReadModelZipEntries( zfp, srcFileName, fileData, entries );
+
+	modelParseJob_t parseJob;
+	FindModelZipEntries( entries, srcFileName, parseJob.text, parseJob.textLength, parseJob.bin, parseJob.binLength );
+	if ( parseJob.text == NULL )
 	{
-		LoadModelFileJson( model,
-							modelsJson, modelsJsonLength,
-							modelsBin, modelsBinLength,
-							programs, materialParms, outModelGeo );
+		WARN( "No models.json in %s", srcFileName );
+		FreeModelZipEntries( entries );
+		return false;
 	}
 
-	if ( modelsJson < fileData || modelsJson > fileData + fileDataLength )
+	ModelFile model( srcFileName );
+	parseJob.model = &model;
+	ParseModelJsonThread( NULL, &parseJob );
+
+	bool converted = false;
+	if ( !parseJob.parsed )
 	{
-		delete modelsJson;
+		WARN( "LoadModelFileJson: Error loading %s : %s", srcFileName, parseJob.error );
 	}
-	if ( modelsBin < fileData || modelsBin > fileData + fileDataLength )
+	else
 	{
-		delete modelsBin;
+		int fileSize = 0;
+		converted = WriteModelFileBinary( dstFileName, model, parseJob.renderData, entries, fileSize );
+		if ( converted )
+		{
+			LOG( "Converted %s (%d bytes) to %s (%d bytes)", srcFileName, fileDataLength, dstFileName, fileSize );
+		}
 	}
 
+	FreeModelZipEntries( entries );
+
+	return converted;
+}
+
+static ModelFile * LoadModelFileBinary( const char * fileName,
+								const void * buffer, const int bufferLength,
+								const ModelGlPrograms & programs,
+								const MaterialParms & materialParms,
+								ModelGeo * outModelGeo = NULL )
+{
+	ModelFile * modelPtr = new ModelFile( fileName );
+	modelPtr->UsingSrgbTextures = materialParms.UseSrgbTextureFormats;
+
+	LoadModelFileBinary( *modelPtr, (const UByte *)buffer, bufferLength, programs, materialParms, outModelGeo );
+
 	return modelPtr;
 }
 
@@ -1061,9 +2006,14 @@ ModelFile * LoadModelFileFromMemory( const char * fileName,
 		const MaterialParms & materialParms,
 		ModelGeo * outModelGeo )
 {
-	// Open the .ModelFile file as a zip.
 	LOG( "LoadModelFileFromMemory %s %i", fileName, bufferLength );
 
+	if ( IsModelFileBinary( buffer, bufferLength ) )
+	{
+		return LoadModelFileBinary( fileName, buffer, bufferLength, programs, materialParms, outModelGeo );
+	}
+
+	// Open the .ModelFile file as a zip.
 	zlib_mmap_opaque zlib_opaque;
 
 	mem_set_opaque( zlib_opaque, (const unsigned char *)buffer, bufferLength );
@@ -1093,6 +2043,12 @@ ModelFile * LoadModelFile( const char * fileName,
 		return new ModelFile( fileName );
 	}
 
+	// Binary model files are used straight from the mapping.
+	if ( IsModelFileBinary( zlib_opaque.data, zlib_opaque.len ) )
+	{
+		return LoadModelFileBinary( fileName, zlib_opaque.data, zlib_opaque.len, programs, materialParms );
+	}
+
 	unzFile zfp = open_opaque( zlib_opaque, fileName );
 	if ( !zfp )
 	{
@@ -1102,6 +2058,31 @@ ModelFile * LoadModelFile( const char * fileName,
 	return LoadModelFile( zfp, fileName, (char *)zlib_opaque.data, zlib_opaque.len, programs, materialParms );
 }
 
+bool ConvertModelFileToBinary( const char * srcFileName, const char * dstFileName )
+{
+	zlib_mmap_opaque zlib_opaque;
+
+	if ( !mmap_open_opaque( srcFileName, zlib_opaque ) )
+	{
+		return false;
+	}
+
+	unzFile zfp = open_opaque( zlib_opaque, srcFileName );
+
+	return ConvertModelFileToBinary( zfp, srcFileName, (char *)zlib_opaque.data, zlib_opaque.len, dstFileName );
+}
+
+bool ConvertModelFileToBinary( const char * srcFileName, const void * buffer, const int bufferLength, const char * dstFileName )
+{
+	zlib_mmap_opaque zlib_opaque;
+
+	mem_set_opaque( zlib_opaque, (const unsigned char *)buffer, bufferLength );
+
+	unzFile zfp = open_opaque( zlib_opaque, srcFileName );
+
+	return ConvertModelFileToBinary( zfp, srcFileName, (const char *)buffer, bufferLength, dstFileName );
+}
+
 #else	// !MEMORY_MAPPED
 
 struct mzBuffer_t
@@ -1178,9 +2159,14 @@ ModelFile * LoadModelFileFromMemory( const char * fileName,
 		const ModelGlPrograms & programs,
 		const MaterialParms & materialParms )
 {
-	// Open the .ModelFile file as a zip.
 	LOG( "LoadModelFileFromMemory %s %i", fileName, bufferLength );
 
+	if ( IsModelFileBinary( buffer, bufferLength ) )
+	{
+		return LoadModelFileBinary( fileName, buffer, bufferLength, programs, materialParms );
+	}
+
+	// Open the .ModelFile file as a zip.
 	mzBuffer_t mzBuffer;
 	mzBuffer.mzBufferBase = (unsigned char *)buffer;
 	mzBuffer.mzBufferLength = bufferLength;
@@ -1211,12 +2197,100 @@ ModelFile * LoadModelFile( const char * fileName,
 	return LoadModelFile( zfp, fileName, NULL, 0, programs, materialParms );
 }
 
+bool ConvertModelFileToBinary( const char * srcFileName, const char * dstFileName )
+{
+	unzFile zfp = unzOpen( srcFileName );
+	return ConvertModelFileToBinary( zfp, srcFileName, NULL, 0, dstFileName );
+}
+
+bool ConvertModelFileToBinary( const char * srcFileName, const void * buffer, const int bufferLength, const char * dstFileName )
+{
+	mzBuffer_t mzBuffer;
+	mzBuffer.mzBufferBase = (unsigned char *)buffer;
+	mzBuffer.mzBufferLength = bufferLength;
+	mzBuffer.mzBufferPos = 0;
+
+	zlib_filefunc_def filefunc;
+	filefunc.zopen_file = mz_open_file_func;
+	filefunc.zread_file = mz_read_file_func;
+	filefunc.zwrite_file = mz_write_file_func;
+	filefunc.ztell_file = mz_tell_file_func;
+	filefunc.zseek_file = mz_seek_file_func;
+	filefunc.zclose_file = mz_close_file_func;
+	filefunc.zerror_file = mz_testerror_file_func;
+	filefunc.opaque = &mzBuffer;
+
+	unzFile zfp = unzOpen2( srcFileName, &filefunc );
+
+	return ConvertModelFileToBinary( zfp, srcFileName, NULL, 0, dstFileName );
+}
+
 #endif	// MEMORY_MAPPED
 
+//-----------------------------------------------------------------------------
+//	Binary model file cache
+//-----------------------------------------------------------------------------
+
+// Zipped model files from application packages are converted to binary model files
+// in the package cache folder the first time they are loaded, so later loads only
+// map the binary file.  The cached files are named by the CRC of the zipped model
+// file, the same way the package cache names its files.
+static bool GetModelFileCacheName( void * zipFile, const char * nameInZip, char * cacheName, const int cacheNameSize )
+{
+#if defined( OVR_OS_ANDROID )
+	const char * cachePath = ovr_GetApplicationPackageCachePath();
+	uint32_t crc = 0;
+	if ( cachePath[0] != '\0' && ovr_GetFileCrcFromOtherApplicationPackage( zipFile, nameInZip, crc ) )
+	{
+		OVR_sprintf( cacheName, cacheNameSize, "%s/%08x.v%d.ovrm", cachePath, (unsigned)crc, MODEL_BINARY_VERSION );
+		return true;
+	}
+#endif
+	return false;
+}
+
+// Converts to a temporary file first, so a partially written binary file is never used.
+static bool WriteCachedModelFile( const char * nameInZip, const void * buffer, const int bufferLength, const char * cacheName )
+{
+	char tempName[1024];
+	OVR_sprintf( tempName, sizeof( tempName ), "%s.%x.tmp", cacheName, (unsigned)(UPInt)GetCurrentThreadId() );
+	if ( !ConvertModelFileToBinary( nameInZip, buffer, bufferLength, tempName ) )
+	{
+		remove( tempName );
+		return false;
+	}
+	if ( rename( tempName, cacheName ) != 0 )
+	{
+		WARN( "Failed to rename %s to %s", tempName, cacheName );
+		remove( tempName );
+		return false;
+	}
+	return true;
+}
+
 ModelFile * LoadModelFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip,
 									const ModelGlPrograms & programs,
 									const MaterialParms & materialParms )
 {
+	char cacheName[1024];
+	const bool cached = GetModelFileCacheName( zipFile, nameInZip, cacheName, sizeof( cacheName ) );
+	if ( cached && access( cacheName, R_OK ) == 0 )
+	{
+		return LoadModelFile( cacheName, programs, materialParms );
+	}
+
+	// Model files stored without compression are loaded straight from the mapped package.
+	const void *	mapped;
+	int				mappedLength;
+	if ( ovr_MapFileFromOtherApplicationPackage( zipFile, nameInZip, mappedLength, mapped ) )
+	{
+		if ( cached && WriteCachedModelFile( nameInZip, mapped, mappedLength, cacheName ) )
+		{
+			return LoadModelFile( cacheName, programs, materialParms );
+		}
+		return LoadModelFileFromMemory( nameInZip, mapped, mappedLength, programs, materialParms );
+	}
+
 	void * 	buffer;
 	int		bufferLength;
 
@@ -1227,6 +2301,12 @@ ModelFile * LoadModelFileFromOtherApplicationPackage( void * zipFile, const char
 		return NULL;
 	}
 
+	if ( cached && WriteCachedModelFile( nameInZip, buffer, bufferLength, cacheName ) )
+	{
+		free( buffer );
+		return LoadModelFile( cacheName, programs, materialParms );
+	}
+
 	ModelFile * scene = LoadModelFileFromMemory( nameInZip,
 				buffer, bufferLength,
 				programs, materialParms );
@@ -162,6 +162,7 @@ struct ModelGeo
 
 // Pass in the programs that will be used for the model materials.
 // Obviously not very general purpose.
+// Both zipped model files and binary model files are accepted.
 ModelFile * LoadModelFileFromMemory( const char * fileName,
 		const void * buffer, int bufferLength,
 		const ModelGlPrograms & programs,
@@ -173,6 +174,8 @@ ModelFile * LoadModelFile( const char * fileName,
 		const MaterialParms & materialParms );
 
 // Returns NULL if the file is not found.
+// When the package cache folder is set, a zipped model file is converted to a binary
+// model file in that folder on first use, and later loads map the binary file.
 ModelFile * LoadModelFileFromOtherApplicationPackage( void * zipFile, const char * nameInZip,
 		const ModelGlPrograms & programs, const MaterialParms & materialParms );
 
@@ -182,6 +185,12 @@ ModelFile * LoadModelFileFromApplicationPackage( const char * nameInZip,
 ModelFile * LoadModelFile( class ovrFileSys & fileSys, const char * uri, 
 		const ModelGlPrograms & programs, const MaterialParms & materialParms );
 
+// Converts a zipped model file with models.json, models.bin and textures into a
+// single binary model file that can be memory mapped and loaded without inflating
+// or parsing anything. Does not issue any GL calls. Returns false on failure.
+bool ConvertModelFileToBinary( const char * srcFileName, const char * dstFileName );
+bool ConvertModelFileToBinary( const char * srcFileName, const void * buffer, const int bufferLength, const char * dstFileName );
+
 } // namespace OVR
 
 #endif	// MODELFILE_H
@@ -12,7 +12,8 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "ModelRender.h"
 
 #include <stdlib.h>
-#include <algorithm>
+#include <string.h>
+#include "Kernel/OVR_Alg.h"
 #include "Kernel/OVR_GlUtils.h"
 #include "Kernel/OVR_LogUtils.h"
 
@@ -22,167 +23,104 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 namespace OVR
 {
 
-// Returns 0 if the bounds is culled by the mvp, otherwise returns the max W
-// value of the bounds corners so it can be sorted into roughly front to back
-// order for more efficient Z cull.  Sorting bounds in increasing order of
-// their farthest W value usually makes characters and objects draw before
-// the environments they are in, and draws sky boxes last, which is what we want.
-static float BoundsSortCullKey( const Bounds3f & bounds, const Matrix4f & mvp )
+static void AddCullCandidate(	ModelSurfaceListBuffers & buffers,
+								const Matrix4f * modelMatrix,
+								const Array< Matrix4f > * joints,
+								const ovrSurfaceDef * surface,
+								const Matrix4f & vpMatrix )
 {
-	// Always cull empty bounds, which can be used to disable a surface.
-	// Don't just check a single axis, or billboards would be culled.
-	if ( bounds.b[1].x == bounds.b[0].x &&  bounds.b[1].y == bounds.b[0].y )
+	const int index = buffers.Candidates.GetSizeI();
+	if ( ( index % MODEL_CULL_BATCH_SIZE ) == 0 )
 	{
-		return 0;
+		buffers.CullBatches.Resize( buffers.CullBatches.GetSize() + 1 );
 	}
+	SetCullBatchSurface( buffers.CullBatches.Back(), index % MODEL_CULL_BATCH_SIZE, surface->cullingBounds, vpMatrix * (*modelMatrix) );
 
-	// Not very efficient code...
-	Vector4f c[8];
-	for ( int i = 0; i < 8; i++ )
-	{
-		Vector4f world;
-		world.x = bounds.b[(i&1)].x;
-		world.y = bounds.b[(i&2)>>1].y;
-		world.z = bounds.b[(i&4)>>2].z;
-		world.w = 1.0f;
+	ovrDrawSurface drawSurf;
+	drawSurf.modelMatrix = modelMatrix;
+	drawSurf.joints = joints;
+	drawSurf.surface = surface;
+	buffers.Candidates.PushBack( drawSurf );
+}
 
-		c[i] = mvp.Transform( world );
-	}
+// Packs the GPU state bits that can differ between opaque surfaces.
+static UInt32 GpuStateSortBits( const ovrGpuState & gpuState )
+{
+	return	( gpuState.depthEnable ? 1 : 0 ) |
+			( gpuState.depthMaskEnable ? 2 : 0 ) |
+			( gpuState.polygonOffsetEnable ? 4 : 0 ) |
+			( gpuState.cullEnable ? 8 : 0 ) |
+			( gpuState.frontFace == GL_CW ? 16 : 0 ) |
+			( ( gpuState.depthFunc & 7 ) << 5 );		// GL_NEVER through GL_ALWAYS
+}
 
-	int i;
-	for ( i = 0; i < 8; i++ )
-	{
-		if ( c[i].x > -c[i].w )
-		{
-			break;
-		}
-	}
-	if ( i == 8 )
-	{
-		return 0;	// all off one side
-	}
-	for ( i = 0; i < 8; i++ )
-	{
-		if ( c[i].x < c[i].w )
-		{
-			break;
-		}
-	}
-	if ( i == 8 )
+// Surfaces that bind the same set of textures will have the same value.
+static UInt32 TextureSetSortBits( const ovrMaterialDef & materialDef )
+{
+	UInt32 hash = 0;
+	for ( int i = 0; i < materialDef.numTextures; i++ )
 	{
-		return 0;	// all off one side
+		hash = hash * 31 + materialDef.textures[i].texture;
 	}
+	return ( hash ^ ( hash >> 16 ) ) & 0xFFFF;
+}
 
-	for ( i = 0; i < 8; i++ )
-	{
-		if ( c[i].y > -c[i].w )
-		{
-			break;
-		}
-	}
-	if ( i == 8 )
-	{
-		return 0;	// all off one side
-	}
-	for ( i = 0; i < 8; i++ )
-	{
-		if ( c[i].y < c[i].w )
-		{
-			break;
-		}
-	}
-	if ( i == 8 )
-	{
-		return 0;	// all off one side
-	}
+// Opaque surfaces sort before transparent ones, and transparent surfaces
+// always sort back-to-front.
+//
+// MODEL_SURFACE_SORT_DEPTH, from most to least significant bit:
+//   1 transparent, 31 far W, 16 program, 16 first texture
+// Opaque surfaces sort front-to-back, and surfaces at the same depth are
+// grouped by program and texture.
+//
+// MODEL_SURFACE_SORT_STATE, for opaque surfaces:
+//   1 transparent, 16 program, 16 texture set, 8 gpuState, 23 far W
+// The far W loses the low bits of the mantissa, which still leaves each
+// state group sorted roughly front-to-back.
+static UInt64 DrawSortKey( const ovrSurfaceDef & surfaceDef, const float farW, const ModelSurfaceSortMode sortMode )
+{
+	// The far W of a visible surface is always positive, and positive floats
+	// sort the same as their bit patterns, so the depth fits in 31 bits
+	// without losing any precision.
+	UInt32 depth;
+	memcpy( &depth, &farW, sizeof( depth ) );
+	depth &= 0x7FFFFFFF;
 
-	for ( i = 0; i < 8; i++ )
-	{
-		if ( c[i].z > -c[i].w )
-		{
-			break;
-		}
-	}
-	if ( i == 8 )
+	const ovrMaterialDef & materialDef = surfaceDef.materialDef;
+	const bool transparent = ( materialDef.gpuState.blendEnable != ovrGpuState::BLEND_DISABLE );
+	if ( transparent )
 	{
-		return 0;	// all off one side
-	}
-	for ( i = 0; i < 8; i++ )
-	{
-		if ( c[i].z < c[i].w )
-		{
-			break;
-		}
-	}
-	if ( i == 8 )
-	{
-		return 0;	// all off one side
+		depth = 0x7FFFFFFF - depth;
 	}
 
-	// calculate the farthest W point for front to back sorting
-	float maxW = 0;
-	for ( i = 0; i < 8; i++ )
-	{
-		const float w = c[i].w;
-		if ( w > maxW )
-		{
-			maxW = w;
-		}
-	}
+	const UInt64 program = materialDef.programObject & 0xFFFF;
 
-	return maxW;		// couldn't cull
-}
-
-struct bsort_t
-{
-	float						key;
-	const Matrix4f * 			modelMatrix;
-	const Array< Matrix4f > *	joints;
-	const ovrSurfaceDef *		surface;
-	bool						transparent;
-
-	bool operator< (const bsort_t& b2) const
+	if ( sortMode == MODEL_SURFACE_SORT_STATE && !transparent )
 	{
-		const bsort_t& b1 = *this;
-		bool trans1 = b1.transparent;
-		bool trans2 = b2.transparent;
-		if ( trans1 == trans2 )
-		{
-			float f1 = b1.key;
-			float f2 = b2.key;
-			if ( !trans1 )
-			{
-				// both are solid, sort front-to-back
-				return ( f1 < f2 );
-			}
-			else
-			{
-				// both are transparent, sort back-to-front
-				return ( f2 < f1 );
-			}
-		}
-		// otherwise, one is solid and one is translucent... the solid is always rendered first
-		return !trans1;
-	};
-};
+		const UInt64 textureSet = TextureSetSortBits( materialDef );
+		const UInt64 gpuState = GpuStateSortBits( materialDef.gpuState );
+		return ( program << 47 ) | ( textureSet << 31 ) | ( gpuState << 23 ) | ( depth >> 8 );
+	}
 
+	const UInt64 texture = ( materialDef.numTextures > 0 ? materialDef.textures[0].texture : 0 ) & 0xFFFF;
 
+	return ( (UInt64)transparent << 63 ) | ( (UInt64)depth << 32 ) | ( program << 16 ) | texture;
+}
 
 void BuildModelSurfaceList(	Array<ovrDrawSurface> & surfaceList,
 							const long long supressModelsWithClientId,
 							const Array<ModelState *> & emitModels,
 							const Array<ovrDrawSurface> & emitSurfaces,
 							const Matrix4f & viewMatrix,
-							const Matrix4f & projectionMatrix )
+							const Matrix4f & projectionMatrix,
+							ModelSurfaceListBuffers & buffers,
+							const ModelSurfaceSortMode sortMode )
 {
-	// A mobile GPU will be in trouble if it draws more than this.
-	static const int MAX_DRAW_SURFACES = 1024;
-	bsort_t	bsort[ MAX_DRAW_SURFACES ];
-
 	const Matrix4f vpMatrix = projectionMatrix * viewMatrix;
 
-	int	numSurfaces = 0;
-	int	cullCount = 0;
+	// Gather all the candidate surfaces first, so they can be culled in batches.
+	buffers.Candidates.Clear();
+	buffers.CullBatches.Clear();
 
 	for ( int modelNum = 0; modelNum < emitModels.GetSizeI(); modelNum++ )
 	{
@@ -195,37 +133,35 @@ void BuildModelSurfaceList(	Array<ovrDrawSurface> & surfaceList,
 		const ModelDef & modelDef = *modelState.modelDef;
 		for ( int surfaceNum = 0; surfaceNum < modelDef.surfaces.GetSizeI(); surfaceNum++ )
 		{
-			const ovrSurfaceDef & surfaceDef = modelDef.surfaces[ surfaceNum ];
-			const float sort = BoundsSortCullKey( surfaceDef.cullingBounds, vpMatrix * modelState.modelMatrix );
-			if ( sort == 0 ) 
-			{
-				if ( LogRenderSurfaces )
-				{
-					LOG( "Culled %s", surfaceDef.surfaceName.ToCStr() );
-				}
-				cullCount++;
-				continue;
-			}
-
-			if ( numSurfaces == MAX_DRAW_SURFACES )
-			{
-				break;
-			}
-
-			bsort[ numSurfaces ].key = sort;
-			bsort[ numSurfaces ].modelMatrix = &modelState.modelMatrix;
-			bsort[ numSurfaces ].joints = &modelState.Joints;
-			bsort[ numSurfaces ].surface = &surfaceDef;
-			bsort[ numSurfaces ].transparent = ( surfaceDef.materialDef.gpuState.blendEnable != ovrGpuState::BLEND_DISABLE );
-			numSurfaces++;
+			AddCullCandidate( buffers, &modelState.modelMatrix, &modelState.Joints, &modelDef.surfaces[ surfaceNum ], vpMatrix );
 		}
 	}
 
 	for ( int i = 0; i < emitSurfaces.GetSizeI(); i++  )
 	{
 		const ovrDrawSurface & drawSurf = emitSurfaces[i];
-		const ovrSurfaceDef & surfaceDef = *drawSurf.surface;
-		const float sort = BoundsSortCullKey( surfaceDef.cullingBounds, vpMatrix * (*drawSurf.modelMatrix) );
+		AddCullCandidate( buffers, drawSurf.modelMatrix, drawSurf.joints, drawSurf.surface, vpMatrix );
+	}
+
+	// Pad out the last batch with empty bounds, which are always culled.
+	for ( int i = buffers.Candidates.GetSizeI(); ( i % MODEL_CULL_BATCH_SIZE ) != 0; i++ )
+	{
+		SetCullBatchSurface( buffers.CullBatches.Back(), i % MODEL_CULL_BATCH_SIZE, Bounds3f( Vector3f( 0.0f ), Vector3f( 0.0f ) ), Matrix4f::Identity() );
+	}
+
+	buffers.CullKeys.Resize( buffers.CullBatches.GetSize() * MODEL_CULL_BATCH_SIZE );
+	for ( int i = 0; i < buffers.CullBatches.GetSizeI(); i++ )
+	{
+		BoundsSortCullKeys( buffers.CullBatches[i], &buffers.CullKeys[i * MODEL_CULL_BATCH_SIZE] );
+	}
+
+	buffers.DrawKeys.Clear();
+	int	cullCount = 0;
+
+	for ( int i = 0; i < buffers.Candidates.GetSizeI(); i++ )
+	{
+		const ovrSurfaceDef & surfaceDef = *buffers.Candidates[i].surface;
+		const float sort = buffers.CullKeys[i];
 		if ( sort == 0 )
 		{
 			if ( LogRenderSurfaces )
@@ -236,34 +172,35 @@ void BuildModelSurfaceList(	Array<ovrDrawSurface> & surfaceList,
 			continue;
 		}
 
-		if ( numSurfaces == MAX_DRAW_SURFACES )
-		{
-			break;
-		}
-
-		bsort[ numSurfaces ].key = sort;
-		bsort[ numSurfaces ].modelMatrix = drawSurf.modelMatrix;
-		bsort[ numSurfaces ].joints = drawSurf.joints;
-		bsort[ numSurfaces ].surface = &surfaceDef;
-		bsort[ numSurfaces ].transparent = ( surfaceDef.materialDef.gpuState.blendEnable != ovrGpuState::BLEND_DISABLE );
-		numSurfaces++;
+		ModelDrawKey drawKey;
+		drawKey.key = DrawSortKey( surfaceDef, sort, sortMode );
+		drawKey.index = i;
+		buffers.DrawKeys.PushBack( drawKey );
 	}
 
+	const int numSurfaces = buffers.DrawKeys.GetSizeI();
+
 	//LOG( "Culled %i, draw %i", cullCount, numSurfaces );
 
-	// sort by the far W and transparency
-	// IMPORTANT: use a stable sort so surfaces with identical bounds
-	// will sort consistently from frame to frame, rather than randomly
-	// as happens with qsort.
-	std::stable_sort( bsort, bsort+numSurfaces );
+	buffers.SortScratch.Resize( numSurfaces );
+	RadixSortDrawKeys( buffers.DrawKeys.GetDataPtr(), buffers.SortScratch.GetDataPtr(), numSurfaces );
 
 	surfaceList.Resize( numSurfaces );
 	for ( int i = 0; i < numSurfaces; i++ ) 
 	{
-		surfaceList[i].modelMatrix = bsort[i].modelMatrix;
-		surfaceList[i].joints = bsort[i].joints;
-		surfaceList[i].surface = bsort[i].surface;
+		surfaceList[i] = buffers.Candidates[buffers.DrawKeys[i].index];
 	}
 }
 
+void BuildModelSurfaceList(	Array<ovrDrawSurface> & surfaceList,
+							const long long supressModelsWithClientId,
+							const Array<ModelState *> & emitModels,
+							const Array<ovrDrawSurface> & emitSurfaces,
+							const Matrix4f & viewMatrix,
+							const Matrix4f & projectionMatrix )
+{
+	ModelSurfaceListBuffers buffers;
+	BuildModelSurfaceList( surfaceList, supressModelsWithClientId, emitModels, emitSurfaces, viewMatrix, projectionMatrix, buffers );
+}
+
 }	// namespace OVR
@@ -19,6 +19,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "GlTexture.h"
 #include "GlGeometry.h"
 #include "SurfaceRender.h"
+#include "ModelCull.h"
 
 namespace OVR
 {
@@ -47,6 +48,30 @@ struct ModelState
 	long long			DontRenderForClientUid;	// skip rendering the model if the current scene's client uid matches this
 };
 
+// Transparent surfaces are always sorted back-to-front, but opaque surfaces
+// can either be sorted purely front-to-back for the best Z cull, or grouped
+// by GPU state to reduce program binds, texture binds and parameter updates,
+// which are often the larger cost on mobile drivers.
+enum ModelSurfaceSortMode
+{
+	MODEL_SURFACE_SORT_DEPTH,		// opaque surfaces sorted front-to-back
+	MODEL_SURFACE_SORT_STATE		// opaque surfaces grouped by program, textures and gpuState, coarsely front-to-back within a group
+};
+
+// Working memory for BuildModelSurfaceList.  If one of these is kept around
+// from frame to frame, the buffers only grow to the high water mark instead
+// of being reallocated on every call.
+struct ModelSurfaceListBuffers
+{
+	typedef ArrayConstPolicy< 0, 16, true > NeverShrinkPolicy;
+
+	ArrayPOD< ovrDrawSurface, NeverShrinkPolicy >	Candidates;
+	ArrayPOD< ModelCullBatch, NeverShrinkPolicy >	CullBatches;
+	ArrayPOD< float, NeverShrinkPolicy >			CullKeys;
+	ArrayPOD< ModelDrawKey, NeverShrinkPolicy >		DrawKeys;
+	ArrayPOD< ModelDrawKey, NeverShrinkPolicy >		SortScratch;
+};
+
 // The model surfaces are culled and added to the sorted surface list.
 // Application specific surfaces from the emit list are also added to the sorted surface list.
 // The surface list is sorted such that opaque surfaces come first, sorted front-to-back,
@@ -58,6 +83,17 @@ void BuildModelSurfaceList(	Array<ovrDrawSurface> & surfaceList,
 							const Matrix4f & viewMatrix,
 							const Matrix4f & projectionMatrix );
 
+// Same as above, but uses buffers that persist across calls and
+// optionally groups the opaque surfaces by state.
+void BuildModelSurfaceList(	Array<ovrDrawSurface> & surfaceList,
+							const long long supressModelsWithClientId,
+							const Array<ModelState *> & emitModels,
+							const Array<ovrDrawSurface> & emitSurfaces,
+							const Matrix4f & viewMatrix,
+							const Matrix4f & projectionMatrix,
+							ModelSurfaceListBuffers & buffers,
+							const ModelSurfaceSortMode sortMode = MODEL_SURFACE_SORT_DEPTH );
+
 } // namespace OVR
 
 #endif	// OVR_ModelRender_h
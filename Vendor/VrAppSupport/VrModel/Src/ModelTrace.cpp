@@ -12,10 +12,19 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "ModelTrace.h"
 
 #include <math.h>
+#include <algorithm>
 
 #include "Kernel/OVR_Alg.h"
 #include "Kernel/OVR_Array.h"
 #include "Kernel/OVR_LogUtils.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Atomic.h"
+
+#if defined( OVR_CPU_SSE )
+#include <xmmintrin.h>
+#elif defined( OVR_CPU_ARM_NEON )
+#include <arm_neon.h>
+#endif
 
 namespace OVR
 {
@@ -40,7 +49,7 @@ bool ModelTrace::Validate( const bool fullVerify ) const
 	invalid |= header.numNodes != nodes.GetSizeI();
 	invalid |= header.numLeafs != leafs.GetSizeI();
 	invalid |= header.numOverflow != overflow.GetSizeI();
-	if ( !invalid )
+	if ( invalid )
 	{
 		LOG( "ModelTrace::Verify - invalid header" );
 		return false;
@@ -77,7 +86,7 @@ bool ModelTrace::Validate( const bool fullVerify ) const
 			}
 		}
 		const int numTris = indices.GetSizeI() / 3;
-		if ( numTris * 3 != indices.GetSizeI() * 3 )
+		if ( numTris * 3 != indices.GetSizeI() )
 		{
 			LOG( "ModelTrace::Verify - Orphaned indices" );
 			return false;
@@ -117,7 +126,8 @@ bool ModelTrace::Validate( const bool fullVerify ) const
 		// verify overflow list doesn't point to any out-of-range triangles
 		for ( int i = 0; i < overflow.GetSizeI(); ++i )
 		{
-			if ( overflow[i] < 0 || overflow[i] >= numTris )
+			// -1 terminates the overflow list of a leaf
+			if ( overflow[i] < -1 || overflow[i] >= numTris )
 			{
 				LOG( "ModelTrace::Verify - overflow index %i value %i is out of range, max %i", i, overflow[i], numTris - 1 );
 				return false;
@@ -369,4 +379,904 @@ traceResult_t ModelTrace::Trace_Exhaustive( const Vector3f & start, const Vector
 	return result;
 }
 
+/*
+
+	Ray packets are traced four at a time. Each ray in a packet still walks its own
+	path through the tree, but all rays that are in the same leaf are intersected
+	with the leaf triangles together. The results are the same as those of Trace().
+
+*/
+
+const int RT_TRACE_PACKET_SIZE	= 4;
+
+struct traceRayPacket_t
+{
+	float	startX[RT_TRACE_PACKET_SIZE];
+	float	startY[RT_TRACE_PACKET_SIZE];
+	float	startZ[RT_TRACE_PACKET_SIZE];
+	float	dirX[RT_TRACE_PACKET_SIZE];
+	float	dirY[RT_TRACE_PACKET_SIZE];
+	float	dirZ[RT_TRACE_PACKET_SIZE];
+};
+
+struct traceRayHits_t
+{
+	float	det[RT_TRACE_PACKET_SIZE];
+	float	s[RT_TRACE_PACKET_SIZE];
+	float	t[RT_TRACE_PACKET_SIZE];
+	float	d[RT_TRACE_PACKET_SIZE];
+};
+
+struct traceRayLane_t
+{
+	Vector3f				start;
+	Vector3f				rayDelta;
+	Vector3f				rayDir;
+	float					rayLengthRcp;
+	float					rcpRayDirX;
+	float					rcpRayDirY;
+	float					rcpRayDirZ;
+	float					entryDistance;
+	float					bestDistance;
+	Vector2f				uv;
+	const kdtree_node_t *	currentNode;
+	int						iterations;
+	bool					active;
+};
+
+// Intersects all rays in the packet with a single triangle, in the same order of operations
+// as Intersect_RayTriangle(). Returns a bit mask with the rays that hit the triangle, and the
+// values for the hits are divided by the determinant in IntersectRayPacketHit().
+#if defined( OVR_CPU_SSE )
+
+static int IntersectRayPacketTriangle( const traceRayPacket_t & packet, const Vector3f & v0,
+										const Vector3f & edge1, const Vector3f & edge2, traceRayHits_t & hits )
+{
+	const __m128 startX = _mm_loadu_ps( packet.startX );
+	const __m128 startY = _mm_loadu_ps( packet.startY );
+	const __m128 startZ = _mm_loadu_ps( packet.startZ );
+	const __m128 dirX = _mm_loadu_ps( packet.dirX );
+	const __m128 dirY = _mm_loadu_ps( packet.dirY );
+	const __m128 dirZ = _mm_loadu_ps( packet.dirZ );
+
+	const __m128 e1X = _mm_set1_ps( edge1.x );
+	const __m128 e1Y = _mm_set1_ps( edge1.y );
+	const __m128 e1Z = _mm_set1_ps( edge1.z );
+	const __m128 e2X = _mm_set1_ps( edge2.x );
+	const __m128 e2Y = _mm_set1_ps( edge2.y );
+	const __m128 e2Z = _mm_set1_ps( edge2.z );
+
+	const __m128 tvX = _mm_sub_ps( startX, _mm_set1_ps( v0.x ) );
+	const __m128 tvY = _mm_sub_ps( startY, _mm_set1_ps( v0.y ) );
+	const __m128 tvZ = _mm_sub_ps( startZ, _mm_set1_ps( v0.z ) );
+
+	const __m128 pvX = _mm_sub_ps( _mm_mul_ps( dirY, e2Z ), _mm_mul_ps( dirZ, e2Y ) );
+	const __m128 pvY = _mm_sub_ps( _mm_mul_ps( dirZ, e2X ), _mm_mul_ps( dirX, e2Z ) );
+	const __m128 pvZ = _mm_sub_ps( _mm_mul_ps( dirX, e2Y ), _mm_mul_ps( dirY, e2X ) );
+
+	const __m128 qvX = _mm_sub_ps( _mm_mul_ps( tvY, e1Z ), _mm_mul_ps( tvZ, e1Y ) );
+	const __m128 qvY = _mm_sub_ps( _mm_mul_ps( tvZ, e1X ), _mm_mul_ps( tvX, e1Z ) );
+	const __m128 qvZ = _mm_sub_ps( _mm_mul_ps( tvX, e1Y ), _mm_mul_ps( tvY, e1X ) );
+
+	const __m128 det = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e1X, pvX ), _mm_mul_ps( e1Y, pvY ) ), _mm_mul_ps( e1Z, pvZ ) );
+	const __m128 s = _mm_add_ps( _mm_add_ps( _mm_mul_ps( tvX, pvX ), _mm_mul_ps( tvY, pvY ) ), _mm_mul_ps( tvZ, pvZ ) );
+	const __m128 t = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dirX, qvX ), _mm_mul_ps( dirY, qvY ) ), _mm_mul_ps( dirZ, qvZ ) );
+	const __m128 d = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e2X, qvX ), _mm_mul_ps( e2Y, qvY ) ), _mm_mul_ps( e2Z, qvZ ) );
+
+	// The determinant is positive when it is larger than the smallest non-denormal,
+	// so that test also rejects back facing triangles.
+	const __m128 zero = _mm_setzero_ps();
+	__m128 hit = _mm_cmpgt_ps( det, _mm_set1_ps( Math<float>::SmallestNonDenormal ) );
+	hit = _mm_and_ps( hit, _mm_and_ps( _mm_cmpge_ps( s, zero ), _mm_cmple_ps( s, det ) ) );
+	hit = _mm_and_ps( hit, _mm_and_ps( _mm_cmpge_ps( t, zero ), _mm_cmple_ps( _mm_add_ps( s, t ), det ) ) );
+
+	_mm_storeu_ps( hits.det, det );
+	_mm_storeu_ps( hits.s, s );
+	_mm_storeu_ps( hits.t, t );
+	_mm_storeu_ps( hits.d, d );
+
+	return _mm_movemask_ps( hit );
+}
+
+#elif defined( OVR_CPU_ARM_NEON )
+
+static int IntersectRayPacketTriangle( const traceRayPacket_t & packet, const Vector3f & v0,
+										const Vector3f & edge1, const Vector3f & edge2, traceRayHits_t & hits )
+{
+	const float32x4_t startX = vld1q_f32( packet.startX );
+	const float32x4_t startY = vld1q_f32( packet.startY );
+	const float32x4_t startZ = vld1q_f32( packet.startZ );
+	const float32x4_t dirX = vld1q_f32( packet.dirX );
+	const float32x4_t dirY = vld1q_f32( packet.dirY );
+	const float32x4_t dirZ = vld1q_f32( packet.dirZ );
+
+	const float32x4_t e1X = vdupq_n_f32( edge1.x );
+	const float32x4_t e1Y = vdupq_n_f32( edge1.y );
+	const float32x4_t e1Z = vdupq_n_f32( edge1.z );
+	const float32x4_t e2X = vdupq_n_f32( edge2.x );
+	const float32x4_t e2Y = vdupq_n_f32( edge2.y );
+	const float32x4_t e2Z = vdupq_n_f32( edge2.z );
+
+	const float32x4_t tvX = vsubq_f32( startX, vdupq_n_f32( v0.x ) );
+	const float32x4_t tvY = vsubq_f32( startY, vdupq_n_f32( v0.y ) );
+	const float32x4_t tvZ = vsubq_f32( startZ, vdupq_n_f32( v0.z ) );
+
+	// Separate multiplies and adds, rather than vmla, so the results
+	// match the scalar path exactly.
+	const float32x4_t pvX = vsubq_f32( vmulq_f32( dirY, e2Z ), vmulq_f32( dirZ, e2Y ) );
+	const float32x4_t pvY = vsubq_f32( vmulq_f32( dirZ, e2X ), vmulq_f32( dirX, e2Z ) );
+	const float32x4_t pvZ = vsubq_f32( vmulq_f32( dirX, e2Y ), vmulq_f32( dirY, e2X ) );
+
+	const float32x4_t qvX = vsubq_f32( vmulq_f32( tvY, e1Z ), vmulq_f32( tvZ, e1Y ) );
+	const float32x4_t qvY = vsubq_f32( vmulq_f32( tvZ, e1X ), vmulq_f32( tvX, e1Z ) );
+	const float32x4_t qvZ = vsubq_f32( vmulq_f32( tvX, e1Y ), vmulq_f32( tvY, e1X ) );
+
+	const float32x4_t det = vaddq_f32( vaddq_f32( vmulq_f32( e1X, pvX ), vmulq_f32( e1Y, pvY ) ), vmulq_f32( e1Z, pvZ ) );
+	const float32x4_t s = vaddq_f32( vaddq_f32( vmulq_f32( tvX, pvX ), vmulq_f32( tvY, pvY ) ), vmulq_f32( tvZ, pvZ ) );
+	const float32x4_t t = vaddq_f32( vaddq_f32( vmulq_f32( dirX, qvX ), vmulq_f32( dirY, qvY ) ), vmulq_f32( dirZ, qvZ ) );
+	const float32x4_t d = vaddq_f32( vaddq_f32( vmulq_f32( e2X, qvX ), vmulq_f32( e2Y, qvY ) ), vmulq_f32( e2Z, qvZ ) );
+
+	// The determinant is positive when it is larger than the smallest non-denormal,
+	// so that test also rejects back facing triangles.
+	const float32x4_t zero = vdupq_n_f32( 0.0f );
+	uint32x4_t hit = vcgtq_f32( det, vdupq_n_f32( Math<float>::SmallestNonDenormal ) );
+	hit = vandq_u32( hit, vandq_u32( vcgeq_f32( s, zero ), vcleq_f32( s, det ) ) );
+	hit = vandq_u32( hit, vandq_u32( vcgeq_f32( t, zero ), vcleq_f32( vaddq_f32( s, t ), det ) ) );
+
+	vst1q_f32( hits.det, det );
+	vst1q_f32( hits.s, s );
+	vst1q_f32( hits.t, t );
+	vst1q_f32( hits.d, d );
+
+	const uint32x4_t bits = { 1, 2, 4, 8 };
+	const uint32x4_t masked = vandq_u32( hit, bits );
+	const uint32x2_t sum = vpadd_u32( vget_low_u32( masked ), vget_high_u32( masked ) );
+	return (int)( vget_lane_u32( sum, 0 ) + vget_lane_u32( sum, 1 ) );
+}
+
+#else
+
+static int IntersectRayPacketTriangle( const traceRayPacket_t & packet, const Vector3f & v0,
+										const Vector3f & edge1, const Vector3f & edge2, traceRayHits_t & hits )
+{
+	int hitMask = 0;
+	for ( int lane = 0; lane < RT_TRACE_PACKET_SIZE; lane++ )
+	{
+		const Vector3f rayStart( packet.startX[lane], packet.startY[lane], packet.startZ[lane] );
+		const Vector3f rayDir( packet.dirX[lane], packet.dirY[lane], packet.dirZ[lane] );
+
+		const Vector3f tv = rayStart - v0;
+		const Vector3f pv = rayDir.Cross( edge2 );
+		const Vector3f qv = tv.Cross( edge1 );
+
+		const float det = edge1.Dot( pv );
+		const float s = tv.Dot( pv );
+		const float t = rayDir.Dot( qv );
+
+		hits.det[lane] = det;
+		hits.s[lane] = s;
+		hits.t[lane] = t;
+		hits.d[lane] = edge2.Dot( qv );
+
+		if ( det > Math<float>::SmallestNonDenormal && s >= 0.0f && s <= det && t >= 0.0f && s + t <= det )
+		{
+			hitMask |= 1 << lane;
+		}
+	}
+	return hitMask;
+}
+
+#endif
+
+static void IntersectRayPacketHit( const traceRayHits_t & hits, const int lane, float & t0, float & u, float & v )
+{
+	const float rcpDet = 1.0f / hits.det[lane];
+	t0 = hits.d[lane] * rcpDet;
+	u = hits.s[lane] * rcpDet;
+	v = hits.t[lane] * rcpDet;
+}
+
+// Sets up a lane the same way as Trace() and returns false if the ray misses the tree bounds.
+static bool StartRayPacketLane( const ModelTrace & trace, const Vector3f & start, const Vector3f & end, traceRayLane_t & lane )
+{
+	lane.start = start;
+	lane.rayDelta = end - start;
+	const float rayLengthSqr = lane.rayDelta.LengthSq();
+	lane.rayLengthRcp = RcpSqrt( rayLengthSqr );
+	const float rayLength = rayLengthSqr * lane.rayLengthRcp;
+	lane.rayDir = lane.rayDelta * lane.rayLengthRcp;
+
+	lane.rcpRayDirX = ( fabsf( lane.rayDir.x ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / lane.rayDir.x ) : Math<float>::HugeNumber;
+	lane.rcpRayDirY = ( fabsf( lane.rayDir.y ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / lane.rayDir.y ) : Math<float>::HugeNumber;
+	lane.rcpRayDirZ = ( fabsf( lane.rayDir.z ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / lane.rayDir.z ) : Math<float>::HugeNumber;
+
+	const Bounds3f & bounds = trace.header.bounds;
+
+	const float sX = ( bounds.GetMins()[0] - start.x ) * lane.rcpRayDirX;
+	const float sY = ( bounds.GetMins()[1] - start.y ) * lane.rcpRayDirY;
+	const float sZ = ( bounds.GetMins()[2] - start.z ) * lane.rcpRayDirZ;
+
+	const float tX = ( bounds.GetMaxs()[0] - start.x ) * lane.rcpRayDirX;
+	const float tY = ( bounds.GetMaxs()[1] - start.y ) * lane.rcpRayDirY;
+	const float tZ = ( bounds.GetMaxs()[2] - start.z ) * lane.rcpRayDirZ;
+
+	const float t0 = Alg::Max( Alg::Min( sX, tX ), Alg::Max( Alg::Min( sY, tY ), Alg::Min( sZ, tZ ) ) );
+	const float t1 = Alg::Min( Alg::Max( sX, tX ), Alg::Min( Alg::Max( sY, tY ), Alg::Max( sZ, tZ ) ) );
+
+	lane.entryDistance = Alg::Max( t0, 0.0f );
+	lane.bestDistance = Alg::Min( t1 + 0.00001f, rayLength );
+	lane.uv = Vector2f( 0.0f );
+	lane.currentNode = &trace.nodes[0];
+	lane.iterations = 0;
+	lane.active = ( t0 < t1 );
+
+	return lane.active;
+}
+
+// Steps down the tree from the current node of the lane until a leaf node is found.
+static void DescendRayPacketLane( const ModelTrace & trace, traceRayLane_t & lane )
+{
+	const Vector3f rayEntryPoint = lane.start + lane.rayDir * lane.entryDistance;
+
+	while ( ( lane.currentNode->data & 1 ) == 0 )
+	{
+		const int nodePlane = ( ( lane.currentNode->data >> 1 ) & 3 );
+		int child;
+		if ( rayEntryPoint[nodePlane] - lane.currentNode->dist < 0.00001f ) child = 0;
+		else if ( rayEntryPoint[nodePlane] - lane.currentNode->dist > 0.00001f ) child = 1;
+		else child = ( lane.rayDelta[nodePlane] > 0.0f );
+		lane.currentNode = &trace.nodes[( lane.currentNode->data >> 3 ) + child];
+	}
+}
+
+// Moves the lane through the exit plane of the leaf into the adjacent leaf, or deactivates it.
+static void ExitRayPacketLane( const ModelTrace & trace, const kdtree_leaf_t & leaf, traceRayLane_t & lane )
+{
+	const float sX = ( leaf.bounds.GetMins()[0] - lane.start.x ) * lane.rcpRayDirX;
+	const float sY = ( leaf.bounds.GetMins()[1] - lane.start.y ) * lane.rcpRayDirY;
+	const float sZ = ( leaf.bounds.GetMins()[2] - lane.start.z ) * lane.rcpRayDirZ;
+
+	const float tX = ( leaf.bounds.GetMaxs()[0] - lane.start.x ) * lane.rcpRayDirX;
+	const float tY = ( leaf.bounds.GetMaxs()[1] - lane.start.y ) * lane.rcpRayDirY;
+	const float tZ = ( leaf.bounds.GetMaxs()[2] - lane.start.z ) * lane.rcpRayDirZ;
+
+	const float maxX = Alg::Max( sX, tX );
+	const float maxY = Alg::Max( sY, tY );
+	const float maxZ = Alg::Max( sZ, tZ );
+
+	lane.entryDistance = Alg::Min( maxX, Alg::Min( maxY, maxZ ) );
+	if ( lane.entryDistance >= lane.bestDistance || ++lane.iterations >= RT_KDTREE_MAX_ITERATIONS )
+	{
+		lane.active = false;
+		return;
+	}
+
+	const int exitX = ( 0 << 1 ) | ( ( sX < tX ) ? 1 : 0 );
+	const int exitY = ( 1 << 1 ) | ( ( sY < tY ) ? 1 : 0 );
+	const int exitZ = ( 2 << 1 ) | ( ( sZ < tZ ) ? 1 : 0 );
+	const int exitPlane = ( maxX < maxY ) ? ( maxX < maxZ ? exitX : exitZ ) : ( maxY < maxZ ? exitY : exitZ );
+
+	const int exitNodeIndex = leaf.ropes[exitPlane];
+	if ( exitNodeIndex == -1 )
+	{
+		lane.active = false;
+		return;
+	}
+
+	lane.currentNode = &trace.nodes[exitNodeIndex];
+}
+
+static void TraceRayPacket( const ModelTrace & trace, const Vector3f * starts, const Vector3f * ends,
+							traceResult_t * results, const int numRays )
+{
+	traceRayLane_t lanes[RT_TRACE_PACKET_SIZE];
+	traceRayPacket_t packet;
+
+	for ( int i = 0; i < RT_TRACE_PACKET_SIZE; i++ )
+	{
+		// Unused lanes trace a copy of the first ray and are never active.
+		const int ray = ( i < numRays ) ? i : 0;
+
+		StartRayPacketLane( trace, starts[ray], ends[ray], lanes[i] );
+		lanes[i].active &= ( i < numRays );
+
+		packet.startX[i] = lanes[i].start.x;
+		packet.startY[i] = lanes[i].start.y;
+		packet.startZ[i] = lanes[i].start.z;
+		packet.dirX[i] = lanes[i].rayDir.x;
+		packet.dirY[i] = lanes[i].rayDir.y;
+		packet.dirZ[i] = lanes[i].rayDir.z;
+	}
+
+	int triangleIndex[RT_TRACE_PACKET_SIZE] = { -1, -1, -1, -1 };
+
+	for ( ; ; )
+	{
+		// Step all active rays down to their current leaf.
+		int leader = -1;
+		for ( int i = RT_TRACE_PACKET_SIZE - 1; i >= 0; i-- )
+		{
+			if ( lanes[i].active )
+			{
+				DescendRayPacketLane( trace, lanes[i] );
+				leader = i;
+			}
+		}
+		if ( leader == -1 )
+		{
+			break;
+		}
+
+		// Intersect all rays that are in the same leaf as the first active ray.
+		const kdtree_node_t * leafNode = lanes[leader].currentNode;
+		int laneMask = 0;
+		for ( int i = leader; i < RT_TRACE_PACKET_SIZE; i++ )
+		{
+			if ( lanes[i].active && lanes[i].currentNode == leafNode )
+			{
+				laneMask |= 1 << i;
+			}
+		}
+
+		const kdtree_leaf_t & currentLeaf = trace.leafs[( leafNode->data >> 3 )];
+		const int * leafTriangles = currentLeaf.triangles;
+		int leafTriangleCount = RT_KDTREE_MAX_LEAF_TRIANGLES;
+		for ( int j = 0; j < leafTriangleCount; j++ )
+		{
+			int currentTriangle = leafTriangles[j];
+			if ( currentTriangle < 0 )
+			{
+				if ( currentTriangle == -1 )
+				{
+					break;
+				}
+
+				const int offset = ( currentTriangle & 0x7FFFFFFF );
+				leafTriangles = &trace.overflow[offset];
+				leafTriangleCount = trace.header.numOverflow - offset;
+				j = 0;
+				currentTriangle = leafTriangles[0];
+			}
+
+			const Vector3f & v0 = trace.vertices[trace.indices[currentTriangle * 3 + 0]];
+			const Vector3f & v1 = trace.vertices[trace.indices[currentTriangle * 3 + 1]];
+			const Vector3f & v2 = trace.vertices[trace.indices[currentTriangle * 3 + 2]];
+
+			traceRayHits_t hits;
+			const int hitMask = IntersectRayPacketTriangle( packet, v0, v1 - v0, v2 - v0, hits ) & laneMask;
+			if ( hitMask == 0 )
+			{
+				continue;
+			}
+
+			for ( int i = leader; i < RT_TRACE_PACKET_SIZE; i++ )
+			{
+				if ( ( hitMask & ( 1 << i ) ) == 0 )
+				{
+					continue;
+				}
+
+				float distance;
+				float u;
+				float v;
+				IntersectRayPacketHit( hits, i, distance, u, v );
+
+				if ( distance >= 0.0f && distance < lanes[i].bestDistance )
+				{
+					lanes[i].bestDistance = distance;
+
+					triangleIndex[i] = currentTriangle * 3;
+					lanes[i].uv.x = u;
+					lanes[i].uv.y = v;
+				}
+			}
+		}
+
+		for ( int i = leader; i < RT_TRACE_PACKET_SIZE; i++ )
+		{
+			if ( ( laneMask & ( 1 << i ) ) != 0 )
+			{
+				ExitRayPacketLane( trace, currentLeaf, lanes[i] );
+			}
+		}
+	}
+
+	for ( int i = 0; i < numRays; i++ )
+	{
+		traceResult_t & result = results[i];
+		result.triangleIndex = triangleIndex[i];
+		result.fraction = 1.0f;
+		result.uv = Vector2f( 0.0f );
+		result.normal = Vector3f( 0.0f );
+
+		if ( result.triangleIndex != -1 )
+		{
+			const Vector2f & uv = lanes[i].uv;
+			result.fraction = lanes[i].bestDistance * lanes[i].rayLengthRcp;
+			// return default uvs if the model has no uvs
+			if ( trace.uvs.GetSizeI() == 0 )
+			{
+				result.uv = Vector2f( 0.0f, 0.0f );
+			}
+			else
+			{
+				result.uv = trace.uvs[trace.indices[result.triangleIndex + 0]] * ( 1.0f - uv.x - uv.y ) +
+							trace.uvs[trace.indices[result.triangleIndex + 1]] * uv.x +
+							trace.uvs[trace.indices[result.triangleIndex + 2]] * uv.y;
+			}
+			const Vector3f d1 = trace.vertices[trace.indices[result.triangleIndex + 1]] - trace.vertices[trace.indices[result.triangleIndex + 0]];
+			const Vector3f d2 = trace.vertices[trace.indices[result.triangleIndex + 2]] - trace.vertices[trace.indices[result.triangleIndex + 0]];
+			result.normal = d1.Cross( d2 ).Normalized();
+		}
+	}
+}
+
+void ModelTrace::TraceBatch( const Vector3f * starts, const Vector3f * ends, traceResult_t * results, const int numRays ) const
+{
+	// in debug, at least warn programmers if they're loading a model
+	// that fails simple validation.
+	OVR_ASSERT( Validate( false ) );
+
+	for ( int first = 0; first < numRays; first += RT_TRACE_PACKET_SIZE )
+	{
+		TraceRayPacket( *this, starts + first, ends + first, results + first, Alg::Min( numRays - first, RT_TRACE_PACKET_SIZE ) );
+	}
+}
+
+/*
+
+	Heuristics for Ray Tracing Using Space Subdivision
+	J. David MacDonald, Kellogg S. Booth
+	The Visual Computer, Volume 6, Number 3, 1990
+
+	The tree is first built into an intermediate form where large subtrees are
+	split off as tasks that are built in parallel. The intermediate form is then
+	flattened into the node, leaf, rope and overflow layout used by Trace().
+
+*/
+
+const float	RT_KDTREE_BUILD_TRAVERSAL_COST		= 1.0f;
+const float	RT_KDTREE_BUILD_INTERSECT_COST		= 1.5f;
+const float	RT_KDTREE_BUILD_EMPTY_BONUS			= 0.8f;		// scale the cost of splits that cut off empty space
+const int	RT_KDTREE_BUILD_MAX_DEPTH			= 40;
+const int	RT_KDTREE_BUILD_MIN_TASK_TRIANGLES	= 1024;
+const int	RT_KDTREE_BUILD_MAX_THREADS			= 4;
+
+enum kdtree_event_type_t
+{
+	KDTREE_EVENT_END,
+	KDTREE_EVENT_PLANAR,
+	KDTREE_EVENT_START
+};
+
+struct kdtree_event_t
+{
+	float	pos;
+	int		type;
+
+	bool operator<( const kdtree_event_t & other ) const
+	{
+		return ( pos < other.pos ) || ( pos == other.pos && type < other.type );
+	}
+};
+
+struct kdtree_build_node_t
+{
+	int		axis;			// -1 for a leaf
+	float	dist;
+	int		children[2];	// in the same build tree
+	int		subtree;		// index of the build tree with the actual node, or -1
+	int		firstTriangle;
+	int		numTriangles;
+};
+
+struct kdtree_build_tree_t
+{
+	Array< kdtree_build_node_t >	nodes;
+	Array< int >					triangles;
+
+	// the subtree still to be built if this is a task
+	Array< int >					taskTriangles;
+	Bounds3f						taskBounds;
+	int								taskDepth;
+};
+
+struct kdtree_builder_t
+{
+	kdtree_builder_t() :
+		maxDepth( 0 ),
+		minTaskTriangles( 0 ),
+		nextTask( 0 ) {}
+
+	Array< Bounds3f >				triangleBounds;
+	int								maxDepth;
+	int								minTaskTriangles;
+	Array< kdtree_build_tree_t * >	trees;
+	AtomicInt< int >				nextTask;
+};
+
+static float SurfaceArea( const Vector3f & size )
+{
+	return 2.0f * ( size.x * size.y + size.y * size.z + size.z * size.x );
+}
+
+static float SplitCost( const float rcpArea, const float leftArea, const float rightArea, const int numLeft, const int numRight )
+{
+	const float cost = RT_KDTREE_BUILD_TRAVERSAL_COST + RT_KDTREE_BUILD_INTERSECT_COST * ( leftArea * numLeft + rightArea * numRight ) * rcpArea;
+	return ( numLeft == 0 || numRight == 0 ) ? cost * RT_KDTREE_BUILD_EMPTY_BONUS : cost;
+}
+
+// Finds the split plane with the lowest surface area heuristic cost by sweeping over
+// the sorted triangle bounds along each axis. Triangles in the split plane go to the
+// side with the lowest cost. Returns false if no split is cheaper than a leaf.
+static bool FindSplit( const kdtree_builder_t & builder, const Array< int > & triangles, const Bounds3f & bounds,
+						int & bestAxis, float & bestDist, bool & bestPlanarLeft )
+{
+	const Vector3f size = bounds.GetSize();
+	const float area = SurfaceArea( size );
+	if ( area <= 0.0f )
+	{
+		return false;
+	}
+	const float rcpArea = 1.0f / area;
+	const int numTriangles = triangles.GetSizeI();
+	const float leafCost = RT_KDTREE_BUILD_INTERSECT_COST * numTriangles;
+
+	float bestCost = leafCost;
+
+	Array< kdtree_event_t > events;
+	events.Reserve( numTriangles * 2 );
+
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		const float cellMin = bounds.GetMins()[axis];
+		const float cellMax = bounds.GetMaxs()[axis];
+		if ( cellMax <= cellMin )
+		{
+			continue;
+		}
+
+		events.Clear();
+		for ( int i = 0; i < numTriangles; i++ )
+		{
+			const Bounds3f & triangleBounds = builder.triangleBounds[triangles[i]];
+			const float triangleMin = Alg::Max( triangleBounds.GetMins()[axis], cellMin );
+			const float triangleMax = Alg::Min( triangleBounds.GetMaxs()[axis], cellMax );
+			if ( triangleMin >= triangleMax )
+			{
+				const kdtree_event_t planar = { triangleMin, KDTREE_EVENT_PLANAR };
+				events.PushBack( planar );
+			}
+			else
+			{
+				const kdtree_event_t start = { triangleMin, KDTREE_EVENT_START };
+				const kdtree_event_t end = { triangleMax, KDTREE_EVENT_END };
+				events.PushBack( start );
+				events.PushBack( end );
+			}
+		}
+		std::sort( events.GetDataPtr(), events.GetDataPtr() + events.GetSize() );
+
+		Vector3f leftSize = size;
+		Vector3f rightSize = size;
+
+		int numLeft = 0;
+		int numRight = numTriangles;
+		for ( int i = 0; i < events.GetSizeI(); )
+		{
+			const float pos = events[i].pos;
+			int numEnd = 0;
+			int numPlanar = 0;
+			int numStart = 0;
+			for ( ; i < events.GetSizeI() && events[i].pos == pos && events[i].type == KDTREE_EVENT_END; i++ ) { numEnd++; }
+			for ( ; i < events.GetSizeI() && events[i].pos == pos && events[i].type == KDTREE_EVENT_PLANAR; i++ ) { numPlanar++; }
+			for ( ; i < events.GetSizeI() && events[i].pos == pos && events[i].type == KDTREE_EVENT_START; i++ ) { numStart++; }
+
+			numRight -= numPlanar + numEnd;
+
+			if ( pos > cellMin && pos < cellMax )
+			{
+				leftSize[axis] = pos - cellMin;
+				rightSize[axis] = cellMax - pos;
+				const float leftArea = SurfaceArea( leftSize );
+				const float rightArea = SurfaceArea( rightSize );
+
+				const float planarLeftCost = SplitCost( rcpArea, leftArea, rightArea, numLeft + numPlanar, numRight );
+				const float planarRightCost = SplitCost( rcpArea, leftArea, rightArea, numLeft, numRight + numPlanar );
+				if ( planarLeftCost < bestCost )
+				{
+					bestCost = planarLeftCost;
+					bestAxis = axis;
+					bestDist = pos;
+					bestPlanarLeft = true;
+				}
+				if ( planarRightCost < bestCost )
+				{
+					bestCost = planarRightCost;
+					bestAxis = axis;
+					bestDist = pos;
+					bestPlanarLeft = false;
+				}
+			}
+
+			numLeft += numStart + numPlanar;
+		}
+	}
+
+	return ( bestCost < leafCost );
+}
+
+// Returns the index of the new node in the build tree. With spawnTasks set, subtrees
+// with few enough triangles are split off as tasks instead of being built.
+static int BuildNode( kdtree_builder_t & builder, kdtree_build_tree_t & tree, Array< int > & triangles,
+						const Bounds3f & bounds, const int depth, const bool spawnTasks )
+{
+	const int nodeIndex = tree.nodes.AllocBack();
+	tree.nodes[nodeIndex].axis = -1;
+	tree.nodes[nodeIndex].dist = 0.0f;
+	tree.nodes[nodeIndex].children[0] = -1;
+	tree.nodes[nodeIndex].children[1] = -1;
+	tree.nodes[nodeIndex].subtree = -1;
+	tree.nodes[nodeIndex].firstTriangle = 0;
+	tree.nodes[nodeIndex].numTriangles = 0;
+
+	const int numTriangles = triangles.GetSizeI();
+
+	if ( spawnTasks && numTriangles <= builder.minTaskTriangles )
+	{
+		kdtree_build_tree_t * task = new kdtree_build_tree_t;
+		task->taskTriangles = triangles;
+		task->taskBounds = bounds;
+		task->taskDepth = depth;
+		tree.nodes[nodeIndex].subtree = builder.trees.GetSizeI();
+		builder.trees.PushBack( task );
+		return nodeIndex;
+	}
+
+	int axis = 0;
+	float dist = 0.0f;
+	bool planarLeft = true;
+	if ( numTriangles == 0 || depth >= builder.maxDepth || !FindSplit( builder, triangles, bounds, axis, dist, planarLeft ) )
+	{
+		tree.nodes[nodeIndex].firstTriangle = tree.triangles.GetSizeI();
+		tree.nodes[nodeIndex].numTriangles = numTriangles;
+		tree.triangles.Append( triangles.GetDataPtr(), numTriangles );
+		return nodeIndex;
+	}
+
+	// Classify the triangles the same way FindSplit counted them.
+	Array< int > leftTriangles;
+	Array< int > rightTriangles;
+	for ( int i = 0; i < numTriangles; i++ )
+	{
+		const Bounds3f & triangleBounds = builder.triangleBounds[triangles[i]];
+		const float triangleMin = Alg::Max( triangleBounds.GetMins()[axis], bounds.GetMins()[axis] );
+		const float triangleMax = Alg::Min( triangleBounds.GetMaxs()[axis], bounds.GetMaxs()[axis] );
+		if ( triangleMin >= triangleMax )
+		{
+			if ( triangleMin < dist || ( triangleMin == dist && planarLeft ) )
+			{
+				leftTriangles.PushBack( triangles[i] );
+			}
+			else
+			{
+				rightTriangles.PushBack( triangles[i] );
+			}
+		}
+		else
+		{
+			if ( triangleMin < dist )
+			{
+				leftTriangles.PushBack( triangles[i] );
+			}
+			if ( triangleMax > dist )
+			{
+				rightTriangles.PushBack( triangles[i] );
+			}
+		}
+	}
+	triangles.ClearAndRelease();
+
+	Bounds3f leftBounds = bounds;
+	Bounds3f rightBounds = bounds;
+	leftBounds.GetMaxs()[axis] = dist;
+	rightBounds.GetMins()[axis] = dist;
+
+	tree.nodes[nodeIndex].axis = axis;
+	tree.nodes[nodeIndex].dist = dist;
+
+	const int leftChild = BuildNode( builder, tree, leftTriangles, leftBounds, depth + 1, spawnTasks );
+	const int rightChild = BuildNode( builder, tree, rightTriangles, rightBounds, depth + 1, spawnTasks );
+
+	tree.nodes[nodeIndex].children[0] = leftChild;
+	tree.nodes[nodeIndex].children[1] = rightChild;
+
+	return nodeIndex;
+}
+
+static void BuildTasks( kdtree_builder_t & builder )
+{
+	for ( ; ; )
+	{
+		const int index = builder.nextTask.ExchangeAdd_Sync( 1 );
+		if ( index >= builder.trees.GetSizeI() )
+		{
+			break;
+		}
+		kdtree_build_tree_t & task = *builder.trees[index];
+		BuildNode( builder, task, task.taskTriangles, task.taskBounds, task.taskDepth, false );
+	}
+}
+
+static threadReturn_t BuildTasksThread( Thread * thread, void * v )
+{
+	BuildTasks( *(kdtree_builder_t *)v );
+	return NULL;
+}
+
+// Stores the build node in nodes[outIndex]. The ropes of a leaf point at the node
+// on the other side of each face of the leaf cell, or -1 at the model bounds.
+static void FlattenNode( const kdtree_builder_t & builder, int treeIndex, int nodeIndex, const int outIndex,
+						const Bounds3f & bounds, const int ropes[6], ModelTrace & model )
+{
+	while ( builder.trees[treeIndex]->nodes[nodeIndex].subtree >= 0 )
+	{
+		treeIndex = builder.trees[treeIndex]->nodes[nodeIndex].subtree;
+		nodeIndex = 0;
+	}
+	const kdtree_build_tree_t & tree = *builder.trees[treeIndex];
+	const kdtree_build_node_t & node = tree.nodes[nodeIndex];
+
+	if ( node.axis < 0 )
+	{
+		const int leafIndex = model.leafs.AllocBack();
+		kdtree_leaf_t & leaf = model.leafs[leafIndex];
+
+		const int * triangles = &tree.triangles[node.firstTriangle];
+		if ( node.numTriangles <= RT_KDTREE_MAX_LEAF_TRIANGLES )
+		{
+			for ( int i = 0; i < RT_KDTREE_MAX_LEAF_TRIANGLES; i++ )
+			{
+				leaf.triangles[i] = ( i < node.numTriangles ) ? triangles[i] : -1;
+			}
+		}
+		else
+		{
+			// the last triangle slot points at the rest of the triangles in the overflow list
+			const int numInline = RT_KDTREE_MAX_LEAF_TRIANGLES - 1;
+			for ( int i = 0; i < numInline; i++ )
+			{
+				leaf.triangles[i] = triangles[i];
+			}
+			leaf.triangles[numInline] = (int)( 0x80000000u | (UInt32)model.overflow.GetSizeI() );
+			model.overflow.Append( triangles + numInline, node.numTriangles - numInline );
+			model.overflow.PushBack( -1 );
+		}
+		for ( int i = 0; i < 6; i++ )
+		{
+			leaf.ropes[i] = ropes[i];
+		}
+		leaf.bounds = bounds;
+
+		model.nodes[outIndex].data = ( (UInt32)leafIndex << 3 ) | ( 3 << 1 ) | 1;
+		model.nodes[outIndex].dist = 0.0f;
+		return;
+	}
+
+	// the children are always stored next to each other
+	const int childIndex = model.nodes.GetSizeI();
+	model.nodes.AllocBack();
+	model.nodes.AllocBack();
+
+	model.nodes[outIndex].data = ( (UInt32)childIndex << 3 ) | ( node.axis << 1 );
+	model.nodes[outIndex].dist = node.dist;
+
+	int leftRopes[6];
+	int rightRopes[6];
+	for ( int i = 0; i < 6; i++ )
+	{
+		leftRopes[i] = ropes[i];
+		rightRopes[i] = ropes[i];
+	}
+	leftRopes[node.axis * 2 + 1] = childIndex + 1;
+	rightRopes[node.axis * 2 + 0] = childIndex + 0;
+
+	Bounds3f leftBounds = bounds;
+	Bounds3f rightBounds = bounds;
+	leftBounds.GetMaxs()[node.axis] = node.dist;
+	rightBounds.GetMins()[node.axis] = node.dist;
+
+	FlattenNode( builder, treeIndex, node.children[0], childIndex + 0, leftBounds, leftRopes, model );
+	FlattenNode( builder, treeIndex, node.children[1], childIndex + 1, rightBounds, rightRopes, model );
+}
+
+bool ModelTrace::Build()
+{
+	LOGCPUTIME( "ModelTrace::Build" );
+
+	const int numTriangles = indices.GetSizeI() / 3;
+
+	kdtree_builder_t builder;
+	builder.maxDepth = Alg::Min( (int)( 8.0f + 1.3f * logf( (float)Alg::Max( numTriangles, 1 ) ) / logf( 2.0f ) ), RT_KDTREE_BUILD_MAX_DEPTH );
+	builder.triangleBounds.Resize( numTriangles );
+
+	Bounds3f modelBounds;
+	modelBounds.Clear();
+	for ( int i = 0; i < vertices.GetSizeI(); i++ )
+	{
+		modelBounds.AddPoint( vertices[i] );
+	}
+
+	Array< int > triangles;
+	triangles.Resize( numTriangles );
+	for ( int i = 0; i < numTriangles; i++ )
+	{
+		const int i0 = indices[i * 3 + 0];
+		const int i1 = indices[i * 3 + 1];
+		const int i2 = indices[i * 3 + 2];
+		if (	i0 < 0 || i0 >= vertices.GetSizeI() ||
+				i1 < 0 || i1 >= vertices.GetSizeI() ||
+				i2 < 0 || i2 >= vertices.GetSizeI() )
+		{
+			LOG( "ModelTrace::Build - triangle %i has out of range indices", i );
+			return false;
+		}
+		builder.triangleBounds[i].Clear();
+		builder.triangleBounds[i].AddPoint( vertices[i0] );
+		builder.triangleBounds[i].AddPoint( vertices[i1] );
+		builder.triangleBounds[i].AddPoint( vertices[i2] );
+		triangles[i] = i;
+	}
+
+	// Build the top of the tree on this thread, and the subtrees split off as tasks in parallel.
+	const int numThreads = Alg::Min( Thread::GetCPUCount(), RT_KDTREE_BUILD_MAX_THREADS );
+	builder.minTaskTriangles = Alg::Max( numTriangles / ( numThreads * 8 ), RT_KDTREE_BUILD_MIN_TASK_TRIANGLES );
+	builder.trees.PushBack( new kdtree_build_tree_t );
+	builder.nextTask = 1;
+
+	BuildNode( builder, *builder.trees[0], triangles, modelBounds, 0, true );
+
+	const int numWorkers = Alg::Min( numThreads, builder.trees.GetSizeI() - 1 ) - 1;
+	Thread * threads[RT_KDTREE_BUILD_MAX_THREADS];
+	for ( int i = 0; i < numWorkers; i++ )
+	{
+		threads[i] = new Thread( Thread::CreateParams( BuildTasksThread, &builder, 128 * 1024 ) );
+		threads[i]->Start();
+	}
+
+	BuildTasks( builder );
+
+	for ( int i = 0; i < numWorkers; i++ )
+	{
+		threads[i]->Join();
+		delete threads[i];
+	}
+
+	// Flatten into the final layout.
+	nodes.Clear();
+	leafs.Clear();
+	overflow.Clear();
+
+	nodes.AllocBack();
+	const int boundaryRopes[6] = { -1, -1, -1, -1, -1, -1 };
+	FlattenNode( builder, 0, 0, 0, modelBounds, boundaryRopes, *this );
+
+	for ( int i = 0; i < builder.trees.GetSizeI(); i++ )
+	{
+		delete builder.trees[i];
+	}
+
+	header.numVertices = vertices.GetSizeI();
+	header.numUvs = uvs.GetSizeI();
+	header.numIndices = indices.GetSizeI();
+	header.numNodes = nodes.GetSizeI();
+	header.numLeafs = leafs.GetSizeI();
+	header.numOverflow = overflow.GetSizeI();
+	header.bounds = modelBounds;
+
+	LOG( "ModelTrace::Build - %i triangles, %i nodes, %i leafs, %i overflow", numTriangles, header.numNodes, header.numLeafs, header.numOverflow );
+
+	return Validate( true );
+}
+
 }
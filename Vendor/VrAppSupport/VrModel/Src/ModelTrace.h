@@ -63,9 +63,20 @@ public:
 
 	bool					Validate( const bool fullVerify ) const;
 
+	// Builds the KD-tree with ropes for the current vertices, uvs and indices using
+	// the surface area heuristic, and sets up the header. The resulting layout is
+	// the same as that of a prebuilt tree. Large subtrees are built in parallel.
+	// Returns false if the result does not validate.
+	bool					Build();
+
 	traceResult_t			Trace( const Vector3f & start, const Vector3f & end ) const;
 	traceResult_t			Trace_Exhaustive( const Vector3f & start, const Vector3f & end ) const;
 
+	// Traces a batch of rays with the same results as Trace(). Rays that are in the same
+	// leaf are intersected with the leaf triangles four at a time, so coherent rays, like
+	// those of a view or a gaze cone, should be next to each other in the batch.
+	void					TraceBatch( const Vector3f * starts, const Vector3f * ends, traceResult_t * results, const int numRays ) const;
+
 public:
 	kdtree_header_t			header;
 	Array< Vector3f >		vertices;
@@ -0,0 +1,178 @@
+/************************************************************************************
+
+Filename    :   ModelZip.cpp
+Content     :   Reading the entries of zipped model files
+Created     :   December 2013
+Authors     :   John Carmack, J.M.P. van Waveren
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "ModelZip.h"
+
+#include <string.h>
+
+#include "Kernel/OVR_Std.h"
+#include "Kernel/OVR_LogUtils.h"
+
+// Verbose log, redefine this as LOG() to get lots more info dumped
+#define LOGV(...)
+
+namespace OVR {
+
+void ReadModelZipEntries( unzFile zfp, const char * fileName, const char * fileData,
+							Array< modelZipEntry_t > & entries, ovrInflateService & inflateService,
+							ovrInflateBufferPool & bufferPool )
+{
+	// Walk the zip directory.  Stored entries in a memory resident zip are
+	// referenced in place, and deflated ones are left for the inflate service.
+	int numDeflated = 0;
+
+	for ( int ret = unzGoToFirstFile( zfp ); ret == UNZ_OK; ret = unzGoToNextFile( zfp ) )
+	{
+		modelZipEntry_t & entry = entries[entries.AllocBack()];
+
+		unz_file_info finfo;
+		unzGetCurrentFileInfo( zfp, &finfo, entry.name, sizeof( entry.name ), NULL, 0, NULL, 0 );
+		LOGV( "zip level: %ld, file: %s", finfo.compression_method, entry.name );
+
+		if ( unzOpenCurrentFile( zfp ) != UNZ_OK )
+		{
+			WARN( "Failed to open %s from %s", entry.name, fileName );
+			continue;
+		}
+
+		entry.size = finfo.uncompressed_size;
+
+		if ( finfo.compression_method == 0 && fileData != NULL )
+		{
+			entry.buffer = (char *)fileData + unzGetCurrentFileZStreamPos64( zfp );
+			entry.valid = true;
+		}
+		else
+		{
+			entry.buffer = (char *)bufferPool.Alloc( entry.size + 1 );
+			if ( entry.buffer == NULL )
+			{
+				WARN( "Failed to allocate %d bytes for %s from %s", entry.size, entry.name, fileName );
+				entry.size = 0;
+				unzCloseCurrentFile( zfp );
+				continue;
+			}
+			entry.buffer[entry.size] = '\0';	// always zero terminate text files
+			entry.pool = &bufferPool;
+
+			if ( finfo.compression_method == Z_DEFLATED && fileData != NULL )
+			{
+				entry.compressed = (const UByte *)fileData + unzGetCurrentFileZStreamPos64( zfp );
+				entry.compressedSize = finfo.compressed_size;
+				entry.crc = finfo.crc;
+				numDeflated++;
+			}
+			else
+			{
+				entry.valid = ( unzReadCurrentFile( zfp, entry.buffer, entry.size ) == entry.size );
+			}
+		}
+
+		unzCloseCurrentFile( zfp );
+	}
+	unzClose( zfp );
+
+	// Inflate all the deflated entries in parallel.
+	if ( numDeflated > 0 )
+	{
+		Array< ovrInflateJob > jobs;
+		jobs.Resize( numDeflated );
+		for ( int i = 0, j = 0; i < entries.GetSizeI(); i++ )
+		{
+			const modelZipEntry_t & entry = entries[i];
+			if ( entry.compressed != NULL )
+			{
+				jobs[j].Compressed = entry.compressed;
+				jobs[j].CompressedSize = entry.compressedSize;
+				jobs[j].Method = Z_DEFLATED;
+				jobs[j].Crc = entry.crc;
+				jobs[j].VerifyCrc = true;
+				jobs[j].Buffer = entry.buffer;
+				jobs[j].Size = entry.size;
+				j++;
+			}
+		}
+
+		inflateService.Inflate( jobs.GetDataPtr(), jobs.GetSizeI() );
+
+		for ( int i = 0, j = 0; i < entries.GetSizeI(); i++ )
+		{
+			modelZipEntry_t & entry = entries[i];
+			if ( entry.compressed != NULL )
+			{
+				entry.valid = jobs[j].Valid;
+				j++;
+			}
+		}
+	}
+}
+
+void FreeModelZipEntry( modelZipEntry_t & entry )
+{
+	if ( entry.pool != NULL )
+	{
+		entry.pool->Free( entry.buffer );
+	}
+	entry.buffer = NULL;
+	entry.size = 0;
+	entry.pool = NULL;
+}
+
+void FreeModelZipEntries( Array< modelZipEntry_t > & entries )
+{
+	for ( int i = 0; i < entries.GetSizeI(); i++ )
+	{
+		FreeModelZipEntry( entries[i] );
+	}
+	entries.Clear();
+}
+
+void FindModelZipEntries( const Array< modelZipEntry_t > & entries, const char * fileName,
+							const char * & modelsJson, int & modelsJsonLength,
+							const char * & modelsBin, int & modelsBinLength )
+{
+	modelsJson = NULL;
+	modelsJsonLength = 0;
+	modelsBin = NULL;
+	modelsBinLength = 0;
+
+	for ( int i = 0; i < entries.GetSizeI(); i++ )
+	{
+		const modelZipEntry_t & entry = entries[i];
+		if ( !entry.valid )
+		{
+			WARN( "Failed to read %s from %s", entry.name, fileName );
+		}
+		else if ( OVR_stricmp( entry.name, "models.json" ) == 0 )
+		{
+			modelsJson = entry.buffer;
+			modelsJsonLength = entry.size;
+		}
+		else if ( OVR_stricmp( entry.name, "models.bin" ) == 0 )
+		{
+			modelsBin = entry.buffer;
+			modelsBinLength = entry.size;
+		}
+	}
+}
+
+bool IsModelTextureFile( const char * name )
+{
+	// assume a 3 character extension
+	const size_t length = strlen( name );
+	const char * extension = ( length >= 4 ) ? &name[length - 4] : name;
+
+	// only support .pvr and .ktx containers for now
+	return (	OVR_stricmp( extension, ".pvr" ) == 0 ||
+				OVR_stricmp( extension, ".ktx" ) == 0 );
+}
+
+} // namespace OVR
@@ -0,0 +1,65 @@
+/************************************************************************************
+
+Filename    :   ModelZip.h
+Content     :   Reading the entries of zipped model files
+Created     :   December 2013
+Authors     :   John Carmack, J.M.P. van Waveren
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#ifndef OVR_ModelZip_h
+#define OVR_ModelZip_h
+
+#include "Kernel/OVR_Array.h"
+#include "unzip.h"
+#include "InflateService.h"
+
+namespace OVR {
+
+struct modelZipEntry_t
+{
+	modelZipEntry_t() :
+		compressed( NULL ),
+		compressedSize( 0 ),
+		crc( 0 ),
+		buffer( NULL ),
+		size( 0 ),
+		pool( NULL ),
+		valid( false ) { name[0] = '\0'; }
+
+	char			name[256];
+	const UByte *	compressed;		// deflated data still to be inflated, in the mapped zip
+	int				compressedSize;
+	uint32_t		crc;
+	char *			buffer;			// zero terminated if owned
+	int				size;
+	ovrInflateBufferPool *	pool;	// owns the buffer if set
+	bool			valid;
+};
+
+// Reads all entries from the zip file and closes it.  Stored entries in a memory
+// resident zip are referenced in place, and deflated ones are inflated in parallel
+// by the given service.  If fileData is NULL, all entries are read one at a time
+// through the zip file.  The other entries get buffers from the pool.
+void ReadModelZipEntries( unzFile zfp, const char * fileName, const char * fileData,
+						Array< modelZipEntry_t > & entries,
+						ovrInflateService & inflateService = ovr_GetInflateService(),
+						ovrInflateBufferPool & bufferPool = ovr_GetInflateBufferPool() );
+
+// Returns the buffer of an entry to its pool once it is consumed.
+void FreeModelZipEntry( modelZipEntry_t & entry );
+void FreeModelZipEntries( Array< modelZipEntry_t > & entries );
+
+// Locates models.json and models.bin in the zip entries.
+// models.json is not zero terminated if the entry is referenced in place.
+void FindModelZipEntries( const Array< modelZipEntry_t > & entries, const char * fileName,
+						const char * & modelsJson, int & modelsJsonLength,
+						const char * & modelsBin, int & modelsBinLength );
+
+bool IsModelTextureFile( const char * name );
+
+} // namespace OVR
+
+#endif	// OVR_ModelZip_h
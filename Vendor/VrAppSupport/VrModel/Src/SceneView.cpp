@@ -81,6 +81,12 @@ void ModelInScene::AnimateJoints( const float timeInSeconds )
 OvrSceneView::OvrSceneView() :
 	FreeWorldModelOnChange( false ),
 	SceneId( 0 ),
+	SurfaceSortMode( MODEL_SURFACE_SORT_DEPTH ),
+	CullThread( NULL ),
+	CullPending( false ),
+	CullExit( false ),
+	CullFovDegreesX( 0.0f ),
+	CullFovDegreesY( 0.0f ),
 	LoadedPrograms( false ),
 	Paused( false ),
 	SupressModelsWithClientId( -1 ),
@@ -100,6 +106,18 @@ OvrSceneView::OvrSceneView() :
 	CenterEyeViewMatrix = ovrMatrix4f_CreateIdentity();
 }
 
+OvrSceneView::~OvrSceneView()
+{
+	if ( CullThread != NULL )
+	{
+		CullExit = true;
+		CullStart.SetEvent();
+		CullThread->Join();
+		delete CullThread;
+		CullThread = NULL;
+	}
+}
+
 ModelGlPrograms OvrSceneView::GetDefaultGLPrograms()
 {
 	ModelGlPrograms programs;
@@ -237,37 +255,115 @@ void OvrSceneView::RemoveModelIndex( int index )
 	Models[index] = NULL;
 }
 
-Matrix4f OvrSceneView::DrawEyeView( const int eye, const float fovDegreesX, const float fovDegreesY ) const
+void OvrSceneView::CullSurfaces( const float fovDegreesX, const float fovDegreesY ) const
 {
-	glEnable( GL_DEPTH_TEST );
-	glEnable( GL_CULL_FACE );
-	glFrontFace( GL_CCW );
-
 	const Matrix4f centerEyeViewMatrix = GetCenterEyeViewMatrix();
-	const Matrix4f viewMatrix = GetEyeViewMatrix( eye );
-	const Matrix4f projectionMatrix = GetEyeProjectionMatrix( eye, fovDegreesX, fovDegreesY );
+	const Matrix4f projectionMatrix = GetEyeProjectionMatrix( 0, fovDegreesX, fovDegreesY );
 
 	// Cull the model surfaces using a view and projection matrix that contain both eyes
 	// and add the surfaces to the sorted surface list.
-	if ( eye == 0 )
+	Matrix4f symmetricEyeProjectionMatrix = projectionMatrix;
+	symmetricEyeProjectionMatrix.M[0][0] = projectionMatrix.M[0][0] / ( fabs( projectionMatrix.M[0][2] ) + 1.0f );
+	symmetricEyeProjectionMatrix.M[0][2] = 0.0f;
+
+	const float moveBackDistance = 0.5f * HeadModelParms.InterpupillaryDistance * symmetricEyeProjectionMatrix.M[0][0];
+	Matrix4f centerEyeCullViewMatrix = Matrix4f::Translation( 0, 0, -moveBackDistance ) * centerEyeViewMatrix;
+
+	Array< ModelState * > emitModels;
+	for ( int i = 0; i < Models.GetSizeI(); i++ )
 	{
-		Matrix4f symmetricEyeProjectionMatrix = projectionMatrix;
-		symmetricEyeProjectionMatrix.M[0][0] = projectionMatrix.M[0][0] / ( fabs( projectionMatrix.M[0][2] ) + 1.0f );
-		symmetricEyeProjectionMatrix.M[0][2] = 0.0f;
- 
-		const float moveBackDistance = 0.5f * HeadModelParms.InterpupillaryDistance * symmetricEyeProjectionMatrix.M[0][0];
-		Matrix4f centerEyeCullViewMatrix = Matrix4f::Translation( 0, 0, -moveBackDistance ) * centerEyeViewMatrix;
-
-		Array< ModelState * > emitModels;
-		for ( int i = 0; i < Models.GetSizeI(); i++ )
+		emitModels.PushBack( &Models[i]->State );
+	}
+
+	BuildModelSurfaceList( DrawSurfaceList, SupressModelsWithClientId, emitModels, EmitSurfaces, centerEyeCullViewMatrix, symmetricEyeProjectionMatrix, DrawSurfaceListBuffers, SurfaceSortMode );
+}
+
+threadReturn_t OvrSceneView::CullThreadFunction( Thread * thread, void * v )
+{
+	thread->SetThreadName( "OVR::SceneCull" );
+
+	OvrSceneView * scene = (OvrSceneView *)v;
+	for ( ; ; )
+	{
+		scene->CullStart.Wait();
+		scene->CullStart.ResetEvent();
+		if ( scene->CullExit )
 		{
-			emitModels.PushBack( &Models[i]->State );
+			break;
 		}
+		scene->CullSurfaces( scene->CullFovDegreesX, scene->CullFovDegreesY );
+		scene->CullDone.SetEvent();
+	}
+	return NULL;
+}
+
+void OvrSceneView::StartSurfaceCull( const float fovDegreesX, const float fovDegreesY )
+{
+	// Finish a cull that was never used by DrawEyeView().
+	if ( CullPending )
+	{
+		CullDone.Wait();
+	}
 
-		BuildModelSurfaceList( DrawSurfaceList, SupressModelsWithClientId, emitModels, EmitSurfaces, centerEyeCullViewMatrix, symmetricEyeProjectionMatrix );
+	if ( CullThread == NULL )
+	{
+		CullThread = new Thread( Thread::CreateParams( CullThreadFunction, this, 128 * 1024 ) );
+		if ( !CullThread->Start() )
+		{
+			WARN( "OvrSceneView::StartSurfaceCull: failed to start the cull thread" );
+			delete CullThread;
+			CullThread = NULL;
+		}
 	}
 
-	RenderSurfaceList( DrawSurfaceList, viewMatrix, projectionMatrix );
+	CullFovDegreesX = fovDegreesX;
+	CullFovDegreesY = fovDegreesY;
+	CullPending = true;
+	CullDone.ResetEvent();
+
+	if ( CullThread != NULL )
+	{
+		CullStart.SetEvent();
+	}
+	else
+	{
+		CullSurfaces( fovDegreesX, fovDegreesY );
+		CullDone.SetEvent();
+	}
+}
+
+Matrix4f OvrSceneView::DrawEyeView( const int eye, const float fovDegreesX, const float fovDegreesY ) const
+{
+	// The surfaces are culled and sorted once for both eyes.
+	if ( eye == 0 )
+	{
+		bool culled = false;
+		if ( CullPending )
+		{
+			CullDone.Wait();
+			CullPending = false;
+			culled = ( CullFovDegreesX == fovDegreesX && CullFovDegreesY == fovDegreesY );
+		}
+		if ( !culled )
+		{
+			CullSurfaces( fovDegreesX, fovDegreesY );
+		}
+	}
+
+	glEnable( GL_DEPTH_TEST );
+	glEnable( GL_CULL_FACE );
+	glFrontFace( GL_CCW );
+
+	const Matrix4f viewMatrix = GetEyeViewMatrix( eye );
+	const Matrix4f projectionMatrix = GetEyeProjectionMatrix( eye, fovDegreesX, fovDegreesY );
+
+	DrawCounters = RenderSurfaceList( DrawSurfaceList, viewMatrix, projectionMatrix );
+
+	if ( LogRenderSurfaces )
+	{
+		LOG( "eye %i sort %i: %i draws, %i program binds, %i texture binds, %i parameter updates", eye, SurfaceSortMode,
+				DrawCounters.numDrawCalls, DrawCounters.numProgramBinds, DrawCounters.numTextureBinds, DrawCounters.numParameterUpdates );
+	}
 
 	return ( projectionMatrix * viewMatrix );
 }
@@ -342,6 +438,13 @@ void OvrSceneView::Frame( const VrFrame & vrFrame,
 							const ovrHeadModelParms & headModelParms_,
 							const long long supressModelsWithClientId_ )
 {
+	// Don't change the view while a cull that was never drawn is still running.
+	if ( CullPending )
+	{
+		CullDone.Wait();
+		CullPending = false;
+	}
+
 	HeadModelParms = headModelParms_;
 	SupressModelsWithClientId = supressModelsWithClientId_;
 
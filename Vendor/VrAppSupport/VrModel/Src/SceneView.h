@@ -12,6 +12,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #ifndef SCENEVIEW_H
 #define SCENEVIEW_H
 
+#include "Kernel/OVR_Threads.h"
 #include "ModelFile.h"
 #include "Input.h"		// VrFrame, etc
 
@@ -41,6 +42,7 @@ class OvrSceneView
 {
 public:
 							OvrSceneView();
+							~OvrSceneView();
 
 	// The default view will be located at the origin, looking down the -Z axis,
 	// with +X to the right and +Y up.
@@ -78,6 +80,14 @@ public:
 									const ovrHeadModelParms & headModelParms_,
 									const long long supressModelsWithClientId = -1 );
 
+	// Starts culling and sorting the surfaces for both eyes on a worker thread, so the work
+	// overlaps with the rest of the frame until DrawEyeView() for the first eye waits for it.
+	// Call from VrAppInterface::StartEyeViews() with the fov passed to it, once all surfaces
+	// are emitted; the models and the emit list must not be changed until the first eye is
+	// drawn. Without this, or if the fov passed to DrawEyeView() is different, the first
+	// DrawEyeView() culls on the calling thread.
+	void					StartSurfaceCull( const float fovDegreesX, const float fovDegreesY );
+
 	// Issues GL calls and returns the view-projection matrix for the eye, as needed by AppInterface DrawEyeVIew
 	Matrix4f				DrawEyeView( const int eye, const float fovDegreesX, const float fovDegreesY ) const;
 
@@ -95,6 +105,12 @@ public:
 
 	float					GetZnear() const { return Znear; }
 
+	// Opaque surfaces are sorted front-to-back by default.  Sorting them by
+	// state instead can be compared using the counters from the last DrawEyeView().
+	void					SetSurfaceSortMode( const ModelSurfaceSortMode sortMode ) { SurfaceSortMode = sortMode; }
+	ModelSurfaceSortMode	GetSurfaceSortMode() const { return SurfaceSortMode; }
+	const ovrDrawCounters &	GetDrawCounters() const { return DrawCounters; }
+
 	void					SetMoveSpeed( const float speed ) { MoveSpeed = speed; }
 	void					SetFreeMove( const bool allowFreeMovement ) { FreeMove = allowFreeMovement; }
 
@@ -123,6 +139,10 @@ public:
 private:
     void                    LoadWorldModel( const char * sceneFileName, const MaterialParms & materialParms, const bool fromApk );
 
+	// Culls the surfaces with a frustum that contains both eyes into DrawSurfaceList.
+	void					CullSurfaces( const float fovDegreesX, const float fovDegreesY ) const;
+	static threadReturn_t	CullThreadFunction( Thread * thread, void * v );
+
 	// The only ModelInScene that OvrSceneView actually owns.
 	bool					FreeWorldModelOnChange;
 	ModelInScene			WorldModel;
@@ -137,6 +157,18 @@ private:
 
 	// Rendered surfaces.
 	mutable Array<ovrDrawSurface>	DrawSurfaceList;
+	mutable ModelSurfaceListBuffers	DrawSurfaceListBuffers;
+	ModelSurfaceSortMode			SurfaceSortMode;
+	mutable ovrDrawCounters			DrawCounters;
+
+	// Surface culling started by StartSurfaceCull()
+	Thread *				CullThread;
+	Event					CullStart;
+	mutable Event			CullDone;
+	mutable bool			CullPending;
+	volatile bool			CullExit;
+	float					CullFovDegreesX;
+	float					CullFovDegreesY;
 
 	GlProgram				ProgVertexColor;
 	GlProgram				ProgSingleTexture;
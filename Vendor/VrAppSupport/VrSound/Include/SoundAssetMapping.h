@@ -35,7 +35,7 @@ sdcard. If this file is found, it is solely used to load sounds.
 
 namespace OVR {
 
-class JSON;
+class JsonStreamReader;
 
 class ovrSoundAssetMapping
 {
@@ -47,8 +47,9 @@ public:
 	bool	GetSound( const char * soundName, String & outSound ) const;
 	
 private:
-	void	LoadSoundAssetsFromJsonObject( const String & url, JSON * dataFile );
 	void	LoadSoundAssetsFromPackage( const String & url, const char * jsonFile );
+	// Adds the sounds while they are read, without building a JSON tree.
+	bool	LoadSoundAssetsFromStream( const String & url, JsonStreamReader & reader );
 
 	StringHash< String >  SoundMap;	// Maps hashed sound name to sound asset url
 };
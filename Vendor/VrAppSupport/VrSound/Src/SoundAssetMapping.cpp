@@ -11,8 +11,9 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 *************************************************************************************/
 #include "SoundAssetMapping.h"
 
-#include "Kernel/OVR_JSON.h"
+#include "Kernel/OVR_JSONStream.h"
 #include "Kernel/OVR_LogUtils.h"
+#include "Kernel/OVR_SysFile.h"
 
 #include "PathUtils.h"
 #include "PackageFiles.h"
@@ -33,13 +34,20 @@ void ovrSoundAssetMapping::LoadSoundAssets()
 	String foundPath;
 	if ( GetFullPath( searchPaths, DEV_SOUNDS_RELATIVE, foundPath ) )
 	{
-		JSON * dataFile = JSON::Load( foundPath.ToCStr() );
-		if ( dataFile == NULL )
+		SysFile file;
+		if ( !file.Open( foundPath, File::Open_Read, File::Mode_Read ) )
 		{
 			FAIL( "ovrSoundAssetMapping::LoadSoundAssets failed to load JSON meta file: %s", foundPath.ToCStr( ) );
 		}
+		JsonFileSource source( &file );
+		JsonStreamReader reader( &source );
+		const String fileName( foundPath );
 		foundPath.StripTrailing( "sound_assets.json" );
-		LoadSoundAssetsFromJsonObject( foundPath, dataFile );
+		if ( !LoadSoundAssetsFromStream( foundPath, reader ) )
+		{
+			FAIL( "ovrSoundAssetMapping::LoadSoundAssets failed json parse on %s: %s", fileName.ToCStr(), reader.GetError() );
+		}
+		file.Close();
 	}
 	else // if that fails, we are in release - load sounds from vrlib/res/raw and the assets folder
 	{
@@ -87,57 +95,65 @@ bool ovrSoundAssetMapping::GetSound( const char * soundName, String & outSound )
 
 void ovrSoundAssetMapping::LoadSoundAssetsFromPackage( const String & url, const char * jsonFile )
 {
-	int bufferLength = 0;
-	void * 	buffer = NULL;
-	ovr_ReadFileFromApplicationPackage( jsonFile, bufferLength, buffer );
-	if ( !buffer )
+	int length = 0;
+	void * packageFile = ovr_OpenFileFromApplicationPackage( jsonFile, length );
+	if ( packageFile == NULL )
 	{
 		FAIL( "ovrSoundAssetMapping::LoadSoundAssetsFromPackage failed to read %s", jsonFile );
 	}
 
-	JSON * dataFile = JSON::Parse( reinterpret_cast< char * >( buffer ) );
-	if ( !dataFile )
+	ovrPackageJsonSource source( packageFile );
+	JsonStreamReader reader( &source );
+	if ( !LoadSoundAssetsFromStream( url, reader ) )
 	{
-		FAIL( "ovrSoundAssetMapping::LoadSoundAssetsFromPackage failed json parse on %s", jsonFile );
+		FAIL( "ovrSoundAssetMapping::LoadSoundAssetsFromPackage failed json parse on %s: %s", jsonFile, reader.GetError() );
 	}
-	free( buffer );
-
-	LoadSoundAssetsFromJsonObject( url, dataFile );
+	ovr_ClosePackageFile( packageFile );
 }
 
-void ovrSoundAssetMapping::LoadSoundAssetsFromJsonObject( const String & url, JSON * dataFile )
+bool ovrSoundAssetMapping::LoadSoundAssetsFromStream( const String & url, JsonStreamReader & reader )
 {
-	OVR_ASSERT( dataFile );
+	if ( reader.Next() != JSON_TOKEN_BEGIN_OBJECT )
+	{
+		return false;
+	}
 
 	// Read in sounds - add to map
-	JSON* sounds = dataFile->GetItemByName( "Sounds" );
-	OVR_ASSERT( sounds );
-	
-	const unsigned numSounds = sounds->GetItemCount();
-
-	for ( unsigned i = 0; i < numSounds; ++i )
+	while ( reader.Next() == JSON_TOKEN_NAME )
 	{
-		const JSON* sound = sounds->GetItemByIndex( i );
-		OVR_ASSERT( sound );
-
-		String fullPath( url );
-		fullPath.AppendString( sound->GetStringValue().ToCStr() );
-
-		// Do we already have this sound?
-		StringHash< String >::ConstIterator soundMapping = SoundMap.Find( sound->Name );
-		if ( soundMapping != SoundMap.End() )
+		if ( OVR_strcmp( reader.GetString(), "Sounds" ) != 0 )
 		{
-			LOG( "SoundManger - adding Duplicate sound %s with asset %s", sound->Name.ToCStr( ), fullPath.ToCStr( ) );
-			SoundMap.Set( sound->Name, fullPath );
+			reader.SkipValue();
+			continue;
 		}
-		else // add new sound
+		if ( reader.Next() != JSON_TOKEN_BEGIN_OBJECT )
+		{
+			reader.SkipRestOfValue();
+			continue;
+		}
+
+		while ( reader.Next() == JSON_TOKEN_NAME )
 		{
-			LOG( "SoundManger read in: %s -> %s", sound->Name.ToCStr( ), fullPath.ToCStr( ) );
-			SoundMap.Add( sound->Name, fullPath );
+			const String soundName( reader.GetString() );
+			String fullPath( url );
+			fullPath.AppendString( reader.ReadString().ToCStr() );
+
+			// Do we already have this sound?
+			StringHash< String >::ConstIterator soundMapping = SoundMap.Find( soundName );
+			if ( soundMapping != SoundMap.End() )
+			{
+				LOG( "SoundManger - adding Duplicate sound %s with asset %s", soundName.ToCStr( ), fullPath.ToCStr( ) );
+				SoundMap.Set( soundName, fullPath );
+			}
+			else // add new sound
+			{
+				LOG( "SoundManger read in: %s -> %s", soundName.ToCStr( ), fullPath.ToCStr( ) );
+				SoundMap.Add( soundName, fullPath );
+			}
 		}
 	}
 
-	dataFile->Release();
+	return reader.GetToken() == JSON_TOKEN_END_OBJECT && reader.GetDepth() == 0;
 }
 
 }